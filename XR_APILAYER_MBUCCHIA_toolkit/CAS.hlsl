@@ -17,14 +17,65 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
-cbuffer cb : register(b0) {
+#ifndef CAS_STEREO
+#define CAS_STEREO 0
+#endif
+
+#if CAS_STEREO
+#define CAS_VIEW_COUNT 2
+#else
+#define CAS_VIEW_COUNT 1
+#endif
+
+struct CasConstants {
     uint4 const0;
     uint4 const1;
+    uint4 const2; // Input offset (xy), output offset (zw)
+    uint4 const3; // Output extent (xy)
+    uint4 const4; // Input slice (x), output slice (y) (stereo only)
 };
 
+// In stereo mode, both eyes are processed in a single dispatch, with the eye index in the Z dimension.
+cbuffer cb : register(b0) {
+    CasConstants views[CAS_VIEW_COUNT];
+};
+
+static uint4 const0;
+static uint4 const1;
+static uint4 const2;
+static uint4 const3;
+static uint4 const4;
+
+#if CAS_STEREO
+Texture2DArray InputTexture : register(t0);
+RWTexture2DArray<float4> OutputTexture : register(u0);
+
+#define CAS_INPUT_TEXEL(p) int4((p), const4.x, 0)
+#define CAS_OUTPUT_TEXEL(p) uint3((p), const4.y)
+#else
 Texture2D InputTexture : register(t0);
 RWTexture2D<float4> OutputTexture : register(u0);
 
+#define CAS_INPUT_TEXEL(p) int3((p), 0)
+#define CAS_OUTPUT_TEXEL(p) (p)
+#endif
+
+#if POST_PROCESS_FUSED
+// Post-processing constants (see postprocess.hlsl), when fusing the post-processor with the upscaler.
+cbuffer postProcessConfig : register(b1) {
+    float4 PostParams1;
+    float4 PostParams2;
+    float4 PostParams3;
+    float4 PostParams4;
+};
+
+#include "postprocess.hlsli"
+
+#define CAS_OUTPUT(c) saturate(PostProcessColor((c), PostParams1, PostParams2, PostParams3))
+#else
+#define CAS_OUTPUT(c) (c)
+#endif
+
 #define A_GPU 1
 #define A_HLSL 1
 
@@ -40,7 +91,7 @@ RWTexture2D<float4> OutputTexture : register(u0);
 #if CAS_SAMPLE_FP16
 
 AH3 CasLoadH(ASW2 p) {
-    return InputTexture.Load(ASU3(p, 0)).rgb;
+    return InputTexture.Load(CAS_INPUT_TEXEL(ASU2(p) + ASU2(const2.xy))).rgb;
 }
 
 // Lets you transform input from the load into a linear color space between 0 and 1. See ffx_cas.h
@@ -51,7 +102,7 @@ void CasInputH(inout AH2 r, inout AH2 g, inout AH2 b) {
 #else
 
 AF3 CasLoad(ASU2 p) {
-    return InputTexture.Load(int3(p, 0)).rgb;
+    return InputTexture.Load(CAS_INPUT_TEXEL(p + ASU2(const2.xy))).rgb;
 }
 
 // Lets you transform input from the load into a linear color space between 0 and 1. See ffx_cas.h
@@ -63,6 +114,13 @@ void CasInput(inout AF1 r, inout AF1 g, inout AF1 b) {
 
 #include "ffx_cas.h"
 
+// Do not write outside of the output viewport.
+void CasStore(ASU2 p, AF4 c) {
+    if (all(AU2(p) < const3.xy)) {
+        OutputTexture[CAS_OUTPUT_TEXEL(p + ASU2(const2.zw))] = c;
+    }
+}
+
 [numthreads(CAS_THREAD_GROUP_SIZE, 1, 1)]
 void mainCS(uint3 LocalThreadId
                                                : SV_GroupThreadID, uint3 WorkGroupId
@@ -70,6 +128,13 @@ void mainCS(uint3 LocalThreadId
     // Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
     AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
 
+    const CasConstants view = views[WorkGroupId.z];
+    const0 = view.const0;
+    const1 = view.const1;
+    const2 = view.const2;
+    const3 = view.const3;
+    const4 = view.const4;
+
     bool sharpenOnly;
 #if CAS_SAMPLE_SHARPEN_ONLY
     sharpenOnly = true;
@@ -85,14 +150,14 @@ void mainCS(uint3 LocalThreadId
 
     CasFilterH(cR, cG, cB, gxy, const0, const1, sharpenOnly);
     CasDepack(c0, c1, cR, cG, cB);
-    OutputTexture[ASU2(gxy)] = AF4(c0);
-    OutputTexture[ASU2(gxy) + ASU2(8, 0)] = AF4(c1);
+    CasStore(ASU2(gxy), AF4(CAS_OUTPUT(AF3(c0.rgb)), c0.a));
+    CasStore(ASU2(gxy) + ASU2(8, 0), AF4(CAS_OUTPUT(AF3(c1.rgb)), c1.a));
     gxy.y += 8u;
 
     CasFilterH(cR, cG, cB, gxy, const0, const1, sharpenOnly);
     CasDepack(c0, c1, cR, cG, cB);
-    OutputTexture[ASU2(gxy)] = AF4(c0);
-    OutputTexture[ASU2(gxy) + ASU2(8, 0)] = AF4(c1);
+    CasStore(ASU2(gxy), AF4(CAS_OUTPUT(AF3(c0.rgb)), c0.a));
+    CasStore(ASU2(gxy) + ASU2(8, 0), AF4(CAS_OUTPUT(AF3(c1.rgb)), c1.a));
 
 #else
 
@@ -100,19 +165,19 @@ void mainCS(uint3 LocalThreadId
     AF3 c;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    CasStore(ASU2(gxy), AF4(CAS_OUTPUT(c), 1));
     gxy.x += 8u;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    CasStore(ASU2(gxy), AF4(CAS_OUTPUT(c), 1));
     gxy.y += 8u;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    CasStore(ASU2(gxy), AF4(CAS_OUTPUT(c), 1));
     gxy.x -= 8u;
 
     CasFilter(c.r, c.g, c.b, gxy, const0, const1, sharpenOnly);
-    OutputTexture[ASU2(gxy)] = AF4(c, 1);
+    CasStore(ASU2(gxy), AF4(CAS_OUTPUT(c), 1));
 
 #endif
 }
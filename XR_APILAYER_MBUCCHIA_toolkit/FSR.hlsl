@@ -19,37 +19,122 @@
 
 // clang-format off
 
+#ifndef FSR_STEREO
+#define FSR_STEREO 0
+#endif
+
+// EASU and RCAS in a single dispatch, through a groupshared tile
+#ifndef SAMPLE_SINGLE_PASS
+#define SAMPLE_SINGLE_PASS 0
+#endif
+
+#if FSR_STEREO
+#define FSR_VIEW_COUNT 2
+#else
+#define FSR_VIEW_COUNT 1
+#endif
+
 // combine EASU and RCAS constants in a single buffer
-cbuffer cb : register(b0)
+struct FsrConstants
 {
   uint4 Const0;
   uint4 Const1;
   uint4 Const2;
   uint4 Const3;
   uint4 Const4;
+  uint4 Const5; // RCAS input offset (xy), output offset (zw)
+  uint4 Const6; // output extent (xy)
+  uint4 Const7; // EASU input/output slices (xy), RCAS input/output slices (zw) (stereo only)
+  uint4 Const8; // foveated region, relative to the output viewport (left, top, right, bottom)
+};
+
+// in stereo mode, both eyes are processed in a single dispatch, with the eye index in the Z dimension
+cbuffer cb : register(b0)
+{
+  FsrConstants Views[FSR_VIEW_COUNT];
+};
+
+static uint4 Const0;
+static uint4 Const1;
+static uint4 Const2;
+static uint4 Const3;
+static uint4 Const4;
+static uint4 Const5;
+static uint4 Const6;
+static uint4 Const7;
+static uint4 Const8;
+
+// whether the tile of the thread group overlaps the foveated region (full quality)
+static bool IsFoveated;
+
+#if FSR_STEREO
+  #if SAMPLE_SINGLE_PASS
+    #define INPUT_SLICE Const7.x
+    #define OUTPUT_SLICE Const7.w
+  #elif SAMPLE_EASU
+    #define INPUT_SLICE Const7.x
+    #define OUTPUT_SLICE Const7.y
+  #else
+    #define INPUT_SLICE Const7.z
+    #define OUTPUT_SLICE Const7.w
+  #endif
+  #define INPUT_TEXTURE Texture2DArray
+  #define OUTPUT_TEXTURE RWTexture2DArray
+  #define INPUT_UV(p) AF3((p), INPUT_SLICE)
+  #define INPUT_TEXEL(p) int4((p), INPUT_SLICE, 0)
+  #define OUTPUT_TEXEL(p) uint3((p), OUTPUT_SLICE)
+#else
+  #define INPUT_TEXTURE Texture2D
+  #define OUTPUT_TEXTURE RWTexture2D
+  #define INPUT_UV(p) (p)
+  #define INPUT_TEXEL(p) int3((p), 0)
+  #define OUTPUT_TEXEL(p) (p)
+#endif
+
+#if POST_PROCESS_FUSED
+// post-processing constants (see postprocess.hlsl), when fusing the post-processor with the upscaler
+cbuffer postProcessConfig : register(b1)
+{
+  float4 PostParams1;
+  float4 PostParams2;
+  float4 PostParams3;
+  float4 PostParams4;
 };
 
+#include "postprocess.hlsli"
+#endif
+
 #define A_GPU 1
 #define A_HLSL 1
 
 SamplerState		samLinearClamp : register(s0);
 
+#if SAMPLE_SINGLE_PASS
+// the EASU output for the 16x16 output tile of the thread group, with a 1-pixel apron for the RCAS taps
+#define TILE_DIM 18
+groupshared float3 Tile[TILE_DIM * TILE_DIM];
+static int2 TileOrigin;
+float3 LoadTile(int2 p) { const int2 t = p - TileOrigin; return Tile[t.y * TILE_DIM + t.x]; }
+#endif
+
 #if SAMPLE_SLOW_FALLBACK
   #include "ffx_a.h"
-  Texture2D InputTexture : register(t0);
-  RWTexture2D<float4> OutputTexture : register(u0);
+  INPUT_TEXTURE InputTexture : register(t0);
+  OUTPUT_TEXTURE<float4> OutputTexture : register(u0);
   #if SAMPLE_EASU
     #define FSR_EASU_F 1
-    AF4 FsrEasuRF(AF2 p) { AF4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
-    AF4 FsrEasuGF(AF2 p) { AF4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
-    AF4 FsrEasuBF(AF2 p) { AF4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }
+    AF4 FsrEasuRF(AF2 p) { AF4 res = InputTexture.GatherRed(samLinearClamp, INPUT_UV(p), int2(0, 0)); return res; }
+    AF4 FsrEasuGF(AF2 p) { AF4 res = InputTexture.GatherGreen(samLinearClamp, INPUT_UV(p), int2(0, 0)); return res; }
+    AF4 FsrEasuBF(AF2 p) { AF4 res = InputTexture.GatherBlue(samLinearClamp, INPUT_UV(p), int2(0, 0)); return res; }
   #endif
   #if SAMPLE_RCAS
     #define FSR_RCAS_F
-    #if SAMPLE_HDR_OUTPUT
-      AF4 FsrRcasLoadF(ASU2 p) { return sqrt(InputTexture.Load(int3(ASU2(p), 0))); }
+    #if SAMPLE_SINGLE_PASS
+      AF4 FsrRcasLoadF(ASU2 p) { return AF4(LoadTile(ASW2(p)), 1); }
+    #elif SAMPLE_HDR_OUTPUT
+      AF4 FsrRcasLoadF(ASU2 p) { return sqrt(InputTexture.Load(INPUT_TEXEL(ASU2(p) + ASU2(Const5.xy)))); }
     #else
-      AF4 FsrRcasLoadF(ASU2 p) { return InputTexture.Load(int3(ASU2(p), 0)); }
+      AF4 FsrRcasLoadF(ASU2 p) { return InputTexture.Load(INPUT_TEXEL(ASU2(p) + ASU2(Const5.xy))); }
     #endif
     void FsrRcasInputF(inout AF1 r, inout AF1 g, inout AF1 b) {
     }
@@ -57,70 +142,186 @@ SamplerState		samLinearClamp : register(s0);
 #else
   #define A_HALF
   #include "ffx_a.h"
-  Texture2D<AH4> InputTexture : register(t0);
-  RWTexture2D<AH4> OutputTexture : register(u0);
+  INPUT_TEXTURE<AH4> InputTexture : register(t0);
+  OUTPUT_TEXTURE<AH4> OutputTexture : register(u0);
   #if SAMPLE_EASU
     #define FSR_EASU_H 1
-    AH4 FsrEasuRH(AF2 p) { AH4 res = InputTexture.GatherRed(samLinearClamp, p, int2(0, 0)); return res; }
-    AH4 FsrEasuGH(AF2 p) { AH4 res = InputTexture.GatherGreen(samLinearClamp, p, int2(0, 0)); return res; }
-    AH4 FsrEasuBH(AF2 p) { AH4 res = InputTexture.GatherBlue(samLinearClamp, p, int2(0, 0)); return res; }	
+    AH4 FsrEasuRH(AF2 p) { AH4 res = InputTexture.GatherRed(samLinearClamp, INPUT_UV(p), int2(0, 0)); return res; }
+    AH4 FsrEasuGH(AF2 p) { AH4 res = InputTexture.GatherGreen(samLinearClamp, INPUT_UV(p), int2(0, 0)); return res; }
+    AH4 FsrEasuBH(AF2 p) { AH4 res = InputTexture.GatherBlue(samLinearClamp, INPUT_UV(p), int2(0, 0)); return res; }	
   #endif
   #if SAMPLE_RCAS
     #define FSR_RCAS_H
-    AH4 FsrRcasLoadH(ASW2 p) { return InputTexture.Load(ASW3(ASW2(p), 0)); }
+    #if SAMPLE_SINGLE_PASS
+      AH4 FsrRcasLoadH(ASW2 p) { return AH4(LoadTile(p), 1); }
+    #elif SAMPLE_HDR_OUTPUT
+      AH4 FsrRcasLoadH(ASW2 p) { return sqrt(InputTexture.Load(INPUT_TEXEL(ASW2(p) + ASW2(Const5.xy)))); }
+    #else
+      AH4 FsrRcasLoadH(ASW2 p) { return InputTexture.Load(INPUT_TEXEL(ASW2(p) + ASW2(Const5.xy))); }
+    #endif
     void FsrRcasInputH(inout AH1 r,inout AH1 g,inout AH1 b){}
   #endif
 #endif
 
 #include "ffx_fsr1.h"
 
+// same as the bilinear path of the FSR sample, using the EASU constants
+AF2 BilinearUV(int2 pos)
+{
+  return (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
+}
+
 void CurrFilter(int2 pos)
 {
+  // do not write outside of the output viewport
+  if (any(AU2(pos) >= Const6.xy))
+    return;
+
 #if SAMPLE_BILINEAR
-  AF2 pp = (AF2(pos) * AF2_AU2(Const0.xy) + AF2_AU2(Const0.zw)) * AF2_AU2(Const1.xy) + AF2(0.5, -0.5) * AF2_AU2(Const1.zw);
-  OutputTexture[pos] = InputTexture.SampleLevel(samLinearClamp, pp, 0.0);
+  OutputTexture[OUTPUT_TEXEL(pos)] = InputTexture.SampleLevel(samLinearClamp, INPUT_UV(BilinearUV(pos)), 0.0);
 #endif
-#if SAMPLE_EASU
+#if SAMPLE_SINGLE_PASS
+  // the tile was upscaled by UpscaleTile()
   #if SAMPLE_SLOW_FALLBACK
     AF3 c;
-    FsrEasuF(c, pos, Const0, Const1, Const2, Const3);
+    if (IsFoveated)
+    {
+      FsrRcasF(c.r, c.g, c.b, pos, Const4);
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = float4(c, 1);
+    }
+    else
+      c = InputTexture.SampleLevel(samLinearClamp, INPUT_UV(BilinearUV(pos)), 0.0).rgb;
+    #if POST_PROCESS_FUSED
+      c = saturate(PostProcessColor(c, PostParams1, PostParams2, PostParams3));
+    #endif
+    OutputTexture[OUTPUT_TEXEL(pos + int2(Const5.zw))] = float4(c, 1);
   #else
     AH3 c;
-    FsrEasuH(c, pos, Const0, Const1, Const2, Const3);
+    if (IsFoveated)
+    {
+      FsrRcasH(c.r, c.g, c.b, pos, Const4);
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = AH4(c, 1);
+    }
+    else
+      c = InputTexture.SampleLevel(samLinearClamp, INPUT_UV(BilinearUV(pos)), 0.0).rgb;
+    #if POST_PROCESS_FUSED
+      c = AH3(saturate(PostProcessColor(AF3(c), PostParams1, PostParams2, PostParams3)));
+    #endif
+    OutputTexture[OUTPUT_TEXEL(pos + int2(Const5.zw))] = AH4(c, 1);
   #endif
 #endif
-#if SAMPLE_RCAS
+#if SAMPLE_EASU && !SAMPLE_SINGLE_PASS
   #if SAMPLE_SLOW_FALLBACK
     AF3 c;
-    FsrRcasF(c.r, c.g, c.b, pos, Const4);
+    if (IsFoveated)
+      FsrEasuF(c, pos, Const0, Const1, Const2, Const3);
+    else
+      c = InputTexture.SampleLevel(samLinearClamp, INPUT_UV(BilinearUV(pos)), 0.0).rgb;
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = float4(c, 1);
+    OutputTexture[OUTPUT_TEXEL(pos)] = float4(c, 1);
   #else
     AH3 c;
-    FsrRcasH(c.r, c.g, c.b, pos, Const4);
+    if (IsFoveated)
+      FsrEasuH(c, pos, Const0, Const1, Const2, Const3);
+    else
+      c = InputTexture.SampleLevel(samLinearClamp, INPUT_UV(BilinearUV(pos)), 0.0).rgb;
     #if SAMPLE_HDR_OUTPUT
       c *= c;
     #endif
-    OutputTexture[pos] = AH4(c, 1);
+    OutputTexture[OUTPUT_TEXEL(pos)] = AH4(c, 1);
+  #endif
+#endif
+#if SAMPLE_RCAS && !SAMPLE_SINGLE_PASS
+  #if SAMPLE_SLOW_FALLBACK
+    AF3 c;
+    if (IsFoveated)
+      FsrRcasF(c.r, c.g, c.b, pos, Const4);
+    else
+      c = FsrRcasLoadF(ASU2(pos)).rgb;
+    #if SAMPLE_HDR_OUTPUT
+      c *= c;
+    #endif
+    #if POST_PROCESS_FUSED
+      c = saturate(PostProcessColor(c, PostParams1, PostParams2, PostParams3));
+    #endif
+    OutputTexture[OUTPUT_TEXEL(pos + int2(Const5.zw))] = float4(c, 1);
+  #else
+    AH3 c;
+    if (IsFoveated)
+      FsrRcasH(c.r, c.g, c.b, pos, Const4);
+    else
+      c = FsrRcasLoadH(ASW2(pos)).rgb;
+    #if SAMPLE_HDR_OUTPUT
+      c *= c;
+    #endif
+    #if POST_PROCESS_FUSED
+      c = AH3(saturate(PostProcessColor(AF3(c), PostParams1, PostParams2, PostParams3)));
+    #endif
+    OutputTexture[OUTPUT_TEXEL(pos + int2(Const5.zw))] = AH4(c, 1);
   #endif
 #endif
 }
 
+#if SAMPLE_SINGLE_PASS
+// upscale the output tile of the thread group and its apron, each thread taking every FSR_THREAD_GROUP_SIZE-th pixel
+void UpscaleTile(uint localIndex)
+{
+  // outside of the foveated region, the bilinear fetch does not need the tile
+  if (!IsFoveated)
+    return;
+
+  for (uint i = localIndex; i < TILE_DIM * TILE_DIM; i += FSR_THREAD_GROUP_SIZE)
+  {
+    const AU2 p = AU2(TileOrigin + int2(i % TILE_DIM, i / TILE_DIM));
+  #if SAMPLE_SLOW_FALLBACK
+    AF3 c;
+    FsrEasuF(c, p, Const0, Const1, Const2, Const3);
+  #else
+    AH3 c;
+    FsrEasuH(c, p, Const0, Const1, Const2, Const3);
+  #endif
+  #if SAMPLE_HDR_OUTPUT
+    // same as the RCAS input of the two-pass version
+    c = sqrt(c);
+  #endif
+    Tile[i] = c;
+  }
+}
+#endif
+
 [numthreads(FSR_THREAD_GROUP_SIZE, 1, 1)]
 void mainCS(uint3 LocalThreadId : SV_GroupThreadID, uint3 WorkGroupId : SV_GroupID, uint3 Dtid : SV_DispatchThreadID)
 {
   // Do remapping of local xy in workgroup for a more PS-like swizzle pattern.
   AU2 gxy = ARmp8x8(LocalThreadId.x) + AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
+
+  const FsrConstants view = Views[WorkGroupId.z];
+  Const0 = view.Const0;
+  Const1 = view.Const1;
+  Const2 = view.Const2;
+  Const3 = view.Const3;
+  Const4 = view.Const4;
+  Const5 = view.Const5;
+  Const6 = view.Const6;
+  Const7 = view.Const7;
+  Const8 = view.Const8;
+
+  // the 16x16 tile of the thread group either runs the full kernel or the cheap filter
+  const AU2 tileMin = AU2(WorkGroupId.x << 4u, WorkGroupId.y << 4u);
+  IsFoveated = all(tileMin < Const8.zw) && all(tileMin + 16u > Const8.xy);
+
+#if SAMPLE_SINGLE_PASS
+  TileOrigin = int2(tileMin) - 1;
+  UpscaleTile(LocalThreadId.x);
+  GroupMemoryBarrierWithGroupSync();
+#endif
+
   CurrFilter(gxy);
   gxy.x += 8u;
   CurrFilter(gxy);
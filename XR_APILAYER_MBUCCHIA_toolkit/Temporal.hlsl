@@ -0,0 +1,154 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// clang-format off
+
+// Temporal upscaling: upscale the current frame, then accumulate it with the previous (upscaled) frames. The camera
+// motion vectors are reconstructed from the depth buffer and the view poses of both frames.
+
+#ifndef TEMPORAL_THREAD_GROUP_SIZE_X
+#define TEMPORAL_THREAD_GROUP_SIZE_X 8
+#endif
+#ifndef TEMPORAL_THREAD_GROUP_SIZE_Y
+#define TEMPORAL_THREAD_GROUP_SIZE_Y 8
+#endif
+
+cbuffer cb : register(b0)
+{
+  float4x4 Reprojection;  // current view NDC to previous view clip space
+  float4 InputRect;       // input offset (xy), input extent (zw)
+  float4 DepthRect;       // depth offset (xy), depth extent (zw)
+  uint4 OutputRect;       // output offset (xy), output extent (zw)
+  float4 Params;          // history weight (x), depth without depth buffer (y), has history (z),
+                          // depth mode (w: 0 = no depth buffer, 1 = regular, 2 = inverted)
+};
+
+Texture2D InputTexture : register(t0);
+Texture2D<float> DepthTexture : register(t1);
+Texture2D HistoryTexture : register(t2);
+RWTexture2D<float4> OutputTexture : register(u0);
+RWTexture2D<float4> HistoryOutput : register(u1);
+SamplerState samLinearClamp : register(s0);
+
+// Catmull-Rom filtering with 5 bilinear taps (the corners are negligible), restricted to a rectangle of the texture.
+float3 SampleCatmullRom(Texture2D tex, float2 samplePos, float2 texSize, float4 rect)
+{
+  const float2 texPos1 = floor(samplePos - 0.5) + 0.5;
+  const float2 f = samplePos - texPos1;
+
+  const float2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+  const float2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+  const float2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+  const float2 w3 = f * f * (-0.5 + 0.5 * f);
+  const float2 w12 = w1 + w2;
+
+  // Do not filter across the edges of the rectangle, which may contain another view.
+  const float2 rectMin = rect.xy + 0.5;
+  const float2 rectMax = rect.xy + rect.zw - 0.5;
+  const float2 uv0 = clamp(texPos1 - 1.0, rectMin, rectMax) / texSize;
+  const float2 uv3 = clamp(texPos1 + 2.0, rectMin, rectMax) / texSize;
+  const float2 uv12 = clamp(texPos1 + w2 / w12, rectMin, rectMax) / texSize;
+
+  float3 result = 0;
+  result += tex.SampleLevel(samLinearClamp, float2(uv12.x, uv0.y), 0).rgb * (w12.x * w0.y);
+  result += tex.SampleLevel(samLinearClamp, float2(uv0.x, uv12.y), 0).rgb * (w0.x * w12.y);
+  result += tex.SampleLevel(samLinearClamp, uv12, 0).rgb * (w12.x * w12.y);
+  result += tex.SampleLevel(samLinearClamp, float2(uv3.x, uv12.y), 0).rgb * (w3.x * w12.y);
+  result += tex.SampleLevel(samLinearClamp, float2(uv12.x, uv3.y), 0).rgb * (w12.x * w3.y);
+
+  const float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+  return max(result / weight, 0);
+}
+
+[numthreads(TEMPORAL_THREAD_GROUP_SIZE_X, TEMPORAL_THREAD_GROUP_SIZE_Y, 1)]
+void mainCS(uint2 pos : SV_DispatchThreadID)
+{
+  if (any(pos >= OutputRect.zw))
+    return;
+
+  const float2 uv = (pos + 0.5) / OutputRect.zw;
+
+  // Upscale the current frame.
+  float2 inputSize;
+  InputTexture.GetDimensions(inputSize.x, inputSize.y);
+  const float2 inputPos = InputRect.xy + uv * InputRect.zw;
+  const float3 color = SampleCatmullRom(InputTexture, inputPos, inputSize, InputRect);
+
+  // The history is clamped to the colors of the neighborhood in the current frame, in order to reject the samples
+  // that are not visible anymore (disocclusion, shading changes...).
+  const int2 inputMin = int2(InputRect.xy);
+  const int2 inputMax = int2(InputRect.xy + InputRect.zw) - 1;
+  const int2 inputCenter = int2(inputPos);
+  float3 minColor = color;
+  float3 maxColor = color;
+  [unroll]
+  for (int y = -1; y <= 1; y++)
+  {
+    [unroll]
+    for (int x = -1; x <= 1; x++)
+    {
+      const int2 texel = clamp(inputCenter + int2(x, y), inputMin, inputMax);
+      const float3 neighbor = InputTexture.Load(int3(texel, 0)).rgb;
+      minColor = min(minColor, neighbor);
+      maxColor = max(maxColor, neighbor);
+    }
+  }
+
+  // Use the closest depth of the neighborhood, so that the edges of the foreground objects follow their motion.
+  float depth = Params.y;
+  if (Params.w > 0)
+  {
+    const bool isDepthInverted = Params.w > 1.5;
+    const int2 depthMin = int2(DepthRect.xy);
+    const int2 depthMax = int2(DepthRect.xy + DepthRect.zw) - 1;
+    const int2 depthCenter = int2(DepthRect.xy + uv * DepthRect.zw);
+    depth = isDepthInverted ? 0 : 1;
+    [unroll]
+    for (int j = -1; j <= 1; j++)
+    {
+      [unroll]
+      for (int i = -1; i <= 1; i++)
+      {
+        const int2 texel = clamp(depthCenter + int2(i, j), depthMin, depthMax);
+        const float sampleDepth = DepthTexture.Load(int3(texel, 0));
+        depth = isDepthInverted ? max(depth, sampleDepth) : min(depth, sampleDepth);
+      }
+    }
+  }
+
+  // Reproject into the previous frame.
+  const float4 ndc = float4(uv.x * 2 - 1, 1 - uv.y * 2, depth, 1);
+  const float4 previous = mul(ndc, Reprojection);
+  const float2 historyUv = float2(previous.x, -previous.y) / previous.w * 0.5 + 0.5;
+
+  float3 result = color;
+  if (Params.z > 0 && previous.w > 0 && all(historyUv == saturate(historyUv)))
+  {
+    const float2 historySize = OutputRect.zw;
+    const float3 history = SampleCatmullRom(HistoryTexture, historyUv * historySize, historySize,
+                                            float4(0, 0, historySize));
+    result = lerp(color, clamp(history, minColor, maxColor), Params.x);
+  }
+
+  HistoryOutput[pos] = float4(result, 1);
+  OutputTexture[OutputRect.xy + pos] = float4(result, 1);
+}
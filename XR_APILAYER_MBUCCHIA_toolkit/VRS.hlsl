@@ -42,22 +42,116 @@
 #define VRS_USE_DIM_RATIO 0
 #endif
 
+#ifndef VRS_CONTENT_ANALYSIS
+#define VRS_CONTENT_ANALYSIS 0
+#endif
+
+#ifndef VRS_DEPTH_ANALYSIS
+#define VRS_DEPTH_ANALYSIS 0
+#endif
+
+#if VRS_CONTENT_ANALYSIS
+
+// Measure the luminance variance of the previous frame, per tile of the hint texture
+// Output: 0 (detailed), 1 (flat enough for 2x2), 2 (flat enough for 4x4)
+
+cbuffer cb : register(b0)
+{
+  float4 Source;  // u, v, w, h of the view in the input texture
+  float4 Params;  // 1/w, 1/h of the hints, variance thresholds for 2x2 and 4x4
+};
+
+Texture2D t_Input : register(t0);
+SamplerState s_Sampler : register(s0);
+RWTexture2D<uint> u_Output : register(u0);
+
+[numthreads(VRS_NUM_THREADS_X, VRS_NUM_THREADS_Y, 1)]
+void mainCS(in int2 pos : SV_DispatchThreadID) {
+  float sum = 0.0f;
+  float sum2 = 0.0f;
+
+  // 4x4 samples spread over the footprint of the tile
+  [unroll] for (int y = 0; y < 4; y++) {
+    [unroll] for (int x = 0; x < 4; x++) {
+      float2 uv = (pos + (float2(x, y) + 0.5f) * 0.25f) * Params.xy;
+      float3 color = t_Input.SampleLevel(s_Sampler, Source.xy + uv * Source.zw, 0).rgb;
+      float luminance = dot(saturate(color), float3(0.299f, 0.587f, 0.114f));
+      sum += luminance;
+      sum2 += luminance * luminance;
+    }
+  }
+
+  float mean = sum / 16.0f;
+  float variance = max(sum2 / 16.0f - mean * mean, 0.0f);
+
+  u_Output[pos] = variance < Params.w ? 2 : variance < Params.z ? 1 : 0;
+}
+
+#elif VRS_DEPTH_ANALYSIS
+
+// Reduce the depth buffer of the previous frame, per tile of the output
+// Output: distance to the nearest geometry of the tile (meters)
+
+cbuffer cb : register(b0)
+{
+  float4 Source;  // x, y, w, h of the view in the depth texture (texels)
+  float4 Params;  // 1/near, 1/far, min depth, 1/(max depth - min depth)
+};
+
+Texture2D<float> t_Depth : register(t0);
+RWTexture2D<float> u_Output : register(u0);
+
+[numthreads(VRS_NUM_THREADS_X, VRS_NUM_THREADS_Y, 1)]
+void mainCS(in int2 pos : SV_DispatchThreadID) {
+  uint w, h;
+  u_Output.GetDimensions(w, h);
+  if (any(pos >= int2(w, h)))
+    return;
+
+  // footprint of the tile in the depth texture
+  float2 scale = Source.zw / float2(w, h);
+  int2 first = int2(Source.xy + pos * scale);
+  int2 last = max(int2(Source.xy + (pos + 1) * scale) - 1, first);
+
+  // the inverse of the distance is linear in the depth, the nearest geometry has the largest inverse
+  float maxInvDistance = 0.0f;
+  for (int y = first.y; y <= last.y; y++) {
+    for (int x = first.x; x <= last.x; x++) {
+      float depth = saturate((t_Depth.Load(int3(x, y, 0)) - Params.z) * Params.w);
+      maxInvDistance = max(maxInvDistance, lerp(Params.x, Params.y, depth));
+    }
+  }
+
+  u_Output[pos] = 1.0f / max(maxInvDistance, 1e-7f);
+}
+
+#else
+
 // Render up to 4 ellipses with their shading rates
 // Equation: x^2 / a^2 + y^2 / b^2 == 1
 // https://www.desmos.com/calculator/tevuazt8xl
 
 cbuffer cb : register(b0)
 {
-  float4 Gaze;    // ndc_x, ndc_y, 1/w, 1/h
-  float4 Rings12; // 1/(a1^2), 1/(b1^2), 1/(a2^2), 1/(b2^2)
-  float4 Rings34; // 1/(a3^2), 1/(b3^2), 1/(a4^2), 1/(b4^2)
-  uint4  Rates;   // r1, r2, r3, r4
+  float4 Gaze;      // ndc_x, ndc_y, 1/w, 1/h
+  float4 Rings12;   // 1/(a1^2), 1/(b1^2), 1/(a2^2), 1/(b2^2)
+  float4 Rings34;   // 1/(a3^2), 1/(b3^2), 1/(a4^2), 1/(b4^2)
+  uint4  Rates;     // r1, r2, r3, r4
+  int4   Region;    // x, y, initialize from base, unused
+  uint4  HintRates; // rates for the content hints 0, 1, 2, use content hints
+  float4 DepthParams; // distances for 2x2 and 4x4, use depth hints, unused
 };
 
+Texture2D<uint> t_Base : register(t0);
+Texture2D<uint> t_Hints : register(t1);
+Texture2D<float> t_DepthTiles : register(t2);
 RWTexture2D<uint> u_Output : register(u0);
 
 [numthreads(VRS_NUM_THREADS_X, VRS_NUM_THREADS_Y, 1)]
-void mainCS(in int2 pos : SV_DispatchThreadID) {
+void mainCS(in int2 dispatchPos : SV_DispatchThreadID) {
+  // only the region of the mask being updated is dispatched
+  int2 pos = dispatchPos + Region.xy;
+
   // screen space (w,h) to uv (0,1)
   float2 pos_uv = (pos + 0.5f) * Gaze.zw;
 
@@ -91,7 +185,27 @@ void mainCS(in int2 pos : SV_DispatchThreadID) {
 #endif
   else rate = VRS_DEFAULT_RATE;
 
-  u_Output[pos] = min(u_Output[pos], rate);
+  // coarsen the flat regions of the previous frame
+  if (HintRates.w) {
+    uint w, h;
+    t_Hints.GetDimensions(w, h);
+    uint hint = t_Hints[min(uint2(pos_uv * float2(w, h)), uint2(w - 1, h - 1))];
+    rate = max(rate, HintRates[min(hint, 2)]);
+  }
+
+  // coarsen the distant tiles of the previous frame
+  if (DepthParams.z > 0.0f) {
+    uint w, h;
+    t_DepthTiles.GetDimensions(w, h);
+    float distance = t_DepthTiles[min(uint2(pos_uv * float2(w, h)), uint2(w - 1, h - 1))];
+    rate = max(rate, HintRates[distance >= DepthParams.y ? 2 : distance >= DepthParams.x ? 1 : 0]);
+  }
+
+  // the first ring pattern drawn into the region starts over from the base (with the HAM stamp)
+  uint previous = Region.z ? t_Base[pos] : u_Output[pos];
+  u_Output[pos] = min(previous, rate);
 }
 
+#endif
+
 // clang-format on
@@ -42,6 +42,9 @@ namespace {
     struct CASConstants {
         uint32_t Const0[4];
         uint32_t Const1[4];
+        uint32_t Const2[4]; // Input offset (xy), output offset (zw)
+        uint32_t Const3[4]; // Output extent (xy)
+        uint32_t Const4[4]; // Input slice (x), output slice (y) (stereo only)
     };
 
     class CASUpscaler : public IImageProcessor {
@@ -62,49 +65,164 @@ namespace {
         void update() override {
         }
 
-        void process(std::shared_ptr<ITexture> input,
-                     std::shared_ptr<ITexture> output,
+        void process(const std::shared_ptr<ITexture>& input,
+                     const std::shared_ptr<ITexture>& output,
                      std::vector<std::shared_ptr<ITexture>>& textures,
+                     std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
                      std::array<uint8_t, 1024>& blob,
-                     std::optional<utilities::Eye> eye = std::nullopt) override {
-            // We need to use a per-instance blob.
-            static_assert(sizeof(CASConstants) <= 1024);
-            CASConstants* const config = reinterpret_cast<CASConstants*>(blob.data());
+                     std::optional<utilities::Eye> eye = std::nullopt,
+                     const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr,
+                     std::optional<TextureRegion> inputRegion = std::nullopt,
+                     std::optional<TextureRegion> outputRegion = std::nullopt) override {
+            const auto inputRect = inputRegion ? inputRegion->rect : getFullRect(input);
+            const auto outputRect = outputRegion ? outputRegion->rect : getFullRect(output);
 
             // Update the scaler's configuration specifically for this image.
-            const auto inputWidth = input->getInfo().width;
-            const auto inputHeight = input->getInfo().height;
-            const auto outputWidth = output->getInfo().width;
-            const auto outputHeight = output->getInfo().height;
+            const auto slot = to_integral(eye.value_or(utilities::Eye::Both));
+            const CASConstants newConfig = makeConstants(inputRect, outputRect);
+            auto configBuffer = uploadConstants(buffers, blob, slot, &newConfig, 1);
+
+            // In fused mode, the post-processing is done at the end of the CAS pass.
+            m_device->beginProfileScope("CAS");
+            const auto& shaderCAS = fusedPostProcess && m_shaderCASFused ? m_shaderCASFused : m_shaderCAS;
+            shaderCAS->updateThreadGroups(getThreadGroups(outputRect.extent, 1));
+            m_device->setShader(shaderCAS, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, configBuffer);
+            if (shaderCAS == m_shaderCASFused) {
+                m_device->setShaderInput(1, fusedPostProcess);
+            }
+            m_device->setShaderInput(0, input, inputRegion ? inputRegion->slice : -1);
+            m_device->setShaderOutput(0, output, outputRegion ? outputRegion->slice : -1);
+            m_device->dispatchShader();
+            m_device->endProfileScope();
+        }
+
+        bool isIdentity() const override {
+            return false;
+        }
+
+        bool isStereoSupported() const override {
+            return !!m_shaderCASStereo;
+        }
+
+        void processStereo(const std::shared_ptr<ITexture>& input,
+                           const std::shared_ptr<ITexture>& output,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                           std::array<uint8_t, 1024>& blob,
+                           const std::array<TextureRegion, utilities::ViewCount>& inputRegions,
+                           const std::array<TextureRegion, utilities::ViewCount>& outputRegions,
+                           const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr) override {
+            // Update the scaler's configuration for both eyes at once.
+            CASConstants newConfig[utilities::ViewCount];
+            XrExtent2Di maxExtent{0, 0};
+            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                newConfig[eye] = makeConstants(inputRegions[eye].rect, outputRegions[eye].rect);
+                newConfig[eye].Const4[0] = inputRegions[eye].slice;
+                newConfig[eye].Const4[1] = outputRegions[eye].slice;
+
+                maxExtent.width = std::max(maxExtent.width, outputRegions[eye].rect.extent.width);
+                maxExtent.height = std::max(maxExtent.height, outputRegions[eye].rect.extent.height);
+            }
+            auto configBuffer = uploadConstants(buffers, blob, StereoSlot, newConfig, utilities::ViewCount);
+
+            // The eye index is in the Z dimension. Each eye discards the writes outside of its own viewport.
+            m_device->beginProfileScope("CAS");
+            const auto& shaderCAS =
+                fusedPostProcess && m_shaderCASFusedStereo ? m_shaderCASFusedStereo : m_shaderCASStereo;
+            shaderCAS->updateThreadGroups(getThreadGroups(maxExtent, utilities::ViewCount));
+            m_device->setShader(shaderCAS, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, configBuffer);
+            if (shaderCAS == m_shaderCASFusedStereo) {
+                m_device->setShaderInput(1, fusedPostProcess);
+            }
+            m_device->setShaderInput(0, input, AllSlices);
+            m_device->setShaderOutput(0, output, AllSlices);
+            m_device->dispatchShader();
+            m_device->endProfileScope();
+        }
+
+        bool isFusedPostProcessSupported() const override {
+            return !!m_shaderCASFused;
+        }
+
+        std::shared_ptr<IShaderBuffer>
+        getFusedPostProcessConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                     std::array<uint8_t, 1024>& blob,
+                                     std::optional<utilities::Eye> eye = std::nullopt) override {
+            return nullptr;
+        }
+
+        void setFoveatedRegion(utilities::Eye eye, const std::optional<FoveatedRegion>& region) override {
+        }
+
+        void setTemporalView(utilities::Eye eye, const std::optional<TemporalViewInfo>& view) override {
+        }
+
+      private:
+        // The per-eye slots (see utilities::Eye) are followed by the slots for the stereo configuration.
+        static constexpr size_t StereoSlot = utilities::ViewCount + 1;
+
+        CASConstants makeConstants(const XrRect2Di& inputRect, const XrRect2Di& outputRect) const {
             const float sharpness = m_configManager->getValue(SettingSharpness) / 100.f;
 
-            CasSetup(config->Const0,
-                     config->Const1,
+            CASConstants config{};
+            CasSetup(config.Const0,
+                     config.Const1,
                      AClampF1(sharpness, 0, 1),
-                     static_cast<AF1>(inputWidth),
-                     static_cast<AF1>(inputHeight),
-                     static_cast<AF1>(outputWidth),
-                     static_cast<AF1>(outputHeight));
+                     static_cast<AF1>(inputRect.extent.width),
+                     static_cast<AF1>(inputRect.extent.height),
+                     static_cast<AF1>(outputRect.extent.width),
+                     static_cast<AF1>(outputRect.extent.height));
+            config.Const2[0] = inputRect.offset.x;
+            config.Const2[1] = inputRect.offset.y;
+            config.Const2[2] = outputRect.offset.x;
+            config.Const2[3] = outputRect.offset.y;
+            config.Const3[0] = outputRect.extent.width;
+            config.Const3[1] = outputRect.extent.height;
+
+            return config;
+        }
 
-            // TODO: We can use an IShaderBuffer cache per swapchain and avoid this every frame.
-            m_configBuffer->uploadData(config, sizeof(*config));
+        std::shared_ptr<IShaderBuffer> uploadConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                                       std::array<uint8_t, 1024>& blob,
+                                                       size_t slot,
+                                                       const CASConstants* newConfig,
+                                                       size_t count) {
+            // We need to use a per-instance blob, with one slot per eye and two slots for stereo.
+            static_assert(sizeof(CASConstants) * (StereoSlot + utilities::ViewCount) <= 1024);
+            CASConstants* const config = reinterpret_cast<CASConstants*>(blob.data()) + slot;
+            const auto size = sizeof(CASConstants) * count;
 
+            // Only upload the per-swapchain, per-eye constant buffer when the configuration has changed.
+            if (buffers.size() <= StereoSlot) {
+                buffers.resize(StereoSlot + 1);
+            }
+            auto& configBuffer = buffers[slot];
+            if (!configBuffer || memcmp(config, newConfig, size)) {
+                if (!configBuffer) {
+                    configBuffer = m_device->createBuffer(
+                        size, slot == StereoSlot ? "CAS Stereo Constants CB" : "CAS Constants CB");
+                }
+                memcpy(config, newConfig, size);
+                configBuffer->uploadData(config, size);
+            }
+
+            return configBuffer;
+        }
+
+        static XrRect2Di getFullRect(const std::shared_ptr<ITexture>& texture) {
+            return {{0, 0}, {(int32_t)texture->getInfo().width, (int32_t)texture->getInfo().height}};
+        }
+
+        static std::array<unsigned int, 3> getThreadGroups(const XrExtent2Di& extent, unsigned int viewCount) {
             // This value is the image region dimension that each thread group of the CAS shader operates on
             const auto threadGroupWorkRegionDim = 16u;
-            const std::array<unsigned int, 3> threadGroups = {
-                (outputWidth + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim,  // dispatchX
-                (outputHeight + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim, // dispatchY
-                1};
-
-            m_shaderCAS->updateThreadGroups(threadGroups);
-            m_device->setShader(m_shaderCAS, SamplerType::LinearClamp);
-            m_device->setShaderInput(0, m_configBuffer);
-            m_device->setShaderInput(0, input);
-            m_device->setShaderOutput(0, output);
-            m_device->dispatchShader();
+            return {(extent.width + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim,  // dispatchX
+                    (extent.height + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim, // dispatchY
+                    viewCount};
         }
 
-      private:
         void initializeUpscaler() {
             const auto shadersDir = dllHome / "shaders";
             const auto shaderFile = shadersDir / "CAS.hlsl";
@@ -115,7 +233,30 @@ namespace {
             defines.add("CAS_SAMPLE_SHARPEN_ONLY", m_isSharpenOnly ? 1 : 0);
             m_shaderCAS = m_device->createComputeShader(shaderFile, "mainCS", "CAS CS", {}, defines.get());
 
-            m_configBuffer = m_device->createBuffer(sizeof(CASConstants), "CAS Constants CB");
+            // CAS with post-processing (fused mode)
+            const bool isFused = m_configManager->getValue(SettingFusedPostProcess);
+            if (isFused) {
+                defines.add("POST_PROCESS_FUSED", 1);
+                m_shaderCASFused =
+                    m_device->createComputeShader(shaderFile, "mainCS", "CAS Fused CS", {}, defines.get());
+            } else {
+                m_shaderCASFused.reset();
+            }
+
+            // CAS for both eyes of a texture array in a single dispatch (stereo mode)
+            if (m_configManager->getValue(SettingStereoDispatch)) {
+                defines.add("CAS_STEREO", 1);
+                if (isFused) {
+                    m_shaderCASFusedStereo =
+                        m_device->createComputeShader(shaderFile, "mainCS", "CAS Fused Stereo CS", {}, defines.get());
+                    defines.set("POST_PROCESS_FUSED", 0);
+                }
+                m_shaderCASStereo =
+                    m_device->createComputeShader(shaderFile, "mainCS", "CAS Stereo CS", {}, defines.get());
+            } else {
+                m_shaderCASStereo.reset();
+                m_shaderCASFusedStereo.reset();
+            }
         }
 
         const std::shared_ptr<IConfigManager> m_configManager;
@@ -123,7 +264,9 @@ namespace {
         const bool m_isSharpenOnly;
 
         std::shared_ptr<IComputeShader> m_shaderCAS;
-        std::shared_ptr<IShaderBuffer> m_configBuffer;
+        std::shared_ptr<IComputeShader> m_shaderCASFused;
+        std::shared_ptr<IComputeShader> m_shaderCASStereo;
+        std::shared_ptr<IComputeShader> m_shaderCASFusedStereo;
     };
 
 } // namespace
@@ -37,15 +37,20 @@ namespace {
     constexpr unsigned int WriteDelay = 22; // 1s in bad VR.
 
     struct ConfigValue {
-        int value;
+        int value{0};
         int defaultValue{0};
 
+        bool isLoaded{false};
         bool changedSinceLastQuery{false};
         unsigned int writeCountdown{0};
     };
 
     // A very simple registry/DWORD backed configuration manager.
-    // Handles deferred writes (to only commit values after a few game loops completed).
+    // Handles deferred writes (to only commit values after a few game loops completed). The writes are committed in
+    // batches by a background thread, which also detects the values changed by others.
+    // The values are stored in a flat array: the settings known at compile time use their ID as index, and other
+    // settings are assigned the next index the first time their name is seen. Those are stored separately, so that
+    // the array of the known settings is never reallocated.
     class ConfigManager : public IConfigManager {
       public:
         ConfigManager(const std::string& appName) : m_appName(appName) {
@@ -56,11 +61,32 @@ namespace {
             std::string baseKey = RegPrefix + "\\" + appName;
             m_baseKey = xr::utf8_to_wide(baseKey);
 
+            m_names = {
+#define X(id, name) name,
+                TOOLKIT_CONFIG_SETTINGS(X)
+#undef X
+            };
+            m_values.resize(m_names.size());
+            for (uint32_t i = 0; i < m_names.size(); i++) {
+                m_slots.insert_or_assign(m_names[i], i);
+            }
+
+            // The changes made by others are detected against this first snapshot.
+            {
+                std::unique_lock lock(m_ioMutex);
+                readRegistrySnapshot();
+                m_refreshedValues.clear();
+            }
+            m_ioThread = std::thread([&] { ioLoop(); });
+
             try {
                 m_watcher = wil::make_registry_watcher(
                     HKEY_CURRENT_USER, m_baseKey.c_str(), true, [&](wil::RegistryChangeKind changeType) {
-                        // TODO: Every call to writeValue() will also cause us to invoke this (unnecessarily).
-                        m_needRefresh = true;
+                        {
+                            std::unique_lock lock(m_ioMutex);
+                            m_needRefresh = true;
+                        }
+                        m_ioWakeUp.notify_one();
                     });
             } catch (std::exception&) {
                 // Ignore errors that can happen with UWP applications not able to write to the registry.
@@ -68,47 +94,64 @@ namespace {
         }
 
         ~ConfigManager() override {
+            m_watcher.reset();
+
+            // Pending writes are committed before the thread exits.
+            {
+                std::unique_lock lock(m_ioMutex);
+                m_stop = true;
+            }
+            m_ioWakeUp.notify_one();
+            m_ioThread.join();
+
             // Log all unwritten values.
-            for (auto& value : m_values) {
-                ConfigValue& entry = value.second;
+            for (uint32_t i = 0, count = getNumSlots(); i < count; i++) {
+                ConfigValue& entry = getEntry(i);
 
-                if (entry.writeCountdown > 0) {
+                if (entry.isLoaded && entry.writeCountdown > 0) {
                     Log("Config value '%s' was discarded due to quickly exiting after changing its value\n",
-                        value.first.c_str());
+                        getName(i).c_str());
                 }
             }
         }
 
         void tick() override {
-            const bool m_wasNeedRefresh = m_needRefresh;
+            std::vector<std::pair<std::wstring, int>> refreshedValues;
+            std::vector<std::pair<std::wstring, int>> writes;
+            {
+                std::unique_lock lock(m_ioMutex);
+                std::swap(refreshedValues, m_refreshedValues);
+            }
 
-            for (auto& value : m_values) {
-                const std::string& name = value.first;
-                ConfigValue& entry = value.second;
+            for (const auto& [name, value] : refreshedValues) {
+                refreshValue(xr::wide_to_utf8(name), value);
+            }
 
-                if (m_wasNeedRefresh && !m_ignoreRefresh.count(name)) {
-                    refreshValue(name, entry);
+            for (uint32_t i = 0, count = getNumSlots(); i < count; i++) {
+                ConfigValue& entry = getEntry(i);
+                if (!entry.isLoaded) {
+                    continue;
                 }
 
                 if (entry.writeCountdown > 0) {
                     entry.writeCountdown--;
 
                     if (entry.writeCountdown == 0) {
-                        writeValue(name, entry);
-
-                        // Delete any backup created by the companion tool. This is to avoid bad statefulness.
-                        deleteValue(name + "_bak");
-
-                        // Don't refresh this value, since we just wrote it!
-                        m_ignoreRefresh.insert(name);
+                        TraceLoggingWrite(g_traceProvider,
+                                          "Config_WriteValue",
+                                          TLArg(getName(i).c_str(), "Name"),
+                                          TLArg(entry.value, "Value"));
+                        writes.push_back({xr::utf8_to_wide(getName(i)), entry.value});
                     }
                 }
             }
 
-            // Only clear the need for refresh if the whole tick update saw the changes.
-            m_needRefresh = m_wasNeedRefresh != m_needRefresh;
-            if (!m_needRefresh) {
-                m_ignoreRefresh.clear();
+            if (!writes.empty()) {
+                {
+                    std::unique_lock lock(m_ioMutex);
+                    m_pendingWrites.insert(m_pendingWrites.end(), writes.begin(), writes.end());
+                }
+                m_ioWakeUp.notify_one();
             }
         }
 
@@ -117,77 +160,60 @@ namespace {
         }
 
         void setDefault(const std::string& name, int value) override {
-            auto it = m_values.find(name);
-
-            if (it != m_values.end()) {
-                Log("Config value '%s' is assigned a default after being used\n", name.c_str());
-            }
+            setDefault(getSlot(name), value);
+        }
 
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            entry.defaultValue = value;
-            if (it == m_values.end()) {
-                readValue(name, entry);
-                m_values.insert_or_assign(name, entry);
-            }
+        void setDefault(const Setting& setting, int value) override {
+            setDefault(getSlot(setting), value);
         }
 
         int getValue(const std::string& name) const override {
-            auto it = m_values.find(name);
-
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            if (it != m_values.end()) {
-                entry.changedSinceLastQuery = false;
-            } else {
-                readValue(name, entry);
-                m_values.insert_or_assign(name, entry);
-            }
+            return getValue(getSlot(name));
+        }
 
-            return entry.value;
+        int getValue(const Setting& setting) const override {
+            return getValue(getSlot(setting));
         }
 
         int peekValue(const std::string& name) const override {
-            auto it = m_values.find(name);
-
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            if (it == m_values.end()) {
-                readValue(name, entry);
-                m_values.insert_or_assign(name, entry);
-            }
+            return peekValue(getSlot(name));
+        }
 
-            return entry.value;
+        int peekValue(const Setting& setting) const override {
+            return peekValue(getSlot(setting));
         }
 
         void setValue(const std::string& name, int value, bool noCommitDelay) override {
-            auto it = m_values.find(name);
+            setValue(getSlot(name), value, noCommitDelay);
+        }
 
-            ConfigValue newEntry;
-            ConfigValue& entry = it != m_values.end() ? it->second : newEntry;
-            entry.value = value;
-            entry.changedSinceLastQuery = true;
-            entry.writeCountdown = noCommitDelay ? 1 : WriteDelay;
-            if (it == m_values.end()) {
-                m_values.insert_or_assign(name, entry);
-            }
+        void setValue(const Setting& setting, int value, bool noCommitDelay) override {
+            setValue(getSlot(setting), value, noCommitDelay);
         }
 
         bool hasChanged(const std::string& name) const override {
-            auto it = m_values.find(name);
-
-            if (it != m_values.end()) {
-                ConfigValue& entry = it->second;
+            return hasChanged(getSlot(name));
+        }
 
-                return entry.changedSinceLastQuery;
-            }
+        bool hasChanged(const Setting& setting) const override {
+            return hasChanged(getSlot(setting));
+        }
 
-            return false;
+        uint64_t getChangeSerial() const override {
+            return m_changeSerial;
         }
 
         void deleteValue(const std::string& name) override {
-            RegDeleteValue(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(name));
-            m_values.erase(name);
+            {
+                std::unique_lock lock(m_ioMutex);
+                RegDeleteValue(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(name));
+                m_registrySnapshot.erase(xr::utf8_to_wide(name));
+            }
+
+            const auto slot = findSlot(name);
+            if (slot) {
+                getEntry(slot.value()) = {};
+            }
         }
 
         void resetToDefaults() override {
@@ -203,17 +229,125 @@ namespace {
         }
 
         void hardReset() override {
-            RegDeleteKey(HKEY_CURRENT_USER, m_baseKey);
-            for (auto& value : m_values) {
-                ConfigValue& entry = value.second;
+            {
+                std::unique_lock lock(m_ioMutex);
+                m_pendingWrites.clear();
+                RegDeleteKey(HKEY_CURRENT_USER, m_baseKey);
+                m_registrySnapshot.clear();
+            }
+            for (uint32_t i = 0, count = getNumSlots(); i < count; i++) {
+                ConfigValue& entry = getEntry(i);
+                if (!entry.isLoaded) {
+                    continue;
+                }
 
                 entry.value = entry.defaultValue;
                 entry.changedSinceLastQuery = true;
                 entry.writeCountdown = 0;
             }
+            m_changeSerial++;
         }
 
       private:
+        static uint32_t getSlot(const Setting& setting) {
+            return static_cast<uint32_t>(to_integral(setting.id));
+        }
+
+        uint32_t getSlot(const std::string& name) const {
+            std::unique_lock lock(m_slotsMutex);
+
+            auto it = m_slots.find(name);
+            if (it == m_slots.end()) {
+                it = m_slots.insert_or_assign(name, (uint32_t)(m_values.size() + m_otherValues.size())).first;
+                m_otherNames.push_back(name);
+                m_otherValues.push_back({});
+            }
+            return it->second;
+        }
+
+        // Does not create a slot for a new name.
+        std::optional<uint32_t> findSlot(const std::string& name) const {
+            std::unique_lock lock(m_slotsMutex);
+
+            const auto it = m_slots.find(name);
+            if (it == m_slots.end()) {
+                return {};
+            }
+            return it->second;
+        }
+
+        uint32_t getNumSlots() const {
+            std::unique_lock lock(m_slotsMutex);
+            return (uint32_t)(m_values.size() + m_otherValues.size());
+        }
+
+        ConfigValue& getEntry(uint32_t slot) const {
+            if (slot < m_values.size()) {
+                return m_values[slot];
+            }
+
+            std::unique_lock lock(m_slotsMutex);
+            return m_otherValues[slot - m_values.size()];
+        }
+
+        const std::string& getName(uint32_t slot) const {
+            if (slot < m_names.size()) {
+                return m_names[slot];
+            }
+
+            std::unique_lock lock(m_slotsMutex);
+            return m_otherNames[slot - m_names.size()];
+        }
+
+        void setDefault(uint32_t slot, int value) {
+            ConfigValue& entry = getEntry(slot);
+
+            if (entry.isLoaded) {
+                Log("Config value '%s' is assigned a default after being used\n", getName(slot).c_str());
+            }
+
+            entry.defaultValue = value;
+            if (!entry.isLoaded) {
+                readValue(slot);
+            }
+        }
+
+        int getValue(uint32_t slot) const {
+            ConfigValue& entry = getEntry(slot);
+            if (entry.isLoaded) {
+                entry.changedSinceLastQuery = false;
+            } else {
+                readValue(slot);
+            }
+
+            return entry.value;
+        }
+
+        int peekValue(uint32_t slot) const {
+            ConfigValue& entry = getEntry(slot);
+            if (!entry.isLoaded) {
+                readValue(slot);
+            }
+
+            return entry.value;
+        }
+
+        void setValue(uint32_t slot, int value, bool noCommitDelay) {
+            ConfigValue& entry = getEntry(slot);
+            if (entry.value != value) {
+                m_changeSerial++;
+            }
+            entry.value = value;
+            entry.isLoaded = true;
+            entry.changedSinceLastQuery = true;
+            entry.writeCountdown = noCommitDelay ? 1 : WriteDelay;
+        }
+
+        bool hasChanged(uint32_t slot) const {
+            const ConfigValue& entry = getEntry(slot);
+            return entry.isLoaded && entry.changedSinceLastQuery;
+        }
+
         std::optional<int> readRegistry(const std::string& name) const {
             auto value = RegGetDword(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(name));
             if (!value) {
@@ -223,7 +357,11 @@ namespace {
             return value;
         }
 
-        void readValue(const std::string& name, ConfigValue& entry) const {
+        void readValue(uint32_t slot) const {
+            const std::string& name = getName(slot);
+            ConfigValue& entry = getEntry(slot);
+
+            entry.isLoaded = true;
             if (m_safeMode) {
                 entry.value = entry.defaultValue;
                 entry.changedSinceLastQuery = true;
@@ -231,6 +369,9 @@ namespace {
             }
 
             const auto value = readRegistry(name);
+            if (entry.value != value.value_or(entry.defaultValue)) {
+                m_changeSerial++;
+            }
             entry.value = value.value_or(entry.defaultValue);
             entry.changedSinceLastQuery = true;
 
@@ -238,14 +379,20 @@ namespace {
                 g_traceProvider, "Config_ReadValue", TLArg(name.c_str(), "Name"), TLArg(entry.value, "Value"));
         }
 
-        void refreshValue(const std::string& name, ConfigValue& entry) const {
+        void refreshValue(const std::string& name, int value) {
             if (m_safeMode) {
                 return;
             }
 
-            const auto value = readRegistry(name);
-            if (value && entry.value != value.value_or(entry.defaultValue)) {
-                entry.value = value.value_or(entry.defaultValue);
+            // Values that were never used do not need to be refreshed.
+            const auto slot = findSlot(name);
+            if (!slot) {
+                return;
+            }
+
+            ConfigValue& entry = getEntry(slot.value());
+            if (entry.isLoaded && entry.value != value) {
+                entry.value = value;
                 entry.changedSinceLastQuery = true;
 
                 // Cancel pending writes.
@@ -253,10 +400,93 @@ namespace {
             }
         }
 
-        void writeValue(const std::string& name, ConfigValue& entry) const {
-            TraceLoggingWrite(
-                g_traceProvider, "Config_WriteValue", TLArg(name.c_str(), "Name"), TLArg(entry.value, "Value"));
-            RegSetDword(HKEY_CURRENT_USER, m_baseKey, xr::utf8_to_wide(name), entry.value);
+        void ioLoop() {
+            RegisterThread(ThreadClass::Background);
+
+            std::unique_lock lock(m_ioMutex);
+            while (true) {
+                m_ioWakeUp.wait(lock, [&] { return m_stop || m_needRefresh || !m_pendingWrites.empty(); });
+
+                std::vector<std::pair<std::wstring, int>> writes;
+                std::swap(writes, m_pendingWrites);
+                if (!writes.empty()) {
+                    lock.unlock();
+                    commitWrites(writes);
+                    lock.lock();
+
+                    // Our own writes will not be seen as changes.
+                    for (const auto& [name, value] : writes) {
+                        m_registrySnapshot.insert_or_assign(name, value);
+                    }
+                }
+
+                if (m_needRefresh) {
+                    m_needRefresh = false;
+                    readRegistrySnapshot();
+                }
+
+                if (m_stop && m_pendingWrites.empty()) {
+                    break;
+                }
+            }
+
+            UnregisterThread();
+        }
+
+        // Commit all the writes under a single opened key.
+        void commitWrites(const std::vector<std::pair<std::wstring, int>>& writes) const {
+            wil::unique_hkey key;
+            if (::RegCreateKeyEx(HKEY_CURRENT_USER,
+                                 m_baseKey.c_str(),
+                                 0,
+                                 nullptr,
+                                 0,
+                                 KEY_SET_VALUE,
+                                 nullptr,
+                                 key.put(),
+                                 nullptr) != ERROR_SUCCESS) {
+                Log("Failed to open configuration key for writing\n");
+                return;
+            }
+
+            for (const auto& [name, value] : writes) {
+                RegSetDword(key.get(), {}, name, value);
+
+                // Delete any backup created by the companion tool. This is to avoid bad statefulness.
+                RegDeleteValue(key.get(), {}, name + L"_bak");
+            }
+        }
+
+        // Read all the values at once, and queue the ones that differ from the last snapshot for tick() to refresh.
+        // Must be called with the I/O lock held.
+        void readRegistrySnapshot() {
+            wil::unique_hkey key;
+            if (::RegOpenKeyEx(HKEY_CURRENT_USER, m_baseKey.c_str(), 0, KEY_QUERY_VALUE, key.put()) != ERROR_SUCCESS) {
+                return;
+            }
+
+            for (DWORD index = 0;; index++) {
+                wchar_t name[256];
+                DWORD nameLength = ARRAYSIZE(name);
+                DWORD type;
+                DWORD data;
+                DWORD dataSize = sizeof(data);
+                const LONG retCode = ::RegEnumValue(
+                    key.get(), index, name, &nameLength, nullptr, &type, reinterpret_cast<BYTE*>(&data), &dataSize);
+                if (retCode == ERROR_NO_MORE_ITEMS) {
+                    break;
+                }
+                if (retCode != ERROR_SUCCESS || type != REG_DWORD) {
+                    continue;
+                }
+
+                const auto value = static_cast<int>(data);
+                const auto it = m_registrySnapshot.find(name);
+                if (it == m_registrySnapshot.end() || it->second != value) {
+                    m_registrySnapshot.insert_or_assign(name, value);
+                    m_refreshedValues.push_back({name, value});
+                }
+            }
         }
 
         const std::string m_appName;
@@ -264,10 +494,28 @@ namespace {
         bool m_safeMode;
         bool m_developer;
         wil::unique_registry_watcher m_watcher;
-        bool m_needRefresh{false};
-        std::set<std::string> m_ignoreRefresh;
 
-        mutable std::map<std::string, ConfigValue> m_values;
+        std::thread m_ioThread;
+        std::mutex m_ioMutex;
+        std::condition_variable m_ioWakeUp;
+        bool m_stop{false};
+        bool m_needRefresh{false};
+        std::vector<std::pair<std::wstring, int>> m_pendingWrites;
+        std::vector<std::pair<std::wstring, int>> m_refreshedValues;
+
+        // The last values known to be in the registry.
+        std::map<std::wstring, int> m_registrySnapshot;
+
+        // Only the registry I/O and the settings unknown at compile time use the names.
+        std::vector<std::string> m_names;
+        mutable std::vector<ConfigValue> m_values;
+
+        // The settings unknown at compile time. The deques never move their existing elements.
+        mutable std::mutex m_slotsMutex;
+        mutable std::deque<std::string> m_otherNames;
+        mutable std::deque<ConfigValue> m_otherValues;
+        mutable std::unordered_map<std::string, uint32_t> m_slots;
+        mutable uint64_t m_changeSerial{0};
     };
 
 } // namespace
@@ -278,4 +526,48 @@ namespace toolkit::config {
         return std::make_shared<ConfigManager>(appName);
     }
 
+    void SetProcessingDefaults(IConfigManager& configManager) {
+        // Upscaling.
+        configManager.setDefault(SettingSharpness, 20);
+        configManager.setDefault(SettingFusedPostProcess, 0);
+        configManager.setDefault(SettingStereoDispatch, 0);
+        configManager.setDefault(SettingFSRSinglePass, 0);
+        configManager.setDefault(SettingTemporalHistoryWeight, 90);
+
+        // Foveated rendering.
+        configManager.setEnumDefault(SettingVRSQuality, VariableShadingRateQuality::Performance);
+        configManager.setEnumDefault(SettingVRSPattern, VariableShadingRatePattern::Wide);
+        configManager.setDefault(SettingVRSInner, 0); // 1x
+        configManager.setDefault(SettingVRSInnerRadius, 55);
+        configManager.setDefault(SettingVRSMiddle, 2); // 1/4x
+        configManager.setDefault(SettingVRSOuter, 4);  // 1/16x
+        configManager.setDefault(SettingVRSOuterRadius, 80);
+        configManager.setDefault(SettingVRSXOffset, 0);
+        configManager.setDefault(SettingVRSXScale, 125);
+        configManager.setDefault(SettingVRSYOffset, 0);
+        configManager.setDefault(SettingVRSPreferHorizontal, 0);
+        configManager.setDefault(SettingVRSLeftRightBias, 0);
+        configManager.setDefault(SettingVRSCullHAM, 0);
+        configManager.setDefault(SettingVRSContentAdaptive, 0);
+        configManager.setDefault(SettingVRSDepthAdaptive, 0);
+        configManager.setDefault(SettingVRSDepthDistance2x2, 200);
+        configManager.setDefault(SettingVRSDepthDistance4x4, 1000);
+        configManager.setDefault(SettingDisableHAM, 0);
+
+        // Appearance.
+        configManager.setDefault(SettingPostSunGlasses, 0);
+        configManager.setDefault(SettingPostContrast, 500);
+        configManager.setDefault(SettingPostBrightness, 500);
+        configManager.setDefault(SettingPostExposure, 500);
+        configManager.setDefault(SettingPostSaturation, 500);
+        configManager.setDefault(SettingPostColorGainR, 500);
+        configManager.setDefault(SettingPostColorGainG, 500);
+        configManager.setDefault(SettingPostColorGainB, 500);
+        configManager.setDefault(SettingPostVibrance, 0);
+        configManager.setDefault(SettingPostHighlights, 1000);
+        configManager.setDefault(SettingPostShadows, 0);
+        configManager.setDefault(SettingPostChromaticCorrectionR, 100090);
+        configManager.setDefault(SettingPostChromaticCorrectionB, 99880);
+    }
+
 } // namespace toolkit::config
@@ -63,6 +63,27 @@ void main(uint3 id : SV_DispatchThreadID)
             resource->SetPrivateData(WKPDID_D3DDebugObjectName, static_cast<UINT>(name.size()), name.data());
     }
 
+    // The maximum number of GPU timers that can be created. Their timestamp queries are owned by the device.
+    constexpr size_t MaxGpuTimers = 256;
+
+    // The number of timestamp disjoint intervals that can be in-flight. An interval spans (at most) one frame, the
+    // frames in-flight are bounded by OpenXR, and we keep one extra in case the GPU is lagging behind.
+    constexpr size_t NumTimestampIntervals = 4;
+
+    // The number of input/output slots of each stage that the toolkit may use. When only tracking the state touched
+    // by the toolkit, the slots beyond this number are left untouched.
+    constexpr UINT TrackedSlotCount = 4;
+
+    // How the application's context state is preserved while the toolkit renders.
+    enum class ContextStateMode {
+        // Save and restore the entire pipeline state.
+        Full = 0,
+        // Save and restore only the stages and the slots that the toolkit may touch.
+        Tracked,
+        // Swap to a dedicated device context state object, when available.
+        Swap,
+    };
+
     struct D3D11ContextState {
         ComPtr<ID3D11InputLayout> inputLayout;
         D3D11_PRIMITIVE_TOPOLOGY topology;
@@ -105,16 +126,23 @@ void main(uint3 id : SV_DispatchThreadID)
         D3D11_RECT scissorRects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
         UINT numScissorRects;
 
-        void save(ID3D11DeviceContext* context) {
+        // When tracked is set, only the stages and the slots that the toolkit may touch are saved.
+        void save(ID3D11DeviceContext* context, bool tracked = false) {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(local, "D3D11ContextState_Save");
+            TraceLoggingWriteStart(local,
+                                   "D3D11ContextState_Save",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
+                                   TLArg(tracked, "Tracked"));
+
+            m_isTracked = tracked;
 
             context->IAGetInputLayout(set(inputLayout));
             context->IAGetPrimitiveTopology(&topology);
             {
                 ID3D11Buffer* vbs[ARRAYSIZE(vertexBuffers)];
-                context->IAGetVertexBuffers(0, ARRAYSIZE(vbs), vbs, vertexBufferStrides, vertexBufferOffsets);
-                for (uint32_t i = 0; i < ARRAYSIZE(vbs); i++) {
+                const UINT count = getSlotCount(ARRAYSIZE(vbs));
+                context->IAGetVertexBuffers(0, count, vbs, vertexBufferStrides, vertexBufferOffsets);
+                for (uint32_t i = 0; i < count; i++) {
                     attach(vertexBuffers[i], vbs[i]);
                 }
             }
@@ -131,43 +159,47 @@ void main(uint3 id : SV_DispatchThreadID)
             context->OMGetDepthStencilState(set(depthStencilState), &stencilRef);
             context->OMGetBlendState(set(blendState), blendFactor, &blendMask);
 
-#define SHADER_STAGE_SAVE_CONTEXT(stage)                                                                               \
+#define SHADER_STAGE_SAVE_CONTEXT(stage, isUsedByToolkit)                                                              \
     context->stage##GetShader(set(stage##Program), nullptr, nullptr);                                                  \
-    {                                                                                                                  \
+    if (!m_isTracked || isUsedByToolkit) {                                                                             \
         ID3D11Buffer* buffers[ARRAYSIZE(stage##ConstantBuffers)];                                                      \
-        context->stage##GetConstantBuffers(0, ARRAYSIZE(buffers), buffers);                                            \
-        for (uint32_t i = 0; i < ARRAYSIZE(buffers); i++) {                                                            \
+        const UINT count = getSlotCount(ARRAYSIZE(buffers));                                                           \
+        context->stage##GetConstantBuffers(0, count, buffers);                                                         \
+        for (uint32_t i = 0; i < count; i++) {                                                                         \
             attach(stage##ConstantBuffers[i], buffers[i]);                                                             \
         }                                                                                                              \
     }                                                                                                                  \
-    {                                                                                                                  \
+    if (!m_isTracked || isUsedByToolkit) {                                                                             \
         ID3D11SamplerState* samp[ARRAYSIZE(stage##Samplers)];                                                          \
-        context->stage##GetSamplers(0, ARRAYSIZE(samp), samp);                                                         \
-        for (uint32_t i = 0; i < ARRAYSIZE(samp); i++) {                                                               \
+        const UINT count = getSlotCount(ARRAYSIZE(samp));                                                              \
+        context->stage##GetSamplers(0, count, samp);                                                                   \
+        for (uint32_t i = 0; i < count; i++) {                                                                         \
             attach(stage##Samplers[i], samp[i]);                                                                       \
         }                                                                                                              \
     }                                                                                                                  \
-    {                                                                                                                  \
+    if (!m_isTracked || isUsedByToolkit) {                                                                             \
         ID3D11ShaderResourceView* srvs[ARRAYSIZE(stage##ShaderResources)];                                             \
-        context->stage##GetShaderResources(0, ARRAYSIZE(srvs), srvs);                                                  \
-        for (uint32_t i = 0; i < ARRAYSIZE(srvs); i++) {                                                               \
+        const UINT count = getSlotCount(ARRAYSIZE(srvs));                                                              \
+        context->stage##GetShaderResources(0, count, srvs);                                                            \
+        for (uint32_t i = 0; i < count; i++) {                                                                         \
             attach(stage##ShaderResources[i], srvs[i]);                                                                \
         }                                                                                                              \
     }
 
-            SHADER_STAGE_SAVE_CONTEXT(VS);
-            SHADER_STAGE_SAVE_CONTEXT(PS);
-            SHADER_STAGE_SAVE_CONTEXT(GS);
-            SHADER_STAGE_SAVE_CONTEXT(DS);
-            SHADER_STAGE_SAVE_CONTEXT(HS);
-            SHADER_STAGE_SAVE_CONTEXT(CS);
+            SHADER_STAGE_SAVE_CONTEXT(VS, true);
+            SHADER_STAGE_SAVE_CONTEXT(PS, true);
+            SHADER_STAGE_SAVE_CONTEXT(GS, true);
+            SHADER_STAGE_SAVE_CONTEXT(DS, false);
+            SHADER_STAGE_SAVE_CONTEXT(HS, false);
+            SHADER_STAGE_SAVE_CONTEXT(CS, true);
 
 #undef SHADER_STAGE_SAVE_CONTEXT
 
             {
                 ID3D11UnorderedAccessView* uavs[ARRAYSIZE(CSUnorderedResources)];
-                context->CSGetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs);
-                for (uint32_t i = 0; i < ARRAYSIZE(uavs); i++) {
+                const UINT count = getSlotCount(ARRAYSIZE(uavs));
+                context->CSGetUnorderedAccessViews(0, count, uavs);
+                for (uint32_t i = 0; i < count; i++) {
                     attach(CSUnorderedResources[i], uavs[i]);
                 }
             }
@@ -180,21 +212,22 @@ void main(uint3 id : SV_DispatchThreadID)
 
             m_isValid = true;
 
-            TraceLoggingWriteStop(local, "D3D11ContextState_Save");
+            TraceLoggingWriteStop(local, "D3D11ContextState_Save", TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         void restore(ID3D11DeviceContext* context) const {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(local, "D3D11ContextState_Restore");
+            TraceLoggingWriteStart(local, "D3D11ContextState_Restore", TraceLoggingKeyword(TLK_GraphicsHooks));
 
             context->IASetInputLayout(get(inputLayout));
             context->IASetPrimitiveTopology(topology);
             {
                 ID3D11Buffer* vbs[ARRAYSIZE(vertexBuffers)];
-                for (uint32_t i = 0; i < ARRAYSIZE(vbs); i++) {
+                const UINT count = getSlotCount(ARRAYSIZE(vbs));
+                for (uint32_t i = 0; i < count; i++) {
                     vbs[i] = get(vertexBuffers[i]);
                 }
-                context->IASetVertexBuffers(0, ARRAYSIZE(vbs), vbs, vertexBufferStrides, vertexBufferOffsets);
+                context->IASetVertexBuffers(0, count, vbs, vertexBufferStrides, vertexBufferOffsets);
             }
             context->IASetIndexBuffer(get(indexBuffer), indexBufferFormat, indexBufferOffset);
 
@@ -208,52 +241,56 @@ void main(uint3 id : SV_DispatchThreadID)
             context->OMSetDepthStencilState(get(depthStencilState), stencilRef);
             context->OMSetBlendState(get(blendState), blendFactor, blendMask);
 
-#define SHADER_STAGE_RESTORE_CONTEXT(stage)                                                                            \
+#define SHADER_STAGE_RESTORE_CONTEXT(stage, isUsedByToolkit)                                                           \
     context->stage##SetShader(get(stage##Program), nullptr, 0);                                                        \
-    {                                                                                                                  \
+    if (!m_isTracked || isUsedByToolkit) {                                                                             \
         ID3D11Buffer* buffers[ARRAYSIZE(stage##ConstantBuffers)];                                                      \
-        for (uint32_t i = 0; i < ARRAYSIZE(buffers); i++) {                                                            \
+        const UINT count = getSlotCount(ARRAYSIZE(buffers));                                                           \
+        for (uint32_t i = 0; i < count; i++) {                                                                         \
             buffers[i] = get(stage##ConstantBuffers[i]);                                                               \
         }                                                                                                              \
-        context->stage##SetConstantBuffers(0, ARRAYSIZE(buffers), buffers);                                            \
+        context->stage##SetConstantBuffers(0, count, buffers);                                                         \
     }                                                                                                                  \
-    {                                                                                                                  \
+    if (!m_isTracked || isUsedByToolkit) {                                                                             \
         ID3D11SamplerState* samp[ARRAYSIZE(stage##Samplers)];                                                          \
-        for (uint32_t i = 0; i < ARRAYSIZE(samp); i++) {                                                               \
+        const UINT count = getSlotCount(ARRAYSIZE(samp));                                                              \
+        for (uint32_t i = 0; i < count; i++) {                                                                         \
             samp[i] = get(stage##Samplers[i]);                                                                         \
         }                                                                                                              \
-        context->stage##SetSamplers(0, ARRAYSIZE(samp), samp);                                                         \
+        context->stage##SetSamplers(0, count, samp);                                                                   \
     }                                                                                                                  \
-    {                                                                                                                  \
+    if (!m_isTracked || isUsedByToolkit) {                                                                             \
         ID3D11ShaderResourceView* srvs[ARRAYSIZE(stage##ShaderResources)];                                             \
-        for (uint32_t i = 0; i < ARRAYSIZE(srvs); i++) {                                                               \
+        const UINT count = getSlotCount(ARRAYSIZE(srvs));                                                              \
+        for (uint32_t i = 0; i < count; i++) {                                                                         \
             srvs[i] = get(stage##ShaderResources[i]);                                                                  \
         }                                                                                                              \
-        context->stage##SetShaderResources(0, ARRAYSIZE(srvs), srvs);                                                  \
+        context->stage##SetShaderResources(0, count, srvs);                                                            \
     }
 
-            SHADER_STAGE_RESTORE_CONTEXT(VS);
-            SHADER_STAGE_RESTORE_CONTEXT(PS);
-            SHADER_STAGE_RESTORE_CONTEXT(GS);
-            SHADER_STAGE_RESTORE_CONTEXT(DS);
-            SHADER_STAGE_RESTORE_CONTEXT(HS);
-            SHADER_STAGE_RESTORE_CONTEXT(CS);
+            SHADER_STAGE_RESTORE_CONTEXT(VS, true);
+            SHADER_STAGE_RESTORE_CONTEXT(PS, true);
+            SHADER_STAGE_RESTORE_CONTEXT(GS, true);
+            SHADER_STAGE_RESTORE_CONTEXT(DS, false);
+            SHADER_STAGE_RESTORE_CONTEXT(HS, false);
+            SHADER_STAGE_RESTORE_CONTEXT(CS, true);
 
 #undef SHADER_STAGE_RESTORE_CONTEXT
 
             {
                 ID3D11UnorderedAccessView* uavs[ARRAYSIZE(CSUnorderedResources)];
-                for (uint32_t i = 0; i < ARRAYSIZE(uavs); i++) {
+                const UINT count = getSlotCount(ARRAYSIZE(uavs));
+                for (uint32_t i = 0; i < count; i++) {
                     uavs[i] = get(CSUnorderedResources[i]);
                 }
-                context->CSGetUnorderedAccessViews(0, ARRAYSIZE(uavs), uavs);
+                context->CSSetUnorderedAccessViews(0, count, uavs, nullptr);
             }
 
             context->RSSetState(get(rasterizerState));
             context->RSSetViewports(numViewports, viewports);
             context->RSSetScissorRects(numScissorRects, scissorRects);
 
-            TraceLoggingWriteStop(local, "D3D11ContextState_Restore");
+            TraceLoggingWriteStop(local, "D3D11ContextState_Restore", TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         void clear() {
@@ -298,14 +335,98 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
       private:
+        UINT getSlotCount(UINT count) const {
+            return m_isTracked ? std::min(count, TrackedSlotCount) : count;
+        }
+
         bool m_isValid{false};
+        bool m_isTracked{false};
     };
 
-    // Wrap a pixel shader resource. Obtained from D3D11Device.
+    // A flat open-addressing table from the description of an application sampler to its biased replacement. Samplers
+    // that do not need biasing are recorded with a null replacement.
+    class BiasedSamplerCache {
+      public:
+        // Returns the entry for the description, or null if it must be created with insert().
+        const ComPtr<ID3D11SamplerState>* find(const D3D11_SAMPLER_DESC& desc, uint64_t hash) const {
+            if (m_entries.empty()) {
+                return nullptr;
+            }
+
+            for (size_t i = hash & (m_entries.size() - 1);; i = (i + 1) & (m_entries.size() - 1)) {
+                const auto& entry = m_entries[i];
+                if (!entry.isUsed) {
+                    return nullptr;
+                }
+                if (entry.hash == hash && !memcmp(&entry.desc, &desc, sizeof(desc))) {
+                    return &entry.sampler;
+                }
+            }
+        }
+
+        void insert(const D3D11_SAMPLER_DESC& desc, uint64_t hash, ComPtr<ID3D11SamplerState> sampler) {
+            // Keep the load factor under 1/2 so that the probe sequences remain short.
+            if ((m_size + 1) * 2 > m_entries.size()) {
+                std::vector<Entry> entries(std::max(m_entries.size() * 2, InitialCapacity));
+                std::swap(entries, m_entries);
+                m_size = 0;
+                for (auto& entry : entries) {
+                    if (entry.isUsed) {
+                        insertEntry(std::move(entry));
+                    }
+                }
+            }
+
+            insertEntry({hash, desc, sampler, true});
+        }
+
+        void clear() {
+            m_entries.clear();
+            m_size = 0;
+        }
+
+        static uint64_t hash(const D3D11_SAMPLER_DESC& desc) {
+            // FNV-1a.
+            uint64_t hash = 0xcbf29ce484222325ull;
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&desc);
+            for (size_t i = 0; i < sizeof(desc); i++) {
+                hash ^= bytes[i];
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+      private:
+        struct Entry {
+            uint64_t hash;
+            D3D11_SAMPLER_DESC desc;
+            ComPtr<ID3D11SamplerState> sampler;
+            bool isUsed{false};
+        };
+
+        void insertEntry(Entry&& entry) {
+            size_t i = entry.hash & (m_entries.size() - 1);
+            while (m_entries[i].isUsed) {
+                i = (i + 1) & (m_entries.size() - 1);
+            }
+            m_entries[i] = std::move(entry);
+            m_size++;
+        }
+
+        static constexpr size_t InitialCapacity = 64;
+
+        std::vector<Entry> m_entries;
+        size_t m_size{0};
+    };
+
+    // Wrap a pixel shader resource. Obtained from D3D11Device. The shader is compiled on a worker thread, and it is
+    // created upon first use.
     class D3D11QuadShader : public IQuadShader {
       public:
-        D3D11QuadShader(std::shared_ptr<IDevice> device, ID3D11PixelShader* pixelShader)
-            : m_device(device), m_pixelShader(pixelShader) {
+        D3D11QuadShader(std::shared_ptr<IDevice> device,
+                        std::shared_future<ComPtr<ID3DBlob>> shaderBytes,
+                        std::string_view debugName)
+            : m_device(device), m_shaderBytes(std::move(shaderBytes)), m_debugName(debugName) {
         }
 
         Api getApi() const override {
@@ -317,21 +438,34 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
         void* getNativePtr() const override {
+            if (!m_pixelShader) {
+                const auto& psBytes = m_shaderBytes.get();
+                CHECK_HRCMD(m_device->getAs<D3D11>()->CreatePixelShader(
+                    psBytes->GetBufferPointer(), psBytes->GetBufferSize(), nullptr, set(m_pixelShader)));
+
+                SetDebugName(get(m_pixelShader), m_debugName);
+            }
             return get(m_pixelShader);
         }
 
       private:
         const std::shared_ptr<IDevice> m_device;
-        const ComPtr<ID3D11PixelShader> m_pixelShader;
+        const std::shared_future<ComPtr<ID3DBlob>> m_shaderBytes;
+        const std::string m_debugName;
+
+        mutable ComPtr<ID3D11PixelShader> m_pixelShader;
     };
 
-    // Wrap a compute shader resource. Obtained from D3D11Device.
+    // Wrap a compute shader resource. Obtained from D3D11Device. The shader is compiled on a worker thread, and it is
+    // created upon first use.
     class D3D11ComputeShader : public IComputeShader {
       public:
         D3D11ComputeShader(std::shared_ptr<IDevice> device,
-                           ID3D11ComputeShader* computeShader,
+                           std::shared_future<ComPtr<ID3DBlob>> shaderBytes,
+                           std::string_view debugName,
                            const std::array<unsigned int, 3>& threadGroups)
-            : m_device(device), m_computeShader(computeShader), m_threadGroups(threadGroups) {
+            : m_device(device), m_shaderBytes(std::move(shaderBytes)), m_debugName(debugName),
+              m_threadGroups(threadGroups) {
         }
 
         Api getApi() const override {
@@ -351,13 +485,23 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
         void* getNativePtr() const override {
+            if (!m_computeShader) {
+                const auto& csBytes = m_shaderBytes.get();
+                CHECK_HRCMD(m_device->getAs<D3D11>()->CreateComputeShader(
+                    csBytes->GetBufferPointer(), csBytes->GetBufferSize(), nullptr, set(m_computeShader)));
+
+                SetDebugName(get(m_computeShader), m_debugName);
+            }
             return get(m_computeShader);
         }
 
       private:
         const std::shared_ptr<IDevice> m_device;
-        const ComPtr<ID3D11ComputeShader> m_computeShader;
+        const std::shared_future<ComPtr<ID3DBlob>> m_shaderBytes;
+        const std::string m_debugName;
         std::array<unsigned int, 3> m_threadGroups;
+
+        mutable ComPtr<ID3D11ComputeShader> m_computeShader;
     };
 
     // Wrap a texture shader resource view. Obtained from D3D11Texture.
@@ -488,17 +632,21 @@ void main(uint3 id : SV_DispatchThreadID)
 
         std::shared_ptr<IShaderInputTextureView> getShaderResourceView(int32_t slice) const override {
             assert(slice < 0 || m_shaderResourceSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_shaderResourceView : m_shaderResourceSubView[slice];
+            auto& view = slice == AllSlices ? m_shaderResourceArrayView
+                         : slice < 0        ? m_shaderResourceView
+                                            : m_shaderResourceSubView[slice];
             if (!view)
-                view = makeShaderInputViewInternal(std::max(slice, 0));
+                view = makeShaderInputViewInternal(std::max(slice, 0), slice == AllSlices ? m_info.arraySize : 1);
             return view;
         }
 
         std::shared_ptr<IComputeShaderOutputView> getUnorderedAccessView(int32_t slice) const override {
             assert(slice < 0 || m_unorderedAccessSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_unorderedAccessView : m_unorderedAccessSubView[slice];
+            auto& view = slice == AllSlices ? m_unorderedAccessArrayView
+                         : slice < 0        ? m_unorderedAccessView
+                                            : m_unorderedAccessSubView[slice];
             if (!view)
-                view = makeUnorderedAccessViewInternal(std::max(slice, 0));
+                view = makeUnorderedAccessViewInternal(std::max(slice, 0), slice == AllSlices ? m_info.arraySize : 1);
             return view;
         }
 
@@ -585,22 +733,34 @@ void main(uint3 id : SV_DispatchThreadID)
         void popState() override {
         }
 
+        std::shared_ptr<ITexture> getUnormAlias() const override {
+            if (!m_unormAlias && IsTypelessColorFormat(m_textureDesc.Format)) {
+                const auto format = GetUnormFormat((DXGI_FORMAT)m_info.format);
+                if (format != DXGI_FORMAT_UNKNOWN) {
+                    auto info = m_info;
+                    info.format = format;
+                    m_unormAlias = std::make_shared<D3D11Texture>(m_device, info, m_textureDesc, get(m_texture));
+                }
+            }
+            return m_unormAlias;
+        }
+
         void* getNativePtr() const override {
             return get(m_texture);
         }
 
       private:
-        std::shared_ptr<D3D11ShaderResourceView> makeShaderInputViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D11ShaderResourceView> makeShaderInputViewInternal(uint32_t slice, uint32_t arraySize = 1) const {
             if (!(m_textureDesc.BindFlags & D3D11_BIND_SHADER_RESOURCE)) {
                 throw std::runtime_error("Texture was not created with D3D11_BIND_SHADER_RESOURCE");
             }
             if (auto device = m_device->getAs<D3D11>()) {
                 D3D11_SHADER_RESOURCE_VIEW_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
-                desc.Format = (DXGI_FORMAT)m_info.format;
+                desc.Format = GetShaderResourceViewFormat((DXGI_FORMAT)m_info.format);
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D11_SRV_DIMENSION_TEXTURE2D : D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
+                desc.Texture2DArray.ArraySize = arraySize;
                 desc.Texture2DArray.FirstArraySlice = slice;
                 desc.Texture2DArray.MipLevels = m_info.mipCount;
                 desc.Texture2DArray.MostDetailedMip = D3D11CalcSubresource(0, 0, m_info.mipCount);
@@ -612,7 +772,7 @@ void main(uint3 id : SV_DispatchThreadID)
             return nullptr;
         }
 
-        std::shared_ptr<D3D11UnorderedAccessView> makeUnorderedAccessViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D11UnorderedAccessView> makeUnorderedAccessViewInternal(uint32_t slice, uint32_t arraySize = 1) const {
             if (!(m_textureDesc.BindFlags & D3D11_BIND_UNORDERED_ACCESS)) {
                 throw std::runtime_error("Texture was not created with D3D11_BIND_UNORDERED_ACCESS");
             }
@@ -622,7 +782,7 @@ void main(uint3 id : SV_DispatchThreadID)
                 desc.Format = (DXGI_FORMAT)m_info.format;
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D11_UAV_DIMENSION_TEXTURE2D : D3D11_UAV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
+                desc.Texture2DArray.ArraySize = arraySize;
                 desc.Texture2DArray.FirstArraySlice = slice;
                 desc.Texture2DArray.MipSlice = D3D11CalcSubresource(0, 0, m_info.mipCount);
 
@@ -661,7 +821,7 @@ void main(uint3 id : SV_DispatchThreadID)
             if (auto device = m_device->getAs<D3D11>()) {
                 D3D11_DEPTH_STENCIL_VIEW_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
-                desc.Format = (DXGI_FORMAT)m_info.format;
+                desc.Format = getDepthStencilViewFormat((DXGI_FORMAT)m_info.format);
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D11_DSV_DIMENSION_TEXTURE2D : D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
                 desc.Texture2DArray.ArraySize = 1;
@@ -675,6 +835,22 @@ void main(uint3 id : SV_DispatchThreadID)
             return nullptr;
         }
 
+        // Application depth buffers are often typeless, in order to be sampled as well.
+        static DXGI_FORMAT getDepthStencilViewFormat(DXGI_FORMAT format) {
+            switch (format) {
+            case DXGI_FORMAT_R16_TYPELESS:
+                return DXGI_FORMAT_D16_UNORM;
+            case DXGI_FORMAT_R24G8_TYPELESS:
+                return DXGI_FORMAT_D24_UNORM_S8_UINT;
+            case DXGI_FORMAT_R32_TYPELESS:
+                return DXGI_FORMAT_D32_FLOAT;
+            case DXGI_FORMAT_R32G8X24_TYPELESS:
+                return DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
+            default:
+                return format;
+            }
+        }
+
         const std::shared_ptr<IDevice> m_device;
         const XrSwapchainCreateInfo m_info;
         const D3D11_TEXTURE2D_DESC m_textureDesc;
@@ -682,12 +858,16 @@ void main(uint3 id : SV_DispatchThreadID)
 
         mutable std::shared_ptr<D3D11ShaderResourceView> m_shaderResourceView;
         mutable std::vector<std::shared_ptr<D3D11ShaderResourceView>> m_shaderResourceSubView;
+        mutable std::shared_ptr<D3D11ShaderResourceView> m_shaderResourceArrayView;
         mutable std::shared_ptr<D3D11UnorderedAccessView> m_unorderedAccessView;
         mutable std::vector<std::shared_ptr<D3D11UnorderedAccessView>> m_unorderedAccessSubView;
+        mutable std::shared_ptr<D3D11UnorderedAccessView> m_unorderedAccessArrayView;
         mutable std::shared_ptr<D3D11RenderTargetView> m_renderTargetView;
         mutable std::vector<std::shared_ptr<D3D11RenderTargetView>> m_renderTargetSubView;
         mutable std::shared_ptr<D3D11DepthStencilView> m_depthStencilView;
         mutable std::vector<std::shared_ptr<D3D11DepthStencilView>> m_depthStencilSubView;
+
+        mutable std::shared_ptr<ITexture> m_unormAlias;
     };
 
     // Wrap a constant buffer. Obtained from D3D11Device.
@@ -768,18 +948,22 @@ void main(uint3 id : SV_DispatchThreadID)
         mutable struct D3D11::MeshData m_meshData;
     };
 
+    // A timer made of two timestamp queries owned by D3D11Device. The timestamps are validated against the disjoint
+    // interval(s) they belong to, and read back in resolveQueries().
     class D3D11GpuTimer : public IGpuTimer {
       public:
-        D3D11GpuTimer(std::shared_ptr<IDevice> device) : m_device(device) {
-            if (auto device = m_device->getAs<D3D11>()) {
-                D3D11_QUERY_DESC queryDesc;
-                ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
-                queryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
-                CHECK_HRCMD(device->CreateQuery(&queryDesc, set(m_timeStampDis)));
-                queryDesc.Query = D3D11_QUERY_TIMESTAMP;
-                CHECK_HRCMD(device->CreateQuery(&queryDesc, set(m_timeStampStart)));
-                CHECK_HRCMD(device->CreateQuery(&queryDesc, set(m_timeStampEnd)));
-            }
+        D3D11GpuTimer(std::shared_ptr<IDevice> device,
+                      ID3D11Query* startQuery,
+                      ID3D11Query* stopQuery,
+                      std::function<uint64_t()> beginTimestampInterval,
+                      std::function<uint64_t(UINT, uint64_t)> endTimestampInterval,
+                      std::function<uint64_t()> getCompletedTimestampInterval,
+                      std::function<uint64_t(UINT)> queryDuration,
+                      UINT index)
+            : m_device(device), m_startQuery(startQuery), m_stopQuery(stopQuery),
+              m_beginTimestampInterval(beginTimestampInterval), m_endTimestampInterval(endTimestampInterval),
+              m_getCompletedTimestampInterval(getCompletedTimestampInterval), m_queryDuration(queryDuration),
+              m_index(index) {
         }
 
         Api getApi() const override {
@@ -791,49 +975,114 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
         void start() override {
-            assert(!m_valid);
-            if (auto context = m_device->getContextAs<D3D11>()) {
-                context->Begin(get(m_timeStampDis));
-                context->End(get(m_timeStampStart));
-            }
+            m_startTimestampInterval = m_beginTimestampInterval();
+            m_device->getContextAs<D3D11>()->End(get(m_startQuery));
+            m_resolveSerial = 0;
         }
 
         void stop() override {
-            assert(!m_valid);
-            if (auto context = m_device->getContextAs<D3D11>()) {
-                context->End(get(m_timeStampEnd));
-                context->End(get(m_timeStampDis));
-                m_valid = true;
-            }
+            m_device->getContextAs<D3D11>()->End(get(m_stopQuery));
+
+            // The timestamps will be available once the disjoint interval has completed.
+            m_resolveSerial = m_endTimestampInterval(m_index, m_startTimestampInterval);
+        }
+
+        bool isReady() const override {
+            return m_resolveSerial && m_getCompletedTimestampInterval() >= m_resolveSerial;
         }
 
         uint64_t query(bool reset) const override {
-            uint64_t duration = 0;
+            return m_queryDuration(m_index);
+        }
+
+      private:
+        const std::shared_ptr<IDevice> m_device;
+        const ComPtr<ID3D11Query> m_startQuery;
+        const ComPtr<ID3D11Query> m_stopQuery;
+        const std::function<uint64_t()> m_beginTimestampInterval;
+        const std::function<uint64_t(UINT, uint64_t)> m_endTimestampInterval;
+        const std::function<uint64_t()> m_getCompletedTimestampInterval;
+        const std::function<uint64_t(UINT)> m_queryDuration;
+        const UINT m_index;
+
+        uint64_t m_startTimestampInterval{0};
+        uint64_t m_resolveSerial{0};
+    };
+
+    class D3D11TextureReadback : public ITextureReadback {
+      public:
+        D3D11TextureReadback(std::shared_ptr<IDevice> device, const XrSwapchainCreateInfo& info)
+            : m_device(device), m_info(info) {
+            auto d3dDevice = m_device->getAs<D3D11>();
+
+            D3D11_TEXTURE2D_DESC desc;
+            ZeroMemory(&desc, sizeof(desc));
+            desc.Width = info.width;
+            desc.Height = info.height;
+            desc.MipLevels = 1;
+            desc.ArraySize = 1;
+            desc.Format = (DXGI_FORMAT)info.format;
+            desc.SampleDesc.Count = 1;
+            desc.Usage = D3D11_USAGE_STAGING;
+            desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+            CHECK_HRCMD(d3dDevice->CreateTexture2D(&desc, nullptr, set(m_stagingTexture)));
+            SetDebugName(get(m_stagingTexture), "Readback TEX2D");
+
+            D3D11_QUERY_DESC queryDesc;
+            ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
+            queryDesc.Query = D3D11_QUERY_EVENT;
+            CHECK_HRCMD(d3dDevice->CreateQuery(&queryDesc, set(m_copyDone)));
+        }
+
+        Api getApi() const override {
+            return Api::D3D11;
+        }
+
+        const XrSwapchainCreateInfo& getInfo() const override {
+            return m_info;
+        }
+
+        void copyFrom(std::shared_ptr<ITexture> source, uint32_t srcX, uint32_t srcY, int32_t srcSlice) override {
+            D3D11_BOX box;
+            box.left = srcX;
+            box.top = srcY;
+            box.right = box.left + m_info.width;
+            box.bottom = box.top + m_info.height;
+            box.front = 0;
+            box.back = 1;
+
             auto context = m_device->getContextAs<D3D11>();
-            if (context && m_valid) {
-                UINT64 startime = 0, endtime = 0;
-                D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disData = {0};
-
-                if (context->GetData(get(m_timeStampStart), &startime, sizeof(UINT64), 0) == S_OK &&
-                    context->GetData(get(m_timeStampEnd), &endtime, sizeof(UINT64), 0) == S_OK &&
-                    context->GetData(get(m_timeStampDis), &disData, sizeof(D3D11_QUERY_DATA_TIMESTAMP_DISJOINT), 0) ==
-                        S_OK &&
-                    !disData.Disjoint) {
-                    duration = static_cast<uint64_t>(((endtime - startime) * 1e6) / disData.Frequency);
-                }
-                m_valid = !reset;
-            }
-            return duration;
+            context->CopySubresourceRegion(
+                get(m_stagingTexture), 0, 0, 0, 0, source->getAs<D3D11>(), std::max(srcSlice, 0), &box);
+            context->End(get(m_copyDone));
+            m_pending = true;
+        }
+
+        bool isReady() const override {
+            return m_pending && m_device->getContextAs<D3D11>()->GetData(
+                                    get(m_copyDone), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+        }
+
+        void readPixels(std::vector<uint8_t>& pixels, uint32_t& rowPitch) override {
+            auto context = m_device->getContextAs<D3D11>();
+
+            D3D11_MAPPED_SUBRESOURCE mappedResource;
+            CHECK_HRCMD(context->Map(get(m_stagingTexture), 0, D3D11_MAP_READ, 0, &mappedResource));
+            rowPitch = mappedResource.RowPitch;
+            const auto data = reinterpret_cast<const uint8_t*>(mappedResource.pData);
+            pixels.assign(data, data + size_t(rowPitch) * m_info.height);
+            context->Unmap(get(m_stagingTexture), 0);
+
+            m_pending = false;
         }
 
       private:
         const std::shared_ptr<IDevice> m_device;
-        ComPtr<ID3D11Query> m_timeStampDis;
-        ComPtr<ID3D11Query> m_timeStampStart;
-        ComPtr<ID3D11Query> m_timeStampEnd;
+        const XrSwapchainCreateInfo m_info;
+        ComPtr<ID3D11Texture2D> m_stagingTexture;
+        ComPtr<ID3D11Query> m_copyDone;
 
-        // Can the timer be queried (it might still only read 0).
-        mutable bool m_valid{false};
+        bool m_pending{false};
     };
 
     // Wrap a device context.
@@ -869,8 +1118,10 @@ void main(uint3 id : SV_DispatchThreadID)
             : m_device(device), m_gpuArchitecture(GpuArchitecture::Unknown), m_configManager(configManager),
               m_allowInterceptor(!configManager->isSafeMode() &&
                                  !configManager->getValue(config::SettingDisableInterceptor)),
+              m_usePrecompiledShaders(!configManager->isDeveloper()),
               m_lateInitCountdown(enableOculusQuirk ? 10 : 0) {
             m_device->GetImmediateContext(set(m_context));
+            initializeContextState();
             {
                 ComPtr<IDXGIDevice> dxgiDevice;
                 DXGI_ADAPTER_DESC desc;
@@ -924,6 +1175,12 @@ void main(uint3 id : SV_DispatchThreadID)
 
             m_meshModelBuffer.reset();
             m_meshViewProjectionBuffer.reset();
+
+            clearEventsCache();
+            {
+                std::unique_lock lock(m_deferredReleasesLock);
+                m_deferredReleases.clear();
+            }
         }
 
         Api getApi() const override {
@@ -970,15 +1227,40 @@ void main(uint3 id : SV_DispatchThreadID)
 
         void saveContext(bool clear) override {
             // Ensure we are not dropping an unfinished context.
-            assert(!m_state.isValid());
+            assert(!m_state.isValid() && !m_applicationContextState);
 
-            m_state.save(get(m_context));
-            if (clear) {
+            // Swapping to our own state object saves the entire application state at once.
+            if (clear && m_toolkitContextState) {
+                m_context1->SwapDeviceContextState(get(m_toolkitContextState), set(m_applicationContextState));
                 m_context->ClearState();
+                return;
+            }
+
+            const bool tracked = m_contextStateMode != ContextStateMode::Full;
+            m_state.save(get(m_context), tracked);
+            if (clear) {
+                if (!tracked) {
+                    m_context->ClearState();
+                } else {
+                    // Only clear the bindings that could prevent the toolkit from accessing the application's
+                    // resources, or that would affect our draws and are not overriden by the toolkit.
+                    m_context->OMSetRenderTargets(0, nullptr, nullptr);
+                    auto unorderedAccessViews = reinterpret_cast<ID3D11UnorderedAccessView* const*>(kClearResources);
+                    m_context->CSSetUnorderedAccessViews(0, TrackedSlotCount, unorderedAccessViews, nullptr);
+                    m_context->GSSetShader(nullptr, nullptr, 0);
+                    m_context->DSSetShader(nullptr, nullptr, 0);
+                    m_context->HSSetShader(nullptr, nullptr, 0);
+                }
             }
         }
 
         void restoreContext() override {
+            if (m_applicationContextState) {
+                m_context1->SwapDeviceContextState(get(m_applicationContextState), nullptr);
+                m_applicationContextState.Reset();
+                return;
+            }
+
             // Ensure saveContext() was called.
             assert(m_state.isValid());
 
@@ -988,7 +1270,11 @@ void main(uint3 id : SV_DispatchThreadID)
 
         void flushContext(bool blocking, bool isEndOfFrame = false) override {
             // Ensure we are not dropping an unfinished context.
-            assert(!m_state.isValid());
+            assert(!m_state.isValid() && !m_applicationContextState);
+
+            if (isEndOfFrame) {
+                markEndOfFrame();
+            }
 
             if (!blocking) {
                 m_context->Flush();
@@ -996,10 +1282,11 @@ void main(uint3 id : SV_DispatchThreadID)
                 ComPtr<ID3D11DeviceContext4> Context1;
                 CHECK_HRCMD(m_context->QueryInterface(IID_PPV_ARGS(Context1.ReleaseAndGetAddressOf())));
 
-                wil::unique_handle eventHandle;
-                *eventHandle.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
-                Context1->Flush1(D3D11_CONTEXT_TYPE_ALL, eventHandle.get());
-                WaitForSingleObject(eventHandle.get(), INFINITE);
+                if (!m_flushEvent) {
+                    *m_flushEvent.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
+                }
+                Context1->Flush1(D3D11_CONTEXT_TYPE_ALL, m_flushEvent.get());
+                WaitForSingleObject(m_flushEvent.get(), INFINITE);
             }
 
             // Workaround: the Oculus OpenXR Runtime for DX11 seems to intercept some of the D3D calls as well. It
@@ -1012,9 +1299,36 @@ void main(uint3 id : SV_DispatchThreadID)
 
             if (isEndOfFrame) {
                 m_executeDebugWorkload = true;
+
+                // Do not hold onto the application resources for longer than a frame.
+                clearEventsCache();
+
+                reclaimDeferredReleases();
             }
         }
 
+        void releaseDeferred(std::shared_ptr<void> resource) override {
+            if (!resource) {
+                return;
+            }
+
+            // The resource may be used by the commands recorded so far, which belong to the frame being recorded.
+            std::unique_lock lock(m_deferredReleasesLock);
+            m_deferredReleases.push_back(std::make_pair(m_frameSerial + 1, std::move(resource)));
+        }
+
+        uint64_t getSubmissionSerial() const override {
+            return m_frameSerial + 1;
+        }
+
+        bool isSubmissionCompleted(uint64_t serial) const override {
+            return serial <= m_completedFrameSerial;
+        }
+
+        void waitForSubmission(uint64_t serial) const override {
+            // The work of the application is executed after our work on the immediate context, it cannot overtake it.
+        }
+
         std::shared_ptr<ITexture> createTexture(const XrSwapchainCreateInfo& info,
                                                 std::string_view debugName,
                                                 int64_t overrideFormat = 0,
@@ -1121,23 +1435,11 @@ void main(uint3 id : SV_DispatchThreadID)
                                                       std::string_view debugName,
                                                       const D3D_SHADER_MACRO* defines,
                                                       std::filesystem::path includePath = "") override {
-            ComPtr<ID3DBlob> psBytes;
-            if (!includePath.empty()) {
-                utilities::shader::IncludeHeader includes({std::move(includePath)});
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(psBytes), defines, &includes, "ps_5_0");
-            } else {
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(psBytes), defines, nullptr, "ps_5_0");
-            }
-
-            ComPtr<ID3D11PixelShader> compiledShader;
-            CHECK_HRCMD(m_device->CreatePixelShader(
-                psBytes->GetBufferPointer(), psBytes->GetBufferSize(), nullptr, set(compiledShader)));
-
-            SetDebugName(get(compiledShader), debugName);
-
-            return std::make_shared<D3D11QuadShader>(shared_from_this(), get(compiledShader));
+            return std::make_shared<D3D11QuadShader>(
+                shared_from_this(),
+                utilities::shader::CompileShaderAsync(
+                    shaderFile, entryPoint, defines, includePath, "ps_5_0", m_usePrecompiledShaders),
+                debugName);
         }
 
         std::shared_ptr<IComputeShader> createComputeShader(const std::filesystem::path& shaderFile,
@@ -1146,27 +1448,62 @@ void main(uint3 id : SV_DispatchThreadID)
                                                             const std::array<unsigned int, 3>& threadGroups,
                                                             const D3D_SHADER_MACRO* defines,
                                                             std::filesystem::path includePath = "") override {
-            ComPtr<ID3DBlob> csBytes;
-            if (!includePath.empty()) {
-                utilities::shader::IncludeHeader includes({std::move(includePath)});
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(csBytes), defines, &includes, "cs_5_0");
-            } else {
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(csBytes), defines, nullptr, "cs_5_0");
-            }
+            return std::make_shared<D3D11ComputeShader>(
+                shared_from_this(),
+                utilities::shader::CompileShaderAsync(
+                    shaderFile, entryPoint, defines, includePath, "cs_5_0", m_usePrecompiledShaders),
+                debugName,
+                threadGroups);
+        }
 
-            ComPtr<ID3D11ComputeShader> compiledShader;
-            CHECK_HRCMD(m_device->CreateComputeShader(
-                csBytes->GetBufferPointer(), csBytes->GetBufferSize(), nullptr, set(compiledShader)));
+        std::shared_ptr<IGpuTimer> createTimer() override {
+            assert(m_nextGpuTimerIndex < MaxGpuTimers);
+            const UINT index = m_nextGpuTimerIndex++;
 
-            SetDebugName(get(compiledShader), debugName);
+            D3D11_QUERY_DESC queryDesc;
+            ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
+            queryDesc.Query = D3D11_QUERY_TIMESTAMP;
+            CHECK_HRCMD(m_device->CreateQuery(&queryDesc, set(m_timestampQueries[index * 2])));
+            CHECK_HRCMD(m_device->CreateQuery(&queryDesc, set(m_timestampQueries[index * 2 + 1])));
 
-            return std::make_shared<D3D11ComputeShader>(shared_from_this(), get(compiledShader), threadGroups);
+            return std::make_shared<D3D11GpuTimer>(
+                shared_from_this(),
+                get(m_timestampQueries[index * 2]),
+                get(m_timestampQueries[index * 2 + 1]),
+                [&]() { return beginTimestampInterval(); },
+                [&](UINT timerIndex, uint64_t startSerial) { return endTimestampInterval(timerIndex, startSerial); },
+                [&]() { return m_completedTimestampIntervalSerial; },
+                [&](UINT timerIndex) { return m_gpuTimerDurations[timerIndex]; },
+                index);
         }
 
-        std::shared_ptr<IGpuTimer> createTimer() override {
-            return std::make_shared<D3D11GpuTimer>(shared_from_this());
+        void beginProfileScope(std::string_view name) override {
+            // The markers are only useful (and only converted) while a graphics debugger is attached.
+            ComPtr<ID3DUserDefinedAnnotation> annotation;
+            if (SUCCEEDED(m_context->QueryInterface(set(annotation))) && annotation->GetStatus()) {
+                annotation->BeginEvent(std::wstring(name.begin(), name.end()).c_str());
+            }
+            if (auto profiler = m_profiler.lock()) {
+                profiler->beginScope(name);
+            }
+        }
+
+        void endProfileScope() override {
+            if (auto profiler = m_profiler.lock()) {
+                profiler->endScope();
+            }
+            ComPtr<ID3DUserDefinedAnnotation> annotation;
+            if (SUCCEEDED(m_context->QueryInterface(set(annotation))) && annotation->GetStatus()) {
+                annotation->EndEvent();
+            }
+        }
+
+        void setProfiler(std::shared_ptr<IGpuProfiler> profiler) override {
+            m_profiler = profiler;
+        }
+
+        std::shared_ptr<ITextureReadback> createTextureReadback(const XrSwapchainCreateInfo& info) override {
+            return std::make_shared<D3D11TextureReadback>(shared_from_this(), info);
         }
 
         void setShader(std::shared_ptr<IQuadShader> shader, SamplerType sampler) override {
@@ -1232,13 +1569,16 @@ void main(uint3 id : SV_DispatchThreadID)
             }
         }
 
-        void setShaderOutput(uint32_t slot, std::shared_ptr<ITexture> output, int32_t slice) override {
+        void setShaderOutput(uint32_t slot,
+                             std::shared_ptr<ITexture> output,
+                             int32_t slice,
+                             const XrRect2Di* viewport) override {
             if (m_currentQuadShader) {
                 if (slot) {
                     throw std::runtime_error("Only use slot 0 for IQuadShader");
                 }
 
-                setRenderTargets(1, &output, &slice);
+                setRenderTargets(1, &output, &slice, viewport);
 
                 m_context->RSSetState(output->getInfo().sampleCount > 1 ? get(m_quadRasterizerMSAA)
                                                                         : get(m_quadRasterizer));
@@ -1326,9 +1666,14 @@ void main(uint3 id : SV_DispatchThreadID)
 
             m_context->OMSetRenderTargets(static_cast<UINT>(numRenderTargets), rtvs, pDepthStencilView);
 
-            if (numRenderTargets) {
-                m_currentDrawRenderTarget = renderTargets[0];
-                m_currentDrawRenderTargetSlice = renderSlices ? renderSlices[0] : -1;
+            // A depth buffer alone is used for the viewport (depth-only pass).
+            if (numRenderTargets || depthBuffer) {
+                const auto& viewportTarget = numRenderTargets ? renderTargets[0] : depthBuffer;
+                const auto viewportWidth = viewportTarget->getInfo().width;
+                const auto viewportHeight = viewportTarget->getInfo().height;
+
+                m_currentDrawRenderTarget = numRenderTargets ? renderTargets[0] : nullptr;
+                m_currentDrawRenderTargetSlice = renderSlices && numRenderTargets ? renderSlices[0] : -1;
                 m_currentDrawDepthBuffer = std::move(depthBuffer);
                 m_currentDrawDepthBufferSlice = depthSlice;
 
@@ -1344,10 +1689,10 @@ void main(uint3 id : SV_DispatchThreadID)
                     m_currentDrawRenderTargetViewport.offset = {0, 0};
                     viewport.TopLeftX = 0.0f;
                     viewport.TopLeftY = 0.0f;
-                    m_currentDrawRenderTargetViewport.extent.width = m_currentDrawRenderTarget->getInfo().width;
-                    viewport.Width = (float)m_currentDrawRenderTarget->getInfo().width;
-                    m_currentDrawRenderTargetViewport.extent.height = m_currentDrawRenderTarget->getInfo().height;
-                    viewport.Height = (float)m_currentDrawRenderTarget->getInfo().height;
+                    m_currentDrawRenderTargetViewport.extent.width = viewportWidth;
+                    viewport.Width = (float)viewportWidth;
+                    m_currentDrawRenderTargetViewport.extent.height = viewportHeight;
+                    viewport.Height = (float)viewportHeight;
                 }
                 viewport.MaxDepth = 1.0f;
                 m_context->RSSetViewports(1, &viewport);
@@ -1443,6 +1788,63 @@ void main(uint3 id : SV_DispatchThreadID)
             }
         }
 
+        void drawInstanced(std::shared_ptr<ISimpleMesh> mesh,
+                           const std::vector<SimpleMeshInstance>& instances,
+                           bool noCulling) override {
+            auto meshData = mesh->getAs<D3D11>();
+            if (!meshData || instances.empty()) {
+                return;
+            }
+
+            // The model matrices are streamed through a dynamic vertex buffer, grown as needed.
+            if (instances.size() > m_meshInstanceBufferCapacity) {
+                m_meshInstanceBufferCapacity = std::max(instances.size(), 2 * m_meshInstanceBufferCapacity);
+
+                D3D11_BUFFER_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.ByteWidth = (UINT)(m_meshInstanceBufferCapacity * sizeof(MeshInstance));
+                desc.Usage = D3D11_USAGE_DYNAMIC;
+                desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+                desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+                CHECK_HRCMD(m_device->CreateBuffer(&desc, nullptr, set(m_meshInstanceBuffer)));
+
+                SetDebugName(get(m_meshInstanceBuffer), "SimpleMesh Instances VB");
+            }
+            {
+                D3D11_MAPPED_SUBRESOURCE mappedResources;
+                CHECK_HRCMD(m_context->Map(get(m_meshInstanceBuffer), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResources));
+                auto meshInstances = reinterpret_cast<MeshInstance*>(mappedResources.pData);
+                for (size_t i = 0; i < instances.size(); i++) {
+                    const auto& instance = instances[i];
+                    const DirectX::XMMATRIX scaleMatrix =
+                        DirectX::XMMatrixScaling(instance.scaling.x, instance.scaling.y, instance.scaling.z);
+                    DirectX::XMStoreFloat4x4(&meshInstances[i].Model,
+                                             scaleMatrix * xr::math::LoadXrPose(instance.pose));
+                }
+                m_context->Unmap(get(m_meshInstanceBuffer), 0);
+            }
+
+            ID3D11Buffer* const constantBuffers[] = {m_meshViewProjectionBuffer->getAs<D3D11>()};
+            m_context->VSSetConstantBuffers(1, ARRAYSIZE(constantBuffers), constantBuffers);
+            m_context->VSSetShader(get(m_meshInstancedVertexShader), nullptr, 0);
+            m_context->PSSetShader(get(m_meshPixelShader), nullptr, 0);
+            m_context->GSSetShader(nullptr, nullptr, 0);
+
+            const UINT strides[] = {meshData->stride, sizeof(MeshInstance)};
+            const UINT offsets[] = {0, 0};
+            ID3D11Buffer* const vertexBuffers[] = {meshData->vertexBuffer, get(m_meshInstanceBuffer)};
+            m_context->IASetVertexBuffers(0, ARRAYSIZE(vertexBuffers), vertexBuffers, strides, offsets);
+            m_context->IASetIndexBuffer(meshData->indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+            m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            m_context->IASetInputLayout(get(m_meshInstancedInputLayout));
+            m_context->RSSetState(noCulling ? m_meshNoCullingRasterizer.Get() : nullptr);
+
+            m_context->DrawIndexedInstanced(meshData->numIndices, (UINT)instances.size(), 0, 0, 0);
+
+            // The mesh pipeline state must be restored on the next draw().
+            m_currentMesh.reset();
+        }
+
         float drawString(std::wstring_view string,
                          TextStyle style,
                          float size,
@@ -1502,21 +1904,77 @@ void main(uint3 id : SV_DispatchThreadID)
         }
 
         void flushText() override {
+            beginProfileScope("Text");
             m_fontNormal->Flush(get(m_context));
             m_fontBold->Flush(get(m_context));
+            endProfileScope();
             m_context->Flush();
         }
 
         void setMipMapBias(config::MipMapBias biasing, float bias = 0.f) override {
+            std::unique_lock lock(m_biasedSamplersLock);
+
+            // The replacement samplers are only valid for one biasing mode and value.
+            if (biasing != m_mipMapBiasingType || bias != m_mipMapBias) {
+                m_biasedSamplers.clear();
+            }
             m_mipMapBiasingType = biasing;
             m_mipMapBias = bias;
         }
 
-        uint32_t getNumBiasedSamplersThisFrame() const override {
+        uint32_t getNumBiasedSamplersThisFrame(uint32_t& numCreated) const override {
+            numCreated = std::exchange(m_numBiasedSamplersCreatedThisFrame, 0);
             return std::exchange(m_numBiasedSamplersThisFrame, 0);
         }
 
         void resolveQueries() override {
+            // Collect the timers of all the disjoint intervals that the GPU has completed, oldest first. This only
+            // needs one disjoint query per interval, and is all done without flushing.
+            const auto lastClosedSerial = m_timestampIntervalSerial - (m_isTimestampIntervalOpen ? 1 : 0);
+            while (m_completedTimestampIntervalSerial < lastClosedSerial) {
+                const auto serial = m_completedTimestampIntervalSerial + 1;
+                auto& interval = m_timestampIntervals[serial % NumTimestampIntervals];
+
+                D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjointData{};
+                if (m_context->GetData(get(interval.disjointQuery),
+                                       &disjointData,
+                                       sizeof(disjointData),
+                                       D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+                    break;
+                }
+                if (disjointData.Disjoint) {
+                    m_lastDisjointTimestampIntervalSerial = serial;
+                }
+
+                for (const auto& [index, startSerial] : interval.timers) {
+                    uint64_t duration = 0;
+                    UINT64 startTime = 0, stopTime = 0;
+                    if (m_lastDisjointTimestampIntervalSerial < startSerial &&
+                        m_context->GetData(get(m_timestampQueries[index * 2]),
+                                           &startTime,
+                                           sizeof(startTime),
+                                           D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK &&
+                        m_context->GetData(get(m_timestampQueries[index * 2 + 1]),
+                                           &stopTime,
+                                           sizeof(stopTime),
+                                           D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK) {
+                        duration = static_cast<uint64_t>(((stopTime - startTime) * 1e6) / disjointData.Frequency);
+                    }
+                    m_gpuTimerDurations[index] = duration;
+                }
+                interval.timers.clear();
+
+                m_completedTimestampIntervalSerial = serial;
+            }
+
+            // Close the current interval, unless the GPU is still using the slot of the next one (in which case the
+            // current interval will be extended into the next frame).
+            if (m_isTimestampIntervalOpen &&
+                m_timestampIntervalSerial + 1 <= m_completedTimestampIntervalSerial + NumTimestampIntervals) {
+                auto& interval = m_timestampIntervals[m_timestampIntervalSerial % NumTimestampIntervals];
+                m_context->End(get(interval.disjointQuery));
+                m_isTimestampIntervalOpen = false;
+            }
         }
 
         void blockCallbacks() override {
@@ -1539,10 +1997,36 @@ void main(uint3 id : SV_DispatchThreadID)
             m_copyTextureEvent = event;
         }
 
+        void registerClearDepthEvent(ClearDepthEvent event) override {
+            m_clearDepthEvent = event;
+        }
+
+        void setEventsFilter(const EventsFilter& filter) override {
+            m_eventsFilter = filter;
+        }
+
+        // The hooks are attached for the whole session: detaching one would reset its original function pointer
+        // while an application thread may still be calling through it. Without a subscription, a hook only forwards
+        // the call to the runtime (see isInterceptedCallSubscribed()).
+        void subscribeInterceptedCall(InterceptedCall call) override {
+            m_interceptedCallSubscriptions[to_integral(call)]++;
+        }
+
+        void unsubscribeInterceptedCall(InterceptedCall call) override {
+            auto& subscriptions = m_interceptedCallSubscriptions[to_integral(call)];
+            if (subscriptions) {
+                subscriptions--;
+            }
+        }
+
         void getVRAMUsage(uint64_t& usage, uint8_t& percentUsed) const {
             utilities::GetVRAMUsage(m_adapter, usage, percentUsed);
         }
 
+        ComPtr<IDXGIAdapter> getAdapter() const override {
+            return m_adapter;
+        }
+
         bool isEventsSupported() const override {
             return m_allowInterceptor;
         }
@@ -1572,8 +2056,8 @@ void main(uint3 id : SV_DispatchThreadID)
                 m_debugWorkloadParams = createBuffer(16, "DebugWorkloadParams", nullptr, false);
             }
 
-            const int cpuLoad = m_configManager->getValue("debug_cpu_load");
-            const int gpuLoad = m_configManager->getValue("debug_gpu_load");
+            const int cpuLoad = m_configManager->getValue(config::SettingDebugCpuLoad);
+            const int gpuLoad = m_configManager->getValue(config::SettingDebugGpuLoad);
 
             if (gpuLoad) {
                 uint32_t param = gpuLoad * 5000;
@@ -1603,69 +2087,171 @@ void main(uint3 id : SV_DispatchThreadID)
 
             g_instance = this;
 
-            // Hook to the Direct3D device context to intercept preparation for the rendering.
-            DetourMethodAttach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               33,
-                               hooked_ID3D11DeviceContext_OMSetRenderTargets,
-                               g_original_ID3D11DeviceContext_OMSetRenderTargets);
-            DetourMethodAttach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               34,
-                               hooked_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews,
-                               g_original_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews);
-            DetourMethodAttach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               44,
-                               hooked_ID3D11DeviceContext_RSSetViewports,
-                               g_original_ID3D11DeviceContext_RSSetViewports);
-            DetourMethodAttach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               47,
-                               hooked_ID3D11DeviceContext_CopyResource,
-                               g_original_ID3D11DeviceContext_CopyResource);
-            DetourMethodAttach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               46,
-                               hooked_ID3D11DeviceContext_CopySubresourceRegion,
-                               g_original_ID3D11DeviceContext_CopySubresourceRegion);
-            DetourMethodAttach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               10,
-                               hooked_ID3D11DeviceContext_PSSetSamplers,
-                               g_original_ID3D11DeviceContext_PSSetSamplers);
+            for (uint32_t i = 0; i < to_integral(InterceptedCall::MaxValue); i++) {
+                attachInterceptedCall((InterceptedCall)i);
+            }
         }
 
         void uninitializeInterceptor() {
-            DetourMethodDetach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               33,
-                               hooked_ID3D11DeviceContext_OMSetRenderTargets,
-                               g_original_ID3D11DeviceContext_OMSetRenderTargets);
-            DetourMethodDetach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               34,
-                               hooked_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews,
-                               g_original_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews);
-            DetourMethodDetach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               47,
-                               hooked_ID3D11DeviceContext_CopyResource,
-                               g_original_ID3D11DeviceContext_CopyResource);
-            DetourMethodDetach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               46,
-                               hooked_ID3D11DeviceContext_CopySubresourceRegion,
-                               g_original_ID3D11DeviceContext_CopySubresourceRegion);
-            DetourMethodDetach(get(m_context),
-                               // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
-                               10,
-                               hooked_ID3D11DeviceContext_PSSetSamplers,
-                               g_original_ID3D11DeviceContext_PSSetSamplers);
+            for (uint32_t i = 0; i < to_integral(InterceptedCall::MaxValue); i++) {
+                detachInterceptedCall((InterceptedCall)i);
+            }
 
             g_instance = nullptr;
         }
 
+        // Called from the hooks, on any application thread.
+        bool isInterceptedCallSubscribed(InterceptedCall call) const {
+            return m_interceptedCallSubscriptions[to_integral(call)].load(std::memory_order_relaxed) != 0;
+        }
+
+        // Hook to the Direct3D device context to intercept preparation for the rendering.
+        void attachInterceptedCall(InterceptedCall call) {
+            TraceLoggingWrite(g_traceProvider, "AttachInterceptedCall", TLArg((uint32_t)call, "Call"));
+
+            switch (call) {
+            case InterceptedCall::SetRenderTargets:
+                DetourMethodAttach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   33,
+                                   hooked_ID3D11DeviceContext_OMSetRenderTargets,
+                                   g_original_ID3D11DeviceContext_OMSetRenderTargets);
+                DetourMethodAttach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   34,
+                                   hooked_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews,
+                                   g_original_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews);
+                // The viewports are only traced.
+                if (IsTraceKeywordEnabled(TLK_GraphicsHooks)) {
+                    DetourMethodAttach(get(m_context),
+                                       // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                       44,
+                                       hooked_ID3D11DeviceContext_RSSetViewports,
+                                       g_original_ID3D11DeviceContext_RSSetViewports);
+                }
+                break;
+
+            case InterceptedCall::CopyTexture:
+                DetourMethodAttach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   47,
+                                   hooked_ID3D11DeviceContext_CopyResource,
+                                   g_original_ID3D11DeviceContext_CopyResource);
+                DetourMethodAttach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   46,
+                                   hooked_ID3D11DeviceContext_CopySubresourceRegion,
+                                   g_original_ID3D11DeviceContext_CopySubresourceRegion);
+                break;
+
+            case InterceptedCall::SetSamplers:
+                DetourMethodAttach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   10,
+                                   hooked_ID3D11DeviceContext_PSSetSamplers,
+                                   g_original_ID3D11DeviceContext_PSSetSamplers);
+                break;
+
+            case InterceptedCall::ClearDepth:
+                DetourMethodAttach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   53,
+                                   hooked_ID3D11DeviceContext_ClearDepthStencilView,
+                                   g_original_ID3D11DeviceContext_ClearDepthStencilView);
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        void detachInterceptedCall(InterceptedCall call) {
+            TraceLoggingWrite(g_traceProvider, "DetachInterceptedCall", TLArg((uint32_t)call, "Call"));
+
+            switch (call) {
+            case InterceptedCall::SetRenderTargets:
+                DetourMethodDetach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   33,
+                                   hooked_ID3D11DeviceContext_OMSetRenderTargets,
+                                   g_original_ID3D11DeviceContext_OMSetRenderTargets);
+                DetourMethodDetach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   34,
+                                   hooked_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews,
+                                   g_original_ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews);
+                DetourMethodDetach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   44,
+                                   hooked_ID3D11DeviceContext_RSSetViewports,
+                                   g_original_ID3D11DeviceContext_RSSetViewports);
+                break;
+
+            case InterceptedCall::CopyTexture:
+                DetourMethodDetach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   47,
+                                   hooked_ID3D11DeviceContext_CopyResource,
+                                   g_original_ID3D11DeviceContext_CopyResource);
+                DetourMethodDetach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   46,
+                                   hooked_ID3D11DeviceContext_CopySubresourceRegion,
+                                   g_original_ID3D11DeviceContext_CopySubresourceRegion);
+                break;
+
+            case InterceptedCall::SetSamplers:
+                DetourMethodDetach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   10,
+                                   hooked_ID3D11DeviceContext_PSSetSamplers,
+                                   g_original_ID3D11DeviceContext_PSSetSamplers);
+                break;
+
+            case InterceptedCall::ClearDepth:
+                DetourMethodDetach(get(m_context),
+                                   // Method offset is 7 + method index (0-based) for ID3D11DeviceContext.
+                                   53,
+                                   hooked_ID3D11DeviceContext_ClearDepthStencilView,
+                                   g_original_ID3D11DeviceContext_ClearDepthStencilView);
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        void initializeContextState() {
+            m_contextStateMode = (ContextStateMode)std::clamp(
+                m_configManager->getValue(config::SettingD3D11ContextState), 0, (int)ContextStateMode::Swap);
+            if (m_contextStateMode != ContextStateMode::Swap) {
+                return;
+            }
+
+            // The state object requires the Direct3D 11.1 interfaces. Otherwise, we fall back to the tracked state.
+            ComPtr<ID3D11Device1> device1;
+            if (FAILED(m_device->QueryInterface(set(device1))) || FAILED(m_context->QueryInterface(set(m_context1)))) {
+                Log("Device context state is not supported\n");
+                m_contextStateMode = ContextStateMode::Tracked;
+                return;
+            }
+
+            const D3D_FEATURE_LEVEL featureLevel = m_device->GetFeatureLevel();
+            const UINT flags = (m_device->GetCreationFlags() & D3D11_CREATE_DEVICE_SINGLETHREADED)
+                                   ? D3D11_1_CREATE_DEVICE_CONTEXT_STATE_SINGLETHREADED
+                                   : 0;
+            if (FAILED(device1->CreateDeviceContextState(flags,
+                                                         &featureLevel,
+                                                         1,
+                                                         D3D11_SDK_VERSION,
+                                                         __uuidof(ID3D11Device1),
+                                                         nullptr,
+                                                         set(m_toolkitContextState)))) {
+                Log("Failed to create device context state\n");
+                m_contextStateMode = ContextStateMode::Tracked;
+            }
+        }
+
         // Initialize the resources needed for dispatchShader() and related calls.
         void initializeShadingResources() {
             {
@@ -1700,7 +2286,8 @@ void main(uint3 id : SV_DispatchThreadID)
             }
             {
                 ComPtr<ID3DBlob> vsBytes;
-                toolkit::utilities::shader::CompileShader(QuadVertexShader, "vsMain", set(vsBytes), "vs_5_0");
+                toolkit::utilities::shader::CompileBuiltInShader(
+                    "QuadVertexShader", QuadVertexShader, "vsMain", set(vsBytes), "vs_5_0");
 
                 CHECK_HRCMD(m_device->CreateVertexShader(
                     vsBytes->GetBufferPointer(), vsBytes->GetBufferSize(), nullptr, set(m_quadVertexShader)));
@@ -1713,7 +2300,8 @@ void main(uint3 id : SV_DispatchThreadID)
         void initializeMeshResources() {
             {
                 ComPtr<ID3DBlob> vsBytes;
-                toolkit::utilities::shader::CompileShader(MeshShaders, "vsMain", set(vsBytes), "vs_5_0");
+                toolkit::utilities::shader::CompileBuiltInShader(
+                    "MeshShaders", MeshShaders, "vsMain", set(vsBytes), "vs_5_0");
 
                 CHECK_HRCMD(m_device->CreateVertexShader(
                     vsBytes->GetBufferPointer(), vsBytes->GetBufferSize(), nullptr, set(m_meshVertexShader)));
@@ -1744,25 +2332,34 @@ void main(uint3 id : SV_DispatchThreadID)
                                                         set(m_meshInputLayout)));
             }
             {
-                ComPtr<ID3DBlob> errors;
+                ComPtr<ID3DBlob> vsBytes;
+                toolkit::utilities::shader::CompileBuiltInShader(
+                    "MeshShaders", MeshShaders, "vsMainInstanced", set(vsBytes), "vs_5_0");
+
+                CHECK_HRCMD(m_device->CreateVertexShader(
+                    vsBytes->GetBufferPointer(), vsBytes->GetBufferSize(), nullptr, set(m_meshInstancedVertexShader)));
+
+                SetDebugName(get(m_meshInstancedVertexShader), "SimpleMesh Instanced VS");
+
+                const D3D11_INPUT_ELEMENT_DESC vertexDesc[] = {
+                    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"MODEL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                    {"MODEL", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                    {"MODEL", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                    {"MODEL", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                };
+
+                CHECK_HRCMD(m_device->CreateInputLayout(vertexDesc,
+                                                        ARRAYSIZE(vertexDesc),
+                                                        vsBytes->GetBufferPointer(),
+                                                        vsBytes->GetBufferSize(),
+                                                        set(m_meshInstancedInputLayout)));
+            }
+            {
                 ComPtr<ID3DBlob> psBytes;
-                HRESULT hr = D3DCompile(MeshShaders.data(),
-                                        MeshShaders.length(),
-                                        nullptr,
-                                        nullptr,
-                                        nullptr,
-                                        "psMain",
-                                        "ps_5_0",
-                                        D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS,
-                                        0,
-                                        set(psBytes),
-                                        set(errors));
-                if (FAILED(hr)) {
-                    if (errors) {
-                        Log("%s", (char*)errors->GetBufferPointer());
-                    }
-                    CHECK_HRESULT(hr, "Failed to compile shader");
-                }
+                toolkit::utilities::shader::CompileBuiltInShader(
+                    "MeshShaders", MeshShaders, "psMain", set(psBytes), "ps_5_0");
                 CHECK_HRCMD(m_device->CreatePixelShader(
                     psBytes->GetBufferPointer(), psBytes->GetBufferSize(), nullptr, set(m_meshPixelShader)));
 
@@ -1788,7 +2385,8 @@ void main(uint3 id : SV_DispatchThreadID)
         // Initialize the resources needed for debugging.
         void initializeDebugResources() {
             ComPtr<ID3DBlob> csBytes;
-            toolkit::utilities::shader::CompileShader(DebugWorkloadShader, "main", set(csBytes), "cs_5_0");
+            toolkit::utilities::shader::CompileBuiltInShader(
+                "DebugWorkloadShader", DebugWorkloadShader, "main", set(csBytes), "cs_5_0");
 
             CHECK_HRCMD(m_device->CreateComputeShader(
                 csBytes->GetBufferPointer(), csBytes->GetBufferSize(), nullptr, set(m_debugWorkloadShader)));
@@ -1837,45 +2435,26 @@ void main(uint3 id : SV_DispatchThreadID)
                 return;
             }
 
-            ComPtr<ID3D11Device> device;
-            context->GetDevice(set(device));
-            if (device != m_device) {
-                return;
-            }
-
-            auto wrappedContext = std::make_shared<D3D11Context>(shared_from_this(), context);
-
-            if (!numViews || !renderTargetViews || !renderTargetViews[0]) {
-                INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
-                return;
-            }
-
+            std::shared_ptr<D3D11Context> wrappedContext;
+            std::shared_ptr<D3D11Texture> renderTarget;
             {
-                D3D11_RENDER_TARGET_VIEW_DESC desc;
-                renderTargetViews[0]->GetDesc(&desc);
-                if (desc.ViewDimension != D3D11_RTV_DIMENSION_TEXTURE2D &&
-                    desc.ViewDimension != D3D11_RTV_DIMENSION_TEXTURE2DMS &&
-                    desc.ViewDimension != D3D11_RTV_DIMENSION_TEXTURE2DARRAY &&
-                    desc.ViewDimension != D3D11_RTV_DIMENSION_TEXTURE2DMSARRAY) {
-                    INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
+                std::unique_lock lock(m_eventsCacheLock);
+
+                wrappedContext = getEventsContext(context);
+                if (!wrappedContext) {
                     return;
                 }
-            }
 
-            ComPtr<ID3D11Resource> resource;
-            renderTargetViews[0]->GetResource(set(resource));
+                if (numViews && renderTargetViews && renderTargetViews[0]) {
+                    renderTarget = getEventsRenderTarget(renderTargetViews[0]);
+                }
+            }
 
-            ComPtr<ID3D11Texture2D> texture;
-            if (FAILED(resource->QueryInterface(set(texture)))) {
+            if (!renderTarget) {
                 INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
                 return;
             }
 
-            D3D11_TEXTURE2D_DESC textureDesc;
-            texture->GetDesc(&textureDesc);
-
-            auto renderTarget = std::make_shared<D3D11Texture>(
-                shared_from_this(), getTextureInfo(textureDesc), textureDesc, get(texture));
             INVOKE_EVENT(setRenderTargetEvent, wrappedContext, renderTarget);
         }
 
@@ -1888,104 +2467,265 @@ void main(uint3 id : SV_DispatchThreadID)
                 return;
             }
 
-            ComPtr<ID3D11Device> device;
-            context->GetDevice(set(device));
-            if (device != m_device) {
-                return;
+            std::shared_ptr<D3D11Context> wrappedContext;
+            std::shared_ptr<D3D11Texture> source;
+            std::shared_ptr<D3D11Texture> destination;
+            {
+                std::unique_lock lock(m_eventsCacheLock);
+
+                wrappedContext = getEventsContext(context);
+                if (!wrappedContext) {
+                    return;
+                }
+
+                destination = getEventsTexture(pDstResource, true /* filter */);
+                if (!destination) {
+                    return;
+                }
+
+                source = getEventsTexture(pSrcResource, false /* filter */);
+                if (!source) {
+                    return;
+                }
             }
 
-            ComPtr<ID3D11Texture2D> sourceTexture;
-            if (FAILED(pSrcResource->QueryInterface(set(sourceTexture)))) {
+            INVOKE_EVENT(copyTextureEvent, wrappedContext, source, destination, SrcSubresource, DstSubresource);
+        }
+
+        void onClearDepthStencilView(ID3D11DeviceContext* context,
+                                     ID3D11DepthStencilView* depthStencilView,
+                                     UINT clearFlags,
+                                     FLOAT depth) {
+            if (m_blockEvents || !m_clearDepthEvent || !depthStencilView || !(clearFlags & D3D11_CLEAR_DEPTH)) {
                 return;
             }
 
-            ComPtr<ID3D11Texture2D> destinationTexture;
-            if (FAILED(pDstResource->QueryInterface(set(destinationTexture)))) {
+            D3D11_DEPTH_STENCIL_VIEW_DESC desc;
+            depthStencilView->GetDesc(&desc);
+            int32_t slice = -1;
+            if (desc.ViewDimension == D3D11_DSV_DIMENSION_TEXTURE2DARRAY) {
+                if (desc.Texture2DArray.ArraySize == 1) {
+                    slice = desc.Texture2DArray.FirstArraySlice;
+                }
+            } else if (desc.ViewDimension != D3D11_DSV_DIMENSION_TEXTURE2D) {
                 return;
             }
 
-            auto wrappedContext = std::make_shared<D3D11Context>(shared_from_this(), context);
+            std::shared_ptr<D3D11Context> wrappedContext;
+            std::shared_ptr<D3D11Texture> depthBuffer;
+            {
+                std::unique_lock lock(m_eventsCacheLock);
 
-            D3D11_TEXTURE2D_DESC sourceTextureDesc;
-            sourceTexture->GetDesc(&sourceTextureDesc);
+                wrappedContext = getEventsContext(context);
+                if (!wrappedContext) {
+                    return;
+                }
 
-            auto source = std::make_shared<D3D11Texture>(
-                shared_from_this(), getTextureInfo(sourceTextureDesc), sourceTextureDesc, get(sourceTexture));
+                ComPtr<ID3D11Resource> resource;
+                depthStencilView->GetResource(set(resource));
+                depthBuffer = getEventsTexture(get(resource), true /* filter */);
+                if (!depthBuffer) {
+                    return;
+                }
+            }
 
-            D3D11_TEXTURE2D_DESC destinationTextureDesc;
-            destinationTexture->GetDesc(&destinationTextureDesc);
+            INVOKE_EVENT(clearDepthEvent, wrappedContext, depthBuffer, slice, depth);
+        }
 
-            auto destination = std::make_shared<D3D11Texture>(shared_from_this(),
-                                                              getTextureInfo(destinationTextureDesc),
-                                                              destinationTextureDesc,
-                                                              get(destinationTexture));
+#undef INVOKE_EVENT
 
-            INVOKE_EVENT(copyTextureEvent, wrappedContext, source, destination, SrcSubresource, DstSubresource);
+        // The wrappers below are cached for the duration of the frame, since the events are invoked up to thousands of
+        // times per frame with the same objects. The cache holds a reference to the native objects, which guarantees
+        // that their address is not reused while in the cache. Must be called with m_eventsCacheLock held.
+
+        // Returns null for a context of a different device.
+        std::shared_ptr<D3D11Context> getEventsContext(ID3D11DeviceContext* context) {
+            auto it = m_eventsContexts.find(context);
+            if (it != m_eventsContexts.end()) {
+                return it->second.second;
+            }
+
+            ComPtr<ID3D11Device> device;
+            context->GetDevice(set(device));
+            std::shared_ptr<D3D11Context> wrappedContext;
+            if (device == m_device) {
+                wrappedContext = std::make_shared<D3D11Context>(shared_from_this(), context);
+            }
+            m_eventsContexts.insert_or_assign(context, std::make_pair(context, wrappedContext));
+
+            return wrappedContext;
         }
 
-#undef INVOKE_EVENT
+        // Returns null for a render target that is not a 2D texture or that does not pass the filter.
+        std::shared_ptr<D3D11Texture> getEventsRenderTarget(ID3D11RenderTargetView* renderTargetView) {
+            auto it = m_eventsRenderTargets.find(renderTargetView);
+            if (it != m_eventsRenderTargets.end()) {
+                return it->second.second;
+            }
+
+            std::shared_ptr<D3D11Texture> renderTarget;
+            D3D11_RENDER_TARGET_VIEW_DESC desc;
+            renderTargetView->GetDesc(&desc);
+            if (desc.ViewDimension == D3D11_RTV_DIMENSION_TEXTURE2D ||
+                desc.ViewDimension == D3D11_RTV_DIMENSION_TEXTURE2DMS ||
+                desc.ViewDimension == D3D11_RTV_DIMENSION_TEXTURE2DARRAY ||
+                desc.ViewDimension == D3D11_RTV_DIMENSION_TEXTURE2DMSARRAY) {
+                ComPtr<ID3D11Resource> resource;
+                renderTargetView->GetResource(set(resource));
+                renderTarget = getEventsTexture(get(resource), true /* filter */);
+            }
+            m_eventsRenderTargets.insert_or_assign(renderTargetView, std::make_pair(renderTargetView, renderTarget));
+
+            return renderTarget;
+        }
+
+        // Returns null for a resource that is not a 2D texture, or that does not pass the filter when requested.
+        std::shared_ptr<D3D11Texture> getEventsTexture(ID3D11Resource* resource, bool filter) {
+            auto it = m_eventsTextures.find(resource);
+            if (it == m_eventsTextures.end()) {
+                std::shared_ptr<D3D11Texture> texture;
+                ComPtr<ID3D11Texture2D> texture2D;
+                if (SUCCEEDED(resource->QueryInterface(set(texture2D)))) {
+                    D3D11_TEXTURE2D_DESC textureDesc;
+                    texture2D->GetDesc(&textureDesc);
+                    texture = std::make_shared<D3D11Texture>(
+                        shared_from_this(), getTextureInfo(textureDesc), textureDesc, get(texture2D));
+                }
+                it = m_eventsTextures.insert_or_assign(resource, std::make_pair(resource, texture)).first;
+            }
+
+            const auto& texture = it->second.second;
+            if (!texture || (filter && !isEventsTextureOfInterest(texture->getInfo()))) {
+                return nullptr;
+            }
+            return texture;
+        }
+
+        bool isEventsTextureOfInterest(const XrSwapchainCreateInfo& info) const {
+            return info.width >= m_eventsFilter.minWidth && info.height >= m_eventsFilter.minHeight &&
+                   info.arraySize <= m_eventsFilter.maxArraySize;
+        }
+
+        void clearEventsCache() {
+            std::unique_lock lock(m_eventsCacheLock);
+
+            m_eventsContexts.clear();
+            m_eventsRenderTargets.clear();
+            m_eventsTextures.clear();
+        }
+
+        // Insert an event query that signals the completion of the frame on the GPU.
+        void markEndOfFrame() {
+            ComPtr<ID3D11Query> query;
+            if (!m_freeFrameEndQueries.empty()) {
+                query = std::move(m_freeFrameEndQueries.back());
+                m_freeFrameEndQueries.pop_back();
+            } else {
+                D3D11_QUERY_DESC queryDesc;
+                ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
+                queryDesc.Query = D3D11_QUERY_EVENT;
+                CHECK_HRCMD(m_device->CreateQuery(&queryDesc, set(query)));
+            }
+            m_context->End(get(query));
+
+            std::unique_lock lock(m_deferredReleasesLock);
+            m_frameEndQueries.push_back(std::make_pair(++m_frameSerial, std::move(query)));
+        }
+
+        // Drop the references to the resources used by the frames that the GPU has completed.
+        void reclaimDeferredReleases() {
+            uint64_t completedFrameSerial = 0;
+            while (!m_frameEndQueries.empty() &&
+                   m_context->GetData(
+                       get(m_frameEndQueries.front().second), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK) {
+                completedFrameSerial = m_completedFrameSerial = m_frameEndQueries.front().first;
+                m_freeFrameEndQueries.push_back(std::move(m_frameEndQueries.front().second));
+                m_frameEndQueries.pop_front();
+            }
+
+            std::unique_lock lock(m_deferredReleasesLock);
+            while (!m_deferredReleases.empty() && m_deferredReleases.front().first <= completedFrameSerial) {
+                m_deferredReleases.pop_front();
+            }
+        }
+
+        // Returns the serial of the disjoint interval that the timestamps recorded now belong to.
+        uint64_t beginTimestampInterval() {
+            if (!m_isTimestampIntervalOpen) {
+                auto& interval = m_timestampIntervals[++m_timestampIntervalSerial % NumTimestampIntervals];
+                if (!interval.disjointQuery) {
+                    D3D11_QUERY_DESC queryDesc;
+                    ZeroMemory(&queryDesc, sizeof(D3D11_QUERY_DESC));
+                    queryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+                    CHECK_HRCMD(m_device->CreateQuery(&queryDesc, set(interval.disjointQuery)));
+                }
+                m_context->Begin(get(interval.disjointQuery));
+                m_isTimestampIntervalOpen = true;
+            }
+            return m_timestampIntervalSerial;
+        }
+
+        // Returns the serial of the disjoint interval after which the timer can be read back.
+        uint64_t endTimestampInterval(UINT index, uint64_t startInterval) {
+            const auto serial = beginTimestampInterval();
+            m_timestampIntervals[serial % NumTimestampIntervals].timers.push_back(std::make_pair(index, startInterval));
+            return serial;
+        }
 
         void patchSamplers(ID3D11DeviceContext* context, ID3D11SamplerState** samplers, size_t numSamplers) {
             if (m_blockEvents || m_mipMapBiasingType == config::MipMapBias::Off) {
                 return;
             }
 
-            ComPtr<ID3D11Device> device;
-            context->GetDevice(set(device));
-            if (device != m_device) {
-                return;
+            {
+                std::unique_lock lock(m_eventsCacheLock);
+
+                if (!getEventsContext(context)) {
+                    return;
+                }
             }
 
+            std::unique_lock lock(m_biasedSamplersLock);
+
             for (size_t i = 0; i < numSamplers; i++) {
                 if (!samplers[i]) {
                     continue;
                 }
 
-                bool needUpdate = false;
+                D3D11_SAMPLER_DESC desc;
+                samplers[i]->GetDesc(&desc);
+                const auto hash = BiasedSamplerCache::hash(desc);
 
-                // Retrieve any previously biased sampler.
+                // Create the biased sampler the first time the application uses this sampler description.
                 ComPtr<ID3D11SamplerState> biasedSampler;
-                UINT nDataSize = sizeof(ID3D11SamplerState*);
-                if (SUCCEEDED(
-                        samplers[i]->GetPrivateData(__uuidof(ID3D11SamplerState), &nDataSize, set(biasedSampler))) &&
-                    biasedSampler) {
-                    // Check if the sampler needs to be updated again.
-                    D3D11_SAMPLER_DESC desc;
-                    biasedSampler->GetDesc(&desc);
-                    needUpdate = std::abs(desc.MipLODBias - m_mipMapBias) > FLT_EPSILON;
-                }
-
-                bool needBiasing = biasedSampler;
-
-                // Create or update the biased sampler.
-                if (!biasedSampler || needUpdate) {
-                    D3D11_SAMPLER_DESC desc;
-                    samplers[i]->GetDesc(&desc);
-
-                    needBiasing = m_mipMapBiasingType == config::MipMapBias::All ||
-                                  (desc.Filter == D3D11_FILTER_ANISOTROPIC ||
-                                   desc.Filter == D3D11_FILTER_COMPARISON_ANISOTROPIC ||
-                                   desc.Filter == D3D11_FILTER_MINIMUM_ANISOTROPIC ||
-                                   desc.Filter == D3D11_FILTER_MAXIMUM_ANISOTROPIC);
+                if (const auto cached = m_biasedSamplers.find(desc, hash)) {
+                    biasedSampler = *cached;
+                } else {
+                    const bool needBiasing = m_mipMapBiasingType == config::MipMapBias::All ||
+                                             (desc.Filter == D3D11_FILTER_ANISOTROPIC ||
+                                              desc.Filter == D3D11_FILTER_COMPARISON_ANISOTROPIC ||
+                                              desc.Filter == D3D11_FILTER_MINIMUM_ANISOTROPIC ||
+                                              desc.Filter == D3D11_FILTER_MAXIMUM_ANISOTROPIC);
 
                     if (needBiasing) {
+                        D3D11_SAMPLER_DESC biasedDesc = desc;
+
                         // Bias the LOD.
-                        desc.MipLODBias += m_mipMapBias;
+                        biasedDesc.MipLODBias += m_mipMapBias;
 
                         // Allow negative LOD.
-                        desc.MinLOD -= std::ceilf(m_mipMapBias);
-
-                        const auto hr = m_device->CreateSamplerState(&desc, set(biasedSampler));
-                        if (SUCCEEDED(hr)) {
-                            samplers[i]->SetPrivateDataInterface(__uuidof(ID3D11SamplerState), get(biasedSampler));
-                        } else {
-                            // TODO: We ignore the error for now.
-                            needBiasing = false;
+                        biasedDesc.MinLOD -= std::ceilf(m_mipMapBias);
+
+                        // TODO: We ignore the error for now, and the sampler is left unbiased.
+                        if (SUCCEEDED(m_device->CreateSamplerState(&biasedDesc, set(biasedSampler)))) {
+                            m_numBiasedSamplersCreatedThisFrame++;
                         }
                     }
+
+                    m_biasedSamplers.insert(desc, hash, biasedSampler);
                 }
 
-                if (needBiasing) {
+                if (biasedSampler) {
                     samplers[i] = biasedSampler.Get();
                     m_numBiasedSamplersThisFrame++;
                 }
@@ -1996,13 +2736,34 @@ void main(uint3 id : SV_DispatchThreadID)
         const std::shared_ptr<config::IConfigManager> m_configManager;
         ComPtr<IDXGIAdapter> m_adapter;
         ComPtr<ID3D11DeviceContext> m_context;
+        ContextStateMode m_contextStateMode{ContextStateMode::Full};
         D3D11ContextState m_state;
+        ComPtr<ID3D11DeviceContext1> m_context1;
+        ComPtr<ID3DDeviceContextState> m_toolkitContextState;
+        ComPtr<ID3DDeviceContextState> m_applicationContextState;
         std::string m_deviceName;
         GpuArchitecture m_gpuArchitecture;
         const bool m_allowInterceptor;
+        // In developer mode, the shader files are always compiled (to allow live edits).
+        const bool m_usePrecompiledShaders;
         uint32_t m_lateInitCountdown{0};
 
         ComPtr<ID3D11SamplerState> m_samplers[2];
+
+        struct TimestampInterval {
+            ComPtr<ID3D11Query> disjointQuery;
+            std::vector<std::pair<UINT, uint64_t>> timers;
+        };
+
+        ComPtr<ID3D11Query> m_timestampQueries[MaxGpuTimers * 2];
+        uint64_t m_gpuTimerDurations[MaxGpuTimers]{};
+        UINT m_nextGpuTimerIndex{0};
+        std::weak_ptr<IGpuProfiler> m_profiler;
+        std::array<TimestampInterval, NumTimestampIntervals> m_timestampIntervals;
+        uint64_t m_timestampIntervalSerial{0};
+        bool m_isTimestampIntervalOpen{false};
+        uint64_t m_completedTimestampIntervalSerial{0};
+        uint64_t m_lastDisjointTimestampIntervalSerial{0};
         ComPtr<ID3D11RasterizerState> m_quadRasterizer;
         ComPtr<ID3D11RasterizerState> m_quadRasterizerMSAA;
         ComPtr<ID3D11VertexShader> m_quadVertexShader;
@@ -2013,6 +2774,10 @@ void main(uint3 id : SV_DispatchThreadID)
         ComPtr<ID3D11RasterizerState> m_meshNoCullingRasterizer;
         std::shared_ptr<IShaderBuffer> m_meshViewProjectionBuffer;
         std::shared_ptr<IShaderBuffer> m_meshModelBuffer;
+        ComPtr<ID3D11VertexShader> m_meshInstancedVertexShader;
+        ComPtr<ID3D11InputLayout> m_meshInstancedInputLayout;
+        ComPtr<ID3D11Buffer> m_meshInstanceBuffer;
+        size_t m_meshInstanceBufferCapacity{0};
         ComPtr<IFW1Factory> m_fontWrapperFactory;
         ComPtr<IFW1FontWrapper> m_fontNormal;
         ComPtr<IFW1FontWrapper> m_fontBold;
@@ -2028,15 +2793,39 @@ void main(uint3 id : SV_DispatchThreadID)
         config::MipMapBias m_mipMapBiasingType{config::MipMapBias::Off};
         float m_mipMapBias{0.f};
         mutable uint32_t m_numBiasedSamplersThisFrame{0};
+        mutable uint32_t m_numBiasedSamplersCreatedThisFrame{0};
+        std::mutex m_biasedSamplersLock;
+        BiasedSamplerCache m_biasedSamplers;
 
         SetRenderTargetEvent m_setRenderTargetEvent;
         UnsetRenderTargetEvent m_unsetRenderTargetEvent;
         CopyTextureEvent m_copyTextureEvent;
+        ClearDepthEvent m_clearDepthEvent;
         std::atomic<bool> m_blockEvents{false};
+        EventsFilter m_eventsFilter;
+        std::array<std::atomic<uint32_t>, to_integral(InterceptedCall::MaxValue)> m_interceptedCallSubscriptions{};
+
+        std::mutex m_eventsCacheLock;
+        std::unordered_map<ID3D11DeviceContext*,
+                           std::pair<ComPtr<ID3D11DeviceContext>, std::shared_ptr<D3D11Context>>>
+            m_eventsContexts;
+        std::unordered_map<ID3D11RenderTargetView*,
+                           std::pair<ComPtr<ID3D11RenderTargetView>, std::shared_ptr<D3D11Texture>>>
+            m_eventsRenderTargets;
+        std::unordered_map<ID3D11Resource*, std::pair<ComPtr<ID3D11Resource>, std::shared_ptr<D3D11Texture>>>
+            m_eventsTextures;
 
         ComPtr<ID3D11ComputeShader> m_debugWorkloadShader;
         std::shared_ptr<IShaderBuffer> m_debugWorkloadParams;
         bool m_executeDebugWorkload{false};
+        wil::unique_handle m_flushEvent;
+
+        std::deque<std::pair<uint64_t, ComPtr<ID3D11Query>>> m_frameEndQueries;
+        std::vector<ComPtr<ID3D11Query>> m_freeFrameEndQueries;
+        uint64_t m_frameSerial{0};
+        uint64_t m_completedFrameSerial{0};
+        std::deque<std::pair<uint64_t, std::shared_ptr<void>>> m_deferredReleases;
+        std::mutex m_deferredReleasesLock;
 
         mutable std::shared_ptr<IQuadShader> m_currentQuadShader;
         mutable std::shared_ptr<IComputeShader> m_currentComputeShader;
@@ -2101,13 +2890,16 @@ void main(uint3 id : SV_DispatchThreadID)
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D11DeviceContext_OMSetRenderTargets",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLArg(NumViews, "NumViews"),
                                    TLPArg(pDepthStencilView, "DSV"));
-            if (IsTraceEnabled()) {
+            if (IsTraceKeywordEnabled(TLK_GraphicsHooks)) {
                 for (UINT i = 0; i < NumViews; i++) {
-                    TraceLoggingWriteTagged(
-                        local, "ID3D11DeviceContext_OMSetRenderTargets", TLPArg(ppRenderTargetViews[i], "RTV"));
+                    TraceLoggingWriteTagged(local,
+                                            "ID3D11DeviceContext_OMSetRenderTargets",
+                                            TraceLoggingKeyword(TLK_GraphicsHooks),
+                                            TLPArg(ppRenderTargetViews[i], "RTV"));
                 }
             }
 
@@ -2116,9 +2908,13 @@ void main(uint3 id : SV_DispatchThreadID)
             g_original_ID3D11DeviceContext_OMSetRenderTargets(
                 Context, NumViews, ppRenderTargetViews, pDepthStencilView);
 
-            g_instance->onSetRenderTargets(Context, NumViews, ppRenderTargetViews, pDepthStencilView);
+            if (g_instance->isInterceptedCallSubscribed(InterceptedCall::SetRenderTargets)) {
+                g_instance->onSetRenderTargets(Context, NumViews, ppRenderTargetViews, pDepthStencilView);
+            }
 
-            TraceLoggingWriteStop(local, "ID3D11DeviceContext_OMSetRenderTargets");
+            TraceLoggingWriteStop(local,
+                                  "ID3D11DeviceContext_OMSetRenderTargets",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         DECLARE_DETOUR_FUNCTION(static void,
@@ -2135,13 +2931,15 @@ void main(uint3 id : SV_DispatchThreadID)
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLArg(NumRTVs, "NumRTVs"),
                                    TLPArg(pDepthStencilView, "DSV"));
-            if (IsTraceEnabled() && NumRTVs != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL) {
+            if (IsTraceKeywordEnabled(TLK_GraphicsHooks) && NumRTVs != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL) {
                 for (UINT i = 0; i < NumRTVs; i++) {
                     TraceLoggingWriteTagged(local,
                                             "ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews",
+                                            TraceLoggingKeyword(TLK_GraphicsHooks),
                                             TLPArg(ppRenderTargetViews[i], "RTV"));
                 }
             }
@@ -2157,11 +2955,14 @@ void main(uint3 id : SV_DispatchThreadID)
                                                                                      ppUnorderedAccessViews,
                                                                                      pUAVInitialCounts);
 
-            if (NumRTVs != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL) {
+            if (NumRTVs != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL &&
+                g_instance->isInterceptedCallSubscribed(InterceptedCall::SetRenderTargets)) {
                 g_instance->onSetRenderTargets(Context, NumRTVs, ppRenderTargetViews, pDepthStencilView);
             }
 
-            TraceLoggingWriteStop(local, "ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews");
+            TraceLoggingWriteStop(local,
+                                  "ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         DECLARE_DETOUR_FUNCTION(static void,
@@ -2173,13 +2974,15 @@ void main(uint3 id : SV_DispatchThreadID)
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D11DeviceContext_RSSetViewports",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLArg(NumViewports, "NumViewports"));
 
-            if (IsTraceEnabled() && pViewports) {
+            if (IsTraceKeywordEnabled(TLK_GraphicsHooks) && pViewports) {
                 for (UINT i = 0; i < NumViewports; i++) {
                     TraceLoggingWriteTagged(local,
                                             "ID3D11DeviceContext_RSSetViewports",
+                                            TraceLoggingKeyword(TLK_GraphicsHooks),
                                             TLArg(pViewports[i].TopLeftX, "TopLeftX"),
                                             TLArg(pViewports[i].TopLeftY, "TopLeftY"),
                                             TLArg(pViewports[i].Width, "Width"),
@@ -2190,7 +2993,7 @@ void main(uint3 id : SV_DispatchThreadID)
             assert(g_original_ID3D11DeviceContext_RSSetViewports);
             g_original_ID3D11DeviceContext_RSSetViewports(Context, NumViewports, pViewports);
 
-            TraceLoggingWriteStop(local, "ID3D11DeviceContext_RSSetViewports");
+            TraceLoggingWriteStop(local, "ID3D11DeviceContext_RSSetViewports", TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         DECLARE_DETOUR_FUNCTION(static void,
@@ -2202,17 +3005,20 @@ void main(uint3 id : SV_DispatchThreadID)
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D11DeviceContext_CopyResource",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLPArg(pDstResource, "DstResource"),
                                    TLPArg(pSrcResource, "SrcResource"));
 
             assert(g_instance);
-            g_instance->onCopyResource(Context, pSrcResource, pDstResource);
+            if (g_instance->isInterceptedCallSubscribed(InterceptedCall::CopyTexture)) {
+                g_instance->onCopyResource(Context, pSrcResource, pDstResource);
+            }
 
             assert(g_original_ID3D11DeviceContext_CopyResource);
             g_original_ID3D11DeviceContext_CopyResource(Context, pDstResource, pSrcResource);
 
-            TraceLoggingWriteStop(local, "ID3D11DeviceContext_CopyResource");
+            TraceLoggingWriteStop(local, "ID3D11DeviceContext_CopyResource", TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         DECLARE_DETOUR_FUNCTION(static void,
@@ -2230,6 +3036,7 @@ void main(uint3 id : SV_DispatchThreadID)
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D11DeviceContext_CopySubresourceRegion",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLPArg(pDstResource, "DstResource"),
                                    TLArg(DstSubresource, "DstSubresource"),
@@ -2237,13 +3044,17 @@ void main(uint3 id : SV_DispatchThreadID)
                                    TLArg(SrcSubresource, "SrcSubresource"));
 
             assert(g_instance);
-            g_instance->onCopyResource(Context, pSrcResource, pDstResource, SrcSubresource, DstSubresource);
+            if (g_instance->isInterceptedCallSubscribed(InterceptedCall::CopyTexture)) {
+                g_instance->onCopyResource(Context, pSrcResource, pDstResource, SrcSubresource, DstSubresource);
+            }
 
             assert(g_original_ID3D11DeviceContext_CopySubresourceRegion);
             g_original_ID3D11DeviceContext_CopySubresourceRegion(
                 Context, pDstResource, DstSubresource, DstX, DstY, DstZ, pSrcResource, SrcSubresource, pSrcBox);
 
-            TraceLoggingWriteStop(local, "ID3D11DeviceContext_CopySubresourceRegion");
+            TraceLoggingWriteStop(local,
+                                  "ID3D11DeviceContext_CopySubresourceRegion",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         DECLARE_DETOUR_FUNCTION(static void,
@@ -2256,6 +3067,7 @@ void main(uint3 id : SV_DispatchThreadID)
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D11DeviceContext_PSSetSamplers",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLArg(StartSlot, "StartSlots"),
                                    TLArg(NumSamplers, "NumSamplers"));
@@ -2265,17 +3077,53 @@ void main(uint3 id : SV_DispatchThreadID)
 
             ID3D11SamplerState* updatedSamplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
             for (UINT i = 0; i < NumSamplers; i++) {
-                TraceLoggingWriteTagged(local, "ID3D11DeviceContext_PSSetSamplers", TLPArg(ppSamplers[i], "Sampler"));
+                TraceLoggingWriteTagged(local,
+                                        "ID3D11DeviceContext_PSSetSamplers",
+                                        TraceLoggingKeyword(TLK_GraphicsHooks),
+                                        TLPArg(ppSamplers[i], "Sampler"));
                 updatedSamplers[i] = ppSamplers[i];
             }
 
             assert(g_instance);
-            g_instance->patchSamplers(Context, updatedSamplers, NumSamplers);
+            if (g_instance->isInterceptedCallSubscribed(InterceptedCall::SetSamplers)) {
+                g_instance->patchSamplers(Context, updatedSamplers, NumSamplers);
+            }
 
             assert(g_original_ID3D11DeviceContext_PSSetSamplers);
             g_original_ID3D11DeviceContext_PSSetSamplers(Context, StartSlot, NumSamplers, updatedSamplers);
 
-            TraceLoggingWriteStop(local, "ID3D11DeviceContext_PSSetSamplers");
+            TraceLoggingWriteStop(local, "ID3D11DeviceContext_PSSetSamplers", TraceLoggingKeyword(TLK_GraphicsHooks));
+        }
+
+        DECLARE_DETOUR_FUNCTION(static void,
+                                STDMETHODCALLTYPE,
+                                ID3D11DeviceContext_ClearDepthStencilView,
+                                ID3D11DeviceContext* Context,
+                                ID3D11DepthStencilView* pDepthStencilView,
+                                UINT ClearFlags,
+                                FLOAT Depth,
+                                UINT8 Stencil) {
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "ID3D11DeviceContext_ClearDepthStencilView",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
+                                   TLPArg(Context, "Context"),
+                                   TLPArg(pDepthStencilView, "DSV"),
+                                   TLArg(ClearFlags, "ClearFlags"),
+                                   TLArg(Depth, "Depth"));
+
+            assert(g_instance);
+            assert(g_original_ID3D11DeviceContext_ClearDepthStencilView);
+            g_original_ID3D11DeviceContext_ClearDepthStencilView(
+                Context, pDepthStencilView, ClearFlags, Depth, Stencil);
+
+            if (g_instance->isInterceptedCallSubscribed(InterceptedCall::ClearDepth)) {
+                g_instance->onClearDepthStencilView(Context, pDepthStencilView, ClearFlags, Depth);
+            }
+
+            TraceLoggingWriteStop(local,
+                                  "ID3D11DeviceContext_ClearDepthStencilView",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
         }
     };
 
@@ -27,6 +27,7 @@
 #include "shader_utilities.h"
 #include "factories.h"
 #include "interfaces.h"
+#include "layer.h"
 #include "log.h"
 
 #include "utils\ScreenGrab12.h"
@@ -40,7 +41,15 @@ namespace {
     using namespace toolkit::log;
 
     constexpr size_t MaxGpuTimers = 256;
+    // The timestamps are resolved at the end of each frame into a ring of readback slots, so that the CPU can read
+    // the last completed set while the GPU is still writing the next ones.
+    constexpr size_t NumTimestampReadbacks = 3;
     constexpr size_t MaxModelBuffers = 128;
+    constexpr size_t MaxTransientDescriptorsPerContext = 128 + MaxModelBuffers;
+    constexpr UINT64 UploadRingSize = 4 * 1024 * 1024;
+    constexpr uint32_t TextAtlasSize = 1024;
+
+    const std::wstring_view FontFamily = L"Segoe UI Symbol";
 
     // If the application uses the Streamline SDK, some D3D12 objects are shimmed, and this will confuse our Detours
     // logic. Luckily, the Streamline SDK has a secret UUID that can be used to query the underlying interface. From
@@ -64,6 +73,10 @@ namespace {
         return left.ptr < right.ptr;
     };
 
+    // Persistent descriptors, recycled through a free list when their view is destroyed.
+    // Only the sampler heap is shader-visible: CBV/SRV/UAV descriptors are staged in a CPU-only heap and copied into
+    // the D3D12DescriptorRing upon binding, which lets us free them immediately even if the GPU has not executed the
+    // commands referencing them yet.
     struct D3D12Heap {
         void initialize(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescriptors = 32) {
             D3D12_DESCRIPTOR_HEAP_DESC desc;
@@ -71,22 +84,41 @@ namespace {
             heapSize = desc.NumDescriptors = numDescriptors;
             desc.Type = type;
             desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-            if (type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER || type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) {
+            if (type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER) {
                 desc.Flags |= D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
             }
             CHECK_HRCMD(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(set(heap))));
             heapStartCPU = heap->GetCPUDescriptorHandleForHeapStart();
-            heapStartGPU = heap->GetGPUDescriptorHandleForHeapStart();
+            if (desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) {
+                heapStartGPU = heap->GetGPUDescriptorHandleForHeapStart();
+            }
             heapOffset = 0;
+            numAllocated = 0;
+            freeList.clear();
             descSize = device->GetDescriptorHandleIncrementSize(type);
         }
 
         void allocate(D3D12_CPU_DESCRIPTOR_HANDLE& desc) {
-            assert((UINT)heapOffset < heapSize);
-            desc = CD3DX12_CPU_DESCRIPTOR_HANDLE(heapStartCPU, heapOffset++, descSize);
+            UINT index;
+            if (!freeList.empty()) {
+                index = freeList.back();
+                freeList.pop_back();
+            } else {
+                if ((UINT)heapOffset >= heapSize) {
+                    throw std::runtime_error("Descriptor heap is full");
+                }
+                index = heapOffset++;
+            }
+            numAllocated++;
+            desc = CD3DX12_CPU_DESCRIPTOR_HANDLE(heapStartCPU, index, descSize);
         }
 
-        // TODO: Implement freeing a descriptor
+        void free(D3D12_CPU_DESCRIPTOR_HANDLE desc) {
+            const auto index = static_cast<UINT>((desc.ptr - heapStartCPU.ptr) / descSize);
+            assert(index < (UINT)heapOffset);
+            numAllocated--;
+            freeList.push_back(index);
+        }
 
         D3D12_GPU_DESCRIPTOR_HANDLE getGPUHandle(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) const {
             INT64 offset = (cpuHandle.ptr - heapStartCPU.ptr) / descSize;
@@ -96,9 +128,376 @@ namespace {
         UINT heapSize{0};
         ComPtr<ID3D12DescriptorHeap> heap;
         D3D12_CPU_DESCRIPTOR_HANDLE heapStartCPU;
-        D3D12_GPU_DESCRIPTOR_HANDLE heapStartGPU;
+        D3D12_GPU_DESCRIPTOR_HANDLE heapStartGPU{};
         INT heapOffset{0};
+        UINT numAllocated{0};
+        std::vector<UINT> freeList;
+        UINT descSize;
+    };
+
+    // Transient shader-visible descriptors. The heap is split into one region per in-flight command list, and the
+    // region is recycled when its command list is reset. Descriptor tables are copied from the persistent heap.
+    struct D3D12DescriptorRing {
+        void initialize(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numRegions, UINT regionSize) {
+            D3D12_DESCRIPTOR_HEAP_DESC desc;
+            ZeroMemory(&desc, sizeof(desc));
+            desc.NumDescriptors = numRegions * regionSize;
+            desc.Type = type;
+            desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+            CHECK_HRCMD(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(set(heap))));
+            heapStartCPU = heap->GetCPUDescriptorHandleForHeapStart();
+            heapStartGPU = heap->GetGPUDescriptorHandleForHeapStart();
+            descSize = device->GetDescriptorHandleIncrementSize(type);
+            heapType = type;
+            this->device = device;
+            this->regionSize = regionSize;
+            beginRegion(0);
+        }
+
+        void beginRegion(size_t region) {
+            regionStart = static_cast<UINT>(region) * regionSize;
+            regionOffset = 0;
+        }
+
+        D3D12_GPU_DESCRIPTOR_HANDLE copy(const D3D12_CPU_DESCRIPTOR_HANDLE* descs, UINT count) {
+            if (regionOffset + count > regionSize) {
+                throw std::runtime_error("Transient descriptor region is full");
+            }
+            const UINT index = regionStart + regionOffset;
+            regionOffset += count;
+            peakUsage = std::max(peakUsage, regionOffset);
+
+            // Source ranges are single descriptors, the destination is one contiguous table.
+            const D3D12_CPU_DESCRIPTOR_HANDLE destination = CD3DX12_CPU_DESCRIPTOR_HANDLE(heapStartCPU, index, descSize);
+            device->CopyDescriptors(1, &destination, &count, count, descs, nullptr, heapType);
+            return CD3DX12_GPU_DESCRIPTOR_HANDLE(heapStartGPU, index, descSize);
+        }
+
+        ComPtr<ID3D12DescriptorHeap> heap;
+        ID3D12Device* device{nullptr};
+        D3D12_DESCRIPTOR_HEAP_TYPE heapType;
+        D3D12_CPU_DESCRIPTOR_HANDLE heapStartCPU;
+        D3D12_GPU_DESCRIPTOR_HANDLE heapStartGPU;
         UINT descSize;
+        UINT regionSize{0};
+        UINT regionStart{0};
+        UINT regionOffset{0};
+        UINT peakUsage{0};
+    };
+
+    struct D3D12UploadAllocation {
+        ID3D12Resource* resource;
+        UINT64 offset;
+        void* cpuAddress;
+    };
+
+    // A single persistently-mapped upload buffer that all the uploads sub-allocate from. Each allocation is tagged with
+    // the next fence value, and its memory is reclaimed once the GPU has signaled it.
+    class D3D12UploadRing {
+      public:
+        void initialize(ID3D12Device* device, ID3D12Fence* fence, std::function<UINT64()> getNextFenceValue) {
+            m_device = device;
+            m_fence = fence;
+            m_getNextFenceValue = getNextFenceValue;
+
+            const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+            const auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(UploadRingSize);
+            CHECK_HRCMD(device->CreateCommittedResource(&heapType,
+                                                        D3D12_HEAP_FLAG_NONE,
+                                                        &bufferDesc,
+                                                        D3D12_RESOURCE_STATE_GENERIC_READ,
+                                                        nullptr,
+                                                        IID_PPV_ARGS(set(m_buffer))));
+            SetDebugName(get(m_buffer), "Upload Ring");
+
+            const D3D12_RANGE noRead{0, 0};
+            CHECK_HRCMD(m_buffer->Map(0, &noRead, reinterpret_cast<void**>(&m_mappedBuffer)));
+        }
+
+        D3D12UploadAllocation allocate(UINT64 size, UINT64 alignment) {
+            reclaim();
+
+            const UINT64 fenceValue = m_getNextFenceValue();
+            UINT64 start = alignTo(m_head, alignment);
+            if ((start % UploadRingSize) + size > UploadRingSize) {
+                // Do not straddle the end of the buffer.
+                start = alignTo(m_head, UploadRingSize);
+            }
+
+            if (start + size - m_tail > UploadRingSize) {
+                // The ring is full (or the allocation is too large): use a standalone buffer with the same lifetime.
+                const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+                const auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+                ComPtr<ID3D12Resource> buffer;
+                CHECK_HRCMD(m_device->CreateCommittedResource(&heapType,
+                                                              D3D12_HEAP_FLAG_NONE,
+                                                              &bufferDesc,
+                                                              D3D12_RESOURCE_STATE_GENERIC_READ,
+                                                              nullptr,
+                                                              IID_PPV_ARGS(set(buffer))));
+                SetDebugName(get(buffer), "Upload Overflow");
+                void* mappedBuffer = nullptr;
+                CHECK_HRCMD(buffer->Map(0, nullptr, &mappedBuffer));
+                m_overflowBuffers.push_back(std::make_pair(fenceValue, buffer));
+                return {get(buffer), 0, mappedBuffer};
+            }
+
+            m_head = start + size;
+            if (!m_pending.empty() && m_pending.back().first == fenceValue) {
+                m_pending.back().second = m_head;
+            } else {
+                m_pending.push_back(std::make_pair(fenceValue, m_head));
+            }
+            return {get(m_buffer), start % UploadRingSize, m_mappedBuffer + (start % UploadRingSize)};
+        }
+
+      private:
+        void reclaim() {
+            const auto completedFenceValue = m_fence->GetCompletedValue();
+            while (!m_pending.empty() && m_pending.front().first <= completedFenceValue) {
+                m_tail = m_pending.front().second;
+                m_pending.pop_front();
+            }
+            while (!m_overflowBuffers.empty() && m_overflowBuffers.front().first <= completedFenceValue) {
+                m_overflowBuffers.pop_front();
+            }
+        }
+
+        ID3D12Device* m_device{nullptr};
+        ID3D12Fence* m_fence{nullptr};
+        std::function<UINT64()> m_getNextFenceValue;
+        ComPtr<ID3D12Resource> m_buffer;
+        uint8_t* m_mappedBuffer{nullptr};
+
+        // Offsets are monotonic and wrapped upon use.
+        UINT64 m_head{0};
+        UINT64 m_tail{0};
+        std::deque<std::pair<UINT64, UINT64>> m_pending;
+        std::deque<std::pair<UINT64, ComPtr<ID3D12Resource>>> m_overflowBuffers;
+    };
+
+    // Persistent pipeline state cache, backed by an ID3D12PipelineLibrary serialized to LocalAppData.
+    // Pipelines are keyed by a hash of their shaders, root signature, output formats and fixed-function state.
+    class D3D12PipelineCache {
+      public:
+        ~D3D12PipelineCache() {
+            waitForLoad();
+        }
+
+        void initialize(ID3D12Device* device, const std::filesystem::path& path, bool loadAsync) {
+            if (FAILED(device->QueryInterface(set(m_device)))) {
+                Log("Pipeline cache is not supported\n");
+                return;
+            }
+            m_path = path;
+
+            // Opening a large library requires the driver to validate it, which we can do in the background.
+            if (loadAsync) {
+                m_loading = std::async(std::launch::async, [&]() { load(); });
+            } else {
+                load();
+            }
+        }
+
+        void serialize() {
+            waitForLoad();
+            if (!m_library || !m_isDirty) {
+                return;
+            }
+
+            std::vector<uint8_t> blob(m_library->GetSerializedSize());
+            if (FAILED(m_library->Serialize(blob.data(), blob.size()))) {
+                Log("Failed to serialize pipeline cache\n");
+                return;
+            }
+
+            std::ofstream file(m_path, std::ios::binary);
+            if (file.is_open()) {
+                file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+                m_isDirty = false;
+                DebugLog("Saved pipeline cache (%zu bytes)\n", blob.size());
+            }
+        }
+
+        ComPtr<ID3D12PipelineState> createGraphicsPipelineState(ID3D12Device* device,
+                                                                const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+                                                                uint64_t rootSignatureHash) {
+            // Every field of the description must be part of the key, since a hit returns the cached pipeline as-is.
+            uint64_t hash = rootSignatureHash;
+            for (const auto& shader : {desc.VS, desc.PS, desc.DS, desc.HS, desc.GS}) {
+                hash = hashValue(hash, shader.BytecodeLength);
+                hash = hashBytes(hash, shader.pShaderBytecode, shader.BytecodeLength);
+            }
+            hash = hashValue(hash, desc.StreamOutput.NumEntries);
+            for (UINT i = 0; i < desc.StreamOutput.NumEntries; i++) {
+                const auto& entry = desc.StreamOutput.pSODeclaration[i];
+                hash = hashValue(hash, entry.Stream);
+                if (entry.SemanticName) {
+                    hash = hashBytes(hash, entry.SemanticName, strlen(entry.SemanticName) + 1);
+                }
+                hash = hashValue(hash, entry.SemanticIndex);
+                hash = hashValue(hash, entry.StartComponent);
+                hash = hashValue(hash, entry.ComponentCount);
+                hash = hashValue(hash, entry.OutputSlot);
+            }
+            hash = hashValue(hash, desc.StreamOutput.NumStrides);
+            hash = hashBytes(hash, desc.StreamOutput.pBufferStrides, desc.StreamOutput.NumStrides * sizeof(UINT));
+            hash = hashValue(hash, desc.StreamOutput.RasterizedStream);
+            hash = hashValue(hash, desc.BlendState);
+            hash = hashValue(hash, desc.SampleMask);
+            hash = hashValue(hash, desc.RasterizerState);
+            hash = hashValue(hash, desc.DepthStencilState);
+            hash = hashValue(hash, desc.IBStripCutValue);
+            hash = hashValue(hash, desc.PrimitiveTopologyType);
+            hash = hashValue(hash, desc.NumRenderTargets);
+            hash = hashValue(hash, desc.RTVFormats);
+            hash = hashValue(hash, desc.DSVFormat);
+            hash = hashValue(hash, desc.SampleDesc);
+            hash = hashValue(hash, desc.NodeMask);
+            hash = hashValue(hash, desc.Flags);
+            hash = hashValue(hash, desc.InputLayout.NumElements);
+            for (UINT i = 0; i < desc.InputLayout.NumElements; i++) {
+                const auto& element = desc.InputLayout.pInputElementDescs[i];
+                hash = hashBytes(hash, element.SemanticName, strlen(element.SemanticName) + 1);
+                hash = hashValue(hash, element.SemanticIndex);
+                hash = hashValue(hash, element.Format);
+                hash = hashValue(hash, element.InputSlot);
+                hash = hashValue(hash, element.AlignedByteOffset);
+                hash = hashValue(hash, element.InputSlotClass);
+                hash = hashValue(hash, element.InstanceDataStepRate);
+            }
+            auto it = m_pipelineStates.find(hash);
+            if (it != m_pipelineStates.end()) {
+                return it->second;
+            }
+            const auto name = getName(hash);
+
+            ComPtr<ID3D12PipelineState> pipelineState;
+            waitForLoad();
+            if (!m_library ||
+                FAILED(m_library->LoadGraphicsPipeline(name.c_str(), &desc, IID_PPV_ARGS(set(pipelineState))))) {
+                CHECK_HRCMD(device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(set(pipelineState))));
+                store(name, get(pipelineState));
+            }
+            m_pipelineStates.insert_or_assign(hash, pipelineState);
+            return pipelineState;
+        }
+
+        ComPtr<ID3D12PipelineState> createComputePipelineState(ID3D12Device* device,
+                                                               const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+                                                               uint64_t rootSignatureHash) {
+            const auto hash = hashBytes(rootSignatureHash, desc.CS.pShaderBytecode, desc.CS.BytecodeLength);
+            auto it = m_pipelineStates.find(hash);
+            if (it != m_pipelineStates.end()) {
+                return it->second;
+            }
+            const auto name = getName(hash);
+
+            ComPtr<ID3D12PipelineState> pipelineState;
+            waitForLoad();
+            if (!m_library ||
+                FAILED(m_library->LoadComputePipeline(name.c_str(), &desc, IID_PPV_ARGS(set(pipelineState))))) {
+                CHECK_HRCMD(device->CreateComputePipelineState(&desc, IID_PPV_ARGS(set(pipelineState))));
+                store(name, get(pipelineState));
+            }
+            m_pipelineStates.insert_or_assign(hash, pipelineState);
+            return pipelineState;
+        }
+
+        // Most shaders share one of a handful of layouts, so root signatures are shared by all the shaders with the
+        // same serialized root signature.
+        ComPtr<ID3D12RootSignature>
+        createRootSignature(ID3D12Device* device, ID3DBlob* serializedRootSignature, uint64_t& rootSignatureHash) {
+            rootSignatureHash = hashBytes(
+                HashSeed, serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize());
+            auto it = m_rootSignatures.find(rootSignatureHash);
+            if (it != m_rootSignatures.end()) {
+                return it->second;
+            }
+
+            ComPtr<ID3D12RootSignature> rootSignature;
+            CHECK_HRCMD(device->CreateRootSignature(0,
+                                                    serializedRootSignature->GetBufferPointer(),
+                                                    serializedRootSignature->GetBufferSize(),
+                                                    IID_PPV_ARGS(set(rootSignature))));
+            m_rootSignatures.insert_or_assign(rootSignatureHash, rootSignature);
+            return rootSignature;
+        }
+
+        // FNV-1a.
+        static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; i++) {
+                hash ^= bytes[i];
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+        template <typename T>
+        static uint64_t hashValue(uint64_t hash, const T& value) {
+            return hashBytes(hash, &value, sizeof(value));
+        }
+
+        static constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+      private:
+        void load() {
+            {
+                std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+                if (file.is_open()) {
+                    m_blob.resize(static_cast<size_t>(file.tellg()));
+                    file.seekg(0);
+                    file.read(reinterpret_cast<char*>(m_blob.data()), m_blob.size());
+                }
+            }
+
+            // The library becomes invalid whenever the driver or the adapter changes, in which case we start over.
+            if (!m_blob.empty()) {
+                const HRESULT hr =
+                    m_device->CreatePipelineLibrary(m_blob.data(), m_blob.size(), IID_PPV_ARGS(set(m_library)));
+                if (SUCCEEDED(hr)) {
+                    Log("Loaded pipeline cache (%zu bytes)\n", m_blob.size());
+                    return;
+                }
+                Log("Discarding pipeline cache: %08x\n", hr);
+                m_blob.clear();
+            }
+            if (FAILED(m_device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(set(m_library))))) {
+                Log("Failed to create pipeline cache\n");
+            }
+        }
+
+        void waitForLoad() {
+            if (m_loading.valid()) {
+                m_loading.get();
+            }
+        }
+
+        void store(const std::wstring& name, ID3D12PipelineState* pipelineState) {
+            // A collision or an existing entry with the same name is not fatal, the pipeline is simply not cached.
+            if (m_library && SUCCEEDED(m_library->StorePipeline(name.c_str(), pipelineState))) {
+                m_isDirty = true;
+            }
+        }
+
+        static std::wstring getName(uint64_t hash) {
+            wchar_t name[17];
+            swprintf_s(name, L"%016llx", hash);
+            return name;
+        }
+
+        ComPtr<ID3D12Device1> m_device;
+        ComPtr<ID3D12PipelineLibrary> m_library;
+        std::filesystem::path m_path;
+        // The library references this memory, which must outlive it.
+        std::vector<uint8_t> m_blob;
+        std::future<void> m_loading;
+        bool m_isDirty{false};
+
+        // The objects already created during this session, which do not need to go through the library again.
+        std::map<uint64_t, ComPtr<ID3D12RootSignature>> m_rootSignatures;
+        std::map<uint64_t, ComPtr<ID3D12PipelineState>> m_pipelineStates;
     };
 
     // Wrap shader resources, common code for root signature creation.
@@ -108,8 +507,12 @@ namespace {
     // are going to be identical for a given shader, which is an acceptable constraint.
     class D3D12Shader {
       public:
-        D3D12Shader(std::shared_ptr<IDevice> device, ID3DBlob* shaderBytes, std::string_view debugName)
-            : m_device(device), m_shaderBytes(shaderBytes), m_debugName(debugName), m_shaderData{} {
+        D3D12Shader(std::shared_ptr<IDevice> device,
+                    D3D12PipelineCache& pipelineCache,
+                    std::shared_future<ComPtr<ID3DBlob>> shaderBytes,
+                    std::string_view debugName)
+            : m_device(device), m_pipelineCache(pipelineCache), m_shaderBytes(std::move(shaderBytes)),
+              m_debugName(debugName), m_shaderData{} {
         }
 
         virtual ~D3D12Shader() = default;
@@ -165,10 +568,8 @@ namespace {
                     CHECK_HRESULT(hr, "Failed to serialize root signature");
                 }
 
-                CHECK_HRCMD(device->CreateRootSignature(0,
-                                                        serializedRootSignature->GetBufferPointer(),
-                                                        serializedRootSignature->GetBufferSize(),
-                                                        IID_PPV_ARGS(set(m_rootSignature))));
+                m_rootSignature =
+                    m_pipelineCache.createRootSignature(device, get(serializedRootSignature), m_rootSignatureHash);
 
                 m_parametersDescriptorRanges.clear();
             }
@@ -179,12 +580,20 @@ namespace {
         }
 
       protected:
+        // The shader is compiled on a worker thread, we only need the result when creating the pipeline state.
+        D3D12_SHADER_BYTECODE getShaderBytecode() const {
+            const auto& shaderBytes = m_shaderBytes.get();
+            return {reinterpret_cast<BYTE*>(shaderBytes->GetBufferPointer()), shaderBytes->GetBufferSize()};
+        }
+
         const std::shared_ptr<IDevice> m_device;
+        D3D12PipelineCache& m_pipelineCache;
         // Keep a reference for memory management purposes.
-        const ComPtr<ID3DBlob> m_shaderBytes;
+        const std::shared_future<ComPtr<ID3DBlob>> m_shaderBytes;
         const std::string_view m_debugName;
 
         ComPtr<ID3D12RootSignature> m_rootSignature;
+        uint64_t m_rootSignatureHash{0};
         ComPtr<ID3D12PipelineState> m_pipelineState;
 
         // Only used during pre-resolve phase.
@@ -198,10 +607,11 @@ namespace {
     class D3D12QuadShader : public D3D12Shader, public IQuadShader {
       public:
         D3D12QuadShader(std::shared_ptr<IDevice> device,
+                        D3D12PipelineCache& pipelineCache,
                         D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
-                        ID3DBlob* shaderBytes,
+                        std::shared_future<ComPtr<ID3DBlob>> shaderBytes,
                         std::string_view debugName)
-            : D3D12Shader(device, shaderBytes, debugName), m_psoDesc(desc) {
+            : D3D12Shader(device, pipelineCache, std::move(shaderBytes), debugName), m_psoDesc(desc) {
         }
 
         Api getApi() const override {
@@ -219,6 +629,7 @@ namespace {
             // Initialize the pipeline state now.
             // TODO: We must support the RTV format changing.
             if (auto device = m_device->getAs<D3D12>()) {
+                m_psoDesc.PS = getShaderBytecode();
                 m_psoDesc.RTVFormats[0] = (DXGI_FORMAT)m_outputInfo.format;
                 m_psoDesc.NumRenderTargets = 1;
                 m_psoDesc.SampleDesc.Count = m_outputInfo.sampleCount;
@@ -235,7 +646,7 @@ namespace {
                     m_psoDesc.RasterizerState.MultisampleEnable = true;
                 }
                 m_psoDesc.pRootSignature = get(m_rootSignature);
-                CHECK_HRCMD(device->CreateGraphicsPipelineState(&m_psoDesc, IID_PPV_ARGS(set(m_pipelineState))));
+                m_pipelineState = m_pipelineCache.createGraphicsPipelineState(device, m_psoDesc, m_rootSignatureHash);
 
                 SetDebugName(get(m_pipelineState), m_debugName);
 
@@ -268,11 +679,12 @@ namespace {
     class D3D12ComputeShader : public D3D12Shader, public IComputeShader {
       public:
         D3D12ComputeShader(std::shared_ptr<IDevice> device,
+                           D3D12PipelineCache& pipelineCache,
                            D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
-                           ID3DBlob* shaderBytes,
+                           std::shared_future<ComPtr<ID3DBlob>> shaderBytes,
                            std::string_view debugName,
                            std::optional<std::array<unsigned int, 3>> threadGroups)
-            : D3D12Shader(device, shaderBytes, debugName), m_psoDesc(desc) {
+            : D3D12Shader(device, pipelineCache, std::move(shaderBytes), debugName), m_psoDesc(desc) {
             if (threadGroups) {
                 m_threadGroups = threadGroups.value();
             }
@@ -300,8 +712,9 @@ namespace {
 
             // Initialize the pipeline state now.
             if (auto device = m_device->getAs<D3D12>()) {
+                m_psoDesc.CS = getShaderBytecode();
                 m_psoDesc.pRootSignature = get(m_rootSignature);
-                CHECK_HRCMD(device->CreateComputePipelineState(&m_psoDesc, IID_PPV_ARGS(set(m_pipelineState))));
+                m_pipelineState = m_pipelineCache.createComputePipelineState(device, m_psoDesc, m_rootSignatureHash);
 
                 SetDebugName(get(m_pipelineState), m_debugName);
 
@@ -330,14 +743,28 @@ namespace {
         D3D12_COMPUTE_PIPELINE_STATE_DESC m_psoDesc;
     };
 
+    // Record a resource transition on the current command list of the device. See D3D12Device::transitionResource().
+    void TransitionResource(IDevice* device,
+                            ID3D12Resource* resource,
+                            D3D12_RESOURCE_STATES before,
+                            D3D12_RESOURCE_STATES after);
+
+    // Record the pending resource transitions of the device. Must be invoked before recording a command that depends
+    // on the state of the resources. See D3D12Device::flushBarriers().
+    void FlushResourceBarriers(IDevice* device);
+
     // Wrap a resource view. Obtained from D3D12Texture.
     class D3D12ResourceView : public IShaderInputTextureView,
                               public IComputeShaderOutputView,
                               public IRenderTargetView,
                               public IDepthStencilView {
       public:
-        D3D12ResourceView(std::shared_ptr<IDevice> device, D3D12_CPU_DESCRIPTOR_HANDLE resourceView)
-            : m_device(device), m_resourceView(resourceView) {
+        D3D12ResourceView(std::shared_ptr<IDevice> device, D3D12Heap& heap, D3D12_CPU_DESCRIPTOR_HANDLE resourceView)
+            : m_device(device), m_heap(heap), m_resourceView(resourceView) {
+        }
+
+        ~D3D12ResourceView() override {
+            m_heap.free(m_resourceView);
         }
 
         Api getApi() const override {
@@ -354,11 +781,18 @@ namespace {
 
       private:
         const std::shared_ptr<IDevice> m_device;
+        D3D12Heap& m_heap;
         const D3D12_CPU_DESCRIPTOR_HANDLE m_resourceView;
     };
 
     // Wrap a texture resource. Obtained from D3D12Device.
     class D3D12Texture : public ITexture {
+        // The state of the resource, shared with its aliases.
+        struct ResourceState {
+            D3D12_RESOURCE_STATES current;
+            std::vector<D3D12_RESOURCE_STATES> stack;
+        };
+
       public:
         D3D12Texture(std::shared_ptr<IDevice> device,
                      const XrSwapchainCreateInfo& info,
@@ -367,9 +801,12 @@ namespace {
                      D3D12_RESOURCE_STATES initialState,
                      D3D12Heap& rtvHeap,
                      D3D12Heap& dsvHeap,
-                     D3D12Heap& rvHeap)
+                     D3D12Heap& rvHeap,
+                     D3D12UploadRing& uploadRing,
+                     std::shared_ptr<ResourceState> aliasedState = nullptr)
             : m_device(device), m_info(info), m_textureDesc(textureDesc), m_texture(texture),
-              m_currentState(initialState), m_rtvHeap(rtvHeap), m_dsvHeap(dsvHeap), m_rvHeap(rvHeap) {
+              m_state(aliasedState ? aliasedState : std::make_shared<ResourceState>(ResourceState{initialState, {}})),
+              m_rtvHeap(rtvHeap), m_dsvHeap(dsvHeap), m_rvHeap(rvHeap), m_uploadRing(uploadRing) {
             m_shaderResourceSubView.resize(info.arraySize);
             m_unorderedAccessSubView.resize(info.arraySize);
             m_renderTargetSubView.resize(info.arraySize);
@@ -394,17 +831,21 @@ namespace {
 
         std::shared_ptr<IShaderInputTextureView> getShaderResourceView(int32_t slice) const override {
             assert(slice < 0 || m_shaderResourceSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_shaderResourceView : m_shaderResourceSubView[slice];
+            auto& view = slice == AllSlices ? m_shaderResourceArrayView
+                         : slice < 0        ? m_shaderResourceView
+                                            : m_shaderResourceSubView[slice];
             if (!view)
-                view = makeShaderInputViewInternal(std::max(slice, 0));
+                view = makeShaderInputViewInternal(std::max(slice, 0), slice == AllSlices ? m_info.arraySize : 1);
             return view;
         }
 
         std::shared_ptr<IComputeShaderOutputView> getUnorderedAccessView(int32_t slice) const override {
             assert(slice < 0 || m_unorderedAccessSubView.size() > size_t(slice));
-            auto& view = slice < 0 ? m_unorderedAccessView : m_unorderedAccessSubView[slice];
+            auto& view = slice == AllSlices ? m_unorderedAccessArrayView
+                         : slice < 0        ? m_unorderedAccessView
+                                            : m_unorderedAccessSubView[slice];
             if (!view)
-                view = makeUnorderedAccessViewInternal(std::max(slice, 0));
+                view = makeUnorderedAccessViewInternal(std::max(slice, 0), slice == AllSlices ? m_info.arraySize : 1);
             return view;
         }
 
@@ -427,40 +868,25 @@ namespace {
         void uploadData(const void* buffer, uint32_t rowPitch, int32_t slice = -1) override {
             assert(!(rowPitch % m_device->getTextureAlignmentConstraint()));
 
-            // Create an upload buffer if we don't have one already
-            if (!m_uploadBuffer) {
-                m_uploadSize = alignTo((UINT)m_textureDesc.Width, m_device->getTextureAlignmentConstraint()) *
-                               m_textureDesc.Height;
-                const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-                const auto stagingDesc = CD3DX12_RESOURCE_DESC::Buffer(m_uploadSize);
-                CHECK_HRCMD(m_device->getAs<D3D12>()->CreateCommittedResource(&heapType,
-                                                                              D3D12_HEAP_FLAG_NONE,
-                                                                              &stagingDesc,
-                                                                              D3D12_RESOURCE_STATE_GENERIC_READ,
-                                                                              nullptr,
-                                                                              IID_PPV_ARGS(set(m_uploadBuffer))));
-            }
-
-            // Copy to the upload buffer.
-            {
-                void* mappedBuffer = nullptr;
-                m_uploadBuffer->Map(0, nullptr, &mappedBuffer);
-                memcpy(mappedBuffer, buffer, m_uploadSize);
-                m_uploadBuffer->Unmap(0, nullptr);
-            }
+            // Copy to the upload ring.
+            const UINT64 uploadSize = (UINT64)rowPitch * m_textureDesc.Height;
+            const auto allocation = m_uploadRing.allocate(uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+            memcpy(allocation.cpuAddress, buffer, uploadSize);
 
             // Do the upload now.
             if (auto context = m_device->getContextAs<D3D12>()) {
                 pushState(D3D12_RESOURCE_STATE_COPY_DEST);
+                FlushResourceBarriers(m_device.get());
 
                 D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
                 ZeroMemory(&footprint, sizeof(footprint));
+                footprint.Offset = allocation.offset;
                 footprint.Footprint.Width = (UINT)m_textureDesc.Width;
                 footprint.Footprint.Height = m_textureDesc.Height;
                 footprint.Footprint.Depth = 1;
                 footprint.Footprint.RowPitch = rowPitch;
                 footprint.Footprint.Format = m_textureDesc.Format;
-                CD3DX12_TEXTURE_COPY_LOCATION src(get(m_uploadBuffer), footprint);
+                CD3DX12_TEXTURE_COPY_LOCATION src(allocation.resource, footprint);
                 CD3DX12_TEXTURE_COPY_LOCATION dst(get(m_texture), 0);
                 context->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
 
@@ -475,6 +901,7 @@ namespace {
 
             pushState(D3D12_RESOURCE_STATE_COPY_SOURCE);
             destination->pushState(D3D12_RESOURCE_STATE_COPY_DEST);
+            FlushResourceBarriers(m_device.get());
 
             m_device->getContextAs<D3D12>()->CopyTextureRegion(&destLoc, 0, 0, 0, &srcLoc, nullptr);
 
@@ -499,6 +926,7 @@ namespace {
 
             pushState(D3D12_RESOURCE_STATE_COPY_SOURCE);
             destination->pushState(D3D12_RESOURCE_STATE_COPY_DEST);
+            FlushResourceBarriers(m_device.get());
 
             m_device->getContextAs<D3D12>()->CopyTextureRegion(&destLoc, 0, 0, 0, &srcLoc, &box);
 
@@ -513,6 +941,7 @@ namespace {
 
             pushState(D3D12_RESOURCE_STATE_COPY_SOURCE);
             destination->pushState(D3D12_RESOURCE_STATE_COPY_DEST);
+            FlushResourceBarriers(m_device.get());
 
             m_device->getContextAs<D3D12>()->CopyTextureRegion(&destLoc, dstX, dstY, 0, &srcLoc, nullptr);
 
@@ -554,35 +983,53 @@ namespace {
         }
 
         void setState(D3D12_RESOURCE_STATES newState) override {
-            if (newState != m_currentState) {
-                const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(get(m_texture), m_currentState, newState);
-                m_device->getContextAs<D3D12>()->ResourceBarrier(1, &barrier);
+            if (newState != m_state->current) {
+                TransitionResource(m_device.get(), get(m_texture), m_state->current, newState);
             }
 
-            m_currentState = newState;
+            m_state->current = newState;
         }
 
         void pushState(D3D12_RESOURCE_STATES newState) override {
-            m_stateStack.push_back(m_currentState);
+            m_state->stack.push_back(m_state->current);
 
-            if (newState != m_currentState) {
-                const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(get(m_texture), m_currentState, newState);
-                m_device->getContextAs<D3D12>()->ResourceBarrier(1, &barrier);
+            if (newState != m_state->current) {
+                TransitionResource(m_device.get(), get(m_texture), m_state->current, newState);
             }
 
-            m_currentState = newState;
+            m_state->current = newState;
         }
 
         void popState() override {
-            const auto newState = m_stateStack.back();
-            m_stateStack.pop_back();
-
-            if (newState != m_currentState) {
-                const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(get(m_texture), m_currentState, newState);
-                m_device->getContextAs<D3D12>()->ResourceBarrier(1, &barrier);
+            const auto newState = m_state->stack.back();
+            m_state->stack.pop_back();
+
+            if (newState != m_state->current) {
+                TransitionResource(m_device.get(), get(m_texture), m_state->current, newState);
+            }
+
+            m_state->current = newState;
+        }
+
+        std::shared_ptr<ITexture> getUnormAlias() const override {
+            if (!m_unormAlias && IsTypelessColorFormat(m_textureDesc.Format)) {
+                const auto format = GetUnormFormat((DXGI_FORMAT)m_info.format);
+                if (format != DXGI_FORMAT_UNKNOWN) {
+                    auto info = m_info;
+                    info.format = format;
+                    m_unormAlias = std::make_shared<D3D12Texture>(m_device,
+                                                                  info,
+                                                                  m_textureDesc,
+                                                                  get(m_texture),
+                                                                  m_state->current,
+                                                                  m_rtvHeap,
+                                                                  m_dsvHeap,
+                                                                  m_rvHeap,
+                                                                  m_uploadRing,
+                                                                  m_state);
+                }
             }
-
-            m_currentState = newState;
+            return m_unormAlias;
         }
 
         void* getNativePtr() const override {
@@ -590,18 +1037,18 @@ namespace {
         }
 
       private:
-        std::shared_ptr<D3D12ResourceView> makeShaderInputViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D12ResourceView> makeShaderInputViewInternal(uint32_t slice, uint32_t arraySize = 1) const {
             if (m_textureDesc.Flags & D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE) {
                 throw std::runtime_error("Texture was created with D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE");
             }
             if (auto device = m_device->getAs<D3D12>()) {
                 D3D12_SHADER_RESOURCE_VIEW_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
-                desc.Format = (DXGI_FORMAT)m_info.format;
+                desc.Format = GetShaderResourceViewFormat((DXGI_FORMAT)m_info.format);
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D12_SRV_DIMENSION_TEXTURE2D : D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
                 desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-                desc.Texture2DArray.ArraySize = 1;
+                desc.Texture2DArray.ArraySize = arraySize;
                 desc.Texture2DArray.FirstArraySlice = slice;
                 desc.Texture2DArray.MipLevels = m_info.mipCount;
                 desc.Texture2DArray.MostDetailedMip = D3D12CalcSubresource(0, 0, 0, m_info.mipCount, m_info.arraySize);
@@ -609,12 +1056,12 @@ namespace {
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_rvHeap.allocate(handle);
                 device->CreateShaderResourceView(get(m_texture), &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, m_rvHeap, handle);
             }
             return nullptr;
         }
 
-        std::shared_ptr<D3D12ResourceView> makeUnorderedAccessViewInternal(uint32_t slice) const {
+        std::shared_ptr<D3D12ResourceView> makeUnorderedAccessViewInternal(uint32_t slice, uint32_t arraySize = 1) const {
             if (!(m_textureDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)) {
                 throw std::runtime_error("Texture was not created with D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS");
             }
@@ -624,14 +1071,14 @@ namespace {
                 desc.Format = (DXGI_FORMAT)m_info.format;
                 desc.ViewDimension =
                     m_info.arraySize == 1 ? D3D12_UAV_DIMENSION_TEXTURE2D : D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
-                desc.Texture2DArray.ArraySize = 1;
+                desc.Texture2DArray.ArraySize = arraySize;
                 desc.Texture2DArray.FirstArraySlice = slice;
                 desc.Texture2DArray.MipSlice = D3D12CalcSubresource(0, 0, 0, m_info.mipCount, m_info.arraySize);
 
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_rvHeap.allocate(handle);
                 device->CreateUnorderedAccessView(get(m_texture), nullptr, &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, m_rvHeap, handle);
             }
             return nullptr;
         }
@@ -653,7 +1100,7 @@ namespace {
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_rtvHeap.allocate(handle);
                 device->CreateRenderTargetView(get(m_texture), &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, m_rtvHeap, handle);
             }
             return nullptr;
         }
@@ -675,51 +1122,36 @@ namespace {
                 D3D12_CPU_DESCRIPTOR_HANDLE handle;
                 m_dsvHeap.allocate(handle);
                 device->CreateDepthStencilView(get(m_texture), &desc, handle);
-                return std::make_shared<D3D12ResourceView>(m_device, handle);
+                return std::make_shared<D3D12ResourceView>(m_device, m_dsvHeap, handle);
             }
             return nullptr;
         }
 
-        void setInteropTexture(std::shared_ptr<ITexture> interopTexture,
-                               std::shared_ptr<ITexture> copyTexture = nullptr) {
-            m_interopTexture = interopTexture;
-            m_interopCopyTexture = copyTexture;
-        }
-
-        std::shared_ptr<ITexture> getInteropTexture() {
-            return m_interopTexture;
-        }
-
-        std::shared_ptr<ITexture> getInteropCopyTexture() {
-            return m_interopCopyTexture;
-        }
-
         const std::shared_ptr<IDevice> m_device;
         const XrSwapchainCreateInfo m_info;
         const D3D12_RESOURCE_DESC m_textureDesc;
         const ComPtr<ID3D12Resource> m_texture;
 
-        D3D12_RESOURCE_STATES m_currentState;
-        std::vector<D3D12_RESOURCE_STATES> m_stateStack;
-
-        ComPtr<ID3D12Resource> m_uploadBuffer;
-        UINT m_uploadSize{0};
-        std::shared_ptr<ITexture> m_interopTexture;
-        std::shared_ptr<ITexture> m_interopCopyTexture;
+        const std::shared_ptr<ResourceState> m_state;
 
         D3D12Heap& m_rtvHeap;
         D3D12Heap& m_dsvHeap;
         D3D12Heap& m_rvHeap;
+        D3D12UploadRing& m_uploadRing;
 
         mutable std::shared_ptr<D3D12ResourceView> m_shaderResourceView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_shaderResourceSubView;
+        mutable std::shared_ptr<D3D12ResourceView> m_shaderResourceArrayView;
         mutable std::shared_ptr<D3D12ResourceView> m_unorderedAccessView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_unorderedAccessSubView;
+        mutable std::shared_ptr<D3D12ResourceView> m_unorderedAccessArrayView;
         mutable std::shared_ptr<D3D12ResourceView> m_renderTargetView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_renderTargetSubView;
         mutable std::shared_ptr<D3D12ResourceView> m_depthStencilView;
         mutable std::vector<std::shared_ptr<D3D12ResourceView>> m_depthStencilSubView;
 
+        mutable std::shared_ptr<ITexture> m_unormAlias;
+
         friend class D3D12Device;
     };
 
@@ -730,9 +1162,16 @@ namespace {
                     ID3D12Resource* buffer,
                     D3D12_RESOURCE_STATES initialState,
                     D3D12Heap& rvHeap,
-                    ID3D12Resource* uploadBuffer = nullptr)
+                    D3D12UploadRing& uploadRing,
+                    bool immutable)
             : m_device(device), m_bufferDesc(bufferDesc), m_buffer(buffer), m_currentState(initialState),
-              m_rvHeap(rvHeap), m_uploadBuffer(uploadBuffer) {
+              m_rvHeap(rvHeap), m_uploadRing(uploadRing), m_isImmutable(immutable) {
+        }
+
+        ~D3D12Buffer() override {
+            if (m_constantBufferView) {
+                m_rvHeap.free(m_constantBufferView.value());
+            }
         }
 
         Api getApi() const override {
@@ -743,23 +1182,23 @@ namespace {
             return m_device;
         }
 
-        void uploadData(const void* buffer, size_t count, ID3D12Resource* uploadBuffer) {
-            D3D12_SUBRESOURCE_DATA subresourceData;
-            subresourceData.pData = buffer;
-            subresourceData.RowPitch = subresourceData.SlicePitch = count;
+        void uploadInitialData(const void* buffer, size_t count) {
+            const auto allocation = m_uploadRing.allocate(count, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+            memcpy(allocation.cpuAddress, buffer, count);
 
             if (auto context = m_device->getContextAs<D3D12>()) {
                 pushState(D3D12_RESOURCE_STATE_COPY_DEST);
-                UpdateSubresources<1>(context, get(m_buffer), uploadBuffer, 0, 0, 1, &subresourceData);
+                FlushResourceBarriers(m_device.get());
+                context->CopyBufferRegion(get(m_buffer), 0, allocation.resource, allocation.offset, count);
                 popState();
             }
         }
 
         void uploadData(const void* buffer, size_t count) override {
-            if (!m_uploadBuffer) {
+            if (m_isImmutable) {
                 throw std::runtime_error("Buffer is immutable");
             }
-            uploadData(buffer, count, get(m_uploadBuffer));
+            uploadInitialData(buffer, count);
         }
 
         // TODO: Consider moving this operation up to IShaderBuffer. Will prevent the need for dynamic_cast below.
@@ -786,8 +1225,7 @@ namespace {
             m_stateStack.push_back(m_currentState);
 
             if (newState != m_currentState) {
-                const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(get(m_buffer), m_currentState, newState);
-                m_device->getContextAs<D3D12>()->ResourceBarrier(1, &barrier);
+                TransitionResource(m_device.get(), get(m_buffer), m_currentState, newState);
             }
 
             m_currentState = newState;
@@ -798,8 +1236,7 @@ namespace {
             m_stateStack.pop_back();
 
             if (newState != m_currentState) {
-                const auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(get(m_buffer), m_currentState, newState);
-                m_device->getContextAs<D3D12>()->ResourceBarrier(1, &barrier);
+                TransitionResource(m_device.get(), get(m_buffer), m_currentState, newState);
             }
 
             m_currentState = newState;
@@ -818,8 +1255,8 @@ namespace {
         std::vector<D3D12_RESOURCE_STATES> m_stateStack;
 
         D3D12Heap& m_rvHeap;
-
-        const ComPtr<ID3D12Resource> m_uploadBuffer;
+        D3D12UploadRing& m_uploadRing;
+        const bool m_isImmutable;
 
         mutable std::optional<D3D12_CPU_DESCRIPTOR_HANDLE> m_constantBufferView;
     };
@@ -871,9 +1308,12 @@ namespace {
         D3D12GpuTimer(std::shared_ptr<IDevice> device,
                       ID3D12QueryHeap* queryHeap,
                       std::function<uint64_t(UINT, UINT)> queryTimestampDelta,
+                      std::function<uint64_t()> getNextResolveSerial,
+                      std::function<uint64_t()> getCompletedResolveSerial,
                       UINT startIndex,
                       UINT stopIndex)
             : m_device(device), m_queryHeap(queryHeap), m_queryTimestampDelta(queryTimestampDelta),
+              m_getNextResolveSerial(getNextResolveSerial), m_getCompletedResolveSerial(getCompletedResolveSerial),
               m_startIndex(startIndex), m_stopIndex(stopIndex) {
         }
 
@@ -887,10 +1327,18 @@ namespace {
 
         void start() override {
             m_device->getContextAs<D3D12>()->EndQuery(get(m_queryHeap), D3D12_QUERY_TYPE_TIMESTAMP, m_startIndex);
+            m_resolveSerial = 0;
         }
 
         void stop() override {
             m_device->getContextAs<D3D12>()->EndQuery(get(m_queryHeap), D3D12_QUERY_TYPE_TIMESTAMP, m_stopIndex);
+
+            // The timestamps will be available once the next end of frame resolve has completed.
+            m_resolveSerial = m_getNextResolveSerial();
+        }
+
+        bool isReady() const override {
+            return m_resolveSerial && m_getCompletedResolveSerial() >= m_resolveSerial;
         }
 
         uint64_t query(bool reset) const override {
@@ -901,8 +1349,97 @@ namespace {
         const std::shared_ptr<IDevice> m_device;
         const ComPtr<ID3D12QueryHeap> m_queryHeap;
         const std::function<uint64_t(UINT, UINT)> m_queryTimestampDelta;
+        const std::function<uint64_t()> m_getNextResolveSerial;
+        const std::function<uint64_t()> m_getCompletedResolveSerial;
         const UINT m_startIndex;
         const UINT m_stopIndex;
+
+        uint64_t m_resolveSerial{0};
+    };
+
+    class D3D12TextureReadback : public ITextureReadback {
+      public:
+        D3D12TextureReadback(std::shared_ptr<IDevice> device,
+                             const XrSwapchainCreateInfo& info,
+                             ID3D12Fence* fence,
+                             std::function<UINT64()> getNextFenceValue)
+            : m_device(device), m_info(info), m_fence(fence), m_getNextFenceValue(getNextFenceValue) {
+            auto d3dDevice = m_device->getAs<D3D12>();
+
+            const auto textureDesc =
+                CD3DX12_RESOURCE_DESC::Tex2D((DXGI_FORMAT)info.format, info.width, info.height, 1, 1);
+            UINT64 totalBytes;
+            d3dDevice->GetCopyableFootprints(&textureDesc, 0, 1, 0, &m_footprint, nullptr, nullptr, &totalBytes);
+
+            const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+            const auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(totalBytes);
+            CHECK_HRCMD(d3dDevice->CreateCommittedResource(&heapType,
+                                                           D3D12_HEAP_FLAG_NONE,
+                                                           &bufferDesc,
+                                                           D3D12_RESOURCE_STATE_COPY_DEST,
+                                                           nullptr,
+                                                           IID_PPV_ARGS(set(m_readbackBuffer))));
+            SetDebugName(get(m_readbackBuffer), "Readback Buffer");
+        }
+
+        Api getApi() const override {
+            return Api::D3D12;
+        }
+
+        const XrSwapchainCreateInfo& getInfo() const override {
+            return m_info;
+        }
+
+        void copyFrom(std::shared_ptr<ITexture> source, uint32_t srcX, uint32_t srcY, int32_t srcSlice) override {
+            D3D12_TEXTURE_COPY_LOCATION destLoc{get(m_readbackBuffer), D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT};
+            destLoc.PlacedFootprint = m_footprint;
+            D3D12_TEXTURE_COPY_LOCATION srcLoc{
+                source->getAs<D3D12>(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, (UINT)std::max(srcSlice, 0)};
+
+            D3D12_BOX box;
+            box.left = srcX;
+            box.top = srcY;
+            box.right = box.left + m_info.width;
+            box.bottom = box.top + m_info.height;
+            box.front = 0;
+            box.back = 1;
+
+            source->pushState(D3D12_RESOURCE_STATE_COPY_SOURCE);
+            FlushResourceBarriers(m_device.get());
+            m_device->getContextAs<D3D12>()->CopyTextureRegion(&destLoc, 0, 0, 0, &srcLoc, &box);
+            source->popState();
+
+            // The copy is complete once the command list is executed and the fence is signaled.
+            m_fenceValue = m_getNextFenceValue();
+        }
+
+        bool isReady() const override {
+            return m_fenceValue && m_fence->GetCompletedValue() >= m_fenceValue;
+        }
+
+        void readPixels(std::vector<uint8_t>& pixels, uint32_t& rowPitch) override {
+            rowPitch = m_footprint.Footprint.RowPitch;
+            const size_t size = size_t(rowPitch) * m_info.height;
+
+            uint8_t* mappedBuffer;
+            D3D12_RANGE range{0, size};
+            CHECK_HRCMD(m_readbackBuffer->Map(0, &range, reinterpret_cast<void**>(&mappedBuffer)));
+            pixels.assign(mappedBuffer, mappedBuffer + size);
+            D3D12_RANGE emptyRange{0, 0};
+            m_readbackBuffer->Unmap(0, &emptyRange);
+
+            m_fenceValue = 0;
+        }
+
+      private:
+        const std::shared_ptr<IDevice> m_device;
+        const XrSwapchainCreateInfo m_info;
+        const ComPtr<ID3D12Fence> m_fence;
+        const std::function<UINT64()> m_getNextFenceValue;
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_footprint;
+        ComPtr<ID3D12Resource> m_readbackBuffer;
+
+        UINT64 m_fenceValue{0};
     };
 
     // Wrap a device context.
@@ -941,12 +1478,11 @@ namespace {
       public:
         D3D12Device(ID3D12Device* device,
                     ID3D12CommandQueue* queue,
-                    std::shared_ptr<config::IConfigManager> configManager,
-                    bool enableVarjoQuirk = false)
+                    std::shared_ptr<config::IConfigManager> configManager)
             : m_device(device), m_queue(queue), m_gpuArchitecture(GpuArchitecture::Unknown),
               m_allowInterceptor(!configManager->isSafeMode() &&
                                  !configManager->getValue(config::SettingDisableInterceptor)),
-              m_needInteropCopy(enableVarjoQuirk) {
+              m_usePrecompiledShaders(!configManager->isDeveloper()) {
             GetRealD3D12Object(get(m_device), set(m_realDevice));
             if (get(m_realDevice) != get(m_device)) {
                 Log("Detected Streamline SDK\n");
@@ -988,7 +1524,16 @@ namespace {
             m_rtvHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 128);
             m_dsvHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 128);
             m_rvHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128 + MaxModelBuffers);
+            m_transientHeap.initialize(get(m_device),
+                                       D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+                                       NumInflightContexts,
+                                       MaxTransientDescriptorsPerContext);
             m_samplerHeap.initialize(get(m_device), D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+            if (configManager->getValue(config::SettingPipelineCache)) {
+                m_pipelineCache.initialize(get(m_device),
+                                           localAppData / "cache" / "d3d12_pipelines.bin",
+                                           configManager->getValue(config::SettingPipelineCachePreload));
+            }
             {
                 D3D12_QUERY_HEAP_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
@@ -1002,7 +1547,8 @@ namespace {
 
                 {
                     const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
-                    const auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(desc.Count * sizeof(uint64_t));
+                    const auto readbackDesc =
+                        CD3DX12_RESOURCE_DESC::Buffer(NumTimestampReadbacks * desc.Count * sizeof(uint64_t));
                     CHECK_HRCMD(m_device->CreateCommittedResource(&heapType,
                                                                   D3D12_HEAP_FLAG_NONE,
                                                                   &readbackDesc,
@@ -1033,31 +1579,14 @@ namespace {
                 m_context = m_commandList[0];
             }
 
-            // Initialize the D3D11on12 interop device that we need for text rendering.
-            // We use the text rendering primitives from the D3D11Device implmenentation (d3d11.cpp).
-            {
-                ComPtr<ID3D11Device> textDevice;
-                D3D_FEATURE_LEVEL featureLevel = {D3D_FEATURE_LEVEL_11_1};
-                CHECK_HRCMD(D3D11On12CreateDevice(device,
-                                                  D3D11_CREATE_DEVICE_SINGLETHREADED,
-                                                  &featureLevel,
-                                                  1,
-                                                  reinterpret_cast<IUnknown**>(&queue),
-                                                  1,
-                                                  0,
-                                                  set(textDevice),
-                                                  nullptr,
-                                                  nullptr));
-                CHECK_HRCMD(textDevice->QueryInterface(set(m_textInteropDevice)));
-
-                m_textDevice = WrapD3D11TextDevice(get(textDevice), configManager);
-            }
-
             CHECK_HRCMD(m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(set(m_fence))));
+            *m_fenceEvent.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
+            m_uploadRing.initialize(get(m_device), get(m_fence), [&]() { return m_fenceValue + 1; });
 
             initializeInterceptor();
             initializeShadingResources();
             initializeMeshResources();
+            initializeTextResources();
         }
 
         ~D3D12Device() override {
@@ -1066,16 +1595,29 @@ namespace {
         }
 
         void shutdown() override {
+            m_pipelineCache.serialize();
+            clearEventsCache();
+            {
+                std::unique_lock lock(m_deferredReleasesLock);
+                m_deferredReleases.clear();
+            }
+
             // Log some statistics for sizing.
-            DebugLog("heap statistics: samp=%u/%u, rtv=%u/%u, dsv=%u/%u, rv=%u/%u, query=%u/%u\n",
+            DebugLog("heap statistics: samp=%u/%u, rtv=%u(%u)/%u, dsv=%u(%u)/%u, rv=%u(%u)/%u, transient=%u/%u, "
+                     "query=%u/%u\n",
                      m_samplerHeap.heapOffset,
                      m_samplerHeap.heapSize,
+                     m_rtvHeap.numAllocated,
                      m_rtvHeap.heapOffset,
                      m_rtvHeap.heapSize,
+                     m_dsvHeap.numAllocated,
                      m_dsvHeap.heapOffset,
                      m_dsvHeap.heapSize,
+                     m_rvHeap.numAllocated,
                      m_rvHeap.heapOffset,
                      m_rvHeap.heapSize,
+                     m_transientHeap.peakUsage,
+                     m_transientHeap.regionSize,
                      m_nextGpuTimestampIndex,
                      ARRAYSIZE(m_queryBuffer));
 
@@ -1084,7 +1626,7 @@ namespace {
             m_currentQuadShader.reset();
             m_currentDrawRenderTarget.reset();
             m_currentDrawDepthBuffer.reset();
-            m_currentTextRenderTarget.reset();
+            m_textAtlasTexture.reset();
 
             m_currentMesh.reset();
             for (uint32_t i = 0; i < ARRAYSIZE(m_meshViewProjectionBuffer); i++) {
@@ -1152,14 +1694,20 @@ namespace {
         }
 
         void flushContext(bool blocking, bool isEndOfFrame = false) override {
-            if (isEndOfFrame) {
-                // Resolve the timers.
+            flushBarriers();
+
+            // Resolve the timers, unless the GPU is still using the readback slot (in which case the timers will be
+            // resolved with the next frame).
+            const auto readbackSlot = (m_timestampResolveSerial + 1) % NumTimestampReadbacks;
+            const bool resolveTimers = isEndOfFrame && m_nextGpuTimestampIndex &&
+                                       m_fence->GetCompletedValue() >= m_timestampResolveFenceValues[readbackSlot];
+            if (resolveTimers) {
                 m_context->ResolveQueryData(get(m_queryHeap),
                                             D3D12_QUERY_TYPE_TIMESTAMP,
                                             0,
                                             m_nextGpuTimestampIndex,
                                             get(m_queryReadbackBuffer),
-                                            0);
+                                            readbackSlot * sizeof(m_queryBuffer));
             }
 
             CHECK_HRCMD(m_context->Close());
@@ -1167,22 +1715,83 @@ namespace {
             ID3D12CommandList* const lists[] = {get(m_context)};
             m_queue->ExecuteCommandLists(ARRAYSIZE(lists), lists);
 
+            // Let the command allocator, the timers and the readbacks track the completion of the work.
+            m_queue->Signal(get(m_fence), ++m_fenceValue);
+            m_commandAllocatorFenceValues[m_currentContext] = m_fenceValue;
+            if (resolveTimers) {
+                m_timestampResolveFenceValues[readbackSlot] = m_fenceValue;
+                m_timestampResolveSerial++;
+            }
+
             if (blocking) {
-                m_queue->Signal(get(m_fence), ++m_fenceValue);
-                if (m_fence->GetCompletedValue() < m_fenceValue) {
-                    wil::unique_handle eventHandle;
-                    *eventHandle.put() = CreateEventEx(nullptr, L"flushContext Fence", 0, EVENT_ALL_ACCESS);
-                    CHECK_HRCMD(m_fence->SetEventOnCompletion(m_fenceValue, eventHandle.get()));
-                    WaitForSingleObject(eventHandle.get(), INFINITE);
+                waitForFence(m_fenceValue);
+            }
+
+            nextContext();
+
+            if (isEndOfFrame) {
+                // Do not hold onto the application resources for longer than a frame.
+                clearEventsCache();
+
+                m_textAtlas->nextFrame();
+            }
+
+            reclaimDeferredReleases();
+        }
+
+        void releaseDeferred(std::shared_ptr<void> resource) override {
+            if (!resource) {
+                return;
+            }
+
+            // The resource may be used by the commands recorded so far, which complete with the next fence value.
+            std::unique_lock lock(m_deferredReleasesLock);
+            m_deferredReleases.push_back(std::make_pair(m_fenceValue + 1, std::move(resource)));
+        }
+
+        uint64_t getSubmissionSerial() const override {
+            return m_fenceValue + 1;
+        }
+
+        bool isSubmissionCompleted(uint64_t serial) const override {
+            return m_fence->GetCompletedValue() >= serial;
+        }
+
+        void waitForSubmission(uint64_t serial) const override {
+            // The application may submit its work on another queue. Only the work that was flushed can be waited for.
+            if (serial <= m_fenceValue && m_fence->GetCompletedValue() < serial) {
+                CHECK_HRCMD(m_fence->SetEventOnCompletion(serial, nullptr));
+            }
+        }
+
+        // Record a transition. The transition is deferred until the next GPU command (see flushBarriers()), and merged
+        // with any pending transition of the same resource.
+        void transitionResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+            auto it = std::find_if(m_pendingBarriers.begin(), m_pendingBarriers.end(), [&](const auto& barrier) {
+                return barrier.Transition.pResource == resource;
+            });
+            if (it == m_pendingBarriers.end()) {
+                m_pendingBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, before, after));
+            } else {
+                assert(it->Transition.StateAfter == before);
+
+                // Collapse A->B->C into A->C, and drop the round trips A->B->A entirely.
+                if (it->Transition.StateBefore == after) {
+                    m_pendingBarriers.erase(it);
+                } else {
+                    it->Transition.StateAfter = after;
                 }
             }
+        }
 
-            if (++m_currentContext == NumInflightContexts) {
-                m_currentContext = 0;
+
+        // Record all the pending transitions at once. Must be invoked before any command that depends on the state of
+        // the resources.
+        void flushBarriers() const {
+            if (!m_pendingBarriers.empty()) {
+                m_context->ResourceBarrier((UINT)m_pendingBarriers.size(), m_pendingBarriers.data());
+                m_pendingBarriers.clear();
             }
-            CHECK_HRCMD(m_commandAllocator[m_currentContext]->Reset());
-            CHECK_HRCMD(m_commandList[m_currentContext]->Reset(get(m_commandAllocator[m_currentContext]), nullptr));
-            m_context = m_commandList[m_currentContext];
         }
 
         std::shared_ptr<ITexture> createTexture(const XrSwapchainCreateInfo& info,
@@ -1223,25 +1832,9 @@ namespace {
                 &heapType, D3D12_HEAP_FLAG_SHARED, &desc, initialState, nullptr, IID_PPV_ARGS(set(texture))));
 
             if (initialData) {
-                // Create an upload buffer.
-                ComPtr<ID3D12Resource> uploadBuffer;
-                {
-                    const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-                    const auto stagingDesc = CD3DX12_RESOURCE_DESC::Buffer(imageSize);
-                    CHECK_HRCMD(m_device->CreateCommittedResource(&heapType,
-                                                                  D3D12_HEAP_FLAG_NONE,
-                                                                  &stagingDesc,
-                                                                  D3D12_RESOURCE_STATE_GENERIC_READ,
-                                                                  nullptr,
-                                                                  IID_PPV_ARGS(set(uploadBuffer))));
-                    SetDebugName(get(uploadBuffer), std::string(debugName) + " Upload");
-                }
-                {
-                    void* mappedBuffer = nullptr;
-                    uploadBuffer->Map(0, nullptr, &mappedBuffer);
-                    memcpy(mappedBuffer, initialData, imageSize);
-                    uploadBuffer->Unmap(0, nullptr);
-                }
+                // Copy to the upload ring, which keeps the data alive until the GPU is done with the copy.
+                const auto allocation = m_uploadRing.allocate(imageSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+                memcpy(allocation.cpuAddress, initialData, imageSize);
 
                 // Do the upload now.
                 {
@@ -1252,12 +1845,13 @@ namespace {
                 {
                     D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
                     ZeroMemory(&footprint, sizeof(footprint));
+                    footprint.Offset = allocation.offset;
                     footprint.Footprint.Width = (UINT)desc.Width;
                     footprint.Footprint.Height = desc.Height;
                     footprint.Footprint.Depth = 1;
                     footprint.Footprint.RowPitch = rowPitch;
                     footprint.Footprint.Format = desc.Format;
-                    CD3DX12_TEXTURE_COPY_LOCATION src(get(uploadBuffer), footprint);
+                    CD3DX12_TEXTURE_COPY_LOCATION src(allocation.resource, footprint);
                     CD3DX12_TEXTURE_COPY_LOCATION dst(get(texture), 0);
                     m_context->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
                 }
@@ -1266,12 +1860,18 @@ namespace {
                         get(texture), D3D12_RESOURCE_STATE_COPY_DEST, initialState);
                     m_context->ResourceBarrier(1, &barrier);
                 }
-                flushContext(true);
             }
             SetDebugName(get(texture), debugName);
 
-            return std::make_shared<D3D12Texture>(
-                shared_from_this(), info, desc, get(texture), initialState, m_rtvHeap, m_dsvHeap, m_rvHeap);
+            return std::make_shared<D3D12Texture>(shared_from_this(),
+                                                  info,
+                                                  desc,
+                                                  get(texture),
+                                                  initialState,
+                                                  m_rtvHeap,
+                                                  m_dsvHeap,
+                                                  m_rvHeap,
+                                                  m_uploadRing);
         }
 
         std::shared_ptr<IShaderBuffer>
@@ -1290,30 +1890,13 @@ namespace {
                                                               IID_PPV_ARGS(set(buffer))));
             }
 
-            // Create an upload buffer.
-            ComPtr<ID3D12Resource> uploadBuffer;
-            if (initialData || !immutable) {
-                const auto& heapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-                CHECK_HRCMD(m_device->CreateCommittedResource(&heapType,
-                                                              D3D12_HEAP_FLAG_NONE,
-                                                              &desc,
-                                                              D3D12_RESOURCE_STATE_GENERIC_READ,
-                                                              nullptr,
-                                                              IID_PPV_ARGS(set(uploadBuffer))));
-                SetDebugName(get(uploadBuffer), std::string(debugName) + " Upload");
-            }
             SetDebugName(get(buffer), debugName);
 
-            auto result = std::make_shared<D3D12Buffer>(shared_from_this(),
-                                                        desc,
-                                                        get(buffer),
-                                                        D3D12_RESOURCE_STATE_COMMON,
-                                                        m_rvHeap,
-                                                        !immutable ? get(uploadBuffer) : nullptr);
+            auto result = std::make_shared<D3D12Buffer>(
+                shared_from_this(), desc, get(buffer), D3D12_RESOURCE_STATE_COMMON, m_rvHeap, m_uploadRing, immutable);
 
             if (initialData) {
-                result->uploadData(initialData, size, get(uploadBuffer));
-                flushContext(true);
+                result->uploadInitialData(initialData, size);
             }
 
             return result;
@@ -1340,29 +1923,24 @@ namespace {
                                                       std::string_view debugName,
                                                       const D3D_SHADER_MACRO* defines,
                                                       std::filesystem::path includePath = "") override {
-            ComPtr<ID3DBlob> psBytes;
-            if (!includePath.empty()) {
-                utilities::shader::IncludeHeader includes({std::move(includePath)});
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(psBytes), defines, &includes, "ps_5_0");
-            } else {
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(psBytes), defines, nullptr, "ps_5_0");
-            }
-
             D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
             ZeroMemory(&desc, sizeof(desc));
             desc.VS = {reinterpret_cast<BYTE*>(m_quadVertexShaderBytes->GetBufferPointer()),
                        m_quadVertexShaderBytes->GetBufferSize()};
-            desc.PS = {reinterpret_cast<BYTE*>(psBytes->GetBufferPointer()), psBytes->GetBufferSize()};
             desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
             desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
             desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
             desc.SampleMask = UINT_MAX;
             desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-            // The rest of the descriptor will be filled up by D3D12QuadShader.
+            // The pixel shader and the rest of the descriptor will be filled up by D3D12QuadShader.
 
-            return std::make_shared<D3D12QuadShader>(shared_from_this(), desc, get(psBytes), debugName);
+            return std::make_shared<D3D12QuadShader>(
+                shared_from_this(),
+                m_pipelineCache,
+                desc,
+                utilities::shader::CompileShaderAsync(
+                    shaderFile, entryPoint, defines, includePath, "ps_5_0", m_usePrecompiledShaders),
+                debugName);
         }
 
         std::shared_ptr<IComputeShader> createComputeShader(const std::filesystem::path& shaderFile,
@@ -1371,23 +1949,18 @@ namespace {
                                                             const std::array<unsigned int, 3>& threadGroups,
                                                             const D3D_SHADER_MACRO* defines,
                                                             std::filesystem::path includePath = "") override {
-            ComPtr<ID3DBlob> csBytes;
-            if (!includePath.empty()) {
-                utilities::shader::IncludeHeader includes({std::move(includePath)});
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(csBytes), defines, &includes, "cs_5_0");
-            } else {
-                utilities::shader::CompileShader(
-                    shaderFile, entryPoint.c_str(), set(csBytes), defines, nullptr, "cs_5_0");
-            }
-
             D3D12_COMPUTE_PIPELINE_STATE_DESC desc;
             ZeroMemory(&desc, sizeof(desc));
-            desc.CS = {reinterpret_cast<BYTE*>(csBytes->GetBufferPointer()), csBytes->GetBufferSize()};
-            // The rest of the descriptor will be filled up by D3D12ComputeShader.
+            // The compute shader and the rest of the descriptor will be filled up by D3D12ComputeShader.
 
             return std::make_shared<D3D12ComputeShader>(
-                shared_from_this(), desc, get(csBytes), debugName, threadGroups);
+                shared_from_this(),
+                m_pipelineCache,
+                desc,
+                utilities::shader::CompileShaderAsync(
+                    shaderFile, entryPoint, defines, includePath, "cs_5_0", m_usePrecompiledShaders),
+                debugName,
+                threadGroups);
         }
 
         std::shared_ptr<IGpuTimer> createTimer() override {
@@ -1398,28 +1971,51 @@ namespace {
                 shared_from_this(),
                 get(m_queryHeap),
                 [&](UINT startIndex, UINT stopIndex) { return queryTimeStampDelta(startIndex, stopIndex); },
+                [&]() { return m_timestampResolveSerial + 1; },
+                [&]() { return m_completedTimestampResolveSerial; },
                 startGpuTimestampIndex,
                 stopGpuTimestampIndex);
         }
 
-        void setShader(std::shared_ptr<IQuadShader> shader, SamplerType sampler) override {
-            m_currentQuadShader.reset();
-            m_currentComputeShader.reset();
-            m_currentRootSlot = 0;
+        void beginProfileScope(std::string_view name) override {
+            // Unicode markers, as understood by PIX.
+            const std::wstring wname(name.begin(), name.end());
+            m_context->BeginEvent(0, wname.c_str(), (UINT)((wname.size() + 1) * sizeof(wchar_t)));
+            if (auto profiler = m_profiler.lock()) {
+                profiler->beginScope(name);
+            }
+        }
 
-            ID3D12DescriptorHeap* const heaps[] = {
-                get(m_rvHeap.heap),
-                get(m_samplerHeap.heap),
-            };
-            m_context->SetDescriptorHeaps(ARRAYSIZE(heaps), heaps);
+        void endProfileScope() override {
+            if (auto profiler = m_profiler.lock()) {
+                profiler->endScope();
+            }
+            m_context->EndEvent();
+        }
+
+        void setProfiler(std::shared_ptr<IGpuProfiler> profiler) override {
+            m_profiler = profiler;
+        }
+
+        std::shared_ptr<ITextureReadback> createTextureReadback(const XrSwapchainCreateInfo& info) override {
+            return std::make_shared<D3D12TextureReadback>(
+                shared_from_this(), info, get(m_fence), [&]() { return m_fenceValue + 1; });
+        }
+
+        void setShader(std::shared_ptr<IQuadShader> shader, SamplerType sampler) override {
+            m_currentQuadShader.reset();
+            m_currentComputeShader.reset();
+            m_currentRootSlot = 0;
+
+            setDescriptorHeaps();
 
             auto d3d12Shader = dynamic_cast<D3D12Shader*>(shader.get());
             if (!d3d12Shader->needsResolve()) {
                 // Prepare to draw the quad.
                 const auto shaderData = shader->getAs<D3D12>();
                 // TODO: This code is duplicated in D3D12QuadShader::resolve().
-                m_context->SetGraphicsRootSignature(shaderData->rootSignature);
-                m_context->SetPipelineState(shaderData->pipelineState);
+                setGraphicsRootSignature(shaderData->rootSignature);
+                setPipelineState(shaderData->pipelineState);
                 m_context->IASetIndexBuffer(nullptr);
                 m_context->IASetVertexBuffers(0, 0, nullptr);
                 m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
@@ -1438,17 +2034,13 @@ namespace {
             m_currentComputeShader.reset();
             m_currentRootSlot = 0;
 
-            ID3D12DescriptorHeap* const heaps[] = {
-                get(m_rvHeap.heap),
-                get(m_samplerHeap.heap),
-            };
-            m_context->SetDescriptorHeaps(ARRAYSIZE(heaps), heaps);
+            setDescriptorHeaps();
 
             auto d3d12Shader = dynamic_cast<D3D12Shader*>(shader.get());
             if (!d3d12Shader->needsResolve()) {
                 const auto shaderData = shader->getAs<D3D12>();
-                m_context->SetComputeRootSignature(shaderData->rootSignature);
-                m_context->SetPipelineState(shaderData->pipelineState);
+                setComputeRootSignature(shaderData->rootSignature);
+                setPipelineState(shaderData->pipelineState);
                 // TODO: This is somewhat restrictive, but for now we only support a linear sampler in slot 0.
                 m_context->SetComputeRootDescriptorTable(m_currentRootSlot++,
                                                          m_samplerHeap.getGPUHandle(m_samplers[to_integral(sampler)]));
@@ -1472,7 +2064,7 @@ namespace {
                 m_currentShaderResources.push_back(input);
 
                 const auto pView = input->getShaderResourceView(slice)->getAs<D3D12>();
-                const auto descriptorHandle = m_rvHeap.getGPUHandle(*pView);
+                const auto descriptorHandle = m_transientHeap.copy(pView, 1);
                 if (!d3d12Shader->needsResolve()) {
                     if (m_currentComputeShader) {
                         m_context->SetComputeRootDescriptorTable(m_currentRootSlot++, descriptorHandle);
@@ -1496,7 +2088,8 @@ namespace {
                 m_currentShaderResources2.push_back(input);
 
                 const auto pBuffer = dynamic_cast<D3D12Buffer*>(input.get());
-                const auto descriptorHandle = m_rvHeap.getGPUHandle(pBuffer->getConstantBufferView());
+                const auto constantBufferView = pBuffer->getConstantBufferView();
+                const auto descriptorHandle = m_transientHeap.copy(&constantBufferView, 1);
                 if (!d3d12Shader->needsResolve()) {
                     if (m_currentComputeShader) {
                         m_context->SetComputeRootDescriptorTable(m_currentRootSlot++, descriptorHandle);
@@ -1511,10 +2104,13 @@ namespace {
             }
         }
 
-        void setShaderOutput(uint32_t slot, std::shared_ptr<ITexture> output, int32_t slice) override {
+        void setShaderOutput(uint32_t slot,
+                             std::shared_ptr<ITexture> output,
+                             int32_t slice,
+                             const XrRect2Di* viewport) override {
             if (m_currentQuadShader) {
                 if (!slot) {
-                    setRenderTargets(1, &output, &slice);
+                    setRenderTargets(1, &output, &slice, viewport);
                     auto d3d12Shader = dynamic_cast<D3D12Shader*>(m_currentQuadShader.get());
                     if (d3d12Shader->needsResolve()) {
                         d3d12Shader->setOutputFormat(output->getInfo());
@@ -1527,7 +2123,7 @@ namespace {
                 m_currentShaderResources.push_back(output);
 
                 const auto pView = output->getUnorderedAccessView(slice)->getAs<D3D12>();
-                auto descriptorHandle = m_rvHeap.getGPUHandle(*pView);
+                auto descriptorHandle = m_transientHeap.copy(pView, 1);
                 auto d3d12Shader = dynamic_cast<D3D12Shader*>(m_currentComputeShader.get());
                 if (!d3d12Shader->needsResolve()) {
                     m_context->SetComputeRootDescriptorTable(m_currentRootSlot++, descriptorHandle);
@@ -1547,7 +2143,11 @@ namespace {
                 // The first time, we need to resolve the root signature and create the pipeline state.
                 if (d3d12Shader->needsResolve()) {
                     d3d12Shader->resolve();
+
+                    // The pipeline was set up without going through the cache below.
+                    m_commandListState = {};
                 }
+                flushBarriers();
                 if (m_currentQuadShader) {
                     m_context->DrawInstanced(3, 1, 0, 0);
 
@@ -1661,21 +2261,16 @@ namespace {
 
         void clearColor(float top, float left, float bottom, float right, const XrColor4f& color) const override {
             if (m_currentDrawRenderTarget) {
-                // When rendering text, we must use the corresponding device.
-                if (!m_isRenderingText) {
-                    const auto rect =
-                        CD3DX12_RECT(m_currentDrawRenderTargetViewport.offset.x + static_cast<LONG>(left),
-                                     m_currentDrawRenderTargetViewport.offset.y + static_cast<LONG>(top),
-                                     m_currentDrawRenderTargetViewport.offset.x + static_cast<LONG>(right),
-                                     m_currentDrawRenderTargetViewport.offset.y + static_cast<LONG>(bottom));
-                    auto renderTargetView =
-                        m_currentDrawRenderTarget->getRenderTargetView(m_currentDrawRenderTargetSlice)->getAs<D3D12>();
-
-                    // XrColor4f components are in the expected order
-                    m_context->ClearRenderTargetView(*renderTargetView, &color.r, 1, &rect);
-                } else {
-                    m_textDevice->clearColor(top, left, bottom, right, color);
-                }
+                const auto rect = CD3DX12_RECT(m_currentDrawRenderTargetViewport.offset.x + static_cast<LONG>(left),
+                                               m_currentDrawRenderTargetViewport.offset.y + static_cast<LONG>(top),
+                                               m_currentDrawRenderTargetViewport.offset.x + static_cast<LONG>(right),
+                                               m_currentDrawRenderTargetViewport.offset.y + static_cast<LONG>(bottom));
+                auto renderTargetView =
+                    m_currentDrawRenderTarget->getRenderTargetView(m_currentDrawRenderTargetSlice)->getAs<D3D12>();
+
+                // XrColor4f components are in the expected order
+                flushBarriers();
+                m_context->ClearRenderTargetView(*renderTargetView, &color.r, 1, &rect);
             }
         }
 
@@ -1684,6 +2279,7 @@ namespace {
                 auto depthStencilView =
                     m_currentDrawDepthBuffer->getDepthStencilView(m_currentDrawDepthBufferSlice)->getAs<D3D12>();
 
+                flushBarriers();
                 m_context->ClearDepthStencilView(*depthStencilView, D3D12_CLEAR_FLAG_DEPTH, value, 0, 0, nullptr);
             }
         }
@@ -1715,72 +2311,9 @@ namespace {
             if (!meshData)
                 return;
 
-            auto& pso = noCulling ? m_meshRendererNoCullingPipelineState : m_meshRendererPipelineState;
-
             if (mesh != m_currentMesh) {
-                // Lazily construct the pipeline state now that we know the format for the render target and whether
-                // depth is inverted.
-                // TODO: We must support the RTV format changing.
-                if (!pso) {
-                    D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
-                    ZeroMemory(&desc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
-                    desc.InputLayout = {m_meshRendererInputLayout.data(), (UINT)m_meshRendererInputLayout.size()};
-                    desc.pRootSignature = get(m_meshRendererRootSignature);
-                    desc.VS = {reinterpret_cast<BYTE*>(m_meshRendererVertexShaderBytes->GetBufferPointer()),
-                               m_meshRendererVertexShaderBytes->GetBufferSize()};
-                    desc.PS = {reinterpret_cast<BYTE*>(m_meshRendererPixelShaderBytes->GetBufferPointer()),
-                               m_meshRendererPixelShaderBytes->GetBufferSize()};
-                    desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-                    desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-                    desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-                    if (m_currentDrawDepthBufferIsInverted) {
-                        desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-                        desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER;
-                    }
-                    desc.SampleMask = UINT_MAX;
-                    desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-                    desc.NumRenderTargets = 1;
-                    desc.RTVFormats[0] = (DXGI_FORMAT)m_currentDrawRenderTarget->getInfo().format;
-                    desc.SampleDesc.Count = m_currentDrawRenderTarget->getInfo().sampleCount;
-                    if (desc.SampleDesc.Count > 1) {
-                        D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS qualityLevels;
-                        qualityLevels.Format = desc.RTVFormats[0];
-                        qualityLevels.SampleCount = desc.SampleDesc.Count;
-                        qualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
-                        CHECK_HRCMD(m_device->CheckFeatureSupport(
-                            D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &qualityLevels, sizeof(qualityLevels)));
-
-                        // Setup for highest quality multisampling if requested.
-                        desc.SampleDesc.Quality = qualityLevels.NumQualityLevels - 1;
-                        desc.RasterizerState.MultisampleEnable = true;
-                    }
-                    if (noCulling) {
-                        desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-                    }
-                    if (m_currentDrawDepthBuffer) {
-                        desc.DSVFormat = (DXGI_FORMAT)m_currentDrawDepthBuffer->getInfo().format;
-                    }
-                    CHECK_HRCMD(
-                        m_device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(set(pso))));
-                }
-
-                m_context->SetPipelineState(get(pso));
-                m_context->SetGraphicsRootSignature(get(m_meshRendererRootSignature));
+                setMeshPipelineState(meshData, false /* isInstanced */, noCulling);
                 m_context->IASetVertexBuffers(0, 1, meshData->vertexBuffer);
-                m_context->IASetIndexBuffer(meshData->indexBuffer);
-                m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-                ID3D12DescriptorHeap* const heaps[] = {
-                    get(m_rvHeap.heap),
-                };
-                m_context->SetDescriptorHeaps(ARRAYSIZE(heaps), heaps);
-
-                {
-                    auto d3d12Buffer =
-                        dynamic_cast<D3D12Buffer*>(m_meshViewProjectionBuffer[m_currentMeshViewProjectionBuffer].get());
-                    const auto& handle = d3d12Buffer->getConstantBufferView();
-                    m_context->SetGraphicsRootDescriptorTable(1, m_rvHeap.getGPUHandle(handle));
-                }
 
                 m_currentMesh = mesh;
             }
@@ -1804,12 +2337,48 @@ namespace {
             {
                 auto d3d12Buffer = dynamic_cast<D3D12Buffer*>(m_meshModelBuffer[m_currentMeshModelBuffer].get());
                 const auto& handle = d3d12Buffer->getConstantBufferView();
-                m_context->SetGraphicsRootDescriptorTable(0, m_rvHeap.getGPUHandle(handle));
+                m_context->SetGraphicsRootDescriptorTable(0, m_transientHeap.copy(&handle, 1));
             }
 
+            flushBarriers();
             m_context->DrawIndexedInstanced(meshData->numIndices, 1, 0, 0, 0);
         }
 
+        void drawInstanced(std::shared_ptr<ISimpleMesh> mesh,
+                           const std::vector<SimpleMeshInstance>& instances,
+                           bool noCulling) override {
+            auto meshData = mesh->getAs<D3D12>();
+            if (!meshData || instances.empty()) {
+                return;
+            }
+
+            // The model matrices are read directly from the upload ring.
+            const UINT64 instancesSize = instances.size() * sizeof(MeshInstance);
+            const auto allocation = m_uploadRing.allocate(instancesSize, sizeof(float));
+            auto meshInstances = reinterpret_cast<MeshInstance*>(allocation.cpuAddress);
+            for (size_t i = 0; i < instances.size(); i++) {
+                const auto& instance = instances[i];
+                const DirectX::XMMATRIX scaleMatrix =
+                    DirectX::XMMatrixScaling(instance.scaling.x, instance.scaling.y, instance.scaling.z);
+                DirectX::XMStoreFloat4x4(&meshInstances[i].Model, scaleMatrix * xr::math::LoadXrPose(instance.pose));
+            }
+
+            D3D12_VERTEX_BUFFER_VIEW vertexBuffers[2];
+            vertexBuffers[0] = *meshData->vertexBuffer;
+            vertexBuffers[1].BufferLocation = allocation.resource->GetGPUVirtualAddress() + allocation.offset;
+            vertexBuffers[1].SizeInBytes = (UINT)instancesSize;
+            vertexBuffers[1].StrideInBytes = sizeof(MeshInstance);
+
+            setMeshPipelineState(meshData, true /* isInstanced */, noCulling);
+            m_context->IASetVertexBuffers(0, ARRAYSIZE(vertexBuffers), vertexBuffers);
+
+            flushBarriers();
+            m_context->DrawIndexedInstanced(meshData->numIndices, (UINT)instances.size(), 0, 0, 0);
+
+            // The mesh pipeline state must be restored on the next draw().
+            m_currentMesh.reset();
+        }
+
         float drawString(std::wstring_view string,
                          TextStyle style,
                          float size,
@@ -1818,7 +2387,41 @@ namespace {
                          uint32_t color,
                          bool measure,
                          int alignment) override {
-            return m_textDevice->drawString(string, style, size, x, y, color, measure, alignment);
+            const bool needWidth = measure || (alignment & (FW1_CENTER | FW1_RIGHT));
+            const float width = needWidth ? m_textAtlas->measureString(string, style, size) : 0.f;
+
+            float penX = x;
+            if (alignment & FW1_CENTER) {
+                penX -= width / 2;
+            } else if (alignment & FW1_RIGHT) {
+                penX -= width;
+            }
+            const float penY = std::floor(y);
+
+            // Queue one instance per visible glyph. They are all drawn at once in flushText().
+            for (const auto c : string) {
+                const auto glyph = m_textAtlas->getGlyph(c, style, size);
+                if (!glyph) {
+                    continue;
+                }
+
+                if (glyph->width && glyph->height) {
+                    GlyphInstance instance;
+                    instance.Rect[0] = std::floor(penX) + glyph->offsetX;
+                    instance.Rect[1] = penY + glyph->offsetY;
+                    instance.Rect[2] = instance.Rect[0] + glyph->width;
+                    instance.Rect[3] = instance.Rect[1] + glyph->height;
+                    instance.TexCoord[0] = glyph->u0;
+                    instance.TexCoord[1] = glyph->v0;
+                    instance.TexCoord[2] = glyph->u1;
+                    instance.TexCoord[3] = glyph->v1;
+                    instance.Color = color;
+                    m_textGlyphs.push_back(instance);
+                }
+                penX += glyph->advance;
+            }
+
+            return measure ? width : 0.0f;
         }
 
         float drawString(std::string_view string,
@@ -1829,95 +2432,158 @@ namespace {
                          uint32_t color,
                          bool measure,
                          int alignment) override {
-            return m_textDevice->drawString(string, style, size, x, y, color, measure, alignment);
+            // fast path, use the stack for most of our strings
+            auto src = reinterpret_cast<const uint8_t*>(string.data());
+            if (string.size() < size_t(64)) {
+                wchar_t buf[64];
+                std::copy_n(src, string.size(), buf)[0] = '\0';
+                return drawString(std::wstring_view(buf, string.size()), style, size, x, y, color, measure, alignment);
+            }
+            return drawString(std::wstring(src, src + string.size()), style, size, x, y, color, measure, alignment);
         }
 
         float measureString(std::wstring_view string, TextStyle style, float size) const override {
-            return m_textDevice->measureString(string, style, size);
+            return m_textAtlas->measureString(string, style, size);
         }
 
         float measureString(std::string_view string, TextStyle style, float size) const override {
-            return m_textDevice->measureString(string, style, size);
+            // fast path, use the stack for most of our strings
+            auto src = reinterpret_cast<const uint8_t*>(string.data());
+            if (string.size() < size_t(64)) {
+                wchar_t buf[64];
+                std::copy_n(src, string.size(), buf)[0] = '\0';
+                return measureString(std::wstring_view(buf, string.size()), style, size);
+            }
+            return measureString(std::wstring(src, src + string.size()), style, size);
         }
 
         void beginText(bool mustKeepOldContent) override {
-            // Grab the interop version of the render target texture...
-            auto d3d12DrawRenderTarget = dynamic_cast<D3D12Texture*>(m_currentDrawRenderTarget.get());
-            m_currentTextRenderTarget = d3d12DrawRenderTarget->getInteropTexture();
-            if (!m_currentTextRenderTarget) {
-                // ...or create it if needed.
-                ComPtr<ID3D11Texture2D> interopTexture;
-                D3D11_RESOURCE_FLAGS flags;
-                ZeroMemory(&flags, sizeof(flags));
-                flags.BindFlags = D3D11_BIND_RENDER_TARGET;
-
-                std::shared_ptr<ITexture> copyTexture;
-                auto copyInfo = m_currentDrawRenderTarget->getInfo();
-
-                // On certain runtimes, we cannot use the swapchain images directly with D3D11on12. Use an
-                // intermediate copy.
-                if (m_needInteropCopy) {
-                    copyInfo.usageFlags |= XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
-                    copyTexture = createTexture(copyInfo, "Render Target Interop Copy TEX2D");
-                }
+            // We draw directly into the render target, so the old content is always kept.
+            m_textGlyphs.clear();
+        }
 
-                CHECK_HRCMD(m_textInteropDevice->CreateWrappedResource(
-                    copyTexture ? copyTexture->getAs<D3D12>() : m_currentDrawRenderTarget->getAs<D3D12>(),
-                    &flags,
-                    D3D12_RESOURCE_STATE_RENDER_TARGET,
-                    D3D12_RESOURCE_STATE_RENDER_TARGET,
-                    IID_PPV_ARGS(set(interopTexture))));
+        void flushText() override {
+            if (m_textGlyphs.empty() || !m_currentDrawRenderTarget) {
+                m_textGlyphs.clear();
+                return;
+            }
 
-                m_currentTextRenderTarget =
-                    WrapD3D11Texture(m_textDevice, copyInfo, get(interopTexture), "Render Target Interop TEX2D");
+            // Lazily create the atlas texture, since we cannot create textures from the constructor.
+            if (!m_textAtlasTexture) {
+                XrSwapchainCreateInfo info;
+                ZeroMemory(&info, sizeof(info));
+                info.width = m_textAtlas->getWidth();
+                info.height = m_textAtlas->getHeight();
+                info.format = DXGI_FORMAT_R8_UNORM;
+                info.arraySize = 1;
+                info.mipCount = 1;
+                info.sampleCount = 1;
+                info.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+                m_textAtlasTexture = createTexture(info, "Glyph Atlas TEX2D");
+            }
+            if (m_textAtlas->isDirty()) {
+                m_textAtlasTexture->uploadData(m_textAtlas->getPixels().data(), m_textAtlas->getWidth());
+                m_textAtlas->clearDirty();
+            }
+
+            // Lazily construct the pipeline state now that we know the format for the render target.
+            const auto& renderTargetInfo = m_currentDrawRenderTarget->getInfo();
+            const auto depthFormat = m_currentDrawDepthBuffer
+                                         ? (DXGI_FORMAT)m_currentDrawDepthBuffer->getInfo().format
+                                         : DXGI_FORMAT_UNKNOWN;
+            auto& pso = m_textPipelineStates[std::make_tuple(
+                (DXGI_FORMAT)renderTargetInfo.format, depthFormat, renderTargetInfo.sampleCount)];
+            if (!pso) {
+                D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+                ZeroMemory(&desc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
+                desc.InputLayout = {m_textInputLayout.data(), (UINT)m_textInputLayout.size()};
+                desc.pRootSignature = get(m_textRootSignature);
+                desc.VS = {reinterpret_cast<BYTE*>(m_textVertexShaderBytes->GetBufferPointer()),
+                           m_textVertexShaderBytes->GetBufferSize()};
+                desc.PS = {reinterpret_cast<BYTE*>(m_textPixelShaderBytes->GetBufferPointer()),
+                           m_textPixelShaderBytes->GetBufferSize()};
+                desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+                desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+                desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+                {
+                    auto& blend = desc.BlendState.RenderTarget[0];
+                    blend.BlendEnable = TRUE;
+                    blend.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+                    blend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+                    blend.BlendOp = D3D12_BLEND_OP_ADD;
+                    blend.SrcBlendAlpha = D3D12_BLEND_ONE;
+                    blend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+                    blend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+                }
+                desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+                desc.DepthStencilState.DepthEnable = FALSE;
+                desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+                desc.SampleMask = UINT_MAX;
+                desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+                desc.NumRenderTargets = 1;
+                desc.RTVFormats[0] = (DXGI_FORMAT)renderTargetInfo.format;
+                desc.DSVFormat = depthFormat;
+                desc.SampleDesc.Count = renderTargetInfo.sampleCount;
+                if (desc.SampleDesc.Count > 1) {
+                    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS qualityLevels;
+                    qualityLevels.Format = desc.RTVFormats[0];
+                    qualityLevels.SampleCount = desc.SampleDesc.Count;
+                    qualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
+                    CHECK_HRCMD(m_device->CheckFeatureSupport(
+                        D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &qualityLevels, sizeof(qualityLevels)));
 
-                d3d12DrawRenderTarget->setInteropTexture(m_currentTextRenderTarget, copyTexture);
-            }
-            // If an intermediate copy is needed, we must copy the previous content of the image first.
-            if (m_needInteropCopy && mustKeepOldContent) {
-                // TODO: Texture arrays?
-                d3d12DrawRenderTarget->copyTo(d3d12DrawRenderTarget->getInteropCopyTexture());
-            }
-            {
-                ID3D11Resource* const resources[] = {m_currentTextRenderTarget->getAs<D3D11>()};
-                m_textInteropDevice->AcquireWrappedResources(resources, ARRAYSIZE(resources));
+                    desc.SampleDesc.Quality = qualityLevels.NumQualityLevels - 1;
+                    desc.RasterizerState.MultisampleEnable = true;
+                }
+                pso = m_pipelineCache.createGraphicsPipelineState(get(m_device), desc, m_textRootSignatureHash);
             }
 
-            // Serialize between the parent queue and interop context.
-            flushContext(false, false);
+            beginProfileScope("Text");
 
-            // Setup the interop context for rendering.
-            m_textDevice->setRenderTargets(
-                1, &m_currentTextRenderTarget, &m_currentDrawRenderTargetSlice, &m_currentDrawRenderTargetViewport);
-            m_textDevice->beginText();
-            m_isRenderingText = true;
-        }
+            // The instances are read directly from the upload ring.
+            const UINT64 instancesSize = m_textGlyphs.size() * sizeof(GlyphInstance);
+            const auto allocation = m_uploadRing.allocate(instancesSize, sizeof(float));
+            memcpy(allocation.cpuAddress, m_textGlyphs.data(), instancesSize);
 
-        void flushText() override {
-            m_textDevice->flushText();
-            m_textDevice->unsetRenderTargets();
-            // Commit to the D3D12 queue.
-            m_textDevice->flushContext();
-            {
-                ID3D11Resource* const resources[] = {m_currentTextRenderTarget->getAs<D3D11>()};
-                m_textInteropDevice->ReleaseWrappedResources(resources, ARRAYSIZE(resources));
-            }
-            // If a copy to the real render target is needed, do it now.
-            auto d3d12DrawRenderTarget = dynamic_cast<D3D12Texture*>(m_currentDrawRenderTarget.get());
-            auto copyTexture = d3d12DrawRenderTarget->getInteropCopyTexture();
-            if (copyTexture) {
-                copyTexture->copyTo(m_currentDrawRenderTarget);
-            }
-            m_currentTextRenderTarget.reset();
-            m_isRenderingText = false;
+            D3D12_VERTEX_BUFFER_VIEW vertexBuffer;
+            vertexBuffer.BufferLocation = allocation.resource->GetGPUVirtualAddress() + allocation.offset;
+            vertexBuffer.SizeInBytes = (UINT)instancesSize;
+            vertexBuffer.StrideInBytes = sizeof(GlyphInstance);
+
+            m_textAtlasTexture->pushState(D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+            setPipelineState(get(pso));
+            setGraphicsRootSignature(get(m_textRootSignature));
+            m_context->IASetVertexBuffers(0, 1, &vertexBuffer);
+            m_context->IASetIndexBuffer(nullptr);
+            m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+            setDescriptorHeaps();
+
+            const float invViewportSize[2] = {1.f / m_currentDrawRenderTargetViewport.extent.width,
+                                              1.f / m_currentDrawRenderTargetViewport.extent.height};
+            m_context->SetGraphicsRoot32BitConstants(0, 2, invViewportSize, 0);
+            m_context->SetGraphicsRootDescriptorTable(
+                1, m_transientHeap.copy(m_textAtlasTexture->getShaderResourceView()->getAs<D3D12>(), 1));
+
+            flushBarriers();
+            m_context->DrawInstanced(4, (UINT)m_textGlyphs.size(), 0, 0);
+            endProfileScope();
+
+            m_textAtlasTexture->popState();
+            m_textGlyphs.clear();
+
+            // The mesh pipeline state must be restored on the next draw().
+            m_currentMesh.reset();
         }
 
         void setMipMapBias(config::MipMapBias biasing, float bias = 0.f) override {
             // TODO: Implement mip-map bias.
         }
 
-        uint32_t getNumBiasedSamplersThisFrame() const override {
+        uint32_t getNumBiasedSamplersThisFrame(uint32_t& numCreated) const override {
             // TODO: Implement mip-map bias.
+            numCreated = 0;
             return 0;
         }
 
@@ -1926,12 +2592,28 @@ namespace {
                 return;
             }
 
-            // Readback the previous set of timers. The queries are resolved in flushContext().
-            uint64_t* mappedBuffer;
-            D3D12_RANGE range{0, sizeof(uint64_t) * m_nextGpuTimestampIndex};
-            CHECK_HRCMD(m_queryReadbackBuffer->Map(0, &range, reinterpret_cast<void**>(&mappedBuffer)));
-            memcpy(m_queryBuffer, mappedBuffer, range.End);
-            m_queryReadbackBuffer->Unmap(0, nullptr);
+            // Readback the most recent set of timers that the GPU has finished resolving. The queries are resolved in
+            // flushContext().
+            const auto completedFenceValue = m_fence->GetCompletedValue();
+            for (uint64_t serial = m_timestampResolveSerial;
+                 serial > m_completedTimestampResolveSerial &&
+                 serial + NumTimestampReadbacks > m_timestampResolveSerial;
+                 serial--) {
+                const auto readbackSlot = serial % NumTimestampReadbacks;
+                if (completedFenceValue < m_timestampResolveFenceValues[readbackSlot]) {
+                    continue;
+                }
+
+                uint8_t* mappedBuffer;
+                const size_t offset = readbackSlot * sizeof(m_queryBuffer);
+                D3D12_RANGE range{offset, offset + sizeof(uint64_t) * m_nextGpuTimestampIndex};
+                CHECK_HRCMD(m_queryReadbackBuffer->Map(0, &range, reinterpret_cast<void**>(&mappedBuffer)));
+                memcpy(m_queryBuffer, mappedBuffer + offset, range.End - range.Begin);
+                m_queryReadbackBuffer->Unmap(0, nullptr);
+
+                m_completedTimestampResolveSerial = serial;
+                break;
+            }
         }
 
         void blockCallbacks() override {
@@ -1954,10 +2636,37 @@ namespace {
             m_copyTextureEvent = event;
         }
 
+        void registerClearDepthEvent(ClearDepthEvent event) override {
+            // Not supported: our draws are recorded on our own command list and cannot be ordered with the
+            // application's command lists.
+        }
+
+        void setEventsFilter(const EventsFilter& filter) override {
+            m_eventsFilter = filter;
+        }
+
+        // The hooks are attached for the whole session: detaching one would reset its original function pointer
+        // while an application thread may still be calling through it. Without a subscription, a hook only forwards
+        // the call to the runtime (see isInterceptedCallSubscribed()).
+        void subscribeInterceptedCall(InterceptedCall call) override {
+            m_interceptedCallSubscriptions[to_integral(call)]++;
+        }
+
+        void unsubscribeInterceptedCall(InterceptedCall call) override {
+            auto& subscriptions = m_interceptedCallSubscriptions[to_integral(call)];
+            if (subscriptions) {
+                subscriptions--;
+            }
+        }
+
         void getVRAMUsage(uint64_t& usage, uint8_t& percentUsed) const {
             utilities::GetVRAMUsage(m_adapter, usage, percentUsed);
         }
 
+        ComPtr<IDXGIAdapter> getAdapter() const override {
+            return m_adapter;
+        }
+
         bool isEventsSupported() const override {
             return m_allowInterceptor;
         }
@@ -1989,50 +2698,96 @@ namespace {
 
             g_instance = this;
 
-            ComPtr<ID3D12GraphicsCommandList> realContext;
-            GetRealD3D12Object(get(m_context), set(realContext));
-
-            // Hook to the Direct3D device and command list  to intercept preparation for the rendering.
-            DetourMethodAttach(get(realContext),
-                               // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
-                               46,
-                               hooked_ID3D12GraphicsCommandList_OMSetRenderTargets,
-                               g_original_ID3D12GraphicsCommandList_OMSetRenderTargets);
+            // The render target views are always tracked, since the application creates most of them before any
+            // subsystem subscribes to the render targets.
             DetourMethodAttach(get(m_realDevice),
                                // Method offset is 7 + method index (0-based) for ID3D12Device.
                                20,
                                hooked_ID3D12Device_CreateRenderTargetView,
                                g_original_ID3D12Device_CreateRenderTargetView);
-            DetourMethodAttach(get(realContext),
-                               // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
-                               16,
-                               hooked_ID3D12GraphicsCommandList_CopyTextureRegion,
-                               g_original_ID3D12GraphicsCommandList_CopyTextureRegion);
+
+            for (uint32_t i = 0; i < to_integral(InterceptedCall::MaxValue); i++) {
+                attachInterceptedCall((InterceptedCall)i);
+            }
         }
 
         void uninitializeInterceptor() {
-            ComPtr<ID3D12GraphicsCommandList> realContext;
-            GetRealD3D12Object(get(m_context), set(realContext));
-
-            DetourMethodDetach(get(realContext),
-                               // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
-                               46,
-                               hooked_ID3D12GraphicsCommandList_OMSetRenderTargets,
-                               g_original_ID3D12GraphicsCommandList_OMSetRenderTargets);
+            for (uint32_t i = 0; i < to_integral(InterceptedCall::MaxValue); i++) {
+                detachInterceptedCall((InterceptedCall)i);
+            }
             DetourMethodDetach(get(m_realDevice),
                                // Method offset is 7 + method index (0-based) for ID3D12Device.
                                20,
                                hooked_ID3D12Device_CreateRenderTargetView,
                                g_original_ID3D12Device_CreateRenderTargetView);
-            DetourMethodDetach(get(realContext),
-                               // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
-                               16,
-                               hooked_ID3D12GraphicsCommandList_CopyTextureRegion,
-                               g_original_ID3D12GraphicsCommandList_CopyTextureRegion);
 
             g_instance = nullptr;
         }
 
+        // Called from the hooks, on any application thread.
+        bool isInterceptedCallSubscribed(InterceptedCall call) const {
+            return m_interceptedCallSubscriptions[to_integral(call)].load(std::memory_order_relaxed) != 0;
+        }
+
+        // Hook to the Direct3D command list to intercept preparation for the rendering.
+        void attachInterceptedCall(InterceptedCall call) {
+            TraceLoggingWrite(g_traceProvider, "AttachInterceptedCall", TLArg((uint32_t)call, "Call"));
+
+            ComPtr<ID3D12GraphicsCommandList> realContext;
+            GetRealD3D12Object(get(m_context), set(realContext));
+
+            switch (call) {
+            case InterceptedCall::SetRenderTargets:
+                DetourMethodAttach(get(realContext),
+                                   // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
+                                   46,
+                                   hooked_ID3D12GraphicsCommandList_OMSetRenderTargets,
+                                   g_original_ID3D12GraphicsCommandList_OMSetRenderTargets);
+                break;
+
+            case InterceptedCall::CopyTexture:
+                DetourMethodAttach(get(realContext),
+                                   // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
+                                   16,
+                                   hooked_ID3D12GraphicsCommandList_CopyTextureRegion,
+                                   g_original_ID3D12GraphicsCommandList_CopyTextureRegion);
+                break;
+
+            default:
+                // Mip-map biasing and the depth clears are not intercepted with Direct3D 12.
+                break;
+            }
+        }
+
+        void detachInterceptedCall(InterceptedCall call) {
+            TraceLoggingWrite(g_traceProvider, "DetachInterceptedCall", TLArg((uint32_t)call, "Call"));
+
+            ComPtr<ID3D12GraphicsCommandList> realContext;
+            GetRealD3D12Object(get(m_context), set(realContext));
+
+            switch (call) {
+            case InterceptedCall::SetRenderTargets:
+                DetourMethodDetach(get(realContext),
+                                   // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
+                                   46,
+                                   hooked_ID3D12GraphicsCommandList_OMSetRenderTargets,
+                                   g_original_ID3D12GraphicsCommandList_OMSetRenderTargets);
+                break;
+
+            case InterceptedCall::CopyTexture:
+                DetourMethodDetach(get(realContext),
+                                   // Method offset is 10 + method index (0-based) for ID3D12GraphicsCommandList.
+                                   16,
+                                   hooked_ID3D12GraphicsCommandList_CopyTextureRegion,
+                                   g_original_ID3D12GraphicsCommandList_CopyTextureRegion);
+                break;
+
+            default:
+                // Mip-map biasing and the depth clears are not intercepted with Direct3D 12.
+                break;
+            }
+        }
+
         // Initialize the resources needed for dispatchShader() and related calls.
         void initializeShadingResources() {
             {
@@ -2056,74 +2811,114 @@ namespace {
                 m_device->CreateSampler(&desc, m_samplers[to_integral(SamplerType::LinearClamp)]);
             }
             {
-                ComPtr<ID3DBlob> errors;
-                const HRESULT hr = D3DCompile(QuadVertexShader.data(),
-                                              QuadVertexShader.length(),
-                                              nullptr,
-                                              nullptr,
-                                              nullptr,
-                                              "vsMain",
-                                              "vs_5_0",
-                                              D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS,
-                                              0,
-                                              set(m_quadVertexShaderBytes),
-                                              set(errors));
-                if (FAILED(hr)) {
-                    if (errors) {
-                        Log("%s", (char*)errors->GetBufferPointer());
-                    }
-                    CHECK_HRESULT(hr, "Failed to compile shader");
+                utilities::shader::CompileBuiltInShader(
+                    "QuadVertexShader", QuadVertexShader, "vsMain", set(m_quadVertexShaderBytes), "vs_5_0");
+            }
+        }
+
+        // Bind the pipeline state for draw() or drawInstanced(), except for the vertex buffers. The pipeline state is
+        // lazily constructed now that we know the format for the render target and whether depth is inverted.
+        void setMeshPipelineState(const D3D12::MeshData* meshData, bool isInstanced, bool noCulling) {
+            auto& pso = isInstanced ? (noCulling ? m_meshRendererInstancedNoCullingPipelineState
+                                                 : m_meshRendererInstancedPipelineState)
+                                    : (noCulling ? m_meshRendererNoCullingPipelineState : m_meshRendererPipelineState);
+            const auto& vertexShaderBytes =
+                isInstanced ? m_meshRendererInstancedVertexShaderBytes : m_meshRendererVertexShaderBytes;
+            const auto& inputLayout = isInstanced ? m_meshRendererInstancedInputLayout : m_meshRendererInputLayout;
+
+            // TODO: We must support the RTV format changing.
+            if (!pso) {
+                D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+                ZeroMemory(&desc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
+                desc.InputLayout = {inputLayout.data(), (UINT)inputLayout.size()};
+                desc.pRootSignature = get(m_meshRendererRootSignature);
+                desc.VS = {reinterpret_cast<BYTE*>(vertexShaderBytes->GetBufferPointer()),
+                           vertexShaderBytes->GetBufferSize()};
+                desc.PS = {reinterpret_cast<BYTE*>(m_meshRendererPixelShaderBytes->GetBufferPointer()),
+                           m_meshRendererPixelShaderBytes->GetBufferSize()};
+                desc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+                desc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+                desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+                if (m_currentDrawDepthBufferIsInverted) {
+                    desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+                    desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER;
+                }
+                desc.SampleMask = UINT_MAX;
+                desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+                desc.NumRenderTargets = 1;
+                desc.RTVFormats[0] = (DXGI_FORMAT)m_currentDrawRenderTarget->getInfo().format;
+                desc.SampleDesc.Count = m_currentDrawRenderTarget->getInfo().sampleCount;
+                if (desc.SampleDesc.Count > 1) {
+                    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS qualityLevels;
+                    qualityLevels.Format = desc.RTVFormats[0];
+                    qualityLevels.SampleCount = desc.SampleDesc.Count;
+                    qualityLevels.Flags = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
+                    CHECK_HRCMD(m_device->CheckFeatureSupport(
+                        D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS, &qualityLevels, sizeof(qualityLevels)));
+
+                    // Setup for highest quality multisampling if requested.
+                    desc.SampleDesc.Quality = qualityLevels.NumQualityLevels - 1;
+                    desc.RasterizerState.MultisampleEnable = true;
                 }
+                if (noCulling) {
+                    desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+                }
+                if (m_currentDrawDepthBuffer) {
+                    desc.DSVFormat = (DXGI_FORMAT)m_currentDrawDepthBuffer->getInfo().format;
+                }
+                pso = m_pipelineCache.createGraphicsPipelineState(
+                    get(m_device), desc, m_meshRendererRootSignatureHash);
+            }
+
+            setPipelineState(get(pso));
+            setGraphicsRootSignature(get(m_meshRendererRootSignature));
+            m_context->IASetIndexBuffer(meshData->indexBuffer);
+            m_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+            setDescriptorHeaps();
+
+            {
+                auto d3d12Buffer =
+                    dynamic_cast<D3D12Buffer*>(m_meshViewProjectionBuffer[m_currentMeshViewProjectionBuffer].get());
+                const auto& handle = d3d12Buffer->getConstantBufferView();
+                m_context->SetGraphicsRootDescriptorTable(1, m_transientHeap.copy(&handle, 1));
             }
         }
 
         // Initialize the calls needed for draw() and related calls.
         void initializeMeshResources() {
             {
-                ComPtr<ID3DBlob> errors;
-                const HRESULT hr = D3DCompile(MeshShaders.data(),
-                                              MeshShaders.length(),
-                                              nullptr,
-                                              nullptr,
-                                              nullptr,
-                                              "vsMain",
-                                              "vs_5_0",
-                                              D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS,
-                                              0,
-                                              set(m_meshRendererVertexShaderBytes),
-                                              set(errors));
-                if (FAILED(hr)) {
-                    if (errors) {
-                        Log("%s", (char*)errors->GetBufferPointer());
-                    }
-                    CHECK_HRESULT(hr, "Failed to compile shader");
-                }
+                utilities::shader::CompileBuiltInShader(
+                    "MeshShaders", MeshShaders, "vsMain", set(m_meshRendererVertexShaderBytes), "vs_5_0");
             }
             {
-                ComPtr<ID3DBlob> errors;
-                const HRESULT hr = D3DCompile(MeshShaders.data(),
-                                              MeshShaders.length(),
-                                              nullptr,
-                                              nullptr,
-                                              nullptr,
-                                              "psMain",
-                                              "ps_5_0",
-                                              D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS,
-                                              0,
-                                              set(m_meshRendererPixelShaderBytes),
-                                              set(errors));
-                if (FAILED(hr)) {
-                    if (errors) {
-                        Log("%s", (char*)errors->GetBufferPointer());
-                    }
-                    CHECK_HRESULT(hr, "Failed to compile shader");
-                }
+                utilities::shader::CompileBuiltInShader("MeshShaders",
+                                                        MeshShaders,
+                                                        "vsMainInstanced",
+                                                        set(m_meshRendererInstancedVertexShaderBytes),
+                                                        "vs_5_0");
+            }
+            {
+                utilities::shader::CompileBuiltInShader(
+                    "MeshShaders", MeshShaders, "psMain", set(m_meshRendererPixelShaderBytes), "ps_5_0");
             }
             {
                 m_meshRendererInputLayout.push_back(
                     {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0});
                 m_meshRendererInputLayout.push_back(
                     {"COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0});
+
+                // The instanced variant reads the rows of the model matrix from the second vertex buffer.
+                m_meshRendererInstancedInputLayout = m_meshRendererInputLayout;
+                for (UINT i = 0; i < 4; i++) {
+                    m_meshRendererInstancedInputLayout.push_back({"MODEL",
+                                                                 i,
+                                                                 DXGI_FORMAT_R32G32B32A32_FLOAT,
+                                                                 1,
+                                                                 i * 16,
+                                                                 D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+                                                                 1});
+                }
             }
             {
                 CD3DX12_ROOT_PARAMETER parametersDescriptors[2];
@@ -2153,6 +2948,147 @@ namespace {
                                                           serializedRootSignature->GetBufferPointer(),
                                                           serializedRootSignature->GetBufferSize(),
                                                           IID_PPV_ARGS(set(m_meshRendererRootSignature))));
+                m_meshRendererRootSignatureHash =
+                    D3D12PipelineCache::hashBytes(D3D12PipelineCache::HashSeed,
+                                                  serializedRootSignature->GetBufferPointer(),
+                                                  serializedRootSignature->GetBufferSize());
+            }
+        }
+
+        // Initialize the resources needed for drawString() and related calls.
+        void initializeTextResources() {
+            m_textAtlas = CreateGlyphAtlas(FontFamily, TextAtlasSize, TextAtlasSize);
+
+            {
+                utilities::shader::CompileBuiltInShader(
+                    "TextShaders", TextShaders, "vsMain", set(m_textVertexShaderBytes), "vs_5_0");
+            }
+            {
+                utilities::shader::CompileBuiltInShader(
+                    "TextShaders", TextShaders, "psMain", set(m_textPixelShaderBytes), "ps_5_0");
+            }
+            {
+                m_textInputLayout.push_back(
+                    {"RECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1});
+                m_textInputLayout.push_back({"TEXCOORD",
+                                             0,
+                                             DXGI_FORMAT_R32G32B32A32_FLOAT,
+                                             0,
+                                             16,
+                                             D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+                                             1});
+                m_textInputLayout.push_back(
+                    {"COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1});
+            }
+            {
+                CD3DX12_ROOT_PARAMETER parametersDescriptors[2];
+                parametersDescriptors[0].InitAsConstants(2, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+                const auto rangeParam1 = CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+                parametersDescriptors[1].InitAsDescriptorTable(1, &rangeParam1, D3D12_SHADER_VISIBILITY_PIXEL);
+
+                const auto sampler = CD3DX12_STATIC_SAMPLER_DESC(0,
+                                                                D3D12_FILTER_MIN_MAG_MIP_LINEAR,
+                                                                D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+                                                                D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+                                                                D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+                                                                0.f,
+                                                                1,
+                                                                D3D12_COMPARISON_FUNC_NEVER,
+                                                                D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK,
+                                                                0.f,
+                                                                D3D12_FLOAT32_MAX,
+                                                                D3D12_SHADER_VISIBILITY_PIXEL);
+
+                CD3DX12_ROOT_SIGNATURE_DESC desc(ARRAYSIZE(parametersDescriptors),
+                                                 parametersDescriptors,
+                                                 1,
+                                                 &sampler,
+                                                 D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+                ComPtr<ID3DBlob> serializedRootSignature;
+                ComPtr<ID3DBlob> errors;
+                const HRESULT hr = D3D12SerializeRootSignature(
+                    &desc, D3D_ROOT_SIGNATURE_VERSION_1, set(serializedRootSignature), set(errors));
+                if (FAILED(hr)) {
+                    if (errors) {
+                        Log("%s", (char*)errors->GetBufferPointer());
+                    }
+                    CHECK_HRESULT(hr, "Failed to serialize root signature");
+                }
+
+                CHECK_HRCMD(m_device->CreateRootSignature(0,
+                                                          serializedRootSignature->GetBufferPointer(),
+                                                          serializedRootSignature->GetBufferSize(),
+                                                          IID_PPV_ARGS(set(m_textRootSignature))));
+                m_textRootSignatureHash = D3D12PipelineCache::hashBytes(D3D12PipelineCache::HashSeed,
+                                                                        serializedRootSignature->GetBufferPointer(),
+                                                                        serializedRootSignature->GetBufferSize());
+            }
+        }
+
+        // The allocator (and its region of the transient descriptors) can only be reused once the GPU is done.
+        void nextContext() {
+            if (++m_currentContext == NumInflightContexts) {
+                m_currentContext = 0;
+            }
+            waitForFence(m_commandAllocatorFenceValues[m_currentContext]);
+            CHECK_HRCMD(m_commandAllocator[m_currentContext]->Reset());
+            CHECK_HRCMD(m_commandList[m_currentContext]->Reset(get(m_commandAllocator[m_currentContext]), nullptr));
+            m_context = m_commandList[m_currentContext];
+            m_commandListState = {};
+            m_transientHeap.beginRegion(m_currentContext);
+        }
+
+        // The passes of both eyes (and of the swapchains) mostly use the same shaders one after the other: skip the
+        // calls that would not change the state of the command list.
+        void setDescriptorHeaps() const {
+            if (m_commandListState.hasDescriptorHeaps) {
+                return;
+            }
+
+            ID3D12DescriptorHeap* const heaps[] = {
+                get(m_transientHeap.heap),
+                get(m_samplerHeap.heap),
+            };
+            m_context->SetDescriptorHeaps(ARRAYSIZE(heaps), heaps);
+            m_commandListState.hasDescriptorHeaps = true;
+        }
+
+        void setGraphicsRootSignature(ID3D12RootSignature* rootSignature) const {
+            if (rootSignature != m_commandListState.graphicsRootSignature) {
+                m_context->SetGraphicsRootSignature(rootSignature);
+                m_commandListState.graphicsRootSignature = rootSignature;
+            }
+        }
+
+        void setComputeRootSignature(ID3D12RootSignature* rootSignature) const {
+            if (rootSignature != m_commandListState.computeRootSignature) {
+                m_context->SetComputeRootSignature(rootSignature);
+                m_commandListState.computeRootSignature = rootSignature;
+            }
+        }
+
+        void setPipelineState(ID3D12PipelineState* pipelineState) const {
+            if (pipelineState != m_commandListState.pipelineState) {
+                m_context->SetPipelineState(pipelineState);
+                m_commandListState.pipelineState = pipelineState;
+            }
+        }
+
+        void waitForFence(UINT64 value) {
+            if (m_fence->GetCompletedValue() < value) {
+                CHECK_HRCMD(m_fence->SetEventOnCompletion(value, m_fenceEvent.get()));
+                WaitForSingleObject(m_fenceEvent.get(), INFINITE);
+            }
+        }
+
+        // Drop the references to the resources that the GPU is done with.
+        void reclaimDeferredReleases() {
+            const auto completedFenceValue = m_fence->GetCompletedValue();
+
+            std::unique_lock lock(m_deferredReleasesLock);
+            while (!m_deferredReleases.empty() && m_deferredReleases.front().first <= completedFenceValue) {
+                m_deferredReleases.pop_front();
             }
         }
 
@@ -2174,15 +3110,20 @@ namespace {
             }
 
             D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
-            if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D) {
-                const size_t sizeBefore = m_renderTargetResourceDescriptors.size();
-                {
-                    std::unique_lock lock(m_renderTargetResourceDescriptorsLock);
+            {
+                std::unique_lock lock(m_renderTargetResourceDescriptorsLock);
+
+                // The descriptor is being overwritten, and any wrapper created for it is now stale.
+                m_renderTargets.erase(handle.ptr);
 
+                if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D) {
+                    const size_t sizeBefore = m_renderTargetResourceDescriptors.size();
                     m_renderTargetResourceDescriptors.insert_or_assign(handle, std::make_pair(resource, resourceDesc));
                     if (sizeBefore && !(sizeBefore % 100) && m_renderTargetResourceDescriptors.size() != sizeBefore) {
                         Log("Dictionary of render target resource descriptor now at %zu elements\n", sizeBefore + 1);
                     }
+                } else {
+                    m_renderTargetResourceDescriptors.erase(handle);
                 }
             }
         }
@@ -2201,13 +3142,15 @@ namespace {
                                 const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargetHandles,
                                 BOOL singleHandleToDescriptorRange,
                                 const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencilHandle) {
-            ComPtr<ID3D12Device> device;
-            CHECK_HRCMD(context->GetDevice(IID_PPV_ARGS(set(device))));
-            if (device != m_realDevice) {
-                return;
-            }
+            std::shared_ptr<D3D12Context> wrappedContext;
+            {
+                std::unique_lock lock(m_eventsCacheLock);
 
-            auto wrappedContext = std::make_shared<D3D12Context>(shared_from_this(), context);
+                wrappedContext = getEventsContext(context);
+                if (!wrappedContext) {
+                    return;
+                }
+            }
 
             if (!numRenderTargetDescriptors) {
                 INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
@@ -2218,23 +3161,33 @@ namespace {
             {
                 std::unique_lock lock(m_renderTargetResourceDescriptorsLock);
 
-                auto it = m_renderTargetResourceDescriptors.find(renderTargetHandles[0]);
-                if (it == m_renderTargetResourceDescriptors.cend()) {
-                    INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
-                    return;
+                auto cachedIt = m_renderTargets.find(renderTargetHandles[0].ptr);
+                if (cachedIt != m_renderTargets.end()) {
+                    renderTarget = cachedIt->second;
+                } else {
+                    auto it = m_renderTargetResourceDescriptors.find(renderTargetHandles[0]);
+                    if (it != m_renderTargetResourceDescriptors.cend() &&
+                        isEventsTextureOfInterest(it->second.second)) {
+                        ID3D12Resource* const resource = it->second.first;
+                        const D3D12_RESOURCE_DESC& resourceDesc = it->second.second;
+
+                        renderTarget = std::make_shared<D3D12Texture>(shared_from_this(),
+                                                                      getTextureInfo(resourceDesc),
+                                                                      resourceDesc,
+                                                                      resource,
+                                                                      D3D12_RESOURCE_STATE_COMMON, /* Conservative. */
+                                                                      m_rtvHeap,
+                                                                      m_dsvHeap,
+                                                                      m_rvHeap,
+                                                                      m_uploadRing);
+                    }
+                    m_renderTargets.insert_or_assign(renderTargetHandles[0].ptr, renderTarget);
                 }
+            }
 
-                ID3D12Resource* const resource = it->second.first;
-                const D3D12_RESOURCE_DESC& resourceDesc = it->second.second;
-
-                renderTarget = std::make_shared<D3D12Texture>(shared_from_this(),
-                                                              getTextureInfo(resourceDesc),
-                                                              resourceDesc,
-                                                              resource,
-                                                              D3D12_RESOURCE_STATE_COMMON, /* Conservative. */
-                                                              m_rtvHeap,
-                                                              m_dsvHeap,
-                                                              m_rvHeap);
+            if (!renderTarget) {
+                INVOKE_EVENT(unsetRenderTargetEvent, wrappedContext);
+                return;
             }
 
             INVOKE_EVENT(setRenderTargetEvent, wrappedContext, renderTarget);
@@ -2245,38 +3198,106 @@ namespace {
                            ID3D12Resource* pDstResource,
                            UINT SrcSubresource = 0,
                            UINT DstSubresource = 0) {
-            ComPtr<ID3D12Device> device;
-            CHECK_HRCMD(context->GetDevice(IID_PPV_ARGS(set(device))));
-            if (device != m_realDevice) {
-                return;
+            std::shared_ptr<D3D12Context> wrappedContext;
+            std::shared_ptr<D3D12Texture> source;
+            std::shared_ptr<D3D12Texture> destination;
+            {
+                std::unique_lock lock(m_eventsCacheLock);
+
+                wrappedContext = getEventsContext(context);
+                if (!wrappedContext) {
+                    return;
+                }
+
+                destination = getEventsCopyTexture(m_copyDestinations,
+                                                   pDstResource,
+                                                   D3D12_RESOURCE_STATE_COPY_DEST, /* Conservative. */
+                                                   true /* filter */);
+                if (!destination) {
+                    return;
+                }
+
+                source = getEventsCopyTexture(m_copySources,
+                                              pSrcResource,
+                                              D3D12_RESOURCE_STATE_COPY_SOURCE, /* Conservative. */
+                                              false /* filter */);
             }
 
-            auto wrappedContext = std::make_shared<D3D12Context>(shared_from_this(), context);
+            INVOKE_EVENT(copyTextureEvent, wrappedContext, source, destination, SrcSubresource, DstSubresource);
+        }
+
+#undef INVOKE_EVENT
 
-            const D3D12_RESOURCE_DESC& sourceTextureDesc = pSrcResource->GetDesc();
-            auto source = std::make_shared<D3D12Texture>(shared_from_this(),
-                                                         getTextureInfo(sourceTextureDesc),
-                                                         sourceTextureDesc,
-                                                         pSrcResource,
-                                                         D3D12_RESOURCE_STATE_COPY_SOURCE, /* Conservative. */
+        // The wrappers below are cached for the duration of the frame, since the events are invoked up to thousands of
+        // times per frame with the same objects. The cache holds a reference to the native objects, which guarantees
+        // that their address is not reused while in the cache. Must be called with m_eventsCacheLock held.
+
+        // Returns null for a command list of a different device.
+        std::shared_ptr<D3D12Context> getEventsContext(ID3D12GraphicsCommandList* context) {
+            auto it = m_eventsContexts.find(context);
+            if (it != m_eventsContexts.end()) {
+                return it->second.second;
+            }
+
+            ComPtr<ID3D12Device> device;
+            CHECK_HRCMD(context->GetDevice(IID_PPV_ARGS(set(device))));
+            std::shared_ptr<D3D12Context> wrappedContext;
+            if (device == m_realDevice) {
+                wrappedContext = std::make_shared<D3D12Context>(shared_from_this(), context);
+            }
+            m_eventsContexts.insert_or_assign(context, std::make_pair(context, wrappedContext));
+
+            return wrappedContext;
+        }
+
+        // The source and destination of the copies are cached separately, since the wrappers track a different state.
+        std::shared_ptr<D3D12Texture> getEventsCopyTexture(
+            std::unordered_map<ID3D12Resource*, std::shared_ptr<D3D12Texture>>& cache,
+            ID3D12Resource* resource,
+            D3D12_RESOURCE_STATES initialState,
+            bool filter) {
+            auto it = cache.find(resource);
+            if (it != cache.end()) {
+                return it->second;
+            }
+
+            std::shared_ptr<D3D12Texture> texture;
+            const D3D12_RESOURCE_DESC& textureDesc = resource->GetDesc();
+            if (!filter || isEventsTextureOfInterest(textureDesc)) {
+                texture = std::make_shared<D3D12Texture>(shared_from_this(),
+                                                         getTextureInfo(textureDesc),
+                                                         textureDesc,
+                                                         resource,
+                                                         initialState,
                                                          m_rtvHeap,
                                                          m_dsvHeap,
-                                                         m_rvHeap);
-
-            const D3D12_RESOURCE_DESC& destinationTextureDesc = pSrcResource->GetDesc();
-            auto destination = std::make_shared<D3D12Texture>(shared_from_this(),
-                                                              getTextureInfo(destinationTextureDesc),
-                                                              destinationTextureDesc,
-                                                              pDstResource,
-                                                              D3D12_RESOURCE_STATE_COPY_DEST, /* Conservative. */
-                                                              m_rtvHeap,
-                                                              m_dsvHeap,
-                                                              m_rvHeap);
+                                                         m_rvHeap,
+                                                         m_uploadRing);
+            }
+            cache.insert_or_assign(resource, texture);
 
-            INVOKE_EVENT(copyTextureEvent, wrappedContext, source, destination, SrcSubresource, DstSubresource);
+            return texture;
         }
 
-#undef INVOKE_EVENT
+        bool isEventsTextureOfInterest(const D3D12_RESOURCE_DESC& desc) const {
+            return desc.Width >= m_eventsFilter.minWidth && desc.Height >= m_eventsFilter.minHeight &&
+                   desc.DepthOrArraySize <= m_eventsFilter.maxArraySize;
+        }
+
+        void clearEventsCache() {
+            {
+                std::unique_lock lock(m_eventsCacheLock);
+
+                m_eventsContexts.clear();
+                m_copySources.clear();
+                m_copyDestinations.clear();
+            }
+            {
+                std::unique_lock lock(m_renderTargetResourceDescriptorsLock);
+
+                m_renderTargets.clear();
+            }
+        }
 
         const ComPtr<ID3D12Device> m_device;
         ComPtr<IDXGIAdapter> m_adapter;
@@ -2285,17 +3306,30 @@ namespace {
         std::string m_deviceName;
         GpuArchitecture m_gpuArchitecture;
         const bool m_allowInterceptor;
-        const bool m_needInteropCopy;
+        // In developer mode, the shader files are always compiled (to allow live edits).
+        const bool m_usePrecompiledShaders;
 
         ComPtr<ID3D12CommandAllocator> m_commandAllocator[NumInflightContexts];
         ComPtr<ID3D12GraphicsCommandList> m_commandList[NumInflightContexts];
         size_t m_currentContext{0};
 
         ComPtr<ID3D12GraphicsCommandList> m_context;
+
+        // The state last set on the current command list (see setPipelineState()).
+        mutable struct {
+            bool hasDescriptorHeaps{false};
+            ID3D12RootSignature* graphicsRootSignature{nullptr};
+            ID3D12RootSignature* computeRootSignature{nullptr};
+            ID3D12PipelineState* pipelineState{nullptr};
+        } m_commandListState;
+
         D3D12Heap m_rtvHeap;
         D3D12Heap m_dsvHeap;
         D3D12Heap m_rvHeap;
         D3D12Heap m_samplerHeap;
+        D3D12DescriptorRing m_transientHeap;
+        D3D12PipelineCache m_pipelineCache;
+        D3D12UploadRing m_uploadRing;
         ComPtr<ID3D12QueryHeap> m_queryHeap;
         ComPtr<ID3D12Resource> m_queryReadbackBuffer;
         ComPtr<ID3DBlob> m_quadVertexShaderBytes;
@@ -2308,20 +3342,40 @@ namespace {
         std::vector<D3D12_INPUT_ELEMENT_DESC> m_meshRendererInputLayout;
         ComPtr<ID3DBlob> m_meshRendererPixelShaderBytes;
         ComPtr<ID3D12RootSignature> m_meshRendererRootSignature;
+        uint64_t m_meshRendererRootSignatureHash{0};
         ComPtr<ID3D12PipelineState> m_meshRendererPipelineState;
         ComPtr<ID3D12PipelineState> m_meshRendererNoCullingPipelineState;
+        ComPtr<ID3DBlob> m_meshRendererInstancedVertexShaderBytes;
+        std::vector<D3D12_INPUT_ELEMENT_DESC> m_meshRendererInstancedInputLayout;
+        ComPtr<ID3D12PipelineState> m_meshRendererInstancedPipelineState;
+        ComPtr<ID3D12PipelineState> m_meshRendererInstancedNoCullingPipelineState;
         ComPtr<ID3D12Fence> m_fence;
         UINT64 m_fenceValue{0};
+        wil::unique_handle m_fenceEvent;
+        std::deque<std::pair<UINT64, std::shared_ptr<void>>> m_deferredReleases;
+        std::mutex m_deferredReleasesLock;
+        UINT64 m_commandAllocatorFenceValues[NumInflightContexts]{};
+
+        mutable std::vector<D3D12_RESOURCE_BARRIER> m_pendingBarriers;
 
         UINT m_nextGpuTimestampIndex{0};
+        std::weak_ptr<IGpuProfiler> m_profiler;
         uint64_t m_queryBuffer[MaxGpuTimers * 2];
+        UINT64 m_timestampResolveFenceValues[NumTimestampReadbacks]{};
+        uint64_t m_timestampResolveSerial{0};
+        uint64_t m_completedTimestampResolveSerial{0};
         uint64_t m_gpuTickFrequency{0};
 
-        std::shared_ptr<IDevice> m_textDevice;
-        ComPtr<ID3D11On12Device> m_textInteropDevice;
-        bool m_isRenderingText{false};
+        std::shared_ptr<IGlyphAtlas> m_textAtlas;
+        std::shared_ptr<ITexture> m_textAtlasTexture;
+        ComPtr<ID3DBlob> m_textVertexShaderBytes;
+        ComPtr<ID3DBlob> m_textPixelShaderBytes;
+        std::vector<D3D12_INPUT_ELEMENT_DESC> m_textInputLayout;
+        ComPtr<ID3D12RootSignature> m_textRootSignature;
+        uint64_t m_textRootSignatureHash{0};
+        std::map<std::tuple<DXGI_FORMAT, DXGI_FORMAT, uint32_t>, ComPtr<ID3D12PipelineState>> m_textPipelineStates;
+        std::vector<GlyphInstance> m_textGlyphs;
 
-        std::shared_ptr<ITexture> m_currentTextRenderTarget;
         std::shared_ptr<ITexture> m_currentDrawRenderTarget;
         int32_t m_currentDrawRenderTargetSlice;
         XrRect2Di m_currentDrawRenderTargetViewport;
@@ -2345,8 +3399,18 @@ namespace {
                  std::pair<ID3D12Resource*, D3D12_RESOURCE_DESC>,
                  decltype(descriptorCompare)>
             m_renderTargetResourceDescriptors{descriptorCompare};
+        std::unordered_map<SIZE_T, std::shared_ptr<D3D12Texture>> m_renderTargets;
         std::mutex m_renderTargetResourceDescriptorsLock;
 
+        EventsFilter m_eventsFilter;
+        std::array<std::atomic<uint32_t>, to_integral(InterceptedCall::MaxValue)> m_interceptedCallSubscriptions{};
+        std::mutex m_eventsCacheLock;
+        std::unordered_map<ID3D12GraphicsCommandList*,
+                           std::pair<ComPtr<ID3D12GraphicsCommandList>, std::shared_ptr<D3D12Context>>>
+            m_eventsContexts;
+        std::unordered_map<ID3D12Resource*, std::shared_ptr<D3D12Texture>> m_copySources;
+        std::unordered_map<ID3D12Resource*, std::shared_ptr<D3D12Texture>> m_copyDestinations;
+
         friend std::shared_ptr<ITexture> toolkit::graphics::WrapD3D12Texture(std::shared_ptr<IDevice> device,
                                                                              const XrSwapchainCreateInfo& info,
                                                                              ID3D12Resource* texture,
@@ -2402,8 +3466,11 @@ namespace {
                                 const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
                                 D3D12_CPU_DESCRIPTOR_HANDLE DestDescriptor) {
             TraceLocalActivity(local);
-            TraceLoggingWriteStart(
-                local, "ID3D12Device_CreateRenderTargetView", TLPArg(Device, "Device"), TLPArg(pResource, "Resource"));
+            TraceLoggingWriteStart(local,
+                                   "ID3D12Device_CreateRenderTargetView",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
+                                   TLPArg(Device, "Device"),
+                                   TLPArg(pResource, "Resource"));
 
             assert(g_instance);
             g_instance->registerRenderTargetView(pResource, pDesc, DestDescriptor);
@@ -2411,8 +3478,10 @@ namespace {
             assert(g_original_ID3D12Device_CreateRenderTargetView);
             g_original_ID3D12Device_CreateRenderTargetView(Device, pResource, pDesc, DestDescriptor);
 
-            TraceLoggingWriteStop(
-                local, "ID3D12Device_CreateRenderTargetView", TLPArg(DestDescriptor.ptr, "Descriptor"));
+            TraceLoggingWriteStop(local,
+                                  "ID3D12Device_CreateRenderTargetView",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks),
+                                  TLPArg(DestDescriptor.ptr, "Descriptor"));
         }
 
         DECLARE_DETOUR_FUNCTION(static void,
@@ -2426,14 +3495,16 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D12GraphicsCommandList_OMSetRenderTargets",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLArg(NumRenderTargetDescriptors, "NumRenderTargetDescriptors"),
                                    TLArg(RTsSingleHandleToDescriptorRange, "RTsSingleHandleToDescriptorRange"),
                                    TLPArg(pDepthStencilDescriptor ? pDepthStencilDescriptor->ptr : 0, "DSV"));
-            if (IsTraceEnabled()) {
+            if (IsTraceKeywordEnabled(TLK_GraphicsHooks)) {
                 for (UINT i = 0; i < NumRenderTargetDescriptors; i++) {
                     TraceLoggingWriteTagged(local,
                                             "ID3D12GraphicsCommandList_OMSetRenderTargets",
+                                            TraceLoggingKeyword(TLK_GraphicsHooks),
                                             TLPArg(pRenderTargetDescriptors[i].ptr, "RTV"));
                 }
             }
@@ -2446,13 +3517,17 @@ namespace {
                                                                     RTsSingleHandleToDescriptorRange,
                                                                     pDepthStencilDescriptor);
 
-            g_instance->onSetRenderTargets(Context,
-                                           NumRenderTargetDescriptors,
-                                           pRenderTargetDescriptors,
-                                           RTsSingleHandleToDescriptorRange,
-                                           pDepthStencilDescriptor);
+            if (g_instance->isInterceptedCallSubscribed(InterceptedCall::SetRenderTargets)) {
+                g_instance->onSetRenderTargets(Context,
+                                               NumRenderTargetDescriptors,
+                                               pRenderTargetDescriptors,
+                                               RTsSingleHandleToDescriptorRange,
+                                               pDepthStencilDescriptor);
+            }
 
-            TraceLoggingWriteStop(local, "ID3D12GraphicsCommandList_OMSetRenderTargets");
+            TraceLoggingWriteStop(local,
+                                  "ID3D12GraphicsCommandList_OMSetRenderTargets",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
         }
 
         DECLARE_DETOUR_FUNCTION(static void,
@@ -2468,6 +3543,7 @@ namespace {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "ID3D12GraphicsCommandList_CopyTextureRegion",
+                                   TraceLoggingKeyword(TLK_GraphicsHooks),
                                    TLPArg(Context, "Context"),
                                    TLPArg(pDst->pResource, "Destination"),
                                    TLArg(pDst->SubresourceIndex, "DestinationIndex"),
@@ -2475,25 +3551,39 @@ namespace {
                                    TLArg(pSrc->SubresourceIndex, "SourceIndex"));
 
             assert(g_instance);
-            g_instance->onCopyTexture(
-                Context, pSrc->pResource, pDst->pResource, pSrc->SubresourceIndex, pDst->SubresourceIndex);
+            if (g_instance->isInterceptedCallSubscribed(InterceptedCall::CopyTexture)) {
+                g_instance->onCopyTexture(
+                    Context, pSrc->pResource, pDst->pResource, pSrc->SubresourceIndex, pDst->SubresourceIndex);
+            }
 
             assert(g_original_ID3D12GraphicsCommandList_CopyTextureRegion);
             g_original_ID3D12GraphicsCommandList_CopyTextureRegion(Context, pDst, DstX, DstY, DstZ, pSrc, pSrcBox);
 
-            TraceLoggingWriteStop(local, "ID3D12GraphicsCommandList_CopyTextureRegion");
+            TraceLoggingWriteStop(local,
+                                  "ID3D12GraphicsCommandList_CopyTextureRegion",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
         }
     };
 
+    void TransitionResource(IDevice* device,
+                            ID3D12Resource* resource,
+                            D3D12_RESOURCE_STATES before,
+                            D3D12_RESOURCE_STATES after) {
+        dynamic_cast<D3D12Device*>(device)->transitionResource(resource, before, after);
+    }
+
+    void FlushResourceBarriers(IDevice* device) {
+        dynamic_cast<D3D12Device*>(device)->flushBarriers();
+    }
+
 } // namespace
 
 namespace toolkit::graphics {
 
     std::shared_ptr<IDevice> WrapD3D12Device(ID3D12Device* device,
                                              ID3D12CommandQueue* queue,
-                                             std::shared_ptr<config::IConfigManager> configManager,
-                                             bool enableVarjoQuirk) {
-        return std::make_shared<D3D12Device>(device, queue, configManager, enableVarjoQuirk);
+                                             std::shared_ptr<config::IConfigManager> configManager) {
+        return std::make_shared<D3D12Device>(device, queue, configManager);
     }
 
     std::shared_ptr<ITexture> WrapD3D12Texture(std::shared_ptr<IDevice> device,
@@ -2512,7 +3602,8 @@ namespace toolkit::graphics {
                                                   initialState,
                                                   d3d12Device->m_rtvHeap,
                                                   d3d12Device->m_dsvHeap,
-                                                  d3d12Device->m_rvHeap);
+                                                  d3d12Device->m_rvHeap,
+                                                  d3d12Device->m_uploadRing);
         }
         throw std::runtime_error("Not a D3D12 device");
     }
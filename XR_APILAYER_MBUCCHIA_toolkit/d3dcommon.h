@@ -11,6 +11,64 @@ namespace toolkit::graphics::d3dcommon {
         DirectX::XMFLOAT4X4 ViewProjection;
     };
 
+    // One instance per mesh drawn with drawInstanced(). Unlike ModelConstantBuffer, the matrix is not transposed.
+    struct MeshInstance {
+        DirectX::XMFLOAT4X4 Model;
+    };
+
+    // Depth buffers are sampled through the color format matching their depth format or typeless format.
+    inline DXGI_FORMAT GetShaderResourceViewFormat(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R16_TYPELESS:
+        case DXGI_FORMAT_D16_UNORM:
+            return DXGI_FORMAT_R16_UNORM;
+        case DXGI_FORMAT_R24G8_TYPELESS:
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:
+            return DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+        case DXGI_FORMAT_R32_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT:
+            return DXGI_FORMAT_R32_FLOAT;
+        case DXGI_FORMAT_R32G8X24_TYPELESS:
+        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+            return DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS;
+        default:
+            return format;
+        }
+    }
+
+    // The UNORM format sharing the layout of an sRGB format, or DXGI_FORMAT_UNKNOWN.
+    inline DXGI_FORMAT GetUnormFormat(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return DXGI_FORMAT_B8G8R8A8_UNORM;
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return DXGI_FORMAT_B8G8R8X8_UNORM;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    // The typeless formats of the color formats that have an sRGB variant.
+    inline bool IsTypelessColorFormat(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+        case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // One instance per glyph quad.
+    struct GlyphInstance {
+        float Rect[4];     // left, top, right, bottom (in pixels)
+        float TexCoord[4]; // u0, v0, u1, v1
+        uint32_t Color;    // 0xAABBGGRR
+    };
+
     const std::string_view MeshShaders = R"_(
 struct VSOutput {
     float4 Pos : SV_POSITION;
@@ -34,6 +92,24 @@ VSOutput vsMain(VSInput input) {
     return output;
 }
 
+struct VSInstancedInput {
+    float3 Pos : POSITION;
+    float3 Color : COLOR0;
+    float4 Model0 : MODEL0;
+    float4 Model1 : MODEL1;
+    float4 Model2 : MODEL2;
+    float4 Model3 : MODEL3;
+};
+
+VSOutput vsMainInstanced(VSInstancedInput input) {
+    const float4x4 model = float4x4(input.Model0, input.Model1, input.Model2, input.Model3);
+
+    VSOutput output;
+    output.Pos = mul(mul(float4(input.Pos, 1), model), ViewProjection);
+    output.Color = input.Color;
+    return output;
+}
+
 float4 psMain(VSOutput input) : SV_TARGET {
     return float4(input.Color, 1);
 }
@@ -45,5 +121,38 @@ void vsMain(in uint id : SV_VertexID, out float4 position : SV_Position, out flo
     texcoord = float2((id == 1) ? 2.0 : 0.0, (id == 2) ? 2.0 : 0.0);
     position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
 }
+)_";
+
+    const std::string_view TextShaders = R"_(
+struct VSOutput {
+    float4 Pos : SV_POSITION;
+    float2 TexCoord : TEXCOORD0;
+    float4 Color : COLOR0;
+};
+struct VSInput {
+    float4 Rect : RECT;
+    float4 TexCoord : TEXCOORD0;
+    float4 Color : COLOR0;
+};
+cbuffer TextConstants : register(b0) {
+    float2 InvViewportSize;
+};
+Texture2D Atlas : register(t0);
+SamplerState AtlasSampler : register(s0);
+
+VSOutput vsMain(uint id : SV_VertexID, VSInput input) {
+    const float2 corner = float2(id & 1, id >> 1);
+    const float2 pos = lerp(input.Rect.xy, input.Rect.zw, corner);
+
+    VSOutput output;
+    output.Pos = float4(pos * InvViewportSize * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+    output.TexCoord = lerp(input.TexCoord.xy, input.TexCoord.zw, corner);
+    output.Color = input.Color;
+    return output;
+}
+
+float4 psMain(VSOutput input) : SV_TARGET {
+    return float4(input.Color.rgb, input.Color.a * Atlas.Sample(AtlasSampler, input.TexCoord).r);
+}
 )_";
 } // namespace toolkit::graphics::d3dcommon
@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    // Smoothing of the GPU frame time.
+    constexpr float FrameTimeSmoothing = 0.1f;
+
+    // Reduce the quality once the GPU uses more than this share of the display period, and restore it once it
+    // is back below the lower share. The gap between the two avoids oscillations.
+    constexpr float ReduceThreshold = 0.9f;
+    constexpr float RestoreThreshold = 0.7f;
+
+    // Number of frames to wait after a change, to let the measurements settle. Restoring is slower than reducing,
+    // since a missed frame is more noticeable than a blurrier periphery.
+    constexpr uint32_t ReduceCooldownFrames = 30;
+    constexpr uint32_t RestoreCooldownFrames = 90;
+
+    class DynamicResolutionController : public IDynamicResolutionController {
+      public:
+        DynamicResolutionController(std::shared_ptr<IConfigManager> configManager) : m_configManager(configManager) {
+        }
+
+        void update(uint64_t gpuFrameTimeUs, XrDuration displayPeriod) override {
+            if (!gpuFrameTimeUs || displayPeriod <= 0) {
+                return;
+            }
+
+            if (m_smoothedFrameTimeUs > 0) {
+                m_smoothedFrameTimeUs += FrameTimeSmoothing * ((float)gpuFrameTimeUs - m_smoothedFrameTimeUs);
+            } else {
+                m_smoothedFrameTimeUs = (float)gpuFrameTimeUs;
+            }
+
+            const int minLevel = std::max(m_configManager->getValue(SettingDynamicResolutionMin), 0);
+            const int maxLevel = std::max(m_configManager->getValue(SettingDynamicResolutionMax), minLevel);
+            m_level = std::clamp(m_level, minLevel, maxLevel);
+
+            if (m_cooldown) {
+                m_cooldown--;
+                return;
+            }
+
+            const float budgetUs = displayPeriod / 1000.f;
+            int newLevel = m_level;
+            if (m_smoothedFrameTimeUs > ReduceThreshold * budgetUs) {
+                newLevel = std::min(m_level + 1, maxLevel);
+            } else if (m_smoothedFrameTimeUs < RestoreThreshold * budgetUs) {
+                newLevel = std::max(m_level - 1, minLevel);
+            }
+
+            if (newLevel != m_level) {
+                m_cooldown = newLevel > m_level ? ReduceCooldownFrames : RestoreCooldownFrames;
+                m_level = newLevel;
+
+                TraceLoggingWrite(g_traceProvider,
+                                  "DynamicResolution_Level",
+                                  TraceLoggingKeyword(TLK_Frame),
+                                  TLArg(m_level, "Level"),
+                                  TLArg(m_smoothedFrameTimeUs, "GpuFrameTimeUs"),
+                                  TLArg(budgetUs, "BudgetUs"));
+            }
+        }
+
+        int getLevel() const override {
+            return m_level;
+        }
+
+      private:
+        const std::shared_ptr<IConfigManager> m_configManager;
+
+        float m_smoothedFrameTimeUs{0};
+        int m_level{0};
+        uint32_t m_cooldown{0};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<IDynamicResolutionController>
+    CreateDynamicResolutionController(std::shared_ptr<IConfigManager> configManager) {
+        return std::make_shared<DynamicResolutionController>(configManager);
+    }
+
+} // namespace toolkit::graphics
@@ -39,26 +39,142 @@ namespace {
 
     using namespace xr::math;
 
+    using namespace std::chrono_literals;
+
+    // Must be a power of 2.
+    constexpr uint32_t GazeSampleRingSize = 32;
+
+    // Samples older than this (relative to the display time) are considered lost.
+    constexpr XrDuration MaxGazeSampleAge = 200'000'000;
+
+    // Do not extrapolate the gaze too far ahead, since saccades make it very unpredictable.
+    constexpr XrDuration MaxGazeExtrapolation = 20'000'000;
+
+    // Velocity-threshold (I-VT) classification of the eye movements, in degrees per second.
+    constexpr float SaccadeOnsetVelocity = 100.f;
+    constexpr float SaccadeOffsetVelocity = 30.f;
+    constexpr XrDuration FixationConfirmationTime = 50'000'000;
+
+    // Main sequence of saccades: peakVelocity = MaxVelocity * (1 - exp(-amplitude / Constant)).
+    constexpr float MainSequenceMaxVelocity = 500.f;
+    constexpr float MainSequenceConstant = 14.f;
+
+    // Classify the gaze movements from one frame to the next, and predict the landing point of saccades.
+    class GazePredictor {
+      public:
+        void reset() {
+            m_movement = GazeMovement::Fixation;
+            m_lastTime = 0;
+        }
+
+        // Returns the gaze point to use for this frame.
+        XrVector3f update(XrTime time, const XrVector3f& gazePoint) {
+            const auto point = LoadXrVector3(gazePoint);
+            const auto direction = DirectX::XMVector3Normalize(point);
+
+            const XrDuration elapsed = time - m_lastTime;
+            if (m_lastTime && elapsed == 0) {
+                // Queried again for the same frame.
+                return gazePoint;
+            }
+            if (!m_lastTime || elapsed < 0 || elapsed > MaxGazeSampleAge) {
+                m_movement = GazeMovement::Fixation;
+                m_lastTime = time;
+                m_lastDirection = direction;
+                return gazePoint;
+            }
+
+            const auto previousDirection = m_lastDirection;
+            const float angle = DirectX::XMConvertToDegrees(
+                DirectX::XMVectorGetX(DirectX::XMVector3AngleBetweenNormals(previousDirection, direction)));
+            const float velocity = angle / (elapsed / 1e9f);
+            m_lastTime = time;
+            m_lastDirection = direction;
+
+            if (velocity > SaccadeOnsetVelocity) {
+                if (m_movement != GazeMovement::Saccade) {
+                    // The previous direction is our best estimate of where the saccade started.
+                    m_movement = GazeMovement::Saccade;
+                    m_saccadeStart = previousDirection;
+                    m_saccadePeakVelocity = 0.f;
+                }
+                m_saccadePeakVelocity = std::max(m_saccadePeakVelocity, velocity);
+            } else if (velocity < SaccadeOffsetVelocity) {
+                if (m_movement == GazeMovement::Saccade) {
+                    m_movement = GazeMovement::Settling;
+                    m_settlingStart = time;
+                } else if (m_movement == GazeMovement::Settling && time - m_settlingStart >= FixationConfirmationTime) {
+                    m_movement = GazeMovement::Fixation;
+                }
+            }
+            if (m_movement != GazeMovement::Saccade) {
+                return gazePoint;
+            }
+
+            // Invert the main sequence to estimate the amplitude of the saccade from its peak velocity so far. This
+            // underestimates the amplitude until the peak is reached, mid-saccade.
+            const float amplitude =
+                -MainSequenceConstant *
+                std::log(1.f - std::min(m_saccadePeakVelocity / MainSequenceMaxVelocity, 0.95f));
+            const float travelled = DirectX::XMConvertToDegrees(
+                DirectX::XMVectorGetX(DirectX::XMVector3AngleBetweenNormals(m_saccadeStart, direction)));
+            if (travelled >= amplitude || travelled < 0.1f) {
+                return gazePoint;
+            }
+
+            // Rotate the start direction towards the current direction by the amplitude.
+            const auto perpendicular = DirectX::XMVector3Normalize(DirectX::XMVectorSubtract(
+                direction, DirectX::XMVectorScale(m_saccadeStart, DirectX::XMVectorGetX(DirectX::XMVector3Dot(
+                                                                      m_saccadeStart, direction)))));
+            const float radians = DirectX::XMConvertToRadians(amplitude);
+            const auto landing = DirectX::XMVectorAdd(DirectX::XMVectorScale(m_saccadeStart, std::cos(radians)),
+                                                      DirectX::XMVectorScale(perpendicular, std::sin(radians)));
+
+            XrVector3f landingPoint;
+            StoreXrVector3(&landingPoint,
+                           DirectX::XMVectorScale(landing, DirectX::XMVectorGetX(DirectX::XMVector3Length(point))));
+
+            TraceLoggingWrite(g_traceProvider,
+                              "GazePredictor_Saccade",
+                              TraceLoggingKeyword(TLK_Input),
+                              TLArg(velocity, "Velocity"),
+                              TLArg(m_saccadePeakVelocity, "PeakVelocity"),
+                              TLArg(amplitude, "Amplitude"),
+                              TLArg(travelled, "Travelled"));
+
+            return landingPoint;
+        }
+
+        GazeMovement getMovement() const {
+            return m_movement;
+        }
+
+      private:
+        GazeMovement m_movement{GazeMovement::Fixation};
+        XrTime m_lastTime{0};
+        DirectX::XMVECTOR m_lastDirection{};
+
+        DirectX::XMVECTOR m_saccadeStart{};
+        float m_saccadePeakVelocity{0.f};
+        XrTime m_settlingStart{0};
+    };
+
     class EyeTrackerBase : public IEyeTracker {
       public:
         EyeTrackerBase(OpenXrApi& openXR, std::shared_ptr<IConfigManager> configManager)
             : m_openXR(openXR), m_configManager(configManager) {
+            PFN_xrVoidFunction unused;
+            m_hasPerformanceCounterKHR = XR_SUCCEEDED(m_openXR.xrGetInstanceProcAddr(
+                m_openXR.GetXrInstance(), "xrConvertWin32PerformanceCounterToTimeKHR", &unused));
         }
 
         ~EyeTrackerBase() override {
             endSession();
         }
 
-        void beginSession(XrSession session) override {
+        void beginSession(XrSession session, XrSpace viewSpace) override {
             m_session = session;
-
-            // Create a reference space.
-            {
-                XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO, nullptr};
-                referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
-                referenceSpaceCreateInfo.poseInReferenceSpace = Pose::Identity();
-                CHECK_XRCMD(m_openXR.xrCreateReferenceSpace(session, &referenceSpaceCreateInfo, &m_viewSpace));
-            }
+            m_viewSpace = viewSpace;
         }
 
         void endSession() override {
@@ -66,11 +182,7 @@ namespace {
                 m_openXR.xrDestroyActionSet(m_eyeTrackerActionSet);
                 m_eyeTrackerActionSet = XR_NULL_HANDLE;
             }
-            if (m_viewSpace != XR_NULL_HANDLE) {
-                m_openXR.xrDestroySpace(m_viewSpace);
-                m_viewSpace = XR_NULL_HANDLE;
-            }
-
+            m_viewSpace = XR_NULL_HANDLE;
             m_session = XR_NULL_HANDLE;
         }
 
@@ -120,9 +232,13 @@ namespace {
 
                 XrVector3f projectedPoint{};
                 if (!getEyeGaze(projectedPoint)) {
+                    m_predictor.reset();
                     return false;
                 }
 
+                // During saccades, aim for the predicted landing point rather than where the eye currently is.
+                projectedPoint = m_predictor.update(m_frameTime, projectedPoint);
+
                 m_eyeGazeState.gazeRay = projectedPoint;
 
                 // Project the pose onto the screen.
@@ -143,11 +259,88 @@ namespace {
             return true;
         }
 
+        GazeMovement getGazeMovement() const override {
+            return m_predictor.getMovement();
+        }
+
         const EyeGazeState& getEyeGazeState() const override {
             return m_eyeGazeState;
         }
 
       protected:
+        struct GazeSample {
+            LARGE_INTEGER qpcTime;
+            XrVector3f projectedPoint;
+            bool isValid;
+        };
+
+        // Called from the thread receiving the samples from the device. There must be a single producer.
+        void pushGazeSample(const XrVector3f& projectedPoint, bool isValid = true) {
+            GazeSample sample{{}, projectedPoint, isValid};
+            QueryPerformanceCounter(&sample.qpcTime);
+
+            const auto head = m_gazeSampleHead.load(std::memory_order_relaxed);
+            m_gazeSamples[head % GazeSampleRingSize] = sample;
+            m_gazeSampleHead.store(head + 1, std::memory_order_release);
+        }
+
+        // Estimate the gaze at the display time of the frame from the two most recent samples.
+        bool getGazeSampleAtFrameTime(XrVector3f& projectedPoint) const {
+            const auto head = m_gazeSampleHead.load(std::memory_order_acquire);
+            if (!head) {
+                return false;
+            }
+
+            const GazeSample latest = m_gazeSamples[(head - 1) % GazeSampleRingSize];
+            const GazeSample previous = m_gazeSamples[(head - (head > 1 ? 2 : 1)) % GazeSampleRingSize];
+
+            // The producer would need to wrap around the entire ring while we copy for the samples to be torn.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_gazeSampleHead.load(std::memory_order_relaxed) - head > GazeSampleRingSize - 2) {
+                return false;
+            }
+
+            if (!latest.isValid) {
+                return false;
+            }
+
+            projectedPoint = latest.projectedPoint;
+
+            XrTime latestTime, previousTime;
+            if (!m_hasPerformanceCounterKHR ||
+                XR_FAILED(m_openXR.xrConvertWin32PerformanceCounterToTimeKHR(
+                    m_openXR.GetXrInstance(), &latest.qpcTime, &latestTime)) ||
+                XR_FAILED(m_openXR.xrConvertWin32PerformanceCounterToTimeKHR(
+                    m_openXR.GetXrInstance(), &previous.qpcTime, &previousTime))) {
+                // Without timestamps, we can only use the latest sample.
+                return true;
+            }
+
+            if (m_frameTime - latestTime > MaxGazeSampleAge) {
+                return false;
+            }
+
+            // Only use the previous sample if it is part of the same fixation/saccade.
+            const XrDuration interval = latestTime - previousTime;
+            if (!previous.isValid || interval <= 0 || interval > MaxGazeExtrapolation) {
+                return true;
+            }
+
+            const XrTime targetTime = std::min(m_frameTime, latestTime + MaxGazeExtrapolation);
+            const float alpha = std::max((float)(targetTime - previousTime) / interval, 0.f);
+            projectedPoint = previous.projectedPoint + (latest.projectedPoint - previous.projectedPoint) * alpha;
+
+            TraceLoggingWrite(g_traceProvider,
+                              "GazeSample",
+                              TraceLoggingKeyword(TLK_Input),
+                              TLArg(latestTime, "LatestTime"),
+                              TLArg(interval, "Interval"),
+                              TLArg(targetTime, "TargetTime"),
+                              TLArg(alpha, "Alpha"));
+
+            return true;
+        }
+
         OpenXrApi& m_openXR;
         const std::shared_ptr<IConfigManager> m_configManager;
         float m_projectionDistance{2.f};
@@ -161,6 +354,15 @@ namespace {
         mutable XrVector2f m_gaze[ViewCount];
         mutable bool m_valid{false};
         mutable EyeGazeState m_eyeGazeState{};
+        mutable GazePredictor m_predictor;
+
+      private:
+        bool m_hasPerformanceCounterKHR{false};
+
+        // Single-producer/single-consumer ring of the samples received from the device. The consumer only ever
+        // looks at the most recent samples, so the producer never waits.
+        std::array<GazeSample, GazeSampleRingSize> m_gazeSamples{};
+        std::atomic<uint32_t> m_gazeSampleHead{0};
     };
 
     class OpenXrEyeTracker : public EyeTrackerBase {
@@ -172,8 +374,8 @@ namespace {
         ~OpenXrEyeTracker() override {
         }
 
-        void beginSession(XrSession session) override {
-            EyeTrackerBase::beginSession(session);
+        void beginSession(XrSession session, XrSpace viewSpace) override {
+            EyeTrackerBase::beginSession(session, viewSpace);
 
             m_debugWithController = m_configManager->getValue(SettingEyeDebugWithController);
 
@@ -308,8 +510,8 @@ namespace {
         ~OpenXrFBEyeTracker() override {
         }
 
-        void beginSession(XrSession session) override {
-            EyeTrackerBase::beginSession(session);
+        void beginSession(XrSession session, XrSpace viewSpace) override {
+            EyeTrackerBase::beginSession(session, viewSpace);
 
             // Create the resources for the eye tracker.
             XrEyeTrackerCreateInfoFB createInfo{XR_TYPE_EYE_TRACKER_CREATE_INFO_FB};
@@ -397,13 +599,25 @@ namespace {
             endSession();
         }
 
-        void beginSession(XrSession session) override {
-            EyeTrackerBase::beginSession(session);
+        void beginSession(XrSession session, XrSpace viewSpace) override {
+            EyeTrackerBase::beginSession(session, viewSpace);
 
             m_omniceptClient->startClient();
+
+            m_stop = false;
+            m_thread = std::thread([&] { pollLoop(); });
         }
 
         void endSession() override {
+            if (m_thread.joinable()) {
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_stop = true;
+                }
+                m_wakeUp.notify_one();
+                m_thread.join();
+            }
+
             if (m_omniceptClient) {
                 // TODO: This is occasionally causing a crash... Disabled for now.
                 // m_omniceptClient->pauseClient();
@@ -413,16 +627,7 @@ namespace {
         }
 
         bool getEyeGaze(XrVector3f& projectedPoint) const override {
-            Client::LastValueCached<Abi::EyeTracking> lvc = m_omniceptClient->getLastData<Abi::EyeTracking>();
-            if (!lvc.valid || lvc.data.combinedGazeConfidence < 0.5f) {
-                return false;
-            }
-
-            projectedPoint.x = -lvc.data.combinedGaze.x;
-            projectedPoint.y = lvc.data.combinedGaze.y;
-            projectedPoint.z = -lvc.data.combinedGaze.z;
-
-            return true;
+            return getGazeSampleAtFrameTime(projectedPoint);
         }
 
         bool isProjectionDistanceSupported() const {
@@ -430,7 +635,40 @@ namespace {
         }
 
       private:
+        // The client only caches the last value, so we poll it faster than the tracker rate (120Hz) in order to
+        // timestamp each sample.
+        void pollLoop() {
+            std::optional<XrVector3f> lastGaze;
+
+            std::unique_lock lock(m_mutex);
+            while (!m_stop) {
+                m_wakeUp.wait_for(lock, 2ms, [&] { return m_stop; });
+
+                lock.unlock();
+                Client::LastValueCached<Abi::EyeTracking> lvc = m_omniceptClient->getLastData<Abi::EyeTracking>();
+                if (!lvc.valid || lvc.data.combinedGazeConfidence < 0.5f) {
+                    if (lastGaze) {
+                        pushGazeSample({}, false);
+                        lastGaze.reset();
+                    }
+                } else {
+                    const XrVector3f gaze{
+                        -lvc.data.combinedGaze.x, lvc.data.combinedGaze.y, -lvc.data.combinedGaze.z};
+                    if (!lastGaze || gaze.x != lastGaze->x || gaze.y != lastGaze->y || gaze.z != lastGaze->z) {
+                        pushGazeSample(gaze);
+                        lastGaze = gaze;
+                    }
+                }
+                lock.lock();
+            }
+        }
+
         const std::unique_ptr<Client> m_omniceptClient;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        bool m_stop{false};
     };
 
     class PimaxEyeTracker : public EyeTrackerBase {
@@ -446,8 +684,8 @@ namespace {
             endSession();
         }
 
-        void beginSession(XrSession session) override {
-            EyeTrackerBase::beginSession(session);
+        void beginSession(XrSession session, XrSpace viewSpace) override {
+            EyeTrackerBase::beginSession(session, viewSpace);
 
             const auto status = aSeeVR_get_coefficient();
             if (status != ASEEVR_RETURN_CODE::success) {
@@ -466,11 +704,11 @@ namespace {
                 return false;
             }
 
-            // TODO: Use timestamp to implement a timeout.
+            if (!getGazeSampleAtFrameTime(projectedPoint)) {
+                return false;
+            }
 
             // We assume the point is projected onto a screen at Z=-1
-            projectedPoint.x = m_recommendedGaze.x - 0.5f;
-            projectedPoint.y = m_recommendedGaze.y - 0.5f;
             projectedPoint.z = -m_projectionDistance;
 
             return true;
@@ -491,15 +729,13 @@ namespace {
             }
         }
 
-        void setEyeData(int64_t timestamp, float recommendedGazeX, float recommendedGazeY) {
-            m_recommendedGaze = {recommendedGazeX, recommendedGazeY};
-            m_lastTimestamp = timestamp;
+        void setEyeData(float recommendedGazeX, float recommendedGazeY) {
+            // The device timestamp is not in a known time domain, so the sample is timestamped upon reception.
+            pushGazeSample({recommendedGazeX - 0.5f, recommendedGazeY - 0.5f, 0.f});
         }
 
         aSeeVRCoefficient m_coefficients;
         bool m_isDeviceReady{false};
-        XrVector2f m_recommendedGaze{0, 0};
-        int64_t m_lastTimestamp{0};
 
         static void _7INVENSUN_CALL stateCallback(const aSeeVRState* state, void* context) {
             switch (state->code) {
@@ -523,13 +759,10 @@ namespace {
 
             PimaxEyeTracker* tracker = reinterpret_cast<PimaxEyeTracker*>(context);
 
-            int64_t timestamp = 0;
-            aSeeVR_get_int64(eyeData, aSeeVREye::undefine_eye, aSeeVREyeDataItemType::timestamp, &timestamp);
-
             aSeeVRPoint2D point2D = {0};
             aSeeVR_get_point2d(eyeData, aSeeVREye::undefine_eye, aSeeVREyeDataItemType::gaze, &point2D);
 
-            tracker->setEyeData(timestamp, point2D.x, point2D.y);
+            tracker->setEyeData(point2D.x, point2D.y);
         }
 
         static void _7INVENSUN_CALL getCoefficientCallback(const aSeeVRCoefficient* data, void* context) {
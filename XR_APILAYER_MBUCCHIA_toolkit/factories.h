@@ -40,6 +40,12 @@ namespace toolkit {
 
         std::shared_ptr<ICpuTimer> CreateCpuTimer();
 
+        std::shared_ptr<IStatisticsRecorder> CreateStatisticsRecorder(const std::filesystem::path& basePath);
+
+        std::shared_ptr<IFrameLimiter> CreateFrameLimiter();
+
+        std::shared_ptr<IVideoMemoryBudget> CreateVideoMemoryBudget(ComPtr<IDXGIAdapter> adapter);
+
         uint32_t GetScaledInputSize(uint32_t outputSize, int scalePercent, uint32_t blockSize);
 
         bool UpdateKeyState(bool& keyState, const std::vector<int>& vkModifiers, int vkKey, bool isRepeat);
@@ -50,6 +56,13 @@ namespace toolkit {
         void EnableHighPrecisionTimer();
         void RestoreTimerPrecision();
 
+        // Frame threads are registered with MMCSS. When thread scheduling is enabled, they also prefer the P-cores of
+        // hybrid CPUs, and the background threads are kept away from them. Registration applies to the calling thread.
+        void EnableThreadScheduling(bool enable);
+        void RegisterThread(ThreadClass threadClass);
+        void UnregisterThread();
+        void RegisterAppRenderThread();
+
         bool IsServiceRunning(const std::string& name);
 
         void GetVRAMUsage(ComPtr<IDXGIAdapter> adapter, uint64_t& usage, uint8_t& percentUsed);
@@ -62,6 +75,10 @@ namespace toolkit {
 
         std::shared_ptr<IConfigManager> CreateConfigManager(const std::string& appName);
 
+        // The defaults of the settings read by the upscaling, foveated rendering and post-processing passes that do
+        // not depend on the application. Shared by the layer and the benchmark.
+        void SetProcessingDefaults(IConfigManager& configManager);
+
         std::pair<uint32_t, uint32_t> GetScaledDimensions(
             int settingScaling, int settingAnamophic, uint32_t outputWidth, uint32_t outputHeight, uint32_t blockSize);
         std::pair<float, float> GetScalingFactors(int settingScaling, int settingAnamophic);
@@ -85,16 +102,31 @@ namespace toolkit {
         void EnableD3D12DebugLayer();
         std::shared_ptr<IDevice> WrapD3D12Device(ID3D12Device* device,
                                                  ID3D12CommandQueue* queue,
-                                                 std::shared_ptr<config::IConfigManager> configManager,
-                                                 bool enableVarjoQuirk = false);
+                                                 std::shared_ptr<config::IConfigManager> configManager);
         std::shared_ptr<ITexture> WrapD3D12Texture(std::shared_ptr<IDevice> device,
                                                    const XrSwapchainCreateInfo& info,
                                                    ID3D12Resource* texture,
                                                    D3D12_RESOURCE_STATES initialState,
                                                    std::string_view debugName);
 
-        std::shared_ptr<IImageProcessor> CreateImageProcessor(
-            std::shared_ptr<toolkit::config::IConfigManager> configManager, std::shared_ptr<IDevice> graphicsDevice);
+        std::shared_ptr<IImageProcessor>
+        CreateImageProcessor(std::shared_ptr<toolkit::config::IConfigManager> configManager,
+                             std::shared_ptr<IDevice> graphicsDevice,
+                             const std::string& systemName);
+
+        std::shared_ptr<IGpuTimerPool> CreateGpuTimerPool(std::shared_ptr<IDevice> graphicsDevice);
+        std::shared_ptr<IGpuProfiler> CreateGpuProfiler(std::shared_ptr<IDevice> graphicsDevice);
+
+        std::shared_ptr<IScreenshotCapture> CreateScreenshotCapture(std::shared_ptr<IDevice> graphicsDevice);
+
+        std::shared_ptr<ITexturePool> CreateTexturePool(std::shared_ptr<IDevice> graphicsDevice);
+
+        std::shared_ptr<IFrameScheduler> CreateFrameScheduler(std::shared_ptr<IDevice> graphicsDevice);
+
+        std::shared_ptr<IDynamicResolutionController>
+        CreateDynamicResolutionController(std::shared_ptr<toolkit::config::IConfigManager> configManager);
+
+        std::shared_ptr<IGlyphAtlas> CreateGlyphAtlas(std::wstring_view fontFamily, uint32_t width, uint32_t height);
 
         std::shared_ptr<IFrameAnalyzer>
         CreateFrameAnalyzer(std::shared_ptr<toolkit::config::IConfigManager> configManager,
@@ -103,6 +135,13 @@ namespace toolkit {
                             uint32_t displayHeight,
                             FrameAnalyzerHeuristic heuristic = FrameAnalyzerHeuristic::Unknown);
 
+        // The shader is created once per candidate thread group size, which must be passed to the shader code.
+        std::shared_ptr<ITunedComputeShader>
+        CreateTunedComputeShader(std::shared_ptr<toolkit::config::IConfigManager> configManager,
+                                 std::shared_ptr<IDevice> graphicsDevice,
+                                 const std::string& name,
+                                 std::function<std::shared_ptr<IComputeShader>(const XrExtent2Di&)> createShader);
+
         std::shared_ptr<IImageProcessor>
         CreateNISUpscaler(std::shared_ptr<toolkit::config::IConfigManager> configManager,
                           std::shared_ptr<IDevice> graphicsDevice,
@@ -121,6 +160,12 @@ namespace toolkit {
                           int settingScaling,
                           int settingAnamorphic);
 
+        std::shared_ptr<IImageProcessor>
+        CreateTemporalUpscaler(std::shared_ptr<toolkit::config::IConfigManager> configManager,
+                               std::shared_ptr<IDevice> graphicsDevice,
+                               int settingScaling,
+                               int settingAnamorphic);
+
         std::shared_ptr<IVariableRateShader>
         CreateVariableRateShader(toolkit::OpenXrApi& openXR,
                                  std::shared_ptr<toolkit::config::IConfigManager> configManager,
@@ -133,6 +178,11 @@ namespace toolkit {
                                  bool hasVisibilityMask,
                                  bool needMirroredPattern);
 
+        std::shared_ptr<IHiddenAreaPrePass> CreateHiddenAreaPrePass(toolkit::OpenXrApi& openXR,
+                                                                    std::shared_ptr<IDevice> graphicsDevice,
+                                                                    uint32_t renderWidth,
+                                                                    uint32_t renderHeight);
+
         bool IsDeviceSupportingFP16(std::shared_ptr<IDevice> device);
 
         GpuArchitecture GetGpuArchitecture(UINT VendorId);
@@ -176,12 +226,20 @@ namespace toolkit {
             bool isVisibilityMaskSupported;
             bool isVisibilityMaskOverrideSupported;
             bool isCACorrectionNeed;
+            bool isFSRHalfPrecision;
             std::string runtimeName;
         };
 
         std::shared_ptr<IMenuHandler> CreateMenuHandler(std::shared_ptr<toolkit::config::IConfigManager> configManager,
                                                         std::shared_ptr<toolkit::graphics::IDevice> device,
                                                         const MenuInfo& menuInfo);
+
+        std::shared_ptr<ITelemetryPublisher> CreateTelemetryPublisher(const std::string& appName);
+
+        std::shared_ptr<IPerformanceSweeper>
+        CreatePerformanceSweeper(std::shared_ptr<toolkit::config::IConfigManager> configManager,
+                                 const std::filesystem::path& reportPath,
+                                 const PerformanceSweepInfo& info);
     } // namespace menu
 
 } // namespace toolkit
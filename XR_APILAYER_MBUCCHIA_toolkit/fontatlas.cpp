@@ -0,0 +1,260 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+#include <dwrite.h>
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    // Empty texels between glyphs, to avoid bleeding with linear filtering.
+    constexpr uint32_t GlyphPadding = 1;
+
+    class GlyphAtlas : public IGlyphAtlas {
+      public:
+        GlyphAtlas(std::wstring_view fontFamily, uint32_t width, uint32_t height)
+            : m_width(width), m_height(height), m_pixels(size_t(width) * height, 0) {
+            CHECK_HRCMD(DWriteCreateFactory(
+                DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), reinterpret_cast<IUnknown**>(set(m_factory))));
+
+            ComPtr<IDWriteFontCollection> fontCollection;
+            CHECK_HRCMD(m_factory->GetSystemFontCollection(set(fontCollection), FALSE));
+
+            UINT32 familyIndex = 0;
+            BOOL exists = FALSE;
+            CHECK_HRCMD(fontCollection->FindFamilyName(std::wstring(fontFamily).c_str(), &familyIndex, &exists));
+            if (!exists) {
+                // Fallback to Arial - won't have symbols but will have text.
+                CHECK_HRCMD(fontCollection->FindFamilyName(L"Arial", &familyIndex, &exists));
+                if (!exists) {
+                    throw std::runtime_error("Failed to find a font family");
+                }
+            }
+
+            ComPtr<IDWriteFontFamily> family;
+            CHECK_HRCMD(fontCollection->GetFontFamily(familyIndex, set(family)));
+            createFontFace(get(family), DWRITE_FONT_WEIGHT_NORMAL, m_fontFaces[to_integral(TextStyle::Normal)]);
+            createFontFace(get(family), DWRITE_FONT_WEIGHT_BOLD, m_fontFaces[to_integral(TextStyle::Bold)]);
+
+            m_fontFaces[to_integral(TextStyle::Normal)]->GetMetrics(&m_fontMetrics);
+        }
+
+        uint32_t getWidth() const override {
+            return m_width;
+        }
+
+        uint32_t getHeight() const override {
+            return m_height;
+        }
+
+        std::optional<GlyphInfo> getGlyph(wchar_t c, TextStyle style, float size) override {
+            // Quantize the size, since each size has its own set of glyphs.
+            const uint32_t pixelSize = (uint32_t)std::max(std::round(size), 1.f);
+            const uint64_t key = (uint64_t)c | ((uint64_t)to_integral(style) << 16) | ((uint64_t)pixelSize << 32);
+
+            const auto it = m_glyphs.find(key);
+            if (it != m_glyphs.cend()) {
+                return it->second;
+            }
+
+            GlyphInfo glyph{};
+            if (!rasterizeGlyph(c, style, (float)pixelSize, glyph)) {
+                // The atlas is full. The glyphs already placed this frame are still to be drawn, so we start over
+                // with the next frame (see nextFrame()). Until then, the glyph is laid out but not drawn.
+                if (!m_isResetPending) {
+                    Log("Glyph atlas is full, resetting (%zu glyphs)\n", m_glyphs.size());
+                    m_isResetPending = true;
+                }
+                return glyph;
+            }
+
+            m_glyphs.insert_or_assign(key, glyph);
+            return glyph;
+        }
+
+        float measureString(std::wstring_view string, TextStyle style, float size) override {
+            float width = 0.f;
+            for (const auto c : string) {
+                const auto glyph = getGlyph(c, style, size);
+                if (glyph) {
+                    width += glyph->advance;
+                }
+            }
+            return width;
+        }
+
+        const std::vector<uint8_t>& getPixels() const override {
+            return m_pixels;
+        }
+
+        bool isDirty() const override {
+            return m_isDirty;
+        }
+
+        void clearDirty() override {
+            m_isDirty = false;
+        }
+
+        void nextFrame() override {
+            if (!m_isResetPending) {
+                return;
+            }
+
+            m_glyphs.clear();
+            std::fill(m_pixels.begin(), m_pixels.end(), (uint8_t)0);
+            m_shelfX = m_shelfY = m_shelfHeight = 0;
+            m_isDirty = true;
+            m_isResetPending = false;
+        }
+
+      private:
+        void createFontFace(IDWriteFontFamily* family, DWRITE_FONT_WEIGHT weight, ComPtr<IDWriteFontFace>& fontFace) {
+            ComPtr<IDWriteFont> font;
+            CHECK_HRCMD(family->GetFirstMatchingFont(
+                weight, DWRITE_FONT_STRETCH_NORMAL, DWRITE_FONT_STYLE_NORMAL, set(font)));
+            CHECK_HRCMD(font->CreateFontFace(set(fontFace)));
+        }
+
+        // Rasterize the glyph and place it in the atlas. Returns false when the atlas is full, in which case only the
+        // advance of the glyph is set.
+        bool rasterizeGlyph(wchar_t c, TextStyle style, float size, GlyphInfo& glyph) {
+            auto& fontFace = m_fontFaces[to_integral(style)];
+            const float scale = size / m_fontMetrics.designUnitsPerEm;
+
+            const UINT32 codePoint = c;
+            UINT16 glyphIndex = 0;
+            CHECK_HRCMD(fontFace->GetGlyphIndices(&codePoint, 1, &glyphIndex));
+
+            DWRITE_GLYPH_METRICS metrics;
+            CHECK_HRCMD(fontFace->GetDesignGlyphMetrics(&glyphIndex, 1, &metrics));
+
+            glyph.advance = metrics.advanceWidth * scale;
+
+            const FLOAT advance = 0.f;
+            DWRITE_GLYPH_RUN glyphRun{};
+            glyphRun.fontFace = get(fontFace);
+            glyphRun.fontEmSize = size;
+            glyphRun.glyphCount = 1;
+            glyphRun.glyphIndices = &glyphIndex;
+            glyphRun.glyphAdvances = &advance;
+
+            // Place the baseline so that the glyph offsets are relative to the top of the line.
+            const float baseline = std::round(m_fontMetrics.ascent * scale);
+            ComPtr<IDWriteGlyphRunAnalysis> analysis;
+            CHECK_HRCMD(m_factory->CreateGlyphRunAnalysis(&glyphRun,
+                                                          1.f,
+                                                          nullptr,
+                                                          DWRITE_RENDERING_MODE_NATURAL,
+                                                          DWRITE_MEASURING_MODE_NATURAL,
+                                                          0.f,
+                                                          baseline,
+                                                          set(analysis)));
+
+            // The natural rendering mode only produces ClearType (3x1) textures.
+            RECT bounds;
+            CHECK_HRCMD(analysis->GetAlphaTextureBounds(DWRITE_TEXTURE_CLEARTYPE_3x1, &bounds));
+            if (bounds.right <= bounds.left || bounds.bottom <= bounds.top) {
+                // Whitespace.
+                return true;
+            }
+
+            const uint32_t width = bounds.right - bounds.left;
+            const uint32_t height = bounds.bottom - bounds.top;
+            if (width + 2 * GlyphPadding > m_width || height + 2 * GlyphPadding > m_height) {
+                return true;
+            }
+
+            // Simple shelf packing.
+            if (m_shelfX + width + 2 * GlyphPadding > m_width) {
+                m_shelfX = 0;
+                m_shelfY += m_shelfHeight;
+                m_shelfHeight = 0;
+            }
+            if (m_shelfY + height + 2 * GlyphPadding > m_height) {
+                return false;
+            }
+
+            std::vector<uint8_t> clearType(size_t(width) * height * 3);
+            CHECK_HRCMD(analysis->CreateAlphaTexture(
+                DWRITE_TEXTURE_CLEARTYPE_3x1, &bounds, clearType.data(), (UINT32)clearType.size()));
+
+            // Average the subpixels into a single coverage value.
+            const uint32_t x0 = m_shelfX + GlyphPadding;
+            const uint32_t y0 = m_shelfY + GlyphPadding;
+            for (uint32_t y = 0; y < height; y++) {
+                const uint8_t* src = clearType.data() + size_t(y) * width * 3;
+                uint8_t* dst = m_pixels.data() + size_t(y0 + y) * m_width + x0;
+                for (uint32_t x = 0; x < width; x++) {
+                    dst[x] = (uint8_t)((src[x * 3] + src[x * 3 + 1] + src[x * 3 + 2]) / 3);
+                }
+            }
+
+            glyph.offsetX = (float)bounds.left;
+            glyph.offsetY = (float)bounds.top;
+            glyph.width = width;
+            glyph.height = height;
+            glyph.u0 = (float)x0 / m_width;
+            glyph.v0 = (float)y0 / m_height;
+            glyph.u1 = (float)(x0 + width) / m_width;
+            glyph.v1 = (float)(y0 + height) / m_height;
+
+            m_shelfX += width + 2 * GlyphPadding;
+            m_shelfHeight = std::max(m_shelfHeight, height + 2 * GlyphPadding);
+            m_isDirty = true;
+
+            return true;
+        }
+
+        const uint32_t m_width;
+        const uint32_t m_height;
+
+        ComPtr<IDWriteFactory> m_factory;
+        ComPtr<IDWriteFontFace> m_fontFaces[2];
+        DWRITE_FONT_METRICS m_fontMetrics;
+
+        std::map<uint64_t, GlyphInfo> m_glyphs;
+        std::vector<uint8_t> m_pixels;
+        uint32_t m_shelfX{0};
+        uint32_t m_shelfY{0};
+        uint32_t m_shelfHeight{0};
+        bool m_isDirty{true};
+        bool m_isResetPending{false};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<IGlyphAtlas> CreateGlyphAtlas(std::wstring_view fontFamily, uint32_t width, uint32_t height) {
+        return std::make_shared<GlyphAtlas>(fontFamily, width, height);
+    }
+
+} // namespace toolkit::graphics
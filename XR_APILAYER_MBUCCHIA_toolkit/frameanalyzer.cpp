@@ -34,6 +34,18 @@ namespace {
     using namespace toolkit::graphics;
     using namespace toolkit::utilities;
 
+    // The number of frames to wait before falling back to the swapchain acquisition order.
+    constexpr uint32_t FallbackDelay = 100;
+
+    // The number of consecutive frames matching the heuristic before locking it. While locked, the eye swapchain images
+    // are only looked up among the ones seen recently, except every RevalidationPeriod frames.
+    constexpr uint32_t LockAfterFrames = 30;
+    constexpr uint32_t RevalidationPeriod = 90;
+    constexpr size_t MaxLockedImages = 8;
+
+    // The number of consecutive frames contradicting the heuristic before detecting it again.
+    constexpr uint32_t MaxMispredictions = 10;
+
     class FrameAnalyzer : public IFrameAnalyzer {
       public:
         FrameAnalyzer(std::shared_ptr<IConfigManager> configManager,
@@ -46,17 +58,23 @@ namespace {
         }
 
         void registerColorSwapchainImage(XrSwapchain swapchain, std::shared_ptr<ITexture> source, Eye eye) override {
-            m_eyeSwapchain[(int)eye].insert(swapchain);
-            m_eyeSwapchainImages[(int)eye].insert(source->getNativePtr());
+            m_eyeSwapchain[(int)eye].insert_or_assign(swapchain, true);
+            m_eyeSwapchainImages[(int)eye].insert_or_assign(source->getNativePtr(), true);
+
+            // The new image must be seen before locking again.
+            unlock();
         }
 
         void resetForFrame() override {
             m_hasSeenLeftEye = m_hasSeenRightEye = false;
+            m_firstEyeRenderTime.reset();
             m_hasCopiedLeftEye = m_hasCopiedRightEye = false;
 
             m_eyePrediction = m_firstEye;
             m_isPredictionValid = m_shouldPredictEye;
 
+            m_isFastPath = m_isLocked && (++m_framesSinceRevalidation % RevalidationPeriod) != 0;
+
             if (m_fallbackDelay) {
                 m_fallbackDelay--;
             }
@@ -83,10 +101,14 @@ namespace {
                     m_firstEye = Eye::Left;
                 }
 
-                TraceLoggingWrite(
-                    g_traceProvider, "FrameAnalyzer_TrySetHeuristic", TLArg((uint32_t)m_heuristic, "Heuristic"));
+                TraceLoggingWrite(g_traceProvider,
+                                  "FrameAnalyzer_TrySetHeuristic",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks),
+                                  TLArg((uint32_t)m_heuristic, "Heuristic"));
 
                 m_shouldPredictEye = m_heuristic != FrameAnalyzerHeuristic::Unknown;
+            } else {
+                validateHeuristic();
             }
         }
 
@@ -97,17 +119,33 @@ namespace {
                 return;
             }
 
-            const void* const nativePtr = renderTarget->getNativePtr();
+            const auto eye = findEyeSwapchainImage(renderTarget->getNativePtr());
 
             // Handle when the application uses the swapchain image directly.
-            if (m_eyeSwapchainImages[0].find(nativePtr) != m_eyeSwapchainImages[0].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedLeftEyeForwardRender");
+            if (eye == Eye::Left) {
+                if (!m_isFastPath) {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "FrameAnalyzer_DetectedLeftEyeForwardRender",
+                                      TraceLoggingKeyword(TLK_GraphicsHooks));
+                }
                 m_eyePrediction = Eye::Left;
                 m_hasSeenLeftEye = true;
-            } else if (m_eyeSwapchainImages[1].find(nativePtr) != m_eyeSwapchainImages[1].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedRightEyeForwardRender");
+            } else if (eye == Eye::Right) {
+                if (!m_isFastPath) {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "FrameAnalyzer_DetectedRightEyeForwardRender",
+                                      TraceLoggingKeyword(TLK_GraphicsHooks));
+                }
                 m_eyePrediction = Eye::Right;
                 m_hasSeenRightEye = true;
+            } else {
+                return;
+            }
+
+            if (!m_firstEyeRenderTime) {
+                LARGE_INTEGER qpcTimeNow;
+                QueryPerformanceCounter(&qpcTimeNow);
+                m_firstEyeRenderTime = qpcTimeNow;
             }
         }
 
@@ -122,11 +160,15 @@ namespace {
                 return;
             }
 
-            const void* const nativePtr = destination->getNativePtr();
+            const auto eye = findEyeSwapchainImage(destination->getNativePtr());
 
             // Handle when the application copies the texture to the swapchain image mid-pass. This is what FS2020 does.
-            if (m_eyeSwapchainImages[0].find(nativePtr) != m_eyeSwapchainImages[0].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedLeftEyeCopyOut");
+            if (eye == Eye::Left) {
+                if (!m_isFastPath) {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "FrameAnalyzer_DetectedLeftEyeCopyOut",
+                                      TraceLoggingKeyword(TLK_GraphicsHooks));
+                }
 
                 if (!m_hasCopiedLeftEye && !m_hasCopiedRightEye) {
                     m_firstEyeCopy = Eye::Left;
@@ -135,8 +177,12 @@ namespace {
                 // Switch to right eye now.
                 m_eyePrediction = Eye::Right;
                 m_hasCopiedLeftEye = true;
-            } else if (m_eyeSwapchainImages[1].find(nativePtr) != m_eyeSwapchainImages[1].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedRightEyeCopyOut");
+            } else if (eye == Eye::Right) {
+                if (!m_isFastPath) {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "FrameAnalyzer_DetectedRightEyeCopyOut",
+                                      TraceLoggingKeyword(TLK_GraphicsHooks));
+                }
 
                 if (!m_hasCopiedLeftEye && !m_hasCopiedRightEye) {
                     m_firstEyeCopy = Eye::Right;
@@ -150,13 +196,17 @@ namespace {
 
         void onAcquireSwapchain(XrSwapchain swapchain) override {
             // If we don't have a better heuristic, just use the swapchain acquisition order.
-            if (m_eyeSwapchain[0].find(swapchain) != m_eyeSwapchain[0].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedLeftEyeSwapchainAcquisition");
+            if (m_eyeSwapchain[0].contains(swapchain)) {
+                TraceLoggingWrite(g_traceProvider,
+                                  "FrameAnalyzer_DetectedLeftEyeSwapchainAcquisition",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
                 if (m_heuristic == FrameAnalyzerHeuristic::Fallback) {
                     m_eyePrediction = Eye::Left;
                 }
-            } else if (m_eyeSwapchain[1].find(swapchain) != m_eyeSwapchain[1].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedRightEyeSwapchainAcquisition");
+            } else if (m_eyeSwapchain[1].contains(swapchain)) {
+                TraceLoggingWrite(g_traceProvider,
+                                  "FrameAnalyzer_DetectedRightEyeSwapchainAcquisition",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
                 if (m_heuristic == FrameAnalyzerHeuristic::Fallback) {
                     m_eyePrediction = Eye::Right;
                 }
@@ -166,13 +216,17 @@ namespace {
         void onReleaseSwapchain(XrSwapchain swapchain) override {
             // If we don't have a better heuristic, just use the swapchain acquisition order.
             // Switch eye once a swapchain is released.
-            if (m_eyeSwapchain[0].find(swapchain) != m_eyeSwapchain[0].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedLeftEyeSwapchainRelease");
+            if (m_eyeSwapchain[0].contains(swapchain)) {
+                TraceLoggingWrite(g_traceProvider,
+                                  "FrameAnalyzer_DetectedLeftEyeSwapchainRelease",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
                 if (m_heuristic == FrameAnalyzerHeuristic::Fallback) {
                     m_eyePrediction = Eye::Right;
                 }
-            } else if (m_eyeSwapchain[1].find(swapchain) != m_eyeSwapchain[1].cend()) {
-                TraceLoggingWrite(g_traceProvider, "FrameAnalyzer_DetectedRightEyeSwapchainRelease");
+            } else if (m_eyeSwapchain[1].contains(swapchain)) {
+                TraceLoggingWrite(g_traceProvider,
+                                  "FrameAnalyzer_DetectedRightEyeSwapchainRelease",
+                                  TraceLoggingKeyword(TLK_GraphicsHooks));
                 if (m_heuristic == FrameAnalyzerHeuristic::Fallback) {
                     m_eyePrediction = Eye::Left;
                 }
@@ -190,15 +244,110 @@ namespace {
             return m_heuristic;
         }
 
+        std::optional<LARGE_INTEGER> getFirstEyeRenderTime() const override {
+            return m_firstEyeRenderTime;
+        }
+
       private:
+        std::optional<Eye> findEyeSwapchainImage(const void* nativePtr) {
+            if (!nativePtr) {
+                return std::nullopt;
+            }
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                auto& lockedImages = m_lockedImages[eye];
+                const auto lockedEnd = lockedImages.cbegin() + m_lockedImageCount[eye].load(std::memory_order_acquire);
+                if (std::find(lockedImages.cbegin(), lockedEnd, nativePtr) != lockedEnd) {
+                    return (Eye)eye;
+                }
+                if (m_isFastPath) {
+                    continue;
+                }
+
+                if (m_eyeSwapchainImages[eye].contains(nativePtr)) {
+                    // Remember the images in use, for when the heuristic is locked. The render targets may be bound
+                    // from several threads.
+                    std::unique_lock lock(m_lockedImagesLock);
+                    const auto count = m_lockedImageCount[eye].load(std::memory_order_relaxed);
+                    if (std::find(lockedImages.cbegin(), lockedImages.cbegin() + count, nativePtr) ==
+                        lockedImages.cbegin() + count) {
+                        if (count < MaxLockedImages) {
+                            lockedImages[count] = nativePtr;
+                            m_lockedImageCount[eye].store(count + 1, std::memory_order_release);
+                        } else {
+                            m_hasTooManyImages = true;
+                        }
+                    }
+                    return (Eye)eye;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        // Check whether the frame matched the heuristic, in order to lock it or to detect it again.
+        void validateHeuristic() {
+            bool isMatch;
+            if (m_heuristic == FrameAnalyzerHeuristic::ForwardRender) {
+                isMatch = m_hasSeenLeftEye && m_hasSeenRightEye;
+            } else if (m_heuristic == FrameAnalyzerHeuristic::DeferredCopy) {
+                isMatch = m_hasCopiedLeftEye && m_hasCopiedRightEye && m_firstEyeCopy == m_firstEye;
+            } else {
+                // The swapchain acquisition order does not depend on the render targets.
+                return;
+            }
+
+            // The frames without any eye swapchain image (eg: loading screens) are not conclusive.
+            if (!isMatch && !m_hasSeenLeftEye && !m_hasSeenRightEye && !m_hasCopiedLeftEye && !m_hasCopiedRightEye) {
+                return;
+            }
+
+            if (isMatch) {
+                m_mispredictions = 0;
+                if (!m_isLocked && ++m_matchedFrames >= LockAfterFrames && !m_hasTooManyImages) {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "FrameAnalyzer_Lock",
+                                      TraceLoggingKeyword(TLK_GraphicsHooks),
+                                      TLArg((uint32_t)m_heuristic, "Heuristic"));
+                    m_isLocked = true;
+                    m_framesSinceRevalidation = 0;
+                }
+                return;
+            }
+
+            TraceLoggingWrite(g_traceProvider,
+                              "FrameAnalyzer_Misprediction",
+                              TraceLoggingKeyword(TLK_GraphicsHooks),
+                              TLArg((uint32_t)m_heuristic, "Heuristic"),
+                              TLArg(m_isLocked, "Locked"));
+            unlock();
+            if (++m_mispredictions >= MaxMispredictions) {
+                Log("Frame analyzer mispredicted %u frames in a row, detecting the heuristic again\n",
+                    m_mispredictions);
+                m_heuristic = FrameAnalyzerHeuristic::Unknown;
+                m_shouldPredictEye = false;
+                m_fallbackDelay = FallbackDelay;
+                m_mispredictions = 0;
+            }
+        }
+
+        void unlock() {
+            m_isLocked = m_isFastPath = false;
+            m_matchedFrames = 0;
+            for (auto& count : m_lockedImageCount) {
+                count = 0;
+            }
+            m_hasTooManyImages = false;
+        }
+
         const std::shared_ptr<IConfigManager> m_configManager;
         const std::shared_ptr<IDevice> m_device;
         const uint32_t m_displayWidth;
         const uint32_t m_displayHeight;
         const FrameAnalyzerHeuristic m_forceHeuristic;
 
-        std::set<const void*> m_eyeSwapchainImages[ViewCount];
-        std::set<XrSwapchain> m_eyeSwapchain[ViewCount];
+        FlatMap<const void*, bool> m_eyeSwapchainImages[ViewCount];
+        FlatMap<XrSwapchain, bool> m_eyeSwapchain[ViewCount];
 
         bool m_hasSeenLeftEye{false};
         bool m_hasSeenRightEye{false};
@@ -212,7 +361,19 @@ namespace {
         Eye m_eyePrediction;
         Eye m_firstEye{Eye::Left};
 
-        uint32_t m_fallbackDelay{100};
+        uint32_t m_fallbackDelay{FallbackDelay};
+
+        bool m_isLocked{false};
+        bool m_isFastPath{false};
+        uint32_t m_matchedFrames{0};
+        uint32_t m_framesSinceRevalidation{0};
+        uint32_t m_mispredictions{0};
+        std::array<const void*, MaxLockedImages> m_lockedImages[ViewCount]{};
+        std::atomic<size_t> m_lockedImageCount[ViewCount]{};
+        std::mutex m_lockedImagesLock;
+        bool m_hasTooManyImages{false};
+
+        std::optional<LARGE_INTEGER> m_firstEyeRenderTime;
     };
 
 } // namespace
@@ -0,0 +1,203 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit::log;
+    using namespace toolkit::utilities;
+
+    using namespace std::chrono_literals;
+    using duration = std::chrono::steady_clock::duration;
+
+    // Bounds for the spin at the end of the wait. The spin absorbs the wake-up latency of the timer.
+    constexpr duration MinSpinMargin = 100us;
+    constexpr duration MaxSpinMargin = 2ms;
+    constexpr duration InitialSpinMargin = 500us;
+
+    // How long we want the runtime's own wait to be after ours. Too short and we risk missing its deadline.
+    constexpr duration InitialRuntimeWaitTarget = 1ms;
+    constexpr duration MaxRuntimeWaitTarget = 3ms;
+
+    // The deadline is only moved after observing several frames, and by a bounded amount each time.
+    constexpr uint32_t SlewWindow = 8;
+    constexpr duration MaxSlewStep = 250us;
+
+    inline int64_t ToMicroseconds(duration value) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(value).count();
+    }
+
+    class FrameLimiter : public IFrameLimiter {
+        using clock = std::chrono::steady_clock;
+
+      public:
+        FrameLimiter() {
+            // This flag was introduced in Windows 10 1803 and the definition is not available in older headers.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+            const DWORD CREATE_WAITABLE_TIMER_HIGH_RESOLUTION = 0x2;
+#endif
+
+            *m_timer.put() =
+                CreateWaitableTimerEx(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+            m_isHighResolution = !!m_timer;
+            if (!m_isHighResolution) {
+                *m_timer.put() = CreateWaitableTimerEx(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+            }
+            if (!m_timer) {
+                throw std::runtime_error("Failed to create waitable timer");
+            }
+
+            TraceLoggingWrite(g_traceProvider, "FrameLimiter_Create", TLArg(m_isHighResolution, "IsHighResolution"));
+        }
+
+        void wait(uint32_t frameRate) override {
+            const clock::duration period = std::chrono::duration_cast<clock::duration>(1s) / frameRate;
+            auto now = clock::now();
+
+            // Deadlines are spaced by exactly one period, so that an early or late wake-up is compensated on the next
+            // frame. We only start over when falling behind by more than a period, or when the frame rate changes.
+            if (period != m_period || m_deadline == clock::time_point{} || now > m_deadline + 2 * period) {
+                m_period = period;
+                m_deadline = now;
+                m_slew = {};
+                m_didWait = false;
+                return;
+            }
+            m_deadline += period + m_slew;
+            m_slew = {};
+
+            m_didWait = now < m_deadline;
+            if (!m_didWait) {
+                return;
+            }
+
+            // Sleep for the bulk of the time.
+            const auto sleepUntil = m_deadline - m_spinMargin;
+            if (now < sleepUntil) {
+                // A negative due time is relative, in 100ns units.
+                LARGE_INTEGER dueTime;
+                dueTime.QuadPart =
+                    -(std::chrono::duration_cast<std::chrono::nanoseconds>(sleepUntil - now).count() / 100);
+                if (SetWaitableTimer(m_timer.get(), &dueTime, 0, nullptr, nullptr, FALSE)) {
+                    WaitForSingleObject(m_timer.get(), INFINITE);
+                } else {
+                    std::this_thread::sleep_until(sleepUntil);
+                }
+                now = clock::now();
+
+                // Calibrate the spin based on how late the timer fires: follow the peaks and decay slowly.
+                const auto lateness = std::max(now - sleepUntil, clock::duration::zero());
+                m_timerLateness = std::max(lateness, m_timerLateness - (m_timerLateness - lateness) / 16);
+                m_spinMargin = std::clamp(m_timerLateness + 50us, MinSpinMargin, MaxSpinMargin);
+            }
+
+            // Spin on the performance counter for the last stretch.
+            const auto spinStart = now;
+            while (now < m_deadline) {
+                YieldProcessor();
+                now = clock::now();
+            }
+
+            TraceLoggingWrite(g_traceProvider,
+                              "FrameLimiter_Wait",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLArg(ToMicroseconds(now - m_deadline), "ErrorUs"),
+                              TLArg(ToMicroseconds(now - spinStart), "SpinUs"),
+                              TLArg(ToMicroseconds(m_spinMargin), "SpinMarginUs"));
+        }
+
+        void reportRuntimeWait(clock::duration runtimeWait) override {
+            // When we did not wait, the application is the bottleneck and there is nothing to slew.
+            if (!m_didWait) {
+                m_slewFrames = 0;
+                return;
+            }
+
+            // A sudden jump to a much longer wait means that our deadline moved past the runtime's, and that it waited
+            // for the next one instead. Keep a larger margin from now on.
+            if (m_lastRuntimeWait && runtimeWait > m_lastRuntimeWait.value() + m_period / 4) {
+                m_runtimeWaitTarget = std::min(m_runtimeWaitTarget + 500us, MaxRuntimeWaitTarget);
+            }
+            m_lastRuntimeWait = runtimeWait;
+
+            m_minRuntimeWait = m_slewFrames ? std::min(m_minRuntimeWait, runtimeWait) : runtimeWait;
+            if (++m_slewFrames < SlewWindow) {
+                return;
+            }
+            m_slewFrames = 0;
+
+            // Slowly move our deadline closer to the runtime's: the application starts its frame later, but still makes
+            // it for the same display time.
+            m_slew = std::clamp((m_minRuntimeWait - m_runtimeWaitTarget) / 2, -MaxSlewStep, MaxSlewStep);
+
+            TraceLoggingWrite(g_traceProvider,
+                              "FrameLimiter_Slew",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLArg(ToMicroseconds(m_minRuntimeWait), "RuntimeWaitUs"),
+                              TLArg(ToMicroseconds(m_runtimeWaitTarget), "TargetUs"),
+                              TLArg(ToMicroseconds(m_slew), "SlewUs"));
+        }
+
+        void reset() override {
+            m_deadline = {};
+            m_slew = {};
+            m_didWait = false;
+            m_lastRuntimeWait.reset();
+            m_slewFrames = 0;
+        }
+
+        bool isHighResolution() const override {
+            return m_isHighResolution;
+        }
+
+      private:
+        wil::unique_handle m_timer;
+        bool m_isHighResolution{false};
+
+        clock::duration m_period{};
+        clock::time_point m_deadline{};
+        bool m_didWait{false};
+
+        clock::duration m_timerLateness{};
+        clock::duration m_spinMargin{InitialSpinMargin};
+
+        clock::duration m_runtimeWaitTarget{InitialRuntimeWaitTarget};
+        std::optional<clock::duration> m_lastRuntimeWait;
+        clock::duration m_minRuntimeWait{};
+        uint32_t m_slewFrames{0};
+        clock::duration m_slew{};
+    };
+
+} // namespace
+
+namespace toolkit::utilities {
+
+    std::shared_ptr<IFrameLimiter> CreateFrameLimiter() {
+        return std::make_shared<FrameLimiter>();
+    }
+
+} // namespace toolkit::utilities
@@ -0,0 +1,178 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    struct FramePass {
+        std::string name;
+        std::vector<std::string> dependencies;
+        std::function<void()> record;
+        bool beforeComposition{false};
+    };
+
+    class FrameScheduler : public IFrameScheduler {
+      public:
+        FrameScheduler(std::shared_ptr<IDevice> graphicsDevice) : m_device(graphicsDevice) {
+        }
+
+        void registerPass(const std::string& name,
+                          const std::vector<std::string>& dependencies,
+                          std::function<void()> record) override {
+            if (name == CompositionPass || findPass(name) != m_passes.end()) {
+                throw std::runtime_error("Frame pass is already registered: " + name);
+            }
+
+            m_passes.push_back({name, dependencies, std::move(record)});
+            sortPasses();
+        }
+
+        void unregisterPass(const std::string& name) override {
+            auto it = findPass(name);
+            if (it != m_passes.end()) {
+                m_passes.erase(it);
+                sortPasses();
+            }
+        }
+
+        void beginFrame() override {
+            if (m_isRecording) {
+                throw std::runtime_error("Frame is already being recorded");
+            }
+
+            m_device->saveContext();
+            m_isRecording = true;
+
+            recordPasses(true);
+        }
+
+        void submitFrame() override {
+            if (!m_isRecording) {
+                throw std::runtime_error("Frame is not being recorded");
+            }
+
+            recordPasses(false);
+
+            m_device->restoreContext();
+            m_device->flushContext(false, true);
+            m_isRecording = false;
+        }
+
+      private:
+        void recordPasses(bool beforeComposition) {
+            for (const auto& pass : m_passes) {
+                if (pass.beforeComposition != beforeComposition) {
+                    continue;
+                }
+
+                TraceLoggingWrite(g_traceProvider, "FrameScheduler_RecordPass", TLArg(pass.name.c_str(), "Name"));
+                pass.record();
+            }
+        }
+
+        std::vector<FramePass>::iterator findPass(const std::string& name) {
+            return std::find_if(
+                m_passes.begin(), m_passes.end(), [&](const FramePass& pass) { return pass.name == name; });
+        }
+
+        // Order the passes after their dependencies, and otherwise in their order of registration. The dependencies
+        // on passes that are not registered are satisfied. The passes depending on the composition (directly or
+        // through another pass) come after it, and the other ones before it.
+        void sortPasses() {
+            std::vector<FramePass> sorted;
+            std::vector<bool> isPlaced(m_passes.size(), false);
+            while (sorted.size() < m_passes.size()) {
+                bool hasProgressed = false;
+                for (size_t i = 0; i < m_passes.size(); i++) {
+                    if (isPlaced[i]) {
+                        continue;
+                    }
+
+                    bool isReady = true;
+                    for (const auto& dependency : m_passes[i].dependencies) {
+                        for (size_t j = 0; j < m_passes.size(); j++) {
+                            if (!isPlaced[j] && m_passes[j].name == dependency) {
+                                isReady = false;
+                            }
+                        }
+                    }
+
+                    if (isReady) {
+                        auto& pass = m_passes[i];
+                        pass.beforeComposition = true;
+                        for (const auto& dependency : pass.dependencies) {
+                            if (dependency == CompositionPass) {
+                                pass.beforeComposition = false;
+                            }
+                            for (const auto& placed : sorted) {
+                                if (placed.name == dependency && !placed.beforeComposition) {
+                                    pass.beforeComposition = false;
+                                }
+                            }
+                        }
+
+                        sorted.push_back(pass);
+                        isPlaced[i] = true;
+                        hasProgressed = true;
+                        break;
+                    }
+                }
+
+                if (!hasProgressed) {
+                    throw std::runtime_error("Frame passes have circular dependencies");
+                }
+            }
+            m_passes = std::move(sorted);
+
+            for (const auto& pass : m_passes) {
+                TraceLoggingWrite(g_traceProvider,
+                                  "FrameScheduler_PassOrder",
+                                  TLArg(pass.name.c_str(), "Name"),
+                                  TLArg(pass.beforeComposition, "BeforeComposition"));
+            }
+        }
+
+        const std::shared_ptr<IDevice> m_device;
+
+        std::vector<FramePass> m_passes;
+        bool m_isRecording{false};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<IFrameScheduler> CreateFrameScheduler(std::shared_ptr<IDevice> graphicsDevice) {
+        return std::make_shared<FrameScheduler>(graphicsDevice);
+    }
+
+} // namespace toolkit::graphics
@@ -289,6 +289,10 @@ namespace LAYER_NAMESPACE {
             }
         }
 
+        if (XR_SUCCEEDED(result)) {
+            StartLogWriter();
+        }
+
         TraceLoggingWriteStop(local, "xrCreateApiLayerInstance", TLArg((int)result, "Result"));
 
         return result;
@@ -304,6 +308,7 @@ namespace LAYER_NAMESPACE {
             result = LAYER_NAMESPACE::GetInstance()->xrDestroyInstance(instance);
             if (XR_SUCCEEDED(result)) {
                 LAYER_NAMESPACE::ResetInstance();
+                StopLogWriter();
             }
         } catch (std::runtime_error& exc) {
             TraceLoggingWriteTagged(local, "xrDestroyInstance_Error", TLArg(exc.what(), "Error"));
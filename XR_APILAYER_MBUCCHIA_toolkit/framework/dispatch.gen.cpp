@@ -786,7 +786,11 @@ namespace LAYER_NAMESPACE
 			else if (apiName == "xrLocateSpace")
 			{
 				m_xrLocateSpace = reinterpret_cast<PFN_xrLocateSpace>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrLocateSpace);
+				if (IsOverrideNeeded(apiName))
+				{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrLocateSpace);
+				}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("xrLocateSpace", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_xrLocateSpace), "Override"));
 			}
 			else if (apiName == "xrDestroySpace")
 			{
@@ -886,32 +890,56 @@ namespace LAYER_NAMESPACE
 			else if (apiName == "xrGetActionStateBoolean")
 			{
 				m_xrGetActionStateBoolean = reinterpret_cast<PFN_xrGetActionStateBoolean>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetActionStateBoolean);
+				if (IsOverrideNeeded(apiName))
+				{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetActionStateBoolean);
+				}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("xrGetActionStateBoolean", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_xrGetActionStateBoolean), "Override"));
 			}
 			else if (apiName == "xrGetActionStateFloat")
 			{
 				m_xrGetActionStateFloat = reinterpret_cast<PFN_xrGetActionStateFloat>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetActionStateFloat);
+				if (IsOverrideNeeded(apiName))
+				{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetActionStateFloat);
+				}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("xrGetActionStateFloat", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_xrGetActionStateFloat), "Override"));
 			}
 			else if (apiName == "xrGetActionStatePose")
 			{
 				m_xrGetActionStatePose = reinterpret_cast<PFN_xrGetActionStatePose>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetActionStatePose);
+				if (IsOverrideNeeded(apiName))
+				{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetActionStatePose);
+				}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("xrGetActionStatePose", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_xrGetActionStatePose), "Override"));
 			}
 			else if (apiName == "xrSyncActions")
 			{
 				m_xrSyncActions = reinterpret_cast<PFN_xrSyncActions>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrSyncActions);
+				if (IsOverrideNeeded(apiName))
+				{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrSyncActions);
+				}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("xrSyncActions", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_xrSyncActions), "Override"));
 			}
 			else if (apiName == "xrApplyHapticFeedback")
 			{
 				m_xrApplyHapticFeedback = reinterpret_cast<PFN_xrApplyHapticFeedback>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrApplyHapticFeedback);
+				if (IsOverrideNeeded(apiName))
+				{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrApplyHapticFeedback);
+				}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("xrApplyHapticFeedback", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_xrApplyHapticFeedback), "Override"));
 			}
 			else if (apiName == "xrStopHapticFeedback")
 			{
 				m_xrStopHapticFeedback = reinterpret_cast<PFN_xrStopHapticFeedback>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrStopHapticFeedback);
+				if (IsOverrideNeeded(apiName))
+				{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrStopHapticFeedback);
+				}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("xrStopHapticFeedback", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_xrStopHapticFeedback), "Override"));
 			}
 			else if (apiName == "xrGetVisibilityMaskKHR")
 			{
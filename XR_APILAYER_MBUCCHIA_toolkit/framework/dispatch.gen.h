@@ -75,6 +75,13 @@ namespace LAYER_NAMESPACE
 		virtual XrResult xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
 		virtual XrResult xrCreateInstance(const XrInstanceCreateInfo* createInfo);
 
+		// Whether a function from the optional overrides must go through the layer. Returning false makes the calls go
+		// directly to the next layer or the runtime.
+		virtual bool IsOverrideNeeded(const std::string& apiName) const
+		{
+			return true;
+		}
+
 
 		// Auto-generated entries for the requested APIs.
 
@@ -50,6 +50,10 @@ if 'xrDestroyInstance' in layer_apis.override_functions:
 if 'xrCreateInstance' in layer_apis.requested_functions:
     raise Exception("xrDestroyInstance() cannot be specified in requested_functions")
 
+for function in layer_apis.optional_override_functions:
+    if function not in layer_apis.override_functions:
+        raise Exception(f"{function}() is specified in optional_override_functions but not in override_functions.")
+
 if 'xrGetInstanceProcAddr' in layer_apis.override_functions:
     raise Exception("xrGetInstanceProcAddr() is implicitly overriden and shall not be specified in override_functions. Use the xrGetInstanceProcAddr() virtual method.")
 if 'xrGetInstanceProcAddr' in layer_apis.requested_functions:
@@ -251,7 +255,18 @@ namespace LAYER_NAMESPACE
 '''
 
         for cur_cmd in self.core_commands + self.ext_commands:
-            if cur_cmd.name in layer_apis.override_functions:
+            if cur_cmd.name in layer_apis.optional_override_functions:
+                generated += f'''			else if (apiName == "{cur_cmd.name}")
+			{{
+				m_{cur_cmd.name} = reinterpret_cast<PFN_{cur_cmd.name}>(*function);
+				if (IsOverrideNeeded(apiName))
+				{{
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::{cur_cmd.name});
+				}}
+				TraceLoggingWrite(g_traceProvider, "OptionalOverride", TLArg("{cur_cmd.name}", "Name"), TLArg(*function != reinterpret_cast<PFN_xrVoidFunction>(m_{cur_cmd.name}), "Override"));
+			}}
+'''
+            elif cur_cmd.name in layer_apis.override_functions:
                 generated += f'''			else if (apiName == "{cur_cmd.name}")
 			{{
 				m_{cur_cmd.name} = reinterpret_cast<PFN_{cur_cmd.name}>(*function);
@@ -325,6 +340,13 @@ namespace LAYER_NAMESPACE
 		// Specially-handled by the auto-generated code.
 		virtual XrResult xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
 		virtual XrResult xrCreateInstance(const XrInstanceCreateInfo* createInfo);
+
+		// Whether a function from the optional overrides must go through the layer. Returning false makes the calls go
+		// directly to the next layer or the runtime.
+		virtual bool IsOverrideNeeded(const std::string& apiName) const
+		{
+			return true;
+		}
 '''
         write(preamble, file=self.outFile)
 
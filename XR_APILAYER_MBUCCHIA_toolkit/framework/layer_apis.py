@@ -34,6 +34,19 @@ override_functions = [
     "xrGetVisibilityMaskKHR",
 ]
 
+# The list of OpenXR functions from override_functions above that our layer may decide not to override.
+# When OpenXrApi::IsOverrideNeeded() returns false, the function pointer of the next layer or the runtime is handed out
+# directly, and the calls do not go through our layer at all.
+optional_override_functions = [
+    "xrLocateSpace",
+    "xrSyncActions",
+    "xrGetActionStateBoolean",
+    "xrGetActionStateFloat",
+    "xrGetActionStatePose",
+    "xrApplyHapticFeedback",
+    "xrStopHapticFeedback",
+]
+
 # The list of OpenXR functions our layer will use from the runtime.
 # Might repeat entries from override_functions above.
 requested_functions = [
@@ -45,6 +45,10 @@ namespace {
         uint32_t Const2[4];
         uint32_t Const3[4];
         uint32_t Const4[4];
+        uint32_t Const5[4]; // RCAS input offset (xy), output offset (zw)
+        uint32_t Const6[4]; // Output extent (xy)
+        uint32_t Const7[4]; // EASU input/output slices (xy), RCAS input/output slices (zw) (stereo only)
+        uint32_t Const8[4]; // Foveated region, relative to the output viewport (left, top, right, bottom)
     };
 
     class FSRUpscaler : public IImageProcessor {
@@ -54,7 +58,8 @@ namespace {
                     int settingScaling,
                     int settingAnamorphic)
             : m_configManager(configManager), m_device(graphicsDevice),
-              m_isSharpenOnly(settingScaling == 100 && settingAnamorphic <= 0) {
+              m_isSharpenOnly(settingScaling == 100 && settingAnamorphic <= 0),
+              m_isHalfPrecision(IsDeviceSupportingFP16(graphicsDevice)) {
             initializeScaler();
         }
 
@@ -65,37 +70,233 @@ namespace {
         void update() override {
         }
 
-        void process(std::shared_ptr<ITexture> input,
-                     std::shared_ptr<ITexture> output,
+        void process(const std::shared_ptr<ITexture>& input,
+                     const std::shared_ptr<ITexture>& output,
                      std::vector<std::shared_ptr<ITexture>>& textures,
+                     std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
                      std::array<uint8_t, 1024>& blob,
-                     std::optional<utilities::Eye> eye = std::nullopt) override {
-            // We need to use a per-instance blob.
-            static_assert(sizeof(FSRConstants) <= 1024);
-            FSRConstants* const config = reinterpret_cast<FSRConstants*>(blob.data());
+                     std::optional<utilities::Eye> eye = std::nullopt,
+                     const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr,
+                     std::optional<TextureRegion> inputRegion = std::nullopt,
+                     std::optional<TextureRegion> outputRegion = std::nullopt) override {
+            const auto inputRect = inputRegion ? inputRegion->rect : getFullRect(input);
+            const auto outputRect = outputRegion ? outputRegion->rect : getFullRect(output);
 
             // Update the scaler's configuration specifically for this image.
-            const auto inputWidth = input->getInfo().width;
-            const auto inputHeight = input->getInfo().height;
-            const auto outputWidth = output->getInfo().width;
-            const auto outputHeight = output->getInfo().height;
+            const auto slot = to_integral(eye.value_or(utilities::Eye::Both));
+            const FSRConstants newConfig = makeConstants(input, inputRect, outputRect, m_foveatedRegions[slot]);
+            auto configBuffer = uploadConstants(buffers, blob, slot, &newConfig, 1);
+
+            const auto threadGroups = getThreadGroups(outputRect.extent, 1);
+
+            m_device->beginProfileScope("FSR");
+            if (m_shaderSinglePass && isSinglePassScale(inputRect.extent, outputRect.extent)) {
+                // In fused mode, the post-processing is done at the end of the single pass.
+                const auto& shader =
+                    fusedPostProcess && m_shaderSinglePassFused ? m_shaderSinglePassFused : m_shaderSinglePass;
+                shader->updateThreadGroups(threadGroups);
+                m_device->setShader(shader, SamplerType::LinearClamp);
+                m_device->setShaderInput(0, configBuffer);
+                if (shader == m_shaderSinglePassFused) {
+                    m_device->setShaderInput(1, fusedPostProcess);
+                }
+                m_device->setShaderInput(0, input, inputRegion ? inputRegion->slice : -1);
+                m_device->setShaderOutput(0, output, outputRegion ? outputRegion->slice : -1);
+                m_device->dispatchShader();
+                m_device->endProfileScope();
+                return;
+            }
+
+            if (!m_isSharpenOnly) {
+                auto intermediate = getIntermediateTexture(textures, output, outputRect.extent, 1);
+
+                m_device->beginProfileScope("EASU");
+                m_shaderEASU->updateThreadGroups(threadGroups);
+                m_device->setShader(m_shaderEASU, SamplerType::LinearClamp);
+                m_device->setShaderInput(0, configBuffer);
+                m_device->setShaderInput(0, input, inputRegion ? inputRegion->slice : -1);
+                m_device->setShaderOutput(0, intermediate);
+                m_device->dispatchShader();
+                m_device->endProfileScope();
+            }
+
+            // In fused mode, the post-processing is done at the end of the RCAS pass.
+            m_device->beginProfileScope("RCAS");
+            const auto& shaderRCAS = fusedPostProcess && m_shaderRCASFused ? m_shaderRCASFused : m_shaderRCAS;
+            shaderRCAS->updateThreadGroups(threadGroups);
+            m_device->setShader(shaderRCAS, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, configBuffer);
+            if (shaderRCAS == m_shaderRCASFused) {
+                m_device->setShaderInput(1, fusedPostProcess);
+            }
+            if (m_isSharpenOnly) {
+                m_device->setShaderInput(0, input, inputRegion ? inputRegion->slice : -1);
+            } else {
+                m_device->setShaderInput(0, textures[0]);
+            }
+            m_device->setShaderOutput(0, output, outputRegion ? outputRegion->slice : -1);
+            m_device->dispatchShader();
+            m_device->endProfileScope();
+            m_device->endProfileScope();
+        }
+
+        bool isIdentity() const override {
+            return false;
+        }
+
+        bool isStereoSupported() const override {
+            return !!m_shaderRCASStereo;
+        }
+
+        void processStereo(const std::shared_ptr<ITexture>& input,
+                           const std::shared_ptr<ITexture>& output,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                           std::array<uint8_t, 1024>& blob,
+                           const std::array<TextureRegion, utilities::ViewCount>& inputRegions,
+                           const std::array<TextureRegion, utilities::ViewCount>& outputRegions,
+                           const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr) override {
+            // Update the scaler's configuration for both eyes at once.
+            FSRConstants newConfig[utilities::ViewCount];
+            XrExtent2Di maxExtent{0, 0};
+            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                newConfig[eye] =
+                    makeConstants(input, inputRegions[eye].rect, outputRegions[eye].rect, m_foveatedRegions[eye]);
+
+                // EASU writes to the slice of the intermediate texture for the eye, that RCAS reads from.
+                newConfig[eye].Const7[0] = inputRegions[eye].slice;
+                newConfig[eye].Const7[1] = eye;
+                newConfig[eye].Const7[2] = m_isSharpenOnly ? inputRegions[eye].slice : eye;
+                newConfig[eye].Const7[3] = outputRegions[eye].slice;
+
+                maxExtent.width = std::max(maxExtent.width, outputRegions[eye].rect.extent.width);
+                maxExtent.height = std::max(maxExtent.height, outputRegions[eye].rect.extent.height);
+            }
+            auto configBuffer = uploadConstants(buffers, blob, StereoSlot, newConfig, utilities::ViewCount);
+
+            // The eye index is in the Z dimension. Each eye discards the writes outside of its own viewport.
+            const auto threadGroups = getThreadGroups(maxExtent, utilities::ViewCount);
+
+            m_device->beginProfileScope("FSR");
+            if (m_shaderSinglePassStereo &&
+                isSinglePassScale(inputRegions[0].rect.extent, outputRegions[0].rect.extent) &&
+                isSinglePassScale(inputRegions[1].rect.extent, outputRegions[1].rect.extent)) {
+                const auto& shader = fusedPostProcess && m_shaderSinglePassFusedStereo ? m_shaderSinglePassFusedStereo
+                                                                                       : m_shaderSinglePassStereo;
+                shader->updateThreadGroups(threadGroups);
+                m_device->setShader(shader, SamplerType::LinearClamp);
+                m_device->setShaderInput(0, configBuffer);
+                if (shader == m_shaderSinglePassFusedStereo) {
+                    m_device->setShaderInput(1, fusedPostProcess);
+                }
+                m_device->setShaderInput(0, input, AllSlices);
+                m_device->setShaderOutput(0, output, AllSlices);
+                m_device->dispatchShader();
+                m_device->endProfileScope();
+                return;
+            }
+
+            if (!m_isSharpenOnly) {
+                auto intermediate = getIntermediateTexture(textures, output, maxExtent, utilities::ViewCount);
+
+                m_device->beginProfileScope("EASU");
+                m_shaderEASUStereo->updateThreadGroups(threadGroups);
+                m_device->setShader(m_shaderEASUStereo, SamplerType::LinearClamp);
+                m_device->setShaderInput(0, configBuffer);
+                m_device->setShaderInput(0, input, AllSlices);
+                m_device->setShaderOutput(0, intermediate, AllSlices);
+                m_device->dispatchShader();
+                m_device->endProfileScope();
+            }
+
+            m_device->beginProfileScope("RCAS");
+            const auto& shaderRCAS =
+                fusedPostProcess && m_shaderRCASFusedStereo ? m_shaderRCASFusedStereo : m_shaderRCASStereo;
+            shaderRCAS->updateThreadGroups(threadGroups);
+            m_device->setShader(shaderRCAS, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, configBuffer);
+            if (shaderRCAS == m_shaderRCASFusedStereo) {
+                m_device->setShaderInput(1, fusedPostProcess);
+            }
+            m_device->setShaderInput(0, m_isSharpenOnly ? input : textures[0], AllSlices);
+            m_device->setShaderOutput(0, output, AllSlices);
+            m_device->dispatchShader();
+            m_device->endProfileScope();
+            m_device->endProfileScope();
+        }
+
+        bool isFusedPostProcessSupported() const override {
+            return !!m_shaderRCASFused;
+        }
+
+        std::shared_ptr<IShaderBuffer>
+        getFusedPostProcessConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                     std::array<uint8_t, 1024>& blob,
+                                     std::optional<utilities::Eye> eye = std::nullopt) override {
+            return nullptr;
+        }
+
+        void setFoveatedRegion(utilities::Eye eye, const std::optional<FoveatedRegion>& region) override {
+            m_foveatedRegions[to_integral(eye)] = region;
+        }
+
+        void setTemporalView(utilities::Eye eye, const std::optional<TemporalViewInfo>& view) override {
+        }
+
+      private:
+        // The per-eye slots (see utilities::Eye) are followed by the slots for the stereo configuration.
+        static constexpr size_t StereoSlot = utilities::ViewCount + 1;
+
+        FSRConstants makeConstants(const std::shared_ptr<ITexture>& input,
+                                   const XrRect2Di& inputRect,
+                                   const XrRect2Di& outputRect,
+                                   const std::optional<FoveatedRegion>& foveatedRegion) const {
             const float sharpness = m_configManager->getValue(SettingSharpness) / 100.f;
 
+            FSRConstants config{};
             if (!m_isSharpenOnly) {
-                FsrEasuCon(config->Const0,
-                           config->Const1,
-                           config->Const2,
-                           config->Const3,
-                           static_cast<AF1>(inputWidth),
-                           static_cast<AF1>(inputHeight),
-                           static_cast<AF1>(inputWidth),
-                           static_cast<AF1>(inputHeight),
-                           static_cast<AF1>(outputWidth),
-                           static_cast<AF1>(outputHeight));
+                FsrEasuCon(config.Const0,
+                           config.Const1,
+                           config.Const2,
+                           config.Const3,
+                           static_cast<AF1>(inputRect.extent.width),
+                           static_cast<AF1>(inputRect.extent.height),
+                           static_cast<AF1>(input->getInfo().width),
+                           static_cast<AF1>(input->getInfo().height),
+                           static_cast<AF1>(outputRect.extent.width),
+                           static_cast<AF1>(outputRect.extent.height));
+
+                // Same as FsrEasuConOffset(): shift the input viewport.
+                config.Const0[2] = AU1_AF1(AF1_AU1(config.Const0[2]) + inputRect.offset.x);
+                config.Const0[3] = AU1_AF1(AF1_AU1(config.Const0[3]) + inputRect.offset.y);
+            }
+
+            // EASU writes to the origin of the intermediate texture, that RCAS reads from.
+            config.Const5[0] = m_isSharpenOnly ? inputRect.offset.x : 0;
+            config.Const5[1] = m_isSharpenOnly ? inputRect.offset.y : 0;
+            config.Const5[2] = outputRect.offset.x;
+            config.Const5[3] = outputRect.offset.y;
+            config.Const6[0] = outputRect.extent.width;
+            config.Const6[1] = outputRect.extent.height;
+
+            // Outside of the foveated region, EASU is replaced by a bilinear fetch and RCAS is skipped. The shader
+            // makes that decision for each thread group, so that the branches remain coherent.
+            config.Const8[2] = outputRect.extent.width;
+            config.Const8[3] = outputRect.extent.height;
+            if (foveatedRegion) {
+                // NDC to pixels (y flip).
+                const auto& c = foveatedRegion->center;
+                const auto& r = foveatedRegion->semiAxes;
+                const float w = (float)outputRect.extent.width;
+                const float h = (float)outputRect.extent.height;
+                config.Const8[0] = (uint32_t)std::clamp(std::floor((c.x - r.x + 1.f) * 0.5f * w), 0.f, w);
+                config.Const8[1] = (uint32_t)std::clamp(std::floor((1.f - c.y - r.y) * 0.5f * h), 0.f, h);
+                config.Const8[2] = (uint32_t)std::clamp(std::ceil((c.x + r.x + 1.f) * 0.5f * w), 0.f, w);
+                config.Const8[3] = (uint32_t)std::clamp(std::ceil((1.f - c.y + r.y) * 0.5f * h), 0.f, h);
             }
 
             const auto attenuation = 1.f - AClampF1(sharpness, 0, 1);
-            FsrRcasCon(config->Const4, static_cast<AF1>(attenuation));
+            FsrRcasCon(config.Const4, static_cast<AF1>(attenuation));
 
             // TODO:
             // The AMD FSR sample is using a value in the constant buffer to correct the output color accordingly.
@@ -105,48 +306,84 @@ namespace {
             //
             // config.Const4[3] = hdr ? 1 : 0;
 
-            // TODO: We can use an IShaderBuffer cache per swapchain and avoid this every frame.
-            m_configBuffer->uploadData(config, sizeof(*config));
+            return config;
+        }
 
-            // This value is the image region dimension that each thread group of the FSR shader operates on
-            const auto threadGroupWorkRegionDim = 16u;
-            const std::array<unsigned int, 3> threadGroups = {
-                (outputWidth + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim,  // dispatchX
-                (outputHeight + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim, // dispatchY
-                1};
+        std::shared_ptr<IShaderBuffer> uploadConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                                       std::array<uint8_t, 1024>& blob,
+                                                       size_t slot,
+                                                       const FSRConstants* newConfig,
+                                                       size_t count) {
+            // We need to use a per-instance blob, with one slot per eye and two slots for stereo.
+            static_assert(sizeof(FSRConstants) * (StereoSlot + utilities::ViewCount) <= 1024);
+            FSRConstants* const config = reinterpret_cast<FSRConstants*>(blob.data()) + slot;
+            const auto size = sizeof(FSRConstants) * count;
+
+            // Only upload the per-swapchain, per-eye constant buffer when the configuration has changed.
+            if (buffers.size() <= StereoSlot) {
+                buffers.resize(StereoSlot + 1);
+            }
+            auto& configBuffer = buffers[slot];
+            if (!configBuffer || memcmp(config, newConfig, size)) {
+                if (!configBuffer) {
+                    configBuffer = m_device->createBuffer(
+                        size, slot == StereoSlot ? "FSR Stereo Constants CB" : "FSR Constants CB");
+                }
+                memcpy(config, newConfig, size);
+                configBuffer->uploadData(config, size);
+            }
+
+            return configBuffer;
+        }
 
+        std::shared_ptr<ITexture> getIntermediateTexture(std::vector<std::shared_ptr<ITexture>>& textures,
+                                                         const std::shared_ptr<ITexture>& output,
+                                                         const XrExtent2Di& extent,
+                                                         uint32_t arraySize) {
             // Create the intermediate texture if needed.
-            if (!m_isSharpenOnly) {
-                const auto outputInfo = output->getInfo();
-                if (textures.empty() || textures[0]->getInfo().width != outputInfo.width ||
-                    textures[0]->getInfo().height != outputInfo.height) {
-                    textures.clear();
-                    auto createInfo = outputInfo;
+            if (textures.empty() || textures[0]->getInfo().width != extent.width ||
+                textures[0]->getInfo().height != extent.height || textures[0]->getInfo().arraySize != arraySize) {
+                // The previous texture may still be in use by the GPU.
+                for (auto& texture : textures) {
+                    m_device->releaseDeferred(std::move(texture));
+                }
+                textures.clear();
+                auto createInfo = output->getInfo();
 
-                    // Good balance between visuals and performance.
-                    createInfo.format = m_device->getTextureFormat(TextureFormat::R16G16B16A16_UNORM);
+                // One surface per eye, output viewport.
+                createInfo.arraySize = arraySize;
+                createInfo.mipCount = 1;
+                createInfo.width = extent.width;
+                createInfo.height = extent.height;
 
-                    createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
-                    textures.push_back(m_device->createTexture(createInfo, "FSR Intermediate TEX2D"));
-                }
+                // Good balance between visuals and performance.
+                createInfo.format = m_device->getTextureFormat(TextureFormat::R16G16B16A16_UNORM);
 
-                m_shaderEASU->updateThreadGroups(threadGroups);
-                m_device->setShader(m_shaderEASU, SamplerType::LinearClamp);
-                m_device->setShaderInput(0, m_configBuffer);
-                m_device->setShaderInput(0, input);
-                m_device->setShaderOutput(0, textures[0]);
-                m_device->dispatchShader();
+                createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                textures.push_back(m_device->createTexture(createInfo, "FSR Intermediate TEX2D"));
             }
 
-            m_shaderRCAS->updateThreadGroups(threadGroups);
-            m_device->setShader(m_shaderRCAS, SamplerType::LinearClamp);
-            m_device->setShaderInput(0, m_configBuffer);
-            m_device->setShaderInput(0, m_isSharpenOnly ? input : textures[0]);
-            m_device->setShaderOutput(0, output);
-            m_device->dispatchShader();
+            return textures[0];
+        }
+
+        static XrRect2Di getFullRect(const std::shared_ptr<ITexture>& texture) {
+            return {{0, 0}, {(int32_t)texture->getInfo().width, (int32_t)texture->getInfo().height}};
+        }
+
+        // The single pass is used within the scale factors that FSR is tuned for. Beyond that, the upscaling is done
+        // in two passes.
+        static bool isSinglePassScale(const XrExtent2Di& inputExtent, const XrExtent2Di& outputExtent) {
+            return outputExtent.width <= 2 * inputExtent.width && outputExtent.height <= 2 * inputExtent.height;
+        }
+
+        static std::array<unsigned int, 3> getThreadGroups(const XrExtent2Di& extent, unsigned int viewCount) {
+            // This value is the image region dimension that each thread group of the FSR shader operates on
+            const auto threadGroupWorkRegionDim = 16u;
+            return {(extent.width + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim,  // dispatchX
+                    (extent.height + (threadGroupWorkRegionDim - 1)) / threadGroupWorkRegionDim, // dispatchY
+                    viewCount};
         }
 
-      private:
         void initializeScaler() {
             const auto shadersDir = dllHome / "shaders";
             const auto shaderFile = shadersDir / "FSR.hlsl";
@@ -154,7 +391,8 @@ namespace {
             // EASU/RCAS common
             utilities::shader::Defines defines;
             defines.add("FSR_THREAD_GROUP_SIZE", 64);
-            defines.add("SAMPLE_SLOW_FALLBACK", 1);
+            // The packed FP16 variant is only usable when the GPU has native 16-bit ALUs.
+            defines.add("SAMPLE_SLOW_FALLBACK", !m_isHalfPrecision);
             defines.add("SAMPLE_BILINEAR", 0);
 
             // EASU specific
@@ -163,22 +401,105 @@ namespace {
             defines.add("SAMPLE_HDR_OUTPUT", 0);
             m_shaderEASU = m_device->createComputeShader(shaderFile, "mainCS", "FSR EASU CS", {}, defines.get());
 
+            // EASU/RCAS for both eyes of a texture array in a single dispatch (stereo mode)
+            const bool isStereo = m_configManager->getValue(SettingStereoDispatch);
+            if (isStereo) {
+                defines.add("FSR_STEREO", 1);
+                m_shaderEASUStereo =
+                    m_device->createComputeShader(shaderFile, "mainCS", "FSR EASU Stereo CS", {}, defines.get());
+                defines.set("FSR_STEREO", 0);
+            } else {
+                m_shaderEASUStereo.reset();
+            }
+
             // RCAS specific
             defines.set("SAMPLE_EASU", 0);
             defines.set("SAMPLE_RCAS", 1);
             defines.add("SAMPLE_HDR_OUTPUT", 1);
             m_shaderRCAS = m_device->createComputeShader(shaderFile, "mainCS", "FSR RCAS CS", {}, defines.get());
 
-            m_configBuffer = m_device->createBuffer(sizeof(FSRConstants), "FSR Constants CB");
+            // RCAS with post-processing (fused mode)
+            const bool isFused = m_configManager->getValue(SettingFusedPostProcess);
+            if (isFused) {
+                defines.add("POST_PROCESS_FUSED", 1);
+                m_shaderRCASFused =
+                    m_device->createComputeShader(shaderFile, "mainCS", "FSR RCAS Fused CS", {}, defines.get());
+            } else {
+                m_shaderRCASFused.reset();
+            }
+
+            if (isStereo) {
+                defines.set("FSR_STEREO", 1);
+                if (isFused) {
+                    m_shaderRCASFusedStereo = m_device->createComputeShader(
+                        shaderFile, "mainCS", "FSR RCAS Fused Stereo CS", {}, defines.get());
+                    defines.set("POST_PROCESS_FUSED", 0);
+                }
+                m_shaderRCASStereo =
+                    m_device->createComputeShader(shaderFile, "mainCS", "FSR RCAS Stereo CS", {}, defines.get());
+            } else {
+                m_shaderRCASStereo.reset();
+                m_shaderRCASFusedStereo.reset();
+            }
+
+            // EASU and RCAS in a single dispatch, through a groupshared tile. This removes the intermediate texture,
+            // but the larger groupshared footprint can hurt the occupancy on some GPUs (1 = all but Intel, 2 = all).
+            const int singlePass = m_configManager->getValue(SettingFSRSinglePass);
+            const bool isSinglePass =
+                !m_isSharpenOnly &&
+                (singlePass == 2 || (singlePass == 1 && m_device->GetGpuArchitecture() != GpuArchitecture::Intel));
+            m_shaderSinglePass.reset();
+            m_shaderSinglePassFused.reset();
+            m_shaderSinglePassStereo.reset();
+            m_shaderSinglePassFusedStereo.reset();
+            if (isSinglePass) {
+                utilities::shader::Defines singlePassDefines;
+                singlePassDefines.add("FSR_THREAD_GROUP_SIZE", 64);
+                singlePassDefines.add("SAMPLE_SLOW_FALLBACK", !m_isHalfPrecision);
+                singlePassDefines.add("SAMPLE_BILINEAR", 0);
+                singlePassDefines.add("SAMPLE_EASU", 1);
+                singlePassDefines.add("SAMPLE_RCAS", 1);
+                singlePassDefines.add("SAMPLE_HDR_OUTPUT", 1);
+                singlePassDefines.add("SAMPLE_SINGLE_PASS", 1);
+                singlePassDefines.add("FSR_STEREO", 0);
+                singlePassDefines.add("POST_PROCESS_FUSED", 0);
+                m_shaderSinglePass = m_device->createComputeShader(
+                    shaderFile, "mainCS", "FSR Single Pass CS", {}, singlePassDefines.get());
+                if (isFused) {
+                    singlePassDefines.set("POST_PROCESS_FUSED", 1);
+                    m_shaderSinglePassFused = m_device->createComputeShader(
+                        shaderFile, "mainCS", "FSR Single Pass Fused CS", {}, singlePassDefines.get());
+                }
+                if (isStereo) {
+                    singlePassDefines.set("FSR_STEREO", 1);
+                    if (isFused) {
+                        m_shaderSinglePassFusedStereo = m_device->createComputeShader(
+                            shaderFile, "mainCS", "FSR Single Pass Fused Stereo CS", {}, singlePassDefines.get());
+                    }
+                    singlePassDefines.set("POST_PROCESS_FUSED", 0);
+                    m_shaderSinglePassStereo = m_device->createComputeShader(
+                        shaderFile, "mainCS", "FSR Single Pass Stereo CS", {}, singlePassDefines.get());
+                }
+            }
         }
 
         const std::shared_ptr<IConfigManager> m_configManager;
         const std::shared_ptr<IDevice> m_device;
         const bool m_isSharpenOnly;
+        const bool m_isHalfPrecision;
 
         std::shared_ptr<IComputeShader> m_shaderEASU;
         std::shared_ptr<IComputeShader> m_shaderRCAS;
-        std::shared_ptr<IShaderBuffer> m_configBuffer;
+        std::shared_ptr<IComputeShader> m_shaderRCASFused;
+        std::shared_ptr<IComputeShader> m_shaderEASUStereo;
+        std::shared_ptr<IComputeShader> m_shaderRCASStereo;
+        std::shared_ptr<IComputeShader> m_shaderRCASFusedStereo;
+        std::shared_ptr<IComputeShader> m_shaderSinglePass;
+        std::shared_ptr<IComputeShader> m_shaderSinglePassFused;
+        std::shared_ptr<IComputeShader> m_shaderSinglePassStereo;
+        std::shared_ptr<IComputeShader> m_shaderSinglePassFusedStereo;
+
+        std::optional<FoveatedRegion> m_foveatedRegions[utilities::ViewCount + 1];
     };
 
 } // namespace
@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    // The upper bound of timers in flight for each pass. With D3D12, this must remain well within the capacity of
+    // the timestamp query heap.
+    constexpr size_t MaxTimersPerPass = 16;
+
+    // The upper bound of timers in flight for all the profiler scopes.
+    constexpr size_t MaxProfilerTimers = 64;
+
+    class GpuTimerPool : public IGpuTimerPool {
+      public:
+        GpuTimerPool(std::shared_ptr<IDevice> graphicsDevice) : m_device(graphicsDevice) {
+            for (auto& pass : m_passes) {
+                pass.free.reserve(MaxTimersPerPass);
+            }
+        }
+
+        void start(GpuPass pass) override {
+            auto& state = m_passes[(size_t)pass];
+            if (!state.active) {
+                if (state.free.empty()) {
+                    if (state.numTimers == MaxTimersPerPass) {
+                        // Too many measurements in flight: skip this one rather than stalling.
+                        return;
+                    }
+                    state.free.push_back(m_device->createTimer());
+                    state.numTimers++;
+                }
+                state.active = std::move(state.free.back());
+                state.free.pop_back();
+            }
+            state.active->start();
+        }
+
+        void stop(GpuPass pass) override {
+            auto& state = m_passes[(size_t)pass];
+            if (!state.active) {
+                return;
+            }
+            state.active->stop();
+            state.pending[(state.pendingHead + state.numPending) % MaxTimersPerPass] = std::move(state.active);
+            state.numPending++;
+        }
+
+        void poll() override {
+            for (auto& state : m_passes) {
+                // The timers of a pass complete in order, so stop at the first one that is not ready.
+                while (state.numPending) {
+                    auto& timer = state.pending[state.pendingHead];
+                    if (!timer->isReady()) {
+                        break;
+                    }
+                    state.lastDurationUs = timer->query();
+                    state.durationUs += state.lastDurationUs;
+                    state.free.push_back(std::move(timer));
+                    state.pendingHead = (state.pendingHead + 1) % MaxTimersPerPass;
+                    state.numPending--;
+                }
+            }
+        }
+
+        uint64_t query(GpuPass pass, bool reset) override {
+            auto& state = m_passes[(size_t)pass];
+            const auto durationUs = state.durationUs;
+            if (reset) {
+                state.durationUs = 0;
+            }
+            return durationUs;
+        }
+
+        uint64_t getLastDuration(GpuPass pass) const override {
+            return m_passes[(size_t)pass].lastDurationUs;
+        }
+
+      private:
+        struct PassTimers {
+            std::vector<std::shared_ptr<IGpuTimer>> free;
+            std::shared_ptr<IGpuTimer> active;
+            std::array<std::shared_ptr<IGpuTimer>, MaxTimersPerPass> pending;
+            size_t pendingHead{0};
+            size_t numPending{0};
+            size_t numTimers{0};
+            uint64_t durationUs{0};
+            uint64_t lastDurationUs{0};
+        };
+
+        const std::shared_ptr<IDevice> m_device;
+
+        std::array<PassTimers, (size_t)GpuPass::MaxValue> m_passes;
+    };
+
+    class GpuProfiler : public IGpuProfiler {
+      public:
+        GpuProfiler(std::shared_ptr<IDevice> graphicsDevice) : m_device(graphicsDevice) {
+            m_free.reserve(MaxProfilerTimers);
+            m_scopes.reserve(MaxGpuProfileScopes);
+        }
+
+        void beginScope(std::string_view name) override {
+            OpenScope scope;
+            scope.index = findScope(m_stack.empty() ? NoScope : m_stack.back().index, name);
+            if (scope.index != NoScope) {
+                if (m_free.empty() && m_numTimers < MaxProfilerTimers) {
+                    m_free.push_back(m_device->createTimer());
+                    m_numTimers++;
+                }
+
+                // Too many measurements in flight: skip this one rather than stalling.
+                if (!m_free.empty()) {
+                    scope.timer = std::move(m_free.back());
+                    m_free.pop_back();
+                    scope.timer->start();
+                }
+            }
+            m_stack.push_back(std::move(scope));
+        }
+
+        void endScope() override {
+            if (m_stack.empty()) {
+                return;
+            }
+            auto scope = std::move(m_stack.back());
+            m_stack.pop_back();
+            if (scope.timer) {
+                scope.timer->stop();
+                m_pending.push_back(std::move(scope));
+            }
+        }
+
+        void poll() override {
+            // The timers complete in the order they were stopped, so stop at the first one that is not ready.
+            while (!m_pending.empty()) {
+                auto& pending = m_pending.front();
+                if (!pending.timer->isReady()) {
+                    break;
+                }
+                const auto durationUs = pending.timer->query();
+                auto& scope = m_scopes[pending.index];
+                scope.durationUs += durationUs;
+
+                TraceLoggingWrite(g_traceProvider,
+                                  "GpuProfileScope",
+                                  TraceLoggingKeyword(TLK_Frame),
+                                  TLArg(scope.name.c_str(), "Name"),
+                                  TLArg(scope.depth, "Depth"),
+                                  TLArg(durationUs, "DurationUs"));
+
+                m_free.push_back(std::move(pending.timer));
+                m_pending.pop_front();
+            }
+        }
+
+        uint32_t query(GpuProfileScope* scopes, uint32_t maxScopes, bool reset) override {
+            uint32_t count = 0;
+            queryChildren(NoScope, scopes, maxScopes, count, reset);
+            return count;
+        }
+
+      private:
+        static constexpr size_t NoScope = ~size_t(0);
+
+        // Find or register the scope by its name under its parent. When an unregistered scope cannot be registered,
+        // neither it nor its children are measured.
+        size_t findScope(size_t parent, std::string_view name) {
+            if (parent == NoScope && !m_stack.empty()) {
+                return NoScope;
+            }
+            for (size_t i = 0; i < m_scopes.size(); i++) {
+                if (m_scopes[i].parent == parent && m_scopes[i].name == name) {
+                    return i;
+                }
+            }
+            if (m_scopes.size() == MaxGpuProfileScopes) {
+                return NoScope;
+            }
+            const uint32_t depth = parent != NoScope ? m_scopes[parent].depth + 1 : 0;
+            m_scopes.push_back({std::string(name), parent, depth, 0});
+            return m_scopes.size() - 1;
+        }
+
+        // List the children of the parent in the order they were registered, each followed by its own children.
+        void queryChildren(size_t parent, GpuProfileScope* scopes, uint32_t maxScopes, uint32_t& count, bool reset) {
+            for (size_t i = 0; i < m_scopes.size() && count < maxScopes; i++) {
+                auto& scope = m_scopes[i];
+                if (scope.parent != parent) {
+                    continue;
+                }
+                auto& output = scopes[count++];
+                strncpy_s(output.name, scope.name.c_str(), _TRUNCATE);
+                output.depth = scope.depth;
+                output.durationUs = scope.durationUs;
+                if (reset) {
+                    scope.durationUs = 0;
+                }
+                queryChildren(i, scopes, maxScopes, count, reset);
+            }
+        }
+
+        struct Scope {
+            std::string name;
+            size_t parent;
+            uint32_t depth;
+            uint64_t durationUs;
+        };
+
+        struct OpenScope {
+            size_t index{NoScope};
+            std::shared_ptr<IGpuTimer> timer;
+        };
+
+        const std::shared_ptr<IDevice> m_device;
+
+        std::vector<Scope> m_scopes;
+        std::vector<OpenScope> m_stack;
+        std::deque<OpenScope> m_pending;
+        std::vector<std::shared_ptr<IGpuTimer>> m_free;
+        size_t m_numTimers{0};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+    std::shared_ptr<IGpuTimerPool> CreateGpuTimerPool(std::shared_ptr<IDevice> graphicsDevice) {
+        return std::make_shared<GpuTimerPool>(graphicsDevice);
+    }
+
+    std::shared_ptr<IGpuProfiler> CreateGpuProfiler(std::shared_ptr<IDevice> graphicsDevice) {
+        auto profiler = std::make_shared<GpuProfiler>(graphicsDevice);
+        graphicsDevice->setProfiler(profiler);
+        return profiler;
+    }
+
+} // namespace toolkit::graphics
@@ -87,6 +87,108 @@ namespace {
 
     static constexpr XrTime GracePeriod = 2000000; // 2ms
 
+    // Absorbs the jitter of the predicted display times when comparing against the sampling interval.
+    static constexpr XrDuration SamplingTolerance = 1000000; // 1ms
+
+    // The number of samples of the hand joints kept for interpolation.
+    static constexpr uint32_t JointsPosesHistory = 4;
+
+    struct JointsPoses {
+        XrTime time{0};
+        XrHandJointLocationEXT jointsPoses[XR_HAND_JOINT_COUNT_EXT];
+        XrHandJointVelocityEXT jointsVelocities[XR_HAND_JOINT_COUNT_EXT];
+    };
+
+    // A sample is protected by a sequence lock: the sequence is odd while the sample is being written.
+    struct JointsPosesSample {
+        std::atomic<uint32_t> sequence{0};
+        JointsPoses data;
+    };
+
+    // The joints positions of both hands, in a SoA layout.
+    struct HandsJointsPositions {
+        float x[HandCount][XR_HAND_JOINT_COUNT_EXT];
+        float y[HandCount][XR_HAND_JOINT_COUNT_EXT];
+        float z[HandCount][XR_HAND_JOINT_COUNT_EXT];
+        bool valid[HandCount][XR_HAND_JOINT_COUNT_EXT];
+    };
+
+    // Enough room for all the gestures of both hands, rounded up to a multiple of 4.
+    static constexpr uint32_t MaxGestureJointsPairs = 24;
+
+    // The pairs of joints whose distance is used to detect the gestures, in a SoA layout. All the distances are
+    // evaluated in one pass, 4 pairs at a time.
+    struct GestureJointsPairs {
+        alignas(16) float x1[MaxGestureJointsPairs]{};
+        alignas(16) float y1[MaxGestureJointsPairs]{};
+        alignas(16) float z1[MaxGestureJointsPairs]{};
+        alignas(16) float x2[MaxGestureJointsPairs]{};
+        alignas(16) float y2[MaxGestureJointsPairs]{};
+        alignas(16) float z2[MaxGestureJointsPairs]{};
+        alignas(16) float nearDistance[MaxGestureJointsPairs]{};
+        alignas(16) float farDistance[MaxGestureJointsPairs]{};
+        alignas(16) float valid[MaxGestureJointsPairs]{};
+        alignas(16) float values[MaxGestureJointsPairs]{};
+        uint32_t count{0};
+
+        // Queue the pair for evaluation and return the index of its value.
+        int32_t add(const HandsJointsPositions& positions,
+                    uint32_t side1,
+                    uint32_t joint1,
+                    uint32_t side2,
+                    uint32_t joint2,
+                    float nearValue,
+                    float farValue) {
+            assert(count < MaxGestureJointsPairs);
+
+            x1[count] = positions.x[side1][joint1];
+            y1[count] = positions.y[side1][joint1];
+            z1[count] = positions.z[side1][joint1];
+            x2[count] = positions.x[side2][joint2];
+            y2[count] = positions.y[side2][joint2];
+            z2[count] = positions.z[side2][joint2];
+            nearDistance[count] = nearValue;
+            farDistance[count] = farValue;
+            valid[count] = positions.valid[side1][joint1] && positions.valid[side2][joint2] ? 1.f : 0.f;
+
+            return (int32_t)count++;
+        }
+
+        // Compute the scaled action value based on the distance between the 2 joints of each pair, or NaN if either
+        // joint is not tracked. Unused lanes are marked invalid.
+        void evaluate() {
+            using namespace DirectX;
+
+            for (uint32_t i = 0; i < count; i += 4) {
+                const XMVECTOR dx = XMVectorSubtract(XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&x1[i])),
+                                                     XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&x2[i])));
+                const XMVECTOR dy = XMVectorSubtract(XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&y1[i])),
+                                                     XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&y2[i])));
+                const XMVECTOR dz = XMVectorSubtract(XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&z1[i])),
+                                                     XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&z2[i])));
+
+                // We ignore joints radius and assume the near/far distance are configured to account for them.
+                const XMVECTOR distance =
+                    XMVectorSqrt(XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz))));
+
+                // Same as std::clamp(), without asserting on misconfigured near/far distances.
+                const XMVECTOR nearValue = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&nearDistance[i]));
+                const XMVECTOR farValue = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&farDistance[i]));
+                const XMVECTOR clamped = XMVectorMax(XMVectorMin(distance, farValue), nearValue);
+
+                const XMVECTOR value =
+                    XMVectorSubtract(g_XMOne,
+                                     XMVectorDivide(XMVectorSubtract(clamped, nearValue),
+                                                    XMVectorSubtract(farValue, nearValue)));
+
+                const XMVECTOR isInvalid =
+                    XMVectorEqual(XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(&valid[i])), XMVectorZero());
+                XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(&values[i]),
+                               XMVectorSelect(value, XMVectorSplatQNaN(), isInvalid));
+            }
+        }
+    };
+
     enum class PoseType { Grip, Aim };
 
     enum class Gesture { Pinch = 0, ThumbPress, IndexBend, FingerGun, Squeeze, Custom1, MaxValue };
@@ -98,7 +200,6 @@ namespace {
     };
 
     struct SubAction {
-        Hand hand;
         std::string path;
 
         bool synced{false};
@@ -113,9 +214,16 @@ namespace {
     };
 
     struct Action {
-        XrActionSet actionSet;
+        XrActionSet actionSet{XR_NULL_HANDLE};
 
-        std::map<XrPath, SubAction> subActions;
+        // The subaction bound for each hand, indexed by side.
+        std::optional<SubAction> subActions[HandCount];
+
+        // The side used when the subaction path is XR_NULL_PATH or is not bound.
+        uint32_t defaultSide{0};
+
+        // Whether the action set was active during the last xrSyncActions().
+        bool isActive{false};
     };
 
     struct Config {
@@ -280,19 +388,21 @@ namespace {
 
                 // Clear any previous mappings.
                 m_actions.clear();
+                m_actionIndices.clear();
+                m_systemClickAction.reset();
+                for (uint32_t side = 0; side < HandCount; side++) {
+                    m_actionsForPath[side].clear();
+                }
 
                 bool hasSystemClick = false;
                 for (uint32_t i = 0; i < bindings.countSuggestedBindings; i++) {
                     const std::string fullPath = getPath(bindings.suggestedBindings[i].binding);
 
-                    XrPath subActionPath;
-                    Hand hand;
+                    uint32_t side;
                     if (fullPath.find("/user/hand/left") == 0) {
-                        hand = Hand::Left;
-                        subActionPath = m_leftHandSubaction;
+                        side = 0;
                     } else if (fullPath.find("/user/hand/right") == 0) {
-                        hand = Hand::Right;
-                        subActionPath = m_rightHandSubaction;
+                        side = 1;
                     } else {
                         // We ignore non-hand actions.
                         continue;
@@ -306,8 +416,8 @@ namespace {
                     }
 
                     const XrAction action = bindings.suggestedBindings[i].action;
-                    auto actionIt = m_actions.find(action);
-                    if (actionIt == m_actions.end()) {
+                    auto actionIt = m_actionIndices.find(action);
+                    if (actionIt == m_actionIndices.end()) {
                         Action entry;
 
                         for (auto& actionSet : m_actionSets) {
@@ -317,15 +427,15 @@ namespace {
                             }
                         }
 
-                        actionIt = m_actions.insert_or_assign(bindings.suggestedBindings[i].action, entry).first;
+                        actionIt = m_actionIndices.insert_or_assign(action, (uint32_t)m_actions.size()).first;
+                        m_actions.push_back(std::move(entry));
                     }
-                    Action& entry = actionIt->second;
+                    Action& entry = m_actions[actionIt->second];
 
                     SubAction subAction;
-                    subAction.hand = hand;
                     subAction.path = fullPath;
                     DebugLog("Simulating action path %s\n", fullPath.c_str());
-                    entry.subActions.insert_or_assign(subActionPath, subAction);
+                    entry.subActions[side] = subAction;
                 }
 
                 // Dummy action to keep track of /input/system/click in case the application does not register it (which
@@ -336,37 +446,47 @@ namespace {
                     systemClick.actionSet = XR_NULL_HANDLE;
                     {
                         SubAction subAction;
-                        subAction.hand = Hand::Left;
                         subAction.path = "/user/hand/left/input/system/click";
-                        systemClick.subActions.insert_or_assign(m_leftHandSubaction, subAction);
+                        systemClick.subActions[0] = subAction;
                     }
                     {
                         SubAction subAction;
-                        subAction.hand = Hand::Left;
                         subAction.path = "/user/hand/right/input/system/click";
-                        systemClick.subActions.insert_or_assign(m_rightHandSubaction, subAction);
+                        systemClick.subActions[1] = subAction;
                     }
 
-                    m_actions.insert_or_assign(XR_NULL_HANDLE, systemClick);
+                    m_actionIndices.insert_or_assign(XR_NULL_HANDLE, (uint32_t)m_actions.size());
+                    m_actions.push_back(std::move(systemClick));
+                }
+
+                for (uint32_t i = 0; i < m_actions.size(); i++) {
+                    Action& action = m_actions[i];
+
+                    // Without a (bound) subaction path, use the hand with the lowest subaction path.
+                    if (action.subActions[0] && action.subActions[1]) {
+                        action.defaultSide = m_leftHandSubaction < m_rightHandSubaction ? 0 : 1;
+                    } else {
+                        action.defaultSide = action.subActions[0] ? 0 : 1;
+                    }
+
+                    // Keep track of the /input/system/click
+                    // path.endswith("/input/system/click")
+                    static std::string_view systemClickPath = "/input/system/click";
+                    const auto& path = action.subActions[action.defaultSide]->path;
+                    if (path.rfind(systemClickPath) == path.length() - systemClickPath.length()) {
+                        m_systemClickAction = i;
+                    }
                 }
             }
         }
 
         const std::string getFullPath(XrAction action, XrPath subActionPath) override {
-            const auto& actionIt = m_actions.find(action);
-            if (actionIt == m_actions.cend()) {
+            const Action* entry = findAction(action);
+            if (!entry) {
                 return {};
             }
 
-            auto subActionIt = actionIt->second.subActions.find(subActionPath);
-            if (subActionIt == actionIt->second.subActions.cend()) {
-                if (actionIt->second.subActions.empty()) {
-                    return {};
-                }
-                subActionIt = actionIt->second.subActions.begin();
-            }
-
-            return subActionIt->second.path;
+            return entry->subActions[getSubActionSide(*entry, subActionPath)]->path;
         }
 
         void beginSession(XrSession session, std::shared_ptr<toolkit::graphics::IDevice> graphicsDevice) override {
@@ -409,6 +529,16 @@ namespace {
                 m_openXR.xrDestroySpace(m_referenceSpace);
                 m_referenceSpace = XR_NULL_HANDLE;
             }
+            {
+                // The samples are relative to the reference space.
+                std::unique_lock lock(m_jointsPosesWriteLock);
+                for (auto& head : m_jointsPosesHead) {
+                    head = 0;
+                }
+            }
+            for (auto& head : m_gesturesJointsPosesHead) {
+                head = 0;
+            }
             for (uint32_t i = 0; i < HandCount; i++) {
                 if (m_handTracker[i] != XR_NULL_HANDLE) {
                     m_openXR.xrDestroyHandTrackerEXT(m_handTracker[i]);
@@ -432,27 +562,23 @@ namespace {
 
                     std::string line(buffer);
                     m_config.ParseConfigurationStatement(line);
-                }
-            }
 
-            // Delete outdated entries from the cache.
-            {
-                std::unique_lock lock(m_cacheLock);
-                for (auto& spaceCache : m_cachedHandJointsPoses) {
-                    auto& cache = spaceCache.second;
+                    // The actions paths for the gestures might have changed.
                     for (uint32_t side = 0; side < HandCount; side++) {
-                        while (cache[side].size() > 0 && cache[side].front().first + GracePeriod < now) {
-                            cache[side].pop_front();
-                        }
-
-                        // Update statistics.
-                        if (spaceCache.first == m_preferredBaseSpace.value_or(m_referenceSpace)) {
-                            m_gesturesState.cacheSize[side] = cache[side].size();
-                        }
+                        m_actionsForPath[side].clear();
                     }
                 }
             }
 
+            // Update statistics.
+            for (uint32_t side = 0; side < HandCount; side++) {
+                m_gesturesState.cacheSize[side] = std::min(m_jointsPosesHead[side].load(), JointsPosesHistory);
+            }
+
+            // Limit how often the joints are sampled. The poses are extrapolated in between.
+            const int samplingRate = m_configManager->getValue(SettingHandTrackingRate);
+            m_samplingInterval.store(samplingRate > 0 ? 1'000'000'000 / samplingRate : 0, std::memory_order_relaxed);
+
             // Inhibit one and or the other if request. The config file acts as a global override.
             const auto handTrackingEnabled =
                 m_configManager->getEnumValue<HandTrackingEnabled>(SettingHandTrackingEnabled);
@@ -462,52 +588,49 @@ namespace {
                                                                handTrackingEnabled == HandTrackingEnabled::Right);
 
             // Get joints poses.
+            XrHandJointLocationEXT jointsPoses[HandCount][XR_HAND_JOINT_COUNT_EXT];
             const XrHandJointLocationEXT* leftHandJointsPoses = nullptr;
             if (m_leftHandEnabled) {
-                leftHandJointsPoses = getCachedHandJointsPoses(
-                    Hand::Left, m_thisFrameTime, now, m_preferredBaseSpace.value_or(m_referenceSpace));
+                getHandJointsPoses(Hand::Left, m_thisFrameTime, now, std::nullopt, jointsPoses[0]);
+                leftHandJointsPoses = jointsPoses[0];
             }
             const XrHandJointLocationEXT* rightHandJointsPoses = nullptr;
             if (m_rightHandEnabled) {
-                rightHandJointsPoses = getCachedHandJointsPoses(
-                    Hand::Right, m_thisFrameTime, now, m_preferredBaseSpace.value_or(m_referenceSpace));
+                getHandJointsPoses(Hand::Right, m_thisFrameTime, now, std::nullopt, jointsPoses[1]);
+                rightHandJointsPoses = jointsPoses[1];
             }
 
             // Only sync actions for the specified action sets.
-            std::set<XrAction> ignore;
-            const Action* systemClick = nullptr;
             for (auto& action : m_actions) {
-                bool foundActionSet = false;
+                action.isActive = false;
                 for (uint32_t i = 0; i < syncInfo.countActiveActionSets; i++) {
-                    if (action.second.actionSet == XR_NULL_HANDLE ||
-                        action.second.actionSet == syncInfo.activeActionSets[i].actionSet) {
+                    if (action.actionSet == XR_NULL_HANDLE ||
+                        action.actionSet == syncInfo.activeActionSets[i].actionSet) {
                         // TODO: We ignore the subActionPath at this time. This is largely OK and mean we might be
                         // non-compliant to some edge cases.
-                        foundActionSet = true;
+                        action.isActive = true;
                         break;
                     }
                 }
 
-                if (!foundActionSet) {
-                    ignore.insert(action.first);
-                }
-
-                const auto& subAction = *action.second.subActions.cbegin();
-                const auto& path = subAction.second.path;
-                static std::string_view systemClickPath = "/input/system/click";
-                // Keep track of the /input/system/click
-                // path.endswith("/input/system/click")
-                if (path.rfind(systemClickPath) == path.length() - systemClickPath.length()) {
-                    systemClick = &action.second;
-                }
-
-                for (auto& subAction : action.second.subActions) {
-                    subAction.second.synced = false;
+                for (auto& subAction : action.subActions) {
+                    if (subAction) {
+                        subAction->synced = false;
+                    }
                 }
             }
 
-            // For each gesture, update the action value.
-            performGesturesDetection(leftHandJointsPoses, rightHandJointsPoses, ignore, now);
+            // For each gesture, update the action value. There is nothing new to evaluate until the joints are sampled
+            // again, and the actions retain their values.
+            bool hasNewJointsPoses = false;
+            for (uint32_t side = 0; side < HandCount; side++) {
+                const auto head = m_jointsPosesHead[side].load(std::memory_order_acquire);
+                hasNewJointsPoses = hasNewJointsPoses || head != m_gesturesJointsPosesHead[side];
+                m_gesturesJointsPosesHead[side] = head;
+            }
+            if (hasNewJointsPoses) {
+                performGesturesDetection(leftHandJointsPoses, rightHandJointsPoses, now);
+            }
 
             // Check for keepalive.
             if (!m_config.keepaliveAction.empty() && m_config.keepaliveInterval) {
@@ -515,7 +638,7 @@ namespace {
                     if (m_lastKeepalive) {
                         for (uint32_t side = 0; side < HandCount; side++) {
                             const Hand hand = (Hand)side;
-                            recordActionValue(hand, m_config.keepaliveAction, ignore, 1.f, now);
+                            recordActionValue(hand, m_config.keepaliveAction, 1.f, now);
                         }
                     }
 
@@ -524,13 +647,15 @@ namespace {
             }
 
             // Special handling for Windows key.
-            if (systemClick) {
+            if (m_systemClickAction) {
                 bool didChange = false;
                 bool value = false;
 
-                for (auto& subAction : systemClick->subActions) {
-                    didChange = didChange || subAction.second.boolValueChanged;
-                    value = value || subAction.second.boolValue;
+                for (const auto& subAction : m_actions[m_systemClickAction.value()].subActions) {
+                    if (subAction) {
+                        didChange = didChange || subAction->boolValueChanged;
+                        value = value || subAction->boolValue;
+                    }
                 }
 
                 if (didChange && value) {
@@ -558,20 +683,11 @@ namespace {
                 // see the zero'ed action. If any action was not 0, we set the tracked bit again to give the app one
                 // more chance to see the changes.
                 if (m_trackedRecently[side] && !tracked) {
-                    const XrPath subactionPath = side == 0 ? m_leftHandSubaction : m_rightHandSubaction;
                     for (auto& action : m_actions) {
-                        auto subActionIt = action.second.subActions.find(subactionPath);
-                        if (subActionIt == action.second.subActions.cend()) {
-                            if (action.second.subActions.empty()) {
-                                continue;
-                            }
-                            const auto& fullPath = action.second.subActions.begin()->second.path;
-                            if ((side == 0 && fullPath.find("/user/hand/left") != 0) ||
-                                (side == 1 && fullPath.find("/user/hand/right") != 0)) {
-                                continue;
-                            }
+                        if (!action.subActions[side]) {
+                            continue;
                         }
-                        auto& subAction = subActionIt->second;
+                        auto& subAction = action.subActions[side].value();
                         // We must only set changed if the value is actually different.
                         subAction.floatValueChanged = std::abs(subAction.floatValue) > FLT_EPSILON;
                         subAction.floatValue = 0.f;
@@ -611,7 +727,8 @@ namespace {
                 return false;
             }
 
-            const auto& jointsPoses = getCachedHandJointsPoses(actionSpace.hand, time, now, baseSpace);
+            XrHandJointLocationEXT jointsPoses[XR_HAND_JOINT_COUNT_EXT];
+            getHandJointsPoses(actionSpace.hand, time, now, baseSpace, jointsPoses);
 
             const uint32_t side = actionSpace.hand == Hand::Left ? 0 : 1;
             const uint32_t joint =
@@ -641,13 +758,15 @@ namespace {
                 return;
             }
 
+            // All the joints of both hands are drawn in a single instanced draw.
+            m_jointInstances.clear();
             for (uint32_t hand = 0; hand < HandCount; hand++) {
                 if ((!m_leftHandEnabled && hand == 0) || (!m_rightHandEnabled && hand == 1)) {
                     continue;
                 }
 
-                const auto& jointsPoses =
-                    getCachedHandJointsPoses(hand ? Hand::Right : Hand::Left, m_thisFrameTime, now, baseSpace);
+                XrHandJointLocationEXT jointsPoses[XR_HAND_JOINT_COUNT_EXT];
+                getHandJointsPoses(hand ? Hand::Right : Hand::Left, m_thisFrameTime, now, baseSpace, jointsPoses);
 
                 for (uint32_t joint = 0; joint < XR_HAND_JOINT_COUNT_EXT; joint++) {
                     if (!xr::math::Pose::IsPoseValid(jointsPoses[joint].locationFlags)) {
@@ -657,35 +776,25 @@ namespace {
                     XrVector3f scaling{jointsPoses[joint].radius,
                                        std::min(0.0025f, jointsPoses[joint].radius),
                                        std::max(0.015f, jointsPoses[joint].radius)};
-                    m_graphicsDevice->draw(m_jointMesh[meshIndex], jointsPoses[joint].pose, scaling);
+                    m_jointInstances.push_back({jointsPoses[joint].pose, scaling});
                 }
             }
-
-            // The sync() method only cares for relative hand joints poses. Try to force reuse of cached entries by
-            // making sync() query with the same base space.
-            m_preferredBaseSpace = baseSpace;
+            m_graphicsDevice->beginProfileScope("Hands");
+            m_graphicsDevice->drawInstanced(m_jointMesh[meshIndex], m_jointInstances);
+            m_graphicsDevice->endProfileScope();
         }
 
         bool getActionState(const XrActionStateGetInfo& getInfo, XrActionStateBoolean& state) const override {
-            const auto& actionIt = m_actions.find(getInfo.action);
-            if (actionIt == m_actions.cend()) {
+            const Action* action = findAction(getInfo.action);
+            if (!action) {
                 return false;
             }
-            const auto& action = actionIt->second;
-
-            auto subActionIt = action.subActions.find(getInfo.subactionPath);
-            if (subActionIt == actionIt->second.subActions.cend()) {
-                if (actionIt->second.subActions.empty()) {
-                    return false;
-                }
-                subActionIt = actionIt->second.subActions.begin();
-            }
-            const auto& subAction = subActionIt->second;
 
-            if ((subAction.hand == Hand::Left && !m_leftHandEnabled) ||
-                (subAction.hand == Hand::Right && !m_rightHandEnabled)) {
+            const uint32_t side = getSubActionSide(*action, getInfo.subactionPath);
+            if ((side == 0 && !m_leftHandEnabled) || (side == 1 && !m_rightHandEnabled)) {
                 return false;
             }
+            const auto& subAction = action->subActions[side].value();
 
             state.isActive = XR_TRUE;
             state.currentState = subAction.boolValue;
@@ -696,25 +805,16 @@ namespace {
         }
 
         bool getActionState(const XrActionStateGetInfo& getInfo, XrActionStateFloat& state) const override {
-            const auto& actionIt = m_actions.find(getInfo.action);
-            if (actionIt == m_actions.cend()) {
+            const Action* action = findAction(getInfo.action);
+            if (!action) {
                 return false;
             }
-            const auto& action = actionIt->second;
 
-            auto subActionIt = action.subActions.find(getInfo.subactionPath);
-            if (subActionIt == actionIt->second.subActions.cend()) {
-                if (actionIt->second.subActions.empty()) {
-                    return false;
-                }
-                subActionIt = actionIt->second.subActions.begin();
-            }
-            const auto& subAction = subActionIt->second;
-
-            if ((subAction.hand == Hand::Left && !m_leftHandEnabled) ||
-                (subAction.hand == Hand::Right && !m_rightHandEnabled)) {
+            const uint32_t side = getSubActionSide(*action, getInfo.subactionPath);
+            if ((side == 0 && !m_leftHandEnabled) || (side == 1 && !m_rightHandEnabled)) {
                 return false;
             }
+            const auto& subAction = action->subActions[side].value();
 
             state.isActive = XR_TRUE;
             state.currentState = subAction.floatValue;
@@ -773,97 +873,226 @@ namespace {
             return str;
         }
 
-        const XrHandJointLocationEXT*
-        getCachedHandJointsPoses(Hand hand, XrTime time, XrTime now, std::optional<XrSpace> baseSpace) const {
+        // Derive the joints poses for any time and base space from the samples taken in our reference space. Readers
+        // never block. Only taking a new sample takes the lock, in order to serialize the writers.
+        void getHandJointsPoses(Hand hand,
+                                XrTime time,
+                                XrTime now,
+                                std::optional<XrSpace> baseSpace,
+                                XrHandJointLocationEXT (&jointsPoses)[XR_HAND_JOINT_COUNT_EXT]) const {
             const uint32_t side = hand == Hand::Left ? 0 : 1;
 
-            std::unique_lock lock(m_cacheLock);
+            // Only sample the joints once per frame (a later time than the latest sample means a new frame), and no
+            // more often than the sampling rate.
+            const XrDuration samplingInterval =
+                std::max(GracePeriod, m_samplingInterval.load(std::memory_order_relaxed));
+            JointsPoses latest, previous;
+            auto numSamples = readJointsPosesSamples(side, latest, previous);
+            if (!numSamples || time + SamplingTolerance >= latest.time + samplingInterval) {
+                std::unique_lock lock(m_jointsPosesWriteLock);
+
+                // Another thread might have taken the sample in the meantime.
+                numSamples = readJointsPosesSamples(side, latest, previous);
+                if (!numSamples || time + SamplingTolerance >= latest.time + samplingInterval) {
+                    takeJointsPosesSample(side, time, now);
+                    numSamples = readJointsPosesSamples(side, latest, previous);
+                }
+            }
+
+            if (numSamples > 1) {
+                interpolateJointsPoses(previous, latest, time, jointsPoses);
+            } else {
+                std::copy_n(latest.jointsPoses, XR_HAND_JOINT_COUNT_EXT, jointsPoses);
+            }
+            if (time > latest.time) {
+                extrapolateJointsPoses(latest, time, jointsPoses);
+            }
+
+            if (!baseSpace || *baseSpace == m_referenceSpace) {
+                return;
+            }
+
+            // A single transform between the spaces replaces a query of the joints in the base space.
+            XrSpaceLocation location{XR_TYPE_SPACE_LOCATION, nullptr};
+            CHECK_XRCMD(m_openXR.xrLocateSpace(m_referenceSpace, *baseSpace, time, &location));
+            for (auto& joint : jointsPoses) {
+                joint.locationFlags &= location.locationFlags;
+                if (Pose::IsPoseValid(joint.locationFlags)) {
+                    joint.pose = Pose::Multiply(joint.pose, location.pose);
+                }
+            }
+        }
+
+        // Must be called with the write lock held.
+        void takeJointsPosesSample(uint32_t side, XrTime time, XrTime now) const {
+            JointsPoses sample;
+            sample.time = time;
+
+            XrHandJointsLocateInfoEXT locateInfo{XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT};
+            locateInfo.baseSpace = m_referenceSpace;
+            // Workaround to loss of virtual controller: do not query a time in the past!
+            locateInfo.time = std::max(time, now);
+
+            XrHandJointVelocitiesEXT velocities{XR_TYPE_HAND_JOINT_VELOCITIES_EXT, nullptr};
+            velocities.jointCount = XR_HAND_JOINT_COUNT_EXT;
+            velocities.jointVelocities = sample.jointsVelocities;
 
-            auto& cache = m_cachedHandJointsPoses[baseSpace.value_or(m_referenceSpace)][side];
+            XrHandJointLocationsEXT locations{XR_TYPE_HAND_JOINT_LOCATIONS_EXT, &velocities};
+            locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
+            locations.jointLocations = sample.jointsPoses;
 
-            // Search for a entry in the cache.
-            int32_t closestIndex = -1;
-            auto insertIt = cache.begin();
-            XrTime closestTimeDelta = INT64_MAX;
-            for (uint32_t i = 0; i < cache.size(); i++) {
-                const auto t = cache[i].first;
-                const XrTime delta = std::abs(t - time);
-                if (t < time) {
-                    insertIt++;
+            CHECK_HRCMD(m_openXR.xrLocateHandJointsEXT(m_handTracker[side], &locateInfo, &locations));
+            if (Pose::IsPoseTracked(locations.jointLocations[XR_HAND_JOINT_PALM_EXT].locationFlags)) {
+                m_lastTimestampWithPoseTracked[side] = std::max(time, m_lastTimestampWithPoseTracked[side]);
+            } else {
+                m_gesturesState.numTrackingLosses[side]++;
+            }
+
+            // The oldest sample is evicted.
+            const auto head = m_jointsPosesHead[side].load(std::memory_order_relaxed);
+            auto& slot = m_jointsPosesSamples[side][head % JointsPosesHistory];
+
+            const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+            slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.data = sample;
+            slot.sequence.store(sequence + 2, std::memory_order_release);
+
+            m_jointsPosesHead[side].store(head + 1, std::memory_order_release);
+        }
+
+        // Returns the number of samples read (up to 2).
+        uint32_t readJointsPosesSamples(uint32_t side, JointsPoses& latest, JointsPoses& previous) const {
+            while (true) {
+                const auto head = m_jointsPosesHead[side].load(std::memory_order_acquire);
+                const auto numSamples = std::min(head, 2u);
+
+                bool isTorn = false;
+                for (uint32_t i = 0; i < numSamples && !isTorn; i++) {
+                    const auto& slot = m_jointsPosesSamples[side][(head - 1 - i) % JointsPosesHistory];
+
+                    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+                    (i ? previous : latest) = slot.data;
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    isTorn = (sequence & 1) || slot.sequence.load(std::memory_order_relaxed) != sequence;
                 }
 
-                if (delta < closestTimeDelta) {
-                    closestTimeDelta = delta;
-                    closestIndex = i;
-                } else {
-                    break;
+                // Retry if a writer went through the ring while we were reading it.
+                if (!isTorn) {
+                    return numSamples;
                 }
             }
+        }
+
+        static void interpolateJointsPoses(const JointsPoses& previous,
+                                           const JointsPoses& latest,
+                                           XrTime time,
+                                           XrHandJointLocationEXT (&jointsPoses)[XR_HAND_JOINT_COUNT_EXT]) {
+            const XrDuration interval = latest.time - previous.time;
+            if (interval <= 0) {
+                std::copy_n(latest.jointsPoses, XR_HAND_JOINT_COUNT_EXT, jointsPoses);
+                return;
+            }
 
-            if (closestIndex != -1 && closestTimeDelta < GracePeriod) {
-                return cache[closestIndex].second;
+            // We never extrapolate by more than the sampling interval, past which a new sample is taken.
+            const float alpha = std::max((float)(time - previous.time) / interval, 0.f);
+            for (uint32_t i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
+                jointsPoses[i] = latest.jointsPoses[i];
+                if (Pose::IsPoseValid(previous.jointsPoses[i].locationFlags) &&
+                    Pose::IsPoseValid(latest.jointsPoses[i].locationFlags)) {
+                    jointsPoses[i].pose = Pose::Slerp(previous.jointsPoses[i].pose, latest.jointsPoses[i].pose, alpha);
+                    jointsPoses[i].locationFlags &= previous.jointsPoses[i].locationFlags;
+                }
             }
+        }
 
-            // Create a new entry.
-            {
-                XrHandJointsLocateInfoEXT locateInfo{XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT};
-                locateInfo.baseSpace = baseSpace.value_or(m_referenceSpace);
-                // Workaround to loss of virtual controller: do not query a time in the past!
-                locateInfo.time = std::max(time, now);
-
-                CacheEntry entry;
-                XrHandJointLocationsEXT locations{XR_TYPE_HAND_JOINT_LOCATIONS_EXT, nullptr};
-                locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
-                locations.jointLocations = entry.second;
-                entry.first = time;
-
-                CHECK_HRCMD(m_openXR.xrLocateHandJointsEXT(m_handTracker[side], &locateInfo, &locations));
-                if (Pose::IsPoseTracked(locations.jointLocations[XR_HAND_JOINT_PALM_EXT].locationFlags)) {
-                    m_lastTimestampWithPoseTracked[side] = std::max(time, m_lastTimestampWithPoseTracked[side]);
-                } else {
-                    m_gesturesState.numTrackingLosses[side]++;
+        // Refine the poses past the latest sample with the joints velocities, when the runtime reports them.
+        static void extrapolateJointsPoses(const JointsPoses& latest,
+                                           XrTime time,
+                                           XrHandJointLocationEXT (&jointsPoses)[XR_HAND_JOINT_COUNT_EXT]) {
+            using namespace DirectX;
+
+            const float dt = (time - latest.time) / 1e9f;
+            for (uint32_t i = 0; i < XR_HAND_JOINT_COUNT_EXT; i++) {
+                const auto& location = latest.jointsPoses[i];
+                const auto& velocity = latest.jointsVelocities[i];
+                if (!Pose::IsPoseValid(location.locationFlags)) {
+                    continue;
+                }
+
+                if (velocity.velocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT) {
+                    jointsPoses[i].pose.position = location.pose.position + velocity.linearVelocity * dt;
+                }
+                if (velocity.velocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT) {
+                    const XMVECTOR angularVelocity = LoadXrVector3(velocity.angularVelocity);
+                    const float angle = XMVectorGetX(XMVector3Length(angularVelocity)) * dt;
+                    if (angle > FLT_EPSILON) {
+                        const XMVECTOR rotation = XMQuaternionRotationAxis(angularVelocity, angle);
+                        StoreXrQuaternion(&jointsPoses[i].pose.orientation,
+                                          XMQuaternionNormalize(XMQuaternionMultiply(
+                                              LoadXrQuaternion(location.pose.orientation), rotation)));
+                    } else {
+                        jointsPoses[i].pose.orientation = location.pose.orientation;
+                    }
                 }
-                return cache.emplace(insertIt, entry)->second;
             }
         }
 
         void performGesturesDetection(const XrHandJointLocationEXT* leftHandJointsPoses,
                                       const XrHandJointLocationEXT* rightHandJointsPoses,
-                                      const std::set<XrAction>& ignore,
                                       XrTime now) {
-#define ACTION_PARAMS(configName) m_config.configName##Action[side],
+            const XrHandJointLocationEXT* handsJointsPoses[HandCount] = {leftHandJointsPoses, rightHandJointsPoses};
 
+            // Convert the joints positions to a SoA layout once for all gestures.
+            HandsJointsPositions positions;
             for (uint32_t side = 0; side < HandCount; side++) {
-                const Hand hand = (Hand)side;
-                const XrHandJointLocationEXT* jointsPoses =
-                    hand == Hand::Left ? leftHandJointsPoses : rightHandJointsPoses;
-                const XrHandJointLocationEXT* jointsPosesOtherHand =
-                    hand == Hand::Left ? rightHandJointsPoses : leftHandJointsPoses;
+                for (uint32_t joint = 0; joint < XR_HAND_JOINT_COUNT_EXT; joint++) {
+                    const bool isValid =
+                        handsJointsPoses[side] && Pose::IsPoseValid(handsJointsPoses[side][joint].locationFlags);
+                    const XrVector3f position =
+                        isValid ? handsJointsPoses[side][joint].pose.position : XrVector3f{0, 0, 0};
+                    positions.x[side][joint] = position.x;
+                    positions.y[side][joint] = position.y;
+                    positions.z[side][joint] = position.z;
+                    positions.valid[side][joint] = isValid;
+                }
+            }
 
-                if (!jointsPoses) {
+            const Gesture hapticsGesture =
+                !m_config.hapticsAction.empty() ? m_config.hapticsResponseGesture : Gesture::MaxValue;
+
+            // Index of the value of each gesture to evaluate (or -1).
+            struct GesturesPairs {
+                int32_t pinch{-1};
+                int32_t thumbPress{-1};
+                int32_t indexBend{-1};
+                int32_t fingerGun{-1};
+                int32_t custom1{-1};
+                int32_t squeeze[3]{-1, -1, -1};
+                int32_t palmTap{-1};
+                int32_t wristTap{-1};
+                int32_t indexTipTap{-1};
+            } gesturesPairs[HandCount];
+
+            // Gather the pairs of joints for all the configured gestures of both hands.
+            GestureJointsPairs pairs;
+            for (uint32_t side = 0; side < HandCount; side++) {
+                const uint32_t otherSide = HandCount - 1 - side;
+                auto& gestures = gesturesPairs[side];
+
+                if (!handsJointsPoses[side]) {
                     continue;
                 }
 
-                const Gesture hapticsGesture =
-                    !m_config.hapticsAction.empty() ? m_config.hapticsResponseGesture : Gesture::MaxValue;
-                bool hapticsGestureState = false;
-
 #define ONE_HANDED_GESTURE(configName, gesture, joint1, joint2)                                                        \
     do {                                                                                                               \
         if (!m_config.configName##Action[side].empty() || hapticsGesture == gesture) {                                 \
-            const auto value = computeJointActionValue(                                                                \
-                jointsPoses, (joint1), jointsPoses, (joint2), m_config.configName##Near, m_config.configName##Far);    \
-            m_gesturesState.configName##Value[side] = value;                                                           \
-            if (!m_config.configName##Action[side].empty()) {                                                          \
-                recordActionValue(hand, m_config.configName##Action[side], ignore, value, now);                        \
-            }                                                                                                          \
-            if (hapticsGesture == gesture) {                                                                           \
-                hapticsGestureState = value >= m_config.clickThreshold;                                                \
-            }                                                                                                          \
+            gestures.configName = pairs.add(                                                                           \
+                positions, side, (joint1), side, (joint2), m_config.configName##Near, m_config.configName##Far);       \
         }                                                                                                              \
     } while (false);
 
-                // Handle gestures made up from one hand.
+                // Gestures made up from one hand.
                 ONE_HANDED_GESTURE(pinch, Gesture::Squeeze, XR_HAND_JOINT_THUMB_TIP_EXT, XR_HAND_JOINT_INDEX_TIP_EXT);
                 ONE_HANDED_GESTURE(
                     thumbPress, Gesture::ThumbPress, XR_HAND_JOINT_INDEX_INTERMEDIATE_EXT, XR_HAND_JOINT_THUMB_TIP_EXT);
@@ -881,24 +1110,80 @@ namespace {
 
                 // Squeeze requires to look at 3 fingers.
                 if (!m_config.squeezeAction[side].empty() || hapticsGesture == Gesture::Squeeze) {
-                    float squeeze[3] = {computeJointActionValue(jointsPoses,
-                                                                XR_HAND_JOINT_MIDDLE_TIP_EXT,
-                                                                jointsPoses,
-                                                                XR_HAND_JOINT_MIDDLE_METACARPAL_EXT,
-                                                                m_config.squeezeNear,
-                                                                m_config.squeezeFar),
-                                        computeJointActionValue(jointsPoses,
-                                                                XR_HAND_JOINT_RING_TIP_EXT,
-                                                                jointsPoses,
-                                                                XR_HAND_JOINT_RING_METACARPAL_EXT,
-                                                                m_config.squeezeNear,
-                                                                m_config.squeezeFar),
-                                        computeJointActionValue(jointsPoses,
-                                                                XR_HAND_JOINT_LITTLE_TIP_EXT,
-                                                                jointsPoses,
-                                                                XR_HAND_JOINT_LITTLE_METACARPAL_EXT,
-                                                                m_config.squeezeNear,
-                                                                m_config.squeezeFar)};
+                    const XrHandJointEXT fingers[3][2] = {
+                        {XR_HAND_JOINT_MIDDLE_TIP_EXT, XR_HAND_JOINT_MIDDLE_METACARPAL_EXT},
+                        {XR_HAND_JOINT_RING_TIP_EXT, XR_HAND_JOINT_RING_METACARPAL_EXT},
+                        {XR_HAND_JOINT_LITTLE_TIP_EXT, XR_HAND_JOINT_LITTLE_METACARPAL_EXT}};
+                    for (uint32_t i = 0; i < 3; i++) {
+                        gestures.squeeze[i] = pairs.add(positions,
+                                                        side,
+                                                        fingers[i][0],
+                                                        side,
+                                                        fingers[i][1],
+                                                        m_config.squeezeNear,
+                                                        m_config.squeezeFar);
+                    }
+                }
+
+#define TWO_HANDED_GESTURE(configName, joint1, joint2)                                                                 \
+    do {                                                                                                               \
+        if (!m_config.configName##Action[side].empty()) {                                                              \
+            gestures.configName = pairs.add(                                                                           \
+                positions, side, (joint1), otherSide, (joint2), m_config.configName##Near, m_config.configName##Far);  \
+        }                                                                                                              \
+    } while (false);
+
+                if (!handsJointsPoses[otherSide]) {
+                    continue;
+                }
+
+                // Gestures made up using both hands.
+                TWO_HANDED_GESTURE(palmTap, XR_HAND_JOINT_PALM_EXT, XR_HAND_JOINT_INDEX_TIP_EXT);
+                TWO_HANDED_GESTURE(wristTap, XR_HAND_JOINT_WRIST_EXT, XR_HAND_JOINT_INDEX_TIP_EXT);
+                TWO_HANDED_GESTURE(indexTipTap, XR_HAND_JOINT_INDEX_TIP_EXT, XR_HAND_JOINT_INDEX_TIP_EXT);
+
+#undef TWO_HANDED_GESTURE
+            }
+
+            pairs.evaluate();
+
+            // Report the actions values.
+            for (uint32_t side = 0; side < HandCount; side++) {
+                const Hand hand = (Hand)side;
+                const auto& gestures = gesturesPairs[side];
+
+                if (!handsJointsPoses[side]) {
+                    continue;
+                }
+
+                bool hapticsGestureState = false;
+
+#define ONE_HANDED_GESTURE(configName, gesture)                                                                        \
+    do {                                                                                                               \
+        if (gestures.configName >= 0) {                                                                                \
+            const auto value = pairs.values[gestures.configName];                                                      \
+            m_gesturesState.configName##Value[side] = value;                                                           \
+            if (!m_config.configName##Action[side].empty()) {                                                          \
+                recordActionValue(hand, m_config.configName##Action[side], value, now);                                \
+            }                                                                                                          \
+            if (hapticsGesture == gesture) {                                                                           \
+                hapticsGestureState = value >= m_config.clickThreshold;                                                \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (false);
+
+                ONE_HANDED_GESTURE(pinch, Gesture::Squeeze);
+                ONE_HANDED_GESTURE(thumbPress, Gesture::ThumbPress);
+                ONE_HANDED_GESTURE(indexBend, Gesture::IndexBend);
+                ONE_HANDED_GESTURE(fingerGun, Gesture::FingerGun);
+                ONE_HANDED_GESTURE(custom1, Gesture::Custom1);
+
+#undef ONE_HANDED_GESTURE
+
+                if (gestures.squeeze[0] >= 0) {
+                    float squeeze[3] = {pairs.values[gestures.squeeze[0]],
+                                        pairs.values[gestures.squeeze[1]],
+                                        pairs.values[gestures.squeeze[2]]};
 
                     // Quickly bubble sort.
                     if (squeeze[0] > squeeze[1]) {
@@ -915,7 +1200,7 @@ namespace {
                     const float value = (squeeze[1] + squeeze[2]) / 2.f;
                     m_gesturesState.squeezeValue[side] = value;
                     if (!m_config.squeezeAction[side].empty()) {
-                        recordActionValue(hand, m_config.squeezeAction[side], ignore, value, now);
+                        recordActionValue(hand, m_config.squeezeAction[side], value, now);
                     }
                     if (hapticsGesture == Gesture::Squeeze) {
                         hapticsGestureState = value >= m_config.clickThreshold;
@@ -924,32 +1209,21 @@ namespace {
 
                 // Check for haptics trigger.
                 if (m_evaluateHapticsGesture && !m_config.hapticsAction.empty() && hapticsGestureState) {
-                    recordActionValue(hand, m_config.hapticsAction, ignore, 1.f, now);
+                    recordActionValue(hand, m_config.hapticsAction, 1.f, now);
                 }
 
-#define TWO_HANDED_GESTURE(configName, joint1, joint2)                                                                 \
+#define TWO_HANDED_GESTURE(configName)                                                                                 \
     do {                                                                                                               \
-        if (!m_config.configName##Action[side].empty()) {                                                              \
-            const auto value = computeJointActionValue(jointsPoses,                                                    \
-                                                       (joint1),                                                       \
-                                                       jointsPosesOtherHand,                                           \
-                                                       (joint2),                                                       \
-                                                       m_config.configName##Near,                                      \
-                                                       m_config.configName##Far);                                      \
+        if (gestures.configName >= 0) {                                                                                \
+            const auto value = pairs.values[gestures.configName];                                                      \
             m_gesturesState.configName##Value[side] = value;                                                           \
-            recordActionValue(hand, m_config.configName##Action[side], ignore, value, now);                            \
+            recordActionValue(hand, m_config.configName##Action[side], value, now);                                    \
         }                                                                                                              \
     } while (false);
 
-                if (!jointsPosesOtherHand) {
-                    continue;
-                }
-
-                // Handle gestures made up using both hands.
-
-                TWO_HANDED_GESTURE(palmTap, XR_HAND_JOINT_PALM_EXT, XR_HAND_JOINT_INDEX_TIP_EXT);
-                TWO_HANDED_GESTURE(wristTap, XR_HAND_JOINT_WRIST_EXT, XR_HAND_JOINT_INDEX_TIP_EXT);
-                TWO_HANDED_GESTURE(indexTipTap, XR_HAND_JOINT_INDEX_TIP_EXT, XR_HAND_JOINT_INDEX_TIP_EXT);
+                TWO_HANDED_GESTURE(palmTap);
+                TWO_HANDED_GESTURE(wristTap);
+                TWO_HANDED_GESTURE(indexTipTap);
 
 #undef TWO_HANDED_GESTURE
             }
@@ -957,61 +1231,76 @@ namespace {
             m_evaluateHapticsGesture = false;
         }
 
-        // Compute the scaled action value based on the distance between 2 joints.
-        float computeJointActionValue(const XrHandJointLocationEXT* joints1Poses,
-                                      uint32_t joint1,
-                                      const XrHandJointLocationEXT* joints2Poses,
-                                      uint32_t joint2,
-                                      float nearDistance,
-                                      float farDistance) {
-            if (Pose::IsPoseValid(joints1Poses[joint1].locationFlags) &&
-                Pose::IsPoseValid(joints2Poses[joint2].locationFlags)) {
-                // We ignore joints radius and assume the near/far distance are configured to account for them.
-                const float distance =
-                    std::max(Length(joints1Poses[joint1].pose.position - joints2Poses[joint2].pose.position), 0.f);
+        const Action* findAction(XrAction action) const {
+            const auto actionIt = m_actionIndices.find(action);
+            if (actionIt == m_actionIndices.cend()) {
+                return nullptr;
+            }
+            return &m_actions[actionIt->second];
+        }
 
-                return 1.f -
-                       (std::clamp(distance, nearDistance, farDistance) - nearDistance) / (farDistance - nearDistance);
+        uint32_t getSubActionSide(const Action& action, XrPath subActionPath) const {
+            if (subActionPath == m_leftHandSubaction && action.subActions[0]) {
+                return 0;
+            } else if (subActionPath == m_rightHandSubaction && action.subActions[1]) {
+                return 1;
             }
-            return NAN;
+            return action.defaultSide;
         }
 
-        void recordActionValue(
-            Hand hand, const std::string& actionPath, const std::set<XrAction>& ignore, float value, XrTime now) {
+        // Resolve (once) the actions whose binding for the given side ends with the path.
+        const std::vector<uint32_t>& getActionsForPath(uint32_t side, const std::string& actionPath) {
+            auto actionsIt = m_actionsForPath[side].find(actionPath);
+            if (actionsIt == m_actionsForPath[side].end()) {
+                std::vector<uint32_t> actions;
+                for (uint32_t i = 0; i < m_actions.size(); i++) {
+                    if (!m_actions[i].subActions[side]) {
+                        continue;
+                    }
+
+                    // path.endswith(actionPath)
+                    const std::string& path = m_actions[i].subActions[side]->path;
+                    if (path.rfind(actionPath) == path.length() - actionPath.length()) {
+                        actions.push_back(i);
+                    }
+                }
+                actionsIt = m_actionsForPath[side].insert_or_assign(actionPath, std::move(actions)).first;
+            }
+            return actionsIt->second;
+        }
+
+        void recordActionValue(Hand hand, const std::string& actionPath, float value, XrTime now) {
             assert(!actionPath.empty());
 
             if (isnan(value)) {
                 return;
             }
 
-            const XrPath subActionPath = hand == Hand::Left ? m_leftHandSubaction : m_rightHandSubaction;
+            const uint32_t side = hand == Hand::Left ? 0 : 1;
 
-            for (auto& action : m_actions) {
-                if (ignore.find(action.first) != ignore.cend()) {
+            for (const uint32_t index : getActionsForPath(side, actionPath)) {
+                Action& action = m_actions[index];
+                if (!action.isActive) {
                     continue;
                 }
 
-                auto& subAction = action.second.subActions[subActionPath];
-                const std::string& path = subAction.path;
+                auto& subAction = action.subActions[side].value();
 
-                // path.endswith(actionPath)
-                if (path.rfind(actionPath) == path.length() - actionPath.length()) {
-                    // If multiple gestures are bound to the same action, pick the highest value.
-                    const float newFloatValue = subAction.synced ? std::max(subAction.floatValue, value) : value;
-                    const bool newBoolValue = newFloatValue >= m_config.clickThreshold;
+                // If multiple gestures are bound to the same action, pick the highest value.
+                const float newFloatValue = subAction.synced ? std::max(subAction.floatValue, value) : value;
+                const bool newBoolValue = newFloatValue >= m_config.clickThreshold;
 
-                    if (std::abs(subAction.floatValue - newFloatValue) > FLT_EPSILON) {
-                        subAction.floatValue = newFloatValue;
-                        subAction.timeFloatValueChanged = now;
-                        subAction.floatValueChanged = true;
-                    }
-                    if (subAction.boolValue != newBoolValue) {
-                        subAction.boolValue = newBoolValue;
-                        subAction.timeBoolValueChanged = now;
-                        subAction.boolValueChanged = true;
-                    }
-                    subAction.synced = true;
+                if (std::abs(subAction.floatValue - newFloatValue) > FLT_EPSILON) {
+                    subAction.floatValue = newFloatValue;
+                    subAction.timeFloatValueChanged = now;
+                    subAction.floatValueChanged = true;
+                }
+                if (subAction.boolValue != newBoolValue) {
+                    subAction.boolValue = newBoolValue;
+                    subAction.timeBoolValueChanged = now;
+                    subAction.boolValueChanged = true;
                 }
+                subAction.synced = true;
             }
         }
 
@@ -1030,6 +1319,7 @@ namespace {
         std::shared_ptr<IDevice> m_graphicsDevice;
         // One mesh for each color.
         std::vector<std::shared_ptr<ISimpleMesh>> m_jointMesh;
+        mutable std::vector<SimpleMeshInstance> m_jointInstances;
 
         XrHandTrackerEXT m_handTracker[HandCount]{XR_NULL_HANDLE, XR_NULL_HANDLE};
         XrTime m_thisFrameTime{0};
@@ -1037,18 +1327,27 @@ namespace {
         bool m_leftHandEnabled{true};
         bool m_rightHandEnabled{true};
 
-        std::map<XrSpace, ActionSpace> m_actionSpaces;
+        utilities::FlatMap<XrSpace, ActionSpace> m_actionSpaces;
         std::map<XrActionSet, std::set<XrAction>> m_actionSets;
-        std::map<XrAction, Action> m_actions;
+
+        // The bound actions, stored densely and indexed through their handle.
+        std::vector<Action> m_actions;
+        utilities::FlatMap<XrAction, uint32_t> m_actionIndices;
+        std::optional<uint32_t> m_systemClickAction;
+
+        // The actions bound to the path of each gesture, for each side.
+        std::unordered_map<std::string, std::vector<uint32_t>> m_actionsForPath[HandCount];
 
         bool m_trackedRecently[2]{false, false};
         bool m_evaluateHapticsGesture{false};
         XrTime m_lastKeepalive{0};
 
-        using CacheEntry = std::pair<XrTime, XrHandJointLocationEXT[XR_HAND_JOINT_COUNT_EXT]>;
-        mutable std::map<XrSpace, std::deque<CacheEntry>[HandCount]> m_cachedHandJointsPoses;
-        mutable std::mutex m_cacheLock;
-        mutable std::optional<XrSpace> m_preferredBaseSpace;
+        // The samples of the hand joints in our reference space.
+        mutable JointsPosesSample m_jointsPosesSamples[HandCount][JointsPosesHistory];
+        mutable std::atomic<uint32_t> m_jointsPosesHead[HandCount]{};
+        mutable std::mutex m_jointsPosesWriteLock;
+        std::atomic<XrDuration> m_samplingInterval{0};
+        uint32_t m_gesturesJointsPosesHead[HandCount]{};
         mutable XrTime m_lastTimestampWithPoseTracked[HandCount]{0, 0};
         mutable GesturesState m_gesturesState{};
     };
@@ -0,0 +1,236 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "layer.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+    using namespace toolkit::utilities;
+
+    using namespace xr::math;
+
+    class HiddenAreaPrePass : public IHiddenAreaPrePass {
+      public:
+        HiddenAreaPrePass(OpenXrApi& openXR,
+                          std::shared_ptr<IDevice> graphicsDevice,
+                          uint32_t renderWidth,
+                          uint32_t renderHeight)
+            : m_openXR(openXR), m_device(graphicsDevice), m_renderRatio((float)renderWidth / renderHeight) {
+        }
+
+        void beginSession(XrSession session, XrSpace viewSpace) override {
+            for (uint32_t i = 0; i < ViewCount; i++) {
+                XrVisibilityMaskKHR mask{XR_TYPE_VISIBILITY_MASK_KHR};
+                if (XR_FAILED(m_openXR.xrGetVisibilityMaskKHR(session,
+                                                              XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO,
+                                                              i,
+                                                              XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR,
+                                                              &mask))) {
+                    break;
+                }
+
+                if (!mask.indexCountOutput) {
+                    break;
+                }
+
+                std::vector<XrVector2f> rawVertices(mask.vertexCountOutput);
+                std::vector<uint32_t> rawIndices(mask.indexCountOutput);
+
+                mask.indexCapacityInput = (uint32_t)rawIndices.size();
+                mask.indices = rawIndices.data();
+                mask.vertexCapacityInput = (uint32_t)rawVertices.size();
+                mask.vertices = rawVertices.data();
+                CHECK_XRCMD(m_openXR.xrGetVisibilityMaskKHR(session,
+                                                            XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO,
+                                                            i,
+                                                            XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR,
+                                                            &mask));
+
+                // The mesh is defined in view space, at 1m.
+                std::vector<SimpleMeshVertex> vertices(mask.vertexCountOutput);
+                for (uint32_t j = 0; j < vertices.size(); j++) {
+                    vertices[j].Position = {rawVertices[j].x, rawVertices[j].y, -1.0f};
+                    vertices[j].Color = {0.f, 0.f, 0.f};
+                }
+
+                std::vector<uint16_t> indices(mask.indexCountOutput);
+                for (uint32_t j = 0; j < indices.size(); j++) {
+                    indices[j] = rawIndices[j];
+                }
+
+                m_hiddenAreaMesh[i] = m_device->createSimpleMesh(vertices, indices, "Hidden Area Mesh");
+            }
+
+            m_session = session;
+            m_viewSpace = viewSpace;
+        }
+
+        void endSession() override {
+            for (uint32_t i = 0; i < ViewCount; i++) {
+                m_hiddenAreaMesh[i].reset();
+            }
+
+            m_isReady = false;
+            m_session = XR_NULL_HANDLE;
+            m_viewSpace = XR_NULL_HANDLE;
+        }
+
+        void beginFrame(XrTime frameTime) override {
+            if (m_hiddenAreaMesh[0] && m_hiddenAreaMesh[1] && !m_isReady) {
+                // Create projection for stamping the mesh.
+                XrViewLocateInfo info{XR_TYPE_VIEW_LOCATE_INFO};
+                info.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+                info.displayTime = frameTime;
+                info.space = m_viewSpace;
+
+                XrViewState state{XR_TYPE_VIEW_STATE, nullptr};
+                XrView eyeInViewSpace[2] = {{XR_TYPE_VIEW, nullptr}, {XR_TYPE_VIEW, nullptr}};
+                uint32_t viewCountOutput;
+                CHECK_XRCMD(m_openXR.xrLocateViews(m_session, &info, &state, 2, &viewCountOutput, eyeInViewSpace));
+                for (uint32_t i = 0; i < ViewCount; i++) {
+                    m_fov[i] = eyeInViewSpace[i].fov;
+                }
+
+                m_isReady = true;
+            }
+
+            m_isStamped.fill(false);
+        }
+
+        void onClearDepth(std::shared_ptr<IContext> context,
+                          std::shared_ptr<ITexture> depthBuffer,
+                          int32_t slice,
+                          float depth,
+                          std::optional<Eye> eyeHint) override {
+            // The mesh is stamped at the near plane, which requires the depth to be cleared to the far plane: 1 for
+            // regular depth and 0 for inverted depth.
+            if (!m_isReady || (depth != 0.f && depth != 1.f)) {
+                return;
+            }
+            const bool isDepthInverted = depth == 0.f;
+
+            // Our draws can only be ordered with the application's draws on the immediate context.
+            if (context->getNativePtr() != m_device->getContextPtr()) {
+                return;
+            }
+
+            // Only consider the depth buffers for the views.
+            const auto& info = depthBuffer->getInfo();
+            const auto width = (int32_t)info.width;
+            const auto height = (int32_t)info.height;
+            const bool isDoubleWide = std::abs((float)(width / 2) / height - m_renderRatio) <= 0.01f;
+            if (!isDoubleWide && std::abs((float)width / height - m_renderRatio) > 0.01f) {
+                return;
+            }
+
+            struct Stamp {
+                Eye eye;
+                int32_t slice;
+                XrRect2Di viewport;
+            };
+            std::vector<Stamp> stamps;
+            if (isDoubleWide) {
+                stamps.push_back({Eye::Left, slice, {{0, 0}, {width / 2, height}}});
+                stamps.push_back({Eye::Right, slice, {{width / 2, 0}, {width / 2, height}}});
+            } else if (info.arraySize == 2 && slice < 0) {
+                stamps.push_back({Eye::Left, 0, {{0, 0}, {width, height}}});
+                stamps.push_back({Eye::Right, 1, {{0, 0}, {width, height}}});
+            } else if (info.arraySize == 2) {
+                stamps.push_back({slice ? Eye::Right : Eye::Left, slice, {{0, 0}, {width, height}}});
+            } else if (eyeHint.value_or(Eye::Both) != Eye::Both) {
+                stamps.push_back({eyeHint.value(), slice, {{0, 0}, {width, height}}});
+            }
+
+            // Only stamp the first depth buffer cleared for each eye in the frame.
+            stamps.erase(std::remove_if(stamps.begin(),
+                                        stamps.end(),
+                                        [&](const Stamp& stamp) { return m_isStamped[(size_t)stamp.eye]; }),
+                         stamps.end());
+            if (stamps.empty()) {
+                return;
+            }
+
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local,
+                                   "HiddenAreaPrePass_Stamp",
+                                   TraceLoggingKeyword(TLK_Frame),
+                                   TLArg(width, "Width"),
+                                   TLArg(height, "Height"),
+                                   TLArg(slice, "Slice"),
+                                   TLArg(isDepthInverted, "IsDepthInverted"),
+                                   TLArg(stamps.size(), "NumStamps"));
+
+            m_device->saveContext();
+            m_device->beginProfileScope("HAM");
+            for (const auto& stamp : stamps) {
+                m_device->setRenderTargets(0, nullptr, nullptr, &stamp.viewport, depthBuffer, stamp.slice);
+
+                // Place the near plane at 1m, where the mesh is defined.
+                ViewProjection view;
+                view.Pose = Pose::Identity();
+                view.Fov = m_fov[(size_t)stamp.eye];
+                view.NearFar = isDepthInverted ? NearFar{100.f, 1.f} : NearFar{1.f, 100.f};
+                m_device->setViewProjection(view);
+                m_device->draw(m_hiddenAreaMesh[(size_t)stamp.eye], Pose::Identity(), {1.f, 1.f, 1.f}, true);
+
+                m_isStamped[(size_t)stamp.eye] = true;
+            }
+            m_device->unsetRenderTargets();
+            m_device->endProfileScope();
+            m_device->restoreContext();
+
+            TraceLoggingWriteStop(local, "HiddenAreaPrePass_Stamp", TraceLoggingKeyword(TLK_Frame));
+        }
+
+      private:
+        OpenXrApi& m_openXR;
+        const std::shared_ptr<IDevice> m_device;
+        const float m_renderRatio;
+
+        XrSession m_session{XR_NULL_HANDLE};
+        XrSpace m_viewSpace{XR_NULL_HANDLE};
+        std::shared_ptr<ISimpleMesh> m_hiddenAreaMesh[ViewCount];
+        XrFovf m_fov[ViewCount];
+        bool m_isReady{false};
+        std::array<bool, ViewCount> m_isStamped{};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<IHiddenAreaPrePass> CreateHiddenAreaPrePass(toolkit::OpenXrApi& openXR,
+                                                                std::shared_ptr<IDevice> graphicsDevice,
+                                                                uint32_t renderWidth,
+                                                                uint32_t renderHeight) {
+        return std::make_shared<HiddenAreaPrePass>(openXR, graphicsDevice, renderWidth, renderHeight);
+    }
+
+} // namespace toolkit::graphics
@@ -42,12 +42,19 @@ namespace {
         XrVector4f Params3; // Highlights, Shadows, Vibrance (0..1 params), UseCA (0 = off, 1 = on)
         XrVector4f Params4; // ChromaticCorrectionR, ChromaticCorrectionG, ChromaticCorrectionB (-1..+1 params)
                             // Eye (0 = left, 1 = right)
+        XrVector4f Params5; // InputScaleU, InputScaleV, InputOffsetU, InputOffsetV (input region)
     };
 
+    // The CA correction LUT maps each position of the view to the position to sample the red (xy) and blue (zw)
+    // channels from.
+    constexpr uint32_t CorrectionLUTSize = 64;
+
     class ImageProcessor : public IImageProcessor {
       public:
-        ImageProcessor(std::shared_ptr<IConfigManager> configManager, std::shared_ptr<IDevice> graphicsDevice)
-            : m_configManager(configManager), m_device(graphicsDevice),
+        ImageProcessor(std::shared_ptr<IConfigManager> configManager,
+                       std::shared_ptr<IDevice> graphicsDevice,
+                       const std::string& systemName)
+            : m_configManager(configManager), m_device(graphicsDevice), m_systemName(systemName),
               m_userParams(GetParams(configManager.get(), 1)) {
             createRenderResources();
         }
@@ -69,32 +76,130 @@ namespace {
             }
         }
 
-        void process(std::shared_ptr<ITexture> input,
-                     std::shared_ptr<ITexture> output,
+        void process(const std::shared_ptr<ITexture>& input,
+                     const std::shared_ptr<ITexture>& output,
                      std::vector<std::shared_ptr<ITexture>>& textures,
+                     std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
                      std::array<uint8_t, 1024>& blob,
-                     std::optional<utilities::Eye> eye = std::nullopt) override {
-            // We need to use a per-instance blob.
-            static_assert(sizeof(ImageProcessorConfig) <= 1024);
-            ImageProcessorConfig* const config = reinterpret_cast<ImageProcessorConfig*>(blob.data());
+                     std::optional<utilities::Eye> eye = std::nullopt,
+                     const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr,
+                     std::optional<TextureRegion> inputRegion = std::nullopt,
+                     std::optional<TextureRegion> outputRegion = std::nullopt) override {
+            const auto slot = to_integral(eye.value_or(utilities::Eye::Both));
 
-            memcpy(config, &m_config, sizeof(m_config));
+            ImageProcessorConfig newConfig = m_config;
 
             // Patch the eye.
-            config->Params4.w = (float)eye.value_or(utilities::Eye::Both);
+            newConfig.Params4.w = (float)slot;
+
+            // Map the output viewport onto the input region.
+            if (inputRegion) {
+                const auto& inputInfo = input->getInfo();
+                newConfig.Params5 = {(float)inputRegion->rect.extent.width / inputInfo.width,
+                                     (float)inputRegion->rect.extent.height / inputInfo.height,
+                                     (float)inputRegion->rect.offset.x / inputInfo.width,
+                                     (float)inputRegion->rect.offset.y / inputInfo.height};
+            } else {
+                newConfig.Params5 = {1, 1, 0, 0};
+            }
 
-            // TODO: We can use an IShaderBuffer cache per swapchain and avoid this every frame.
-            m_cbParams->uploadData(config, sizeof(*config));
+            const auto cbParams = uploadConfig(buffers, blob, slot, newConfig);
 
             const auto usePostProcess = m_mode == PostProcessType::On;
+            m_device->beginProfileScope("PostProcess");
             m_device->setShader(m_shaders[usePostProcess], SamplerType::LinearClamp);
-            m_device->setShaderInput(0, m_cbParams);
-            m_device->setShaderInput(0, input);
-            m_device->setShaderOutput(0, output);
+            m_device->setShaderInput(0, cbParams);
+            m_device->setShaderInput(0, input, inputRegion ? inputRegion->slice : -1);
+            if (!usePostProcess) {
+                m_device->setShaderInput(1, m_correctionLUT[slot == to_integral(utilities::Eye::Right)]);
+            }
+            m_device->setShaderOutput(0,
+                                      output,
+                                      outputRegion ? outputRegion->slice : -1,
+                                      outputRegion ? &outputRegion->rect : nullptr);
             m_device->dispatchShader();
+            m_device->endProfileScope();
+        }
+
+        bool isIdentity() const override {
+            return m_mode == PostProcessType::Off && m_config.Params2.x == 0.f && m_config.Params2.y == 0.f &&
+                   m_config.Params2.z == 0.f;
+        }
+
+        bool isStereoSupported() const override {
+            return false;
+        }
+
+        void processStereo(const std::shared_ptr<ITexture>& input,
+                           const std::shared_ptr<ITexture>& output,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                           std::array<uint8_t, 1024>& blob,
+                           const std::array<TextureRegion, utilities::ViewCount>& inputRegions,
+                           const std::array<TextureRegion, utilities::ViewCount>& outputRegions,
+                           const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr) override {
+            // The post-processor is a full-screen quad that renders one eye at a time.
+            throw std::runtime_error("Stereo processing is not supported");
+        }
+
+        bool isFusedPostProcessSupported() const override {
+            return false;
+        }
+
+        std::shared_ptr<IShaderBuffer>
+        getFusedPostProcessConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                     std::array<uint8_t, 1024>& blob,
+                                     std::optional<utilities::Eye> eye = std::nullopt) override {
+            // CA correction needs to resample the image, which cannot be done at the end of the upscaler.
+            if (m_mode == PostProcessType::CACorrection) {
+                return nullptr;
+            }
+
+            ImageProcessorConfig newConfig = m_config;
+
+            // The pass-through shader only uses the color gains.
+            if (m_mode != PostProcessType::On) {
+                newConfig.Params1 = {0, 0, 0, 0};
+                newConfig.Params3 = {0, 0, 0, 0};
+            }
+            newConfig.Params4 = {0, 0, 0, 0};
+            newConfig.Params5 = {0, 0, 0, 0};
+
+            // Use a separate set of slots from the regular process() path.
+            const auto slot = utilities::ViewCount + 1 + to_integral(eye.value_or(utilities::Eye::Both));
+            return uploadConfig(buffers, blob, slot, newConfig);
+        }
+
+        void setFoveatedRegion(utilities::Eye eye, const std::optional<FoveatedRegion>& region) override {
+        }
+
+        void setTemporalView(utilities::Eye eye, const std::optional<TemporalViewInfo>& view) override {
         }
 
       private:
+        std::shared_ptr<IShaderBuffer> uploadConfig(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                                    std::array<uint8_t, 1024>& blob,
+                                                    size_t slot,
+                                                    const ImageProcessorConfig& newConfig) {
+            // We need to use a per-instance blob, with one slot per eye for both regular and fused mode.
+            static_assert(sizeof(ImageProcessorConfig) * (utilities::ViewCount + 1) * 2 <= 1024);
+            ImageProcessorConfig* const config = reinterpret_cast<ImageProcessorConfig*>(blob.data()) + slot;
+
+            // Only upload the per-swapchain, per-eye constant buffer when the configuration has changed.
+            if (buffers.size() <= slot) {
+                buffers.resize((utilities::ViewCount + 1) * 2);
+            }
+            auto& cbParams = buffers[slot];
+            if (!cbParams || memcmp(config, &newConfig, sizeof(newConfig))) {
+                if (!cbParams) {
+                    cbParams = m_device->createBuffer(sizeof(ImageProcessorConfig), "Postprocess CB");
+                }
+                memcpy(config, &newConfig, sizeof(newConfig));
+                cbParams->uploadData(config, sizeof(*config));
+            }
+            return cbParams;
+        }
+
         void createRenderResources() {
             const auto shadersDir = dllHome / "shaders";
             const auto shaderFile = shadersDir / "postprocess.hlsl";
@@ -107,13 +212,113 @@ namespace {
             m_shaders[0] = m_device->createQuadShader(shaderFile, "mainPassThrough", "Passthrough PS", defines.get());
             m_shaders[1] = m_device->createQuadShader(shaderFile, "mainPostProcess", "Postprocess PS", defines.get());
 
-            // TODO: For now, we're going to require that all image processing shaders share the same configuration
-            // structure.
-            m_cbParams = m_device->createBuffer(sizeof(ImageProcessorConfig), "Postprocess CB");
+            // A LUT for the headset replaces the one generated from the CA correction settings.
+            m_hasHeadsetLUT = loadCorrectionLUT();
+            m_correctionLUTScale = {};
 
             updateConfig();
         }
 
+        // Look for a LUT in %LocalAppData% first, then fallback to your installation folder. The file contains the size
+        // of the LUT (uint32), then the texels (float4, see CorrectionLUTSize) of the left eye, then the right eye.
+        bool loadCorrectionLUT() {
+            if (m_systemName.empty()) {
+                return false;
+            }
+
+            const auto fileName = m_systemName + ".calut";
+            std::ifstream file(localAppData / "configs" / fileName, std::ios::binary);
+            if (!file.is_open()) {
+                file.open(dllHome / fileName, std::ios::binary);
+            }
+            if (!file.is_open()) {
+                return false;
+            }
+
+            uint32_t size = 0;
+            file.read(reinterpret_cast<char*>(&size), sizeof(size));
+            if (!file || size < 2 || size > 1024) {
+                Log("Invalid CA correction LUT for \"%s\"\n", m_systemName.c_str());
+                return false;
+            }
+
+            std::vector<XrVector4f> texels(size * size);
+            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                file.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(XrVector4f));
+                if (!file) {
+                    Log("Invalid CA correction LUT for \"%s\"\n", m_systemName.c_str());
+                    return false;
+                }
+
+                // The previous texture may still be in use by the GPU.
+                if (m_correctionLUT[eye]) {
+                    m_device->releaseDeferred(std::move(m_correctionLUT[eye]));
+                }
+                m_correctionLUT[eye] = createCorrectionLUT(texels, size, eye);
+            }
+
+            Log("Loaded %ux%u CA correction LUT for \"%s\"\n", size, size, m_systemName.c_str());
+            return true;
+        }
+
+        // The LUT is only regenerated when the correction changes.
+        void updateCorrectionLUT() {
+            const XrVector2f scale{m_config.Params4.x, m_config.Params4.z};
+            if (m_hasHeadsetLUT ||
+                (m_correctionLUT[0] && scale.x == m_correctionLUTScale.x && scale.y == m_correctionLUTScale.y)) {
+                return;
+            }
+            m_correctionLUTScale = scale;
+
+            // Radial scaling of the red and blue channels, around the lens center (mirrored for the right eye).
+            std::vector<XrVector4f> texels(CorrectionLUTSize * CorrectionLUTSize);
+            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                const XrVector2f origin{eye ? 1 - 0.313f : 0.313f, 0.42f};
+                for (uint32_t y = 0; y < CorrectionLUTSize; y++) {
+                    for (uint32_t x = 0; x < CorrectionLUTSize; x++) {
+                        const XrVector2f uv{(float)x / (CorrectionLUTSize - 1), (float)y / (CorrectionLUTSize - 1)};
+                        texels[y * CorrectionLUTSize + x] = {(uv.x - origin.x) * scale.x + origin.x,
+                                                             (uv.y - origin.y) * scale.x + origin.y,
+                                                             (uv.x - origin.x) * scale.y + origin.x,
+                                                             (uv.y - origin.y) * scale.y + origin.y};
+                    }
+                }
+
+                // The previous texture may still be in use by the GPU.
+                if (m_correctionLUT[eye]) {
+                    m_device->releaseDeferred(std::move(m_correctionLUT[eye]));
+                }
+                m_correctionLUT[eye] = createCorrectionLUT(texels, CorrectionLUTSize, eye);
+            }
+        }
+
+        std::shared_ptr<ITexture>
+        createCorrectionLUT(const std::vector<XrVector4f>& texels, uint32_t size, uint32_t eye) {
+            const uint32_t rowPitch = size * sizeof(XrVector4f);
+            const uint32_t rowPitchAligned = alignTo(rowPitch, m_device->getTextureAlignmentConstraint());
+
+            std::vector<uint8_t> alignedTexels(rowPitchAligned * size);
+            for (uint32_t y = 0; y < size; y++) {
+                memcpy(alignedTexels.data() + y * rowPitchAligned, texels.data() + y * size, rowPitch);
+            }
+
+            XrSwapchainCreateInfo info;
+            ZeroMemory(&info, sizeof(info));
+            info.width = size;
+            info.height = size;
+            info.format = m_device->getTextureFormat(TextureFormat::R32G32B32A32_FLOAT);
+            info.arraySize = 1;
+            info.mipCount = 1;
+            info.sampleCount = 1;
+            info.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+            return m_device->createTexture(info,
+                                           eye ? "CA Correction Right LUT TEX2D" : "CA Correction Left LUT TEX2D",
+                                           0,
+                                           rowPitchAligned,
+                                           (uint32_t)alignedTexels.size(),
+                                           alignedTexels.data());
+        }
+
         bool checkUpdateConfig(PostProcessType mode) const {
             if (mode != PostProcessType::Off) {
                 return m_configManager->hasChanged(SettingPostSunGlasses) ||
@@ -131,6 +336,7 @@ namespace {
                        m_configManager->hasChanged(SettingPostChromaticCorrectionB);
             } else {
                 return m_configManager->hasChanged(SettingPostColorGainR) ||
+                       m_configManager->hasChanged(SettingPostColorGainG) ||
                        m_configManager->hasChanged(SettingPostColorGainB);
             }
         }
@@ -162,16 +368,13 @@ namespace {
                 StoreXrVector4(&m_config.Params1 + i, (param * kGainBias[i][0]) - kGainBias[i][1]);
             }
 
-            // CA Correction stuff.
-            if (m_mode == PostProcessType::CACorrection) {
-                m_config.Params3.w = 1;
-                m_config.Params4.x = m_configManager->getValue(SettingPostChromaticCorrectionR) / 100000.0f;
-                m_config.Params4.y = 1.0f;
-                m_config.Params4.z = m_configManager->getValue(SettingPostChromaticCorrectionB) / 100000.0f;
-                // Params4.w is patched JIT in process().
-            } else {
-                m_config.Params3.w = 0;
-            }
+            // CA Correction stuff. The LUT must always be valid, since the pass-through shader samples it.
+            m_config.Params3.w = m_mode == PostProcessType::CACorrection ? 1.f : 0.f;
+            m_config.Params4.x = m_configManager->getValue(SettingPostChromaticCorrectionR) / 100000.0f;
+            m_config.Params4.y = 1.0f;
+            m_config.Params4.z = m_configManager->getValue(SettingPostChromaticCorrectionB) / 100000.0f;
+            // Params4.w (eye) is set for each pass in process().
+            updateCorrectionLUT();
         }
 
         static std::array<DirectX::XMINT4, 3> GetParams(const IConfigManager* configManager, size_t index) {
@@ -224,10 +427,14 @@ namespace {
 
         const std::shared_ptr<IConfigManager> m_configManager;
         const std::shared_ptr<IDevice> m_device;
+        const std::string m_systemName;
         const std::array<DirectX::XMINT4, 3> m_userParams;
 
         std::shared_ptr<IQuadShader> m_shaders[2]; // off, on
-        std::shared_ptr<IShaderBuffer> m_cbParams;
+
+        std::shared_ptr<ITexture> m_correctionLUT[utilities::ViewCount];
+        XrVector2f m_correctionLUTScale{};
+        bool m_hasHeadsetLUT{false};
 
         PostProcessType m_mode{PostProcessType::Off};
         ImageProcessorConfig m_config{};
@@ -242,7 +449,10 @@ namespace toolkit::graphics {
             if (auto device11 = device->getAs<D3D11>()) {
                 D3D11_FEATURE_DATA_SHADER_MIN_PRECISION_SUPPORT feature = {};
                 device11->CheckFeatureSupport(D3D11_FEATURE_SHADER_MIN_PRECISION_SUPPORT, &feature, sizeof(feature));
-                return (feature.PixelShaderMinPrecision & D3D11_SHADER_MIN_PRECISION_16_BIT) != 0;
+
+                // Compute shaders are part of the "other" stages.
+                return (feature.PixelShaderMinPrecision & D3D11_SHADER_MIN_PRECISION_16_BIT) != 0 &&
+                       (feature.AllOtherShaderStagesMinPrecision & D3D11_SHADER_MIN_PRECISION_16_BIT) != 0;
             }
             if (auto device12 = device->getAs<D3D12>()) {
                 D3D12_FEATURE_DATA_D3D12_OPTIONS feature = {};
@@ -286,8 +496,9 @@ namespace toolkit::graphics {
     }
 
     std::shared_ptr<IImageProcessor> CreateImageProcessor(std::shared_ptr<IConfigManager> configManager,
-                                                          std::shared_ptr<IDevice> graphicsDevice) {
-        return std::make_shared<ImageProcessor>(configManager, graphicsDevice);
+                                                          std::shared_ptr<IDevice> graphicsDevice,
+                                                          const std::string& systemName) {
+        return std::make_shared<ImageProcessor>(configManager, graphicsDevice, systemName);
     }
 
 } // namespace toolkit::graphics
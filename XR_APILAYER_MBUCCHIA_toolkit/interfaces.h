@@ -88,6 +88,226 @@ namespace toolkit {
         // A CPU synchronous timer.
         struct ICpuTimer : public ITimer {};
 
+        // The timings of a single frame (in microseconds).
+        struct FrameStatistics {
+            uint64_t timeUs;
+            uint32_t appCpuTimeUs;
+            uint32_t renderCpuTimeUs;
+            uint32_t appGpuTimeUs;
+            uint32_t waitCpuTimeUs;
+            uint32_t endFrameCpuTimeUs;
+            uint32_t processorGpuTimeUs[2];
+            uint32_t overlayGpuTimeUs;
+
+            // See menu::MenuStatistics.
+            uint32_t inputLatencyUs;
+            uint32_t waitLatencyUs;
+            uint32_t beginLatencyUs;
+            uint32_t renderLatencyUs;
+            uint32_t endFrameLatencyUs;
+            uint32_t submitLatencyUs;
+
+            // See graphics::VariableRateShaderStatistics.
+            uint32_t vrsCandidateBinds;
+            uint32_t vrsRejectedBinds[3];
+            uint32_t vrsMaskHits;
+            uint32_t vrsMaskMisses;
+            uint32_t vrsMaskEvictions;
+            uint16_t vrsTileCoverage[6]; // In 1/10000th of the tiles.
+        };
+
+        // A per-frame statistics recorder. Recording is non-blocking: the samples are written out (along with the
+        // percentiles for each window) by a background thread.
+        struct IStatisticsRecorder {
+            virtual ~IStatisticsRecorder() = default;
+
+            virtual void record(const FrameStatistics& frame) = 0;
+        };
+
+        // How the scheduling of a thread is managed, see RegisterThread().
+        enum class ThreadClass { Frame, Background };
+
+        // A frame rate limiter. It sleeps on a high-resolution waitable timer and spins for the last stretch, so that it
+        // does not need to raise the system-wide timer resolution.
+        struct IFrameLimiter {
+            virtual ~IFrameLimiter() = default;
+
+            // Block until the next frame may begin at the requested frame rate.
+            virtual void wait(uint32_t frameRate) = 0;
+
+            // Report how long the runtime blocked in its own frame wait, right after ours. The limiter slowly shifts
+            // its deadline to keep this short, which reduces the latency of the throttled frames.
+            virtual void reportRuntimeWait(std::chrono::steady_clock::duration duration) = 0;
+
+            // Start over (eg: after a pause in frame submission).
+            virtual void reset() = 0;
+
+            // Whether a high-resolution timer is available. When it is not, the system timer resolution must be raised
+            // for the limiter to be accurate.
+            virtual bool isHighResolution() const = 0;
+        };
+
+        // The video memory budget given by the OS to the process. DXGI signals the changes of the budget, and the
+        // usage is refreshed periodically.
+        struct IVideoMemoryBudget {
+            virtual ~IVideoMemoryBudget() = default;
+
+            // Whether the usage of the process is close to the budget. This call does not block.
+            virtual bool isUnderPressure() = 0;
+
+            virtual uint64_t getBudget() const = 0;
+            virtual uint64_t getUsage() const = 0;
+        };
+
+        // A map for the handful of handles (swapchains, spaces, textures...) looked up on the hot paths. The keys are
+        // kept contiguous and searched linearly, which beats a tree or a hash for the few entries we deal with.
+        // The entries are allocated individually, so that like with std::map, a reference to a value stays valid until
+        // that entry is erased, even when the map grows or another entry is erased. Erasing swaps the entry with the
+        // last one: it invalidates the iterators, and does not preserve the order.
+        template <typename Key, typename Value>
+        class FlatMap {
+          public:
+            using value_type = std::pair<Key, Value>;
+
+          private:
+            using Entries = std::vector<std::unique_ptr<value_type>>;
+
+            template <typename T>
+            class Iterator {
+              public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = ptrdiff_t;
+                using pointer = T*;
+                using reference = T&;
+
+                Iterator() = default;
+                Iterator(typename Entries::const_iterator it) : m_it(it) {
+                }
+
+                // Allow the conversion from iterator to const_iterator.
+                template <typename U>
+                Iterator(const Iterator<U>& other) : m_it(other.m_it) {
+                }
+
+                reference operator*() const {
+                    return **m_it;
+                }
+                pointer operator->() const {
+                    return m_it->get();
+                }
+
+                Iterator& operator++() {
+                    ++m_it;
+                    return *this;
+                }
+                Iterator operator++(int) {
+                    return Iterator(m_it++);
+                }
+
+                template <typename U>
+                bool operator==(const Iterator<U>& other) const {
+                    return m_it == other.m_it;
+                }
+                template <typename U>
+                bool operator!=(const Iterator<U>& other) const {
+                    return m_it != other.m_it;
+                }
+
+              private:
+                template <typename U>
+                friend class Iterator;
+                friend class FlatMap;
+
+                typename Entries::const_iterator m_it;
+            };
+
+          public:
+            using iterator = Iterator<value_type>;
+            using const_iterator = Iterator<const value_type>;
+
+            iterator find(const Key& key) {
+                return m_entries.cbegin() + indexOf(key);
+            }
+
+            const_iterator find(const Key& key) const {
+                return m_entries.cbegin() + indexOf(key);
+            }
+
+            bool contains(const Key& key) const {
+                return indexOf(key) != m_keys.size();
+            }
+
+            template <typename T>
+            std::pair<iterator, bool> insert_or_assign(const Key& key, T&& value) {
+                const size_t index = indexOf(key);
+                if (index != m_keys.size()) {
+                    m_entries[index]->second = std::forward<T>(value);
+                    return {m_entries.cbegin() + index, false};
+                }
+                m_entries.push_back(std::make_unique<value_type>(key, std::forward<T>(value)));
+                m_keys.push_back(key);
+                return {m_entries.cend() - 1, true};
+            }
+
+            void erase(const_iterator it) {
+                const size_t index = it.m_it - m_entries.cbegin();
+                if (index != m_keys.size() - 1) {
+                    m_keys[index] = std::move(m_keys.back());
+                    m_entries[index] = std::move(m_entries.back());
+                }
+                m_keys.pop_back();
+                m_entries.pop_back();
+            }
+
+            void erase(const Key& key) {
+                const auto it = find(key);
+                if (it != end()) {
+                    erase(it);
+                }
+            }
+
+            void clear() {
+                m_keys.clear();
+                m_entries.clear();
+            }
+
+            size_t size() const {
+                return m_keys.size();
+            }
+
+            bool empty() const {
+                return m_keys.empty();
+            }
+
+            iterator begin() {
+                return m_entries.cbegin();
+            }
+            iterator end() {
+                return m_entries.cend();
+            }
+            const_iterator begin() const {
+                return m_entries.cbegin();
+            }
+            const_iterator end() const {
+                return m_entries.cend();
+            }
+            const_iterator cbegin() const {
+                return m_entries.cbegin();
+            }
+            const_iterator cend() const {
+                return m_entries.cend();
+            }
+
+          private:
+            size_t indexOf(const Key& key) const {
+                return std::find(m_keys.cbegin(), m_keys.cend(), key) - m_keys.cbegin();
+            }
+
+            std::vector<Key> m_keys;
+            Entries m_entries;
+        };
+
         // [-1,+1] (+up) -> [0..1] (+dn)
         inline constexpr XrVector2f NdcToScreen(XrVector2f v) {
             return {(v.x + 1.f) * 0.5f, (v.y - 1.f) * -0.5f};
@@ -102,106 +322,180 @@ namespace toolkit {
 
     namespace config {
 
-        const std::string SettingFirstRun = "first_run2";
-        const std::string SettingDeveloper = "developer";
-        const std::string SettingReloadShaders = "reload_shaders";
-        const std::string SettingScreenshotEnabled = "enable_screenshot";
-        const std::string SettingScreenshotFileFormat = "screenshot_fileformat";
-        const std::string SettingScreenshotEye = "screenshot_eye";
-        const std::string SettingScreenshotKey = "key_screenshot";
-        const std::string SettingKeyCtrlModifier = "ctrl_modifier";
-        const std::string SettingKeyAltModifier = "alt_modifier";
-        const std::string SettingMenuKeyUp = "key_up";
-        const std::string SettingMenuKeyDown = "key_menu";
-        const std::string SettingMenuKeyLeft = "key_left";
-        const std::string SettingMenuKeyRight = "key_right";
-        const std::string SettingMenuEyeVisibility = "menu_eye";
-        const std::string SettingMenuEyeOffset = "menu_eye_offset";
-        const std::string SettingMenuDistance = "menu_distance";
-        const std::string SettingMenuOpacity = "menu_opacity";
-        const std::string SettingMenuLegacyMode = "menu_legacy_mode";
-        const std::string SettingOverlayType = "overlay";
-        const std::string SettingOverlayShowClock = "overlay_show_clock";
-        const std::string SettingOverlayXOffset = "overlay_x_offset";
-        const std::string SettingOverlayYOffset = "overlay_y_offset";
-        const std::string SettingMenuFontSize = "font_size2";
-        const std::string SettingMenuTimeout = "menu_timeout";
-        const std::string SettingMenuExpert = "expert_menu";
-        const std::string SettingScalingType = "scaling_type";
-        const std::string SettingScaling = "scaling";
-        const std::string SettingAnamorphic = "anamorphic";
-        const std::string SettingSharpness = "sharpness";
-        const std::string SettingMipMapBias = "mipmap_bias";
-        const std::string SettingICD = "world_scale";
-        const std::string SettingFOVType = "fov_type";
-        const std::string SettingFOV = "fov";
-        const std::string SettingFOVUp = "fov_up";
-        const std::string SettingFOVDown = "fov_down";
-        const std::string SettingFOVLeftLeft = "fov_ll";
-        const std::string SettingFOVLeftRight = "fov_lr";
-        const std::string SettingFOVRightLeft = "fov_rl";
-        const std::string SettingFOVRightRight = "fov_rr";
-        const std::string SettingZoom = "zoom";
-        const std::string SettingDisableHAM = "disable_ham";
-        const std::string SettingBlindEye = "blind_eye";
-        const std::string SettingHandTrackingEnabled = "enable_hand_tracking";
-        const std::string SettingHandVisibilityAndSkinTone = "hand_visibility";
-        const std::string SettingHandOcclusion = "hand_occlusion";
-        const std::string SettingHandTimeout = "hand_timeout";
-        const std::string SettingPredictionDampen = "prediction_dampen";
-        const std::string SettingBypassMsftHandInteractionCheck = "allow_msft_hand_interaction";
-        const std::string SettingBypassMsftEyeGazeInteractionCheck = "allow_msft_eye_gaze_interaction";
-        const std::string SettingMotionReprojection = "motion_reprojection";
-        const std::string SettingMotionReprojectionRate = "motion_reprojection_rate";
-        const std::string SettingVRS = "vrs";
-        const std::string SettingVRSQuality = "vrs_quality";
-        const std::string SettingVRSPattern = "vrs_pattern";
-        const std::string SettingVRSOuter = "vrs_outer";
-        const std::string SettingVRSOuterRadius = "vrs_outer_radius";
-        const std::string SettingVRSMiddle = "vrs_middle";
-        const std::string SettingVRSInnerRadius = "vrs_inner_radius";
-        const std::string SettingVRSInner = "vrs_inner";
-        const std::string SettingVRSXOffset = "vrs_x_offset";
-        const std::string SettingVRSXScale = "vrs_x_scale";
-        const std::string SettingVRSYOffset = "vrs_y_offset";
-        const std::string SettingVRSPreferHorizontal = "vrs_prefer_horizontal";
-        const std::string SettingVRSLeftRightBias = "vrs_lr_bias";
-        const std::string SettingVRSScaleFilter = "vrs_scale_filter2";
-        const std::string SettingVRSCullHAM = "vrs_cull_mask";
-        const std::string SettingPostProcess = "post_process";
-        const std::string SettingPostSunGlasses = "post_sunglasses";
-        const std::string SettingPostContrast = "post_contrast";
-        const std::string SettingPostBrightness = "post_brightness";
-        const std::string SettingPostExposure = "post_exposure";
-        const std::string SettingPostSaturation = "post_saturation";
-        const std::string SettingPostVibrance = "post_vibrance";
-        const std::string SettingPostColorGainR = "post_gain_r";
-        const std::string SettingPostColorGainG = "post_gain_g";
-        const std::string SettingPostColorGainB = "post_gain_b";
-        const std::string SettingPostHighlights = "post_highlights";
-        const std::string SettingPostShadows = "post_shadows";
-        const std::string SettingPostChromaticCorrectionR = "post_ca_r";
-        const std::string SettingPostChromaticCorrectionB = "post_ca_b";
-        const std::string SettingEyeTrackingEnabled = "eye_tracking";
-        const std::string SettingEyeProjectionDistance = "eye_projection";
-        const std::string SettingEyeDebug = "eye_debug";
-        const std::string SettingEyeDebugWithController = "eye_controller_debug";
-        const std::string SettingResolutionOverride = "override_resolution";
-        const std::string SettingResolutionHeight = "resolution_height";
-        const std::string SettingDisableInterceptor = "disable_interceptor";
-        const std::string SettingRecordStats = "record_stats";
-        const std::string SettingHighRateStats = "high_rate_stats";
-        const std::string SettingFrameThrottling = "frame_throttle";
-        const std::string SettingTurboMode = "turbo";
-        const std::string SettingTargetFrameRate = "target_rate";
-        const std::string SettingTargetFrameRate2 = "target_rate2";
+        // The settings known at compile time. Each one gets a slot in the configuration manager, so that accessing it
+        // does not need to look up its name. The name is only used to read and write the registry.
+#define TOOLKIT_CONFIG_SETTINGS(X)                                                                                     \
+    X(FirstRun, "first_run2")                                                                                          \
+    X(Developer, "developer")                                                                                          \
+    X(ReloadShaders, "reload_shaders")                                                                                 \
+    X(ScreenshotEnabled, "enable_screenshot")                                                                          \
+    X(ScreenshotFileFormat, "screenshot_fileformat")                                                                   \
+    X(ScreenshotEye, "screenshot_eye")                                                                                 \
+    X(ScreenshotKey, "key_screenshot")                                                                                 \
+    X(KeyCtrlModifier, "ctrl_modifier")                                                                                \
+    X(KeyAltModifier, "alt_modifier")                                                                                  \
+    X(MenuKeyUp, "key_up")                                                                                             \
+    X(MenuKeyDown, "key_menu")                                                                                         \
+    X(MenuKeyLeft, "key_left")                                                                                         \
+    X(MenuKeyRight, "key_right")                                                                                       \
+    X(MenuEyeVisibility, "menu_eye")                                                                                   \
+    X(MenuEyeOffset, "menu_eye_offset")                                                                                \
+    X(MenuDistance, "menu_distance")                                                                                   \
+    X(MenuOpacity, "menu_opacity")                                                                                     \
+    X(MenuLegacyMode, "menu_legacy_mode")                                                                              \
+    X(OverlayType, "overlay")                                                                                          \
+    X(OverlayShowClock, "overlay_show_clock")                                                                          \
+    X(OverlayXOffset, "overlay_x_offset")                                                                              \
+    X(OverlayYOffset, "overlay_y_offset")                                                                              \
+    X(MenuFontSize, "font_size2")                                                                                      \
+    X(MenuTimeout, "menu_timeout")                                                                                     \
+    X(MenuExpert, "expert_menu")                                                                                       \
+    X(ScalingType, "scaling_type")                                                                                     \
+    X(Scaling, "scaling")                                                                                              \
+    X(Anamorphic, "anamorphic")                                                                                        \
+    X(Sharpness, "sharpness")                                                                                          \
+    X(MipMapBias, "mipmap_bias")                                                                                       \
+    X(ICD, "world_scale")                                                                                              \
+    X(FOVType, "fov_type")                                                                                             \
+    X(FOV, "fov")                                                                                                      \
+    X(FOVUp, "fov_up")                                                                                                 \
+    X(FOVDown, "fov_down")                                                                                             \
+    X(FOVLeftLeft, "fov_ll")                                                                                           \
+    X(FOVLeftRight, "fov_lr")                                                                                          \
+    X(FOVRightLeft, "fov_rl")                                                                                          \
+    X(FOVRightRight, "fov_rr")                                                                                         \
+    X(Zoom, "zoom")                                                                                                    \
+    X(DisableHAM, "disable_ham")                                                                                       \
+    X(BlindEye, "blind_eye")                                                                                           \
+    X(HandTrackingEnabled, "enable_hand_tracking")                                                                     \
+    X(HandVisibilityAndSkinTone, "hand_visibility")                                                                    \
+    X(HandOcclusion, "hand_occlusion")                                                                                 \
+    X(HandTimeout, "hand_timeout")                                                                                     \
+    X(PredictionDampen, "prediction_dampen")                                                                           \
+    X(PredictionDampenAuto, "prediction_dampen_auto")                                                                  \
+    X(BypassMsftHandInteractionCheck, "allow_msft_hand_interaction")                                                   \
+    X(BypassMsftEyeGazeInteractionCheck, "allow_msft_eye_gaze_interaction")                                            \
+    X(MotionReprojection, "motion_reprojection")                                                                       \
+    X(MotionReprojectionRate, "motion_reprojection_rate")                                                              \
+    X(VRS, "vrs")                                                                                                      \
+    X(VRSQuality, "vrs_quality")                                                                                       \
+    X(VRSPattern, "vrs_pattern")                                                                                       \
+    X(VRSOuter, "vrs_outer")                                                                                           \
+    X(VRSOuterRadius, "vrs_outer_radius")                                                                              \
+    X(VRSMiddle, "vrs_middle")                                                                                         \
+    X(VRSInnerRadius, "vrs_inner_radius")                                                                              \
+    X(VRSInner, "vrs_inner")                                                                                           \
+    X(VRSXOffset, "vrs_x_offset")                                                                                      \
+    X(VRSXScale, "vrs_x_scale")                                                                                        \
+    X(VRSYOffset, "vrs_y_offset")                                                                                      \
+    X(VRSPreferHorizontal, "vrs_prefer_horizontal")                                                                    \
+    X(VRSLeftRightBias, "vrs_lr_bias")                                                                                 \
+    X(VRSScaleFilter, "vrs_scale_filter2")                                                                             \
+    X(VRSCullHAM, "vrs_cull_mask")                                                                                     \
+    X(PostProcess, "post_process")                                                                                     \
+    X(PostSunGlasses, "post_sunglasses")                                                                               \
+    X(PostContrast, "post_contrast")                                                                                   \
+    X(PostBrightness, "post_brightness")                                                                               \
+    X(PostExposure, "post_exposure")                                                                                   \
+    X(PostSaturation, "post_saturation")                                                                               \
+    X(PostVibrance, "post_vibrance")                                                                                   \
+    X(PostColorGainR, "post_gain_r")                                                                                   \
+    X(PostColorGainG, "post_gain_g")                                                                                   \
+    X(PostColorGainB, "post_gain_b")                                                                                   \
+    X(PostHighlights, "post_highlights")                                                                               \
+    X(PostShadows, "post_shadows")                                                                                     \
+    X(PostChromaticCorrectionR, "post_ca_r")                                                                           \
+    X(PostChromaticCorrectionB, "post_ca_b")                                                                           \
+    X(EyeTrackingEnabled, "eye_tracking")                                                                              \
+    X(EyeProjectionDistance, "eye_projection")                                                                         \
+    X(EyeDebug, "eye_debug")                                                                                           \
+    X(EyeDebugWithController, "eye_controller_debug")                                                                  \
+    X(ResolutionOverride, "override_resolution")                                                                       \
+    X(ResolutionHeight, "resolution_height")                                                                           \
+    X(DisableInterceptor, "disable_interceptor")                                                                       \
+    X(RecordStats, "record_stats")                                                                                     \
+    X(HighRateStats, "high_rate_stats")                                                                                \
+    X(FrameThrottling, "frame_throttle")                                                                               \
+    X(TurboMode, "turbo")                                                                                              \
+    X(TargetFrameRate, "target_rate")                                                                                  \
+    X(TargetFrameRate2, "target_rate2")                                                                                \
+    /* Settings without a menu entry. */                                                                               \
+    X(KeyMenuGeneration, "key_menu_gen")                                                                               \
+    X(DisableFrameAnalyzer, "disable_frame_analyzer")                                                                  \
+    X(Canting, "canting")                                                                                              \
+    X(VRSCapture, "vrs_capture")                                                                                       \
+    X(VRSContentAdaptive, "vrs_content_adaptive")                                                                      \
+    X(VRSDepthAdaptive, "vrs_depth_adaptive")                                                                          \
+    X(VRSDepthDistance2x2, "vrs_depth_distance_2x2")                                                                   \
+    X(VRSDepthDistance4x4, "vrs_depth_distance_4x4")                                                                   \
+    X(HiddenAreaPrePass, "hidden_area_prepass")                                                                        \
+    X(ForceVPRTPath, "force_vprt_path")                                                                                \
+    X(FusedPostProcess, "fused_post_process")                                                                          \
+    X(StereoDispatch, "stereo_dispatch")                                                                               \
+    X(FSRSinglePass, "fsr_single_pass")                                                                                \
+    X(TemporalHistoryWeight, "temporal_history_weight")                                                                \
+    X(ShaderTuning, "shader_tuning")                                                                                   \
+    X(FoveatedUpscaling, "foveated_upscaling")                                                                         \
+    X(RecordStatsPerFrame, "record_stats_per_frame")                                                                   \
+    X(DynamicResolution, "dynamic_resolution")                                                                         \
+    X(DynamicResolutionMin, "dynamic_resolution_min")                                                                  \
+    X(DynamicResolutionMax, "dynamic_resolution_max")                                                                  \
+    X(PipelineCache, "pipeline_cache")                                                                                 \
+    X(PipelineCachePreload, "pipeline_cache_preload")                                                                  \
+    X(D3D11ContextState, "d3d11_context_state")                                                                        \
+    X(DroolonPort, "droolon_port")                                                                                     \
+    X(AllowCACorrection, "allow_ca_correction")                                                                        \
+    X(HandTrackingRate, "hand_tracking_rate")                                                                          \
+    X(LateLatch, "late_latch")                                                                                         \
+    X(ThreadScheduling, "thread_scheduling")                                                                           \
+    X(LocateSpaceCache, "locate_space_cache")                                                                          \
+    X(ReducedEye, "reduced_eye")                                                                                       \
+    X(ReducedEyeScaling, "reduced_eye_scaling")                                                                        \
+    X(Telemetry, "telemetry")                                                                                          \
+    X(BenchmarkSweep, "benchmark_sweep")                                                                               \
+    X(BenchmarkSweepFrames, "benchmark_sweep_frames")                                                                  \
+    X(BenchmarkSweepTarget, "benchmark_sweep_target")                                                                  \
+    X(ShadowSwapchainImages, "shadow_swapchain_images")                                                                \
+    X(SRGBAliasing, "srgb_aliasing")                                                                                   \
+    X(DebugCpuLoad, "debug_cpu_load")                                                                                  \
+    X(DebugGpuLoad, "debug_gpu_load")
+
+        enum class SettingId : uint32_t {
+#define X(id, name) id,
+            TOOLKIT_CONFIG_SETTINGS(X)
+#undef X
+            MaxValue
+        };
+
+        struct Setting {
+            SettingId id;
+            std::string name;
+
+            operator const std::string&() const {
+                return name;
+            }
+        };
+
+        inline bool operator==(const std::string& name, const Setting& setting) {
+            return name == setting.name;
+        }
+        inline bool operator!=(const std::string& name, const Setting& setting) {
+            return name != setting.name;
+        }
+        inline std::string operator+(const Setting& setting, const char* suffix) {
+            return setting.name + suffix;
+        }
+
+#define X(id, name) const Setting Setting##id{SettingId::id, name};
+        TOOLKIT_CONFIG_SETTINGS(X)
+#undef X
 
         enum class OffOnType { Off = 0, On, MaxValue };
         enum class NoYesType { No = 0, Yes, MaxValue };
         enum class OverlayType { None = 0, FPS, Advanced, Developer, MaxValue };
         enum class MenuFontSize { Small = 0, Medium, Large, MaxValue };
         enum class MenuTimeout { Small = 0, Medium, Large, None, MaxValue };
-        enum class ScalingType { None = 0, NIS, FSR, CAS, MaxValue };
+        enum class ScalingType { None = 0, NIS, FSR, CAS, Temporal, MaxValue };
         enum class MipMapBias { Off = 0, Anisotropic, All, MaxValue };
         enum class HandTrackingEnabled { Off = 0, Both, Left, Right, MaxValue };
         enum class HandTrackingVisibility { Hidden = 0, Bright, Medium, Dark, Darker, MaxValue };
@@ -238,6 +532,16 @@ namespace toolkit {
             virtual void setValue(const std::string& name, int value, bool noCommitDelay = false) = 0;
             virtual bool hasChanged(const std::string& name) const = 0;
 
+            // Same as above, for the settings known at compile time.
+            virtual void setDefault(const Setting& setting, int value) = 0;
+            virtual int getValue(const Setting& setting) const = 0;
+            virtual int peekValue(const Setting& setting) const = 0;
+            virtual void setValue(const Setting& setting, int value, bool noCommitDelay = false) = 0;
+            virtual bool hasChanged(const Setting& setting) const = 0;
+
+            // A counter incremented whenever any value changes, whether from the layer or from the companion app.
+            virtual uint64_t getChangeSerial() const = 0;
+
             virtual void deleteValue(const std::string& name) = 0;
             virtual void resetToDefaults() = 0;
 
@@ -262,6 +566,23 @@ namespace toolkit {
                 const auto value = peekValue(name);
                 return static_cast<T>(std::clamp(value, std::underlying_type_t<T>(0), to_integral(T::MaxValue) - 1));
             }
+
+            template <typename T, std::enable_if_t<std::is_enum<T>::value, bool> = true>
+            void setEnumDefault(const Setting& setting, T value) {
+                setDefault(setting, static_cast<int>(to_integral(value)));
+            }
+
+            template <typename T, std::enable_if_t<std::is_enum<T>::value, bool> = true>
+            T getEnumValue(const Setting& setting) const {
+                const auto value = getValue(setting);
+                return static_cast<T>(std::clamp(value, std::underlying_type_t<T>(0), to_integral(T::MaxValue) - 1));
+            }
+
+            template <typename T, std::enable_if_t<std::is_enum<T>::value, bool> = true>
+            T peekEnumValue(const Setting& setting) const {
+                const auto value = peekValue(setting);
+                return static_cast<T>(std::clamp(value, std::underlying_type_t<T>(0), to_integral(T::MaxValue) - 1));
+            }
         };
 
     } // namespace config
@@ -446,6 +767,9 @@ namespace toolkit {
             }
         };
 
+        // Special slice index to view all the slices of a texture array at once.
+        constexpr int32_t AllSlices = -2;
+
         // A texture, plain and simple!
         struct ITexture {
             virtual ~ITexture() = default;
@@ -472,6 +796,11 @@ namespace toolkit {
             virtual void pushState(D3D12_RESOURCE_STATES newState) = 0;
             virtual void popState() = 0;
 
+            // For an sRGB texture created typeless, a texture sharing its memory and its state, whose views are UNORM.
+            // It reads and writes the sRGB-encoded values as they are, including from compute shaders. Otherwise
+            // nullptr.
+            virtual std::shared_ptr<ITexture> getUnormAlias() const = 0;
+
             virtual void* getNativePtr() const = 0;
 
             template <typename ApiTraits>
@@ -505,6 +834,12 @@ namespace toolkit {
             XrVector3f Color;
         };
 
+        // The placement of one instance of a mesh drawn with drawInstanced().
+        struct SimpleMeshInstance {
+            XrPosef pose;
+            XrVector3f scaling{1.0f, 1.0f, 1.0f};
+        };
+
         // A simple (unskinned) mesh.
         struct ISimpleMesh {
             virtual ~ISimpleMesh() = default;
@@ -524,6 +859,225 @@ namespace toolkit {
         struct IGpuTimer : public ITimer {
             virtual Api getApi() const = 0;
             virtual std::shared_ptr<IDevice> getDevice() const = 0;
+
+            // Whether the measurement of the last start()/stop() is available, without stalling the CPU.
+            virtual bool isReady() const = 0;
+        };
+
+        // An asynchronous copy of a texture region into CPU-readable memory.
+        struct ITextureReadback {
+            virtual ~ITextureReadback() = default;
+
+            virtual Api getApi() const = 0;
+            virtual const XrSwapchainCreateInfo& getInfo() const = 0;
+
+            // Enqueue the copy of a region (the size of the readback) of the source texture.
+            virtual void copyFrom(std::shared_ptr<ITexture> source, uint32_t srcX, uint32_t srcY, int32_t srcSlice) = 0;
+
+            // Whether the copy has completed, without stalling the CPU.
+            virtual bool isReady() const = 0;
+
+            // Read the pixels, with the returned row pitch. Only valid once isReady() returns true.
+            virtual void readPixels(std::vector<uint8_t>& pixels, uint32_t& rowPitch) = 0;
+        };
+
+        // An asynchronous screenshot pipeline: the textures are read back without stalling and encoded on a
+        // background thread.
+        struct IScreenshotCapture {
+            virtual ~IScreenshotCapture() = default;
+
+            // Whether the texture format can be encoded asynchronously.
+            virtual bool isFormatSupported(int64_t format) const = 0;
+
+            // Enqueue the capture of a region of the texture into the file (PNG, JPG, BMP or DDS).
+            virtual void capture(std::shared_ptr<ITexture> source,
+                                 const XrRect2Di& region,
+                                 int32_t slice,
+                                 const std::filesystem::path& path) = 0;
+
+            // Hand the completed readbacks to the encoder thread.
+            virtual void poll() = 0;
+
+            // Destroy the readbacks that are not in use.
+            virtual void trim() = 0;
+        };
+
+        // A pool of intermediate textures. A texture released to the pool is handed out again for any later request
+        // with the same properties, which lets intermediates whose lifetimes do not overlap share the same memory.
+        struct ITexturePool {
+            virtual ~ITexturePool() = default;
+
+            // Obtain a texture, either from the pool or newly created.
+            virtual std::shared_ptr<ITexture> acquire(const XrSwapchainCreateInfo& info,
+                                                      std::string_view debugName) = 0;
+
+            // Return a texture to the pool. Its content may be overwritten by the next user.
+            virtual void release(std::shared_ptr<ITexture> texture) = 0;
+
+            // Destroy all the textures held by the pool.
+            virtual void clear() = 0;
+
+            // Destroy the textures that were not used since the previous call.
+            virtual void trim() = 0;
+        };
+
+        // The toolkit work of a frame, recorded with a single save and restore of the context and submitted once at the
+        // end of the frame. The registered passes are recorded in an order satisfying the dependencies that they
+        // declare: the passes that do not depend on the composition of the layers are recorded before it.
+        struct IFrameScheduler {
+            // The name of the composition of the layers, for the passes that consume its results.
+            static constexpr const char* CompositionPass = "Composition";
+
+            virtual ~IFrameScheduler() = default;
+
+            // The dependencies are the names of the passes that must be recorded before this one.
+            virtual void registerPass(const std::string& name,
+                                      const std::vector<std::string>& dependencies,
+                                      std::function<void()> record) = 0;
+            virtual void unregisterPass(const std::string& name) = 0;
+
+            // Save the context and record the passes preceding the composition. The composition is recorded until
+            // submitFrame().
+            virtual void beginFrame() = 0;
+
+            // Record the passes following the composition, restore the context and submit the work of the frame.
+            virtual void submitFrame() = 0;
+        };
+
+        // A closed-loop controller of the rendering quality, based on the GPU frame time.
+        struct IDynamicResolutionController {
+            virtual ~IDynamicResolutionController() = default;
+
+            virtual void update(uint64_t gpuFrameTimeUs, XrDuration displayPeriod) = 0;
+
+            // The current reduction level (0 is full quality).
+            virtual int getLevel() const = 0;
+        };
+
+        // The placement of a rasterized glyph within a glyph atlas.
+        struct GlyphInfo {
+            // Offset of the glyph bitmap from the pen position (top of the line), in pixels.
+            float offsetX;
+            float offsetY;
+            uint32_t width;
+            uint32_t height;
+
+            // Normalized texture coordinates in the atlas.
+            float u0, v0, u1, v1;
+
+            float advance;
+        };
+
+        // A CPU-side atlas of glyphs rasterized on-demand, with 8-bit coverage per texel. The atlas is API-agnostic
+        // and must be uploaded by the device whenever it is dirty.
+        struct IGlyphAtlas {
+            virtual ~IGlyphAtlas() = default;
+
+            virtual uint32_t getWidth() const = 0;
+            virtual uint32_t getHeight() const = 0;
+
+            // Return the placement of the glyph, rasterizing it if needed.
+            virtual std::optional<GlyphInfo> getGlyph(wchar_t c, TextStyle style, float size) = 0;
+            virtual float measureString(std::wstring_view string, TextStyle style, float size) = 0;
+
+            virtual const std::vector<uint8_t>& getPixels() const = 0;
+            virtual bool isDirty() const = 0;
+            virtual void clearDirty() = 0;
+
+            // Called once the frame is submitted. When the atlas fills up, it is only reset then, so that the glyphs
+            // placed during a frame remain valid until they are drawn.
+            virtual void nextFrame() = 0;
+        };
+
+        // The properties of the application textures that are of interest to the event handlers.
+        struct EventsFilter {
+            uint32_t minWidth{0};
+            uint32_t minHeight{0};
+            uint32_t maxArraySize{UINT32_MAX};
+        };
+
+        // The calls of the application that the device intercepts. Each call is only forwarded to the layer while at
+        // least one subsystem is subscribed to it.
+        enum class InterceptedCall : uint32_t {
+            SetRenderTargets = 0, // SetRenderTargetEvent and UnsetRenderTargetEvent.
+            CopyTexture,          // CopyTextureEvent.
+            SetSamplers,          // Mip-map biasing.
+            ClearDepth,           // ClearDepthEvent.
+
+            MaxValue
+        };
+
+        // The GPU passes measured by the layer.
+        enum class GpuPass : uint32_t {
+            App = 0,
+            VariableRateShading,
+            Upscaling,
+            PostProcessing,
+            Overlay,
+            HandTracking,
+
+            MaxValue
+        };
+
+        // A pool of GPU timers, with named scopes per pass. The timers are recycled once their measurement has been
+        // read back, so the number of frames in flight does not need to be known in advance.
+        struct IGpuTimerPool {
+            virtual ~IGpuTimerPool() = default;
+
+            virtual void start(GpuPass pass) = 0;
+            virtual void stop(GpuPass pass) = 0;
+
+            // Collect the measurements that have become available (non-blocking).
+            virtual void poll() = 0;
+
+            // Return the accumulated time for the pass (in microseconds) since the last query.
+            virtual uint64_t query(GpuPass pass, bool reset = true) = 0;
+
+            // Return the most recent measurement for the pass (in microseconds).
+            virtual uint64_t getLastDuration(GpuPass pass) const = 0;
+        };
+
+        // The measurement of a profiler scope. Scopes are listed in the order they were first opened, and their depth
+        // gives the nesting under the previous scopes of a lower depth.
+        struct GpuProfileScope {
+            char name[24];
+            uint32_t depth;
+            uint64_t durationUs;
+        };
+
+        // The upper bound of distinct scopes reported by a profiler.
+        constexpr size_t MaxGpuProfileScopes = 16;
+
+        // A profiler for the named scopes of GPU work opened with IDevice::beginProfileScope(). The timers are
+        // recycled like with IGpuTimerPool.
+        struct IGpuProfiler {
+            virtual ~IGpuProfiler() = default;
+
+            virtual void beginScope(std::string_view name) = 0;
+            virtual void endScope() = 0;
+
+            // Collect the measurements that have become available (non-blocking).
+            virtual void poll() = 0;
+
+            // Copy the accumulated time of each scope (in microseconds) since the last query, and return the number of
+            // scopes.
+            virtual uint32_t query(GpuProfileScope* scopes, uint32_t maxScopes, bool reset = true) = 0;
+        };
+
+        // A compute shader compiled with several thread group sizes. The candidates are benchmarked in turn, then the
+        // fastest one is kept and remembered for the adapter. The dispatches must be surrounded by
+        // beginDispatch()/endDispatch(), and getShader()/getThreadGroupSize() must be used in between.
+        struct ITunedComputeShader {
+            virtual ~ITunedComputeShader() = default;
+
+            virtual void beginDispatch() = 0;
+            virtual void endDispatch() = 0;
+
+            virtual std::shared_ptr<IComputeShader> getShader() const = 0;
+            virtual XrExtent2Di getThreadGroupSize() const = 0;
+
+            // Whether the benchmark is over.
+            virtual bool isTuned() const = 0;
         };
 
         // A graphics execution context (eg: command list).
@@ -557,6 +1111,18 @@ namespace toolkit {
             virtual void restoreContext() = 0;
             virtual void flushContext(bool blocking = false, bool isEndOfFrame = false) = 0;
 
+            // Hold a reference to a resource (or any object holding resources) until the GPU has completed the
+            // frames submitted so far, to avoid the implicit synchronization of destroying resources in use.
+            virtual void releaseDeferred(std::shared_ptr<void> resource) = 0;
+
+            // The same tracking, to reuse a resource without waiting on the GPU: the serial of the work recorded so
+            // far, and whether the GPU has completed it. Completion may only be observed when flushing the context.
+            virtual uint64_t getSubmissionSerial() const = 0;
+            virtual bool isSubmissionCompleted(uint64_t serial) const = 0;
+            // Block until the work of a serial is completed, if it would otherwise race with the work that the
+            // application submits next.
+            virtual void waitForSubmission(uint64_t serial) const = 0;
+
             virtual std::shared_ptr<ITexture> createTexture(const XrSwapchainCreateInfo& info,
                                                             std::string_view debugName,
                                                             int64_t overrideFormat = 0,
@@ -588,6 +1154,14 @@ namespace toolkit {
 
             virtual std::shared_ptr<IGpuTimer> createTimer() = 0;
 
+            // Open a named scope of GPU work, which can be nested. The scope is visible in graphics debuggers (eg:
+            // PIX), and it is measured by the profiler when one is set. The device only holds a weak reference to it.
+            virtual void beginProfileScope(std::string_view name) = 0;
+            virtual void endProfileScope() = 0;
+            virtual void setProfiler(std::shared_ptr<IGpuProfiler> profiler) = 0;
+
+            virtual std::shared_ptr<ITextureReadback> createTextureReadback(const XrSwapchainCreateInfo& info) = 0;
+
             // Must be invoked prior to setting the input/output.
             virtual void setShader(std::shared_ptr<IQuadShader> shader, SamplerType sampler) = 0;
 
@@ -596,7 +1170,10 @@ namespace toolkit {
 
             virtual void setShaderInput(uint32_t slot, std::shared_ptr<ITexture> input, int32_t slice = -1) = 0;
             virtual void setShaderInput(uint32_t slot, std::shared_ptr<IShaderBuffer> input) = 0;
-            virtual void setShaderOutput(uint32_t slot, std::shared_ptr<ITexture> output, int32_t slice = -1) = 0;
+            virtual void setShaderOutput(uint32_t slot,
+                                         std::shared_ptr<ITexture> output,
+                                         int32_t slice = -1,
+                                         const XrRect2Di* viewport = nullptr) = 0;
 
             virtual void dispatchShader(bool doNotClear = false) const = 0;
 
@@ -618,6 +1195,9 @@ namespace toolkit {
                               const XrPosef& pose,
                               XrVector3f scaling = {1.0f, 1.0f, 1.0f},
                               bool noCulling = false) = 0;
+            virtual void drawInstanced(std::shared_ptr<ISimpleMesh> mesh,
+                                       const std::vector<SimpleMeshInstance>& instances,
+                                       bool noCulling = false) = 0;
 
             virtual float drawString(std::wstring_view string,
                                      TextStyle style,
@@ -641,7 +1221,8 @@ namespace toolkit {
             virtual void flushText() = 0;
 
             virtual void setMipMapBias(config::MipMapBias biasing, float bias = 0.f) = 0;
-            virtual uint32_t getNumBiasedSamplersThisFrame() const = 0;
+            // Returns the number of samplers biased this frame, and how many of them missed the cache.
+            virtual uint32_t getNumBiasedSamplersThisFrame(uint32_t& numCreated) const = 0;
 
             virtual void resolveQueries() = 0;
 
@@ -659,8 +1240,24 @@ namespace toolkit {
                                                         int /* sourceSlice */,
                                                         int /* destinationSlice */)>;
             virtual void registerCopyTextureEvent(CopyTextureEvent event) = 0;
+            // Raised after the application cleared the depth of a depth buffer (slice -1 for all slices). An empty
+            // event unregisters the previous one.
+            using ClearDepthEvent = std::function<void(std::shared_ptr<IContext> /* context */,
+                                                       std::shared_ptr<ITexture> /* depthBuffer */,
+                                                       int32_t /* slice */,
+                                                       float /* depth */)>;
+            virtual void registerClearDepthEvent(ClearDepthEvent event) = 0;
+
+            // Render targets and copy destinations that do not pass the filter are reported as no render target or
+            // not reported at all, without wrapping them.
+            virtual void setEventsFilter(const EventsFilter& filter) = 0;
+
+            // The subscriptions are counted: a call is forwarded to the layer until its last subscription goes away.
+            virtual void subscribeInterceptedCall(InterceptedCall call) = 0;
+            virtual void unsubscribeInterceptedCall(InterceptedCall call) = 0;
 
             virtual void getVRAMUsage(uint64_t& usage, uint8_t& percentUsed) const = 0;
+            virtual ComPtr<IDXGIAdapter> getAdapter() const = 0;
 
             virtual void shutdown() = 0;
 
@@ -686,17 +1283,72 @@ namespace toolkit {
             }
         };
 
+        // A rectangle within an array slice of a texture.
+        struct TextureRegion {
+            XrRect2Di rect;
+            int32_t slice;
+        };
+
+        // The region of a view seen at full quality, as an ellipse in NDC.
+        struct FoveatedRegion {
+            XrVector2f center;
+            XrVector2f semiAxes;
+        };
+
+        // The view and depth buffer submitted by the application for a view, used to reproject the previous frame.
+        struct TemporalViewInfo {
+            xr::math::ViewProjection view;
+            std::shared_ptr<ITexture> depth;
+            TextureRegion depthRegion;
+        };
+
         // A texture post-processor.
         struct IImageProcessor {
             virtual ~IImageProcessor() = default;
 
             virtual void reload() = 0;
             virtual void update() = 0;
-            virtual void process(std::shared_ptr<ITexture> input,
-                                 std::shared_ptr<ITexture> output,
+            virtual void process(const std::shared_ptr<ITexture>& input,
+                                 const std::shared_ptr<ITexture>& output,
                                  std::vector<std::shared_ptr<ITexture>>& textures,
+                                 std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
                                  std::array<uint8_t, 1024>& blob,
-                                 std::optional<utilities::Eye> eye = std::nullopt) = 0;
+                                 std::optional<utilities::Eye> eye = std::nullopt,
+                                 const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr,
+                                 std::optional<TextureRegion> inputRegion = std::nullopt,
+                                 std::optional<TextureRegion> outputRegion = std::nullopt) = 0;
+
+            // Fused mode: an upscaler may apply the post-processing at the end of its own pass, using the constants
+            // returned by the post-processor (or nullptr if the post-processing cannot be fused).
+            virtual bool isFusedPostProcessSupported() const = 0;
+            virtual std::shared_ptr<IShaderBuffer>
+            getFusedPostProcessConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                         std::array<uint8_t, 1024>& blob,
+                                         std::optional<utilities::Eye> eye = std::nullopt) = 0;
+
+            // Stereo mode: a processor may process both eyes of a texture array in a single pass, reading from and
+            // writing to all the slices of the input and output textures.
+            virtual bool isStereoSupported() const = 0;
+            virtual void processStereo(const std::shared_ptr<ITexture>& input,
+                                       const std::shared_ptr<ITexture>& output,
+                                       std::vector<std::shared_ptr<ITexture>>& textures,
+                                       std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                       std::array<uint8_t, 1024>& blob,
+                                       const std::array<TextureRegion, utilities::ViewCount>& inputRegions,
+                                       const std::array<TextureRegion, utilities::ViewCount>& outputRegions,
+                                       const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr) = 0;
+
+            // Foveated mode: a processor may only run its full kernel within the foveated region of a view, and use a
+            // cheaper filter for the periphery. No region means the entire view.
+            virtual void setFoveatedRegion(utilities::Eye eye, const std::optional<FoveatedRegion>& region) = 0;
+
+            // Temporal mode: a processor may accumulate the previous frames of a view, reprojected with the depth
+            // buffer and view of the current frame. No view means the history cannot be reprojected.
+            virtual void setTemporalView(utilities::Eye eye, const std::optional<TemporalViewInfo>& view) = 0;
+
+            // Whether process() would output the input unchanged (eg: post-processing off with neutral gains), so that
+            // the pass can be skipped.
+            virtual bool isIdentity() const = 0;
         };
 
         struct IFrameAnalyzer {
@@ -723,33 +1375,102 @@ namespace toolkit {
 
             virtual std::optional<utilities::Eye> getEyeHint() const = 0;
             virtual FrameAnalyzerHeuristic getCurrentHeuristic() const = 0;
+
+            // The QPC time when an eye swapchain image was first set as render target during the current frame.
+            virtual std::optional<LARGE_INTEGER> getFirstEyeRenderTime() const = 0;
+        };
+
+        enum class VariableRateShaderRejection { AspectRatio, Size, ArraySize, MaxValue };
+
+        // The effectiveness of VRS during the current frame.
+        struct VariableRateShaderStatistics {
+            // The fraction of the tiles of the views at each rate (see config::VariableShadingRateVal), from the ring
+            // patterns only (before the HAM culling and the content-adaptive rates).
+            float tileCoverage[to_integral(config::VariableShadingRateVal::MaxValue)]{};
+
+            uint32_t numCandidateBinds{0};
+            uint32_t numRejectedBinds[to_integral(VariableRateShaderRejection::MaxValue)]{};
+
+            // Binds of candidates with a mask ready (hit) or pending creation (miss), and masks evicted (over the
+            // memory budget, or trimmed).
+            uint32_t numMaskHits{0};
+            uint32_t numMaskMisses{0};
+            uint32_t numMaskEvictions{0};
         };
 
         // A Variable Rate Shader (VRS) control implementation.
         struct IVariableRateShader {
             virtual ~IVariableRateShader() = default;
 
-            virtual void beginSession(XrSession session) = 0;
+            virtual void beginSession(XrSession session, XrSpace viewSpace) = 0;
             virtual void endSession() = 0;
 
             virtual void beginFrame(XrTime frameTime) = 0;
             virtual void endFrame() = 0;
             virtual void update() = 0;
 
+            // Redraw the masks that are out of date, for the next frame. The context must be saved by the caller. With
+            // eye tracking, the masks are drawn before the composition (with the gaze predicted in beginFrame()),
+            // otherwise after the composition (with its content hints).
+            virtual void recordMasks(bool beforeComposition) = 0;
+
             virtual bool onSetRenderTarget(std::shared_ptr<IContext> context,
                                            std::shared_ptr<ITexture> renderTarget,
                                            std::optional<utilities::Eye> eyeHint) = 0;
             virtual void onUnsetRenderTarget(std::shared_ptr<graphics::IContext> context) = 0;
 
+            // Analyze the view rendered by the application, for the content-adaptive rates of the next frames.
+            virtual void updateContentHints(std::shared_ptr<ITexture> input,
+                                            const TextureRegion& region,
+                                            utilities::Eye eye) = 0;
+
+            // Reduce the depth buffer submitted by the application, for the depth-adaptive rates of the next frames.
+            virtual void updateDepthHints(std::shared_ptr<ITexture> depth,
+                                          const TextureRegion& region,
+                                          const XrCompositionLayerDepthInfoKHR& depthInfo,
+                                          utilities::Eye eye) = 0;
+
+            // The distance (in meters) to the nearest geometry in each tile of the render resolution, from the last
+            // depth buffer analyzed for the view, or nothing when the depth-adaptive rates are disabled.
+            virtual std::shared_ptr<ITexture> getDepthTiles(utilities::Eye eye) const = 0;
+
             virtual void updateGazeLocation(XrVector2f gaze, utilities::Eye eye) = 0;
             virtual void setViewProjectionCenters(XrVector2f left, XrVector2f right) = 0;
 
+            // The inner ring of the pattern for a view, or nothing when VRS is disabled.
+            virtual std::optional<FoveatedRegion> getFoveatedRegion(utilities::Eye eye) const = 0;
+
             virtual uint8_t getMaxRate() const = 0;
 
             virtual uint32_t getActualRenderWidth() const = 0;
+            // Evaluating the tile coverage walks all the tiles of the views: it is left out unless requested.
+            virtual VariableRateShaderStatistics getStatistics(bool withTileCoverage) = 0;
+
+            // Coarsen the shading rate outside of the inner ring by the number of steps.
+            virtual void setDynamicRateBias(int bias) = 0;
 
             virtual void startCapture() = 0;
             virtual void stopCapture() = 0;
+
+            // Destroy the masks that were not used in the last frame, even within the memory budget.
+            virtual void trim() = 0;
+        };
+
+        // A depth pre-pass stamping the hidden area mesh into the depth buffers of the application, so that early-Z
+        // rejects the pixels that are never visible through the lenses.
+        struct IHiddenAreaPrePass {
+            virtual ~IHiddenAreaPrePass() = default;
+
+            virtual void beginSession(XrSession session, XrSpace viewSpace) = 0;
+            virtual void endSession() = 0;
+
+            virtual void beginFrame(XrTime frameTime) = 0;
+
+            virtual void onClearDepth(std::shared_ptr<IContext> context,
+                                      std::shared_ptr<ITexture> depthBuffer,
+                                      int32_t slice,
+                                      float depth,
+                                      std::optional<utilities::Eye> eyeHint) = 0;
         };
 
     } // namespace graphics
@@ -819,10 +1540,19 @@ namespace toolkit {
             XrVector2f rightPoint{};
         };
 
+        enum class GazeMovement {
+            // The gaze has been stable long enough.
+            Fixation,
+            // The gaze is moving too fast for the projected gaze to be accurate.
+            Saccade,
+            // The saccade ended, but the fixation is not confirmed yet.
+            Settling,
+        };
+
         struct IEyeTracker {
             virtual ~IEyeTracker() = default;
 
-            virtual void beginSession(XrSession session) = 0;
+            virtual void beginSession(XrSession session, XrSpace viewSpace) = 0;
             virtual void endSession() = 0;
 
             virtual void beginFrame(XrTime frameTime) = 0;
@@ -831,6 +1561,7 @@ namespace toolkit {
 
             virtual XrActionSet getActionSet() const = 0;
             virtual bool getProjectedGaze(XrVector2f gaze[utilities::ViewCount]) const = 0;
+            virtual GazeMovement getGazeMovement() const = 0;
 
             virtual bool isProjectionDistanceSupported() const = 0;
 
@@ -851,7 +1582,27 @@ namespace toolkit {
             uint64_t overlayCpuTimeUs{0};
             uint64_t overlayGpuTimeUs{0};
             uint64_t handTrackingCpuTimeUs{0};
+            uint64_t handTrackingGpuTimeUs{0};
+            uint64_t numLocateSpaceCacheHits{0};
+            uint64_t numLocateSpaceCacheMisses{0};
+            uint64_t variableRateShadingGpuTimeUs{0};
+            int dynamicResolutionLevel{0};
             uint64_t predictionTimeUs{0};
+            int predictionDampen{100};
+            uint64_t poseAgeUs{0};
+            float poseErrorDeg{0.f};
+            graphics::GpuProfileScope gpuProfileScopes[graphics::MaxGpuProfileScopes];
+            uint32_t numGpuProfileScopes{0};
+
+            // The age of each step of the last frame at the display time predicted by the runtime: the application's
+            // view poses, the return from xrWaitFrame(), xrBeginFrame(), the first render target bind on an eye
+            // swapchain, the call to xrEndFrame(), and the submission to the runtime. 0 when not observed.
+            uint64_t inputLatencyUs{0};
+            uint64_t waitLatencyUs{0};
+            uint64_t beginLatencyUs{0};
+            uint64_t renderLatencyUs{0};
+            uint64_t endFrameLatencyUs{0};
+            uint64_t submitLatencyUs{0};
 
             float fps{0.0f};
             uint64_t vramUsedSize;
@@ -859,8 +1610,10 @@ namespace toolkit {
             float icd{0.0f};
             XrFovf fov[2]{{0}};
             uint32_t numBiasedSamplers{0};
+            uint32_t numBiasedSamplersCreated{0};
             uint32_t numRenderTargetsWithVRS{0};
             uint32_t actualRenderWidth{0};
+            graphics::VariableRateShaderStatistics variableRateShader;
 
             bool hasColorBuffer[utilities::ViewCount]{false, false};
             bool hasDepthBuffer[utilities::ViewCount]{false, false};
@@ -881,6 +1634,41 @@ namespace toolkit {
 
             virtual void setViewProjectionCenters(XrVector2f left, XrVector2f right) = 0;
             virtual bool isVisible() const = 0;
+
+            // Whether render() would produce a different image than the last time clearDirty() was called.
+            virtual bool isDirty() const = 0;
+            virtual void clearDirty() = 0;
+        };
+
+        // A publisher of the live statistics to external tools, through shared memory (see telemetry.cpp). Publishing
+        // is lock-free and never waits on the readers.
+        struct ITelemetryPublisher {
+            virtual ~ITelemetryPublisher() = default;
+
+            virtual void publishFrame(const utilities::FrameStatistics& frame,
+                                      const graphics::GpuProfileScope* gpuProfileScopes,
+                                      uint32_t numGpuProfileScopes) = 0;
+            virtual void publishStatistics(const MenuStatistics& stats) = 0;
+        };
+
+        // What a performance sweep may change in the current session, and how to describe it in the report.
+        struct PerformanceSweepInfo {
+            std::string applicationName;
+            std::string sessionDescription;
+            double displayPeriodUs;
+            bool sweepVariableRateShading;
+            bool sweepMipMapBias;
+        };
+
+        // A performance sweep steps through a grid of settings, measures each combination for a number of frames,
+        // then writes a report and applies the best combination for the target frame rate.
+        struct IPerformanceSweeper {
+            virtual ~IPerformanceSweeper() = default;
+
+            virtual void recordFrame(const utilities::FrameStatistics& frame,
+                                     const graphics::GpuProfileScope* gpuProfileScopes,
+                                     uint32_t numGpuProfileScopes) = 0;
+            virtual bool isDone() const = 0;
         };
 
     } // namespace menu
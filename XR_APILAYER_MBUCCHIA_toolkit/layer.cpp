@@ -37,15 +37,16 @@ namespace {
     using namespace xr::math;
     using namespace toolkit::math;
 
-    // The xrWaitFrame() loop might cause to have 2 frames in-flight, so we want to delay the GPU timer re-use by those
-    // 2 frames.
-    constexpr uint32_t GpuTimerLatency = 2;
-
     struct SwapchainImages {
         std::shared_ptr<graphics::ITexture> appTexture;
         std::shared_ptr<graphics::ITexture> runtimeTexture;
-        std::shared_ptr<graphics::IGpuTimer> upscalingTimers[utilities::ViewCount];
-        std::shared_ptr<graphics::IGpuTimer> postProcessingTimers[utilities::ViewCount];
+    };
+
+    // An image of the shorter ring handed to the application instead of one per runtime image (see
+    // SettingShadowSwapchainImages), and the GPU work that last read it.
+    struct ShadowImage {
+        std::shared_ptr<graphics::ITexture> texture;
+        uint64_t lastUseSerial{0};
     };
 
     struct SwapchainState {
@@ -53,20 +54,278 @@ namespace {
         uint32_t acquiredImageIndex{0};
         bool delayedRelease{false};
 
-        // Intermediate textures for processing.
-        std::shared_ptr<graphics::ITexture> nonVPRTInputTexture;
-        std::shared_ptr<graphics::ITexture> nonVPRTOutputTexture;
-        std::shared_ptr<graphics::ITexture> upscaledTexture;
+        // With shadow images, the runtime image is only acquired in xrEndFrame(), where it receives the processing of
+        // the shadow image released by the application.
+        std::vector<ShadowImage> shadowImages;
+        uint32_t nextShadowIndex{0};
+        std::optional<uint32_t> pendingShadowIndex;
+
+        // The image released by the application for the frame being ended. With frame pipelining, the application may
+        // acquire the image for the next frame before ending the current one.
+        uint32_t frameImageIndex{0};
 
         // Intermediate textures than can be used for state in the image processors.
-        std::vector<std::shared_ptr<graphics::ITexture>> upscalerTextures;
         std::vector<std::shared_ptr<graphics::ITexture>> postProcessorTextures;
 
+        // Textures holding the history of the temporal upscaler, which cannot be shared with the other swapchains.
+        std::vector<std::shared_ptr<graphics::ITexture>> upscalerHistoryTextures;
+
+        // Per-eye constant buffers that can be used by the image processors to avoid uploading every frame.
+        std::vector<std::shared_ptr<graphics::IShaderBuffer>> upscalerBuffers;
+        std::vector<std::shared_ptr<graphics::IShaderBuffer>> postProcessorBuffers;
+
         // Opaque blobs of memory that can be used for constant buffer bouncing in the image processors.
         std::array<uint8_t, 1024> upscalerBlob;
         std::array<uint8_t, 1024> postProcessorBlob;
 
         bool registeredWithFrameAnalyzer{false};
+
+        // Whether the swapchain was created for the eye rendered at a lower resolution (see SettingReducedEye).
+        bool isReducedEye{false};
+    };
+
+    // The timing of a frame, from xrWaitFrame() to xrEndFrame(). Engines pipelining their frames wait for the next
+    // frame before ending the current one, so there may be more than one frame in flight.
+    struct FrameContext {
+        uint64_t frameId{0};
+
+        // The display time predicted by the runtime, and the one returned to the application (after dampening).
+        XrTime runtimeDisplayTime{0};
+        XrTime displayTime{0};
+
+        // The time when the runtime's xrWaitFrame() returned, when the application last located its views for the
+        // frame, and when the frame was begun. 0 if unknown.
+        XrTime waitedTime{0};
+        XrTime inputTime{0};
+        XrTime begunTime{0};
+    };
+
+    // The views last located by the application, to measure how old they are by the time the frame is submitted.
+    struct AppViewsLocate {
+        std::chrono::steady_clock::time_point timestamp;
+        XrSpace space;
+        XrQuaternionf orientations[utilities::ViewCount];
+    };
+
+    // Chooses the prediction dampening from the latency actually observed. We cannot know when a frame is displayed, so
+    // we estimate it to be one display period after the frame is submitted with xrEndFrame(). Relative to the time the
+    // frame was waited, with P the runtime's prediction and L the estimated latency, the factor minimizing the squared
+    // error of the dampened prediction over a window of frames is sum(P * L) / sum(P * P). The value is smoothed across
+    // windows so it follows the changes of load without jumping around.
+    class PredictionDampeningTuner {
+      public:
+        void addSample(XrTime prediction, XrTime latency) {
+            if (prediction <= 0 || latency <= 0) {
+                return;
+            }
+
+            m_sumPredictionLatency += static_cast<double>(prediction) * latency;
+            m_sumPredictionSquared += static_cast<double>(prediction) * prediction;
+            if (++m_numSamples < WindowSize) {
+                return;
+            }
+
+            const float optimal =
+                std::clamp(static_cast<float>(100 * m_sumPredictionLatency / m_sumPredictionSquared), 0.f, 100.f);
+            m_smoothedValue += (optimal - m_smoothedValue) * Smoothing;
+            m_value = static_cast<int>(std::round(m_smoothedValue));
+
+            TraceLoggingWrite(g_traceProvider,
+                              "PredictionDampeningTuner",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLArg(optimal, "Optimal"),
+                              TLArg(m_value.load(), "Value"));
+
+            m_sumPredictionLatency = m_sumPredictionSquared = 0;
+            m_numSamples = 0;
+        }
+
+        // The dampening to apply, in percent of the runtime's prediction.
+        int getValue() const {
+            return m_value;
+        }
+
+        void reset() {
+            m_sumPredictionLatency = m_sumPredictionSquared = 0;
+            m_numSamples = 0;
+            m_smoothedValue = 100.f;
+            m_value = 100;
+        }
+
+      private:
+        static constexpr uint32_t WindowSize = 90;
+        static constexpr float Smoothing = 0.25f;
+
+        double m_sumPredictionLatency{0};
+        double m_sumPredictionSquared{0};
+        uint32_t m_numSamples{0};
+        float m_smoothedValue{100.f};
+
+        // Read from xrWaitFrame(), which may be called from a different thread than xrEndFrame().
+        std::atomic<int> m_value{100};
+    };
+
+    // In Turbo Mode, the runtime's xrWaitFrame() is called from a long-lived thread, so that the application can start
+    // its next frame right away. The pipeline holds at most one wait:
+    // - Idle: there is no wait in flight.
+    // - Waiting: the wait was kicked off at the end of a frame, and the thread is blocked in the runtime.
+    // - Completed: the runtime returned, and the result must be collected before submitting the next frame.
+    class AsyncFrameWaiter {
+        using clock = std::chrono::steady_clock;
+
+      public:
+        enum class State { Idle, Waiting, Completed };
+
+        AsyncFrameWaiter(std::function<XrResult(XrFrameState*)> waitFrame) : m_waitFrame(std::move(waitFrame)) {
+            m_thread = std::thread([&]() { waitThread(); });
+        }
+
+        ~AsyncFrameWaiter() {
+            {
+                std::unique_lock lock(m_mutex);
+                m_stop = true;
+            }
+            m_kickoff.notify_all();
+            m_thread.join();
+        }
+
+        // Start waiting for the next frame.
+        void kickoff() {
+            {
+                std::unique_lock lock(m_mutex);
+                assert(m_state == State::Idle);
+                m_kickoffTime = clock::now();
+                m_frameState.reset();
+                m_isPolled = false;
+                setState(State::Waiting);
+            }
+            m_kickoff.notify_one();
+        }
+
+        // Called when the application waits for a frame. We only block upon the second poll since the kickoff, which
+        // means that the application is running ahead of the runtime by more than one frame. Returns the frame timing
+        // if the runtime already returned.
+        std::optional<XrFrameState> poll() {
+            std::unique_lock lock(m_mutex);
+            if (m_isPolled) {
+                waitForCompletion(lock, std::nullopt);
+            }
+            m_isPolled = true;
+            return m_state == State::Completed ? m_frameState : std::nullopt;
+        }
+
+        // Block until the runtime returns. Returns false upon timeout.
+        bool wait(std::optional<std::chrono::milliseconds> timeout = std::nullopt) {
+            std::unique_lock lock(m_mutex);
+            return waitForCompletion(lock, timeout);
+        }
+
+        // Go back to Idle. Returns the frame timing if the runtime call succeeded.
+        std::optional<XrFrameState> collect() {
+            std::unique_lock lock(m_mutex);
+            assert(m_state == State::Completed);
+            setState(State::Idle);
+            return m_frameState;
+        }
+
+        bool isActive() const {
+            std::unique_lock lock(m_mutex);
+            return m_state != State::Idle;
+        }
+
+      private:
+        bool waitForCompletion(std::unique_lock<std::mutex>& lock, std::optional<std::chrono::milliseconds> timeout) {
+            if (m_state != State::Waiting) {
+                return true;
+            }
+
+            TraceLocalActivity(local);
+            TraceLoggingWriteStart(local, "AsyncWaitNow", TraceLoggingKeyword(TLK_Frame));
+            const auto isCompleted = [&]() { return m_state != State::Waiting; };
+            bool ready = true;
+            if (timeout) {
+                ready = m_completion.wait_for(lock, timeout.value(), isCompleted);
+            } else {
+                m_completion.wait(lock, isCompleted);
+            }
+            TraceLoggingWriteStop(
+                local,
+                "AsyncWaitNow",
+                TraceLoggingKeyword(TLK_Frame),
+                TLArg(ready, "Ready"),
+                TLArg(ready ? std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - m_completionTime)
+                                  .count()
+                            : 0,
+                      "WakeLatencyUs"));
+
+            return ready;
+        }
+
+        void setState(State state) {
+            TraceLoggingWrite(g_traceProvider,
+                              "AsyncWait_State",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLArg((int)m_state, "From"),
+                              TLArg((int)state, "To"));
+            m_state = state;
+        }
+
+        void waitThread() {
+            // Waking up promptly when the runtime returns is what matters for this thread.
+            utilities::RegisterThread(utilities::ThreadClass::Frame);
+
+            std::unique_lock lock(m_mutex);
+            while (true) {
+                m_kickoff.wait(lock, [&]() { return m_stop || m_state == State::Waiting; });
+                if (m_stop) {
+                    break;
+                }
+                lock.unlock();
+
+                TraceLocalActivity(local);
+                TraceLoggingWriteStart(
+                    local,
+                    "AsyncWaitFrame",
+                    TraceLoggingKeyword(TLK_Frame),
+                    TLArg(std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - m_kickoffTime).count(),
+                          "WakeLatencyUs"));
+
+                XrFrameState frameState{XR_TYPE_FRAME_STATE};
+                const XrResult result = m_waitFrame(&frameState);
+
+                TraceLoggingWriteStop(local,
+                                      "AsyncWaitFrame",
+                                      TraceLoggingKeyword(TLK_Frame),
+                                      TLArg(xr::ToCString(result), "Result"),
+                                      TLArg(frameState.predictedDisplayTime, "PredictedDisplayTime"),
+                                      TLArg(frameState.predictedDisplayPeriod, "PredictedDisplayPeriod"));
+
+                lock.lock();
+                if (XR_SUCCEEDED(result)) {
+                    m_frameState = frameState;
+                }
+                m_completionTime = clock::now();
+                setState(State::Completed);
+                m_completion.notify_all();
+            }
+            lock.unlock();
+
+            utilities::UnregisterThread();
+        }
+
+        const std::function<XrResult(XrFrameState*)> m_waitFrame;
+
+        std::thread m_thread;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_kickoff;
+        std::condition_variable m_completion;
+        bool m_stop{false};
+
+        State m_state{State::Idle};
+        bool m_isPolled{false};
+        std::optional<XrFrameState> m_frameState;
+        clock::time_point m_kickoffTime;
+        clock::time_point m_completionTime;
     };
 
     class OpenXrLayer : public toolkit::OpenXrApi {
@@ -74,7 +333,7 @@ namespace {
         OpenXrLayer() = default;
 
         void setOptionsDefaults() {
-            m_configManager->setDefault("key_menu_gen", 1);
+            m_configManager->setDefault(config::SettingKeyMenuGeneration, 1);
             m_configManager->setDefault(config::SettingFirstRun, 0);
             m_configManager->setDefault(config::SettingDeveloper, 0);
 
@@ -117,11 +376,13 @@ namespace {
             m_configManager->setDefault(config::SettingEyeProjectionDistance, 200); // 2m
             m_configManager->setDefault(config::SettingEyeDebug, 0);
 
+            // The settings of the passes shared with the benchmark.
+            config::SetProcessingDefaults(*m_configManager);
+
             // Upscaling feature.
             m_configManager->setEnumDefault(config::SettingScalingType, config::ScalingType::None);
             m_configManager->setDefault(config::SettingScaling, 100);
             m_configManager->setDefault(config::SettingAnamorphic, -100);
-            m_configManager->setDefault(config::SettingSharpness, 20);
             // We default mip-map biasing to Off with OpenComposite since it's causing issues with certain apps. Users
             // have the (Expert) option to turn it back on.
             m_configManager->setEnumDefault(config::SettingMipMapBias,
@@ -130,38 +391,12 @@ namespace {
 
             // Foveated rendering.
             m_configManager->setEnumDefault(config::SettingVRS, config::VariableShadingRateType::None);
-            m_configManager->setEnumDefault(config::SettingVRSQuality, config::VariableShadingRateQuality::Performance);
-            m_configManager->setEnumDefault(config::SettingVRSPattern, config::VariableShadingRatePattern::Wide);
-            m_configManager->setDefault(config::SettingVRSInner, 0); // 1x
-            m_configManager->setDefault(config::SettingVRSInnerRadius, 55);
-            m_configManager->setDefault(config::SettingVRSMiddle, 2); // 1/4x
-            m_configManager->setDefault(config::SettingVRSOuter, 4);  // 1/16x
-            m_configManager->setDefault(config::SettingVRSOuterRadius, 80);
-            m_configManager->setDefault(config::SettingVRSXOffset, 0);
-            m_configManager->setDefault(config::SettingVRSXScale, 125);
-            m_configManager->setDefault(config::SettingVRSYOffset, 0);
-            m_configManager->setDefault(config::SettingVRSPreferHorizontal, 0);
-            m_configManager->setDefault(config::SettingVRSLeftRightBias, 0);
             // Fix issue in iRacing: https://forums.iracing.com/discussion/comment/310749
             m_configManager->setDefault(config::SettingVRSScaleFilter,
                                         m_applicationName != "iRacingSim64DX11" ? 80 : 90);
-            m_configManager->setDefault(config::SettingVRSCullHAM, 0);
 
             // Appearance.
             m_configManager->setDefault(config::SettingPostProcess, 0);
-            m_configManager->setDefault(config::SettingPostSunGlasses, 0);
-            m_configManager->setDefault(config::SettingPostContrast, 500);
-            m_configManager->setDefault(config::SettingPostBrightness, 500);
-            m_configManager->setDefault(config::SettingPostExposure, 500);
-            m_configManager->setDefault(config::SettingPostSaturation, 500);
-            m_configManager->setDefault(config::SettingPostColorGainR, 500);
-            m_configManager->setDefault(config::SettingPostColorGainG, 500);
-            m_configManager->setDefault(config::SettingPostColorGainB, 500);
-            m_configManager->setDefault(config::SettingPostVibrance, 0);
-            m_configManager->setDefault(config::SettingPostHighlights, 1000);
-            m_configManager->setDefault(config::SettingPostShadows, 0);
-            m_configManager->setDefault(config::SettingPostChromaticCorrectionR, 100090);
-            m_configManager->setDefault(config::SettingPostChromaticCorrectionB, 99880);
 
             // TODO: Appearance (User)
 #if 0
@@ -187,9 +422,9 @@ namespace {
             m_configManager->setDefault(config::SettingFOVRightLeft, 100);
             m_configManager->setDefault(config::SettingFOVRightRight, 100);
             m_configManager->setDefault(config::SettingZoom, 10);
-            m_configManager->setDefault(config::SettingDisableHAM, 0);
             m_configManager->setEnumDefault(config::SettingBlindEye, config::BlindEye::None);
             m_configManager->setDefault(config::SettingPredictionDampen, 100);
+            m_configManager->setDefault(config::SettingPredictionDampenAuto, 0);
             m_configManager->setDefault(config::SettingResolutionOverride, 0);
             m_configManager->setEnumDefault(config::SettingMotionReprojection, config::MotionReprojection::Default);
             m_configManager->setEnumDefault(config::SettingMotionReprojectionRate, config::MotionReprojectionRate::Off);
@@ -208,13 +443,39 @@ namespace {
                                                                                                                   : 0);
             // We disable the frame analyzer when using OpenComposite, because the app does not see the OpenXR
             // textures anyways.
-            m_configManager->setDefault("disable_frame_analyzer",
+            m_configManager->setDefault(config::SettingDisableFrameAnalyzer,
                                         m_isOpenComposite || m_applicationName == "DCS World");
-            m_configManager->setDefault("canting", 0);
-            m_configManager->setDefault("vrs_capture", 0);
-            m_configManager->setDefault("force_vprt_path", 0);
-            m_configManager->setDefault("droolon_port", 5347);
-            m_configManager->setDefault("allow_ca_correction", 0);
+            m_configManager->setDefault(config::SettingCanting, 0);
+            m_configManager->setDefault(config::SettingVRSCapture, 0);
+            m_configManager->setDefault(config::SettingHiddenAreaPrePass, 0);
+            m_configManager->setDefault(config::SettingForceVPRTPath, 0);
+            m_configManager->setDefault(config::SettingShaderTuning, 1);
+            m_configManager->setDefault(config::SettingFoveatedUpscaling, 0);
+            m_configManager->setDefault(config::SettingRecordStatsPerFrame, 0);
+            m_configManager->setDefault(config::SettingDynamicResolution, 0);
+            m_configManager->setDefault(config::SettingDynamicResolutionMin, 0);
+            m_configManager->setDefault(config::SettingDynamicResolutionMax, 2);
+            m_configManager->setDefault(config::SettingPipelineCache, 1);
+            m_configManager->setDefault(config::SettingPipelineCachePreload, 1);
+            m_configManager->setDefault(config::SettingD3D11ContextState, 0);
+            m_configManager->setDefault(config::SettingDroolonPort, 5347);
+            m_configManager->setDefault(config::SettingAllowCACorrection, 0);
+            m_configManager->setDefault(config::SettingHandTrackingRate, 0);
+            m_configManager->setDefault(config::SettingLateLatch, 0);
+            m_configManager->setDefault(config::SettingThreadScheduling, 0);
+            m_configManager->setDefault(config::SettingLocateSpaceCache, 0);
+            m_configManager->setEnumDefault(config::SettingReducedEye, config::BlindEye::None);
+            m_configManager->setDefault(config::SettingReducedEyeScaling, 80);
+            m_configManager->setDefault(config::SettingTelemetry, 0);
+            m_configManager->setDefault(config::SettingShadowSwapchainImages, 0);
+            m_configManager->setDefault(config::SettingSRGBAliasing, 1);
+            m_configManager->setDefault(config::SettingBenchmarkSweep, 0);
+            m_configManager->setDefault(config::SettingBenchmarkSweepFrames, 300);
+            m_configManager->setDefault(config::SettingBenchmarkSweepTarget, 0);
+            // Do not resume a sweep that was interrupted by the application exiting.
+            if (m_configManager->getValue(config::SettingBenchmarkSweep)) {
+                m_configManager->setValue(config::SettingBenchmarkSweep, 0, true);
+            }
 
             // Workaround: the first versions of the toolkit used a different representation for the world scale.
             // Migrate the value upon first run.
@@ -307,6 +568,9 @@ namespace {
             }
             m_keyScreenshot = m_configManager->getValue(config::SettingScreenshotKey);
 
+            // The function pointers are handed out after this call, therefore this option cannot change later.
+            m_useSpaceLocationsCache = m_configManager->getValue(config::SettingLocateSpaceCache);
+
             // We must initialize hand and eye tracking early on, because the application can start creating actions etc
             // before creating the session.
             if (m_configManager->getEnumValue<config::HandTrackingEnabled>(config::SettingHandTrackingEnabled) !=
@@ -359,7 +623,7 @@ namespace {
                     CHECK_XRCMD(OpenXrApi::xrGetSystemProperties(GetXrInstance(), systemId, &systemProperties));
                     if (std::string(systemProperties.systemName).find("aapvr") != std::string::npos) {
                         aSeeVRInitParam param;
-                        param.ports[0] = m_configManager->getValue("droolon_port");
+                        param.ports[0] = m_configManager->getValue(config::SettingDroolonPort);
                         Log("--> aSeeVR_connect_server(%d)\n", param.ports[0]);
                         const auto code = aSeeVR_connect_server(&param);
                         m_hasPimaxEyeTracker = code == ASEEVR_RETURN_CODE::success;
@@ -410,6 +674,23 @@ namespace {
             utilities::RestoreTimerPrecision();
         }
 
+        // The function pointers are handed out to the loader after xrCreateInstance(), once we know which features
+        // are used. The input functions are only needed for hand and eye tracking, otherwise they are not intercepted.
+        bool IsOverrideNeeded(const std::string& apiName) const override {
+            if (apiName == "xrSyncActions") {
+                return m_handTracker || m_eyeTracker || m_useSpaceLocationsCache;
+            }
+            if (apiName == "xrLocateSpace") {
+                return m_handTracker || m_useSpaceLocationsCache;
+            }
+            if (apiName == "xrGetActionStateBoolean" ||
+                apiName == "xrGetActionStateFloat" || apiName == "xrGetActionStatePose" ||
+                apiName == "xrApplyHapticFeedback" || apiName == "xrStopHapticFeedback") {
+                return !!m_handTracker;
+            }
+            return true;
+        }
+
         XrResult xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId) override {
             if (getInfo->type != XR_TYPE_SYSTEM_GET_INFO) {
                 return XR_ERROR_VALIDATION_FAILURE;
@@ -593,6 +874,12 @@ namespace {
                 const auto settingAnamophic = m_vrSession != XR_NULL_HANDLE
                                                   ? m_settingAnamorphic
                                                   : m_configManager->peekValue(config::SettingAnamorphic);
+                const auto reducedEye =
+                    m_vrSession != XR_NULL_HANDLE ? m_reducedEye
+                                                  : getReducedEyeSetting(upscaleMode, settingScaling, settingAnamophic);
+                const auto settingReducedEyeScaling =
+                    m_vrSession != XR_NULL_HANDLE ? m_settingReducedEyeScaling
+                                                  : m_configManager->peekValue(config::SettingReducedEyeScaling);
 
                 uint32_t inputWidth = m_displayWidth;
                 uint32_t inputHeight = m_displayHeight;
@@ -600,7 +887,8 @@ namespace {
                 switch (upscaleMode) {
                 case config::ScalingType::FSR:
                 case config::ScalingType::NIS:
-                case config::ScalingType::CAS: {
+                case config::ScalingType::CAS:
+                case config::ScalingType::Temporal: {
                     std::tie(inputWidth, inputHeight) = config::GetScaledDimensions(
                         settingScaling, settingAnamophic, m_displayWidth, m_displayHeight, 2);
                 } break;
@@ -618,6 +906,12 @@ namespace {
                 for (uint32_t i = 0; i < *viewCountOutput; i++) {
                     views[i].recommendedImageRectWidth = inputWidth;
                     views[i].recommendedImageRectHeight = inputHeight;
+
+                    // The non-dominant eye is rendered at a lower resolution, and upscaled along with the other eye.
+                    if (reducedEye && i == (uint32_t)reducedEye.value()) {
+                        std::tie(views[i].recommendedImageRectWidth, views[i].recommendedImageRectHeight) =
+                            getReducedEyeDimensions(inputWidth, inputHeight, settingReducedEyeScaling);
+                    }
                 }
 
                 static bool atLeastOnce = false;
@@ -639,6 +933,7 @@ namespace {
                     g_traceProvider,
                     "xrEnumerateViewConfigurationViews",
                     TLArg(fmt::format("{}x{}", inputWidth, inputHeight).c_str(), "AppResolution"),
+                    TLArg(reducedEye ? settingReducedEyeScaling : 100, "ReducedEyeScaling"),
                     TLArg(fmt::format("{}x{}", m_displayWidth, m_displayHeight).c_str(), "SystemResolution"));
             }
 
@@ -686,10 +981,8 @@ namespace {
 
                         const XrGraphicsBindingD3D12KHR* d3dBindings =
                             reinterpret_cast<const XrGraphicsBindingD3D12KHR*>(entry);
-                        // Workaround: On Varjo, we must use intermediate textures with D3D11on12.
-                        const bool enableVarjoQuirk = m_runtimeName.find("Varjo") != std::string::npos;
-                        m_graphicsDevice = graphics::WrapD3D12Device(
-                            d3dBindings->device, d3dBindings->queue, m_configManager, enableVarjoQuirk);
+                        m_graphicsDevice =
+                            graphics::WrapD3D12Device(d3dBindings->device, d3dBindings->queue, m_configManager);
                         break;
                     }
 
@@ -702,10 +995,18 @@ namespace {
                     m_upscaleMode = m_configManager->getEnumValue<config::ScalingType>(config::SettingScalingType);
                     if (m_upscaleMode == config::ScalingType::NIS || 
                         m_upscaleMode == config::ScalingType::FSR ||
-                        m_upscaleMode == config::ScalingType::CAS
+                        m_upscaleMode == config::ScalingType::CAS ||
+                        m_upscaleMode == config::ScalingType::Temporal
                     ) {
                         m_settingScaling = m_configManager->peekValue(config::SettingScaling);
                         m_settingAnamorphic = m_configManager->peekValue(config::SettingAnamorphic);
+                        m_reducedEye = getReducedEyeSetting(m_upscaleMode, m_settingScaling, m_settingAnamorphic);
+                        m_settingReducedEyeScaling = m_configManager->peekValue(config::SettingReducedEyeScaling);
+                        if (m_reducedEye) {
+                            Log("Rendering the %s eye at %d%% of the resolution\n",
+                                m_reducedEye.value() == utilities::Eye::Left ? "left" : "right",
+                                m_settingReducedEyeScaling);
+                        }
                     }
 
                     switch (m_upscaleMode) {
@@ -724,12 +1025,18 @@ namespace {
                             m_configManager, m_graphicsDevice, m_settingScaling, m_settingAnamorphic);
                         break;
 
+                    case config::ScalingType::Temporal:
+                        m_upscaler = graphics::CreateTemporalUpscaler(
+                            m_configManager, m_graphicsDevice, m_settingScaling, m_settingAnamorphic);
+                        break;
+
                     case config::ScalingType::None:
                         break;
 
                     default:
                         Log("Unknown upscaling type, falling back to no upscaling\n");
                         m_upscaleMode = config::ScalingType::None;
+                        m_reducedEye.reset();
                         break;
                     }
 
@@ -737,7 +1044,8 @@ namespace {
                     uint32_t renderHeight = m_displayHeight;
                     if (m_upscaleMode == config::ScalingType::NIS || 
                         m_upscaleMode == config::ScalingType::FSR ||
-                        m_upscaleMode == config::ScalingType::CAS
+                        m_upscaleMode == config::ScalingType::CAS ||
+                        m_upscaleMode == config::ScalingType::Temporal
                     ) {
                         std::tie(renderWidth, renderHeight) = config::GetScaledDimensions(
                             m_settingScaling, m_settingAnamorphic, m_displayWidth, m_displayHeight, 2);
@@ -748,10 +1056,17 @@ namespace {
                         Log("MipMap biasing for upscaling is: %.3f\n", m_mipMapBiasForUpscaling);
                     }
 
-                    m_postProcessor = graphics::CreateImageProcessor(m_configManager, m_graphicsDevice);
+                    m_postProcessor = graphics::CreateImageProcessor(m_configManager, m_graphicsDevice, m_systemName);
+                    m_texturePool = graphics::CreateTexturePool(m_graphicsDevice);
+                    m_frameScheduler = graphics::CreateFrameScheduler(m_graphicsDevice);
+                    m_videoMemoryBudget = utilities::CreateVideoMemoryBudget(m_graphicsDevice->getAdapter());
+                    m_isFusedPostProcess = m_upscaler && m_upscaler->isFusedPostProcessSupported();
+                    if (m_isFusedPostProcess) {
+                        Log("Using fused upscaling and post-processing\n");
+                    }
 
                     if (m_graphicsDevice->isEventsSupported()) {
-                        if (!m_configManager->getValue("disable_frame_analyzer")) {
+                        if (!m_configManager->getValue(config::SettingDisableFrameAnalyzer)) {
                             graphics::FrameAnalyzerHeuristic heuristic = graphics::FrameAnalyzerHeuristic::Unknown;
 
                             // TODO: Override heuristic per-app if needed.
@@ -772,6 +1087,34 @@ namespace {
                                                                !m_isOpenComposite && m_hasVisibilityMaskKHR,
                                                                m_isUnity);
 
+                        if (m_variableRateShader) {
+                            // The masks are drawn for the next frame, with the gaze predicted in xrBeginFrame() at
+                            // the start of the composition, or otherwise with the content hints of the composition.
+                            m_frameScheduler->registerPass("EyeTrackedShadingRateMasks", {}, [this]() {
+                                m_performanceCounters.gpuTimers->start(graphics::GpuPass::VariableRateShading);
+                                m_variableRateShader->recordMasks(true);
+                                m_performanceCounters.gpuTimers->stop(graphics::GpuPass::VariableRateShading);
+                            });
+                            m_frameScheduler->registerPass(
+                                "ShadingRateMasks", {graphics::IFrameScheduler::CompositionPass}, [this]() {
+                                    m_performanceCounters.gpuTimers->start(graphics::GpuPass::VariableRateShading);
+                                    m_variableRateShader->recordMasks(false);
+                                    m_performanceCounters.gpuTimers->stop(graphics::GpuPass::VariableRateShading);
+                                });
+                        }
+
+                        if (m_variableRateShader && m_configManager->getValue(config::SettingDynamicResolution)) {
+                            m_dynamicResolution = graphics::CreateDynamicResolutionController(m_configManager);
+                        }
+
+                        // The pre-pass draws into the application's depth buffers, which is only possible when the
+                        // application renders on the immediate context.
+                        if (m_configManager->getValue(config::SettingHiddenAreaPrePass) && !m_isOpenComposite &&
+                            m_hasVisibilityMaskKHR && m_graphicsDevice->getApi() == graphics::Api::D3D11) {
+                            m_hiddenAreaPrePass =
+                                graphics::CreateHiddenAreaPrePass(*this, m_graphicsDevice, renderWidth, renderHeight);
+                        }
+
                         // Register intercepted events.
                         m_graphicsDevice->registerSetRenderTargetEvent(
                             [&](std::shared_ptr<graphics::IContext> context,
@@ -822,6 +1165,31 @@ namespace {
                                 m_frameAnalyzer->onCopyTexture(source, destination, sourceSlice, destinationSlice);
                             }
                         });
+                        if (m_hiddenAreaPrePass) {
+                            m_graphicsDevice->registerClearDepthEvent(
+                                [&](std::shared_ptr<graphics::IContext> context,
+                                    std::shared_ptr<graphics::ITexture> depthBuffer,
+                                    int32_t slice,
+                                    float depth) {
+                                    if (!m_isInFrame) {
+                                        return;
+                                    }
+
+                                    m_hiddenAreaPrePass->onClearDepth(
+                                        context,
+                                        depthBuffer,
+                                        slice,
+                                        depth,
+                                        m_frameAnalyzer ? m_frameAnalyzer->getEyeHint() : std::nullopt);
+                                });
+                        }
+
+                        // Neither the frame analyzer nor VRS have any interest in small textures or texture arrays.
+                        graphics::EventsFilter eventsFilter;
+                        eventsFilter.minWidth = renderWidth / 8;
+                        eventsFilter.minHeight = renderHeight / 8;
+                        eventsFilter.maxArraySize = m_variableRateShader || m_hiddenAreaPrePass ? 2 : 1;
+                        m_graphicsDevice->setEventsFilter(eventsFilter);
                     }
 
                     m_performanceCounters.appCpuTimer = utilities::CreateCpuTimer();
@@ -830,11 +1198,11 @@ namespace {
                     m_performanceCounters.endFrameCpuTimer = utilities::CreateCpuTimer();
                     m_performanceCounters.overlayCpuTimer = utilities::CreateCpuTimer();
                     m_performanceCounters.handTrackingTimer = utilities::CreateCpuTimer();
+                    m_frameLimiter = utilities::CreateFrameLimiter();
 
-                    for (unsigned int i = 0; i <= GpuTimerLatency; i++) {
-                        m_performanceCounters.appGpuTimer[i] = m_graphicsDevice->createTimer();
-                        m_performanceCounters.overlayGpuTimer[i] = m_graphicsDevice->createTimer();
-                    }
+                    m_performanceCounters.gpuTimers = graphics::CreateGpuTimerPool(m_graphicsDevice);
+                    m_performanceCounters.gpuProfiler = graphics::CreateGpuProfiler(m_graphicsDevice);
+                    m_screenshotCapture = graphics::CreateScreenshotCapture(m_graphicsDevice);
 
                     m_performanceCounters.lastWindowStart = std::chrono::steady_clock::now();
 
@@ -865,7 +1233,8 @@ namespace {
                         // Our HAM override does not seem to work with OpenComposite.
                         menuInfo.isVisibilityMaskOverrideSupported = !m_isOpenComposite && m_hasVisibilityMaskKHR;
                         menuInfo.isCACorrectionNeed = m_configManager->isDeveloper() || m_systemName == "AERO" ||
-                                                      m_configManager->getValue("allow_ca_correction");
+                                                      m_configManager->getValue(config::SettingAllowCACorrection);
+                        menuInfo.isFSRHalfPrecision = graphics::IsDeviceSupportingFP16(m_graphicsDevice);
                         menuInfo.runtimeName = m_runtimeName;
 
                         m_menuHandler = menu::CreateMenuHandler(m_configManager, m_graphicsDevice, menuInfo);
@@ -884,7 +1253,7 @@ namespace {
                         m_handTracker->beginSession(*session, m_graphicsDevice);
                     }
                     if (m_eyeTracker) {
-                        m_eyeTracker->beginSession(*session);
+                        m_eyeTracker->beginSession(*session, m_viewSpace);
                     }
 
                     // Make sure we perform calibration again. We pass these values to the menu and FFR, so in the case
@@ -921,11 +1290,22 @@ namespace {
             if (XR_SUCCEEDED(result) && isVrSession(session)) {
                 m_configManager->setActiveSession(m_applicationName);
 
-                // Bump up timer precision for this process.
-                utilities::EnableHighPrecisionTimer();
+                // Bump up timer precision for this process, unless the frame limiter can do without it.
+                if (!m_frameLimiter || !m_frameLimiter->isHighResolution()) {
+                    utilities::EnableHighPrecisionTimer();
+                }
+                if (m_frameLimiter) {
+                    m_frameLimiter->reset();
+                }
+                m_predictionDampeningTuner.reset();
+
+                utilities::EnableThreadScheduling(m_configManager->getValue(config::SettingThreadScheduling));
 
                 if (m_variableRateShader) {
-                    m_variableRateShader->beginSession(session);
+                    m_variableRateShader->beginSession(session, m_viewSpace);
+                }
+                if (m_hiddenAreaPrePass) {
+                    m_hiddenAreaPrePass->beginSession(session, m_viewSpace);
                 }
             }
 
@@ -940,6 +1320,9 @@ namespace {
                 if (m_variableRateShader) {
                     m_variableRateShader->endSession();
                 }
+                if (m_hiddenAreaPrePass) {
+                    m_hiddenAreaPrePass->endSession();
+                }
 
                 utilities::RestoreTimerPrecision();
 
@@ -960,9 +1343,13 @@ namespace {
 
                 // Wait for any pending operation to complete.
                 if (m_graphicsDevice) {
-                    if (m_asyncWaitPromise.valid()) {
-                        m_asyncWaitPromise.wait_for(5s);
-                        m_asyncWaitPromise = {};
+                    {
+                        std::unique_lock lock(m_frameLock);
+                        if (m_asyncWaiter) {
+                            m_asyncWaiter->wait(5s);
+                            m_asyncWaiter.reset();
+                        }
+                        m_isAsyncWaitActive = false;
                     }
 
                     m_graphicsDevice->blockCallbacks();
@@ -974,6 +1361,8 @@ namespace {
                     xrDestroySpace(m_viewSpace);
                     m_viewSpace = XR_NULL_HANDLE;
                 }
+                m_viewsCache = {};
+                invalidateVisibilityMasksCache();
                 if (m_handTracker) {
                     m_handTracker->endSession();
                 }
@@ -983,6 +1372,7 @@ namespace {
                 if (m_menuSwapchain != XR_NULL_HANDLE) {
                     xrDestroySwapchain(m_menuSwapchain);
                     m_menuSwapchain = XR_NULL_HANDLE;
+                    m_menuSwapchainHasContent = false;
                 }
             }
 
@@ -991,18 +1381,34 @@ namespace {
             if (XR_SUCCEEDED(result) && isVrSession(session)) {
                 // Cleanup our resources.
                 m_upscaler.reset();
+                m_reducedEye.reset();
                 m_postProcessor.reset();
+                m_texturePool.reset();
+                m_frameScheduler.reset();
+                m_videoMemoryBudget.reset();
+                m_isVideoMemoryTrimmed = false;
+                m_upscalerTextures.clear();
                 m_frameAnalyzer.reset();
                 m_variableRateShader.reset();
-                for (unsigned int i = 0; i <= GpuTimerLatency; i++) {
-                    m_performanceCounters.appGpuTimer[i].reset();
-                    m_performanceCounters.overlayGpuTimer[i].reset();
+                if (m_hiddenAreaPrePass) {
+                    m_graphicsDevice->registerClearDepthEvent(nullptr);
+                    m_hiddenAreaPrePass.reset();
+                }
+                m_interceptedCallsSubscriptions = {};
+                m_dynamicResolution.reset();
+                if (m_performanceSweeper) {
+                    m_performanceSweeper.reset();
+                    m_configManager->setValue(config::SettingBenchmarkSweep, 0, true);
                 }
+                m_performanceCounters.gpuTimers.reset();
+                m_performanceCounters.gpuProfiler.reset();
+                m_screenshotCapture.reset();
                 m_performanceCounters.appCpuTimer.reset();
                 m_performanceCounters.renderCpuTimer.reset();
                 m_performanceCounters.waitCpuTimer.reset();
                 m_performanceCounters.endFrameCpuTimer.reset();
                 m_performanceCounters.overlayCpuTimer.reset();
+                m_frameLimiter.reset();
                 m_swapchains.clear();
                 m_menuSwapchainImages.clear();
                 m_menuHandler.reset();
@@ -1069,32 +1475,76 @@ namespace {
                 createInfo->usageFlags);
 
             XrSwapchainCreateInfo chainCreateInfo = *createInfo;
+            bool isReducedEye = false;
             if (!isDepth) {
                 // Modify the swapchain to handle our processing chain (eg: change resolution and/or usage.
 
                 if (m_upscaleMode == config::ScalingType::NIS || 
                     m_upscaleMode == config::ScalingType::FSR ||
-                    m_upscaleMode == config::ScalingType::CAS
+                    m_upscaleMode == config::ScalingType::CAS ||
+                    m_upscaleMode == config::ScalingType::Temporal
                 ) {
                     float horizontalScaleFactor;
                     float verticalScaleFactor;
                     std::tie(horizontalScaleFactor, verticalScaleFactor) =
                         config::GetScalingFactors(m_settingScaling, m_settingAnamorphic);
 
+                    // A swapchain created with the dimensions of the reduced eye is upscaled to the full display
+                    // resolution. Texture arrays and shared swapchains use the larger dimensions of the other eye.
+                    if (m_reducedEye && createInfo->arraySize == 1) {
+                        const auto [inputWidth, inputHeight] = config::GetScaledDimensions(
+                            m_settingScaling, m_settingAnamorphic, m_displayWidth, m_displayHeight, 2);
+                        const auto [reducedWidth, reducedHeight] =
+                            getReducedEyeDimensions(inputWidth, inputHeight, m_settingReducedEyeScaling);
+                        if (createInfo->width == reducedWidth && createInfo->height == reducedHeight &&
+                            (reducedWidth != inputWidth || reducedHeight != inputHeight)) {
+                            horizontalScaleFactor *= (float)inputWidth / reducedWidth;
+                            verticalScaleFactor *= (float)inputHeight / reducedHeight;
+                            isReducedEye = true;
+                        }
+                    }
+
                     chainCreateInfo.width = roundUp((uint32_t)std::ceil(createInfo->width * horizontalScaleFactor), 2);
                     chainCreateInfo.height = roundUp((uint32_t)std::ceil(createInfo->height * verticalScaleFactor), 2);
                 }
 
                 // The post processor will draw a full-screen quad onto the final swapchain.
                 chainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+
+                // In fused mode, or when the post-processing does not change the image, the upscaler will write
+                // directly to the final swapchain. sRGB formats can only be written through a UNORM view of a
+                // typeless texture (see getUnormAliases()).
+                if (m_upscaler && (!m_graphicsDevice->isTextureFormatSRGB(createInfo->format) ||
+                                   m_configManager->getValue(config::SettingSRGBAliasing))) {
+                    chainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                }
+
+                // Without upscaling, the application renders directly into the final swapchain (see below), which
+                // must then also be sampled for the analysis and the post-processing.
+                if (!m_upscaler) {
+                    chainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+                }
+            } else if (m_upscaleMode == config::ScalingType::Temporal ||
+                       (m_variableRateShader && m_configManager->getValue(config::SettingVRSDepthAdaptive))) {
+                // The temporal upscaler reprojects its history with the depth buffer, and the depth-adaptive VRS
+                // measures the distance of each tile.
+                chainCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
             }
 
-            const XrResult result = OpenXrApi::xrCreateSwapchain(session, &chainCreateInfo, swapchain);
+            XrResult result = OpenXrApi::xrCreateSwapchain(session, &chainCreateInfo, swapchain);
+            if (XR_FAILED(result) && m_graphicsDevice->isTextureFormatSRGB(createInfo->format) &&
+                (chainCreateInfo.usageFlags & ~createInfo->usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT)) {
+                // Not all runtimes accept the UAV usage with sRGB formats.
+                Log("Runtime rejected the UAV usage for an sRGB swapchain, retrying without it\n");
+                chainCreateInfo.usageFlags &= ~XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                result = OpenXrApi::xrCreateSwapchain(session, &chainCreateInfo, swapchain);
+            }
             if (XR_SUCCEEDED(result)) {
                 uint32_t imageCount;
                 CHECK_XRCMD(OpenXrApi::xrEnumerateSwapchainImages(*swapchain, 0, &imageCount, nullptr));
 
                 SwapchainState swapchainState;
+                swapchainState.isReducedEye = isReducedEye;
                 int64_t overrideFormat = 0;
                 if (m_graphicsDevice->getApi() == graphics::Api::D3D11) {
                     std::vector<XrSwapchainImageD3D11KHR> d3dImages(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR});
@@ -1186,10 +1636,29 @@ namespace {
                     throw std::runtime_error("Unsupported graphics runtime");
                 }
 
+                // The application renders at a lower resolution than the runtime images, which can therefore be
+                // fed from a shorter ring of images.
+                const int settingShadowImages = m_configManager->getValue(config::SettingShadowSwapchainImages);
+                const uint32_t shadowImageCount = settingShadowImages ? std::max(settingShadowImages, 2) : 0;
+                if (!isDepth && m_upscaler && shadowImageCount && shadowImageCount < imageCount) {
+                    XrSwapchainCreateInfo inputCreateInfo = *createInfo;
+                    inputCreateInfo.usageFlags |= XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+                    for (uint32_t i = 0; i < shadowImageCount; i++) {
+                        ShadowImage image;
+                        image.texture = m_graphicsDevice->createTexture(
+                            inputCreateInfo, fmt::format("App shadow swapchain {} TEX2D", i), overrideFormat);
+                        swapchainState.shadowImages.push_back(std::move(image));
+                    }
+                    Log("Using %u shadow images for %u runtime images\n", shadowImageCount, imageCount);
+                }
+
                 for (uint32_t i = 0; i < imageCount; i++) {
                     SwapchainImages& images = swapchainState.images[i];
 
-                    if (!isDepth) {
+                    if (!swapchainState.shadowImages.empty()) {
+                        // Bound to a shadow image when the runtime image is acquired in xrEndFrame().
+                        images.appTexture = swapchainState.shadowImages[0].texture;
+                    } else if (!isDepth && m_upscaler) {
                         // Create an app texture with the exact specification requested (lower resolution in case of
                         // upscaling).
                         XrSwapchainCreateInfo inputCreateInfo = *createInfo;
@@ -1199,12 +1668,10 @@ namespace {
 
                         images.appTexture = m_graphicsDevice->createTexture(
                             inputCreateInfo, fmt::format("App swapchain {} TEX2D", i), overrideFormat);
-
-                        for (uint32_t i = 0; i < utilities::ViewCount; i++) {
-                            images.upscalingTimers[i] = m_graphicsDevice->createTimer();
-                            images.postProcessingTimers[i] = m_graphicsDevice->createTimer();
-                        }
                     } else {
+                        // Without upscaling, hand the runtime texture straight to the application. The
+                        // post-processing is skipped when it does not change the image, and it otherwise reads from a
+                        // copy.
                         images.appTexture = images.runtimeTexture;
                     }
                 }
@@ -1224,18 +1691,22 @@ namespace {
             {
                 std::unique_lock lock(m_frameLock);
 
-                if (m_asyncWaitPromise.valid()) {
-                    TraceLocalActivity(local);
-
-                    TraceLoggingWriteStart(local, "AsyncWaitNow");
-                    m_asyncWaitPromise.wait();
-                    TraceLoggingWriteStop(local, "AsyncWaitNow");
+                if (m_asyncWaiter) {
+                    m_asyncWaiter->wait();
                 }
             }
 
             const XrResult result = OpenXrApi::xrDestroySwapchain(swapchain);
             if (XR_SUCCEEDED(result)) {
-                m_swapchains.erase(swapchain);
+                auto it = m_swapchains.find(swapchain);
+                if (it != m_swapchains.end()) {
+                    // The textures of the swapchain may still be in use by the GPU, release them once the frames
+                    // that use them have completed.
+                    if (m_graphicsDevice) {
+                        m_graphicsDevice->releaseDeferred(std::make_shared<SwapchainState>(std::move(it->second)));
+                    }
+                    m_swapchains.erase(it);
+                }
             }
 
             return result;
@@ -1389,6 +1860,15 @@ namespace {
             if (XR_SUCCEEDED(result) && m_handTracker) {
                 m_handTracker->unregisterActionSpace(space);
             }
+            if (XR_SUCCEEDED(result)) {
+                // The handle might be reused by the runtime.
+                for (auto& entry : m_viewsCache) {
+                    if (entry.space == space) {
+                        entry = {};
+                    }
+                }
+                invalidateSpaceLocationsCache();
+            }
 
             return result;
         }
@@ -1402,6 +1882,32 @@ namespace {
                               TLPArg(swapchain, "Swapchain"),
                               TLArg(imageCapacityInput, "ImageCapacityInput"));
 
+            // The application only sees the shadow images.
+            auto shadowSwapchainIt = m_swapchains.find(swapchain);
+            if (shadowSwapchainIt != m_swapchains.end() && !shadowSwapchainIt->second.shadowImages.empty()) {
+                const auto& shadowImages = shadowSwapchainIt->second.shadowImages;
+                *imageCountOutput = (uint32_t)shadowImages.size();
+                if (imageCapacityInput && imageCapacityInput < *imageCountOutput) {
+                    return XR_ERROR_SIZE_INSUFFICIENT;
+                }
+                if (imageCapacityInput) {
+                    for (uint32_t i = 0; i < *imageCountOutput; i++) {
+                        if (m_graphicsDevice->getApi() == graphics::Api::D3D11) {
+                            reinterpret_cast<XrSwapchainImageD3D11KHR*>(images)[i].texture =
+                                shadowImages[i].texture->getAs<graphics::D3D11>();
+                        } else {
+                            reinterpret_cast<XrSwapchainImageD3D12KHR*>(images)[i].texture =
+                                shadowImages[i].texture->getAs<graphics::D3D12>();
+                        }
+                    }
+                }
+
+                TraceLoggingWrite(
+                    g_traceProvider, "xrEnumerateSwapchainImages", TLArg(*imageCountOutput, "ImageCountOutput"));
+
+                return XR_SUCCESS;
+            }
+
             const XrResult result =
                 OpenXrApi::xrEnumerateSwapchainImages(swapchain, imageCapacityInput, imageCountOutput, images);
             if (XR_SUCCEEDED(result) && images) {
@@ -1441,8 +1947,26 @@ namespace {
                 return XR_ERROR_VALIDATION_FAILURE;
             }
 
-            TraceLoggingWrite(
-                g_traceProvider, "xrWaitSwapchainImage", TLPArg(swapchain, "Swapchain"), TLArg(waitInfo->timeout));
+            TraceLoggingWrite(g_traceProvider,
+                              "xrWaitSwapchainImage",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLPArg(swapchain, "Swapchain"),
+                              TLArg(waitInfo->timeout));
+
+            // The shadow images are acquired without waiting, see xrAcquireSwapchainImage(). The image may still be
+            // read by the processing of a previous frame.
+            auto swapchainIt = m_swapchains.find(swapchain);
+            if (swapchainIt != m_swapchains.end() && !swapchainIt->second.shadowImages.empty()) {
+                const auto& swapchainState = swapchainIt->second;
+                const auto& shadowImage = swapchainState.shadowImages[swapchainState.acquiredImageIndex];
+                if (!m_graphicsDevice->isSubmissionCompleted(shadowImage.lastUseSerial)) {
+                    TraceLocalActivity(local);
+                    TraceLoggingWriteStart(local, "WaitShadowImage", TraceLoggingKeyword(TLK_Frame));
+                    m_graphicsDevice->waitForSubmission(shadowImage.lastUseSerial);
+                    TraceLoggingWriteStop(local, "WaitShadowImage", TraceLoggingKeyword(TLK_Frame));
+                }
+                return XR_SUCCESS;
+            }
 
             // We remove the timeout causing issues with OpenComposite.
             XrSwapchainImageWaitInfo chainWaitInfo = *waitInfo;
@@ -1457,7 +1981,10 @@ namespace {
                 return XR_ERROR_VALIDATION_FAILURE;
             }
 
-            TraceLoggingWrite(g_traceProvider, "xrAcquireSwapchainImage", TLPArg(swapchain, "Swapchain"));
+            TraceLoggingWrite(g_traceProvider,
+                              "xrAcquireSwapchainImage",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLPArg(swapchain, "Swapchain"));
 
             auto swapchainIt = m_swapchains.find(swapchain);
             if (swapchainIt != m_swapchains.end()) {
@@ -1465,9 +1992,24 @@ namespace {
                     m_frameAnalyzer->onAcquireSwapchain(swapchain);
                 }
 
+                if (!swapchainIt->second.shadowImages.empty()) {
+                    *index = acquireShadowImage(swapchainIt->second);
+
+                    TraceLoggingWrite(g_traceProvider,
+                                      "xrAcquireSwapchainImage",
+                                      TraceLoggingKeyword(TLK_Frame),
+                                      TLArg(*index, "ShadowIndex"));
+
+                    m_graphicsDevice->executeDebugWorkload();
+                    return XR_SUCCESS;
+                }
+
                 // Perform the release now in case it was delayed.
                 if (swapchainIt->second.delayedRelease) {
-                    TraceLoggingWrite(g_traceProvider, "ForcedSwapchainRelease", TLPArg(swapchain, "Swapchain"));
+                    TraceLoggingWrite(g_traceProvider,
+                                      "ForcedSwapchainRelease",
+                                      TraceLoggingKeyword(TLK_Frame),
+                                      TLPArg(swapchain, "Swapchain"));
 
                     XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO, nullptr};
                     swapchainIt->second.delayedRelease = false;
@@ -1482,7 +2024,10 @@ namespace {
                     swapchainIt->second.acquiredImageIndex = *index;
                 }
 
-                TraceLoggingWrite(g_traceProvider, "xrAcquireSwapchainImage", TLArg(*index, "Index"));
+                TraceLoggingWrite(g_traceProvider,
+                                  "xrAcquireSwapchainImage",
+                                  TraceLoggingKeyword(TLK_Frame),
+                                  TLArg(*index, "Index"));
 
                 // Arbitrary location to simulate workload.
                 if (m_graphicsDevice) {
@@ -1499,7 +2044,10 @@ namespace {
                 return XR_ERROR_VALIDATION_FAILURE;
             }
 
-            TraceLoggingWrite(g_traceProvider, "xrReleaseSwapchainImage", TLPArg(swapchain, "Swapchain"));
+            TraceLoggingWrite(g_traceProvider,
+                              "xrReleaseSwapchainImage",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLPArg(swapchain, "Swapchain"));
 
             auto swapchainIt = m_swapchains.find(swapchain);
             if (swapchainIt != m_swapchains.end()) {
@@ -1507,8 +2055,15 @@ namespace {
                     m_frameAnalyzer->onReleaseSwapchain(swapchain);
                 }
 
+                // The runtime image is acquired once the frame is submitted.
+                if (!swapchainIt->second.shadowImages.empty()) {
+                    swapchainIt->second.pendingShadowIndex = swapchainIt->second.acquiredImageIndex;
+                    return XR_SUCCESS;
+                }
+
                 // Perform a delayed release: we still need to write to the swapchain in our xrEndFrame()!
                 swapchainIt->second.delayedRelease = true;
+                swapchainIt->second.frameImageIndex = swapchainIt->second.acquiredImageIndex;
                 return XR_SUCCESS;
             }
 
@@ -1552,7 +2107,16 @@ namespace {
                 return XR_SUCCESS;
             }
 
-            return OpenXrApi::xrPollEvent(instance, eventData);
+            const XrResult result = OpenXrApi::xrPollEvent(instance, eventData);
+            if (result == XR_SUCCESS && eventData->type == XR_TYPE_EVENT_DATA_VISIBILITY_MASK_CHANGED_KHR) {
+                const XrEventDataVisibilityMaskChangedKHR* const buffer =
+                    reinterpret_cast<XrEventDataVisibilityMaskChangedKHR*>(eventData);
+                if (buffer->viewConfigurationType == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+                    invalidateVisibilityMasksCache(buffer->viewIndex);
+                }
+            }
+
+            return result;
         }
 
         XrResult xrGetCurrentInteractionProfile(XrSession session,
@@ -1666,8 +2230,8 @@ namespace {
                 }
                 result = XR_SUCCESS;
             } else {
-                result = OpenXrApi::xrGetVisibilityMaskKHR(
-                    session, viewConfigurationType, viewIndex, visibilityMaskType, visibilityMask);
+                result =
+                    getVisibilityMask(session, viewConfigurationType, viewIndex, visibilityMaskType, visibilityMask);
             }
 
             if (XR_SUCCEEDED(result)) {
@@ -1684,6 +2248,89 @@ namespace {
             return result;
         }
 
+        // Get the visibility mask from the runtime, reusing the result of an earlier call when possible. The
+        // application, VRS and the hidden area pre-pass all query the masks with the two-call idiom, but the runtime
+        // only needs to be called once per view and mask type.
+        XrResult getVisibilityMask(XrSession session,
+                                   XrViewConfigurationType viewConfigurationType,
+                                   uint32_t viewIndex,
+                                   XrVisibilityMaskTypeKHR visibilityMaskType,
+                                   XrVisibilityMaskKHR* visibilityMask) {
+            if (!isVrSession(session) || viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO ||
+                visibilityMask->next) {
+                return OpenXrApi::xrGetVisibilityMaskKHR(
+                    session, viewConfigurationType, viewIndex, visibilityMaskType, visibilityMask);
+            }
+
+            std::unique_lock lock(m_visibilityMasksCacheLock);
+
+            const auto key = std::make_pair(viewIndex, visibilityMaskType);
+            auto it = m_visibilityMasksCache.find(key);
+            if (it == m_visibilityMasksCache.end()) {
+                XrVisibilityMaskKHR mask{XR_TYPE_VISIBILITY_MASK_KHR};
+                XrResult result = OpenXrApi::xrGetVisibilityMaskKHR(
+                    session, viewConfigurationType, viewIndex, visibilityMaskType, &mask);
+                if (XR_FAILED(result)) {
+                    return result;
+                }
+
+                CachedVisibilityMask entry;
+                entry.vertices.resize(mask.vertexCountOutput);
+                entry.indices.resize(mask.indexCountOutput);
+                if (!entry.vertices.empty() || !entry.indices.empty()) {
+                    mask.vertexCapacityInput = (uint32_t)entry.vertices.size();
+                    mask.vertices = entry.vertices.data();
+                    mask.indexCapacityInput = (uint32_t)entry.indices.size();
+                    mask.indices = entry.indices.data();
+                    result = OpenXrApi::xrGetVisibilityMaskKHR(
+                        session, viewConfigurationType, viewIndex, visibilityMaskType, &mask);
+                    if (XR_FAILED(result)) {
+                        return result;
+                    }
+                }
+
+                TraceLoggingWrite(g_traceProvider,
+                                  "VisibilityMaskCached",
+                                  TLArg(viewIndex, "ViewIndex"),
+                                  TLArg(xr::ToCString(visibilityMaskType), "VisibilityMaskType"),
+                                  TLArg(mask.vertexCountOutput, "VertexCount"),
+                                  TLArg(mask.indexCountOutput, "IndexCount"));
+
+                it = m_visibilityMasksCache.insert_or_assign(key, std::move(entry)).first;
+            }
+
+            // Follow the two-call idiom for each of the arrays.
+            const auto& entry = it->second;
+            visibilityMask->vertexCountOutput = (uint32_t)entry.vertices.size();
+            visibilityMask->indexCountOutput = (uint32_t)entry.indices.size();
+            if ((visibilityMask->vertexCapacityInput &&
+                 visibilityMask->vertexCapacityInput < visibilityMask->vertexCountOutput) ||
+                (visibilityMask->indexCapacityInput &&
+                 visibilityMask->indexCapacityInput < visibilityMask->indexCountOutput)) {
+                return XR_ERROR_SIZE_INSUFFICIENT;
+            }
+            if (visibilityMask->vertexCapacityInput) {
+                std::copy(entry.vertices.cbegin(), entry.vertices.cend(), visibilityMask->vertices);
+            }
+            if (visibilityMask->indexCapacityInput) {
+                std::copy(entry.indices.cbegin(), entry.indices.cend(), visibilityMask->indices);
+            }
+
+            return XR_SUCCESS;
+        }
+
+        void invalidateVisibilityMasksCache(std::optional<uint32_t> viewIndex = std::nullopt) {
+            std::unique_lock lock(m_visibilityMasksCacheLock);
+
+            for (auto it = m_visibilityMasksCache.begin(); it != m_visibilityMasksCache.end();) {
+                if (!viewIndex || it->first.first == viewIndex.value()) {
+                    it = m_visibilityMasksCache.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
         XrResult xrLocateViews(XrSession session,
                                const XrViewLocateInfo* viewLocateInfo,
                                XrViewState* viewState,
@@ -1696,22 +2343,40 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrLocateViews",
+                              TraceLoggingKeyword(TLK_Frame),
                               TLPArg(session, "Session"),
                               TLArg(xr::ToCString(viewLocateInfo->viewConfigurationType), "ViewConfigurationType"),
                               TLArg(viewLocateInfo->displayTime, "DisplayTime"),
                               TLPArg(viewLocateInfo->space, "Space"),
                               TLArg(viewCapacityInput, "ViewCapacityInput"));
 
+            // Our own components locate the views in our VIEW space. Those locations are not for the application's
+            // frame submission.
+            const bool isLayerViewSpace = m_viewSpace != XR_NULL_HANDLE && viewLocateInfo->space == m_viewSpace;
+
             const XrResult result =
-                OpenXrApi::xrLocateViews(session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
+                locateViews(session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
             if (XR_SUCCEEDED(result) && isVrSession(session) &&
                 viewLocateInfo->viewConfigurationType == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO &&
                 viewCapacityInput) {
                 assert(*viewCountOutput == utilities::ViewCount);
                 using namespace DirectX;
 
-                m_posesForFrame[0].pose = views[0].pose;
-                m_posesForFrame[1].pose = views[1].pose;
+                if (!isLayerViewSpace) {
+                    m_posesForFrame[0].pose = views[0].pose;
+                    m_posesForFrame[1].pose = views[1].pose;
+
+                    const XrTime xrTimeNow = m_hasPerformanceCounterKHR ? getTimeNow() : 0;
+
+                    // xrEndFrame() may run on another thread.
+                    std::unique_lock waitLock(m_waitLock);
+                    m_lastAppViewsLocate = {std::chrono::steady_clock::now(),
+                                            viewLocateInfo->space,
+                                            {views[0].pose.orientation, views[1].pose.orientation}};
+                    if (m_hasPerformanceCounterKHR) {
+                        m_frameContexts[m_waitedFrameId % m_frameContexts.size()].inputTime = xrTimeNow;
+                    }
+                }
 
                 // Fix Fallout 4 / OpenComposite Decal Issue for WMR
                 if (m_overrideParallelProjection) {
@@ -1722,7 +2387,7 @@ namespace {
                 }
 
                 // Override the canting angle if requested.
-                const int cantOverride = m_configManager->getValue("canting");
+                const int cantOverride = m_configManager->getValue(config::SettingCanting);
                 if (cantOverride != 0) {
                     const float angle = (float)(cantOverride * (M_PI / 180));
 
@@ -1741,8 +2406,8 @@ namespace {
 
                     XrViewState state{XR_TYPE_VIEW_STATE, nullptr};
                     XrView eyeInViewSpace[2] = {{XR_TYPE_VIEW, nullptr}, {XR_TYPE_VIEW, nullptr}};
-                    CHECK_XRCMD(OpenXrApi::xrLocateViews(
-                        session, &info, &state, viewCapacityInput, viewCountOutput, eyeInViewSpace));
+                    uint32_t viewCountOutput;
+                    CHECK_XRCMD(locateViews(session, &info, &state, 2, &viewCountOutput, eyeInViewSpace));
 
                     if (Pose::IsPoseValid(state.viewStateFlags)) {
                         utilities::GetProjectedGaze(eyeInViewSpace, XrVector3f{0, 0, -1.0f}, m_projCenters);
@@ -1812,8 +2477,10 @@ namespace {
                 StoreXrFov(&m_stats.fov[0], ConvertToDegrees(views[0].fov));
                 StoreXrFov(&m_stats.fov[1], ConvertToDegrees(views[1].fov));
 
-                m_posesForFrame[0].fov = views[0].fov;
-                m_posesForFrame[1].fov = views[1].fov;
+                if (!isLayerViewSpace) {
+                    m_posesForFrame[0].fov = views[0].fov;
+                    m_posesForFrame[1].fov = views[1].fov;
+                }
 
                 // Apply zoom if requested.
                 const auto zoom = m_configManager->getValue(config::SettingZoom);
@@ -1824,6 +2491,7 @@ namespace {
 
                 TraceLoggingWrite(g_traceProvider,
                                   "xrLocateViews",
+                                  TraceLoggingKeyword(TLK_Frame),
                                   TLArg(*viewCountOutput, "ViewCountOutput"),
                                   TLArg(viewState->viewStateFlags, "ViewStateFlags"),
                                   TLArg(xr::ToString(views[0].pose).c_str(), "LeftPose"),
@@ -1835,6 +2503,46 @@ namespace {
             return result;
         }
 
+        // Locate the views, reusing the result of an earlier call for the same space and display time when possible.
+        // Only our VIEW space is cached: the application may locate the views again later for the same display time in
+        // order to get a fresher prediction, and we must not defeat that.
+        XrResult locateViews(XrSession session,
+                             const XrViewLocateInfo* viewLocateInfo,
+                             XrViewState* viewState,
+                             uint32_t viewCapacityInput,
+                             uint32_t* viewCountOutput,
+                             XrView* views) {
+            const bool isCacheable =
+                isVrSession(session) && m_viewSpace != XR_NULL_HANDLE && viewLocateInfo->space == m_viewSpace &&
+                viewLocateInfo->viewConfigurationType == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO &&
+                viewCapacityInput >= utilities::ViewCount && !viewState->next && !views[0].next && !views[1].next;
+
+            if (isCacheable) {
+                for (const auto& entry : m_viewsCache) {
+                    if (entry.space == viewLocateInfo->space && entry.displayTime == viewLocateInfo->displayTime) {
+                        *viewState = entry.viewState;
+                        std::copy_n(entry.views, utilities::ViewCount, views);
+                        *viewCountOutput = utilities::ViewCount;
+                        return XR_SUCCESS;
+                    }
+                }
+            }
+
+            const XrResult result =
+                OpenXrApi::xrLocateViews(session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
+            if (XR_SUCCEEDED(result) && isCacheable && *viewCountOutput == utilities::ViewCount) {
+                auto& entry = m_viewsCache[m_nextViewsCacheEntry];
+                m_nextViewsCacheEntry = (m_nextViewsCacheEntry + 1) % m_viewsCache.size();
+
+                entry.space = viewLocateInfo->space;
+                entry.displayTime = viewLocateInfo->displayTime;
+                entry.viewState = *viewState;
+                std::copy_n(views, utilities::ViewCount, entry.views);
+            }
+
+            return result;
+        }
+
         XrResult xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location) override {
             if (location->type != XR_TYPE_SPACE_LOCATION) {
                 return XR_ERROR_VALIDATION_FAILURE;
@@ -1842,10 +2550,48 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrLocateSpace",
+                              TraceLoggingKeyword(TLK_Frame),
                               TLPArg(space, "Space"),
                               TLPArg(baseSpace, "BaseSpace"),
                               TLArg(time, "Time"));
 
+            // Engines tend to locate the same spaces many times per frame. Within a frame, serve them from our cache.
+            // Only the plain locations are cached: locating the velocities must go to the runtime.
+            const bool isCacheable = m_useSpaceLocationsCache && !location->next;
+            if (isCacheable) {
+                std::unique_lock lock(m_spaceLocationsCacheLock);
+                for (const auto& entry : m_spaceLocationsCache) {
+                    if (entry.space == space && entry.baseSpace == baseSpace && entry.time == time) {
+                        location->locationFlags = entry.location.locationFlags;
+                        location->pose = entry.location.pose;
+                        m_stats.numLocateSpaceCacheHits++;
+                        return XR_SUCCESS;
+                    }
+                }
+                m_stats.numLocateSpaceCacheMisses++;
+            }
+
+            const XrResult result = locateSpace(space, baseSpace, time, location);
+            if (XR_SUCCEEDED(result) && isCacheable) {
+                std::unique_lock lock(m_spaceLocationsCacheLock);
+                if (m_spaceLocationsCache.size() < MaxCachedSpaceLocations) {
+                    m_spaceLocationsCache.push_back({space, baseSpace, time, *location});
+                }
+            }
+
+            return result;
+        }
+
+        // Invalidate the cached space locations. The action spaces may move after xrSyncActions(), and the predictions
+        // are refreshed after xrWaitFrame().
+        void invalidateSpaceLocationsCache() {
+            if (m_useSpaceLocationsCache) {
+                std::unique_lock lock(m_spaceLocationsCacheLock);
+                m_spaceLocationsCache.clear();
+            }
+        }
+
+        XrResult locateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location) {
             if (m_handTracker && m_vrSession != XR_NULL_HANDLE && location->type == XR_TYPE_SPACE_LOCATION) {
                 m_performanceCounters.handTrackingTimer->start();
                 if (m_handTracker->locate(space, baseSpace, time, getTimeNow(), *location)) {
@@ -1854,6 +2600,7 @@ namespace {
 
                     TraceLoggingWrite(g_traceProvider,
                                       "xrLocateSpace",
+                                      TraceLoggingKeyword(TLK_Frame),
                                       TLArg(location->locationFlags, "LocationFlags"),
                                       TLArg(xr::ToString(location->pose).c_str(), "Pose"));
 
@@ -1869,14 +2616,23 @@ namespace {
                 return XR_ERROR_VALIDATION_FAILURE;
             }
 
-            TraceLoggingWrite(g_traceProvider, "xrSyncActions", TLPArg(session, "Session"));
-            for (uint32_t i = 0; i < syncInfo->countActiveActionSets; i++) {
-                TraceLoggingWrite(g_traceProvider,
-                                  "xrSyncActions",
-                                  TLPArg(syncInfo->activeActionSets[i].actionSet, "ActionSet"),
-                                  TLArg(getPath(syncInfo->activeActionSets[i].subactionPath).c_str(), "SubactionPath"));
+            TraceLoggingWrite(g_traceProvider,
+                              "xrSyncActions",
+                              TraceLoggingKeyword(TLK_Input),
+                              TLPArg(session, "Session"));
+            if (IsTraceKeywordEnabled(TLK_Input)) {
+                for (uint32_t i = 0; i < syncInfo->countActiveActionSets; i++) {
+                    TraceLoggingWrite(
+                        g_traceProvider,
+                        "xrSyncActions",
+                        TraceLoggingKeyword(TLK_Input),
+                        TLPArg(syncInfo->activeActionSets[i].actionSet, "ActionSet"),
+                        TLArg(getPath(syncInfo->activeActionSets[i].subactionPath).c_str(), "SubactionPath"));
+                }
             }
 
+            invalidateSpaceLocationsCache();
+
             XrActionsSyncInfo chainSyncInfo = *syncInfo;
             std::vector<XrActiveActionSet> newActiveActionSets;
             if (m_eyeTracker && isVrSession(session)) {
@@ -1901,7 +2657,7 @@ namespace {
             if (XR_SUCCEEDED(result) && m_handTracker && isVrSession(session)) {
                 m_performanceCounters.handTrackingTimer->start();
 
-                m_handTracker->sync(m_begunFrameTime, getTimeNow(), *syncInfo);
+                m_handTracker->sync(getBegunFrame().displayTime, getTimeNow(), *syncInfo);
 
                 m_performanceCounters.handTrackingTimer->stop();
                 m_stats.handTrackingCpuTimeUs += m_performanceCounters.handTrackingTimer->query();
@@ -1919,6 +2675,7 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrGetActionStateBoolean",
+                              TraceLoggingKeyword(TLK_Input),
                               TLPArg(session, "Session"),
                               TLPArg(getInfo->action, "Action"),
                               TLArg(getPath(getInfo->subactionPath).c_str(), "SubactionPath"));
@@ -1932,6 +2689,7 @@ namespace {
 
                     TraceLoggingWrite(g_traceProvider,
                                       "xrGetActionStateBoolean",
+                                      TraceLoggingKeyword(TLK_Input),
                                       TLArg(!!state->isActive, "Active"),
                                       TLArg(!!state->currentState, "CurrentState"),
                                       TLArg(!!state->changedSinceLastSync, "ChangedSinceLastSync"),
@@ -1953,6 +2711,7 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrGetActionStateFloat",
+                              TraceLoggingKeyword(TLK_Input),
                               TLPArg(session, "Session"),
                               TLPArg(getInfo->action, "Action"),
                               TLArg(getPath(getInfo->subactionPath).c_str(), "SubactionPath"));
@@ -1966,6 +2725,7 @@ namespace {
 
                     TraceLoggingWrite(g_traceProvider,
                                       "xrGetActionStateFloat",
+                                      TraceLoggingKeyword(TLK_Input),
                                       TLArg(!!state->isActive, "Active"),
                                       TLArg(state->currentState, "CurrentState"),
                                       TLArg(!!state->changedSinceLastSync, "ChangedSinceLastSync"),
@@ -1987,6 +2747,7 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrGetActionStatePose",
+                              TraceLoggingKeyword(TLK_Input),
                               TLPArg(session, "Session"),
                               TLPArg(getInfo->action, "Action"),
                               TLArg(getPath(getInfo->subactionPath).c_str(), "SubactionPath"));
@@ -2010,7 +2771,10 @@ namespace {
                     m_performanceCounters.handTrackingTimer->stop();
                     m_stats.handTrackingCpuTimeUs += m_performanceCounters.handTrackingTimer->query();
 
-                    TraceLoggingWrite(g_traceProvider, "xrGetActionStatePose", TLArg(!!state->isActive, "Active"));
+                    TraceLoggingWrite(g_traceProvider,
+                                      "xrGetActionStatePose",
+                                      TraceLoggingKeyword(TLK_Input),
+                                      TLArg(!!state->isActive, "Active"));
 
                     return XR_SUCCESS;
                 }
@@ -2028,6 +2792,7 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrApplyHapticFeedback",
+                              TraceLoggingKeyword(TLK_Input),
                               TLPArg(session, "Session"),
                               TLPArg(hapticActionInfo->action, "Action"),
                               TLArg(getPath(hapticActionInfo->subactionPath).c_str(), "SubactionPath"));
@@ -2064,6 +2829,7 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrStopHapticFeedback",
+                              TraceLoggingKeyword(TLK_Input),
                               TLPArg(session, "Session"),
                               TLPArg(hapticActionInfo->action, "Action"),
                               TLArg(getPath(hapticActionInfo->subactionPath).c_str(), "SubactionPath"));
@@ -2099,26 +2865,27 @@ namespace {
                 return XR_ERROR_VALIDATION_FAILURE;
             }
 
-            TraceLoggingWrite(g_traceProvider, "xrWaitFrame", TLPArg(session, "Session"));
+            TraceLoggingWrite(g_traceProvider,
+                              "xrWaitFrame",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLPArg(session, "Session"));
 
             const auto lastFrameWaitTimestamp = m_lastFrameWaitTimestamp;
+            bool isThrottling = false;
             if (isVrSession(session)) {
                 if (m_graphicsDevice) {
                     m_performanceCounters.appCpuTimer->stop();
-                    m_stats.appCpuTimeUs += m_performanceCounters.appCpuTimer->query();
+
+                    std::unique_lock lock(m_waitLock);
+                    m_pendingAppCpuTimeUs += m_performanceCounters.appCpuTimer->query();
                 }
 
                 // Do throttling if needed.
                 if (m_isFrameThrottlingPossible) {
                     const auto frameThrottling = m_configManager->getValue(config::SettingFrameThrottling);
                     if (frameThrottling < config::MaxFrameRate) {
-                        // TODO: Try to reduce latency by slowing slewing to reduce the predictedDisplayTime.
-
-                        const auto target =
-                            m_lastFrameWaitTimestamp +
-                            std::chrono::microseconds(1000000 / frameThrottling + m_frameThrottleSleepOffset) -
-                            500us /* "running start" */;
-                        std::this_thread::sleep_until(target);
+                        m_frameLimiter->wait(frameThrottling);
+                        isThrottling = true;
                     }
                 }
                 m_lastFrameWaitTimestamp = std::chrono::steady_clock::now();
@@ -2126,84 +2893,115 @@ namespace {
                 m_performanceCounters.waitCpuTimer->start();
             }
 
-            std::unique_lock lock(m_frameLock);
-
+            // Only Turbo Mode needs to synchronize with xrEndFrame(). Otherwise, we must not hold the frame lock, since
+            // an engine pipelining its frames calls xrWaitFrame() while the previous frame is still being ended.
+            //
+            // The async waiter must never be kicked off while we are in the runtime's xrWaitFrame(). We announce the
+            // wait before checking whether Turbo Mode is active, while xrEndFrame() sets m_isAsyncWaitActive before
+            // checking for a wait in progress: at least one of the two sides sees the other.
             XrResult result = XR_ERROR_RUNTIME_FAILURE;
-            if (isVrSession(session) && m_asyncWaitPromise.valid()) {
-                TraceLoggingWrite(g_traceProvider, "AsyncWaitMode");
+            std::unique_lock lock(m_frameLock, std::defer_lock);
+            if (isVrSession(session)) {
+                m_isAppWaitingOnRuntime = true;
+                if (m_isAsyncWaitActive) {
+                    lock.lock();
+                    m_isAppWaitingOnRuntime = false;
+                }
+            }
+            if (isVrSession(session) && lock && m_asyncWaiter && m_asyncWaiter->isActive()) {
+                TraceLoggingWrite(g_traceProvider, "AsyncWaitMode", TraceLoggingKeyword(TLK_Frame));
 
                 // In Turbo mode, we accept pipelining of exactly one frame.
-                if (m_asyncWaitPolled) {
-                    TraceLocalActivity(local);
-
-                    // On second frame poll, we must wait.
-                    TraceLoggingWriteStart(local, "AsyncWaitNow");
-                    m_asyncWaitPromise.wait();
-                    TraceLoggingWriteStop(local, "AsyncWaitNow");
+                const auto asyncFrameState = m_asyncWaiter->poll();
+                std::unique_lock waitLock(m_waitLock);
+                if (asyncFrameState) {
+                    m_lastPredictedDisplayTime = asyncFrameState->predictedDisplayTime;
+                    m_lastPredictedDisplayPeriod = asyncFrameState->predictedDisplayPeriod;
                 }
-                m_asyncWaitPolled = true;
 
                 // In Turbo mode, we don't actually wait, we make up a predicted time.
-                std::unique_lock lock(m_asyncWaitLock);
                 frameState->predictedDisplayTime =
-                    m_asyncWaitCompleted
+                    asyncFrameState
                         ? m_lastPredictedDisplayTime
                         : (m_lastPredictedDisplayTime + (m_lastFrameWaitTimestamp - lastFrameWaitTimestamp).count());
                 frameState->predictedDisplayPeriod = m_lastPredictedDisplayPeriod;
                 frameState->shouldRender = XR_TRUE;
                 result = XR_SUCCESS;
             } else {
-                lock.unlock();
+                if (lock) {
+                    m_isAppWaitingOnRuntime = true;
+                    lock.unlock();
+                }
                 result = OpenXrApi::xrWaitFrame(session, frameWaitInfo, frameState);
-                lock.lock();
+                if (isVrSession(session)) {
+                    m_isAppWaitingOnRuntime = false;
+                }
+
+                // Let the frame limiter line up its deadline with the runtime's.
+                if (isThrottling && XR_SUCCEEDED(result)) {
+                    m_frameLimiter->reportRuntimeWait(std::chrono::steady_clock::now() - m_lastFrameWaitTimestamp);
+                }
 
                 if (XR_SUCCEEDED(result)) {
                     // We must always store those values to properly handle transitions into Turbo Mode.
+                    std::unique_lock waitLock(m_waitLock);
                     m_lastPredictedDisplayTime = frameState->predictedDisplayTime;
                     m_lastPredictedDisplayPeriod = frameState->predictedDisplayPeriod;
                 }
             }
+            invalidateSpaceLocationsCache();
             if (XR_SUCCEEDED(result) && isVrSession(session)) {
                 m_performanceCounters.waitCpuTimer->stop();
-                m_stats.waitCpuTimeUs += m_performanceCounters.waitCpuTimer->query();
 
-                m_savedFrameTime1 = frameState->predictedDisplayTime;
+                FrameContext frame;
+                frame.runtimeDisplayTime = frameState->predictedDisplayTime;
+                uint64_t predictionTimeUs = 0;
 
                 // Apply prediction dampening if possible and if needed.
                 if (m_hasPerformanceCounterKHR) {
-                    const int predictionDampen = m_configManager->getValue(config::SettingPredictionDampen);
-                    if (predictionDampen != 100) {
-                        // Find the current time.
-                        LARGE_INTEGER qpcTimeNow;
-                        QueryPerformanceCounter(&qpcTimeNow);
-
-                        XrTime xrTimeNow;
-                        CHECK_XRCMD(
-                            xrConvertWin32PerformanceCounterToTimeKHR(GetXrInstance(), &qpcTimeNow, &xrTimeNow));
-
+                    const XrTime xrTimeNow = getTimeNow();
+                    frame.waitedTime = xrTimeNow;
+
+                    const bool isAutoPredictionDampen = m_configManager->getValue(config::SettingPredictionDampenAuto);
+                    const int predictionDampen = isAutoPredictionDampen
+                                                     ? m_predictionDampeningTuner.getValue()
+                                                     : m_configManager->getValue(config::SettingPredictionDampen);
+                    if (predictionDampen != 100 || isAutoPredictionDampen) {
                         XrTime predictionAmount = frameState->predictedDisplayTime - xrTimeNow;
                         if (predictionAmount > 0) {
                             frameState->predictedDisplayTime = xrTimeNow + (predictionDampen * predictionAmount) / 100;
                         }
 
-                        m_stats.predictionTimeUs += predictionAmount;
+                        predictionTimeUs = predictionAmount;
                     }
                 }
 
-                // Per OpenXR spec, the predicted display must increase monotonically.
-                frameState->predictedDisplayTime = std::max(frameState->predictedDisplayTime, m_waitedFrameTime + 1);
+                {
+                    std::unique_lock waitLock(m_waitLock);
+
+                    // Per OpenXR spec, the predicted display must increase monotonically.
+                    const FrameContext& lastWaitedFrame = m_frameContexts[m_waitedFrameId % m_frameContexts.size()];
+                    frameState->predictedDisplayTime =
+                        std::max(frameState->predictedDisplayTime, lastWaitedFrame.displayTime + 1);
 
-                // Record the predicted display time.
-                m_waitedFrameTime = frameState->predictedDisplayTime;
+                    // Record the predicted display time.
+                    frame.frameId = ++m_waitedFrameId;
+                    frame.displayTime = frameState->predictedDisplayTime;
+                    m_frameContexts[frame.frameId % m_frameContexts.size()] = frame;
+
+                    m_pendingWaitCpuTimeUs += m_performanceCounters.waitCpuTimer->query();
+                    m_pendingPredictionTimeUs += predictionTimeUs;
+                    m_pendingFramePipeliningDetected = m_isInFrame;
+                }
 
                 if (m_graphicsDevice) {
                     m_performanceCounters.appCpuTimer->start();
                 }
 
-                m_stats.isFramePipeliningDetected = m_isInFrame;
-
                 TraceLoggingWrite(g_traceProvider,
                                   "xrWaitFrame",
+                                  TraceLoggingKeyword(TLK_Frame),
+                                  TLArg(frame.frameId, "FrameId"),
                                   TLArg(!!frameState->shouldRender, "ShouldRender"),
                                   TLArg(frameState->predictedDisplayTime, "PredictedDisplayTime"),
                                   TLArg(frameState->predictedDisplayPeriod, "PredictedDisplayPeriod"));
@@ -2217,7 +3015,10 @@ namespace {
                 return XR_ERROR_VALIDATION_FAILURE;
             }
 
-            TraceLoggingWrite(g_traceProvider, "xrBeginFrame", TLPArg(session, "Session"));
+            TraceLoggingWrite(g_traceProvider,
+                              "xrBeginFrame",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLPArg(session, "Session"));
 
             std::unique_lock lock(m_frameLock);
 
@@ -2225,7 +3026,10 @@ namespace {
             // when a frame is discarded.
             for (auto& swapchain : m_swapchains) {
                 if (swapchain.second.delayedRelease) {
-                    TraceLoggingWrite(g_traceProvider, "ForcedSwapchainRelease", TLPArg(swapchain.first, "Swapchain"));
+                    TraceLoggingWrite(g_traceProvider,
+                                      "ForcedSwapchainRelease",
+                                      TraceLoggingKeyword(TLK_Frame),
+                                      TLPArg(swapchain.first, "Swapchain"));
 
                     XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
                     swapchain.second.delayedRelease = false;
@@ -2234,24 +3038,26 @@ namespace {
             }
 
             XrResult result = XR_ERROR_RUNTIME_FAILURE;
-            if (isVrSession(session) && m_asyncWaitPromise.valid()) {
+            if (isVrSession(session) && m_asyncWaiter && m_asyncWaiter->isActive()) {
                 // In turbo mode, we do nothing here.
-                TraceLoggingWrite(g_traceProvider, "AsyncWaitMode");
+                TraceLoggingWrite(g_traceProvider, "AsyncWaitMode", TraceLoggingKeyword(TLK_Frame));
                 result = XR_SUCCESS;
             } else {
                 result = OpenXrApi::xrBeginFrame(session, frameBeginInfo);
             }
             if (XR_SUCCEEDED(result) && isVrSession(session)) {
-                // Record the predicted display time.
-                m_begunFrameTime = m_waitedFrameTime;
-                m_savedFrameTime2 = m_savedFrameTime1;
+                // The frame being begun is the latest one that was waited.
+                const XrTime xrTimeNow = m_hasPerformanceCounterKHR ? getTimeNow() : 0;
+                {
+                    std::unique_lock waitLock(m_waitLock);
+                    m_begunFrameId = m_waitedFrameId;
+                    m_frameContexts[m_begunFrameId % m_frameContexts.size()].begunTime = xrTimeNow;
+                }
                 m_isInFrame = true;
 
                 if (m_graphicsDevice) {
                     m_performanceCounters.renderCpuTimer->start();
-                    m_stats.appGpuTimeUs +=
-                        m_performanceCounters.appGpuTimer[m_performanceCounters.gpuTimerIndex]->query();
-                    m_performanceCounters.appGpuTimer[m_performanceCounters.gpuTimerIndex]->start();
+                    m_performanceCounters.gpuTimers->start(graphics::GpuPass::App);
 
                     // With D3D12, we want to make sure the query is enqueued now.
                     if (m_graphicsDevice->getApi() == graphics::Api::D3D12) {
@@ -2289,12 +3095,17 @@ namespace {
                     }
 
                     if (m_eyeTracker) {
-                        m_eyeTracker->beginFrame(m_begunFrameTime);
+                        m_eyeTracker->beginFrame(getBegunFrame().displayTime);
                     }
                 }
 
+                // The masks themselves are drawn with the rest of our work (see xrEndFrame()).
                 if (m_variableRateShader) {
-                    m_variableRateShader->beginFrame(m_begunFrameTime);
+                    m_variableRateShader->beginFrame(getBegunFrame().displayTime);
+                }
+
+                if (m_hiddenAreaPrePass) {
+                    m_hiddenAreaPrePass->beginFrame(getBegunFrame().displayTime);
                 }
             }
 
@@ -2305,18 +3116,6 @@ namespace {
             const auto now = std::chrono::steady_clock::now();
             const auto numFrames = ++m_performanceCounters.numFrames;
 
-            if (m_graphicsDevice) {
-                m_stats.numBiasedSamplers = m_graphicsDevice->getNumBiasedSamplersThisFrame();
-            }
-
-            if (m_variableRateShader) {
-                m_stats.actualRenderWidth = m_variableRateShader->getActualRenderWidth();
-            }
-
-            if (m_frameAnalyzer) {
-                m_stats.frameAnalyzerHeuristic = m_frameAnalyzer->getCurrentHeuristic();
-            }
-
             if (m_configManager->hasChanged(config::SettingRecordStats)) {
                 if (m_configManager->getValue(config::SettingRecordStats)) {
                     const std::time_t now = std::time(nullptr);
@@ -2327,14 +3126,43 @@ namespace {
 
                     // Write headers.
                     m_logStats << "time,FPS,appCPU (us),renderCPU (us),appGPU (us),VRAM (MB),VRAM (%)\n";
+
+                    // Optionally record every frame, without averaging.
+                    if (m_configManager->getValue(config::SettingRecordStatsPerFrame)) {
+                        const auto recordFile = localAppData / "stats" / (std::string(buf) + "_frames");
+                        m_statsRecorder = utilities::CreateStatisticsRecorder(recordFile);
+                        resetRecordedStatistics();
+                    }
                 } else {
                     m_logStats.close();
+                    m_statsRecorder.reset();
+                }
+            }
+
+            if (m_configManager->hasChanged(config::SettingTelemetry)) {
+                m_telemetryPublisher.reset();
+                if (m_configManager->getValue(config::SettingTelemetry)) {
+                    try {
+                        m_telemetryPublisher = menu::CreateTelemetryPublisher(m_applicationName);
+                    } catch (std::exception& e) {
+                        Log("Could not publish telemetry: %s\n", e.what());
+                    }
+                    resetRecordedStatistics();
+                }
+            }
+
+            if (m_configManager->hasChanged(config::SettingBenchmarkSweep)) {
+                m_performanceSweeper.reset();
+                if (m_configManager->getValue(config::SettingBenchmarkSweep)) {
+                    startPerformanceSweep();
                 }
             }
 
             const bool highRate = m_configManager->getValue(config::SettingHighRateStats);
             if ((now - m_performanceCounters.lastWindowStart) >= (highRate ? 100ms : 1s)) {
                 const auto duration = now - m_performanceCounters.lastWindowStart;
+                const auto numPoseAgeSamples = std::exchange(m_performanceCounters.numPoseAgeSamples, 0);
+                const auto numPoseErrorSamples = std::exchange(m_performanceCounters.numPoseErrorSamples, 0);
                 m_performanceCounters.numFrames = 0;
                 m_performanceCounters.lastWindowStart = now;
 
@@ -2352,7 +3180,19 @@ namespace {
                 m_stats.overlayCpuTimeUs /= numFrames;
                 m_stats.overlayGpuTimeUs /= numFrames;
                 m_stats.handTrackingCpuTimeUs /= numFrames;
+                m_stats.handTrackingGpuTimeUs /= numFrames;
+                m_stats.numLocateSpaceCacheHits /= numFrames;
+                m_stats.numLocateSpaceCacheMisses /= numFrames;
+                m_stats.variableRateShadingGpuTimeUs /= numFrames;
                 m_stats.predictionTimeUs /= numFrames;
+                // The poses are only measured on the frames where the application located the views.
+                m_stats.poseAgeUs = numPoseAgeSamples ? m_stats.poseAgeUs / numPoseAgeSamples : 0;
+                m_stats.poseErrorDeg = numPoseErrorSamples ? m_stats.poseErrorDeg / numPoseErrorSamples : 0.f;
+                m_stats.numGpuProfileScopes = m_performanceCounters.gpuProfiler->query(
+                    m_stats.gpuProfileScopes, (uint32_t)std::size(m_stats.gpuProfileScopes));
+                for (uint32_t i = 0; i < m_stats.numGpuProfileScopes; i++) {
+                    m_stats.gpuProfileScopes[i].durationUs /= numFrames;
+                }
                 if (highRate) {
                     // We must still do a rolling average for the FPS otherwise the values are all over the place.
                     m_performanceCounters.frameRates.push_front(std::make_pair(duration, numFrames));
@@ -2374,6 +3214,8 @@ namespace {
 
                 m_graphicsDevice->getVRAMUsage(m_stats.vramUsedSize, m_stats.vramUsedPercent);
 
+                trimVideoMemory();
+
                 // When CPU-bound, do not bother giving a (false) GPU time for D3D12
                 if (m_graphicsDevice->getApi() == graphics::Api::D3D12 &&
                     m_stats.appCpuTimeUs + 500 > m_stats.appGpuTimeUs) {
@@ -2383,6 +3225,9 @@ namespace {
                 if (m_menuHandler) {
                     m_menuHandler->updateStatistics(m_stats);
                 }
+                if (m_telemetryPublisher) {
+                    m_telemetryPublisher->publishStatistics(m_stats);
+                }
 
                 if (m_logStats.is_open()) {
                     const std::time_t now = std::time(nullptr);
@@ -2395,10 +3240,42 @@ namespace {
                                << "\n";
                 }
 
-                // Start from fresh!
+                // Start from fresh! The query above reset the GPU profiler, so its scopes must be snapshot again.
                 memset(&m_stats, 0, sizeof(m_stats));
+                resetRecordedStatistics();
+            }
+
+            // Collect the statistics accumulated by xrWaitFrame() since the last frame. This is done after the
+            // window is reset, since the frame is recorded at the end of xrEndFrame() (see recordStatisticsForFrame()).
+            {
+                std::unique_lock waitLock(m_waitLock);
+                m_stats.appCpuTimeUs += std::exchange(m_pendingAppCpuTimeUs, 0);
+                m_stats.waitCpuTimeUs += std::exchange(m_pendingWaitCpuTimeUs, 0);
+                m_stats.predictionTimeUs += std::exchange(m_pendingPredictionTimeUs, 0);
+                m_stats.isFramePipeliningDetected = m_pendingFramePipeliningDetected;
+            }
+
+            if (m_graphicsDevice) {
+                m_stats.numBiasedSamplers =
+                    m_graphicsDevice->getNumBiasedSamplersThisFrame(m_stats.numBiasedSamplersCreated);
+            }
+
+            if (m_variableRateShader) {
+                m_stats.actualRenderWidth = m_variableRateShader->getActualRenderWidth();
+                // The tile coverage is only displayed by the developer overlay, and recorded with the statistics.
+                const bool needTileCoverage =
+                    m_statsRecorder || m_telemetryPublisher ||
+                    m_configManager->peekEnumValue<config::OverlayType>(config::SettingOverlayType) ==
+                        config::OverlayType::Developer;
+                m_stats.variableRateShader = m_variableRateShader->getStatistics(needTileCoverage);
+            }
+
+            if (m_frameAnalyzer) {
+                m_stats.frameAnalyzerHeuristic = m_frameAnalyzer->getCurrentHeuristic();
             }
 
+            m_stats.predictionDampen = m_predictionDampeningTuner.getValue();
+
             if (m_handTracker && m_menuHandler) {
                 m_menuHandler->updateGesturesState(m_handTracker->getGesturesState());
             }
@@ -2412,6 +3289,281 @@ namespace {
             m_stats.numRenderTargetsWithVRS = 0;
         }
 
+        // Record the statistics of the frame, once it is submitted to the runtime (and its latency is known).
+        void recordStatisticsForFrame() {
+            if (!m_statsRecorder && !m_telemetryPublisher && !m_performanceSweeper) {
+                return;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+
+            // The statistics are accumulated over the window, so we record the difference since the last frame.
+            utilities::FrameStatistics frame;
+            frame.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+            frame.appCpuTimeUs = (uint32_t)(m_stats.appCpuTimeUs - m_recordedStats.appCpuTimeUs);
+            frame.renderCpuTimeUs = (uint32_t)(m_stats.renderCpuTimeUs - m_recordedStats.renderCpuTimeUs);
+            frame.appGpuTimeUs = (uint32_t)(m_stats.appGpuTimeUs - m_recordedStats.appGpuTimeUs);
+            frame.waitCpuTimeUs = (uint32_t)(m_stats.waitCpuTimeUs - m_recordedStats.waitCpuTimeUs);
+            frame.endFrameCpuTimeUs = (uint32_t)(m_stats.endFrameCpuTimeUs - m_recordedStats.endFrameCpuTimeUs);
+            for (uint32_t i = 0; i < 2; i++) {
+                frame.processorGpuTimeUs[i] =
+                    (uint32_t)(m_stats.processorGpuTimeUs[i] - m_recordedStats.processorGpuTimeUs[i]);
+            }
+            frame.overlayGpuTimeUs = (uint32_t)(m_stats.overlayGpuTimeUs - m_recordedStats.overlayGpuTimeUs);
+
+            // The latencies are already per-frame.
+            frame.inputLatencyUs = (uint32_t)m_stats.inputLatencyUs;
+            frame.waitLatencyUs = (uint32_t)m_stats.waitLatencyUs;
+            frame.beginLatencyUs = (uint32_t)m_stats.beginLatencyUs;
+            frame.renderLatencyUs = (uint32_t)m_stats.renderLatencyUs;
+            frame.endFrameLatencyUs = (uint32_t)m_stats.endFrameLatencyUs;
+            frame.submitLatencyUs = (uint32_t)m_stats.submitLatencyUs;
+
+            // The VRS statistics are already per-frame.
+            const auto& vrsStats = m_stats.variableRateShader;
+            static_assert(std::extent_v<decltype(frame.vrsRejectedBinds)> ==
+                          std::extent_v<decltype(vrsStats.numRejectedBinds)>);
+            static_assert(std::extent_v<decltype(frame.vrsTileCoverage)> ==
+                          std::extent_v<decltype(vrsStats.tileCoverage)>);
+            frame.vrsCandidateBinds = vrsStats.numCandidateBinds;
+            for (uint32_t i = 0; i < std::size(frame.vrsRejectedBinds); i++) {
+                frame.vrsRejectedBinds[i] = vrsStats.numRejectedBinds[i];
+            }
+            frame.vrsMaskHits = vrsStats.numMaskHits;
+            frame.vrsMaskMisses = vrsStats.numMaskMisses;
+            frame.vrsMaskEvictions = vrsStats.numMaskEvictions;
+            for (uint32_t i = 0; i < std::size(frame.vrsTileCoverage); i++) {
+                frame.vrsTileCoverage[i] = (uint16_t)std::round(vrsStats.tileCoverage[i] * 10000.f);
+            }
+            if (m_statsRecorder) {
+                m_statsRecorder->record(frame);
+            }
+
+            // The GPU profiler also accumulates over the window. Its scopes keep their order unless a new one is
+            // first opened, in which case the sample of the moved scopes is skipped.
+            graphics::GpuProfileScope gpuProfileScopes[graphics::MaxGpuProfileScopes];
+            graphics::GpuProfileScope frameGpuProfileScopes[graphics::MaxGpuProfileScopes];
+            uint32_t numGpuProfileScopes = 0;
+            if (m_telemetryPublisher || m_performanceSweeper) {
+                numGpuProfileScopes = m_performanceCounters.gpuProfiler->query(
+                    gpuProfileScopes, (uint32_t)std::size(gpuProfileScopes), false /* reset */);
+                for (uint32_t i = 0; i < numGpuProfileScopes; i++) {
+                    frameGpuProfileScopes[i] = gpuProfileScopes[i];
+                    const auto& previous = m_recordedStats.gpuProfileScopes[i];
+                    if (i < m_recordedStats.numGpuProfileScopes && !strcmp(previous.name, gpuProfileScopes[i].name)) {
+                        frameGpuProfileScopes[i].durationUs -=
+                            std::min(previous.durationUs, gpuProfileScopes[i].durationUs);
+                    } else if (m_recordedStats.numGpuProfileScopes) {
+                        frameGpuProfileScopes[i].durationUs = 0;
+                    }
+                }
+            }
+            if (m_telemetryPublisher) {
+                m_telemetryPublisher->publishFrame(frame, frameGpuProfileScopes, numGpuProfileScopes);
+            }
+            if (m_performanceSweeper) {
+                m_performanceSweeper->recordFrame(frame, frameGpuProfileScopes, numGpuProfileScopes);
+                if (m_performanceSweeper->isDone()) {
+                    m_performanceSweeper.reset();
+                    m_configManager->setValue(config::SettingBenchmarkSweep, 0, true);
+                }
+            }
+
+            m_recordedStats = m_stats;
+            std::copy_n(gpuProfileScopes, numGpuProfileScopes, m_recordedStats.gpuProfileScopes);
+            m_recordedStats.numGpuProfileScopes = numGpuProfileScopes;
+        }
+
+        // Hand the next shadow image that the GPU is done reading to the application. When all of them are still in
+        // use, the oldest one is handed out, and xrWaitSwapchainImage() waits for the GPU to be done with it.
+        uint32_t acquireShadowImage(SwapchainState& swapchainState) {
+            const auto& shadowImages = swapchainState.shadowImages;
+            const uint32_t count = (uint32_t)shadowImages.size();
+            uint32_t index = swapchainState.nextShadowIndex;
+            for (uint32_t i = 0; i < count; i++) {
+                const uint32_t candidate = (swapchainState.nextShadowIndex + i) % count;
+                if (m_graphicsDevice->isSubmissionCompleted(shadowImages[candidate].lastUseSerial) &&
+                    candidate != swapchainState.pendingShadowIndex) {
+                    index = candidate;
+                    break;
+                }
+            }
+            if (!m_graphicsDevice->isSubmissionCompleted(shadowImages[index].lastUseSerial)) {
+                TraceLoggingWrite(
+                    g_traceProvider, "ShadowImageBusy", TraceLoggingKeyword(TLK_Frame), TLArg(index, "Index"));
+            }
+
+            swapchainState.acquiredImageIndex = index;
+            swapchainState.nextShadowIndex = (index + 1) % count;
+            return index;
+        }
+
+        // Acquire the runtime image that receives the processing of the shadow image released by the application.
+        void acquireRuntimeImageForShadow(XrSwapchain swapchain, SwapchainState& swapchainState) {
+            if (!swapchainState.pendingShadowIndex) {
+                return;
+            }
+            auto& shadowImage = swapchainState.shadowImages[swapchainState.pendingShadowIndex.value()];
+            swapchainState.pendingShadowIndex.reset();
+
+            uint32_t index;
+            CHECK_XRCMD(OpenXrApi::xrAcquireSwapchainImage(swapchain, nullptr, &index));
+            XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+            waitInfo.timeout = XR_INFINITE_DURATION;
+            CHECK_XRCMD(OpenXrApi::xrWaitSwapchainImage(swapchain, &waitInfo));
+
+            TraceLoggingWrite(g_traceProvider,
+                              "AcquireRuntimeImageForShadow",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLPArg(swapchain, "Swapchain"),
+                              TLArg(index, "Index"));
+
+            swapchainState.images[index].appTexture = shadowImage.texture;
+            swapchainState.frameImageIndex = index;
+            swapchainState.delayedRelease = true;
+
+            // The processing of the image is recorded right after.
+            shadowImage.lastUseSerial = m_graphicsDevice->getSubmissionSerial();
+        }
+
+        // The per-frame statistics are the difference with the last recorded ones, including for the GPU profiler.
+        void resetRecordedStatistics() {
+            m_recordedStats = m_stats;
+            m_recordedStats.numGpuProfileScopes =
+                m_performanceCounters.gpuProfiler->query(m_recordedStats.gpuProfileScopes,
+                                                         (uint32_t)std::size(m_recordedStats.gpuProfileScopes),
+                                                         false /* reset */);
+        }
+
+        void startPerformanceSweep() {
+            menu::PerformanceSweepInfo info;
+            info.applicationName = m_applicationName;
+            const bool isD3D11 = m_graphicsDevice->getApi() == graphics::Api::D3D11;
+            info.sessionDescription = fmt::format("{} on {}, {}x{}, upscaling {} at {}%",
+                                                  isD3D11 ? "D3D11" : "D3D12",
+                                                  m_systemName,
+                                                  m_displayWidth,
+                                                  m_displayHeight,
+                                                  (int)m_upscaleMode,
+                                                  m_settingScaling);
+            info.displayPeriodUs = m_lastPredictedDisplayPeriod ? m_lastPredictedDisplayPeriod / 1000.0 : 1e6 / 90;
+            info.sweepVariableRateShading = m_variableRateShader != nullptr;
+            // Mip-map biasing is only applied along with upscaling (see updateConfiguration()).
+            info.sweepMipMapBias = m_upscaleMode != config::ScalingType::None;
+
+            const std::time_t now = std::time(nullptr);
+            char buf[1024];
+            std::strftime(buf, sizeof(buf), "_%Y%m%d_%H%M%S", std::localtime(&now));
+            std::string sanitizedName = m_applicationName;
+            std::replace(sanitizedName.begin(), sanitizedName.end(), '.', '_');
+            const auto reportFile = localAppData / "stats" / ("sweep_" + sanitizedName + buf + ".csv");
+
+            try {
+                m_performanceSweeper = menu::CreatePerformanceSweeper(m_configManager, reportFile, info);
+                resetRecordedStatistics();
+            } catch (std::exception& e) {
+                Log("Could not start benchmark sweep: %s\n", e.what());
+                m_configManager->setValue(config::SettingBenchmarkSweep, 0, true);
+            }
+        }
+
+        // Measure how old the view poses of the application are by the time the frame is submitted. With late latch,
+        // also locate the views again for the display time of the frame, and measure how far the head turned since.
+        void measurePoseAge(XrSession session, XrTime displayTime, const AppViewsLocate& appViews) {
+            using namespace DirectX;
+
+            const auto ageUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                                     appViews.timestamp)
+                                   .count();
+            m_stats.poseAgeUs += ageUs;
+            m_performanceCounters.numPoseAgeSamples++;
+
+            float errorDeg = 0.f;
+            if (m_configManager->getValue(config::SettingLateLatch)) {
+                XrViewLocateInfo info{XR_TYPE_VIEW_LOCATE_INFO, nullptr};
+                info.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+                info.displayTime = displayTime;
+                info.space = appViews.space;
+
+                XrViewState state{XR_TYPE_VIEW_STATE, nullptr};
+                XrView views[utilities::ViewCount] = {{XR_TYPE_VIEW, nullptr}, {XR_TYPE_VIEW, nullptr}};
+                uint32_t viewCountOutput;
+                if (XR_SUCCEEDED(OpenXrApi::xrLocateViews(
+                        session, &info, &state, utilities::ViewCount, &viewCountOutput, views)) &&
+                    Pose::IsPoseValid(state.viewStateFlags)) {
+                    for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                        const float dot =
+                            std::abs(XMVectorGetX(XMQuaternionDot(LoadXrQuaternion(views[eye].pose.orientation),
+                                                                  LoadXrQuaternion(appViews.orientations[eye]))));
+                        errorDeg += 2.f * std::acos(std::min(dot, 1.f)) * (float)(180 / M_PI) / utilities::ViewCount;
+                    }
+                    m_stats.poseErrorDeg += errorDeg;
+                    m_performanceCounters.numPoseErrorSamples++;
+                }
+            }
+
+            TraceLoggingWrite(g_traceProvider,
+                              "PoseAge",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLArg(ageUs, "AgeUs"),
+                              TLArg(errorDeg, "ErrorDeg"));
+        }
+
+        // Only forward the calls of the application that an active subsystem consumes.
+        void updateInterceptedCalls() {
+            if (!m_graphicsDevice->isEventsSupported()) {
+                return;
+            }
+
+            const bool isVariableRateShadingActive =
+                m_variableRateShader && m_configManager->peekEnumValue<config::VariableShadingRateType>(
+                                            config::SettingVRS) != config::VariableShadingRateType::None;
+
+            // The frame analyzer provides the eye hints to the other subsystems, and statistics for developers.
+            const bool isFrameAnalyzerActive =
+                m_frameAnalyzer &&
+                (isVariableRateShadingActive || m_hiddenAreaPrePass ||
+                 m_configManager->peekEnumValue<config::OverlayType>(config::SettingOverlayType) ==
+                     config::OverlayType::Developer);
+
+            // The samplers are only patched when upscaling.
+            const bool isMipMapBiasActive =
+                m_upscaleMode != config::ScalingType::None &&
+                m_configManager->peekEnumValue<config::MipMapBias>(config::SettingMipMapBias) !=
+                    config::MipMapBias::Off;
+
+            updateInterceptedCallsSubscription(m_interceptedCallsSubscriptions.variableRateShader,
+                                               isVariableRateShadingActive,
+                                               {graphics::InterceptedCall::SetRenderTargets});
+            updateInterceptedCallsSubscription(
+                m_interceptedCallsSubscriptions.frameAnalyzer,
+                isFrameAnalyzerActive,
+                {graphics::InterceptedCall::SetRenderTargets, graphics::InterceptedCall::CopyTexture});
+            updateInterceptedCallsSubscription(m_interceptedCallsSubscriptions.mipMapBias,
+                                               isMipMapBiasActive,
+                                               {graphics::InterceptedCall::SetSamplers});
+            updateInterceptedCallsSubscription(m_interceptedCallsSubscriptions.hiddenAreaPrePass,
+                                               !!m_hiddenAreaPrePass,
+                                               {graphics::InterceptedCall::ClearDepth});
+        }
+
+        void updateInterceptedCallsSubscription(bool& isSubscribed,
+                                                bool needsSubscription,
+                                                std::initializer_list<graphics::InterceptedCall> calls) {
+            if (isSubscribed == needsSubscription) {
+                return;
+            }
+
+            for (const auto call : calls) {
+                if (needsSubscription) {
+                    m_graphicsDevice->subscribeInterceptedCall(call);
+                } else {
+                    m_graphicsDevice->unsubscribeInterceptedCall(call);
+                }
+            }
+            isSubscribed = needsSubscription;
+        }
+
         void updateConfiguration() {
             // Make sure config gets written if needed.
             m_configManager->tick();
@@ -2437,7 +3589,8 @@ namespace {
             // Adjust mip map biasing.
             if ((m_upscaleMode == config::ScalingType::NIS ||
                  m_upscaleMode == config::ScalingType::FSR ||
-                 m_upscaleMode == config::ScalingType::CAS
+                 m_upscaleMode == config::ScalingType::CAS ||
+                 m_upscaleMode == config::ScalingType::Temporal
                 ) &&
                 m_configManager->hasChanged(config::SettingMipMapBias)) {
                 m_graphicsDevice->setMipMapBias(
@@ -2445,6 +3598,8 @@ namespace {
                     m_mipMapBiasForUpscaling);
             }
 
+            updateInterceptedCalls();
+
             // Update HAM.
             if (m_configManager->hasChanged(config::SettingDisableHAM) ||
                 m_configManager->hasChanged(config::SettingBlindEye)) {
@@ -2484,6 +3639,17 @@ namespace {
             if (m_variableRateShader) {
                 m_variableRateShader->update();
             }
+
+            // Foveated upscaling: the upscaler runs its full kernel within the inner ring of the VRS pattern only.
+            if (m_upscaler) {
+                const bool isFoveated =
+                    m_variableRateShader && m_configManager->getValue(config::SettingFoveatedUpscaling);
+                for (uint32_t eye = 0; eye <= utilities::ViewCount; eye++) {
+                    m_upscaler->setFoveatedRegion(
+                        (utilities::Eye)eye,
+                        isFoveated ? m_variableRateShader->getFoveatedRegion((utilities::Eye)eye) : std::nullopt);
+                }
+            }
         }
 
         void takeScreenshot(std::shared_ptr<graphics::ITexture> texture,
@@ -2508,10 +3674,11 @@ namespace {
 
             if (m_upscaleMode != config::ScalingType::None) {
                 // TODO: add a getUpscaleModeName() helper to keep enum and string in sync.
-                const auto upscaleName = m_upscaleMode == config::ScalingType::NIS   ? "_NIS_"
-                                         : m_upscaleMode == config::ScalingType::FSR ? "_FSR_"
-                                         : m_upscaleMode == config::ScalingType::CAS ? "_CAS_"
-                                                                                     : "_SCL_";
+                const auto upscaleName = m_upscaleMode == config::ScalingType::NIS        ? "_NIS_"
+                                         : m_upscaleMode == config::ScalingType::FSR      ? "_FSR_"
+                                         : m_upscaleMode == config::ScalingType::CAS      ? "_CAS_"
+                                         : m_upscaleMode == config::ScalingType::Temporal ? "_TMP_"
+                                                                                          : "_SCL_";
                 parameters << upscaleName << m_settingScaling << "_"
                            << m_configManager->getValue(config::SettingSharpness);
             }
@@ -2533,9 +3700,16 @@ namespace {
 
             // Handle VPRT.
             auto info = texture->getInfo();
+            const auto srcSlice = (info.arraySize > 1 && suffix == "R") ? 1 : 0;
+
+            // Prefer the asynchronous capture, which does not stall the frame.
+            if (m_screenshotCapture->isFormatSupported(info.format)) {
+                m_screenshotCapture->capture(texture, viewport, srcSlice, path);
+                return;
+            }
+
             if (info.arraySize > 1 || viewport.offset.x || viewport.offset.y || info.width != viewport.extent.width ||
                 info.height != viewport.extent.height) {
-                const auto srcSlice = (info.arraySize > 1 && suffix == "R") ? 1 : 0;
                 info.arraySize = 1;
                 info.width = viewport.extent.width;
                 info.height = viewport.extent.height;
@@ -2554,6 +3728,7 @@ namespace {
 
             TraceLoggingWrite(g_traceProvider,
                               "xrEndFrame",
+                              TraceLoggingKeyword(TLK_Frame),
                               TLPArg(session, "Session"),
                               TLArg(frameEndInfo->displayTime, "DisplayTime"),
                               TLArg(xr::ToCString(frameEndInfo->environmentBlendMode), "EnvironmentBlendMode"));
@@ -2562,6 +3737,11 @@ namespace {
                 return OpenXrApi::xrEndFrame(session, frameEndInfo);
             }
 
+            const XrTime endFrameTime = m_hasPerformanceCounterKHR ? getTimeNow() : 0;
+
+            // We can only identify the application's render thread from here.
+            utilities::RegisterAppRenderThread();
+
             std::unique_lock lock(m_frameLock);
 
             m_isInFrame = false;
@@ -2570,14 +3750,55 @@ namespace {
 
             m_performanceCounters.renderCpuTimer->stop();
             m_stats.renderCpuTimeUs += m_performanceCounters.renderCpuTimer->query();
-            m_performanceCounters.appGpuTimer[m_performanceCounters.gpuTimerIndex]->stop();
+            m_performanceCounters.gpuTimers->stop(graphics::GpuPass::App);
 
             m_stats.endFrameCpuTimeUs += m_performanceCounters.endFrameCpuTimer->query();
             m_performanceCounters.endFrameCpuTimer->start();
 
-            // Toggle to the next set of GPU timers.
-            m_performanceCounters.gpuTimerIndex = (m_performanceCounters.gpuTimerIndex + 1) % (GpuTimerLatency + 1);
+            // Only measure the poses once, in case the application does not locate the views for every frame.
+            std::optional<AppViewsLocate> appViews;
+            {
+                std::unique_lock waitLock(m_waitLock);
+                appViews = std::exchange(m_lastAppViewsLocate, std::nullopt);
+            }
+            if (appViews) {
+                measurePoseAge(session, frameEndInfo->displayTime, appViews.value());
+            }
+
+            // Measure the latency of the frame to tune the prediction dampening.
+            if (m_configManager->getValue(config::SettingPredictionDampenAuto)) {
+                const FrameContext frame = getBegunFrame();
+                if (frame.waitedTime) {
+                    XrTime displayPeriod;
+                    {
+                        std::unique_lock waitLock(m_waitLock);
+                        displayPeriod = m_lastPredictedDisplayPeriod;
+                    }
+                    m_predictionDampeningTuner.addSample(frame.runtimeDisplayTime - frame.waitedTime,
+                                                         getTimeNow() + displayPeriod - frame.waitedTime);
+                }
+            }
+
+            // Collect the GPU timers that have completed, regardless of how many frames are in-flight.
             m_graphicsDevice->resolveQueries();
+            {
+                auto& gpuTimers = *m_performanceCounters.gpuTimers;
+                gpuTimers.poll();
+                m_stats.appGpuTimeUs += gpuTimers.query(graphics::GpuPass::App);
+                m_stats.variableRateShadingGpuTimeUs += gpuTimers.query(graphics::GpuPass::VariableRateShading);
+                m_stats.processorGpuTimeUs[0] += gpuTimers.query(graphics::GpuPass::Upscaling);
+                m_stats.processorGpuTimeUs[1] += gpuTimers.query(graphics::GpuPass::PostProcessing);
+                m_stats.overlayGpuTimeUs += gpuTimers.query(graphics::GpuPass::Overlay);
+                m_stats.handTrackingGpuTimeUs += gpuTimers.query(graphics::GpuPass::HandTracking);
+                m_performanceCounters.gpuProfiler->poll();
+
+                if (m_dynamicResolution) {
+                    m_dynamicResolution->update(gpuTimers.getLastDuration(graphics::GpuPass::App),
+                                                m_lastPredictedDisplayPeriod);
+                    m_variableRateShader->setDynamicRateBias(m_dynamicResolution->getLevel());
+                    m_stats.dynamicResolutionLevel = m_dynamicResolution->getLevel();
+                }
+            }
 
             if (m_frameAnalyzer) {
                 m_frameAnalyzer->prepareForEndFrame();
@@ -2595,7 +3816,7 @@ namespace {
                 m_variableRateShader->stopCapture();
             }
 
-            m_graphicsDevice->saveContext();
+            m_frameScheduler->beginFrame();
 
             // Handle inputs.
             if (m_menuHandler) {
@@ -2623,13 +3844,18 @@ namespace {
             // Because the frame info is passed const, we are going to need to reconstruct a writable version of it
             // to patch the resolution.
             XrFrameEndInfo chainFrameEndInfo = *frameEndInfo;
-            std::vector<const XrCompositionLayerBaseHeader*> correctedLayers;
-
-            std::vector<XrCompositionLayerProjection> layerProjectionAllocator;
-            std::vector<std::array<XrCompositionLayerProjectionView, 2>> layerProjectionViewsAllocator;
             XrCompositionLayerQuad layerQuadForMenu{XR_TYPE_COMPOSITION_LAYER_QUAD};
 
-            // We must reserve the underlying storage to keep our pointers stable.
+            // The storage is reused from frame to frame, and only grows with the maximum layer count seen.
+            auto& correctedLayers = m_correctedLayers;
+            auto& layerProjectionAllocator = m_layerProjectionAllocator;
+            auto& layerProjectionViewsAllocator = m_layerProjectionViewsAllocator;
+            correctedLayers.clear();
+            layerProjectionAllocator.clear();
+            layerProjectionViewsAllocator.clear();
+
+            // We must reserve the underlying storage to keep our pointers stable. We may add the menu layer.
+            correctedLayers.reserve(chainFrameEndInfo.layerCount + 1);
             layerProjectionAllocator.reserve(chainFrameEndInfo.layerCount);
             layerProjectionViewsAllocator.reserve(chainFrameEndInfo.layerCount);
 
@@ -2641,6 +3867,7 @@ namespace {
 
                     TraceLoggingWrite(g_traceProvider,
                                       "xrEndFrame_Layer",
+                                      TraceLoggingKeyword(TLK_Frame),
                                       TLArg("Proj", "Type"),
                                       TLArg(proj->layerFlags, "Flags"),
                                       TLPArg(proj->space, "Space"));
@@ -2668,12 +3895,19 @@ namespace {
                             m_stats.hasColorBuffer[(int)utilities::Eye::Right] = true;
                     }
 
+                    // Stereo mode: with texture arrays, both eyes can be upscaled in a single pass once the last eye
+                    // has been visited.
+                    const bool useStereoDispatch = useTextureArrays && m_upscaler && m_upscaler->isStereoSupported();
+                    std::array<graphics::TextureRegion, utilities::ViewCount> stereoInputRegions;
+                    std::array<graphics::TextureRegion, utilities::ViewCount> stereoOutputRegions;
+
                     assert(proj->viewCount == utilities::ViewCount);
                     for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
                         const XrCompositionLayerProjectionView& view = proj->views[eye];
 
                         TraceLoggingWrite(g_traceProvider,
                                           "xrEndFrame_View",
+                                          TraceLoggingKeyword(TLK_Frame),
                                           TLArg("Proj", "Type"),
                                           TLArg(eye, "Index"),
                                           TLPArg(proj->views[eye].subImage.swapchain, "Swapchain"),
@@ -2687,11 +3921,15 @@ namespace {
                             throw std::runtime_error("Swapchain is not registered");
                         }
                         auto& swapchainState = swapchainIt->second;
-                        auto& swapchainImages = swapchainState.images[swapchainState.acquiredImageIndex];
+                        acquireRuntimeImageForShadow(view.subImage.swapchain, swapchainState);
+                        auto& swapchainImages = swapchainState.images[swapchainState.frameImageIndex];
 
                         // Look for the depth buffer.
-                        std::shared_ptr<graphics::ITexture> depthBuffer;
+                        auto& depthBuffer = depthForOverlay[eye];
+                        depthBuffer.reset();
+                        graphics::TextureRegion depthRegion{};
                         NearFar nearFar{0.001f, 100.f};
+                        const XrCompositionLayerDepthInfoKHR* depthInfo = nullptr;
                         const XrBaseInStructure* entry = reinterpret_cast<const XrBaseInStructure*>(view.next);
                         while (entry) {
                             if (entry->type == XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR) {
@@ -2700,6 +3938,7 @@ namespace {
 
                                 TraceLoggingWrite(g_traceProvider,
                                                   "xrEndFrame_View",
+                                                  TraceLoggingKeyword(TLK_Frame),
                                                   TLArg("Depth", "Type"),
                                                   TLArg(eye, "Index"),
                                                   TLPArg(depth->subImage.swapchain, "Swapchain"),
@@ -2719,9 +3958,11 @@ namespace {
                                     auto& depthSwapchainState = depthSwapchainIt->second;
 
                                     depthBuffer =
-                                        depthSwapchainState.images[depthSwapchainState.acquiredImageIndex].appTexture;
+                                        depthSwapchainState.images[depthSwapchainState.frameImageIndex].appTexture;
+                                    depthRegion = {depth->subImage.imageRect, (int32_t)depth->subImage.imageArrayIndex};
                                     nearFar.Near = depth->nearZ;
                                     nearFar.Far = depth->farZ;
+                                    depthInfo = depth;
 
                                     m_stats.hasDepthBuffer[eye] = true;
                                 }
@@ -2737,9 +3978,16 @@ namespace {
                         // is texture 1. I'm sure this holds in like 99% of the applications, but still not very clean
                         // to assume.
                         if (m_frameAnalyzer && !useTextureArrays && !swapchainState.registeredWithFrameAnalyzer) {
-                            for (const auto& image : swapchainState.images) {
-                                m_frameAnalyzer->registerColorSwapchainImage(
-                                    view.subImage.swapchain, image.appTexture, (utilities::Eye)eye);
+                            if (swapchainState.shadowImages.empty()) {
+                                for (const auto& image : swapchainState.images) {
+                                    m_frameAnalyzer->registerColorSwapchainImage(
+                                        view.subImage.swapchain, image.appTexture, (utilities::Eye)eye);
+                                }
+                            } else {
+                                for (const auto& image : swapchainState.shadowImages) {
+                                    m_frameAnalyzer->registerColorSwapchainImage(
+                                        view.subImage.swapchain, image.texture, (utilities::Eye)eye);
+                                }
                             }
                             swapchainState.registeredWithFrameAnalyzer = true;
                         }
@@ -2750,10 +3998,23 @@ namespace {
                             view.subImage.imageRect.offset.y ||
                             view.subImage.imageRect.extent.width != swapchainImages.appTexture->getInfo().width ||
                             view.subImage.imageRect.extent.height != swapchainImages.appTexture->getInfo().height ||
-                            m_configManager->getValue("force_vprt_path");
+                            m_configManager->getValue(config::SettingForceVPRTPath);
+
+                        // Analyze the content of the view for the next frames.
+                        if (m_variableRateShader) {
+                            m_variableRateShader->updateContentHints(
+                                swapchainImages.appTexture,
+                                {view.subImage.imageRect, (int32_t)view.subImage.imageArrayIndex},
+                                (utilities::Eye)eye);
+                            if (depthBuffer) {
+                                m_variableRateShader->updateDepthHints(
+                                    depthBuffer, depthRegion, *depthInfo, (utilities::Eye)eye);
+                            }
+                        }
 
-                        std::shared_ptr<graphics::ITexture> nextInput = swapchainImages.appTexture;
-                        std::shared_ptr<graphics::ITexture> finalOutput = swapchainImages.runtimeTexture;
+                        // Refer to the textures held by the swapchain state, to avoid reference counting.
+                        const std::shared_ptr<graphics::ITexture>* nextInput = &swapchainImages.appTexture;
+                        const std::shared_ptr<graphics::ITexture>& finalOutput = swapchainImages.runtimeTexture;
 
                         float horizontalScaleFactor = 1.f;
                         float verticalScaleFactor = 1.f;
@@ -2762,46 +4023,35 @@ namespace {
                         if (m_upscaleMode == config::ScalingType::NIS 
                             || m_upscaleMode == config::ScalingType::FSR
                             || m_upscaleMode == config::ScalingType::CAS
+                            || m_upscaleMode == config::ScalingType::Temporal
                         ) {
                             std::tie(horizontalScaleFactor, verticalScaleFactor) =
                                 config::GetScalingFactors(m_settingScaling, m_settingAnamorphic);
 
+                            // The reduced eye is upscaled to the same output resolution as the other eye.
+                            if (swapchainState.isReducedEye) {
+                                horizontalScaleFactor = (float)swapchainImages.runtimeTexture->getInfo().width /
+                                                        swapchainImages.appTexture->getInfo().width;
+                                verticalScaleFactor = (float)swapchainImages.runtimeTexture->getInfo().height /
+                                                      swapchainImages.appTexture->getInfo().height;
+                            }
+
                             scaledOutputWidth = roundUp(
                                 (uint32_t)std::ceil(view.subImage.imageRect.extent.width * horizontalScaleFactor), 2);
                             scaledOutputHeight = roundUp(
                                 (uint32_t)std::ceil(view.subImage.imageRect.extent.height * verticalScaleFactor), 2);
                         }
 
-                        // Copy the VPRT app input into an intermediate buffer if needed.
-                        // TODO: This is a naive solution to uniformely support the same time of input/output for all
-                        // upscalers and post-processor.
+                        // With VPRT, the upscaler/post-processor read directly from the sub-rect/array slice of the
+                        // app swapchain and write directly into the sub-rect/array slice of the runtime swapchain.
+                        std::optional<graphics::TextureRegion> inputRegion;
+                        std::optional<graphics::TextureRegion> outputRegion;
                         if (isVPRT) {
-                            if (!swapchainState.nonVPRTInputTexture ||
-                                view.subImage.imageRect.extent.width !=
-                                    swapchainState.nonVPRTInputTexture->getInfo().width ||
-                                view.subImage.imageRect.extent.height !=
-                                    swapchainState.nonVPRTInputTexture->getInfo().height) {
-                                auto createInfo = swapchainImages.appTexture->getInfo();
-
-                                // Single-surface, full (input) screen.
-                                createInfo.arraySize = 1;
-                                createInfo.width = view.subImage.imageRect.extent.width;
-                                createInfo.height = view.subImage.imageRect.extent.height;
-                                createInfo.mipCount = 1;
-
-                                // Will be copied to from the app swapchain. Then both upscaler or post-processor will
-                                // sample.
-                                createInfo.usageFlags =
-                                    XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
-
-                                swapchainState.nonVPRTInputTexture =
-                                    m_graphicsDevice->createTexture(createInfo, "Non-VPRT Input TEX2D");
-                            }
-
                             // Patch the top-left corner offset.
                             if (m_upscaleMode == config::ScalingType::NIS ||
                                 m_upscaleMode == config::ScalingType::FSR ||
-                                m_upscaleMode == config::ScalingType::CAS    
+                                m_upscaleMode == config::ScalingType::CAS ||
+                                m_upscaleMode == config::ScalingType::Temporal
                             ) {
                                 correctedProjectionViews[eye].subImage.imageRect.offset.x = (uint32_t)std::ceil(
                                     correctedProjectionViews[eye].subImage.imageRect.offset.x * horizontalScaleFactor);
@@ -2821,97 +4071,135 @@ namespace {
                                                      correctedProjectionViews[eye].subImage.imageRect.offset.y;
                             }
 
-                            if (!swapchainState.nonVPRTOutputTexture ||
-                                scaledOutputWidth != swapchainState.nonVPRTOutputTexture->getInfo().width ||
-                                scaledOutputHeight != swapchainState.nonVPRTOutputTexture->getInfo().height) {
-                                auto createInfo = swapchainImages.appTexture->getInfo();
-
-                                // Single-surface, full (output) screen.
-                                createInfo.arraySize = 1;
-                                createInfo.width = scaledOutputWidth;
-                                createInfo.height = scaledOutputHeight;
-                                createInfo.mipCount = 1;
-
-                                // Post-processor will draw a full-screen quad. Then will be copied from into the
-                                // runtime swapchain.
-                                createInfo.usageFlags = XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT |
-                                                        XR_SWAPCHAIN_USAGE_SAMPLED_BIT |
-                                                        XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
-
-                                swapchainState.nonVPRTOutputTexture =
-                                    m_graphicsDevice->createTexture(createInfo, "Non-VPRT Output TEX2D");
-                            }
-
-                            swapchainImages.appTexture->copyTo(view.subImage.imageRect.offset.x,
-                                                               view.subImage.imageRect.offset.y,
-                                                               view.subImage.imageArrayIndex,
-                                                               swapchainState.nonVPRTInputTexture);
+                            inputRegion = {view.subImage.imageRect, (int32_t)view.subImage.imageArrayIndex};
+                            outputRegion = {{correctedProjectionViews[eye].subImage.imageRect.offset,
+                                             {(int32_t)scaledOutputWidth, (int32_t)scaledOutputHeight}},
+                                            (int32_t)view.subImage.imageArrayIndex};
+                        }
 
-                            nextInput = swapchainState.nonVPRTInputTexture;
-                            finalOutput = swapchainState.nonVPRTOutputTexture;
+                        // Fused mode: perform the post-processing at the end of the upscaling, writing directly to
+                        // the final output.
+                        // When the post-processing does not change the image, the upscaler writes directly to the
+                        // final output without it.
+                        const bool isPostProcessIdentity = m_postProcessor->isIdentity();
+                        std::shared_ptr<graphics::ITexture> aliasedInput;
+                        std::shared_ptr<graphics::ITexture> aliasedOutput;
+                        const bool isDirectUpscale =
+                            !useStereoDispatch && m_upscaler && isPostProcessIdentity &&
+                            (canWriteDirectly(finalOutput) ||
+                             getUnormAliases(swapchainImages, aliasedInput, aliasedOutput));
+                        std::shared_ptr<graphics::IShaderBuffer> fusedPostProcess;
+                        if (!useStereoDispatch && m_isFusedPostProcess && !isPostProcessIdentity &&
+                            canWriteDirectly(finalOutput)) {
+                            fusedPostProcess =
+                                m_postProcessor->getFusedPostProcessConstants(swapchainState.postProcessorBuffers,
+                                                                              swapchainState.postProcessorBlob,
+                                                                              (utilities::Eye)eye);
                         }
 
-                        // Perform upscaling.
+                        // Temporal mode: the history is reprojected with the view and depth buffer of the application.
                         if (m_upscaler) {
-                            if (!swapchainState.upscaledTexture ||
-                                scaledOutputWidth != swapchainState.upscaledTexture->getInfo().width ||
-                                scaledOutputHeight != swapchainState.upscaledTexture->getInfo().height) {
-                                auto createInfo = swapchainImages.appTexture->getInfo();
-
-                                // Single-surface, full (output) screen.
-                                createInfo.arraySize = 1;
-                                createInfo.width = scaledOutputWidth;
-                                createInfo.height = scaledOutputHeight;
-
-                                // Upscaler will write to as UAV. Then the post-processor will sample.
-                                createInfo.usageFlags =
-                                    XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
-
-                                if (m_graphicsDevice->isTextureFormatSRGB(createInfo.format)) {
-                                    // Good balance between visuals and performance.
-                                    createInfo.format =
-                                        m_graphicsDevice->getTextureFormat(graphics::TextureFormat::R10G10B10A2_UNORM);
-                                }
+                            m_upscaler->setTemporalView(
+                                (utilities::Eye)eye,
+                                graphics::TemporalViewInfo{{view.pose, view.fov, nearFar}, depthBuffer, depthRegion});
+                        }
 
-                                swapchainState.upscaledTexture =
-                                    m_graphicsDevice->createTexture(createInfo, "Upscaled TEX2D");
+                        // Perform upscaling.
+                        std::shared_ptr<graphics::ITexture> upscaledTexture;
+                        if (useStereoDispatch) {
+                            const auto sliceIndex = (int32_t)view.subImage.imageArrayIndex;
+                            stereoInputRegions[eye] =
+                                inputRegion.value_or(graphics::TextureRegion{getFullRect(*nextInput), sliceIndex});
+                            stereoOutputRegions[eye] =
+                                outputRegion.value_or(graphics::TextureRegion{getFullRect(finalOutput), sliceIndex});
+
+                            if (eye == utilities::ViewCount - 1) {
+                                processStereoViews(
+                                    swapchainState, swapchainImages, stereoInputRegions, stereoOutputRegions);
                             }
-
-                            auto timer = swapchainImages.upscalingTimers[eye].get();
-                            m_stats.processorGpuTimeUs[0] += timer->query();
-
-                            timer->start();
-                            m_upscaler->process(nextInput,
-                                                swapchainState.upscaledTexture,
-                                                swapchainState.upscalerTextures,
+                        } else if (m_upscaler && (fusedPostProcess || isDirectUpscale)) {
+                            const auto upscalerExtent =
+                                outputRegion ? outputRegion->rect.extent : getFullRect(finalOutput).extent;
+
+                            m_performanceCounters.gpuTimers->start(graphics::GpuPass::Upscaling);
+                            m_upscaler->process(aliasedInput ? aliasedInput : *nextInput,
+                                                aliasedOutput ? aliasedOutput : finalOutput,
+                                                getUpscalerTextures(swapchainState, upscalerExtent, 1),
+                                                swapchainState.upscalerBuffers,
                                                 swapchainState.upscalerBlob,
-                                                (utilities::Eye)eye);
-                            timer->stop();
+                                                (utilities::Eye)eye,
+                                                fusedPostProcess,
+                                                inputRegion,
+                                                outputRegion);
+                            m_performanceCounters.gpuTimers->stop(graphics::GpuPass::Upscaling);
+                        } else if (m_upscaler) {
+                            auto createInfo = swapchainImages.appTexture->getInfo();
+
+                            // Single-surface, full (output) screen.
+                            createInfo.arraySize = 1;
+                            createInfo.width = scaledOutputWidth;
+                            createInfo.height = scaledOutputHeight;
+
+                            // Upscaler will write to as UAV. Then the post-processor will sample.
+                            createInfo.usageFlags =
+                                XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+
+                            if (m_graphicsDevice->isTextureFormatSRGB(createInfo.format)) {
+                                // Good balance between visuals and performance.
+                                createInfo.format =
+                                    m_graphicsDevice->getTextureFormat(graphics::TextureFormat::R10G10B10A2_UNORM);
+                            }
 
-                            nextInput = swapchainState.upscaledTexture;
+                            // The upscaled texture is only needed until the post-processing, and can be shared with
+                            // the other swapchains.
+                            upscaledTexture = m_texturePool->acquire(createInfo, "Upscaled TEX2D");
+
+                            m_performanceCounters.gpuTimers->start(graphics::GpuPass::Upscaling);
+                            m_upscaler->process(*nextInput,
+                                                upscaledTexture,
+                                                getUpscalerTextures(
+                                                    swapchainState,
+                                                    {(int32_t)scaledOutputWidth, (int32_t)scaledOutputHeight},
+                                                    1),
+                                                swapchainState.upscalerBuffers,
+                                                swapchainState.upscalerBlob,
+                                                (utilities::Eye)eye,
+                                                nullptr,
+                                                inputRegion);
+                            m_performanceCounters.gpuTimers->stop(graphics::GpuPass::Upscaling);
+
+                            // The upscaled texture is a full surface.
+                            nextInput = &upscaledTexture;
+                            inputRegion.reset();
                         }
 
-                        // Do post-processing and color conversion.
-                        {
-                            auto timer = swapchainImages.postProcessingTimers[eye].get();
-                            m_stats.processorGpuTimeUs[1] += timer->query();
-
-                            timer->start();
-                            m_postProcessor->process(nextInput,
+                        // Do post-processing and color conversion. When the application rendered directly into the
+                        // final output, this is only needed if the image changes, reading from a copy.
+                        std::shared_ptr<graphics::ITexture> inputCopy;
+                        const bool isDirectOutput = *nextInput == finalOutput;
+                        if (isDirectOutput && !isPostProcessIdentity) {
+                            auto createInfo = finalOutput->getInfo();
+                            createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+                            inputCopy = m_texturePool->acquire(createInfo, "Post-process Input TEX2D");
+                            finalOutput->copyTo(inputCopy);
+                            nextInput = &inputCopy;
+                        }
+                        if (!useStereoDispatch && !fusedPostProcess && !isDirectUpscale &&
+                            (!isDirectOutput || inputCopy)) {
+                            m_performanceCounters.gpuTimers->start(graphics::GpuPass::PostProcessing);
+                            m_postProcessor->process(*nextInput,
                                                      finalOutput,
                                                      swapchainState.postProcessorTextures,
+                                                     swapchainState.postProcessorBuffers,
                                                      swapchainState.postProcessorBlob,
-                                                     (utilities::Eye)eye);
-                            timer->stop();
-                        }
-
-                        // Copy the output back into the VPRT runtime swapchain is needed.
-                        if (finalOutput != swapchainImages.runtimeTexture) {
-                            finalOutput->copyTo(swapchainImages.runtimeTexture,
-                                                correctedProjectionViews[eye].subImage.imageRect.offset.x,
-                                                correctedProjectionViews[eye].subImage.imageRect.offset.y,
-                                                view.subImage.imageArrayIndex);
+                                                     (utilities::Eye)eye,
+                                                     nullptr,
+                                                     inputRegion,
+                                                     outputRegion);
+                            m_performanceCounters.gpuTimers->stop(graphics::GpuPass::PostProcessing);
                         }
+                        m_texturePool->release(std::move(upscaledTexture));
+                        m_texturePool->release(std::move(inputCopy));
 
                         // Patch the resolution.
                         correctedProjectionViews[eye].subImage.imageRect.extent.width = scaledOutputWidth;
@@ -2919,10 +4207,9 @@ namespace {
 
                         textureForOverlay[eye] = swapchainImages.runtimeTexture;
                         sliceForOverlay[eye] = view.subImage.imageArrayIndex;
-                        depthForOverlay[eye] = depthBuffer;
 
                         // Patch the eye poses.
-                        if (m_configManager->getValue("canting")) {
+                        if (m_configManager->getValue(config::SettingCanting)) {
                             correctedProjectionViews[eye].pose = m_posesForFrame[eye].pose;
                         }
 
@@ -2966,17 +4253,21 @@ namespace {
 
                     spaceForOverlay = proj->space;
 
-                    for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
-                        TraceLoggingWrite(
-                            g_traceProvider,
-                            "CorrectedView",
-                            TLArg("Proj", "Type"),
-                            TLArg(eye, "Index"),
-                            TLPArg(correctedProjectionViews[eye].subImage.swapchain, "Swapchain"),
-                            TLArg(correctedProjectionViews[eye].subImage.imageArrayIndex, "ImageArrayIndex"),
-                            TLArg(xr::ToString(correctedProjectionViews[eye].subImage.imageRect).c_str(), "ImageRect"),
-                            TLArg(xr::ToString(correctedProjectionViews[eye].pose).c_str(), "Pose"),
-                            TLArg(xr::ToString(correctedProjectionViews[eye].fov).c_str(), "Fov"));
+                    if (IsTraceKeywordEnabled(TLK_Frame)) {
+                        for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                            const auto& correctedView = correctedProjectionViews[eye];
+                            TraceLoggingWrite(g_traceProvider,
+                                              "CorrectedView",
+                                              TraceLoggingKeyword(TLK_Frame),
+                                              TLArg("Proj", "Type"),
+                                              TLArg(eye, "Index"),
+                                              TLPArg(correctedView.subImage.swapchain, "Swapchain"),
+                                              TLArg(correctedView.subImage.imageArrayIndex, "ImageArrayIndex"),
+                                              TLArg(xr::ToString(correctedView.subImage.imageRect).c_str(),
+                                                    "ImageRect"),
+                                              TLArg(xr::ToString(correctedView.pose).c_str(), "Pose"),
+                                              TLArg(xr::ToString(correctedView.fov).c_str(), "Fov"));
+                        }
                     }
 
                     correctedProjectionLayer->views = correctedProjectionViews;
@@ -2988,11 +4279,13 @@ namespace {
 
                     TraceLoggingWrite(g_traceProvider,
                                       "xrEndFrame_Layer",
+                                      TraceLoggingKeyword(TLK_Frame),
                                       TLArg("Quad", "Type"),
                                       TLArg(quad->layerFlags, "Flags"),
                                       TLPArg(quad->space, "Space"));
                     TraceLoggingWrite(g_traceProvider,
                                       "xrEndFrame_View",
+                                      TraceLoggingKeyword(TLK_Frame),
                                       TLArg("Quad", "Type"),
                                       TLPArg(quad->subImage.swapchain, "Swapchain"),
                                       TLArg(quad->subImage.imageArrayIndex, "ImageArrayIndex"),
@@ -3008,7 +4301,8 @@ namespace {
                     }
 
                     auto& swapchainState = swapchainIt->second;
-                    auto& swapchainImages = swapchainState.images[swapchainState.acquiredImageIndex];
+                    acquireRuntimeImageForShadow(quad->subImage.swapchain, swapchainState);
+                    auto& swapchainImages = swapchainState.images[swapchainState.frameImageIndex];
 
                     if (swapchainImages.appTexture != swapchainImages.runtimeTexture) {
                         swapchainImages.appTexture->copyTo(swapchainImages.runtimeTexture);
@@ -3032,11 +4326,10 @@ namespace {
                 const bool drawEyeGaze = m_eyeTracker && m_configManager->getValue(config::SettingEyeDebug);
 
                 m_stats.overlayCpuTimeUs += m_performanceCounters.overlayCpuTimer->query();
-                m_stats.overlayGpuTimeUs +=
-                    m_performanceCounters.overlayGpuTimer[m_performanceCounters.gpuTimerIndex]->query();
 
                 m_performanceCounters.overlayCpuTimer->start();
-                m_performanceCounters.overlayGpuTimer[m_performanceCounters.gpuTimerIndex]->start();
+                m_performanceCounters.gpuTimers->start(graphics::GpuPass::Overlay);
+                m_graphicsDevice->beginProfileScope("Overlay");
 
                 if (textureForOverlay[0]) {
                     const bool useTextureArrays =
@@ -3044,8 +4337,11 @@ namespace {
 
                     // Render the hands or eye gaze helper.
                     if (drawHands || drawEyeGaze) {
-                        TraceLoggingWrite(
-                            g_traceProvider, "StampOverlays", TLArg(drawHands, "Hands"), TLArg(drawEyeGaze, "EyeGaze"));
+                        TraceLoggingWrite(g_traceProvider,
+                                          "StampOverlays",
+                                          TraceLoggingKeyword(TLK_Frame),
+                                          TLArg(drawHands, "Hands"),
+                                          TLArg(drawEyeGaze, "EyeGaze"));
 
                         auto isEyeGazeValid = m_eyeTracker && m_eyeTracker->getProjectedGaze(m_eyeGaze);
                         const bool doHandOcclusion = m_configManager->getValue(config::SettingHandOcclusion);
@@ -3062,8 +4358,11 @@ namespace {
                             m_graphicsDevice->setViewProjection(viewForOverlay[eye]);
 
                             if (drawHands) {
+                                // The hands are measured separately, but they are also part of the overlay time.
+                                m_performanceCounters.gpuTimers->start(graphics::GpuPass::HandTracking);
                                 m_handTracker->render(
                                     viewForOverlay[eye].Pose, spaceForOverlay, getTimeNow(), textureForOverlay[eye]);
+                                m_performanceCounters.gpuTimers->stop(graphics::GpuPass::HandTracking);
                             }
 
                             if (drawEyeGaze) {
@@ -3084,7 +4383,7 @@ namespace {
                 if (m_menuHandler) {
                     if (!m_configManager->getValue(config::SettingMenuLegacyMode) && !m_configManager->isSafeMode()) {
                         if (m_menuHandler->isVisible() || m_menuLingering) {
-                            TraceLoggingWrite(g_traceProvider, "OverlayMenu");
+                            TraceLoggingWrite(g_traceProvider, "OverlayMenu", TraceLoggingKeyword(TLK_Frame));
 
                             // Workaround: there is a bug in the WMR runtime that causes a past quad layer content
                             // to linger on the next projection layer. We make sure to submit a completely blank
@@ -3092,29 +4391,35 @@ namespace {
                             // of depth buffers cached inside the precompositor of the WMR runtime.
                             m_menuLingering = m_menuHandler->isVisible() ? 3 : m_menuLingering - 1;
 
-                            uint32_t menuImageIndex;
-                            {
-                                XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
-                                CHECK_XRCMD(
-                                    OpenXrApi::xrAcquireSwapchainImage(m_menuSwapchain, &acquireInfo, &menuImageIndex));
+                            const auto& textureInfo = m_menuSwapchainImages[0]->getInfo();
 
-                                XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
-                                waitInfo.timeout = XR_INFINITE_DURATION;
-                                CHECK_XRCMD(OpenXrApi::xrWaitSwapchainImage(m_menuSwapchain, &waitInfo));
-                            }
+                            // Only render the menu when its content has changed. Otherwise, we submit the swapchain
+                            // without acquiring a new image, and the runtime reuses the last image we released.
+                            if (!m_menuSwapchainHasContent || m_menuHandler->isDirty()) {
+                                uint32_t menuImageIndex;
+                                {
+                                    XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+                                    CHECK_XRCMD(OpenXrApi::xrAcquireSwapchainImage(
+                                        m_menuSwapchain, &acquireInfo, &menuImageIndex));
 
-                            const auto& textureInfo = m_menuSwapchainImages[menuImageIndex]->getInfo();
+                                    XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+                                    waitInfo.timeout = XR_INFINITE_DURATION;
+                                    CHECK_XRCMD(OpenXrApi::xrWaitSwapchainImage(m_menuSwapchain, &waitInfo));
+                                }
 
-                            m_graphicsDevice->setRenderTargets(1, &m_menuSwapchainImages[menuImageIndex]);
-                            m_graphicsDevice->beginText();
-                            m_graphicsDevice->clearColor(
-                                0, 0, (float)textureInfo.height, (float)textureInfo.width, XrColor4f{0, 0, 0, 0});
-                            m_menuHandler->render(m_menuSwapchainImages[menuImageIndex]);
-                            m_graphicsDevice->flushText();
+                                m_graphicsDevice->setRenderTargets(1, &m_menuSwapchainImages[menuImageIndex]);
+                                m_graphicsDevice->beginText();
+                                m_graphicsDevice->clearColor(
+                                    0, 0, (float)textureInfo.height, (float)textureInfo.width, XrColor4f{0, 0, 0, 0});
+                                m_menuHandler->render(m_menuSwapchainImages[menuImageIndex]);
+                                m_menuHandler->clearDirty();
+                                m_graphicsDevice->flushText();
 
-                            m_graphicsDevice->unsetRenderTargets();
+                                m_graphicsDevice->unsetRenderTargets();
 
-                            needMenuSwapchainDelayedRelease = true;
+                                needMenuSwapchainDelayedRelease = true;
+                                m_menuSwapchainHasContent = true;
+                            }
 
                             // Add the quad layer to the frame.
                             layerQuadForMenu.space = m_viewSpace;
@@ -3136,12 +4441,14 @@ namespace {
 
                             TraceLoggingWrite(g_traceProvider,
                                               "xrEndFrame_Layer",
+                                              TraceLoggingKeyword(TLK_Frame),
                                               TLArg("Quad", "Type"),
                                               TLArg(layerQuadForMenu.layerFlags, "Flags"),
                                               TLPArg(layerQuadForMenu.space, "Space"));
                             TraceLoggingWrite(
                                 g_traceProvider,
                                 "xrEndFrame_View",
+                                TraceLoggingKeyword(TLK_Frame),
                                 TLArg("Quad", "Type"),
                                 TLPArg(layerQuadForMenu.subImage.swapchain, "Swapchain"),
                                 TLArg(layerQuadForMenu.subImage.imageArrayIndex, "ImageArrayIndex"),
@@ -3157,7 +4464,7 @@ namespace {
                     } else {
                         // Legacy menu mode, for people having problems.
                         if (textureForOverlay[0]) {
-                            TraceLoggingWrite(g_traceProvider, "StampMenu");
+                            TraceLoggingWrite(g_traceProvider, "StampMenu", TraceLoggingKeyword(TLK_Frame));
 
                             const bool useTextureArrays = textureForOverlay[1] == textureForOverlay[0] &&
                                                           sliceForOverlay[0] != sliceForOverlay[1];
@@ -3178,8 +4485,9 @@ namespace {
                     }
                 }
 
+                m_graphicsDevice->endProfileScope();
                 m_performanceCounters.overlayCpuTimer->stop();
-                m_performanceCounters.overlayGpuTimer[m_performanceCounters.gpuTimerIndex]->stop();
+                m_performanceCounters.gpuTimers->stop(graphics::GpuPass::Overlay);
             }
 
             // Whether the menu is available or not, we can still use that top-most texture for screenshot.
@@ -3199,18 +4507,24 @@ namespace {
                     takeScreenshot(textureForOverlay[1], "R", viewportForOverlay[1]);
                 }
 
-                if (m_variableRateShader && m_configManager->getValue("vrs_capture")) {
+                if (m_variableRateShader && m_configManager->getValue(config::SettingVRSCapture)) {
                     m_variableRateShader->startCapture();
                 }
             }
 
-            m_graphicsDevice->restoreContext();
-            m_graphicsDevice->flushContext(false, true);
+            // Hand the screenshots from the previous frames to the encoder once their readback has completed.
+            m_screenshotCapture->poll();
+
+            // Record the passes depending on the composition, and submit all our work for the frame at once.
+            m_frameScheduler->submitFrame();
 
             // Release the swapchain images now, as we are really done this time.
             for (auto& swapchain : m_swapchains) {
                 if (swapchain.second.delayedRelease) {
-                    TraceLoggingWrite(g_traceProvider, "DelayedSwapchainRelease", TLPArg(swapchain.first, "Swapchain"));
+                    TraceLoggingWrite(g_traceProvider,
+                                      "DelayedSwapchainRelease",
+                                      TraceLoggingKeyword(TLK_Frame),
+                                      TLPArg(swapchain.first, "Swapchain"));
 
                     XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
                     swapchain.second.delayedRelease = false;
@@ -3218,7 +4532,10 @@ namespace {
                 }
             }
             if (needMenuSwapchainDelayedRelease) {
-                TraceLoggingWrite(g_traceProvider, "MenuSwapchainRelease", TLPArg(m_menuSwapchain, "Swapchain"));
+                TraceLoggingWrite(g_traceProvider,
+                                  "MenuSwapchainRelease",
+                                  TraceLoggingKeyword(TLK_Frame),
+                                  TLPArg(m_menuSwapchain, "Swapchain"));
 
                 XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
                 CHECK_XRCMD(OpenXrApi::xrReleaseSwapchainImage(m_menuSwapchain, &releaseInfo));
@@ -3236,58 +4553,56 @@ namespace {
                     config::MotionReprojection::On;
             if (m_hasPerformanceCounterKHR && m_configManager->getValue(config::SettingPredictionDampen) != 100 &&
                 !isMotionReprojectionOn) {
-                chainFrameEndInfo.displayTime = m_savedFrameTime2;
+                chainFrameEndInfo.displayTime = getBegunFrame().runtimeDisplayTime;
             }
 #endif
 
             {
-                if (m_asyncWaitPromise.valid()) {
-                    TraceLocalActivity(local);
-
+                if (m_asyncWaiter && m_asyncWaiter->isActive()) {
                     // This is the latest point we must have fully waited a frame before proceeding.
                     //
                     // Note: we should not wait infinitely here, however certain patterns of engine calls may cause us
                     // to attempt a "double xrWaitFrame" when turning on Turbo. Use a timeout to detect that, and
-                    // refrain from enqueing a second wait further down. This isn't a pretty solution, but it is simple
-                    // and it seems to work effectively (minus the 1s freeze observed in-game).
-                    TraceLoggingWriteStart(local, "AsyncWaitNow");
-                    const auto ready = m_asyncWaitPromise.wait_for(1s) == std::future_status::ready;
-                    TraceLoggingWriteStop(local, "AsyncWaitNow", TLArg(ready, "Ready"));
-                    if (ready) {
-                        m_asyncWaitPromise = {};
+                    // refrain from enqueing a second wait further down (the wait remains in flight).
+                    if (m_asyncWaiter->wait(1s)) {
+                        const auto asyncFrameState = m_asyncWaiter->collect();
+                        m_isAsyncWaitActive = false;
+                        std::unique_lock waitLock(m_waitLock);
+                        if (asyncFrameState) {
+                            m_lastPredictedDisplayTime = asyncFrameState->predictedDisplayTime;
+                            m_lastPredictedDisplayPeriod = asyncFrameState->predictedDisplayPeriod;
+                        }
                     }
 
                     CHECK_XRCMD(OpenXrApi::xrBeginFrame(m_vrSession, nullptr));
                 }
 
+                const XrTime submitTime = m_hasPerformanceCounterKHR ? getTimeNow() : 0;
                 const auto result = OpenXrApi::xrEndFrame(session, &chainFrameEndInfo);
+                if (XR_SUCCEEDED(result) && submitTime) {
+                    updateLatencyForFrame(endFrameTime, submitTime);
+                }
+                recordStatisticsForFrame();
 
                 m_graphicsDevice->unblockCallbacks();
 
-                if (m_configManager->getValue(config::SettingTurboMode) && !m_asyncWaitPromise.valid()) {
-                    m_asyncWaitPolled = false;
-                    m_asyncWaitCompleted = false;
-
-                    // In Turbo mode, we kick off a wait thread immediately.
-                    TraceLoggingWrite(g_traceProvider, "AsyncWaitStart");
-                    m_asyncWaitPromise = std::async(std::launch::async, [&] {
-                        TraceLocalActivity(local);
-
-                        XrFrameState frameState{XR_TYPE_FRAME_STATE};
-                        TraceLoggingWriteStart(local, "AsyncWaitFrame");
-                        CHECK_XRCMD(OpenXrApi::xrWaitFrame(m_vrSession, nullptr, &frameState));
-                        TraceLoggingWriteStop(local,
-                                              "AsyncWaitFrame",
-                                              TLArg(frameState.predictedDisplayTime, "PredictedDisplayTime"),
-                                              TLArg(frameState.predictedDisplayPeriod, "PredictedDisplayPeriod"));
-                        {
-                            std::unique_lock lock(m_asyncWaitLock);
-                            m_lastPredictedDisplayTime = frameState.predictedDisplayTime;
-                            m_lastPredictedDisplayPeriod = frameState.predictedDisplayPeriod;
-
-                            m_asyncWaitCompleted = true;
-                        }
-                    });
+                if (m_configManager->getValue(config::SettingTurboMode) &&
+                    !(m_asyncWaiter && m_asyncWaiter->isActive())) {
+                    if (!m_asyncWaiter) {
+                        m_asyncWaiter = std::make_unique<AsyncFrameWaiter>([this](XrFrameState* frameState) {
+                            return OpenXrApi::xrWaitFrame(m_vrSession, nullptr, frameState);
+                        });
+                    }
+
+                    // In Turbo mode, we kick off a wait immediately. An engine pipelining its frames may already be
+                    // waiting for its next frame: Turbo Mode then only starts with the next frame.
+                    m_isAsyncWaitActive = true;
+                    if (!m_isAppWaitingOnRuntime) {
+                        TraceLoggingWrite(g_traceProvider, "AsyncWaitStart", TraceLoggingKeyword(TLK_Frame));
+                        m_asyncWaiter->kickoff();
+                    } else {
+                        m_isAsyncWaitActive = false;
+                    }
                 }
 
                 return result;
@@ -3299,6 +4614,213 @@ namespace {
             return systemId == m_vrSystemId;
         }
 
+        // The non-dominant eye may be rendered at a lower resolution than the other eye. This is only possible when
+        // upscaling, since the upscaler needs to bring that eye back to the display resolution. Without scaling, NIS,
+        // FSR and CAS are created sharpen-only and do not resize.
+        std::optional<utilities::Eye>
+        getReducedEyeSetting(config::ScalingType upscaleMode, int settingScaling, int settingAnamorphic) const {
+            if (upscaleMode != config::ScalingType::NIS && upscaleMode != config::ScalingType::FSR &&
+                upscaleMode != config::ScalingType::CAS && upscaleMode != config::ScalingType::Temporal) {
+                return {};
+            }
+            if (upscaleMode != config::ScalingType::Temporal && settingScaling == 100 && settingAnamorphic <= 0) {
+                return {};
+            }
+            if (m_configManager->peekValue(config::SettingReducedEyeScaling) >= 100) {
+                return {};
+            }
+
+            switch (m_configManager->peekEnumValue<config::BlindEye>(config::SettingReducedEye)) {
+            case config::BlindEye::Left:
+                return utilities::Eye::Left;
+            case config::BlindEye::Right:
+                return utilities::Eye::Right;
+            default:
+                return {};
+            }
+        }
+
+        static std::pair<uint32_t, uint32_t>
+        getReducedEyeDimensions(uint32_t inputWidth, uint32_t inputHeight, int settingReducedEyeScaling) {
+            const int scaling = std::clamp(settingReducedEyeScaling, 25, 100);
+            return std::make_pair(roundUp((uint32_t)std::ceil(inputWidth * scaling / 100.f), 2),
+                                  roundUp((uint32_t)std::ceil(inputHeight * scaling / 100.f), 2));
+        }
+
+        // Applications running close to the video memory budget may start paging because of our allocations. When the
+        // usage is over the budget, release what we can, starting with the allocations that are not in use.
+        void trimVideoMemory() {
+            if (!m_videoMemoryBudget || !m_videoMemoryBudget->isUnderPressure()) {
+                if (m_isVideoMemoryTrimmed) {
+                    Log("Video memory usage is back under budget\n");
+                    m_isVideoMemoryTrimmed = false;
+                }
+                return;
+            }
+
+            if (!m_isVideoMemoryTrimmed) {
+                Log("Video memory usage is over budget (%llu/%llu MB), releasing the unused resources\n",
+                    m_videoMemoryBudget->getUsage() / (1024 * 1024),
+                    m_videoMemoryBudget->getBudget() / (1024 * 1024));
+                m_isVideoMemoryTrimmed = true;
+            }
+            TraceLoggingWrite(g_traceProvider,
+                              "TrimVideoMemory",
+                              TLArg(m_videoMemoryBudget->getUsage(), "Usage"),
+                              TLArg(m_videoMemoryBudget->getBudget(), "Budget"));
+
+            // The intermediate textures and screenshot readbacks that were not needed lately.
+            if (m_texturePool) {
+                m_texturePool->trim();
+            }
+            if (m_screenshotCapture) {
+                m_screenshotCapture->trim();
+            }
+
+            // The VRS masks for the render target sizes that were not used in the last frame.
+            if (m_variableRateShader) {
+                m_variableRateShader->trim();
+            }
+        }
+
+        static XrRect2Di getFullRect(const std::shared_ptr<graphics::ITexture>& texture) {
+            return {{0, 0}, {(int32_t)texture->getInfo().width, (int32_t)texture->getInfo().height}};
+        }
+
+        // The intermediate textures of the upscaler only hold data during the upscaling pass. They are shared by all
+        // the swapchains with the same upscaler output size. The history of the temporal upscaler is per swapchain.
+        std::vector<std::shared_ptr<graphics::ITexture>>&
+        getUpscalerTextures(SwapchainState& swapchainState, const XrExtent2Di& extent, uint32_t arraySize) {
+            if (m_upscaleMode == config::ScalingType::Temporal) {
+                return swapchainState.upscalerHistoryTextures;
+            }
+            return m_upscalerTextures[std::make_tuple(extent.width, extent.height, arraySize)];
+        }
+
+        // Upscale and post-process both eyes of a texture array, with a single upscaler pass for both eyes.
+        void processStereoViews(SwapchainState& swapchainState,
+                                SwapchainImages& swapchainImages,
+                                const std::array<graphics::TextureRegion, utilities::ViewCount>& inputRegions,
+                                const std::array<graphics::TextureRegion, utilities::ViewCount>& outputRegions) {
+            const std::shared_ptr<graphics::ITexture>& finalOutput = swapchainImages.runtimeTexture;
+
+            // The fused post-processing uses the same constants for both eyes.
+            // When the post-processing does not change the image, the upscaler writes directly to the final output.
+            std::shared_ptr<graphics::ITexture> aliasedInput;
+            std::shared_ptr<graphics::ITexture> aliasedOutput;
+            const bool isDirectUpscale =
+                m_postProcessor->isIdentity() &&
+                (canWriteDirectly(finalOutput) || getUnormAliases(swapchainImages, aliasedInput, aliasedOutput));
+            std::shared_ptr<graphics::IShaderBuffer> fusedPostProcess;
+            if (m_isFusedPostProcess && !isDirectUpscale && canWriteDirectly(finalOutput)) {
+                fusedPostProcess = m_postProcessor->getFusedPostProcessConstants(swapchainState.postProcessorBuffers,
+                                                                                 swapchainState.postProcessorBlob,
+                                                                                 utilities::Eye::Both);
+            }
+
+            auto& gpuTimers = *m_performanceCounters.gpuTimers;
+
+            // The upscaled texture has one slice per eye, with the image at the origin.
+            std::array<graphics::TextureRegion, utilities::ViewCount> upscaledRegions;
+            XrExtent2Di upscaledExtent{0, 0};
+            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                upscaledRegions[eye] = {{{0, 0}, outputRegions[eye].rect.extent}, (int32_t)eye};
+                upscaledExtent.width = std::max(upscaledExtent.width, outputRegions[eye].rect.extent.width);
+                upscaledExtent.height = std::max(upscaledExtent.height, outputRegions[eye].rect.extent.height);
+            }
+
+            if (fusedPostProcess || isDirectUpscale) {
+                // A single measurement covers both eyes.
+                gpuTimers.start(graphics::GpuPass::Upscaling);
+                m_upscaler->processStereo(aliasedInput ? aliasedInput : swapchainImages.appTexture,
+                                          aliasedOutput ? aliasedOutput : finalOutput,
+                                          getUpscalerTextures(swapchainState, upscaledExtent, utilities::ViewCount),
+                                          swapchainState.upscalerBuffers,
+                                          swapchainState.upscalerBlob,
+                                          inputRegions,
+                                          outputRegions,
+                                          fusedPostProcess);
+                gpuTimers.stop(graphics::GpuPass::Upscaling);
+                return;
+            }
+
+            auto createInfo = swapchainImages.appTexture->getInfo();
+
+            // One surface per eye, full (output) screen.
+            createInfo.arraySize = utilities::ViewCount;
+            createInfo.width = upscaledExtent.width;
+            createInfo.height = upscaledExtent.height;
+
+            // Upscaler will write to as UAV. Then the post-processor will sample.
+            createInfo.usageFlags = XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+
+            if (m_graphicsDevice->isTextureFormatSRGB(createInfo.format)) {
+                // Good balance between visuals and performance.
+                createInfo.format = m_graphicsDevice->getTextureFormat(graphics::TextureFormat::R10G10B10A2_UNORM);
+            }
+
+            // The upscaled texture is only needed until the post-processing, and can be shared with the other
+            // swapchains.
+            auto upscaledTexture = m_texturePool->acquire(createInfo, "Upscaled Stereo TEX2D");
+
+            // A single measurement covers both eyes.
+            gpuTimers.start(graphics::GpuPass::Upscaling);
+            m_upscaler->processStereo(swapchainImages.appTexture,
+                                      upscaledTexture,
+                                      getUpscalerTextures(swapchainState, upscaledExtent, utilities::ViewCount),
+                                      swapchainState.upscalerBuffers,
+                                      swapchainState.upscalerBlob,
+                                      inputRegions,
+                                      upscaledRegions);
+            gpuTimers.stop(graphics::GpuPass::Upscaling);
+
+            // Do post-processing and color conversion.
+            for (uint32_t eye = 0; eye < utilities::ViewCount; eye++) {
+                gpuTimers.start(graphics::GpuPass::PostProcessing);
+                m_postProcessor->process(upscaledTexture,
+                                         finalOutput,
+                                         swapchainState.postProcessorTextures,
+                                         swapchainState.postProcessorBuffers,
+                                         swapchainState.postProcessorBlob,
+                                         (utilities::Eye)eye,
+                                         nullptr,
+                                         upscaledRegions[eye],
+                                         outputRegions[eye]);
+                gpuTimers.stop(graphics::GpuPass::PostProcessing);
+            }
+
+            m_texturePool->release(std::move(upscaledTexture));
+        }
+
+        // Whether an upscaler can write its output directly into the texture (as an UAV).
+        bool canWriteDirectly(const std::shared_ptr<graphics::ITexture>& output) const {
+            return (output->getInfo().usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) &&
+                   !m_graphicsDevice->isTextureFormatSRGB(output->getInfo().format);
+        }
+
+        // An sRGB output cannot be written as UAV, but when the app and runtime textures are both typeless, the
+        // upscaler can read and write the sRGB-encoded values through UNORM views, without the intermediate texture
+        // and the post-processing pass that converts it.
+        bool getUnormAliases(const SwapchainImages& swapchainImages,
+                             std::shared_ptr<graphics::ITexture>& input,
+                             std::shared_ptr<graphics::ITexture>& output) const {
+            const auto& finalOutput = swapchainImages.runtimeTexture;
+            if (!m_configManager->getValue(config::SettingSRGBAliasing) ||
+                !(finalOutput->getInfo().usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) ||
+                !m_graphicsDevice->isTextureFormatSRGB(finalOutput->getInfo().format)) {
+                return false;
+            }
+
+            input = swapchainImages.appTexture->getUnormAlias();
+            output = finalOutput->getUnormAlias();
+            if (!input || !output) {
+                input.reset();
+                output.reset();
+                return false;
+            }
+            return true;
+        }
+
         bool isVrSession(XrSession session) const {
             return session == m_vrSession;
         }
@@ -3316,9 +4838,51 @@ namespace {
             return str;
         }
 
+        // Record how old each step of the frame is at the display time predicted by the runtime.
+        void updateLatencyForFrame(XrTime endFrameTime, XrTime submitTime) {
+            const FrameContext frame = getBegunFrame();
+
+            XrTime renderTime = 0;
+            if (m_frameAnalyzer) {
+                const auto firstEyeRenderTime = m_frameAnalyzer->getFirstEyeRenderTime();
+                if (firstEyeRenderTime) {
+                    CHECK_XRCMD(xrConvertWin32PerformanceCounterToTimeKHR(
+                        GetXrInstance(), &firstEyeRenderTime.value(), &renderTime));
+                }
+            }
+
+            const auto getLatencyUs = [&](XrTime time) -> uint64_t {
+                return time ? std::max(frame.runtimeDisplayTime - time, XrTime(0)) / 1000 : 0;
+            };
+            m_stats.inputLatencyUs = getLatencyUs(frame.inputTime);
+            m_stats.waitLatencyUs = getLatencyUs(frame.waitedTime);
+            m_stats.beginLatencyUs = getLatencyUs(frame.begunTime);
+            m_stats.renderLatencyUs = getLatencyUs(renderTime);
+            m_stats.endFrameLatencyUs = getLatencyUs(endFrameTime);
+            m_stats.submitLatencyUs = getLatencyUs(submitTime);
+
+            TraceLoggingWrite(g_traceProvider,
+                              "FrameLatency",
+                              TraceLoggingKeyword(TLK_Frame),
+                              TLArg(frame.frameId, "FrameId"),
+                              TLArg(frame.runtimeDisplayTime, "DisplayTime"),
+                              TLArg(m_stats.inputLatencyUs, "InputLatencyUs"),
+                              TLArg(m_stats.waitLatencyUs, "WaitLatencyUs"),
+                              TLArg(m_stats.beginLatencyUs, "BeginLatencyUs"),
+                              TLArg(m_stats.renderLatencyUs, "RenderLatencyUs"),
+                              TLArg(m_stats.endFrameLatencyUs, "EndFrameLatencyUs"),
+                              TLArg(m_stats.submitLatencyUs, "SubmitLatencyUs"));
+        }
+
+        // The frame in between xrBeginFrame() and xrEndFrame().
+        FrameContext getBegunFrame() {
+            std::unique_lock waitLock(m_waitLock);
+            return m_frameContexts[m_begunFrameId % m_frameContexts.size()];
+        }
+
         // Find the current time. Fallback to the frame time if we cannot query the actual time.
         XrTime getTimeNow() {
-            XrTime xrTimeNow = m_begunFrameTime;
+            XrTime xrTimeNow = getBegunFrame().displayTime;
             if (m_hasPerformanceCounterKHR) {
                 LARGE_INTEGER qpcTimeNow;
                 QueryPerformanceCounter(&qpcTimeNow);
@@ -3407,11 +4971,22 @@ namespace {
         bool m_overrideParallelProjection{false};
 
         std::mutex m_frameLock;
-        XrTime m_waitedFrameTime;
-        XrTime m_begunFrameTime;
-        XrTime m_savedFrameTime1;
-        XrTime m_savedFrameTime2;
-        bool m_isInFrame{false};
+        std::atomic<bool> m_isInFrame{false};
+
+        // xrWaitFrame() does not take the frame lock outside of Turbo Mode. The frame contexts (indexed by frame ID)
+        // and the statistics not yet collected by xrEndFrame() are protected by the wait lock instead.
+        std::mutex m_waitLock;
+        std::array<FrameContext, 4> m_frameContexts;
+        uint64_t m_waitedFrameId{0};
+        uint64_t m_begunFrameId{0};
+        uint64_t m_pendingAppCpuTimeUs{0};
+        uint64_t m_pendingWaitCpuTimeUs{0};
+        uint64_t m_pendingPredictionTimeUs{0};
+        bool m_pendingFramePipeliningDetected{false};
+        // Whether the async waiter is in use (only written under m_frameLock), and whether the application is in the
+        // runtime's xrWaitFrame() (see xrWaitFrame()).
+        std::atomic<bool> m_isAsyncWaitActive{false};
+        std::atomic<bool> m_isAppWaitingOnRuntime{false};
         bool m_sendInterationProfileEvent{false};
         uint32_t m_visibilityMaskEventIndex{utilities::ViewCount};
         XrSpace m_viewSpace{XR_NULL_HANDLE};
@@ -3419,24 +4994,57 @@ namespace {
         XrVector2f m_projCenters[utilities::ViewCount];
         XrVector2f m_eyeGaze[utilities::ViewCount];
         XrView m_posesForFrame[utilities::ViewCount];
+
+        std::optional<AppViewsLocate> m_lastAppViewsLocate; // Protected by m_waitLock.
+
+        // The locations of the views in our VIEW space, for the last few display times.
+        struct CachedViews {
+            XrSpace space{XR_NULL_HANDLE};
+            XrTime displayTime{0};
+            XrViewState viewState{XR_TYPE_VIEW_STATE};
+            XrView views[utilities::ViewCount]{};
+        };
+        std::array<CachedViews, 2> m_viewsCache;
+        size_t m_nextViewsCacheEntry{0};
+
+        // The locations of the spaces since the last xrSyncActions() or xrWaitFrame().
+        struct CachedSpaceLocation {
+            XrSpace space;
+            XrSpace baseSpace;
+            XrTime time;
+            XrSpaceLocation location;
+        };
+        static constexpr size_t MaxCachedSpaceLocations = 64;
+        bool m_useSpaceLocationsCache{false};
+        std::mutex m_spaceLocationsCacheLock;
+        std::vector<CachedSpaceLocation> m_spaceLocationsCache;
+
+        // The visibility masks from the runtime, per view and mask type, until the runtime signals a change.
+        struct CachedVisibilityMask {
+            std::vector<XrVector2f> vertices;
+            std::vector<uint32_t> indices;
+        };
+        std::mutex m_visibilityMasksCacheLock;
+        std::map<std::pair<uint32_t, XrVisibilityMaskTypeKHR>, CachedVisibilityMask> m_visibilityMasksCache;
+
         std::chrono::time_point<std::chrono::steady_clock> m_lastFrameWaitTimestamp{};
-        uint32_t m_frameThrottleSleepOffset{0};
+        std::shared_ptr<utilities::IFrameLimiter> m_frameLimiter;
+        PredictionDampeningTuner m_predictionDampeningTuner;
 
-        std::mutex m_asyncWaitLock;
-        std::future<void> m_asyncWaitPromise;
+        std::unique_ptr<AsyncFrameWaiter> m_asyncWaiter;
         XrTime m_lastPredictedDisplayTime{0};
         XrTime m_lastPredictedDisplayPeriod{0};
-        bool m_asyncWaitPolled{false};
-        bool m_asyncWaitCompleted{false};
 
         std::shared_ptr<config::IConfigManager> m_configManager;
 
         std::shared_ptr<graphics::IDevice> m_graphicsDevice;
-        std::map<XrSwapchain, SwapchainState> m_swapchains;
+        utilities::FlatMap<XrSwapchain, SwapchainState> m_swapchains;
 
         config::ScalingType m_upscaleMode{config::ScalingType::None};
         int m_settingScaling{100};
         int m_settingAnamorphic{-100};
+        std::optional<utilities::Eye> m_reducedEye;
+        int m_settingReducedEyeScaling{100};
         float m_mipMapBiasForUpscaling{0.f};
 
         std::shared_ptr<graphics::IFrameAnalyzer> m_frameAnalyzer;
@@ -3446,38 +5054,67 @@ namespace {
         bool m_needVarjoPollEventWorkaround{false};
         std::shared_ptr<input::IHandTracker> m_handTracker;
 
+        // Per-frame layer rewriting storage, reused across frames to avoid heap allocations in xrEndFrame().
+        std::vector<const XrCompositionLayerBaseHeader*> m_correctedLayers;
+        std::vector<XrCompositionLayerProjection> m_layerProjectionAllocator;
+        std::vector<std::array<XrCompositionLayerProjectionView, 2>> m_layerProjectionViewsAllocator;
+
         std::shared_ptr<graphics::IImageProcessor> m_upscaler;
         std::shared_ptr<graphics::IImageProcessor> m_postProcessor;
+        bool m_isFusedPostProcess{false};
+        std::shared_ptr<graphics::ITexturePool> m_texturePool;
+        std::shared_ptr<graphics::IFrameScheduler> m_frameScheduler;
+        std::shared_ptr<utilities::IVideoMemoryBudget> m_videoMemoryBudget;
+        bool m_isVideoMemoryTrimmed{false};
+        std::map<std::tuple<int32_t, int32_t, uint32_t>, std::vector<std::shared_ptr<graphics::ITexture>>>
+            m_upscalerTextures;
         std::shared_ptr<graphics::IVariableRateShader> m_variableRateShader;
+        std::shared_ptr<graphics::IHiddenAreaPrePass> m_hiddenAreaPrePass;
+
+        // The subsystems currently subscribed to the intercepted calls (see updateInterceptedCalls()).
+        struct {
+            bool variableRateShader{false};
+            bool frameAnalyzer{false};
+            bool mipMapBias{false};
+            bool hiddenAreaPrePass{false};
+        } m_interceptedCallsSubscriptions;
 
         std::vector<int> m_keyModifiers;
         int m_keyScreenshot;
         XrSwapchain m_menuSwapchain{XR_NULL_HANDLE};
         std::vector<std::shared_ptr<graphics::ITexture>> m_menuSwapchainImages;
+        bool m_menuSwapchainHasContent{false};
         std::shared_ptr<menu::IMenuHandler> m_menuHandler;
+        std::shared_ptr<graphics::IScreenshotCapture> m_screenshotCapture;
+        std::shared_ptr<graphics::IDynamicResolutionController> m_dynamicResolution;
         int m_menuLingering{0};
         bool m_requestScreenShotKeyState{false};
 
         struct {
             std::shared_ptr<utilities::ICpuTimer> appCpuTimer;
             std::shared_ptr<utilities::ICpuTimer> renderCpuTimer;
-            std::shared_ptr<graphics::IGpuTimer> appGpuTimer[GpuTimerLatency + 1];
             std::shared_ptr<utilities::ICpuTimer> waitCpuTimer;
             std::shared_ptr<utilities::ICpuTimer> endFrameCpuTimer;
             std::shared_ptr<utilities::ICpuTimer> overlayCpuTimer;
-            std::shared_ptr<graphics::IGpuTimer> overlayGpuTimer[GpuTimerLatency + 1];
             std::shared_ptr<utilities::ICpuTimer> handTrackingTimer;
+            std::shared_ptr<graphics::IGpuTimerPool> gpuTimers;
+            std::shared_ptr<graphics::IGpuProfiler> gpuProfiler;
 
-            unsigned int gpuTimerIndex{0};
             std::chrono::steady_clock::time_point lastWindowStart;
             std::deque<std::pair<std::chrono::steady_clock::duration, uint32_t>> frameRates;
             uint32_t framesInPeriod{0};
             std::chrono::steady_clock::duration timePeriod{0s};
             uint32_t numFrames{0};
+            uint32_t numPoseAgeSamples{0};
+            uint32_t numPoseErrorSamples{0};
         } m_performanceCounters;
 
         menu::MenuStatistics m_stats{};
         std::ofstream m_logStats;
+        std::shared_ptr<utilities::IStatisticsRecorder> m_statsRecorder;
+        std::shared_ptr<menu::ITelemetryPublisher> m_telemetryPublisher;
+        std::shared_ptr<menu::IPerformanceSweeper> m_performanceSweeper;
+        menu::MenuStatistics m_recordedStats{};
         bool m_hasPerformanceCounterKHR{false};
         bool m_hasVisibilityMaskKHR{false};
     };
@@ -3506,9 +5143,14 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
         TraceLoggingRegister(g_traceProvider);
         break;
 
+    case DLL_PROCESS_DETACH:
+        // The log writer thread is stopped with the last instance, or already gone when the process exits without
+        // destroying the instance.
+        toolkit::log::FlushLog();
+        break;
+
     case DLL_THREAD_ATTACH:
     case DLL_THREAD_DETACH:
-    case DLL_PROCESS_DETACH:
         break;
     }
     return TRUE;
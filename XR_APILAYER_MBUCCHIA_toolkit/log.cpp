@@ -23,6 +23,7 @@
 
 #include "pch.h"
 
+#include "factories.h"
 #include "log.h"
 
 namespace toolkit::log {
@@ -37,18 +38,271 @@ namespace toolkit::log {
 
     namespace {
 
+        constexpr size_t MaxLogLength = 1024;
+        constexpr size_t LogQueueCapacity = 256;
+
+        // Repeated messages are only reported this often.
+        constexpr auto RepeatSummaryPeriod = 10s;
+        constexpr auto WriterPeriod = 100ms;
+
+        struct LogRecord {
+            std::atomic<size_t> sequence{0};
+            size_t messageOffset{0};
+            char text[MaxLogLength];
+        };
+
+        // A bounded multi-producer/single-consumer queue of formatted lines. Producers never block: the message is
+        // dropped when the queue is full. The lines are written to the file by a background thread while an instance
+        // exists, and synchronously otherwise.
+        class LogQueue {
+          public:
+            LogQueue() {
+                for (size_t i = 0; i < LogQueueCapacity; i++) {
+                    m_records[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            void push(const char* text, size_t messageOffset) {
+                size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+                LogRecord* record;
+                while (true) {
+                    record = &m_records[position % LogQueueCapacity];
+                    const size_t sequence = record->sequence.load(std::memory_order_acquire);
+                    const auto difference = (intptr_t)sequence - (intptr_t)position;
+                    if (difference == 0) {
+                        if (m_enqueuePosition.compare_exchange_weak(
+                                position, position + 1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if (difference < 0) {
+                        m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    } else {
+                        position = m_enqueuePosition.load(std::memory_order_relaxed);
+                    }
+                }
+
+                strcpy_s(record->text, text);
+                record->messageOffset = messageOffset;
+                record->sequence.store(position + 1, std::memory_order_release);
+
+                if (m_isWriterRunning) {
+                    m_wakeUp.notify_one();
+                } else {
+                    std::unique_lock lock(m_flushMutex);
+                    drain();
+                }
+            }
+
+            void startWriter() {
+                std::unique_lock lock(m_writerMutex);
+                if (m_writerUsers++) {
+                    return;
+                }
+
+                m_stopWriter = false;
+                m_writer = std::thread([&] { writerLoop(); });
+                m_isWriterRunning = true;
+            }
+
+            // The writer thread must be gone before our DLL may be unloaded. It is stopped with the last instance.
+            void stopWriter() {
+                std::unique_lock lock(m_writerMutex);
+                if (!m_writerUsers || --m_writerUsers || !m_writer.joinable()) {
+                    return;
+                }
+
+                {
+                    std::unique_lock stopLock(m_mutex);
+                    m_stopWriter = true;
+                }
+                m_wakeUp.notify_one();
+                m_writer.join();
+                m_isWriterRunning = false;
+
+                flush();
+            }
+
+            // Write the pending lines synchronously. Only called when the writer thread is not running.
+            void flush() {
+                std::unique_lock lock(m_flushMutex);
+                drain();
+                reportRepeats();
+            }
+
+            // Upon process exit without destroying the instance, the writer thread was terminated at an arbitrary
+            // point, possibly while holding m_flushMutex. It cannot be joined from DllMain, and a joinable std::thread
+            // must not be destructed.
+            void abandonWriter() {
+                if (m_writer.joinable()) {
+                    m_writer.detach();
+                }
+                m_isWriterRunning = false;
+
+                std::unique_lock lock(m_flushMutex, std::try_to_lock);
+                if (lock.owns_lock()) {
+                    drain();
+                    reportRepeats();
+                }
+            }
+
+          private:
+            void writerLoop() {
+                utilities::RegisterThread(utilities::ThreadClass::Background);
+
+                std::unique_lock lock(m_mutex);
+                while (!m_stopWriter) {
+                    m_wakeUp.wait_for(lock, WriterPeriod, [&] { return m_stopWriter || hasRecords(); });
+
+                    lock.unlock();
+                    {
+                        // Producers may still be writing synchronously while the thread starts.
+                        std::unique_lock flushLock(m_flushMutex);
+                        if (!drain()) {
+                            // Report repeated messages once things quiet down.
+                            reportRepeats();
+                        }
+                    }
+                    lock.lock();
+                }
+                lock.unlock();
+
+                utilities::UnregisterThread();
+            }
+
+            bool hasRecords() const {
+                const auto& record = m_records[m_dequeuePosition % LogQueueCapacity];
+                return record.sequence.load(std::memory_order_acquire) == m_dequeuePosition + 1;
+            }
+
+            // Returns whether any line was dequeued.
+            bool drain() {
+                bool dequeued = false;
+                while (hasRecords()) {
+                    auto& record = m_records[m_dequeuePosition % LogQueueCapacity];
+                    writeRecord(record.text, record.messageOffset);
+                    record.sequence.store(m_dequeuePosition + LogQueueCapacity, std::memory_order_release);
+                    m_dequeuePosition++;
+                    dequeued = true;
+                }
+
+                const auto droppedRecords = m_droppedRecords.exchange(0, std::memory_order_relaxed);
+                if (droppedRecords) {
+                    writeLine(fmt::format("{} log messages were dropped\n", droppedRecords));
+                }
+
+                writeBatch();
+
+                // Do not let a message repeated forever go unnoticed.
+                if (m_repeats && std::chrono::steady_clock::now() - m_lastRepeatSummary > RepeatSummaryPeriod) {
+                    reportRepeats();
+                }
+
+                return dequeued;
+            }
+
+            void writeRecord(const char* text, size_t messageOffset) {
+                // Messages are compared without their timestamp.
+                const std::string_view message(text + messageOffset);
+                if (message == m_lastMessage) {
+                    if (!m_repeats) {
+                        m_lastRepeatSummary = std::chrono::steady_clock::now();
+                    }
+                    m_repeats++;
+                    return;
+                }
+
+                reportRepeats();
+                m_lastMessage = message;
+
+                OutputDebugStringA(text);
+                m_batch += text;
+            }
+
+            void reportRepeats() {
+                if (!m_repeats) {
+                    return;
+                }
+
+                writeLine(fmt::format("Last message repeated {} times\n", m_repeats));
+                m_repeats = 0;
+                m_lastRepeatSummary = std::chrono::steady_clock::now();
+
+                writeBatch();
+            }
+
+            void writeBatch() {
+                if (m_batch.empty()) {
+                    return;
+                }
+
+                // The writer thread might have been terminated in the middle of a write (when the process exits
+                // without destroying the instance), while holding the file lock.
+                if (m_isWritingFile.exchange(true)) {
+                    return;
+                }
+                if (logStream.is_open()) {
+                    logStream << m_batch;
+                    logStream.flush();
+                }
+                m_isWritingFile = false;
+
+                m_batch.clear();
+            }
+
+            // Messages from the logger itself.
+            void writeLine(const std::string& line) {
+                char buf[MaxLogLength];
+                const size_t offset = formatTimestamp(buf, sizeof(buf));
+                strcpy_s(buf + offset, sizeof(buf) - offset, line.c_str());
+                OutputDebugStringA(buf);
+                m_batch += buf;
+            }
+
+          public:
+            static size_t formatTimestamp(char* buf, size_t size) {
+                const std::time_t now = std::time(nullptr);
+
+                std::tm localTime;
+                localtime_s(&localTime, &now);
+                return std::strftime(buf, size, "[OXRTK] %Y-%m-%d %H:%M:%S %z: ", &localTime);
+            }
+
+          private:
+            LogRecord m_records[LogQueueCapacity];
+            std::atomic<size_t> m_enqueuePosition{0};
+            std::atomic<uint32_t> m_droppedRecords{0};
+            std::atomic<bool> m_isWritingFile{false};
+            std::mutex m_writerMutex;
+            uint32_t m_writerUsers{0};
+            std::thread m_writer;
+            std::atomic<bool> m_isWriterRunning{false};
+            std::mutex m_mutex;
+            std::condition_variable m_wakeUp;
+            bool m_stopWriter{false};
+
+            // Only one thread writes to the file at a time.
+            std::mutex m_flushMutex;
+
+            // Only accessed under m_flushMutex.
+            size_t m_dequeuePosition{0};
+            std::string m_batch;
+            std::string m_lastMessage;
+            uint32_t m_repeats{0};
+            std::chrono::steady_clock::time_point m_lastRepeatSummary;
+        };
+
+        LogQueue& GetLogQueue() {
+            static LogQueue queue;
+            return queue;
+        }
+
         // Utility logging function.
         void InternalLog(const char* fmt, va_list va) {
-            const std::time_t now = std::time(nullptr);
-
-            char buf[1024];
-            size_t offset = std::strftime(buf, sizeof(buf), "[OXRTK] %Y-%m-%d %H:%M:%S %z: ", std::localtime(&now));
+            char buf[MaxLogLength];
+            const size_t offset = LogQueue::formatTimestamp(buf, sizeof(buf));
             vsnprintf_s(buf + offset, sizeof(buf) - offset, _TRUNCATE, fmt, va);
-            OutputDebugStringA(buf);
-            if (logStream.is_open()) {
-                logStream << buf;
-                logStream.flush();
-            }
+            GetLogQueue().push(buf, offset);
         }
     } // namespace
 
@@ -68,4 +322,16 @@ namespace toolkit::log {
 #endif
     }
 
+    void StartLogWriter() {
+        GetLogQueue().startWriter();
+    }
+
+    void StopLogWriter() {
+        GetLogQueue().stopWriter();
+    }
+
+    void FlushLog() {
+        GetLogQueue().abandonWriter();
+    }
+
 } // namespace toolkit::log
@@ -60,7 +60,17 @@ namespace toolkit::log {
 
     extern TraceLoggingActivity<g_traceProvider> g_traceGlobal;
 
+    // Keywords for the high-frequency events. A trace session can enable only some of them (see OXRTK.wprp), while
+    // events without a keyword are always written when the provider is enabled.
+#define TLK_Frame 0x1
+#define TLK_Input 0x2
+#define TLK_GraphicsHooks 0x4
+#define TLK_VRS 0x8
+
+    // TraceLoggingWrite() only evaluates its arguments when the event is enabled. Use these to skip any work done
+    // outside of it (such as looping through an array) when nobody listens.
 #define IsTraceEnabled() TraceLoggingProviderEnabled(g_traceProvider, 0, 0)
+#define IsTraceKeywordEnabled(keyword) TraceLoggingProviderEnabled(g_traceProvider, 0, (keyword))
 
 #define TraceLocalActivity(activity) TraceLoggingActivity<g_traceProvider> activity;
 
@@ -73,4 +83,14 @@ namespace toolkit::log {
     // Debug logging function. Can make things very slow (only enabled on Debug builds).
     void DebugLog(const char* fmt, ...);
 
+    // The log messages are written by a background thread while an instance exists, and synchronously otherwise.
+    // Each call to StartLogWriter() must be balanced by a call to StopLogWriter(). Stopping the thread with the last
+    // instance writes the pending messages.
+    void StartLogWriter();
+    void StopLogWriter();
+
+    // Write the pending log messages upon unloading the DLL. A writer thread still running (the process exited without
+    // destroying the instance) is abandoned.
+    void FlushLog();
+
 } // namespace toolkit::log
@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit::log;
+    using namespace toolkit::utilities;
+
+    using namespace std::chrono_literals;
+
+    // The usage over which we consider that the process is running out of video memory, in percent of the budget.
+    constexpr uint64_t PressureThreshold = 95;
+
+    // DXGI only signals the changes of the budget, not of the usage. The usage is refreshed at least this often.
+    constexpr auto RefreshPeriod = 1s;
+
+    class VideoMemoryBudget : public IVideoMemoryBudget {
+        using clock = std::chrono::steady_clock;
+
+      public:
+        VideoMemoryBudget(ComPtr<IDXGIAdapter> adapter) {
+            if (FAILED(adapter->QueryInterface(set(m_adapter)))) {
+                Log("Video memory budget is not available\n");
+                return;
+            }
+
+            *m_budgetChanged.put() = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+            if (!m_budgetChanged ||
+                FAILED(m_adapter->RegisterVideoMemoryBudgetChangeNotificationEvent(m_budgetChanged.get(),
+                                                                                   &m_cookie))) {
+                // We can still poll.
+                m_budgetChanged.reset();
+            }
+            refresh();
+        }
+
+        ~VideoMemoryBudget() override {
+            if (m_budgetChanged) {
+                m_adapter->UnregisterVideoMemoryBudgetChangeNotification(m_cookie);
+            }
+        }
+
+        bool isUnderPressure() override {
+            if (!m_adapter) {
+                return false;
+            }
+
+            const auto now = clock::now();
+            if ((m_budgetChanged && WaitForSingleObject(m_budgetChanged.get(), 0) == WAIT_OBJECT_0) ||
+                now - m_lastRefresh >= RefreshPeriod) {
+                refresh();
+            }
+
+            return m_budget && m_usage * 100 >= m_budget * PressureThreshold;
+        }
+
+        uint64_t getBudget() const override {
+            return m_budget;
+        }
+
+        uint64_t getUsage() const override {
+            return m_usage;
+        }
+
+      private:
+        void refresh() {
+            m_lastRefresh = clock::now();
+
+            DXGI_QUERY_VIDEO_MEMORY_INFO info{};
+            if (SUCCEEDED(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info))) {
+                if (info.Budget != m_budget) {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "VideoMemoryBudget",
+                                      TLArg(info.Budget, "Budget"),
+                                      TLArg(info.CurrentUsage, "Usage"));
+                }
+                m_budget = info.Budget;
+                m_usage = info.CurrentUsage;
+            }
+        }
+
+        ComPtr<IDXGIAdapter3> m_adapter;
+        wil::unique_handle m_budgetChanged;
+        DWORD m_cookie{0};
+
+        clock::time_point m_lastRefresh;
+        uint64_t m_budget{0};
+        uint64_t m_usage{0};
+    };
+
+} // namespace
+
+namespace toolkit::utilities {
+
+    std::shared_ptr<IVideoMemoryBudget> CreateVideoMemoryBudget(ComPtr<IDXGIAdapter> adapter) {
+        return std::make_shared<VideoMemoryBudget>(adapter);
+    }
+
+} // namespace toolkit::utilities
@@ -57,6 +57,14 @@ namespace {
         return XrColor4f({sRGBToLinear(r / 255.f), sRGBToLinear(g / 255.f), sRGBToLinear(b / 255.f), a / 255.f});
     }
 
+    // Whether a value changes once displayed with the given precision (eg: 100 for 2 decimals).
+    bool HasDisplayedValueChanged(double a, double b, double precision = 1.0) {
+        if (isnan(a) || isnan(b)) {
+            return isnan(a) != isnan(b);
+        }
+        return std::round(a * precision) != std::round(b * precision);
+    }
+
     // Text colors
     const auto ColorNormal = sRGBToLinear(145, 141, 201);
     const auto ColorOverlay = sRGBToLinear(247, 198, 20);
@@ -152,11 +160,11 @@ namespace {
               m_isEyeTrackingSupported(menuInfo.isEyeTrackingSupported),
               m_resolutionHeightRatio(menuInfo.resolutionHeightRatio),
               m_isMotionReprojectionRateSupported(menuInfo.isMotionReprojectionRateSupported),
-              m_displayRefreshRate(menuInfo.displayRefreshRate) {
+              m_displayRefreshRate(menuInfo.displayRefreshRate), m_isFSRHalfPrecision(menuInfo.isFSRHalfPrecision) {
             m_lastInput = std::chrono::steady_clock::now();
 
             // We display the hint for menu hotkeys for the first few runs.
-            const int keyMenuGen = m_configManager->getValue("key_menu_gen");
+            const int keyMenuGen = m_configManager->getValue(SettingKeyMenuGeneration);
             if (keyMenuGen != m_configManager->getValue(SettingFirstRun)) {
                 m_state = MenuState::Splash;
             }
@@ -244,7 +252,7 @@ namespace {
                     Log("Opening menu\n");
 
                     // Clear the "first run" until the menu key is reconfigured.
-                    m_configManager->setValue(SettingFirstRun, m_configManager->getValue("key_menu_gen"));
+                    m_configManager->setValue(SettingFirstRun, m_configManager->getValue(SettingKeyMenuGeneration));
 
                     m_needRestart = checkNeedRestartCondition();
                     m_resetTextLayout = m_resetBackgroundLayout = true;
@@ -264,6 +272,7 @@ namespace {
 
                 m_resetArmed = false;
                 m_lastInput = now;
+                m_isDirty = true;
             }
 
             if (m_state == MenuState::Visible && (moveLeft || moveRight)) {
@@ -334,12 +343,14 @@ namespace {
                 }
 
                 m_lastInput = now;
+                m_isDirty = true;
             }
 
             if (menuControl && moveLeft && moveRight) {
                 m_configManager->hardReset();
                 m_state = MenuState::Splash;
                 m_selectedItem = 0;
+                m_isDirty = true;
             }
 
             const bool showExpert = m_configManager->getValue(SettingMenuExpert);
@@ -685,7 +696,8 @@ namespace {
                     if (m_currentTab == MenuTab::Performance && m_configManager->peekValue(SettingTurboMode)) {
                         warning = m_turboWarning;
                     } else if (m_currentTab == MenuTab::Inputs &&
-                               m_configManager->peekValue(SettingPredictionDampen) != 100) {
+                               (m_configManager->peekValue(SettingPredictionDampen) != 100 ||
+                                m_configManager->peekValue(SettingPredictionDampenAuto))) {
                         warning = m_predictionDampeningWarning;
                     }
 
@@ -977,12 +989,47 @@ namespace {
     top += 1.05f * fontSize;
                                 TIMING_STAT("wait", waitCpuTimeUs);
                                 TIMING_STAT("lay CPU", endFrameCpuTimeUs);
+                                if (m_stats.variableRateShadingGpuTimeUs) {
+                                    TIMING_STAT("vrs GPU", variableRateShadingGpuTimeUs);
+                                }
+                                if (m_stats.dynamicResolutionLevel) {
+                                    TIMING_STAT("dyn VRS", dynamicResolutionLevel);
+                                }
                                 TIMING_STAT("scl GPU", processorGpuTimeUs[0]);
                                 TIMING_STAT("pst GPU", processorGpuTimeUs[1]);
                                 TIMING_STAT("ovl CPU", overlayCpuTimeUs);
                                 TIMING_STAT("ovl GPU", overlayGpuTimeUs);
                                 if (m_isHandTrackingSupported) {
                                     TIMING_STAT("hnd CPU", handTrackingCpuTimeUs);
+                                    TIMING_STAT("hnd GPU", handTrackingGpuTimeUs);
+                                }
+                                TIMING_STAT("pose age", poseAgeUs);
+                                if (m_stats.numLocateSpaceCacheHits || m_stats.numLocateSpaceCacheMisses) {
+                                    m_device->drawString(fmt::format("loc cache: {} / {}",
+                                                                     m_stats.numLocateSpaceCacheHits,
+                                                                     m_stats.numLocateSpaceCacheMisses),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+                                if (m_stats.poseErrorDeg > 0.f) {
+                                    m_device->drawString(fmt::format("pose err: {:.2f}deg", m_stats.poseErrorDeg),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+                                if (m_stats.submitLatencyUs) {
+                                    TIMING_STAT("lat inp", inputLatencyUs);
+                                    TIMING_STAT("lat wait", waitLatencyUs);
+                                    TIMING_STAT("lat bgn", beginLatencyUs);
+                                    TIMING_STAT("lat rdr", renderLatencyUs);
+                                    TIMING_STAT("lat end", endFrameLatencyUs);
+                                    TIMING_STAT("lat sub", submitLatencyUs);
+                                }
+                                for (uint32_t i = 0; i < m_stats.numGpuProfileScopes; i++) {
+                                    const auto& scope = m_stats.gpuProfileScopes[i];
+                                    const auto indent = std::string(scope.depth * 2, ' ');
+                                    m_device->drawString(
+                                        fmt::format("{}{}: {}", indent, scope.name, scope.durationUs), OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
                                 }
 
                                 m_device->drawString(fmt::format("{}{} / {}{}",
@@ -995,8 +1042,15 @@ namespace {
                                 m_device->drawString(fmt::format("heur: {}", m_stats.frameAnalyzerHeuristic),
                                                      OVERLAY_COMMON);
                                 top += 1.05f * fontSize;
+                                if (m_originalScalingType == ScalingType::FSR) {
+                                    m_device->drawString(
+                                        fmt::format("FSR: {}", m_isFSRHalfPrecision ? "FP16" : "FP32"), OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
 
-                                m_device->drawString(fmt::format("biased: {}", m_stats.numBiasedSamplers),
+                                m_device->drawString(fmt::format("biased: {} ({} new)",
+                                                                 m_stats.numBiasedSamplers,
+                                                                 m_stats.numBiasedSamplersCreated),
                                                      OVERLAY_COMMON);
                                 top += 1.05f * fontSize;
                                 m_device->drawString(fmt::format("VRS RTV: {}", m_stats.numRenderTargetsWithVRS),
@@ -1007,6 +1061,35 @@ namespace {
                                                      OVERLAY_COMMON);
                                 top += 1.05f * fontSize;
 
+                                {
+                                    // Rejections are by aspect ratio, size and array size. Tile coverage is from full
+                                    // rate to culled.
+                                    const auto& vrs = m_stats.variableRateShader;
+                                    m_device->drawString(fmt::format("binds: {} ok {} ar {} sz {} arr",
+                                                                     vrs.numCandidateBinds,
+                                                                     vrs.numRejectedBinds[0],
+                                                                     vrs.numRejectedBinds[1],
+                                                                     vrs.numRejectedBinds[2]),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                    m_device->drawString(fmt::format("masks: {} hit {} miss {} evict",
+                                                                     vrs.numMaskHits,
+                                                                     vrs.numMaskMisses,
+                                                                     vrs.numMaskEvictions),
+                                                         OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                    m_device->drawString(
+                                        fmt::format("tiles: {:.0f}/{:.0f}/{:.0f}/{:.0f}/{:.0f}/{:.0f}%",
+                                                    vrs.tileCoverage[0] * 100.f,
+                                                    vrs.tileCoverage[1] * 100.f,
+                                                    vrs.tileCoverage[2] * 100.f,
+                                                    vrs.tileCoverage[3] * 100.f,
+                                                    vrs.tileCoverage[4] * 100.f,
+                                                    vrs.tileCoverage[5] * 100.f),
+                                        OVERLAY_COMMON);
+                                    top += 1.05f * fontSize;
+                                }
+
 #undef TIMING_STAT
 
                                 top += 1.05f * fontSize;
@@ -1090,24 +1173,73 @@ namespace {
         }
 
         void updateStatistics(const MenuStatistics& stats) override {
+            // The statistics are only updated once per stats window.
             m_stats = stats;
+            m_isDirty = true;
         }
 
+        // Only the changes that are visible on the developer overlay (see render()) require to re-render.
         void updateGesturesState(const GesturesState& state) override {
+            if (!m_isDirty && isDeveloperOverlayVisible() && isHandTrackingEnabled()) {
+                const auto hasChanged = [&](const auto member, double precision, double scale = 1.0) {
+                    for (uint32_t side = 0; side < 2; side++) {
+                        if (HasDisplayedValueChanged(
+                                (m_gesturesState.*member)[side] * scale, (state.*member)[side] * scale, precision)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+
+                m_isDirty = hasChanged(&GesturesState::pinchValue, 100) ||
+                            hasChanged(&GesturesState::thumbPressValue, 100) ||
+                            hasChanged(&GesturesState::indexBendValue, 100) ||
+                            hasChanged(&GesturesState::fingerGunValue, 100) ||
+                            hasChanged(&GesturesState::squeezeValue, 100) ||
+                            hasChanged(&GesturesState::wristTapValue, 100) ||
+                            hasChanged(&GesturesState::palmTapValue, 100) ||
+                            hasChanged(&GesturesState::indexTipTapValue, 100) ||
+                            hasChanged(&GesturesState::custom1Value, 100) ||
+                            hasChanged(&GesturesState::hapticsFrequency, 1000) ||
+                            hasChanged(&GesturesState::hapticsDurationUs, 10, 1e-6) ||
+                            hasChanged(&GesturesState::handposeAgeUs, 10, 1e-6) ||
+                            hasChanged(&GesturesState::numTrackingLosses, 1) ||
+                            hasChanged(&GesturesState::cacheSize, 1);
+            }
             m_gesturesState = state;
         }
 
         void updateEyeGazeState(const input::EyeGazeState& state) override {
+            if (!m_isDirty && isDeveloperOverlayVisible() && isEyeTrackingEnabled()) {
+                const auto& old = m_eyeGazeState;
+                m_isDirty = HasDisplayedValueChanged(old.gazeRay.x, state.gazeRay.x, 1000) ||
+                            HasDisplayedValueChanged(old.gazeRay.y, state.gazeRay.y, 1000) ||
+                            HasDisplayedValueChanged(old.gazeRay.z, state.gazeRay.z, 1000) ||
+                            HasDisplayedValueChanged(old.leftPoint.x, state.leftPoint.x, 1000) ||
+                            HasDisplayedValueChanged(old.leftPoint.y, state.leftPoint.y, 1000) ||
+                            HasDisplayedValueChanged(old.rightPoint.x, state.rightPoint.x, 1000) ||
+                            HasDisplayedValueChanged(old.rightPoint.y, state.rightPoint.y, 1000);
+            }
             m_eyeGazeState = state;
         }
 
         void setViewProjectionCenters(XrVector2f left, XrVector2f right) override {
+            // Only the horizontal distance between the centers is used, to offset the menu for the right eye. The
+            // menu is not re-rendered for less than a pixel.
+            const float previousDistance = m_projCenter[1].x - m_projCenter[0].x;
             left = utilities::NdcToScreen(left);
             m_projCenter[0].x = left.x;
             m_projCenter[0].y = left.y;
             right = utilities::NdcToScreen(right);
             m_projCenter[1].x = right.x;
             m_projCenter[1].y = right.y;
+            const float distance = m_projCenter[1].x - m_projCenter[0].x;
+            const float width = (float)m_device->getViewportSize().width;
+            m_isDirty = m_isDirty || HasDisplayedValueChanged(2.f * previousDistance * width, 2.f * distance * width);
+        }
+
+        bool isDeveloperOverlayVisible() const {
+            return m_configManager->peekEnumValue<OverlayType>(SettingOverlayType) == OverlayType::Developer;
         }
 
         bool isVisible() const {
@@ -1116,6 +1248,36 @@ namespace {
                    m_configManager->getValue(SettingOverlayShowClock);
         }
 
+        bool isDirty() const override {
+            // The splash screen reflects the keys being pressed, and the layout takes several frames to settle.
+            if (m_isDirty || m_state == MenuState::Splash || m_resetTextLayout || m_resetBackgroundLayout ||
+                m_configManager->getChangeSerial() != m_renderedConfigSerial) {
+                return true;
+            }
+
+            // The menu fades out during the last second before its timeout.
+            if (m_state == MenuState::Visible) {
+                const double timeouts[to_integral(MenuTimeout::MaxValue)] = {3.0, 12.0, 60.0, INFINITY};
+                const double timeout = timeouts[m_configManager->peekValue(SettingMenuTimeout)];
+                const auto duration =
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - m_lastInput).count();
+                if (duration >= timeout - 1.0) {
+                    return true;
+                }
+            } else if (m_configManager->peekValue(SettingOverlayShowClock) &&
+                       std::time(nullptr) != m_renderedClockTime) {
+                return true;
+            }
+
+            return false;
+        }
+
+        void clearDirty() override {
+            m_isDirty = false;
+            m_renderedConfigSerial = m_configManager->getChangeSerial();
+            m_renderedClockTime = std::time(nullptr);
+        }
+
       private:
         friend class MenuGroup;
 
@@ -1191,7 +1353,8 @@ namespace {
             {
                 MenuGroup upscalingGroup(this, [&] {
                     return getCurrentScalingType() == ScalingType::NIS || getCurrentScalingType() == ScalingType::FSR ||
-                           getCurrentScalingType() == ScalingType::CAS;
+                           getCurrentScalingType() == ScalingType::CAS ||
+                           getCurrentScalingType() == ScalingType::Temporal;
                 });
                 m_menuEntries.push_back({MenuIndent::SubGroupIndent,
                                          "Anamorphic",
@@ -1614,6 +1777,24 @@ namespace {
                 this, [&] { return m_currentTab == MenuTab::Inputs; }, true);
 
             if (menuInfo.isPredictionDampeningSupported) {
+                m_menuEntries.push_back({MenuIndent::OptionIndent,
+                                         "Auto over-prediction reduction",
+                                         MenuEntryType::Choice,
+                                         SettingPredictionDampenAuto,
+                                         0,
+                                         MenuEntry::LastVal<OffOnType>(),
+                                         [&](int value) {
+                                             if (!value) {
+                                                 return std::string("Off");
+                                             } else {
+                                                 return fmt::format("On ({}% of {:.1f}ms)",
+                                                                    m_stats.predictionDampen - 100,
+                                                                    m_stats.predictionTimeUs / 1000000.0f);
+                                             }
+                                         }});
+
+                MenuGroup predictionDampenGroup(
+                    this, [&] { return !m_configManager->peekValue(SettingPredictionDampenAuto); });
                 m_menuEntries.push_back({MenuIndent::OptionIndent,
                                          "Over-prediction reduction",
                                          MenuEntryType::Slider,
@@ -1629,6 +1810,7 @@ namespace {
                                                                     m_stats.predictionTimeUs / 1000000.0f);
                                              }
                                          }});
+                predictionDampenGroup.finalize();
             }
 
             if (m_isHandTrackingSupported) {
@@ -2006,6 +2188,33 @@ namespace {
                                      1000,
                                      MenuEntry::FmtDecimal<0>});
 
+            // The sweep resets itself once the report is written and the best settings are applied.
+            m_menuEntries.push_back({MenuIndent::OptionIndent,
+                                     "Benchmark sweep",
+                                     MenuEntryType::Choice,
+                                     SettingBenchmarkSweep,
+                                     0,
+                                     MenuEntry::LastVal<OffOnType>(),
+                                     MenuEntry::FmtEnum<OffOnType>});
+            m_menuEntries.back().noCommitDelay = true;
+            m_menuEntries.push_back({MenuIndent::SubGroupIndent,
+                                     "Frames per step",
+                                     MenuEntryType::Slider,
+                                     SettingBenchmarkSweepFrames,
+                                     60,
+                                     3000,
+                                     MenuEntry::FmtDecimal<0>});
+            m_menuEntries.back().acceleration = 10;
+            m_menuEntries.push_back({MenuIndent::SubGroupIndent,
+                                     "Target frame rate",
+                                     MenuEntryType::Slider,
+                                     SettingBenchmarkSweepTarget,
+                                     0,
+                                     144,
+                                     [](int value) {
+                                         return value ? fmt::format("{} FPS", value) : std::string("Refresh rate");
+                                     }});
+
             m_menuEntries.push_back(
                 {MenuIndent::OptionIndent, "Reload Shaders", MenuEntryType::ReloadShaders, BUTTON_OR_SEPARATOR});
 
@@ -2132,6 +2341,7 @@ namespace {
         const float m_resolutionHeightRatio;
         const bool m_isMotionReprojectionRateSupported;
         const uint8_t m_displayRefreshRate;
+        const bool m_isFSRHalfPrecision;
         std::wstring m_turboWarning;
         std::wstring m_predictionDampeningWarning;
         MenuStatistics m_stats{};
@@ -2183,6 +2393,10 @@ namespace {
         mutable float m_menuHeaderHeight{0.0f};
         mutable bool m_resetTextLayout{true};
         mutable bool m_resetBackgroundLayout{true};
+
+        bool m_isDirty{true};
+        uint64_t m_renderedConfigSerial{0};
+        std::time_t m_renderedClockTime{0};
     };
 
     template <typename E>
@@ -60,56 +60,87 @@ namespace {
         void update() override {
         }
 
-        void process(std::shared_ptr<ITexture> input,
-                     std::shared_ptr<ITexture> output,
+        void process(const std::shared_ptr<ITexture>& input,
+                     const std::shared_ptr<ITexture>& output,
                      std::vector<std::shared_ptr<ITexture>>& textures,
+                     std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
                      std::array<uint8_t, 1024>& blob,
-                     std::optional<utilities::Eye> eye = std::nullopt) override {
-            // We need to use a per-instance blob.
-            static_assert(sizeof(NISConfig) <= 1024);
-            NISConfig* const config = reinterpret_cast<NISConfig*>(blob.data());
+                     std::optional<utilities::Eye> eye = std::nullopt,
+                     const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr,
+                     std::optional<TextureRegion> inputRegion = std::nullopt,
+                     std::optional<TextureRegion> outputRegion = std::nullopt) override {
+            // We need to use a per-instance blob, with one slot per eye.
+            static_assert(sizeof(NISConfig) * (utilities::ViewCount + 1) <= 1024);
+            const auto slot = to_integral(eye.value_or(utilities::Eye::Both));
+            NISConfig* const config = reinterpret_cast<NISConfig*>(blob.data()) + slot;
 
             // Update the scaler's configuration specifically for this image.
             const auto inputWidth = input->getInfo().width;
             const auto inputHeight = input->getInfo().height;
             const auto outputWidth = output->getInfo().width;
             const auto outputHeight = output->getInfo().height;
+            const auto inputRect =
+                inputRegion ? inputRegion->rect : XrRect2Di{{0, 0}, {(int32_t)inputWidth, (int32_t)inputHeight}};
+            const auto outputRect =
+                outputRegion ? outputRegion->rect : XrRect2Di{{0, 0}, {(int32_t)outputWidth, (int32_t)outputHeight}};
             const float sharpness = m_configManager->getValue(SettingSharpness) / 100.f;
 
+            // The NIS shader natively supports input and output viewports.
+            NISConfig newConfig{};
             if (!m_isSharpenOnly) {
-                NVScalerUpdateConfig(*config,
+                NVScalerUpdateConfig(newConfig,
                                      sharpness,
-                                     0,
-                                     0,
+                                     inputRect.offset.x,
+                                     inputRect.offset.y,
+                                     inputRect.extent.width,
+                                     inputRect.extent.height,
                                      inputWidth,
                                      inputHeight,
-                                     inputWidth,
-                                     inputHeight,
-                                     0,
-                                     0,
-                                     outputWidth,
-                                     outputHeight,
+                                     outputRect.offset.x,
+                                     outputRect.offset.y,
+                                     outputRect.extent.width,
+                                     outputRect.extent.height,
                                      outputWidth,
                                      outputHeight,
                                      NISHDRMode::None);
             } else {
-                NVSharpenUpdateConfig(
-                    *config, sharpness, 0, 0, inputWidth, inputHeight, inputWidth, inputHeight, 0, 0, NISHDRMode::None);
+                NVSharpenUpdateConfig(newConfig,
+                                      sharpness,
+                                      inputRect.offset.x,
+                                      inputRect.offset.y,
+                                      inputRect.extent.width,
+                                      inputRect.extent.height,
+                                      inputWidth,
+                                      inputHeight,
+                                      outputRect.offset.x,
+                                      outputRect.offset.y,
+                                      NISHDRMode::None);
             }
 
-            // TODO: We can use an IShaderBuffer cache per swapchain and avoid this every frame.
-            m_configBuffer->uploadData(config, sizeof(*config));
+            // Only upload the per-swapchain, per-eye constant buffer when the configuration has changed.
+            if (buffers.size() <= slot) {
+                buffers.resize(utilities::ViewCount + 1);
+            }
+            auto& configBuffer = buffers[slot];
+            if (!configBuffer || memcmp(config, &newConfig, sizeof(newConfig))) {
+                if (!configBuffer) {
+                    configBuffer = m_device->createBuffer(sizeof(NISConfig), "NIS Configuration CB");
+                }
+                memcpy(config, &newConfig, sizeof(newConfig));
+                configBuffer->uploadData(config, sizeof(*config));
+            }
 
             const std::array<unsigned int, 3> threadGroups = {
-                (unsigned int)std::ceil(outputWidth / float(m_optimalBlockWidth)),
-                (unsigned int)std::ceil(outputHeight / float(m_optimalBlockHeight)),
+                (unsigned int)std::ceil(outputRect.extent.width / float(m_optimalBlockWidth)),
+                (unsigned int)std::ceil(outputRect.extent.height / float(m_optimalBlockHeight)),
                 1};
             m_shader->updateThreadGroups(threadGroups);
 
+            m_device->beginProfileScope("NIS");
             m_device->setShader(m_shader, SamplerType::LinearClamp);
-            m_device->setShaderInput(0, m_configBuffer);
-            m_device->setShaderInput(0, input);
-            m_device->setShaderOutput(0, output);
+            m_device->setShaderInput(0, configBuffer);
+            m_device->setShaderInput(0, input, inputRegion ? inputRegion->slice : -1);
+            m_device->setShaderOutput(0, output, outputRegion ? outputRegion->slice : -1);
 
             if (!m_isSharpenOnly) {
                 m_device->setShaderInput(1, m_coefScale);
@@ -117,6 +148,44 @@ namespace {
             }
 
             m_device->dispatchShader();
+            m_device->endProfileScope();
+        }
+
+        bool isIdentity() const override {
+            return false;
+        }
+
+        bool isStereoSupported() const override {
+            return false;
+        }
+
+        void processStereo(const std::shared_ptr<ITexture>& input,
+                           const std::shared_ptr<ITexture>& output,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                           std::array<uint8_t, 1024>& blob,
+                           const std::array<TextureRegion, utilities::ViewCount>& inputRegions,
+                           const std::array<TextureRegion, utilities::ViewCount>& outputRegions,
+                           const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr) override {
+            // The NIS SDK shader accesses the textures and the configuration directly, one eye at a time.
+            throw std::runtime_error("Stereo processing is not supported");
+        }
+
+        bool isFusedPostProcessSupported() const override {
+            return false;
+        }
+
+        std::shared_ptr<IShaderBuffer>
+        getFusedPostProcessConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                     std::array<uint8_t, 1024>& blob,
+                                     std::optional<utilities::Eye> eye = std::nullopt) override {
+            return nullptr;
+        }
+
+        void setFoveatedRegion(utilities::Eye eye, const std::optional<FoveatedRegion>& region) override {
+        }
+
+        void setTemporalView(utilities::Eye eye, const std::optional<TemporalViewInfo>& view) override {
         }
 
       private:
@@ -152,8 +221,6 @@ namespace {
             } else {
                 m_shader = m_device->createComputeShader(shaderFile, "main", "NISSharpen CS", {}, defines.get());
             }
-
-            m_configBuffer = m_device->createBuffer(sizeof(NISConfig), "NIS Configuration CB");
         }
 
         void initializeCoefficients() {
@@ -204,7 +271,6 @@ namespace {
         std::shared_ptr<IComputeShader> m_shader;
         uint32_t m_optimalBlockWidth;
         uint32_t m_optimalBlockHeight;
-        std::shared_ptr<IShaderBuffer> m_configBuffer;
         std::shared_ptr<ITexture> m_coefScale;
         std::shared_ptr<ITexture> m_coefUSM;
     };
@@ -30,6 +30,7 @@
 #include <chrono>
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <condition_variable>
 #include <cstdarg>
 #include <ctime>
 #include <deque>
@@ -37,14 +38,18 @@
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <sstream>
 #include <string>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <optional>
 #include <set>
 #include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 using namespace std::chrono_literals;
@@ -57,6 +62,7 @@ using namespace std::chrono_literals;
 #include <wrl.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <avrt.h>
 #include <wil/registry.h>
 
 using Microsoft::WRL::ComPtr;
@@ -28,132 +28,18 @@ cbuffer config : register(b0) {
     float4 Params2;  // ColorGainR, ColorGainG, ColorGainB (-1..+1 params)
     float4 Params3;  // Highlights, Shadows, Vibrance (0..1 params), UseCA (0 = off, 1 = on)
     float4 Params4;  // ChromaticCorrectionR, ChromaticCorrectionG, ChromaticCorrectionB (-1..+1 params), Eye (0 = left, 1 = right)
+    float4 Params5;  // InputScaleU, InputScaleV, InputOffsetU, InputOffsetV (input region)
 };
 
 SamplerState sourceSampler : register(s0);
 
 Texture2D sourceTexture : register(t0);
-#define SAMPLE_TEXTURE(texcoord) sourceTexture.Sample(sourceSampler, (texcoord))
+#define SAMPLE_TEXTURE(texcoord) sourceTexture.Sample(sourceSampler, (texcoord) * Params5.xy + Params5.zw)
 
-#ifndef FLT_EPSILON
-#define FLT_EPSILON     1.192092896e-07
-#endif
-
-#if 0
-// http://www.martinreddy.net/gfx/faqs/colorconv.faq
-
-float3 sRGB_to_YUV(float3 col) {
-  return col.r * float3(0.299,-0.147, 0.615) +
-         col.g * float3(0.587,-0.289,-0.515) +
-         col.b * float3(0.114, 0.436,-0.100);
-}
+// CA correction: the position in the view to sample the red (xy) and blue (zw) channels from.
+Texture2D correctionLUT : register(t1);
 
-float3 YUV_to_sRGB(float3 yuv) {
-  return yuv.r +
-         yuv.g * float3(0.0 , -0.396, 2.029) +
-         yuv.b * float3(1.14, -0.581, 0.0  );
-}
-
-float3 linear_to_YUV(float3 col) {
-  return col.r * float3(0.431, 0.222, 0.020) +
-         col.g * float3(0.342, 0.707, 0.130) +
-         col.b * float3(0.178, 0.071, 0.939);
-}
-
-float3 YUV_to_linear(float3 yuv) {
-  return yuv.r * float3( 3.063,-3.969, 0.068) +
-         yuv.g * float3(-1.393, 1.876, 0.229) +
-         yuv.b * float3( 0.476, 0.042, 1.069);
-}
-
-float3 RGB_to_BT601(float3 col) {
-  return col.r * float3(0.299,-0.169, 0.500) +
-         col.g * float3(0.587,-0.331,-0.419) +
-         col.b * float3(0.114, 0.500,-0.081);
-}
-
-float3 BT601_to_RGB(float3 yuv) {
-  return yuv.r +
-         yuv.g * float3(0.0  ,-0.344, 1.773) +
-         yuv.b * float3(1.403,-0.714, 0.0  );
-}
-
-float Smoothstep(float x, float p) {
-    x = saturate(x);
-    float x_ = x < 0.5 ? x * 2.0 : x * -2.0 + 2.0;
-    float y = pow(x_, p);
-    return x < 0.5 ? y * 0.5 : y * -0.5 + 1.0;
-}
-#endif
-
-float3 srgb2linear(float3 c ) {
-  //return pow(c, 2.2);
-  return saturate(c*c); // fast aproximation
-}
-float3 linear2srgb(float3 c) {
-  //return pow(c, 1.0/2.2);
-  return sqrt(c); // fast aproximation
-}
-
-float SafePow(float value, float power) {
-  return pow(max(abs(value), FLT_EPSILON), power);
-}
-float3 SafePow(float3 value, float3 power) {
-  return pow(max(abs(value), FLT_EPSILON), power);
-}
-
-// -1..+1
-float3 AdjustContrast(float3 color, float scale) {
-  float luminance = dot(saturate(color), float3(0.2125, 0.7154, 0.0721));
-  float contrast = luminance * luminance * (3.0 - 2.0 * luminance); // smoothstep
-  contrast = lerp(luminance, contrast, scale);
-  return max(color + contrast - luminance, 0.0);
-}
-
-// -1..+1 (better: +- 0.8)
-float3 AdjustBrightness(float3 color, float scale) {
-  return SafePow(color, (1.0 - scale));
-}
-
-// -1..+1 (better: +-3 F-stops)
-float3 AdjustExposure(float3 color, float scale) {
-  return color * pow(2.0, scale);
-}
-
-// -1..+1 (better: +-4 F-stops)
-float3 AdjustExposureToneMap(float3 color, float scale) {
-  color = -(color / min(color - 1.0, -0.1)); // color /= exp(0);
-  color*= exp(scale); // inverse + forward Reinhard tone mapping
-  return color / (1.0 + color);
-}
-
-// 0..+1
-float3 AdjustVibrance(float3 color, float scale) {
-  float average = (color.r + color.g + color.b) / 3.0;
-  float highest = max(color.r, max(color.g, color.b));
-  float amount = (average - highest) * scale;
-  return lerp(color, highest, amount);
-}
-
-// -1..+1
-float3 AdjustSaturation(float3 color, float amount) {
-  float luminance = dot(saturate(color), float3(0.2125, 0.7154, 0.0721));
-  return luminance + (color - luminance) * (amount + 1.0);
-}
-
-// -1..+1
-float3 AdjustGains(float3 color, float3 gains) {
-  return saturate(color * (gains + 1));
-}
-
-// 0..1 (https://www.desmos.com/calculator/wmiuegrnli)
-float3 AdjustHighlightsShadows(float3 color, float2 amount) {
-  float2 inv_hs = rcp(amount + 1.0);
-  float luma = dot(saturate(color), float3(0.3,0.3,0.3));
-  float h = 1.0 - SafePow((1.0 - luma), inv_hs.x); // highlights
-  float s = SafePow(luma, inv_hs.y); // shadows
-  return (color/luma) * (h + s - luma);
-}
+#include "postprocess.hlsli"
 
 float4 mainPostProcess(in float4 position : SV_POSITION, in float2 texcoord : TEXCOORD0) : SV_TARGET {
   float3 color = SAMPLE_TEXTURE(texcoord).rgb;
@@ -161,26 +47,8 @@ float4 mainPostProcess(in float4 position : SV_POSITION, in float2 texcoord : TE
 #ifdef POST_PROCESS_SRC_SRGB
   color = srgb2linear(color);
  #endif
-  
-  // adjust color input gains.
-  if (any(Params2.rgb)) {
-    color = AdjustGains(color, Params2.rgb);
-  }
-  // adjust lighting and saturation.
-  if (any(Params1)) {
-    color = AdjustContrast(color, Params1.x);
-    color = AdjustBrightness(color, Params1.y);
-    color = AdjustExposure(color, Params1.z);
-    color = AdjustSaturation(color, Params1.w);
-  }
-  // boost colors
-  if (any(Params3.z)) {
-    color = AdjustVibrance(color, Params3.z);
-  }
-  // expand/crush luma for output.
-  if (any(Params3.xy)) {
-    color = AdjustHighlightsShadows(color, Params3.xy);
-  }
+
+  color = PostProcessColor(color, Params1, Params2, Params3);
 
 #ifdef POST_PROCESS_DST_SRGB
   color = linear2srgb(color);
@@ -193,19 +61,14 @@ float4 mainPassThrough(in float4 position : SV_POSITION, in float2 texcoord : TE
 
   float3 color;
   if (Params3.w) {
-    float2 correctionOrigin = float2(0.313, 0.42);
-    if (Params4.w) {
-        correctionOrigin.x = 1 - correctionOrigin.x;
-    }
-
-    float2 uvr = ((texcoord - correctionOrigin) * Params4.r) + correctionOrigin;
-    color.r = SAMPLE_TEXTURE(uvr).r;
-
-    float2 uvg = ((texcoord - correctionOrigin) * Params4.g) + correctionOrigin;
-    color.g = SAMPLE_TEXTURE(uvg).g;
-
-    float2 uvb = ((texcoord - correctionOrigin) * Params4.b) + correctionOrigin;
-    color.b = SAMPLE_TEXTURE(uvb).b;
+    // The LUT texels are at the edges of their cell, in order to cover the view from 0 to 1.
+    float2 lutSize;
+    correctionLUT.GetDimensions(lutSize.x, lutSize.y);
+    const float4 uvrb = correctionLUT.Sample(sourceSampler, (texcoord * (lutSize - 1) + 0.5) / lutSize);
+
+    color.r = SAMPLE_TEXTURE(uvrb.xy).r;
+    color.g = SAMPLE_TEXTURE(texcoord).g;
+    color.b = SAMPLE_TEXTURE(uvrb.zw).b;
   } else {
     color = SAMPLE_TEXTURE(texcoord).rgb;
   }
@@ -0,0 +1,368 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+#include <wincodec.h>
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    // Screenshots are rare, we only need enough readbacks for both eyes of a couple of frames.
+    constexpr size_t MaxReadbacks = 4;
+
+    // The WIC equivalent of the texture formats that we can encode.
+    std::optional<WICPixelFormatGUID> getWICPixelFormat(int64_t format) {
+        switch ((DXGI_FORMAT)format) {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            return GUID_WICPixelFormat32bppRGBA;
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            return GUID_WICPixelFormat32bppBGRA;
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            return GUID_WICPixelFormat32bppBGR;
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+            return GUID_WICPixelFormat32bppRGBA1010102;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return GUID_WICPixelFormat64bppRGBAHalf;
+        default:
+            return {};
+        }
+    }
+
+    // Minimal DDS headers (see the DDS programming guide), we always use the DX10 extension.
+    struct DDSPixelFormat {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t rBitMask;
+        uint32_t gBitMask;
+        uint32_t bBitMask;
+        uint32_t aBitMask;
+    };
+
+    struct DDSHeader {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DDSPixelFormat pixelFormat;
+        uint32_t caps;
+        uint32_t caps2;
+        uint32_t caps3;
+        uint32_t caps4;
+        uint32_t reserved2;
+    };
+
+    struct DDSHeaderDXT10 {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    static_assert(sizeof(DDSHeader) == 124);
+
+    class ScreenshotCapture : public IScreenshotCapture {
+      public:
+        ScreenshotCapture(std::shared_ptr<IDevice> graphicsDevice) : m_device(graphicsDevice) {
+            m_thread = std::thread([&] { encodeLoop(); });
+        }
+
+        ~ScreenshotCapture() override {
+            {
+                std::unique_lock lock(m_mutex);
+                m_stop = true;
+            }
+            m_wakeUp.notify_one();
+            m_thread.join();
+        }
+
+        bool isFormatSupported(int64_t format) const override {
+            return getWICPixelFormat(format).has_value();
+        }
+
+        void capture(std::shared_ptr<ITexture> source,
+                     const XrRect2Di& region,
+                     int32_t slice,
+                     const std::filesystem::path& path) override {
+            auto info = source->getInfo();
+            info.arraySize = 1;
+            info.mipCount = 1;
+            info.width = region.extent.width;
+            info.height = region.extent.height;
+
+            // Reuse a readback of the same dimensions if possible.
+            std::shared_ptr<ITextureReadback> readback;
+            for (auto it = m_freeReadbacks.begin(); it != m_freeReadbacks.end(); it++) {
+                const auto& readbackInfo = (*it)->getInfo();
+                if (readbackInfo.width == info.width && readbackInfo.height == info.height &&
+                    readbackInfo.format == info.format) {
+                    readback = *it;
+                    m_freeReadbacks.erase(it);
+                    break;
+                }
+            }
+            if (!readback) {
+                if (m_pendingCaptures.size() + m_freeReadbacks.size() >= MaxReadbacks) {
+                    if (m_freeReadbacks.empty()) {
+                        Log("Too many screenshots in progress, skipping %S\n", path.c_str());
+                        return;
+                    }
+                    m_freeReadbacks.pop_back();
+                }
+                readback = m_device->createTextureReadback(info);
+            }
+
+            readback->copyFrom(source, region.offset.x, region.offset.y, slice);
+            m_pendingCaptures.push_back({readback, path});
+        }
+
+        void poll() override {
+            while (!m_pendingCaptures.empty() && m_pendingCaptures.front().readback->isReady()) {
+                auto& pending = m_pendingCaptures.front();
+                const auto& info = pending.readback->getInfo();
+
+                EncodeJob job;
+                job.path = pending.path;
+                job.width = info.width;
+                job.height = info.height;
+                job.format = info.format;
+                pending.readback->readPixels(job.pixels, job.rowPitch);
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_encodeQueue.push_back(std::move(job));
+                }
+                m_wakeUp.notify_one();
+
+                m_freeReadbacks.push_back(std::move(pending.readback));
+                m_pendingCaptures.pop_front();
+            }
+        }
+
+        void trim() override {
+            m_freeReadbacks.clear();
+        }
+
+      private:
+        struct PendingCapture {
+            std::shared_ptr<ITextureReadback> readback;
+            std::filesystem::path path;
+        };
+
+        struct EncodeJob {
+            std::filesystem::path path;
+            uint32_t width;
+            uint32_t height;
+            int64_t format;
+            std::vector<uint8_t> pixels;
+            uint32_t rowPitch;
+        };
+
+        void encodeLoop() {
+            utilities::RegisterThread(utilities::ThreadClass::Background);
+
+            const auto hrCoInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+            ComPtr<IWICImagingFactory> wicFactory;
+            HRESULT hr = CoCreateInstance(
+                CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(set(wicFactory)));
+            if (FAILED(hr)) {
+                Log("Failed to create WIC factory: 0x%x\n", hr);
+            }
+
+            std::unique_lock lock(m_mutex);
+            while (true) {
+                m_wakeUp.wait(lock, [&] { return m_stop || !m_encodeQueue.empty(); });
+                if (m_encodeQueue.empty()) {
+                    break;
+                }
+
+                auto job = std::move(m_encodeQueue.front());
+                m_encodeQueue.pop_front();
+
+                lock.unlock();
+                if (job.path.extension() == ".dds") {
+                    hr = writeDDS(job);
+                } else {
+                    hr = wicFactory ? encode(get(wicFactory), job) : E_NOINTERFACE;
+                }
+                if (SUCCEEDED(hr)) {
+                    Log("Screenshot saved to %S\n", job.path.c_str());
+                } else {
+                    Log("Failed to take screenshot: 0x%x\n", hr);
+                }
+                lock.lock();
+            }
+
+            wicFactory.Reset();
+            if (SUCCEEDED(hrCoInit)) {
+                CoUninitialize();
+            }
+
+            utilities::UnregisterThread();
+        }
+
+        static HRESULT writeDDS(const EncodeJob& job) {
+            const uint32_t bytesPerPixel = (DXGI_FORMAT)job.format == DXGI_FORMAT_R16G16B16A16_FLOAT ? 8 : 4;
+            const uint32_t pitch = job.width * bytesPerPixel;
+
+            DDSHeader header{};
+            header.size = sizeof(header);
+            header.flags = 0x1 /* CAPS */ | 0x2 /* HEIGHT */ | 0x4 /* WIDTH */ | 0x8 /* PITCH */ |
+                           0x1000 /* PIXELFORMAT */;
+            header.height = job.height;
+            header.width = job.width;
+            header.pitchOrLinearSize = pitch;
+            header.depth = 1;
+            header.mipMapCount = 1;
+            header.pixelFormat.size = sizeof(header.pixelFormat);
+            header.pixelFormat.flags = 0x4 /* FOURCC */;
+            header.pixelFormat.fourCC = 0x30315844 /* 'DX10' */;
+            header.caps = 0x1000 /* TEXTURE */;
+
+            DDSHeaderDXT10 header10{};
+            header10.dxgiFormat = (uint32_t)job.format;
+            header10.resourceDimension = 3 /* TEXTURE2D */;
+            header10.arraySize = 1;
+
+            std::ofstream file(job.path, std::ios::binary);
+            if (!file.is_open()) {
+                return E_ACCESSDENIED;
+            }
+            const uint32_t magic = 0x20534444 /* 'DDS ' */;
+            file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(&header10), sizeof(header10));
+
+            // The readback rows are padded, but DDS rows are tightly packed.
+            for (uint32_t y = 0; y < job.height; y++) {
+                file.write(reinterpret_cast<const char*>(job.pixels.data()) + (size_t)y * job.rowPitch, pitch);
+            }
+            return file ? S_OK : E_FAIL;
+        }
+
+        static HRESULT encode(IWICImagingFactory* wicFactory, const EncodeJob& job) {
+            const auto& fileFormat = job.path.extension() == ".png"   ? GUID_ContainerFormatPng
+                                     : job.path.extension() == ".bmp" ? GUID_ContainerFormatBmp
+                                                                      : GUID_ContainerFormatJpeg;
+            WICPixelFormatGUID pixelFormat = getWICPixelFormat(job.format).value();
+
+            ComPtr<IWICBitmap> bitmap;
+            HRESULT hr = wicFactory->CreateBitmapFromMemory(job.width,
+                                                            job.height,
+                                                            pixelFormat,
+                                                            job.rowPitch,
+                                                            (UINT)job.pixels.size(),
+                                                            const_cast<BYTE*>(job.pixels.data()),
+                                                            set(bitmap));
+            if (FAILED(hr)) {
+                return hr;
+            }
+
+            ComPtr<IWICStream> stream;
+            hr = wicFactory->CreateStream(set(stream));
+            if (SUCCEEDED(hr)) {
+                hr = stream->InitializeFromFilename(job.path.c_str(), GENERIC_WRITE);
+            }
+            ComPtr<IWICBitmapEncoder> encoder;
+            if (SUCCEEDED(hr)) {
+                hr = wicFactory->CreateEncoder(fileFormat, nullptr, set(encoder));
+            }
+            if (SUCCEEDED(hr)) {
+                hr = encoder->Initialize(get(stream), WICBitmapEncoderNoCache);
+            }
+            ComPtr<IWICBitmapFrameEncode> frame;
+            ComPtr<IPropertyBag2> properties;
+            if (SUCCEEDED(hr)) {
+                hr = encoder->CreateNewFrame(set(frame), set(properties));
+            }
+            if (SUCCEEDED(hr)) {
+                hr = frame->Initialize(get(properties));
+            }
+            if (SUCCEEDED(hr)) {
+                hr = frame->SetSize(job.width, job.height);
+            }
+
+            // Screenshots don't typically include the alpha channel of the render target.
+            WICPixelFormatGUID targetFormat = GUID_WICPixelFormat24bppBGR;
+            if (SUCCEEDED(hr)) {
+                hr = frame->SetPixelFormat(&targetFormat);
+            }
+            ComPtr<IWICFormatConverter> converter;
+            if (SUCCEEDED(hr)) {
+                hr = wicFactory->CreateFormatConverter(set(converter));
+            }
+            if (SUCCEEDED(hr)) {
+                hr = converter->Initialize(
+                    get(bitmap), targetFormat, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeMedianCut);
+            }
+            if (SUCCEEDED(hr)) {
+                hr = frame->WriteSource(get(converter), nullptr);
+            }
+            if (SUCCEEDED(hr)) {
+                hr = frame->Commit();
+            }
+            if (SUCCEEDED(hr)) {
+                hr = encoder->Commit();
+            }
+            return hr;
+        }
+
+        const std::shared_ptr<IDevice> m_device;
+
+        // Only accessed by the application thread.
+        std::vector<std::shared_ptr<ITextureReadback>> m_freeReadbacks;
+        std::deque<PendingCapture> m_pendingCaptures;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        std::deque<EncodeJob> m_encodeQueue;
+        bool m_stop{false};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<IScreenshotCapture> CreateScreenshotCapture(std::shared_ptr<IDevice> graphicsDevice) {
+        return std::make_shared<ScreenshotCapture>(graphicsDevice);
+    }
+
+} // namespace toolkit::graphics
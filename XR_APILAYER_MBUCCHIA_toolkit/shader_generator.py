@@ -0,0 +1,110 @@
+# MIT License
+#
+# Copyright(c) 2022 Matthieu Bucchianeri
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this softwareand associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+#
+# The above copyright noticeand this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Compile the shader permutations at build time, and generate the resource script that embeds them into the DLL.
+# Usage: shader_generator.py <path to fxc.exe> <output directory> <configuration>
+
+import os
+import re
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+# Import configuration.
+import shader_permutations
+
+cur_dir = os.path.abspath(os.path.dirname(__file__))
+base_dir = os.path.abspath(os.path.join(cur_dir, '..'))
+
+fxc = sys.argv[1]
+out_dir = os.path.abspath(sys.argv[2])
+is_debug = len(sys.argv) > 3 and sys.argv[3] == 'Debug'
+
+# The same flags as utilities::shader::CompileShader().
+flags = ['/nologo', '/Zpc', '/Ges', '/WX'] + (['/Od', '/Zi'] if is_debug else ['/O3'])
+
+# The headers are patched and copied next to the output by the pre-build event.
+include_dirs = [out_dir, cur_dir]
+
+def get_resource_name(source, entry, target, defines):
+    '''Must match LoadPrecompiledShader() in utilities.cpp (FNV-1a).'''
+    key = '%s|%s|%s|' % (source, entry, target) + ''.join('%s=%s;' % define for define in defines)
+    value = 0xcbf29ce484222325
+    for byte in key.encode('utf-8'):
+        value = ((value ^ byte) * 0x100000001b3) & 0xffffffffffffffff
+    return 'SHADER_%016X' % value
+
+def find_builtin_sources():
+    sources = {}
+    for file in shader_permutations.builtin_shaders_files:
+        with open(os.path.join(cur_dir, file), 'r') as f:
+            for name, code in re.findall(r'const std::string_view (\w+) =\s*R"_\((.*?)\)_";', f.read(), re.DOTALL):
+                sources[name] = code
+    return sources
+
+def compile_shader(job):
+    source_file, entry, target, defines, output = job
+    command = [fxc] + flags + ['/T', target, '/E', entry, '/Fo', output]
+    command += ['/I' + include_dir for include_dir in include_dirs]
+    command += ['/D%s=%s' % define for define in defines]
+    command += [source_file]
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if result.returncode != 0:
+        raise Exception('Failed to compile %s (%s): %s' % (source_file, entry, result.stdout))
+
+jobs = {}
+def emit(source, entry, target, defines, source_file = None):
+    defines = defines.get() if isinstance(defines, shader_permutations.Defines) else defines
+    name = get_resource_name(source, entry, target, defines)
+    if name not in jobs:
+        output = os.path.join(out_dir, name + '.cso')
+        jobs[name] = (source_file or os.path.join(cur_dir, source), entry, target, defines, output)
+
+os.makedirs(out_dir, exist_ok=True)
+
+for permutations in shader_permutations.shader_permutations:
+    permutations(emit)
+
+builtin_sources = find_builtin_sources()
+for name, entry, target in shader_permutations.builtin_shaders:
+    source_file = os.path.join(out_dir, name + '.hlsl')
+    with open(source_file, 'w') as f:
+        f.write(builtin_sources[name])
+    emit(name, entry, target, [], source_file)
+
+# Only recompile the permutations that are older than any of the inputs.
+inputs = [os.path.join(cur_dir, file) for file in os.listdir(cur_dir) if file.endswith(('.hlsl', '.hlsli', '.py'))]
+inputs += [os.path.join(out_dir, file) for file in os.listdir(out_dir) if file.endswith('.h')]
+inputs += [os.path.join(cur_dir, file) for file in shader_permutations.builtin_shaders_files]
+newest_input = max(os.path.getmtime(file) for file in inputs)
+stale = [job for job in jobs.values() if not os.path.exists(job[4]) or os.path.getmtime(job[4]) < newest_input]
+
+with ThreadPoolExecutor() as executor:
+    list(executor.map(compile_shader, stale))
+
+with open(os.path.join(out_dir, 'shaders.gen.rc'), 'w') as f:
+    f.write('// *********** THIS FILE IS GENERATED - DO NOT EDIT ***********\n')
+    f.write('// Shader permutations precompiled by shader_generator.py.\n\n')
+    for name in sorted(jobs.keys()):
+        f.write('%s RCDATA "%s"\n' % (name, jobs[name][4].replace('\\', '\\\\')))
+
+print('Compiled %d of %d shader permutations' % (len(stale), len(jobs)))
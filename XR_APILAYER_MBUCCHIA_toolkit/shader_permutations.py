@@ -0,0 +1,185 @@
+# MIT License
+#
+# Copyright(c) 2022 Matthieu Bucchianeri
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this softwareand associated documentation files(the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions :
+#
+# The above copyright noticeand this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# The shader permutations that are compiled at build time and embedded into the DLL. They mirror the defines built by
+# the code (in the same order), so that they can be found again at runtime. A permutation that is not listed here is
+# still compiled from the shader file at runtime.
+
+class Defines:
+    '''Equivalent of utilities::shader::Defines.'''
+    def __init__(self):
+        self.defines = []
+
+    def add(self, name, value):
+        self.defines.append([name, Defines.to_str(value)])
+
+    def set(self, name, value):
+        for define in self.defines:
+            if define[0] == name:
+                define[1] = Defines.to_str(value)
+                break
+
+    def get(self):
+        return [tuple(define) for define in self.defines]
+
+    @staticmethod
+    def to_str(value):
+        return str(int(value)) if isinstance(value, bool) else str(value)
+
+# The thread group sizes candidates of ITunedComputeShader (shadertuning.cpp), for all architectures.
+tuning_candidates = [(8, 8), (16, 8), (8, 4), (16, 16)]
+
+def cas_permutations(emit):
+    for is_sharpen_only in [False, True]:
+        for is_fused in [False, True]:
+            for is_stereo in [False, True]:
+                defines = Defines()
+                defines.add('CAS_THREAD_GROUP_SIZE', 64)
+                defines.add('CAS_SAMPLE_FP16', 0)
+                defines.add('CAS_SAMPLE_SHARPEN_ONLY', 1 if is_sharpen_only else 0)
+                emit('CAS.hlsl', 'mainCS', 'cs_5_0', defines)
+                if is_fused:
+                    defines.add('POST_PROCESS_FUSED', 1)
+                    emit('CAS.hlsl', 'mainCS', 'cs_5_0', defines)
+                if is_stereo:
+                    defines.add('CAS_STEREO', 1)
+                    if is_fused:
+                        emit('CAS.hlsl', 'mainCS', 'cs_5_0', defines)
+                        defines.set('POST_PROCESS_FUSED', 0)
+                    emit('CAS.hlsl', 'mainCS', 'cs_5_0', defines)
+
+def fsr_permutations(emit):
+    for is_half_precision in [False, True]:
+        for is_fused in [False, True]:
+            for is_stereo in [False, True]:
+                defines = Defines()
+                defines.add('FSR_THREAD_GROUP_SIZE', 64)
+                defines.add('SAMPLE_SLOW_FALLBACK', not is_half_precision)
+                defines.add('SAMPLE_BILINEAR', 0)
+
+                defines.add('SAMPLE_RCAS', 0)
+                defines.add('SAMPLE_EASU', 1)
+                defines.add('SAMPLE_HDR_OUTPUT', 0)
+                emit('FSR.hlsl', 'mainCS', 'cs_5_0', defines)
+                if is_stereo:
+                    defines.add('FSR_STEREO', 1)
+                    emit('FSR.hlsl', 'mainCS', 'cs_5_0', defines)
+                    defines.set('FSR_STEREO', 0)
+
+                defines.set('SAMPLE_EASU', 0)
+                defines.set('SAMPLE_RCAS', 1)
+                defines.add('SAMPLE_HDR_OUTPUT', 1)
+                emit('FSR.hlsl', 'mainCS', 'cs_5_0', defines)
+                if is_fused:
+                    defines.add('POST_PROCESS_FUSED', 1)
+                    emit('FSR.hlsl', 'mainCS', 'cs_5_0', defines)
+                if is_stereo:
+                    defines.set('FSR_STEREO', 1)
+                    if is_fused:
+                        emit('FSR.hlsl', 'mainCS', 'cs_5_0', defines)
+                        defines.set('POST_PROCESS_FUSED', 0)
+                    emit('FSR.hlsl', 'mainCS', 'cs_5_0', defines)
+
+                single_pass = Defines()
+                single_pass.add('FSR_THREAD_GROUP_SIZE', 64)
+                single_pass.add('SAMPLE_SLOW_FALLBACK', not is_half_precision)
+                single_pass.add('SAMPLE_BILINEAR', 0)
+                single_pass.add('SAMPLE_EASU', 1)
+                single_pass.add('SAMPLE_RCAS', 1)
+                single_pass.add('SAMPLE_HDR_OUTPUT', 1)
+                single_pass.add('SAMPLE_SINGLE_PASS', 1)
+                single_pass.add('FSR_STEREO', 0)
+                single_pass.add('POST_PROCESS_FUSED', 0)
+                emit('FSR.hlsl', 'mainCS', 'cs_5_0', single_pass)
+                if is_fused:
+                    single_pass.set('POST_PROCESS_FUSED', 1)
+                    emit('FSR.hlsl', 'mainCS', 'cs_5_0', single_pass)
+                if is_stereo:
+                    single_pass.set('FSR_STEREO', 1)
+                    if is_fused:
+                        emit('FSR.hlsl', 'mainCS', 'cs_5_0', single_pass)
+                    single_pass.set('POST_PROCESS_FUSED', 0)
+                    emit('FSR.hlsl', 'mainCS', 'cs_5_0', single_pass)
+
+def nis_permutations(emit):
+    # The block and thread group sizes picked by NISOptimizer for the generic architectures.
+    for block_width, block_height, thread_group_size in [(32, 24, 128), (32, 32, 256), (32, 32, 128), (32, 24, 256)]:
+        for is_sharpen_only in [False, True]:
+            defines = Defines()
+            defines.add('NIS_SCALER', not is_sharpen_only)
+            defines.add('NIS_HDR_MODE', 0)
+            defines.add('NIS_BLOCK_WIDTH', block_width)
+            defines.add('NIS_BLOCK_HEIGHT', block_height)
+            defines.add('NIS_THREAD_GROUP_SIZE', thread_group_size)
+            emit('NIS.hlsl', 'main', 'cs_5_0', defines)
+
+def vrs_permutations(emit):
+    for tile_size in [8, 16, 32]:
+        defines = Defines()
+        defines.add('VRS_TILE_X', tile_size)
+        defines.add('VRS_TILE_Y', tile_size)
+        defines.add('VRS_NUM_RATES', 3)
+        defines.add('VRS_NUM_THREADS_X', 8)
+        defines.add('VRS_NUM_THREADS_Y', 8)
+        for width, height in tuning_candidates:
+            defines.set('VRS_NUM_THREADS_X', width)
+            defines.set('VRS_NUM_THREADS_Y', height)
+            emit('VRS.hlsl', 'mainCS', 'cs_5_0', defines)
+        defines.set('VRS_NUM_THREADS_X', 8)
+        defines.set('VRS_NUM_THREADS_Y', 8)
+        defines.add('VRS_CONTENT_ANALYSIS', True)
+        emit('VRS.hlsl', 'mainCS', 'cs_5_0', defines)
+
+def temporal_permutations(emit):
+    for width, height in tuning_candidates:
+        defines = Defines()
+        defines.add('TEMPORAL_THREAD_GROUP_SIZE_X', width)
+        defines.add('TEMPORAL_THREAD_GROUP_SIZE_Y', height)
+        emit('Temporal.hlsl', 'mainCS', 'cs_5_0', defines)
+
+def postprocess_permutations(emit):
+    defines = Defines()
+    defines.add('PASS_THROUGH_USE_GAINS', True)
+    emit('postprocess.hlsl', 'mainPassThrough', 'ps_5_0', defines)
+    emit('postprocess.hlsl', 'mainPostProcess', 'ps_5_0', defines)
+
+# The shader files of the layer.
+shader_permutations = [
+    cas_permutations,
+    fsr_permutations,
+    nis_permutations,
+    vrs_permutations,
+    temporal_permutations,
+    postprocess_permutations,
+]
+
+# The shaders embedded as strings in the code (see CompileBuiltInShader()): name, entry point, target.
+builtin_shaders_files = ['d3dcommon.h', 'd3d11.cpp']
+builtin_shaders = [
+    ('QuadVertexShader', 'vsMain', 'vs_5_0'),
+    ('MeshShaders', 'vsMain', 'vs_5_0'),
+    ('MeshShaders', 'vsMainInstanced', 'vs_5_0'),
+    ('MeshShaders', 'psMain', 'ps_5_0'),
+    ('TextShaders', 'vsMain', 'vs_5_0'),
+    ('TextShaders', 'psMain', 'ps_5_0'),
+    ('DebugWorkloadShader', 'main', 'cs_5_0'),
+]
@@ -48,6 +48,28 @@ namespace toolkit::utilities::shader {
         CompileShader(code.data(), code.size(), entryPoint, blob, nullptr, nullptr, target);
     }
 
+    // Retrieve the bytecode of a shader permutation compiled at build time (see shader_generator.py). The source name
+    // is the name of the shader file, or the name of the built-in shader.
+    bool LoadPrecompiledShader(std::string_view sourceName,
+                               const char* entryPoint,
+                               const D3D_SHADER_MACRO* defines,
+                               const char* target,
+                               ID3DBlob** blob);
+
+    // Compile one of the shaders embedded as strings in the code, unless it was precompiled.
+    void CompileBuiltInShader(
+        std::string_view name, std::string_view code, const char* entryPoint, ID3DBlob** blob, const char* target);
+
+    // Compile a shader file on a worker thread. The defines are copied, so they do not need to outlive the call. A
+    // compilation error is thrown upon retrieving the result. When allowed, the permutations compiled at build time
+    // are used instead, and the shader file is only compiled for the other permutations.
+    std::shared_future<ComPtr<ID3DBlob>> CompileShaderAsync(const std::filesystem::path& shaderFile,
+                                                            const std::string& entryPoint,
+                                                            const D3D_SHADER_MACRO* defines,
+                                                            const std::filesystem::path& includePath,
+                                                            const char* target,
+                                                            bool usePrecompiled = true);
+
     struct IncludeHeader : ID3DInclude {
         IncludeHeader(std::vector<std::filesystem::path> includePaths) : m_includePaths(std::move(includePaths)) {
         }
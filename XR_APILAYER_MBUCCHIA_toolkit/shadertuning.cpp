@@ -0,0 +1,233 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "layer.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    // The measurements of the first dispatches of each candidate are discarded (shader caches warming up).
+    constexpr uint32_t WarmupSamples = 2;
+
+    // The number of measurements of each candidate before picking the fastest one.
+    constexpr uint32_t TuningSamples = 20;
+
+    // The thread group sizes to try for each architecture. The first one is the default, which is used until the
+    // benchmark completes or when the tuning is disabled.
+    std::vector<XrExtent2Di> GetCandidates(GpuArchitecture architecture) {
+        switch (architecture) {
+        case GpuArchitecture::Intel:
+            // The SIMD8/SIMD16 execution units tend to prefer the smaller groups.
+            return {{8, 4}, {8, 8}, {16, 8}};
+
+        case GpuArchitecture::AMD:
+        case GpuArchitecture::NVidia:
+        default:
+            // One or two waves of 32/64 threads per group, either square or wide.
+            return {{8, 8}, {16, 8}, {8, 4}, {16, 16}};
+        }
+    }
+
+    class TunedComputeShader : public ITunedComputeShader {
+      public:
+        TunedComputeShader(std::shared_ptr<IConfigManager> configManager,
+                           std::shared_ptr<IDevice> graphicsDevice,
+                           const std::string& name,
+                           std::function<std::shared_ptr<IComputeShader>(const XrExtent2Di&)> createShader)
+            : m_device(graphicsDevice), m_name(name), m_registryKey(xr::utf8_to_wide(RegPrefix + "\\tuning")),
+              m_registryValue(xr::utf8_to_wide(name + " " + graphicsDevice->getDeviceName())) {
+            const auto candidates = GetCandidates(GetGpuArchitecture(m_device));
+
+            // The winner is remembered for each adapter, since the benchmark disturbs the first frames.
+            const auto cached = utilities::RegGetDword(HKEY_CURRENT_USER, m_registryKey, m_registryValue);
+            if (cached) {
+                const XrExtent2Di size{(int32_t)((uint32_t)cached.value() >> 16),
+                                       (int32_t)((uint32_t)cached.value() & 0xffff)};
+                if (std::find_if(candidates.cbegin(), candidates.cend(), [&](const XrExtent2Di& candidate) {
+                        return candidate.width == size.width && candidate.height == size.height;
+                    }) != candidates.cend()) {
+                    addCandidate(size, createShader);
+                    Log("Using %dx%d thread groups for %s (tuned)\n", size.width, size.height, m_name.c_str());
+                    m_isTuned = true;
+                    return;
+                }
+            }
+
+            if (!configManager->getValue(SettingShaderTuning)) {
+                addCandidate(candidates[0], createShader);
+                m_isTuned = true;
+                return;
+            }
+
+            for (const auto& candidate : candidates) {
+                addCandidate(candidate, createShader);
+                m_candidates.back().timer = m_device->createTimer();
+            }
+        }
+
+        void beginDispatch() override {
+            if (m_isTuned) {
+                return;
+            }
+
+            // There is only one timer per candidate: move to the next candidate once its measurement is collected.
+            if (m_isPending) {
+                auto& candidate = m_candidates[m_current];
+                if (!candidate.timer->isReady()) {
+                    // Do not stall, and skip the measurement of this dispatch.
+                    return;
+                }
+                m_isPending = false;
+
+                const auto durationUs = candidate.timer->query();
+                if (candidate.numSamples++ >= WarmupSamples) {
+                    candidate.durationUs += durationUs;
+                    candidate.numThreads += m_pendingThreads;
+                }
+
+                if (std::all_of(m_candidates.cbegin(), m_candidates.cend(), [](const Candidate& candidate) {
+                        return candidate.numSamples >= WarmupSamples + TuningSamples;
+                    })) {
+                    finishTuning();
+                    return;
+                }
+                m_current = (m_current + 1) % m_candidates.size();
+            }
+
+            m_candidates[m_current].timer->start();
+            m_isMeasuring = true;
+        }
+
+        void endDispatch() override {
+            if (!m_isMeasuring) {
+                return;
+            }
+            auto& candidate = m_candidates[m_current];
+            candidate.timer->stop();
+            m_isMeasuring = false;
+            m_isPending = true;
+
+            // The dispatches may cover regions of different sizes: the candidates are compared by time per thread.
+            const auto& threadGroups = candidate.shader->getThreadGroups();
+            m_pendingThreads = (uint64_t)threadGroups[0] * threadGroups[1] * threadGroups[2] * candidate.size.width *
+                               candidate.size.height;
+        }
+
+        std::shared_ptr<IComputeShader> getShader() const override {
+            return m_candidates[m_current].shader;
+        }
+
+        XrExtent2Di getThreadGroupSize() const override {
+            return m_candidates[m_current].size;
+        }
+
+        bool isTuned() const override {
+            return m_isTuned;
+        }
+
+      private:
+        struct Candidate {
+            XrExtent2Di size;
+            std::shared_ptr<IComputeShader> shader;
+            std::shared_ptr<IGpuTimer> timer;
+            uint32_t numSamples{0};
+            uint64_t durationUs{0};
+            uint64_t numThreads{0};
+        };
+
+        void addCandidate(const XrExtent2Di& size,
+                          const std::function<std::shared_ptr<IComputeShader>(const XrExtent2Di&)>& createShader) {
+            Candidate candidate;
+            candidate.size = size;
+            candidate.shader = createShader(size);
+            m_candidates.push_back(std::move(candidate));
+        }
+
+        void finishTuning() {
+            size_t best = 0;
+            double bestCost = std::numeric_limits<double>::max();
+            for (size_t i = 0; i < m_candidates.size(); i++) {
+                const auto& candidate = m_candidates[i];
+                const double cost = (double)candidate.durationUs / std::max(candidate.numThreads, (uint64_t)1);
+                Log("Thread groups %dx%d for %s: %.3f us per 1000 threads\n",
+                    candidate.size.width,
+                    candidate.size.height,
+                    m_name.c_str(),
+                    cost * 1000);
+                if (cost < bestCost) {
+                    best = i;
+                    bestCost = cost;
+                }
+            }
+
+            // Only keep the winner.
+            auto winner = std::move(m_candidates[best]);
+            winner.timer.reset();
+            m_candidates.clear();
+            m_candidates.push_back(std::move(winner));
+            m_current = 0;
+            m_isTuned = true;
+
+            const auto& size = m_candidates[0].size;
+            Log("Using %dx%d thread groups for %s\n", size.width, size.height, m_name.c_str());
+            utilities::RegSetDword(HKEY_CURRENT_USER,
+                                   m_registryKey,
+                                   m_registryValue,
+                                   ((DWORD)size.width << 16) | (DWORD)size.height);
+        }
+
+        const std::shared_ptr<IDevice> m_device;
+        const std::string m_name;
+        const std::wstring m_registryKey;
+        const std::wstring m_registryValue;
+
+        std::vector<Candidate> m_candidates;
+        size_t m_current{0};
+        bool m_isTuned{false};
+        bool m_isMeasuring{false};
+        bool m_isPending{false};
+        uint64_t m_pendingThreads{0};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<ITunedComputeShader>
+    CreateTunedComputeShader(std::shared_ptr<IConfigManager> configManager,
+                             std::shared_ptr<IDevice> graphicsDevice,
+                             const std::string& name,
+                             std::function<std::shared_ptr<IComputeShader>(const XrExtent2Di&)> createShader) {
+        return std::make_shared<TunedComputeShader>(configManager, graphicsDevice, name, createShader);
+    }
+
+} // namespace toolkit::graphics
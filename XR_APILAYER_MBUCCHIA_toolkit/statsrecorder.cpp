@@ -0,0 +1,247 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::log;
+    using namespace toolkit::utilities;
+
+    // Must be a power of 2. This is several seconds worth of frames, way more than the background thread latency.
+    constexpr size_t RingCapacity = 8192;
+    static_assert((RingCapacity & (RingCapacity - 1)) == 0);
+
+    constexpr auto DrainPeriod = std::chrono::milliseconds(100);
+    constexpr uint64_t WindowDurationUs = 1000000;
+
+    // The binary file is the header followed by the raw FrameStatistics records.
+    struct FileHeader {
+        char magic[4]{'X', 'T', 'S', 'R'};
+        uint32_t version{3};
+        uint32_t recordSize{sizeof(FrameStatistics)};
+    };
+    static_assert(sizeof(FrameStatistics) == 104, "FrameStatistics must not have padding");
+
+    struct Metric {
+        const char* name;
+        uint32_t FrameStatistics::*value;
+    };
+
+    const Metric Metrics[] = {
+        {"appCPU", &FrameStatistics::appCpuTimeUs},
+        {"renderCPU", &FrameStatistics::renderCpuTimeUs},
+        {"appGPU", &FrameStatistics::appGpuTimeUs},
+        {"wait", &FrameStatistics::waitCpuTimeUs},
+        {"endFrame", &FrameStatistics::endFrameCpuTimeUs},
+        {"overlayGPU", &FrameStatistics::overlayGpuTimeUs},
+        {"inputLatency", &FrameStatistics::inputLatencyUs},
+        {"waitLatency", &FrameStatistics::waitLatencyUs},
+        {"beginLatency", &FrameStatistics::beginLatencyUs},
+        {"renderLatency", &FrameStatistics::renderLatencyUs},
+        {"endFrameLatency", &FrameStatistics::endFrameLatencyUs},
+        {"submitLatency", &FrameStatistics::submitLatencyUs},
+    };
+
+    // Nearest-rank percentile of a sorted set.
+    uint32_t getPercentile(const std::vector<uint32_t>& sorted, uint32_t percentile) {
+        const size_t rank = (sorted.size() * percentile + 99) / 100;
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    class StatisticsRecorder : public IStatisticsRecorder {
+      public:
+        StatisticsRecorder(const std::filesystem::path& basePath) {
+            const auto samplesFile = basePath.string() + ".bin";
+            const auto percentilesFile = basePath.string() + "_percentiles.csv";
+
+            m_samplesFile.open(samplesFile, std::ios_base::binary);
+            const FileHeader header;
+            m_samplesFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            m_percentilesFile.open(percentilesFile);
+            m_percentilesFile << "time (s),frames,1% low (FPS)";
+            for (const auto& name : {"frame", "sclGPU", "pstGPU"}) {
+                m_percentilesFile << "," << name << " p50 (us)," << name << " p95 (us)," << name << " p99 (us)";
+            }
+            for (const auto& metric : Metrics) {
+                m_percentilesFile << "," << metric.name << " p50 (us)," << metric.name << " p95 (us)," << metric.name
+                                  << " p99 (us)";
+            }
+            m_percentilesFile << "\n";
+
+            Log("Recording per-frame statistics to %s\n", samplesFile.c_str());
+
+            m_thread = std::thread([&] { drainLoop(); });
+        }
+
+        ~StatisticsRecorder() override {
+            {
+                std::unique_lock lock(m_mutex);
+                m_stop = true;
+            }
+            m_wakeUp.notify_one();
+            m_thread.join();
+
+            if (m_droppedSamples) {
+                Log("Statistics recorder dropped %u samples\n", m_droppedSamples.load());
+            }
+        }
+
+        void record(const FrameStatistics& frame) override {
+            // Single producer: only the consumer can move the tail concurrently.
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if (head - m_tail.load(std::memory_order_acquire) == RingCapacity) {
+                m_droppedSamples.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            m_ring[head % RingCapacity] = frame;
+            m_head.store(head + 1, std::memory_order_release);
+        }
+
+      private:
+        void drainLoop() {
+            RegisterThread(ThreadClass::Background);
+
+            std::unique_lock lock(m_mutex);
+            while (!m_stop) {
+                m_wakeUp.wait_for(lock, DrainPeriod, [&] { return m_stop; });
+
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+
+            if (!m_window.empty()) {
+                flushWindow();
+            }
+            m_samplesFile.flush();
+            m_percentilesFile.flush();
+
+            UnregisterThread();
+        }
+
+        void drain() {
+            auto tail = m_tail.load(std::memory_order_relaxed);
+            const auto head = m_head.load(std::memory_order_acquire);
+            while (tail != head) {
+                const auto& frame = m_ring[tail % RingCapacity];
+                m_samplesFile.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+
+                if (m_window.empty()) {
+                    m_windowStartUs = frame.timeUs;
+                } else if (frame.timeUs - m_windowStartUs >= WindowDurationUs) {
+                    flushWindow();
+                    m_windowStartUs = frame.timeUs;
+                }
+                if (m_lastFrameTimeUs) {
+                    m_frameTimes.push_back((uint32_t)(frame.timeUs - m_lastFrameTimeUs));
+                }
+                m_lastFrameTimeUs = frame.timeUs;
+                m_window.push_back(frame);
+
+                tail++;
+            }
+            m_tail.store(tail, std::memory_order_release);
+        }
+
+        void flushWindow() {
+            if (!m_startTimeUs) {
+                m_startTimeUs = m_windowStartUs;
+            }
+            m_percentilesFile << std::fixed << std::setprecision(1) << (m_windowStartUs - m_startTimeUs) / 1e6 << ","
+                              << m_window.size() << ",";
+
+            // The 1% low is the average framerate over the slowest 1% of the frames.
+            std::sort(m_frameTimes.begin(), m_frameTimes.end());
+            if (!m_frameTimes.empty()) {
+                const size_t count = std::max<size_t>(m_frameTimes.size() / 100, 1);
+                const uint64_t total = std::accumulate(m_frameTimes.end() - count, m_frameTimes.end(), uint64_t(0));
+                m_percentilesFile << (total ? count * 1e6 / total : 0.0);
+            }
+
+            const auto writePercentiles = [&](std::vector<uint32_t>& values) {
+                std::sort(values.begin(), values.end());
+                for (const auto percentile : {50u, 95u, 99u}) {
+                    m_percentilesFile << ",";
+                    if (!values.empty()) {
+                        m_percentilesFile << getPercentile(values, percentile);
+                    }
+                }
+            };
+            writePercentiles(m_frameTimes);
+            for (uint32_t i = 0; i < 2; i++) {
+                m_values.clear();
+                for (const auto& frame : m_window) {
+                    m_values.push_back(frame.processorGpuTimeUs[i]);
+                }
+                writePercentiles(m_values);
+            }
+            for (const auto& metric : Metrics) {
+                m_values.clear();
+                for (const auto& frame : m_window) {
+                    m_values.push_back(frame.*metric.value);
+                }
+                writePercentiles(m_values);
+            }
+            m_percentilesFile << "\n";
+
+            m_window.clear();
+            m_frameTimes.clear();
+        }
+
+        std::array<FrameStatistics, RingCapacity> m_ring;
+        std::atomic<size_t> m_head{0};
+        std::atomic<size_t> m_tail{0};
+        std::atomic<uint32_t> m_droppedSamples{0};
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        bool m_stop{false};
+
+        // Only accessed by the background thread.
+        std::ofstream m_samplesFile;
+        std::ofstream m_percentilesFile;
+        std::vector<FrameStatistics> m_window;
+        std::vector<uint32_t> m_frameTimes;
+        std::vector<uint32_t> m_values;
+        uint64_t m_windowStartUs{0};
+        uint64_t m_startTimeUs{0};
+        uint64_t m_lastFrameTimeUs{0};
+    };
+
+} // namespace
+
+namespace toolkit::utilities {
+
+    std::shared_ptr<IStatisticsRecorder> CreateStatisticsRecorder(const std::filesystem::path& basePath) {
+        return std::make_shared<StatisticsRecorder>(basePath);
+    }
+
+} // namespace toolkit::utilities
@@ -0,0 +1,321 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace toolkit::log;
+    using namespace toolkit::menu;
+
+    // The frames right after a change of settings are not measured, to let the pipeline (and the dynamic resolution and
+    // the GPU clocks) settle.
+    constexpr uint32_t SettleFrames = 45;
+
+    // A combination is considered to hold the target frame rate with a small jitter of the frame times.
+    constexpr double TargetTolerance = 1.05;
+
+    // Nearest-rank percentile of a sorted set.
+    uint32_t getPercentile(const std::vector<uint32_t>& sorted, uint32_t percentile) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        const size_t rank = (sorted.size() * percentile + 99) / 100;
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    // One combination of settings of the grid, and what was measured with it.
+    struct Step {
+        std::vector<std::pair<Setting, int>> values;
+
+        std::vector<uint32_t> frameTimesUs;
+        std::vector<uint32_t> appCpuTimesUs;
+        std::vector<uint32_t> appGpuTimesUs;
+        std::vector<uint32_t> processorGpuTimesUs[2];
+        std::map<std::string, uint64_t> gpuProfileScopesUs;
+    };
+
+    class PerformanceSweeper : public IPerformanceSweeper {
+      public:
+        PerformanceSweeper(std::shared_ptr<IConfigManager> configManager,
+                           const std::filesystem::path& reportPath,
+                           const PerformanceSweepInfo& info)
+            : m_configManager(configManager), m_reportPath(reportPath), m_info(info) {
+            m_framesPerStep = std::max(m_configManager->getValue(SettingBenchmarkSweepFrames), 10);
+            const int targetFrameRate = m_configManager->getValue(SettingBenchmarkSweepTarget);
+            m_targetFrameTimeUs = targetFrameRate > 0 ? 1e6 / targetFrameRate : m_info.displayPeriodUs;
+
+            buildGrid();
+            if (m_steps.empty()) {
+                throw std::runtime_error("No setting to sweep in this session");
+            }
+
+            for (const auto& [setting, value] : m_steps[0].values) {
+                m_originalValues.push_back({setting, m_configManager->getValue(setting)});
+            }
+
+            Log("Starting benchmark sweep of %zu combinations, %u frames each\n", m_steps.size(), m_framesPerStep);
+            applyStep();
+        }
+
+        ~PerformanceSweeper() override {
+            if (!m_isDone) {
+                Log("Benchmark sweep was interrupted\n");
+                for (const auto& [setting, value] : m_originalValues) {
+                    m_configManager->setValue(setting, value);
+                }
+            }
+        }
+
+        void recordFrame(const utilities::FrameStatistics& frame,
+                         const graphics::GpuProfileScope* gpuProfileScopes,
+                         uint32_t numGpuProfileScopes) override {
+            if (m_isDone) {
+                return;
+            }
+
+            const uint64_t lastFrameTimeUs = std::exchange(m_lastFrameTimeUs, frame.timeUs);
+            if (m_settleFrames) {
+                m_settleFrames--;
+                return;
+            }
+
+            auto& step = m_steps[m_currentStep];
+            step.frameTimesUs.push_back((uint32_t)(frame.timeUs - lastFrameTimeUs));
+            step.appCpuTimesUs.push_back(frame.appCpuTimeUs);
+            step.appGpuTimesUs.push_back(frame.appGpuTimeUs);
+            for (uint32_t i = 0; i < 2; i++) {
+                step.processorGpuTimesUs[i].push_back(frame.processorGpuTimeUs[i]);
+            }
+            for (uint32_t i = 0; i < numGpuProfileScopes; i++) {
+                step.gpuProfileScopesUs[getScopeName(gpuProfileScopes, i)] += gpuProfileScopes[i].durationUs;
+            }
+
+            if (step.frameTimesUs.size() >= m_framesPerStep) {
+                if (++m_currentStep < m_steps.size()) {
+                    applyStep();
+                } else {
+                    finish();
+                }
+            }
+        }
+
+        bool isDone() const override {
+            return m_isDone;
+        }
+
+      private:
+        // The grid only covers the settings that take effect without restarting the session. It is ordered from the
+        // highest to the lowest visual quality, so the first combination to hold the target frame rate is the best.
+        void buildGrid() {
+            std::vector<std::vector<std::pair<Setting, int>>> vrsValues;
+            if (m_info.sweepVariableRateShading) {
+                for (int quality = (int)VariableShadingRateQuality::MaxValue - 1; quality >= 0; quality--) {
+                    for (int pattern = 0; pattern < (int)VariableShadingRatePattern::MaxValue; pattern++) {
+                        vrsValues.push_back({{SettingVRS, (int)VariableShadingRateType::Preset},
+                                             {SettingVRSQuality, quality},
+                                             {SettingVRSPattern, pattern}});
+                    }
+                }
+                vrsValues.insert(vrsValues.begin(),
+                                 {{SettingVRS, (int)VariableShadingRateType::None},
+                                  {SettingVRSQuality, m_configManager->getValue(SettingVRSQuality)},
+                                  {SettingVRSPattern, m_configManager->getValue(SettingVRSPattern)}});
+            } else {
+                vrsValues.push_back({});
+            }
+
+            std::vector<std::vector<std::pair<Setting, int>>> mipMapBiasValues;
+            if (m_info.sweepMipMapBias) {
+                for (int bias = (int)MipMapBias::MaxValue - 1; bias >= 0; bias--) {
+                    mipMapBiasValues.push_back({{SettingMipMapBias, bias}});
+                }
+            } else {
+                mipMapBiasValues.push_back({});
+            }
+
+            for (const auto& vrs : vrsValues) {
+                for (const auto& mipMapBias : mipMapBiasValues) {
+                    Step step;
+                    step.values = vrs;
+                    step.values.insert(step.values.end(), mipMapBias.cbegin(), mipMapBias.cend());
+                    if (!step.values.empty()) {
+                        m_steps.push_back(std::move(step));
+                    }
+                }
+            }
+        }
+
+        void applyStep() {
+            for (const auto& [setting, value] : m_steps[m_currentStep].values) {
+                m_configManager->setValue(setting, value);
+            }
+            m_settleFrames = SettleFrames;
+        }
+
+        void finish() {
+            m_isDone = true;
+
+            for (auto& step : m_steps) {
+                std::sort(step.frameTimesUs.begin(), step.frameTimesUs.end());
+                std::sort(step.appCpuTimesUs.begin(), step.appCpuTimesUs.end());
+                std::sort(step.appGpuTimesUs.begin(), step.appGpuTimesUs.end());
+                for (auto& times : step.processorGpuTimesUs) {
+                    std::sort(times.begin(), times.end());
+                }
+            }
+
+            // Pick the highest quality that holds the target, or else the fastest.
+            const auto bestStep = std::find_if(m_steps.cbegin(), m_steps.cend(), [&](const Step& step) {
+                return getPercentile(step.frameTimesUs, 95) <= m_targetFrameTimeUs * TargetTolerance;
+            });
+            const auto fastestStep =
+                std::min_element(m_steps.cbegin(), m_steps.cend(), [](const Step& a, const Step& b) {
+                    return getPercentile(a.frameTimesUs, 95) < getPercentile(b.frameTimesUs, 95);
+                });
+            const auto& best = bestStep != m_steps.cend() ? *bestStep : *fastestStep;
+
+            writeReport(best, bestStep != m_steps.cend());
+
+            for (const auto& [setting, value] : best.values) {
+                m_configManager->setValue(setting, value);
+            }
+            Log("Benchmark sweep suggests %s%s\n",
+                getStepName(best).c_str(),
+                bestStep != m_steps.cend() ? "" : " (target frame rate not reached)");
+        }
+
+        void writeReport(const Step& best, bool isTargetReached) const {
+            std::ofstream report(m_reportPath);
+            if (!report.is_open()) {
+                Log("Failed to write benchmark sweep report to %s\n", m_reportPath.string().c_str());
+                return;
+            }
+
+            std::set<std::string> scopeNames;
+            for (const auto& step : m_steps) {
+                for (const auto& [name, totalUs] : step.gpuProfileScopesUs) {
+                    scopeNames.insert(name);
+                }
+            }
+
+            report << "# Application: " << m_info.applicationName << "\n";
+            report << "# Session: " << m_info.sessionDescription << "\n";
+            report << "# Target frame time (us): " << std::fixed << std::setprecision(0) << m_targetFrameTimeUs
+                   << "\n";
+
+            for (const auto& [setting, value] : m_steps[0].values) {
+                report << setting.name << ",";
+            }
+            report << "frames";
+            for (const auto& name : {"frame", "appCPU", "appGPU", "sclGPU", "pstGPU"}) {
+                report << "," << name << " p50 (us)," << name << " p95 (us)," << name << " p99 (us)";
+            }
+            for (const auto& name : scopeNames) {
+                report << "," << name << " mean (us)";
+            }
+            report << "\n";
+
+            for (const auto& step : m_steps) {
+                for (const auto& [setting, value] : step.values) {
+                    report << value << ",";
+                }
+                report << step.frameTimesUs.size();
+                for (const auto* times : {&step.frameTimesUs,
+                                          &step.appCpuTimesUs,
+                                          &step.appGpuTimesUs,
+                                          &step.processorGpuTimesUs[0],
+                                          &step.processorGpuTimesUs[1]}) {
+                    for (const auto percentile : {50u, 95u, 99u}) {
+                        report << "," << getPercentile(*times, percentile);
+                    }
+                }
+                for (const auto& name : scopeNames) {
+                    const auto it = step.gpuProfileScopesUs.find(name);
+                    report << ",";
+                    if (it != step.gpuProfileScopesUs.cend() && !step.frameTimesUs.empty()) {
+                        report << it->second / step.frameTimesUs.size();
+                    }
+                }
+                report << "\n";
+            }
+
+            report << "# Suggested: " << getStepName(best)
+                   << (isTargetReached ? "" : " (target frame rate not reached, fastest combination)") << "\n";
+
+            Log("Benchmark sweep report written to %s\n", m_reportPath.string().c_str());
+        }
+
+        static std::string getStepName(const Step& step) {
+            std::string name;
+            for (const auto& [setting, value] : step.values) {
+                name += fmt::format("{}{}={}", name.empty() ? "" : " ", setting.name, value);
+            }
+            return name;
+        }
+
+        // Nested scopes are named after their parents, since the same name may appear under different parents.
+        static std::string getScopeName(const graphics::GpuProfileScope* scopes, uint32_t index) {
+            std::string name = scopes[index].name;
+            uint32_t depth = scopes[index].depth;
+            for (uint32_t i = index; i > 0 && depth > 0; i--) {
+                if (scopes[i - 1].depth < depth) {
+                    depth = scopes[i - 1].depth;
+                    name = std::string(scopes[i - 1].name) + "/" + name;
+                }
+            }
+            return name;
+        }
+
+        const std::shared_ptr<IConfigManager> m_configManager;
+        const std::filesystem::path m_reportPath;
+        const PerformanceSweepInfo m_info;
+        uint32_t m_framesPerStep;
+        double m_targetFrameTimeUs;
+
+        std::vector<Step> m_steps;
+        std::vector<std::pair<Setting, int>> m_originalValues;
+        size_t m_currentStep{0};
+        uint32_t m_settleFrames{0};
+        uint64_t m_lastFrameTimeUs{0};
+        bool m_isDone{false};
+    };
+
+} // namespace
+
+namespace toolkit::menu {
+
+    std::shared_ptr<IPerformanceSweeper>
+    CreatePerformanceSweeper(std::shared_ptr<toolkit::config::IConfigManager> configManager,
+                             const std::filesystem::path& reportPath,
+                             const PerformanceSweepInfo& info) {
+        return std::make_shared<PerformanceSweeper>(configManager, reportPath, info);
+    }
+
+} // namespace toolkit::menu
@@ -0,0 +1,221 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::log;
+    using namespace toolkit::menu;
+
+    // The live statistics are published into a named file mapping (in the session namespace), so that external tools
+    // can read them without ETW sessions or files. The layout is:
+    //
+    //   SharedHeader                      The version and the sizes of the structures below, then the counters.
+    //   menu::MenuStatistics              The averaged statistics, as displayed in the overlay (once per window).
+    //   SharedFrame[SharedFrameCapacity]  A ring of the per-frame samples, indexed by frame number.
+    //
+    // The layer is the only writer, and it never waits on the readers. The sequence counter of the header is a seqlock:
+    // it is odd while a write is in progress. A reader must read the sequence, copy out what it needs, then read the
+    // sequence again, and retry if it changed or if it was odd. The frames of the ring older than the last
+    // SharedFrameCapacity - 1 frames are overwritten without notice. When a new process takes over the mapping from
+    // an exited one, the counters restart from 0 and the processId changes (within a write).
+    const std::string MappingName = "Local\\OpenXR_Toolkit_Telemetry";
+
+    constexpr uint32_t SharedMemoryVersion = 1;
+    constexpr uint32_t SharedFrameCapacity = 256;
+
+    struct SharedHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t statisticsSize;
+        uint32_t frameSize;
+        uint32_t frameCapacity;
+        uint32_t processId;
+        uint32_t reserved;
+        char applicationName[64];
+
+        std::atomic<uint64_t> sequence;
+
+        // The number of frames published so far: the last frame is at (frameCount - 1) % frameCapacity.
+        std::atomic<uint64_t> frameCount;
+
+        // The number of averaged statistics published so far.
+        std::atomic<uint64_t> statisticsCount;
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The seqlock must be lock-free across processes");
+
+    struct SharedFrame {
+        uint64_t frameIndex;
+        utilities::FrameStatistics frame;
+
+        // The GPU time of each profiler scope for this frame (see graphics::IGpuProfiler::query()).
+        uint32_t numGpuProfileScopes;
+        uint32_t reserved;
+        graphics::GpuProfileScope gpuProfileScopes[graphics::MaxGpuProfileScopes];
+    };
+
+    struct SharedMemory {
+        SharedHeader header;
+        MenuStatistics statistics;
+        SharedFrame frames[SharedFrameCapacity];
+    };
+    static_assert(std::is_trivially_copyable_v<MenuStatistics> && std::is_trivially_copyable_v<SharedFrame>);
+
+    class TelemetryPublisher : public ITelemetryPublisher {
+      public:
+        TelemetryPublisher(const std::string& appName) {
+            m_mapping.reset(CreateFileMappingA(INVALID_HANDLE_VALUE,
+                                               nullptr,
+                                               PAGE_READWRITE,
+                                               0,
+                                               (DWORD)sizeof(SharedMemory),
+                                               MappingName.c_str()));
+            if (!m_mapping) {
+                throw std::runtime_error(fmt::format("CreateFileMapping failed with error {}", GetLastError()));
+            }
+            // The mapping outlives its writer while a reader still holds it open.
+            const bool alreadyExists = GetLastError() == ERROR_ALREADY_EXISTS;
+
+            m_view.reset(static_cast<SharedMemory*>(
+                MapViewOfFile(m_mapping.get(), FILE_MAP_WRITE, 0, 0, sizeof(SharedMemory))));
+            if (!m_view) {
+                throw std::runtime_error(fmt::format("MapViewOfFile failed with error {}", GetLastError()));
+            }
+
+            auto& header = m_view.get()->header;
+            if (!alreadyExists) {
+                // The mapping is zero-initialized by the system. Publish the header last, so that readers never match
+                // an incomplete one.
+                initializeHeader(appName);
+                std::atomic_thread_fence(std::memory_order_release);
+                memcpy(header.magic, "XTTL", sizeof(header.magic));
+            } else {
+                // Only one process at a time may publish, since readers cannot tell the writers apart. Take over the
+                // mapping left behind by a writer that has exited.
+                const auto previousProcessId = header.processId;
+                if (isProcessAlive(previousProcessId)) {
+                    m_view.reset();
+                    m_mapping.reset();
+                    throw std::runtime_error("The telemetry is already published by another process");
+                }
+                Log("Taking over the telemetry of exited process %u\n", previousProcessId);
+
+                // The previous writer may have been terminated in the middle of a write, with an odd sequence.
+                auto& sequence = header.sequence;
+                sequence.store(sequence.load(std::memory_order_relaxed) | 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                auto& shared = *m_view.get();
+                memset(&shared.statistics, 0, sizeof(shared.statistics));
+                memset(shared.frames, 0, sizeof(shared.frames));
+                header.frameCount.store(0, std::memory_order_relaxed);
+                header.statisticsCount.store(0, std::memory_order_relaxed);
+                initializeHeader(appName);
+                memcpy(header.magic, "XTTL", sizeof(header.magic));
+                endWrite();
+            }
+
+            Log("Publishing telemetry to %s\n", MappingName.c_str());
+        }
+
+        void publishFrame(const utilities::FrameStatistics& frame,
+                          const graphics::GpuProfileScope* gpuProfileScopes,
+                          uint32_t numGpuProfileScopes) override {
+            SharedFrame sample;
+            sample.frameIndex = m_frameCount;
+            sample.frame = frame;
+            sample.numGpuProfileScopes = std::min(numGpuProfileScopes, (uint32_t)graphics::MaxGpuProfileScopes);
+            sample.reserved = 0;
+            std::copy_n(gpuProfileScopes, sample.numGpuProfileScopes, sample.gpuProfileScopes);
+            std::fill(std::begin(sample.gpuProfileScopes) + sample.numGpuProfileScopes,
+                      std::end(sample.gpuProfileScopes),
+                      graphics::GpuProfileScope{});
+
+            auto& shared = *m_view.get();
+            beginWrite();
+            memcpy(&shared.frames[m_frameCount % SharedFrameCapacity], &sample, sizeof(sample));
+            m_frameCount++;
+            shared.header.frameCount.store(m_frameCount, std::memory_order_relaxed);
+            endWrite();
+        }
+
+        void publishStatistics(const MenuStatistics& stats) override {
+            auto& shared = *m_view.get();
+            beginWrite();
+            memcpy(&shared.statistics, &stats, sizeof(stats));
+            shared.header.statisticsCount.fetch_add(1, std::memory_order_relaxed);
+            endWrite();
+        }
+
+      private:
+        void initializeHeader(const std::string& appName) {
+            auto& header = m_view.get()->header;
+            header.version = SharedMemoryVersion;
+            header.headerSize = sizeof(SharedHeader);
+            header.statisticsSize = sizeof(MenuStatistics);
+            header.frameSize = sizeof(SharedFrame);
+            header.frameCapacity = SharedFrameCapacity;
+            header.processId = GetCurrentProcessId();
+            strncpy_s(header.applicationName, appName.c_str(), _TRUNCATE);
+        }
+
+        static bool isProcessAlive(DWORD processId) {
+            wil::unique_handle process(OpenProcess(SYNCHRONIZE, FALSE, processId));
+            if (!process) {
+                // We might not be allowed to open an elevated process.
+                return GetLastError() == ERROR_ACCESS_DENIED;
+            }
+            return WaitForSingleObject(process.get(), 0) == WAIT_TIMEOUT;
+        }
+
+        void beginWrite() {
+            auto& sequence = m_view.get()->header.sequence;
+            sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        void endWrite() {
+            auto& sequence = m_view.get()->header.sequence;
+            sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        wil::unique_handle m_mapping;
+        wil::unique_mapview_ptr<SharedMemory> m_view;
+        uint64_t m_frameCount{0};
+    };
+
+} // namespace
+
+namespace toolkit::menu {
+
+    std::shared_ptr<ITelemetryPublisher> CreateTelemetryPublisher(const std::string& appName) {
+        return std::make_shared<TelemetryPublisher>(appName);
+    }
+
+} // namespace toolkit::menu
@@ -0,0 +1,289 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "shader_utilities.h"
+#include "factories.h"
+#include "interfaces.h"
+#include "layer.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    using namespace DirectX;
+
+    struct TemporalConstants {
+        XMFLOAT4X4 Reprojection; // Current view NDC to previous view clip space
+        float InputRect[4];      // Input offset (xy), input extent (zw)
+        float DepthRect[4];      // Depth offset (xy), depth extent (zw)
+        uint32_t OutputRect[4];  // Output offset (xy), output extent (zw)
+        float Params[4];         // History weight (x), depth without depth buffer (y), has history (z), depth mode (w)
+    };
+
+    // The state of the history of a view, kept in the per-swapchain blob.
+    struct TemporalHistory {
+        XMFLOAT4X4 previousViewProjection;
+        uint32_t previousIndex;
+        bool isValid;
+    };
+
+    // The history textures are ping-ponged: one is read (previous frame) while the other one is written (this frame).
+    constexpr size_t HistoryCount = 2;
+
+    // Temporal upscaler without jittering of the projection: the history only accumulates the camera motion of the
+    // views, reconstructed from the depth buffer submitted by the application and the change of view pose.
+    class TemporalUpscaler : public IImageProcessor {
+      public:
+        TemporalUpscaler(std::shared_ptr<IConfigManager> configManager,
+                         std::shared_ptr<IDevice> graphicsDevice,
+                         int settingScaling,
+                         int settingAnamorphic)
+            : m_configManager(configManager), m_device(graphicsDevice) {
+            initializeUpscaler();
+        }
+
+        void reload() override {
+            initializeUpscaler();
+        }
+
+        void update() override {
+        }
+
+        void process(const std::shared_ptr<ITexture>& input,
+                     const std::shared_ptr<ITexture>& output,
+                     std::vector<std::shared_ptr<ITexture>>& textures,
+                     std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                     std::array<uint8_t, 1024>& blob,
+                     std::optional<utilities::Eye> eye = std::nullopt,
+                     const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr,
+                     std::optional<TextureRegion> inputRegion = std::nullopt,
+                     std::optional<TextureRegion> outputRegion = std::nullopt) override {
+            const auto inputRect = inputRegion ? inputRegion->rect : getFullRect(input);
+            const auto outputRect = outputRegion ? outputRegion->rect : getFullRect(output);
+
+            // We need to use a per-instance blob, with one slot per eye.
+            static_assert(sizeof(TemporalHistory) * (utilities::ViewCount + 1) <= 1024);
+            const auto slot = to_integral(eye.value_or(utilities::Eye::Both));
+            TemporalHistory& history = reinterpret_cast<TemporalHistory*>(blob.data())[slot];
+            const auto& view = m_views[slot];
+
+            // The history may not be reused when it was (re)created or when the view cannot be reprojected.
+            const bool isNewHistory = updateHistoryTextures(textures, output, slot, outputRect.extent);
+            if (isNewHistory || !view) {
+                history.previousIndex = 0;
+                history.isValid = false;
+            }
+            const auto& previousHistory = textures[slot * HistoryCount + history.previousIndex];
+            const auto& currentHistory = textures[slot * HistoryCount + (history.previousIndex + 1) % HistoryCount];
+
+            const XMMATRIX viewProjection =
+                view ? xr::math::LoadInvertedXrPose(view->view.Pose) *
+                           xr::math::ComposeProjectionMatrix(view->view.Fov, view->view.NearFar)
+                     : XMMatrixIdentity();
+            const bool isDepthInverted = view && view->view.NearFar.Far < view->view.NearFar.Near;
+
+            TemporalConstants config{};
+            XMStoreFloat4x4(&config.Reprojection,
+                            XMMatrixTranspose(XMMatrixInverse(nullptr, viewProjection) *
+                                              XMLoadFloat4x4(&history.previousViewProjection)));
+            config.InputRect[0] = (float)inputRect.offset.x;
+            config.InputRect[1] = (float)inputRect.offset.y;
+            config.InputRect[2] = (float)inputRect.extent.width;
+            config.InputRect[3] = (float)inputRect.extent.height;
+            if (view && view->depth) {
+                config.DepthRect[0] = (float)view->depthRegion.rect.offset.x;
+                config.DepthRect[1] = (float)view->depthRegion.rect.offset.y;
+                config.DepthRect[2] = (float)view->depthRegion.rect.extent.width;
+                config.DepthRect[3] = (float)view->depthRegion.rect.extent.height;
+            }
+            config.OutputRect[0] = outputRect.offset.x;
+            config.OutputRect[1] = outputRect.offset.y;
+            config.OutputRect[2] = outputRect.extent.width;
+            config.OutputRect[3] = outputRect.extent.height;
+            config.Params[0] = std::clamp(m_configManager->getValue(SettingTemporalHistoryWeight), 0, 98) / 100.f;
+            // Without depth buffer, the scene is assumed to be at the far plane.
+            config.Params[1] = isDepthInverted ? 0.f : 1.f;
+            config.Params[2] = history.isValid ? 1.f : 0.f;
+            config.Params[3] = !(view && view->depth) ? 0.f : isDepthInverted ? 2.f : 1.f;
+
+            // The reprojection changes every frame, so the constants are always uploaded.
+            if (buffers.size() <= slot) {
+                buffers.resize(slot + 1);
+            }
+            auto& configBuffer = buffers[slot];
+            if (!configBuffer) {
+                configBuffer = m_device->createBuffer(sizeof(TemporalConstants), "Temporal Constants CB");
+            }
+            configBuffer->uploadData(&config, sizeof(config));
+
+            m_device->beginProfileScope("Temporal");
+            m_shaderTemporal->beginDispatch();
+            const auto shader = m_shaderTemporal->getShader();
+            shader->updateThreadGroups(getThreadGroups(outputRect.extent, m_shaderTemporal->getThreadGroupSize()));
+            m_device->setShader(shader, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, configBuffer);
+            m_device->setShaderInput(0, input, inputRegion ? inputRegion->slice : -1);
+            // Without depth buffer, bind any texture in its slot. It is not read from.
+            if (view && view->depth) {
+                m_device->setShaderInput(1, view->depth, view->depthRegion.slice);
+            } else {
+                m_device->setShaderInput(1, input, inputRegion ? inputRegion->slice : -1);
+            }
+            m_device->setShaderInput(2, previousHistory);
+            m_device->setShaderOutput(0, output, outputRegion ? outputRegion->slice : -1);
+            m_device->setShaderOutput(1, currentHistory);
+            m_device->dispatchShader();
+            m_shaderTemporal->endDispatch();
+            m_device->endProfileScope();
+
+            XMStoreFloat4x4(&history.previousViewProjection, viewProjection);
+            history.previousIndex = (history.previousIndex + 1) % HistoryCount;
+            history.isValid = !!view;
+        }
+
+        bool isIdentity() const override {
+            return false;
+        }
+
+        bool isStereoSupported() const override {
+            return false;
+        }
+
+        void processStereo(const std::shared_ptr<ITexture>& input,
+                           const std::shared_ptr<ITexture>& output,
+                           std::vector<std::shared_ptr<ITexture>>& textures,
+                           std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                           std::array<uint8_t, 1024>& blob,
+                           const std::array<TextureRegion, utilities::ViewCount>& inputRegions,
+                           const std::array<TextureRegion, utilities::ViewCount>& outputRegions,
+                           const std::shared_ptr<IShaderBuffer>& fusedPostProcess = nullptr) override {
+            throw std::runtime_error("Stereo mode is not supported by the temporal upscaler");
+        }
+
+        bool isFusedPostProcessSupported() const override {
+            return false;
+        }
+
+        std::shared_ptr<IShaderBuffer>
+        getFusedPostProcessConstants(std::vector<std::shared_ptr<IShaderBuffer>>& buffers,
+                                     std::array<uint8_t, 1024>& blob,
+                                     std::optional<utilities::Eye> eye = std::nullopt) override {
+            return nullptr;
+        }
+
+        void setFoveatedRegion(utilities::Eye eye, const std::optional<FoveatedRegion>& region) override {
+        }
+
+        void setTemporalView(utilities::Eye eye, const std::optional<TemporalViewInfo>& view) override {
+            m_views[to_integral(eye)] = view;
+        }
+
+      private:
+        // Returns true if the history textures of the view were (re)created.
+        bool updateHistoryTextures(std::vector<std::shared_ptr<ITexture>>& textures,
+                                   const std::shared_ptr<ITexture>& output,
+                                   size_t slot,
+                                   const XrExtent2Di& extent) {
+            if (textures.size() < (slot + 1) * HistoryCount) {
+                textures.resize((slot + 1) * HistoryCount);
+            }
+
+            auto& history = textures[slot * HistoryCount];
+            if (history && history->getInfo().width == extent.width && history->getInfo().height == extent.height) {
+                return false;
+            }
+
+            auto createInfo = output->getInfo();
+
+            // Single-surface, output viewport.
+            createInfo.arraySize = 1;
+            createInfo.mipCount = 1;
+            createInfo.sampleCount = 1;
+            createInfo.width = extent.width;
+            createInfo.height = extent.height;
+
+            // Enough precision to accumulate the frames.
+            createInfo.format = m_device->getTextureFormat(TextureFormat::R16G16B16A16_UNORM);
+
+            createInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+            for (size_t i = 0; i < HistoryCount; i++) {
+                // The previous texture may still be in use by the GPU.
+                auto& texture = textures[slot * HistoryCount + i];
+                if (texture) {
+                    m_device->releaseDeferred(std::move(texture));
+                }
+                texture = m_device->createTexture(createInfo, "Temporal History TEX2D");
+            }
+
+            return true;
+        }
+
+        static XrRect2Di getFullRect(const std::shared_ptr<ITexture>& texture) {
+            return {{0, 0}, {(int32_t)texture->getInfo().width, (int32_t)texture->getInfo().height}};
+        }
+
+        static std::array<unsigned int, 3> getThreadGroups(const XrExtent2Di& extent, const XrExtent2Di& groupSize) {
+            // Each thread of the temporal shader produces one pixel
+            return {xr::math::DivideRoundingUp((uint32_t)extent.width, (uint32_t)groupSize.width),   // dispatchX
+                    xr::math::DivideRoundingUp((uint32_t)extent.height, (uint32_t)groupSize.height), // dispatchY
+                    1};
+        }
+
+        void initializeUpscaler() {
+            const auto shadersDir = dllHome / "shaders";
+            const auto shaderFile = shadersDir / "Temporal.hlsl";
+
+            m_shaderTemporal = CreateTunedComputeShader(
+                m_configManager, m_device, "Temporal CS", [&](const XrExtent2Di& groupSize) {
+                    utilities::shader::Defines defines;
+                    defines.add("TEMPORAL_THREAD_GROUP_SIZE_X", groupSize.width);
+                    defines.add("TEMPORAL_THREAD_GROUP_SIZE_Y", groupSize.height);
+                    return m_device->createComputeShader(shaderFile, "mainCS", "Temporal CS", {}, defines.get());
+                });
+        }
+
+        const std::shared_ptr<IConfigManager> m_configManager;
+        const std::shared_ptr<IDevice> m_device;
+
+        std::shared_ptr<ITunedComputeShader> m_shaderTemporal;
+
+        std::optional<TemporalViewInfo> m_views[utilities::ViewCount + 1];
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<IImageProcessor> CreateTemporalUpscaler(std::shared_ptr<IConfigManager> configManager,
+                                                            std::shared_ptr<IDevice> graphicsDevice,
+                                                            int settingScaling,
+                                                            int settingAnamorphic) {
+        return std::make_shared<TemporalUpscaler>(configManager, graphicsDevice, settingScaling, settingAnamorphic);
+    }
+
+} // namespace toolkit::graphics
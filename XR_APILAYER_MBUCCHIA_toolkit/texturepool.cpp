@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    // The properties that make two textures interchangeable.
+    using TextureKey = std::tuple<int64_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, XrSwapchainUsageFlags>;
+
+    class TexturePool : public ITexturePool {
+      public:
+        TexturePool(std::shared_ptr<IDevice> graphicsDevice) : m_device(graphicsDevice) {
+        }
+
+        std::shared_ptr<ITexture> acquire(const XrSwapchainCreateInfo& info, std::string_view debugName) override {
+            auto it = m_freeTextures.find(getKey(info));
+            if (it != m_freeTextures.end()) {
+                auto texture = std::move(it->second.texture);
+                m_freeTextures.erase(it);
+                return texture;
+            }
+
+            TraceLoggingWrite(g_traceProvider,
+                              "TexturePool_Create",
+                              TLArg(debugName.data(), "Name"),
+                              TLArg(info.width, "Width"),
+                              TLArg(info.height, "Height"),
+                              TLArg(info.arraySize, "ArraySize"),
+                              TLArg(info.format, "Format"));
+
+            return m_device->createTexture(info, debugName);
+        }
+
+        void release(std::shared_ptr<ITexture> texture) override {
+            if (texture) {
+                m_freeTextures.emplace(getKey(texture->getInfo()), FreeTexture{std::move(texture), m_epoch});
+            }
+        }
+
+        void clear() override {
+            // The textures may still be in use by the GPU.
+            for (auto& [key, entry] : m_freeTextures) {
+                m_device->releaseDeferred(std::move(entry.texture));
+            }
+            m_freeTextures.clear();
+        }
+
+        void trim() override {
+            for (auto it = m_freeTextures.begin(); it != m_freeTextures.end();) {
+                if (it->second.epoch != m_epoch) {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "TexturePool_Trim",
+                                      TLArg(it->second.texture->getInfo().width, "Width"),
+                                      TLArg(it->second.texture->getInfo().height, "Height"));
+                    m_device->releaseDeferred(std::move(it->second.texture));
+                    it = m_freeTextures.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            m_epoch++;
+        }
+
+      private:
+        static TextureKey getKey(const XrSwapchainCreateInfo& info) {
+            return std::make_tuple(info.format,
+                                   info.width,
+                                   info.height,
+                                   info.arraySize,
+                                   info.mipCount,
+                                   info.sampleCount,
+                                   info.usageFlags);
+        }
+
+        struct FreeTexture {
+            std::shared_ptr<ITexture> texture;
+
+            // The trim() period during which the texture was last released.
+            uint32_t epoch;
+        };
+
+        const std::shared_ptr<IDevice> m_device;
+
+        std::multimap<TextureKey, FreeTexture> m_freeTextures;
+        uint32_t m_epoch{0};
+    };
+
+} // namespace
+
+namespace toolkit::graphics {
+
+    std::shared_ptr<ITexturePool> CreateTexturePool(std::shared_ptr<IDevice> graphicsDevice) {
+        return std::make_shared<TexturePool>(graphicsDevice);
+    }
+
+} // namespace toolkit::graphics
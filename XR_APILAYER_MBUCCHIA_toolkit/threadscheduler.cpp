@@ -0,0 +1,277 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "log.h"
+
+namespace {
+
+    using namespace toolkit::log;
+    using namespace toolkit::utilities;
+
+    // Keeps the frame threads (the application's render thread and our Turbo Mode wait) on the fastest cores, and our
+    // background threads out of their way.
+    // - On hybrid CPUs, the frame threads prefer the cores with the highest efficiency class (P-cores), and the
+    //   background threads are kept on the other cores (E-cores).
+    // - Otherwise, the background threads avoid the core where the application's render thread was last seen.
+    // The frame threads are also registered with MMCSS, which boosts them while they are runnable.
+    class ThreadScheduler {
+      public:
+        void enable(bool enable) {
+            std::unique_lock lock(m_mutex);
+
+            if (enable && m_cpuSets.empty()) {
+                queryTopology();
+            }
+            m_isEnabled = enable;
+
+            for (auto& thread : m_threads) {
+                applyCpuSets(thread);
+            }
+        }
+
+        void registerThread(ThreadClass threadClass, bool isAppThread = false) {
+            Thread thread;
+            thread.id = GetCurrentThreadId();
+            thread.threadClass = threadClass;
+            thread.isAppThread = isAppThread;
+            if (!DuplicateHandle(GetCurrentProcess(),
+                                 GetCurrentThread(),
+                                 GetCurrentProcess(),
+                                 thread.handle.put(),
+                                 0,
+                                 FALSE,
+                                 DUPLICATE_SAME_ACCESS)) {
+                return;
+            }
+
+            // MMCSS must be requested by the thread itself.
+            if (threadClass == ThreadClass::Frame) {
+                DWORD taskIndex = 0;
+                thread.mmcssHandle = AvSetMmThreadCharacteristics(L"Games", &taskIndex);
+                if (thread.mmcssHandle) {
+                    AvSetMmThreadPriority(thread.mmcssHandle, AVRT_PRIORITY_HIGH);
+                } else {
+                    TraceLoggingWrite(g_traceProvider,
+                                      "ThreadScheduler_SetMmThreadCharacteristics_Failed",
+                                      TLArg(thread.id, "ThreadId"),
+                                      TLArg(HRESULT_FROM_WIN32(::GetLastError()), "HR"));
+                }
+            }
+
+            std::unique_lock lock(m_mutex);
+
+            if (isAppThread) {
+                // Only one application render thread is tracked. Release the previous one.
+                const auto it = std::find_if(
+                    m_threads.begin(), m_threads.end(), [](const Thread& entry) { return entry.isAppThread; });
+                if (it != m_threads.end()) {
+                    SetThreadSelectedCpuSets(it->handle.get(), nullptr, 0);
+                    if (it->mmcssHandle) {
+                        AvRevertMmThreadCharacteristics(it->mmcssHandle);
+                    }
+                    m_threads.erase(it);
+                }
+                m_appRenderThreadId = thread.id;
+                updateAppRenderCore();
+            }
+
+            m_threads.push_back(std::move(thread));
+            if (isAppThread) {
+                // The background threads must now avoid the core of the new render thread.
+                for (auto& entry : m_threads) {
+                    applyCpuSets(entry);
+                }
+            } else {
+                applyCpuSets(m_threads.back());
+            }
+
+            TraceLoggingWrite(g_traceProvider,
+                              "ThreadScheduler_Register",
+                              TLArg(m_threads.back().id, "ThreadId"),
+                              TLArg(threadClass == ThreadClass::Frame ? "Frame" : "Background", "Class"),
+                              TLArg(isAppThread, "IsAppThread"));
+        }
+
+        void unregisterThread() {
+            const DWORD threadId = GetCurrentThreadId();
+
+            std::unique_lock lock(m_mutex);
+
+            const auto it = std::find_if(
+                m_threads.begin(), m_threads.end(), [&](const Thread& entry) { return entry.id == threadId; });
+            if (it == m_threads.end()) {
+                return;
+            }
+
+            if (it->mmcssHandle) {
+                AvRevertMmThreadCharacteristics(it->mmcssHandle);
+            }
+            if (it->isAppThread) {
+                m_appRenderThreadId = 0;
+            }
+            m_threads.erase(it);
+        }
+
+        void registerAppRenderThread() {
+            if (!m_isEnabled || m_appRenderThreadId == GetCurrentThreadId()) {
+                return;
+            }
+
+            registerThread(ThreadClass::Frame, true /* isAppThread */);
+        }
+
+      private:
+        struct Thread {
+            DWORD id{0};
+            ThreadClass threadClass{ThreadClass::Background};
+            bool isAppThread{false};
+            wil::unique_handle handle;
+            HANDLE mmcssHandle{nullptr};
+        };
+
+        struct CpuSet {
+            ULONG id;
+            WORD group;
+            BYTE logicalProcessorIndex;
+            BYTE coreIndex;
+            BYTE efficiencyClass;
+        };
+
+        void queryTopology() {
+            ULONG size = 0;
+            GetSystemCpuSetInformation(nullptr, 0, &size, GetCurrentProcess(), 0);
+            std::vector<uint8_t> buffer(size);
+            if (!size || !GetSystemCpuSetInformation(reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buffer.data()),
+                                                     size,
+                                                     &size,
+                                                     GetCurrentProcess(),
+                                                     0)) {
+                Log("Failed to query the CPU sets: %d\n", GetLastError());
+                return;
+            }
+
+            BYTE minEfficiencyClass = std::numeric_limits<BYTE>::max();
+            for (size_t offset = 0; offset < size;) {
+                const auto info = reinterpret_cast<const SYSTEM_CPU_SET_INFORMATION*>(buffer.data() + offset);
+                if (info->Type == CpuSetInformation) {
+                    m_cpuSets.push_back({info->CpuSet.Id,
+                                         info->CpuSet.Group,
+                                         info->CpuSet.LogicalProcessorIndex,
+                                         info->CpuSet.CoreIndex,
+                                         info->CpuSet.EfficiencyClass});
+                    minEfficiencyClass = std::min(minEfficiencyClass, info->CpuSet.EfficiencyClass);
+                    m_maxEfficiencyClass = std::max(m_maxEfficiencyClass, info->CpuSet.EfficiencyClass);
+                }
+                offset += info->Size;
+            }
+            m_isHybrid = minEfficiencyClass != m_maxEfficiencyClass;
+
+            Log("Thread scheduling: %u CPU sets, %s\n", (uint32_t)m_cpuSets.size(), m_isHybrid ? "hybrid" : "uniform");
+        }
+
+        // Must be called from the application's render thread.
+        void updateAppRenderCore() {
+            PROCESSOR_NUMBER processor;
+            GetCurrentProcessorNumberEx(&processor);
+
+            m_appRenderCoreIndex.reset();
+            for (const auto& cpuSet : m_cpuSets) {
+                if (cpuSet.group == processor.Group && cpuSet.logicalProcessorIndex == processor.Number) {
+                    m_appRenderCoreIndex = cpuSet.coreIndex;
+                    break;
+                }
+            }
+        }
+
+        void applyCpuSets(const Thread& thread) {
+            std::vector<ULONG> ids;
+            if (m_isEnabled) {
+                for (const auto& cpuSet : m_cpuSets) {
+                    bool include;
+                    if (thread.threadClass == ThreadClass::Frame) {
+                        include = !m_isHybrid || cpuSet.efficiencyClass == m_maxEfficiencyClass;
+                    } else if (m_isHybrid) {
+                        include = cpuSet.efficiencyClass != m_maxEfficiencyClass;
+                    } else {
+                        include = !m_appRenderCoreIndex || cpuSet.coreIndex != m_appRenderCoreIndex.value();
+                    }
+                    if (include) {
+                        ids.push_back(cpuSet.id);
+                    }
+                }
+
+                // No restriction is the same as all the CPU sets.
+                if (ids.size() == m_cpuSets.size()) {
+                    ids.clear();
+                }
+            }
+
+            if (!SetThreadSelectedCpuSets(thread.handle.get(), ids.data(), (ULONG)ids.size())) {
+                TraceLoggingWrite(g_traceProvider,
+                                  "ThreadScheduler_SetThreadSelectedCpuSets_Failed",
+                                  TLArg(thread.id, "ThreadId"),
+                                  TLArg(HRESULT_FROM_WIN32(::GetLastError()), "HR"));
+            }
+        }
+
+        std::mutex m_mutex;
+        std::vector<Thread> m_threads;
+        std::atomic<bool> m_isEnabled{false};
+        std::atomic<DWORD> m_appRenderThreadId{0};
+
+        std::vector<CpuSet> m_cpuSets;
+        bool m_isHybrid{false};
+        BYTE m_maxEfficiencyClass{0};
+        std::optional<BYTE> m_appRenderCoreIndex;
+    };
+
+    ThreadScheduler& GetThreadScheduler() {
+        // Never destroyed, since our threads may unregister during the teardown of the process.
+        static ThreadScheduler* scheduler = new ThreadScheduler;
+        return *scheduler;
+    }
+
+} // namespace
+
+namespace toolkit::utilities {
+
+    void EnableThreadScheduling(bool enable) {
+        GetThreadScheduler().enable(enable);
+    }
+
+    void RegisterThread(ThreadClass threadClass) {
+        GetThreadScheduler().registerThread(threadClass);
+    }
+
+    void UnregisterThread() {
+        GetThreadScheduler().unregisterThread();
+    }
+
+    void RegisterAppRenderThread() {
+        GetThreadScheduler().registerAppRenderThread();
+    }
+
+} // namespace toolkit::utilities
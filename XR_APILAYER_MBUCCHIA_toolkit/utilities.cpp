@@ -86,7 +86,7 @@ namespace toolkit::config {
     DECLARE_ENUM_TO_STRING_VIEW(OverlayType, {"Off", "FPS", "Advanced", "Developer"})
     DECLARE_ENUM_TO_STRING_VIEW(MenuFontSize, {"Small", "Medium", "Large"})
     DECLARE_ENUM_TO_STRING_VIEW(MenuTimeout, {"Short", "Medium", "Long", "None"})
-    DECLARE_ENUM_TO_STRING_VIEW(ScalingType, {"Off", "NIS", "FSR", "CAS"})
+    DECLARE_ENUM_TO_STRING_VIEW(ScalingType, {"Off", "NIS", "FSR", "CAS", "Temporal"})
     DECLARE_ENUM_TO_STRING_VIEW(MipMapBias, {"Off", "Conservative", "All"})
     DECLARE_ENUM_TO_STRING_VIEW(HandTrackingEnabled, {"Off", "Both", "Left", "Right"})
     DECLARE_ENUM_TO_STRING_VIEW(HandTrackingVisibility, {"Hidden", "Bright", "Medium", "Dark", "Darker"})
@@ -432,6 +432,97 @@ namespace toolkit::utilities::shader {
         }
     }
 
+    bool LoadPrecompiledShader(std::string_view sourceName,
+                               const char* entryPoint,
+                               const D3D_SHADER_MACRO* defines,
+                               const char* target,
+                               ID3DBlob** blob) {
+        // The resources are named after a FNV-1a hash of the permutation (see get_resource_name() in
+        // shader_generator.py).
+        std::string key = std::string(sourceName) + "|" + entryPoint + "|" + target + "|";
+        for (const D3D_SHADER_MACRO* define = defines; define && define->Name; define++) {
+            key += std::string(define->Name) + "=" + (define->Definition ? define->Definition : "") + ";";
+        }
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (const char c : key) {
+            hash = (hash ^ (uint8_t)c) * 0x100000001b3ull;
+        }
+        char resourceName[32];
+        sprintf_s(resourceName, "SHADER_%016llX", hash);
+
+        HMODULE module;
+        if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                                (LPCSTR)&LoadPrecompiledShader,
+                                &module)) {
+            return false;
+        }
+        const HRSRC resource = FindResourceA(module, resourceName, MAKEINTRESOURCEA(10) /* RT_RCDATA */);
+        if (!resource) {
+            return false;
+        }
+        const HGLOBAL data = LoadResource(module, resource);
+        const DWORD size = SizeofResource(module, resource);
+        if (!data || !size) {
+            return false;
+        }
+
+        CHECK_HRCMD(D3DCreateBlob(size, blob));
+        memcpy((*blob)->GetBufferPointer(), LockResource(data), size);
+        return true;
+    }
+
+    void CompileBuiltInShader(
+        std::string_view name, std::string_view code, const char* entryPoint, ID3DBlob** blob, const char* target) {
+        if (!LoadPrecompiledShader(name, entryPoint, nullptr, target, blob)) {
+            CompileShader(code, entryPoint, blob, target);
+        }
+    }
+
+    std::shared_future<ComPtr<ID3DBlob>> CompileShaderAsync(const std::filesystem::path& shaderFile,
+                                                            const std::string& entryPoint,
+                                                            const D3D_SHADER_MACRO* defines,
+                                                            const std::filesystem::path& includePath,
+                                                            const char* target,
+                                                            bool usePrecompiled) {
+        const auto sourceName = shaderFile.filename().string();
+        ComPtr<ID3DBlob> precompiled;
+        if (usePrecompiled &&
+            LoadPrecompiledShader(sourceName, entryPoint.c_str(), defines, target, set(precompiled))) {
+            std::promise<ComPtr<ID3DBlob>> promise;
+            promise.set_value(precompiled);
+            return promise.get_future().share();
+        }
+
+        std::vector<std::pair<std::string, std::string>> ownedDefines;
+        for (const D3D_SHADER_MACRO* define = defines; define && define->Name; define++) {
+            ownedDefines.push_back({define->Name, define->Definition ? define->Definition : ""});
+        }
+
+        return std::async(std::launch::async,
+                          [shaderFile,
+                           entryPoint,
+                           ownedDefines = std::move(ownedDefines),
+                           includePath,
+                           target = std::string(target)]() {
+                              std::vector<D3D_SHADER_MACRO> macros;
+                              for (const auto& [name, definition] : ownedDefines) {
+                                  macros.push_back({name.c_str(), definition.c_str()});
+                              }
+                              macros.push_back({nullptr, nullptr});
+
+                              ComPtr<ID3DBlob> blob;
+                              IncludeHeader includes({includePath});
+                              CompileShader(shaderFile,
+                                            entryPoint.c_str(),
+                                            set(blob),
+                                            macros.data(),
+                                            !includePath.empty() ? &includes : nullptr,
+                                            target.c_str());
+                              return blob;
+                          })
+            .share();
+    }
+
     HRESULT IncludeHeader::Open(
         D3D_INCLUDE_TYPE /*includeType*/, LPCSTR pFileName, LPCVOID /*pParentData*/, LPCVOID* ppData, UINT* pBytes) {
         for (auto& it : m_includePaths) {
@@ -61,8 +61,28 @@ namespace {
 
     using namespace xr::math;
 
-    // The number of frames before freeing an unused set of VRS mask textures.
-    constexpr uint16_t MaxAge = 100;
+    // The memory budget of the VRS mask textures. Beyond it, the least recently used masks are freed. A mask for a
+    // 4K render target uses about 650 KB.
+    constexpr uint64_t MaxMaskBytes = 2 * 1024 * 1024;
+
+    // The number of frames since its last use after which a mask is not redrawn anymore. It is refreshed on its next
+    // use instead.
+    constexpr uint32_t MaxRedrawAge = 2;
+
+    // The number of frames between two analyses of the content for the content-adaptive rates.
+    constexpr uint32_t ContentHintsPeriod = 8;
+
+    // The luminance variance under which a tile is coarsened to 2x2 and 4x4 (standard deviation of 3% and 1%).
+    constexpr float ContentHintsThreshold2x2 = 0.03f * 0.03f;
+    constexpr float ContentHintsThreshold4x4 = 0.01f * 0.01f;
+
+    // The number of frames between two reductions of the depth buffer for the depth-adaptive rates.
+    constexpr uint32_t DepthHintsPeriod = 8;
+
+    // How much the inner ring grows while the eye tracker is not confident about the fixation, and how fast it shrinks
+    // back (per frame) once it is.
+    constexpr float SaccadeInnerRingExpansion = 1.5f;
+    constexpr float InnerRingContractionStep = 0.1f;
 
     template <typename T>
     constexpr T integer_log2(T n) noexcept {
@@ -93,6 +113,28 @@ namespace {
         XrVector2f InvDim;   // 1/w, 1/h
         XrVector2f Rings[4]; // 1/(a1^2), 1/(b1^2)
         uint32_t Rates[4];   // r1, r2, r3, r4
+        int32_t Region[4];   // x, y, initialize from base, unused
+        uint32_t HintRates[4]; // rates for the content hints 0, 1, 2, use content hints
+        float DepthParams[4];  // distances for 2x2 and 4x4, use depth hints, unused
+    };
+
+    // Constant buffer for the content analysis.
+    struct alignas(16) ContentHintsConstants {
+        float Source[4]; // u, v, w, h
+        float Params[4]; // 1/w, 1/h, threshold 2x2, threshold 4x4
+    };
+
+    // Constant buffer for the depth reduction.
+    struct alignas(16) DepthHintsConstants {
+        float Source[4]; // x, y, w, h (texels)
+        float Params[4]; // 1/near, 1/far, min depth, 1/(max depth - min depth)
+    };
+
+    // A ring pattern drawn into one of the masks.
+    struct ShadingPass {
+        size_t target;
+        size_t eye;
+        bool upsideDown;
     };
 
     struct ShadingRateMask {
@@ -102,15 +144,61 @@ namespace {
         // The generation of this mask. If the generation is too old, the mask must be updated.
         uint64_t gen;
 
+        // Whether the mask was drawn at least once, and may be bound.
+        bool isReady{false};
+
         // The number of frames since the mask was last used during a rendering pass.
-        uint16_t age;
+        std::atomic<uint32_t> age{0};
+
+        // Whether the mask was too old to be redrawn and is out of date. It must not be bound until it is redrawn.
+        std::atomic<bool> isStale{false};
+
+        // The memory used by the textures of the mask.
+        uint64_t sizeInBytes{0};
+
+        // The gaze locations that the mask was last drawn with.
+        XrVector2f gazeLocation[ViewCount + 1]{};
 
         std::shared_ptr<IShaderBuffer> cbShading[ViewCount * 2 + 2];
         std::shared_ptr<ITexture> mask[ViewCount + 1];
         std::shared_ptr<ITexture> maskDoubleWide;
         std::shared_ptr<ITexture> maskTextureArray;
+
+        // The initial content of each mask, with the HAM stamp. Only redrawn when the mask parameters change.
+        std::shared_ptr<ITexture> base[ViewCount + 1];
+
+        // D3D11 only: the NVAPI views of the masks above.
+        ComPtr<ID3D11NvShadingRateResourceView> nvView[ViewCount + 1];
+        ComPtr<ID3D11NvShadingRateResourceView> nvViewDoubleWide;
+        ComPtr<ID3D11NvShadingRateResourceView> nvViewTextureArray;
+    };
+
+    // The cached outcome of onSetRenderTarget() for a render target.
+    struct RenderTargetDecision {
+        uint32_t width;
+        uint32_t height;
+        uint32_t arraySize;
+
+        bool isCandidate;
+        VariableRateShaderRejection rejection;
+        bool isDoubleWide;
+
+        // Expired when the creation of the mask was deferred.
+        std::weak_ptr<ShadingRateMask> mask;
+
+        std::atomic<uint32_t>* renderScaleCounter;
+    };
+
+    // The render targets may be bound from several threads: each thread keeps its own decisions, which are valid as
+    // long as the epoch does not change.
+    struct RenderTargetDecisionCache {
+        uint64_t epoch{0};
+        std::unordered_map<void*, RenderTargetDecision> decisions;
     };
 
+    // The epochs are unique across all the instances of the variable rate shader.
+    std::atomic<uint64_t> g_renderTargetDecisionEpoch{0};
+
     inline XrVector2f MakeRingParam(XrVector2f size) {
         size.x = std::max(size.x, FLT_EPSILON);
         size.y = std::max(size.y, FLT_EPSILON);
@@ -149,21 +237,13 @@ namespace {
         ~VariableRateShader() override {
             disable();
 
-            // TODO: Leak NVAPI resources for now, since there is an occasional crash.
-            for (size_t i = 0; i < m_NvShadingRateResources.views.size(); i++) {
-                LeakNVAPIResource(i);
-            }
-        }
-
-        void LeakNVAPIResource(size_t index) {
-            for (auto& view : m_NvShadingRateResources.views[index]) {
-                view.Detach();
+            // The masks (and their NVAPI views) may still be in use by the GPU.
+            for (auto& mask : m_shadingRateMask) {
+                m_device->releaseDeferred(std::move(mask));
             }
-            m_NvShadingRateResources.viewsDoubleWide[index].Detach();
-            m_NvShadingRateResources.viewsTextureArray[index].Detach();
         }
 
-        void beginSession(XrSession session) override {
+        void beginSession(XrSession session, XrSpace viewSpace) override {
             // Create HAM buffers.
             if (m_hasVisibilityMask) {
                 for (uint32_t i = 0; i < ViewCount; i++) {
@@ -211,6 +291,13 @@ namespace {
             }
 
             m_session = session;
+            m_viewSpace = viewSpace;
+
+            // Create the mask for the render resolution upfront, rather than upon its first bind, so that the first
+            // frames are not rendered without VRS.
+            if (m_configManager->peekEnumValue<VariableShadingRateType>(SettingVRS) != VariableShadingRateType::None) {
+                prewarmMask(m_renderWidth, m_renderHeight);
+            }
         }
 
         void endSession() override {
@@ -219,19 +306,24 @@ namespace {
             }
 
             m_isHAMReady = false;
+            m_viewSpace = XR_NULL_HANDLE;
         }
 
         void beginFrame(XrTime frameTime) override {
+            m_numCandidateBinds = 0;
+            for (auto& count : m_numRejectedBinds) {
+                count = 0;
+            }
+            m_numMaskHits = 0;
+            m_numMaskMisses = 0;
+            m_numMaskEvictions = 0;
+
             if (m_HAM[0] && m_HAM[1] && !m_isHAMReady) {
                 // Create projection for stamping HAM.
                 XrViewLocateInfo info{XR_TYPE_VIEW_LOCATE_INFO};
                 info.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
                 info.displayTime = frameTime;
-
-                XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO, nullptr};
-                referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
-                referenceSpaceCreateInfo.poseInReferenceSpace = Pose::Identity();
-                CHECK_XRCMD(m_openXR.xrCreateReferenceSpace(m_session, &referenceSpaceCreateInfo, &info.space));
+                info.space = m_viewSpace;
 
                 XrViewState state{XR_TYPE_VIEW_STATE, nullptr};
                 XrView eyeInViewSpace[2] = {{XR_TYPE_VIEW, nullptr}, {XR_TYPE_VIEW, nullptr}};
@@ -243,75 +335,83 @@ namespace {
                     m_viewProjection[i].NearFar = {0.001f, 100.f};
                 }
 
-                CHECK_XRCMD(m_openXR.xrDestroySpace(info.space));
-
                 m_isHAMReady = true;
 
                 m_currentGen++;
             }
 
-            // When using eye tracking we must render the views every frame.
-            if (m_usingEyeTracking) {
-                // TODO: What do we do upon (permanent) loss of tracking?
-                updateGaze();
-
-                m_currentGen++;
+            if (m_isContentAdaptive) {
+                m_framesSinceContentHints++;
             }
 
-            m_device->blockCallbacks();
-            m_device->saveContext();
+            if (m_isDepthAdaptive) {
+                // Stop using the distances once the application does not submit its depth buffers anymore.
+                if (++m_framesSinceDepthHints > 2 * DepthHintsPeriod &&
+                    (m_depthHintsValid[0] || m_depthHintsValid[1])) {
+                    m_depthHintsValid.fill(false);
+                    m_currentGen++;
+                }
+            }
 
             {
                 std::unique_lock lock(m_shadingRateMaskLock);
 
-                // Update all masks.
-                size_t index = 0;
-                for (auto it = m_shadingRateMask.begin(); it != m_shadingRateMask.end();) {
-                    // Age all masks.
-                    if (++it->age > MaxAge) {
-                        // Evict old entries. If a mask is used in a frame, its age is to 0.
-                        TraceLocalActivity(local);
-                        TraceLoggingWriteStart(local,
-                                               "VariableRateShading_DestroyMask",
-                                               TLArg(it->widthInTiles, "WidthInTiles"),
-                                               TLArg(it->heightInTiles, "HeightInTiles"),
-                                               TLArg("DiedOfAge", "State"));
-
-                        it = m_shadingRateMask.erase(it);
-
-                        if (m_NvShadingRateResources.views.size()) {
-                            // TODO: Leak NVAPI resources for now, since there is an occasional crash.
-                            LeakNVAPIResource(index);
-                            m_NvShadingRateResources.views.erase(m_NvShadingRateResources.views.begin() + index);
-                            m_NvShadingRateResources.viewsDoubleWide.erase(
-                                m_NvShadingRateResources.viewsDoubleWide.begin() + index);
-                            m_NvShadingRateResources.viewsTextureArray.erase(
-                                m_NvShadingRateResources.viewsTextureArray.begin() + index);
-                        }
-
-                        TraceLoggingWriteStop(local, "VariableRateShading_DestroyMask");
-                    } else {
-                        // If this mask is still valid...
-
-                        // ...and is pending creation, create it.
-                        if (!it->mask[0]) {
-                            createMaskResources(*it);
-                        }
+                // Age all masks. If a mask is used in a frame, its age is reset to 0.
+                uint64_t totalBytes = 0;
+                for (auto& mask : m_shadingRateMask) {
+                    mask->age++;
+                    totalBytes += mask->sizeInBytes;
+                }
 
-                        // ...and eventually, update it.
-                        updateViews(*it);
+                // Evict the least recently used masks beyond the memory budget. When trimming, only keep the masks
+                // used in the last frame.
+                const bool isTrimRequested = m_isTrimRequested.exchange(false);
+                while (isTrimRequested || totalBytes > MaxMaskBytes) {
+                    const auto it = std::max_element(
+                        m_shadingRateMask.begin(), m_shadingRateMask.end(), [](const auto& a, const auto& b) {
+                            return a->age < b->age;
+                        });
+                    if (it == m_shadingRateMask.end() || (*it)->age <= 1) {
+                        break;
+                    }
 
-                        it++;
-                        index++;
+                    TraceLoggingWrite(g_traceProvider,
+                                      "VariableRateShading_DestroyMask",
+                                      TraceLoggingKeyword(TLK_VRS),
+                                      TLArg((*it)->widthInTiles, "WidthInTiles"),
+                                      TLArg((*it)->heightInTiles, "HeightInTiles"),
+                                      TLArg((*it)->age.load(), "Age"),
+                                      TLArg(isTrimRequested ? "Trimmed" : "OverBudget", "State"));
+
+                    // The NVAPI views must not remain bound while they are released.
+                    if (m_device->getApi() == Api::D3D11) {
+                        disable();
                     }
+
+                    totalBytes -= (*it)->sizeInBytes;
+                    m_device->releaseDeferred(std::move(*it));
+                    m_shadingRateMask.erase(it);
+                    invalidateRenderTargetDecisions();
+                    m_numMaskEvictions++;
                 }
+
+                // Create the masks pending creation. They are drawn at the end of the frame (see recordMasks()).
+                createPendingMasks();
             }
 
-            m_device->restoreContext();
-            m_device->flushContext(false, false);
-            m_device->unblockCallbacks();
+            // When using eye tracking we must update the gaze every frame. The masks are only redrawn when the gaze
+            // moved by at least one tile (see updateViews()), at the start of the next composition.
+            if (m_usingEyeTracking) {
+                // TODO: What do we do upon (permanent) loss of tracking?
+                updateGaze();
+            }
 
-            m_renderScales.clear();
+            {
+                std::unique_lock lock(m_renderScalesLock);
+                for (auto& [width, count] : m_renderScales) {
+                    *count = 0;
+                }
+            }
         }
 
         void endFrame() override {
@@ -322,19 +422,38 @@ namespace {
                 uint32_t maxCount = 0;
                 uint32_t renderWidth = 0;
 
-                for (auto it : m_renderScales) {
-                    if (it.second >= maxCount && it.first > renderWidth) {
-                        renderWidth = it.first;
-                        maxCount = it.second;
+                for (const auto& [width, count] : m_renderScales) {
+                    const auto value = count->load();
+                    if (value && value >= maxCount && width > renderWidth) {
+                        renderWidth = width;
+                        maxCount = value;
                     }
                 }
 
-                m_actualRenderWidth = renderWidth;
+                if (renderWidth != m_actualRenderWidth) {
+                    m_actualRenderWidth = renderWidth;
+                    invalidateRenderTargetDecisions();
+                }
+            }
+
+            // Create the mask for a new render resolution now, so it is drawn at the end of this frame rather than
+            // the next one.
+            if (m_actualRenderWidth) {
+                prewarmMask(m_actualRenderWidth, (uint32_t)(m_actualRenderWidth / m_renderRatio));
             }
 
             disable();
         }
 
+        void recordMasks(bool beforeComposition) override {
+            // The eye-tracked masks are drawn with the latest gaze, and the other ones with the latest content hints.
+            if (beforeComposition != m_usingEyeTracking) {
+                return;
+            }
+
+            drawMasks();
+        }
+
         void update() override {
             const auto mode = m_configManager->getEnumValue<VariableShadingRateType>(config::SettingVRS);
             const auto hasModeChanged = mode != m_mode;
@@ -369,11 +488,33 @@ namespace {
                 // We can't use config's hasChanged since we don't own this setting.
                 m_isHAMEnabled = isHAMEnabled;
 
+                const bool isContentAdaptive = m_configManager->getValue(SettingVRSContentAdaptive);
+                if (isContentAdaptive != m_isContentAdaptive) {
+                    m_isContentAdaptive = isContentAdaptive;
+                    m_contentHintsValid.fill(false);
+                    m_currentGen++;
+                }
+
+                const bool isDepthAdaptive = m_configManager->getValue(SettingVRSDepthAdaptive);
+                if (isDepthAdaptive != m_isDepthAdaptive) {
+                    m_isDepthAdaptive = isDepthAdaptive;
+                    m_depthHintsValid.fill(false);
+                    m_currentGen++;
+                }
+                if (m_configManager->hasChanged(SettingVRSDepthDistance2x2) ||
+                    m_configManager->hasChanged(SettingVRSDepthDistance4x4)) {
+                    m_currentGen++;
+                }
+
             } else if (m_usingEyeTracking) {
                 m_usingEyeTracking = false;
             }
 
-            m_filterScale = m_configManager->getValue(SettingVRSScaleFilter) / 100.f;
+            const float filterScale = m_configManager->getValue(SettingVRSScaleFilter) / 100.f;
+            if (filterScale != m_filterScale) {
+                m_filterScale = filterScale;
+                invalidateRenderTargetDecisions();
+            }
         }
 
         bool onSetRenderTarget(std::shared_ptr<graphics::IContext> context,
@@ -381,34 +522,60 @@ namespace {
                                std::optional<Eye> eyeHint) override {
             const auto& info = renderTarget->getInfo();
 
-            bool isDoubleWide = false;
-            if (m_mode == VariableShadingRateType::None || !isVariableRateShadingCandidate(info, isDoubleWide)) {
+            if (m_mode == VariableShadingRateType::None) {
                 disable(context);
                 return false;
             }
 
-            const Eye eye = eyeHint.value_or(Eye::Both);
-            TraceLoggingWrite(g_traceProvider, "EnableVariableRateShading", TLArg(isDoubleWide, "IsDoubleWide"));
+            const auto& decision = getRenderTargetDecision(renderTarget);
+            if (decision.renderScaleCounter) {
+                decision.renderScaleCounter->fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!decision.isCandidate) {
+                m_numRejectedBinds[to_integral(decision.rejection)]++;
+                disable(context);
+                return false;
+            }
+            m_numCandidateBinds++;
 
-            size_t maskIndex;
-            {
-                std::unique_lock lock(m_shadingRateMaskLock);
+            const bool isDoubleWide = decision.isDoubleWide;
+            const Eye eye = eyeHint.value_or(Eye::Both);
+            TraceLoggingWrite(g_traceProvider,
+                              "EnableVariableRateShading",
+                              TraceLoggingKeyword(TLK_VRS),
+                              TLArg(isDoubleWide, "IsDoubleWide"));
+
+            const auto shadingRateMask = decision.mask.lock();
+            (shadingRateMask ? m_numMaskHits : m_numMaskMisses)++;
+            if (!shadingRateMask) {
+                // Creation was deferred to the next frame.
+                TraceLoggingWrite(g_traceProvider,
+                                  "SkipEnableVariableRateShading",
+                                  TraceLoggingKeyword(TLK_VRS),
+                                  TLArg("DeferredCreation", "Reason"));
+                return true;
+            }
 
-                if (!getMaskIndex(isDoubleWide ? info.width / 2 : info.width, info.height, maskIndex)) {
-                    // Creation was deferred to the next frame.
-                    TraceLoggingWrite(
-                        g_traceProvider, "SkipEnableVariableRateShading", TLArg("DeferredCreation", "Reason"));
-                    return true;
-                }
+            // Reset the age to keep this mask active.
+            shadingRateMask->age = 0;
 
-                // Reset the age to keep this mask active.
-                m_shadingRateMask[maskIndex].age = 0;
+            if (shadingRateMask->isStale) {
+                // The mask will be redrawn for the next frame.
+                TraceLoggingWrite(g_traceProvider,
+                                  "SkipEnableVariableRateShading",
+                                  TraceLoggingKeyword(TLK_VRS),
+                                  TLArg("StaleMask", "Reason"));
+                disable(context);
+                return true;
             }
 
             if (auto context11 = context->getAs<D3D11>()) {
                 if (m_currentState.isActive && m_currentState.width == info.width &&
                     m_currentState.height == info.height && m_currentState.eye == eye) {
-                    TraceLoggingWrite(g_traceProvider, "SkipEnableVariableRateShading", TLArg("AlreadySet", "Reason"));
+                    TraceLoggingWrite(g_traceProvider,
+                                      "SkipEnableVariableRateShading",
+                                      TraceLoggingKeyword(TLK_VRS),
+                                      TLArg("AlreadySet", "Reason"));
                     return true;
                 }
 
@@ -420,9 +587,9 @@ namespace {
                 desc.pViewports = m_nvRates;
                 CHECK_NVCMD(NvAPI_D3D11_RSSetViewportsPixelShadingRates(context11, &desc));
 
-                auto& mask = isDoubleWide          ? m_NvShadingRateResources.viewsDoubleWide[maskIndex]
-                             : info.arraySize == 2 ? m_NvShadingRateResources.viewsTextureArray[maskIndex]
-                                                   : m_NvShadingRateResources.views[maskIndex][(size_t)eye];
+                auto& mask = isDoubleWide          ? shadingRateMask->nvViewDoubleWide
+                             : info.arraySize == 2 ? shadingRateMask->nvViewTextureArray
+                                                   : shadingRateMask->nvView[(size_t)eye];
 
                 CHECK_NVCMD(NvAPI_D3D11_RSSetShadingRateResourceView(context11, get(mask)));
 
@@ -440,10 +607,12 @@ namespace {
                     return false;
                 }
 
-                // TODO: With DX12, the mask cannot be a texture array. For now we just use the generic mask.
-
-                auto mask = isDoubleWide ? m_shadingRateMask[maskIndex].maskDoubleWide
-                                         : m_shadingRateMask[maskIndex].mask[(size_t)eye];
+                // With DX12, the shading rate image applies to all the slices of a texture array. We use the generic
+                // mask, which combines the patterns of both eyes (see updateViews()), so that each eye keeps its full
+                // rate region.
+                auto mask = isDoubleWide          ? shadingRateMask->maskDoubleWide
+                            : info.arraySize == 2 ? shadingRateMask->mask[(size_t)Eye::Both]
+                                                  : shadingRateMask->mask[(size_t)eye];
 
                 // RSSetShadingRate() function sets both the combiners and the per-drawcall shading rate.
                 // We set to 1X1 for all sources and all combiners to MAX, so that the coarsest wins (per-drawcall,
@@ -463,6 +632,100 @@ namespace {
             disable(context);
         }
 
+        void updateContentHints(std::shared_ptr<ITexture> input, const TextureRegion& region, Eye eye) override {
+            if (!m_isContentAdaptive || m_mode == VariableShadingRateType::None || eye == Eye::Both ||
+                m_framesSinceContentHints < ContentHintsPeriod) {
+                return;
+            }
+
+            const auto& info = input->getInfo();
+            const auto& output = m_contentHints[(size_t)eye];
+            const auto& outputInfo = output->getInfo();
+
+            ContentHintsConstants constants{};
+            constants.Source[0] = (float)region.rect.offset.x / info.width;
+            constants.Source[1] = (float)region.rect.offset.y / info.height;
+            constants.Source[2] = (float)region.rect.extent.width / info.width;
+            constants.Source[3] = (float)region.rect.extent.height / info.height;
+            constants.Params[0] = 1.f / outputInfo.width;
+            constants.Params[1] = 1.f / outputInfo.height;
+            constants.Params[2] = ContentHintsThreshold2x2;
+            constants.Params[3] = ContentHintsThreshold4x4;
+            m_cbContentHints[(size_t)eye]->uploadData(&constants, sizeof(constants));
+
+            m_csContentHints->updateThreadGroups({xr::math::DivideRoundingUp(outputInfo.width, 8u),
+                                                  xr::math::DivideRoundingUp(outputInfo.height, 8u),
+                                                  1});
+            m_device->setShader(m_csContentHints, SamplerType::LinearClamp);
+            m_device->setShaderInput(0, m_cbContentHints[(size_t)eye]);
+            m_device->setShaderInput(0, input, region.slice);
+            output->setState(D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            m_device->setShaderOutput(0, output);
+            m_device->dispatchShader();
+
+            // The masks are redrawn with the new hints once both eyes are analyzed.
+            m_contentHintsValid[(size_t)eye] = true;
+            if (eye == Eye::Right) {
+                m_framesSinceContentHints = 0;
+                m_currentGen++;
+            }
+        }
+
+        void updateDepthHints(std::shared_ptr<ITexture> depth,
+                              const TextureRegion& region,
+                              const XrCompositionLayerDepthInfoKHR& depthInfo,
+                              Eye eye) override {
+            if (!m_isDepthAdaptive || m_mode == VariableShadingRateType::None || eye == Eye::Both ||
+                m_framesSinceDepthHints < DepthHintsPeriod) {
+                return;
+            }
+
+            // The depth swapchains created before enabling the setting cannot be sampled.
+            const auto& info = depth->getInfo();
+            if (!(info.usageFlags & XR_SWAPCHAIN_USAGE_SAMPLED_BIT) || info.sampleCount > 1) {
+                return;
+            }
+
+            const auto& output = m_depthTiles[(size_t)eye];
+            const auto& outputInfo = output->getInfo();
+
+            // The inverse of the distance is linear in the depth, which also covers the inverted and infinite depth.
+            DepthHintsConstants constants{};
+            constants.Source[0] = (float)region.rect.offset.x;
+            constants.Source[1] = (float)region.rect.offset.y;
+            constants.Source[2] = (float)region.rect.extent.width;
+            constants.Source[3] = (float)region.rect.extent.height;
+            constants.Params[0] = 1.f / depthInfo.nearZ;
+            constants.Params[1] = 1.f / depthInfo.farZ;
+            constants.Params[2] = depthInfo.minDepth;
+            constants.Params[3] = 1.f / std::max(depthInfo.maxDepth - depthInfo.minDepth, FLT_EPSILON);
+            m_cbDepthHints[(size_t)eye]->uploadData(&constants, sizeof(constants));
+
+            m_csDepthHints->updateThreadGroups({xr::math::DivideRoundingUp(outputInfo.width, 8u),
+                                                xr::math::DivideRoundingUp(outputInfo.height, 8u),
+                                                1});
+            m_device->setShader(m_csDepthHints, SamplerType::NearestClamp);
+            m_device->setShaderInput(0, m_cbDepthHints[(size_t)eye]);
+            m_device->setShaderInput(0, depth, region.slice);
+            output->setState(D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            m_device->setShaderOutput(0, output);
+            m_device->dispatchShader();
+
+            // The masks are redrawn with the new distances once both eyes are reduced.
+            m_depthHintsValid[(size_t)eye] = true;
+            if (eye == Eye::Right) {
+                m_framesSinceDepthHints = 0;
+                m_currentGen++;
+            }
+        }
+
+        std::shared_ptr<ITexture> getDepthTiles(Eye eye) const override {
+            if (eye == Eye::Both || !m_depthHintsValid[(size_t)eye]) {
+                return nullptr;
+            }
+            return m_depthTiles[(size_t)eye];
+        }
+
         void updateGazeLocation(XrVector2f gaze, Eye eye) override {
             // works with left, right and both
             if (eye != Eye::Right)
@@ -478,6 +741,18 @@ namespace {
             m_gazeOffset[1] = right;
         }
 
+        std::optional<FoveatedRegion> getFoveatedRegion(Eye eye) const override {
+            if (m_mode == VariableShadingRateType::None) {
+                return {};
+            }
+
+            // The rings are stored as 1/(a^2), 1/(b^2).
+            FoveatedRegion region;
+            region.center = m_gazeLocation[(size_t)eye];
+            region.semiAxes = {1.f / std::sqrt(m_Rings[0].x), 1.f / std::sqrt(m_Rings[0].y)};
+            return region;
+        }
+
         uint8_t getMaxRate() const override {
             return static_cast<uint8_t>(m_tileRateMax);
         }
@@ -486,9 +761,38 @@ namespace {
             return m_actualRenderWidth;
         }
 
+        VariableRateShaderStatistics getStatistics(bool withTileCoverage) override {
+            VariableRateShaderStatistics stats;
+            if (withTileCoverage) {
+                if (m_isTileCoverageDirty) {
+                    updateTileCoverage();
+                    m_isTileCoverageDirty = false;
+                }
+                std::copy(m_tileCoverage.cbegin(), m_tileCoverage.cend(), stats.tileCoverage);
+            }
+            stats.numCandidateBinds = m_numCandidateBinds;
+            for (size_t i = 0; i < std::size(m_numRejectedBinds); i++) {
+                stats.numRejectedBinds[i] = m_numRejectedBinds[i];
+            }
+            stats.numMaskHits = m_numMaskHits;
+            stats.numMaskMisses = m_numMaskMisses;
+            stats.numMaskEvictions = m_numMaskEvictions;
+            return stats;
+        }
+
+        void setDynamicRateBias(int bias) override {
+            if (bias != m_dynamicRateBias) {
+                m_dynamicRateBias = bias;
+                if (m_mode != VariableShadingRateType::None) {
+                    updateRates(m_mode);
+                    m_currentGen++;
+                }
+            }
+        }
+
         void startCapture() override {
             DebugLog("VRS: Start capture\n");
-            TraceLoggingWrite(g_traceProvider, "StartVariableRateShadingCapture");
+            TraceLoggingWrite(g_traceProvider, "StartVariableRateShadingCapture", TraceLoggingKeyword(TLK_VRS));
             m_captureID++;
             m_captureFileIndex = 0;
             m_isCapturing = true;
@@ -497,11 +801,15 @@ namespace {
         void stopCapture() override {
             if (m_isCapturing) {
                 DebugLog("VRS: Stop capture\n");
-                TraceLoggingWrite(g_traceProvider, "StopVariableRateShadingCapture");
+                TraceLoggingWrite(g_traceProvider, "StopVariableRateShadingCapture", TraceLoggingKeyword(TLK_VRS));
                 m_isCapturing = false;
             }
         }
 
+        void trim() override {
+            m_isTrimRequested = true;
+        }
+
         void doCapture(std::shared_ptr<ITexture> renderTarget = nullptr, std::optional<Eye> eyeHint = std::nullopt) {
             if (m_isCapturing) {
                 if (renderTarget) {
@@ -509,6 +817,7 @@ namespace {
 
                     TraceLoggingWrite(g_traceProvider,
                                       "VariableRateShadingCapture",
+                                      TraceLoggingKeyword(TLK_VRS),
                                       TLArg(m_captureID, "CaptureID"),
                                       TLArg(m_captureFileIndex, "CaptureFileIndex"));
 
@@ -555,11 +864,52 @@ namespace {
                 defines.add("VRS_TILE_Y", m_tileSize);
                 defines.add("VRS_NUM_RATES", 3);
 
-                // Dispatch 64 threads per group.
                 defines.add("VRS_NUM_THREADS_X", 8);
                 defines.add("VRS_NUM_THREADS_Y", 8);
 
-                m_csShading = m_device->createComputeShader(shaderFile, "mainCS", "VRS CS", {1, 1, 1}, defines.get());
+                // The thread group size of the shading rate kernel is tuned for the GPU.
+                m_csShading = CreateTunedComputeShader(
+                    m_configManager, m_device, "VRS CS", [&](const XrExtent2Di& groupSize) {
+                        defines.set("VRS_NUM_THREADS_X", groupSize.width);
+                        defines.set("VRS_NUM_THREADS_Y", groupSize.height);
+                        return m_device->createComputeShader(shaderFile, "mainCS", "VRS CS", {1, 1, 1}, defines.get());
+                    });
+
+                // Dispatch 64 threads per group.
+                defines.set("VRS_NUM_THREADS_X", 8);
+                defines.set("VRS_NUM_THREADS_Y", 8);
+                defines.add("VRS_CONTENT_ANALYSIS", true);
+                m_csContentHints =
+                    m_device->createComputeShader(shaderFile, "mainCS", "VRS Content CS", {1, 1, 1}, defines.get());
+
+                defines.set("VRS_CONTENT_ANALYSIS", false);
+                defines.add("VRS_DEPTH_ANALYSIS", true);
+                m_csDepthHints =
+                    m_device->createComputeShader(shaderFile, "mainCS", "VRS Depth CS", {1, 1, 1}, defines.get());
+            }
+
+            // Initialize the content hints, one value per tile of the render resolution.
+            {
+                XrSwapchainCreateInfo info;
+                ZeroMemory(&info, sizeof(info));
+                info.width = xr::math::DivideRoundingUp(renderWidth, m_tileSize);
+                info.height = xr::math::DivideRoundingUp(renderHeigh, m_tileSize);
+                info.format = DXGI_FORMAT_R8_UINT;
+                info.arraySize = 1;
+                info.mipCount = 1;
+                info.sampleCount = 1;
+                info.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+                for (size_t i = 0; i < ViewCount; i++) {
+                    m_contentHints[i] = m_device->createTexture(info, "VRS Content Hints TEX2D");
+                    m_cbContentHints[i] = m_device->createBuffer(sizeof(ContentHintsConstants), "VRS Content CB");
+                }
+
+                // The depth tiles hold the distance to the nearest geometry of each tile.
+                info.format = DXGI_FORMAT_R32_FLOAT;
+                for (size_t i = 0; i < ViewCount; i++) {
+                    m_depthTiles[i] = m_device->createTexture(info, "VRS Depth Tiles TEX2D");
+                    m_cbDepthHints[i] = m_device->createBuffer(sizeof(DepthHintsConstants), "VRS Depth CB");
+                }
             }
 
             // Initialize API-specific shading rate resources.
@@ -578,10 +928,10 @@ namespace {
         }
 
         void disable(std::shared_ptr<graphics::IContext> context = nullptr) {
-            TraceLoggingWrite(g_traceProvider, "DisableVariableRateShading");
+            TraceLoggingWrite(g_traceProvider, "DisableVariableRateShading", TraceLoggingKeyword(TLK_VRS));
             if (m_device->getApi() == Api::D3D11) {
                 if (!m_currentState.isActive) {
-                    TraceLoggingWrite(g_traceProvider, "SkipDisableVariableRateShading");
+                    TraceLoggingWrite(g_traceProvider, "SkipDisableVariableRateShading", TraceLoggingKeyword(TLK_VRS));
                     return;
                 }
 
@@ -630,8 +980,12 @@ namespace {
                 const auto quality = m_configManager->getEnumValue<VariableShadingRateQuality>(SettingVRSQuality);
                 for (size_t i = 0; i < 3; i++) {
                     const auto rate = i + (quality != VariableShadingRateQuality::Quality ? i : 0);
-                    m_Rates[2][i] = m_Rates[1][i] = m_Rates[0][i] = settingsRateToShadingRate(rate);
+                    // The dynamic bias only applies outside of the inner ring.
+                    m_Rates[2][i] = m_Rates[1][i] = m_Rates[0][i] =
+                        settingsRateToShadingRate(rate, i ? m_dynamicRateBias : 0);
                     m_Rates[i][3] = m_shadingRates[SHADING_RATE_CULL];
+                    m_RateVals[2][i] = m_RateVals[1][i] = m_RateVals[0][i] =
+                        settingsRateToRateVal(rate, i ? m_dynamicRateBias : 0);
                 }
 
             } else if (mode == VariableShadingRateType::Custom) {
@@ -645,15 +999,21 @@ namespace {
                 const int rateBias[3] = {std::min(leftRightBias, 0), std::max(leftRightBias, 0), 0};
 
                 for (size_t eye = 0; eye < 3; eye++) {
+                    // The dynamic bias only applies outside of the inner ring.
+                    const int outerBias = abs(rateBias[eye]) + m_dynamicRateBias;
                     m_Rates[eye][0] = settingsRateToShadingRate(rates[0], rateBias[eye], preferHorizontal);
-                    m_Rates[eye][1] = settingsRateToShadingRate(rates[1], rateBias[eye], preferHorizontal);
-                    m_Rates[eye][2] = settingsRateToShadingRate(rates[2], rateBias[eye], preferHorizontal);
+                    m_Rates[eye][1] = settingsRateToShadingRate(rates[1], outerBias, preferHorizontal);
+                    m_Rates[eye][2] = settingsRateToShadingRate(rates[2], outerBias, preferHorizontal);
                     m_Rates[eye][3] = m_shadingRates[SHADING_RATE_CULL];
+                    m_RateVals[eye][0] = settingsRateToRateVal(rates[0], rateBias[eye]);
+                    m_RateVals[eye][1] = settingsRateToRateVal(rates[1], outerBias);
+                    m_RateVals[eye][2] = settingsRateToRateVal(rates[2], outerBias);
                 }
             }
 
             TraceLoggingWrite(g_traceProvider,
                               "VariableRateShading_Rates",
+                              TraceLoggingKeyword(TLK_VRS),
                               TLArg(m_Rates[2][0], "Rate1"),
                               TLArg(m_Rates[2][1], "Rate2"),
                               TLArg(m_Rates[2][2], "Rate3"),
@@ -709,7 +1069,8 @@ namespace {
             }
 
             const auto semiMajorFactor = m_configManager->getValue(SettingVRSXScale);
-            m_Rings[0] = MakeRingParam({radius[0] * semiMajorFactor * 0.0001f, radius[0] * 0.01f});
+            m_innerRing = {radius[0] * semiMajorFactor * 0.0001f, radius[0] * 0.01f};
+            updateInnerRing();
             m_Rings[1] = MakeRingParam({radius[1] * semiMajorFactor * 0.0001f, radius[1] * 0.01f});
             m_Rings[2] = MakeRingParam({100.f, 100.f}); // large enough
             m_Rings[3] = MakeRingParam({100.f, 100.f}); // large enough
@@ -717,17 +1078,71 @@ namespace {
             m_gazeOffset[2].x = m_configManager->getValue(SettingVRSXOffset) * 0.01f;
             m_gazeOffset[2].y = m_configManager->getValue(SettingVRSYOffset) * 0.01f;
 
-            TraceLoggingWrite(
-                g_traceProvider, "VariableRateShading_Rings", TLArg(radius[0], "Ring1"), TLArg(radius[1], "Ring2"));
+            TraceLoggingWrite(g_traceProvider,
+                              "VariableRateShading_Rings",
+                              TraceLoggingKeyword(TLK_VRS),
+                              TLArg(radius[0], "Ring1"),
+                              TLArg(radius[1], "Ring2"));
+        }
+
+        void updateInnerRing() {
+            m_Rings[0] = MakeRingParam({m_innerRing.x * m_innerRingExpansion, m_innerRing.y * m_innerRingExpansion});
+        }
+
+        // Redraw the recently used masks that are out of date. The other ones are marked stale, and redrawn once they
+        // are used again.
+        void drawMasks() {
+            bool hasUpdatedMasks = false;
+            {
+                std::unique_lock lock(m_shadingRateMaskLock);
+
+                for (auto& mask : m_shadingRateMask) {
+                    if (mask->mask[0] && needsUpdate(*mask)) {
+                        if (mask->age > MaxRedrawAge) {
+                            mask->isStale = true;
+                            continue;
+                        }
+
+                        const bool isFirstUpdate = !mask->isReady;
+                        updateViews(*mask);
+                        mask->isStale = false;
+                        hasUpdatedMasks = true;
+
+                        // The mask may now be bound.
+                        if (isFirstUpdate) {
+                            mask->isReady = true;
+                            invalidateRenderTargetDecisions();
+                        }
+                    }
+                }
+            }
+
+            // The coverage is only evaluated when it is read (see getStatistics()).
+            if (hasUpdatedMasks) {
+                m_isTileCoverageDirty = true;
+            }
         }
 
         void updateGaze() {
             XrVector2f gaze[ViewCount];
             // We've determined experimentally that +4% offset gives best results.
             float xOffset = m_gazeOffset[2].x + 0.04f;
+            float innerRingExpansion = 1.f;
             if (!m_usingEyeTracking || !m_eyeTracker || !m_eyeTracker->getProjectedGaze(gaze)) {
                 gaze[0] = m_gazeOffset[0];
                 gaze[1] = m_gazeOffset[1];
+            } else if (m_eyeTracker->getGazeMovement() != input::GazeMovement::Fixation) {
+                // Cover for the latency and the inaccuracy of the landing point prediction during saccades.
+                innerRingExpansion = SaccadeInnerRingExpansion;
+            } else {
+                innerRingExpansion = std::max(m_innerRingExpansion - InnerRingContractionStep, 1.f);
+            }
+            if (innerRingExpansion != m_innerRingExpansion) {
+                m_innerRingExpansion = innerRingExpansion;
+                updateInnerRing();
+
+                // The area to redraw is only known for a constant ring size (see updateViews()).
+                m_currentGen++;
             }
             // location = view center + view offset (L/R)
             m_gazeLocation[0] = gaze[0] + XrVector2f{xOffset, m_gazeOffset[2].y};
@@ -738,44 +1153,108 @@ namespace {
             m_gazeLocation[2].y = m_gazeOffset[2].y;
         }
 
+        // Look up the decision made for a render target the last time it was bound. Decisions are cached per-thread
+        // and dropped whenever the set of masks or the candidacy criteria change.
+        const RenderTargetDecision& getRenderTargetDecision(const std::shared_ptr<ITexture>& renderTarget) {
+            static thread_local RenderTargetDecisionCache cache;
+
+            const uint64_t epoch = m_renderTargetDecisionEpoch.load(std::memory_order_acquire);
+            if (cache.epoch != epoch) {
+                cache.decisions.clear();
+                cache.epoch = epoch;
+            }
+
+            const auto& info = renderTarget->getInfo();
+            auto& decision = cache.decisions[renderTarget->getNativePtr()];
+
+            // Validate the entry in case the application recycled the address of a render target.
+            if (decision.width == info.width && decision.height == info.height &&
+                decision.arraySize == info.arraySize) {
+                return decision;
+            }
+
+            decision.width = info.width;
+            decision.height = info.height;
+            decision.arraySize = info.arraySize;
+            decision.isDoubleWide = false;
+            decision.mask.reset();
+            decision.renderScaleCounter = nullptr;
+            decision.isCandidate = isVariableRateShadingCandidate(
+                info, decision.isDoubleWide, decision.renderScaleCounter, decision.rejection);
+
+            if (decision.isCandidate) {
+                std::unique_lock lock(m_shadingRateMaskLock);
+
+                size_t maskIndex;
+                if (getMaskIndex(decision.isDoubleWide ? info.width / 2 : info.width, info.height, maskIndex)) {
+                    decision.mask = m_shadingRateMask[maskIndex];
+                }
+            }
+
+            return decision;
+        }
+
+        void invalidateRenderTargetDecisions() {
+            m_renderTargetDecisionEpoch.store(++g_renderTargetDecisionEpoch, std::memory_order_release);
+        }
+
         bool getMaskIndex(uint32_t width, uint32_t height, size_t& index) {
             const auto texW = xr::math::DivideRoundingUp(width, m_tileSize);
             const auto texH = xr::math::DivideRoundingUp(height, m_tileSize);
 
             // Look-up existing resources.
             for (size_t i = 0; i < m_shadingRateMask.size(); i++) {
-                if (m_shadingRateMask[i].widthInTiles == texW && m_shadingRateMask[i].heightInTiles == texH) {
+                if (m_shadingRateMask[i]->widthInTiles == texW && m_shadingRateMask[i]->heightInTiles == texH) {
                     index = i;
 
-                    // Do not return invalid masks deferred to the next frame.
-                    return !!m_shadingRateMask[i].mask[0];
+                    // Do not return the masks that were not drawn yet.
+                    return m_shadingRateMask[i]->isReady;
                 }
             }
 
             TraceLoggingWrite(g_traceProvider,
                               "VariableRateShading_CreateMask",
+                              TraceLoggingKeyword(TLK_VRS),
                               TLArg(width, "Width"),
                               TLArg(height, "Height"),
                               TLArg(texW, "WidthInTiles"),
                               TLArg(texH, "HeightInTiles"),
                               TLArg("Deferred", "State"));
 
-            ShadingRateMask newMask;
-            newMask.widthInTiles = texW;
-            newMask.heightInTiles = texH;
-            newMask.age = 0;
-            newMask.gen = 0;
+            auto newMask = std::make_shared<ShadingRateMask>();
+            newMask->widthInTiles = texW;
+            newMask->heightInTiles = texH;
+            newMask->age = 0;
+            newMask->gen = 0;
 
             // Defer creation to the next beginFrame() event.
-            m_shadingRateMask.push_back(newMask);
+            m_shadingRateMask.push_back(std::move(newMask));
 
             return false;
         }
 
+        // Create the resources of a mask ahead of its first use.
+        void prewarmMask(uint32_t width, uint32_t height) {
+            std::unique_lock lock(m_shadingRateMaskLock);
+
+            size_t index;
+            getMaskIndex(width, height, index);
+            createPendingMasks();
+        }
+
+        void createPendingMasks() {
+            for (auto& mask : m_shadingRateMask) {
+                if (!mask->mask[0]) {
+                    createMaskResources(*mask);
+                }
+            }
+        }
+
         void createMaskResources(ShadingRateMask& mask) {
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "VariableRateShading_CreateMask",
+                                   TraceLoggingKeyword(TLK_VRS),
                                    TLArg(mask.widthInTiles, "WidthInTiles"),
                                    TLArg(mask.heightInTiles, "HeightInTiles"),
                                    TLArg("Current", "State"));
@@ -795,6 +1274,9 @@ namespace {
             for (auto& it : mask.mask) {
                 it = m_device->createTexture(info, "VRS TEX2D");
             }
+            for (auto& it : mask.base) {
+                it = m_device->createTexture(info, "VRS Base TEX2D");
+            }
             info.width *= 2;
             mask.maskDoubleWide = m_device->createTexture(info, "VRS DoubleWide TEX2D");
             info.width = mask.widthInTiles;
@@ -805,6 +1287,10 @@ namespace {
                 it = m_device->createBuffer(sizeof(ShadingConstants), "VRS CB");
             }
 
+            // One byte per tile, for the masks and their base, plus the double-wide and texture array masks.
+            mask.sizeInBytes = (uint64_t)mask.widthInTiles * mask.heightInTiles *
+                               (std::size(mask.mask) + std::size(mask.base) + 2 * ViewCount);
+
             if (auto device11 = m_device->getAs<D3D11>()) {
                 NV_D3D11_SHADING_RATE_RESOURCE_VIEW_DESC desc;
                 ZeroMemory(&desc, sizeof(desc));
@@ -813,99 +1299,134 @@ namespace {
                 desc.ViewDimension = NV_SRRV_DIMENSION_TEXTURE2D;
                 desc.Texture2D.MipSlice = 0;
 
-                const auto newIndex = m_NvShadingRateResources.views.size();
-                m_NvShadingRateResources.views.push_back({});
-                m_NvShadingRateResources.viewsDoubleWide.push_back({});
-                m_NvShadingRateResources.viewsTextureArray.push_back({});
-
                 for (size_t i = 0; i < std::size(mask.mask); i++) {
-                    CHECK_NVCMD(
-                        NvAPI_D3D11_CreateShadingRateResourceView(device11,
-                                                                  mask.mask[i]->getAs<D3D11>(),
-                                                                  &desc,
-                                                                  set(m_NvShadingRateResources.views[newIndex][i])));
+                    CHECK_NVCMD(NvAPI_D3D11_CreateShadingRateResourceView(
+                        device11, mask.mask[i]->getAs<D3D11>(), &desc, set(mask.nvView[i])));
                 }
 
-                CHECK_NVCMD(
-                    NvAPI_D3D11_CreateShadingRateResourceView(device11,
-                                                              mask.maskDoubleWide->getAs<D3D11>(),
-                                                              &desc,
-                                                              set(m_NvShadingRateResources.viewsDoubleWide[newIndex])));
+                CHECK_NVCMD(NvAPI_D3D11_CreateShadingRateResourceView(
+                    device11, mask.maskDoubleWide->getAs<D3D11>(), &desc, set(mask.nvViewDoubleWide)));
 
                 desc.ViewDimension = NV_SRRV_DIMENSION_TEXTURE2DARRAY;
                 desc.Texture2DArray.ArraySize = 2;
                 CHECK_NVCMD(NvAPI_D3D11_CreateShadingRateResourceView(
-                    device11,
-                    mask.maskTextureArray->getAs<D3D11>(),
-                    &desc,
-                    set(m_NvShadingRateResources.viewsTextureArray[newIndex])));
+                    device11, mask.maskTextureArray->getAs<D3D11>(), &desc, set(mask.nvViewTextureArray)));
             }
 
-            TraceLoggingWriteStop(local, "VariableRateShading_CreateMask");
+            TraceLoggingWriteStop(local, "VariableRateShading_CreateMask", TraceLoggingKeyword(TLK_VRS));
+        }
+
+        // Check if this mask needs to be updated.
+        bool needsUpdate(const ShadingRateMask& mask) const {
+            return !mask.isReady || mask.gen != m_currentGen || hasGazeMovedByTile(mask);
         }
 
         void updateViews(ShadingRateMask& mask) {
-            // Check if this mask needs to be updated.
-            if (mask.gen == m_currentGen) {
-                return;
-            }
+            // A change of the mask parameters requires to redraw the entire masks, while a movement of the gaze only
+            // requires to redraw the regions around the old and new gaze.
+            const bool isFullUpdate = !mask.isReady || mask.gen != m_currentGen;
             mask.gen = m_currentGen;
 
             TraceLocalActivity(local);
             TraceLoggingWriteStart(local,
                                    "VariableRateShading_UpdateMask",
+                                   TraceLoggingKeyword(TLK_VRS),
                                    TLArg(mask.widthInTiles, "WidthInTiles"),
-                                   TLArg(mask.heightInTiles, "HeightInTiles"));
+                                   TLArg(mask.heightInTiles, "HeightInTiles"),
+                                   TLArg(isFullUpdate, "FullUpdate"));
+
+            m_device->beginProfileScope("VRS");
+            if (isFullUpdate) {
+                for (size_t i = 0; i < std::size(mask.base); i++) {
+                    m_device->setRenderTargets(1, &mask.base[i]);
+                    m_device->clearColor(
+                        0.f, 0.f, (float)mask.heightInTiles, (float)mask.widthInTiles, {255.f, 255.f, 255.f, 255.f});
+
+                    // Initialize mask with HAM culling if needed.
+                    if (i < ViewCount && m_isHAMReady && !m_configManager->peekValue(SettingDisableHAM) &&
+                        m_configManager->getValue(SettingVRSCullHAM)) {
+                        m_device->setViewProjection(m_viewProjection[i]);
+                        m_device->draw(m_HAM[i], Pose::Identity(), {1.f, 1.f, 1.f}, true);
+                    }
+                }
+                m_device->unsetRenderTargets();
+            }
 
-            for (size_t i = 0; i < std::size(mask.mask); i++) {
-                m_device->setRenderTargets(1, &mask.mask[i]);
-                m_device->clearColor(
-                    0.f, 0.f, (float)mask.heightInTiles, (float)mask.widthInTiles, {255.f, 255.f, 255.f, 255.f});
-
-                // Initialize mask with HAM culling if needed.
-                if (i < ViewCount && m_isHAMReady && !m_configManager->peekValue(SettingDisableHAM) &&
-                    m_configManager->getValue(SettingVRSCullHAM)) {
-                    m_device->setViewProjection(m_viewProjection[i]);
-                    m_device->draw(m_HAM[i], Pose::Identity(), {1.f, 1.f, 1.f}, true);
+            // List the ring patterns to draw into each mask. With eye tracking, or when the generic mask is used for
+            // texture arrays (DX12), the generic mask combines the patterns of both eyes.
+            const bool isCombinedMask = m_usingEyeTracking || m_device->getApi() == Api::D3D12;
+            std::vector<ShadingPass> passes;
+            for (size_t i = 0; i < std::size(mask.mask) + (isCombinedMask ? 1 : 0); i++) {
+                passes.push_back({std::min(i, std::size(mask.mask) - 1), isCombinedMask ? i % 2 : i, false});
+            }
+            if (m_usingEyeTracking && m_needMirroredPattern) {
+                for (size_t i = 0; i < ViewCount; i++) {
+                    passes.push_back({i, i, true});
+                }
+            }
+
+            // Compute the region to redraw in each mask.
+            const XrRect2Di fullRegion{{0, 0}, {(int32_t)mask.widthInTiles, (int32_t)mask.heightInTiles}};
+            XrRect2Di regions[ViewCount + 1]{};
+            for (const auto& pass : passes) {
+                if (isFullUpdate) {
+                    regions[pass.target] = fullRegion;
+                } else {
+                    regions[pass.target] = unionRegion(
+                        regions[pass.target],
+                        unionRegion(getGazeRegion(mask.gazeLocation[pass.eye], pass.upsideDown, mask),
+                                    getGazeRegion(m_gazeLocation[pass.eye], pass.upsideDown, mask)));
                 }
             }
 
             // Draw the rings into the mask.
-            const auto dispatchX = xr::math::DivideRoundingUp(mask.widthInTiles, 8);
-            const auto dispatchY = xr::math::DivideRoundingUp(mask.heightInTiles, 8);
-            for (size_t i = 0; i < std::size(mask.mask) + 1; i++) {
-                size_t target = std::min(i, std::size(mask.mask) - 1);
-                size_t eye = i;
-                ShadingConstants constants;
-                if (m_usingEyeTracking) {
-                    // The combined mask has both eyes.
-                    eye = eye % 2;
+            bool isFirstPass[ViewCount + 1];
+            std::fill_n(isFirstPass, std::size(isFirstPass), true);
+            for (size_t i = 0; i < passes.size(); i++) {
+                const auto& pass = passes[i];
+                const auto& region = regions[pass.target];
+                if (region.extent.width <= 0 || region.extent.height <= 0) {
+                    continue;
                 }
-                constants = makeShadingConstants(eye, mask.widthInTiles, mask.heightInTiles);
-                mask.cbShading[i]->uploadData(&constants, sizeof(constants));
 
-                m_csShading->updateThreadGroups({dispatchX, dispatchY, 1});
-                m_device->setShader(m_csShading, SamplerType::NearestClamp);
+                // The content hints are only available per eye.
+                const bool useContentHints =
+                    m_isContentAdaptive && pass.eye < ViewCount && m_contentHintsValid[pass.eye];
+                const bool useDepthHints = m_isDepthAdaptive && pass.eye < ViewCount && m_depthHintsValid[pass.eye];
+
+                auto constants = makeShadingConstants(pass.eye, mask.widthInTiles, mask.heightInTiles, pass.upsideDown);
+                constants.Region[0] = region.offset.x;
+                constants.Region[1] = region.offset.y;
+                constants.Region[2] = isFirstPass[pass.target];
+                constants.HintRates[0] = 0;
+                constants.HintRates[1] = settingsRateToShadingRate(2);
+                constants.HintRates[2] = settingsRateToShadingRate(4);
+                constants.HintRates[3] = useContentHints;
+                constants.DepthParams[0] = (float)m_configManager->getValue(SettingVRSDepthDistance2x2);
+                constants.DepthParams[1] = (float)m_configManager->getValue(SettingVRSDepthDistance4x4);
+                constants.DepthParams[2] = useDepthHints;
+                mask.cbShading[i]->uploadData(&constants, sizeof(constants));
+                isFirstPass[pass.target] = false;
+
+                m_csShading->beginDispatch();
+                const auto shader = m_csShading->getShader();
+                const auto groupSize = m_csShading->getThreadGroupSize();
+                shader->updateThreadGroups(
+                    {xr::math::DivideRoundingUp((uint32_t)region.extent.width, (uint32_t)groupSize.width),
+                     xr::math::DivideRoundingUp((uint32_t)region.extent.height, (uint32_t)groupSize.height),
+                     1});
+                m_device->setShader(shader, SamplerType::NearestClamp);
                 m_device->setShaderInput(0, mask.cbShading[i]);
-                mask.mask[target]->setState(D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-                m_device->setShaderOutput(0, mask.mask[target]);
+                m_device->setShaderInput(0, mask.base[pass.target]);
+                m_device->setShaderInput(1, useContentHints ? m_contentHints[pass.eye] : mask.base[pass.target]);
+                m_device->setShaderInput(2, m_depthTiles[std::min(pass.eye, (size_t)ViewCount - 1)]);
+                mask.mask[pass.target]->setState(D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                m_device->setShaderOutput(0, mask.mask[pass.target]);
                 m_device->dispatchShader();
-                mask.mask[target]->setState(D3D12_RESOURCE_STATE_COPY_SOURCE);
-            }
-            if (m_usingEyeTracking && m_needMirroredPattern) {
-                for (size_t i = 0; i < 2; i++) {
-                    const auto constants = makeShadingConstants(i, mask.widthInTiles, mask.heightInTiles, true);
-                    mask.cbShading[i]->uploadData(&constants, sizeof(constants));
-
-                    m_csShading->updateThreadGroups({dispatchX, dispatchY, 1});
-                    m_device->setShader(m_csShading, SamplerType::NearestClamp);
-                    m_device->setShaderInput(0, mask.cbShading[i]);
-                    mask.mask[i]->setState(D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-                    m_device->setShaderOutput(0, mask.mask[i]);
-                    m_device->dispatchShader();
-                    mask.mask[i]->setState(D3D12_RESOURCE_STATE_COPY_SOURCE);
-                }
+                m_csShading->endDispatch();
+                mask.mask[pass.target]->setState(D3D12_RESOURCE_STATE_COPY_SOURCE);
             }
+            std::copy_n(m_gazeLocation, std::size(m_gazeLocation), mask.gazeLocation);
 
             // Copy to the double wide/texture arrays mask.
             mask.mask[0]->copyTo(mask.maskDoubleWide, 0, 0, 0);
@@ -916,12 +1437,66 @@ namespace {
             for (size_t i = 0; i < std::size(mask.mask); i++) {
                 mask.mask[i]->setState(D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE);
             }
+            m_device->endProfileScope();
+
+            TraceLoggingWriteStop(local, "VariableRateShading_UpdateMask", TraceLoggingKeyword(TLK_VRS));
+        }
+
+        // Whether the gaze moved by at least one tile since the mask was last drawn.
+        bool hasGazeMovedByTile(const ShadingRateMask& mask) const {
+            for (size_t i = 0; i < std::size(m_gazeLocation); i++) {
+                // The gaze is in NDC, which span 2 units across the mask.
+                if (std::abs(m_gazeLocation[i].x - mask.gazeLocation[i].x) * mask.widthInTiles >= 2.f ||
+                    std::abs(m_gazeLocation[i].y - mask.gazeLocation[i].y) * mask.heightInTiles >= 2.f) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // The region of a mask (in tiles) where the rings depend on the gaze location. The outermost ring covers the
+        // entire mask, so only the bounding box of the inner rings is needed.
+        XrRect2Di getGazeRegion(XrVector2f gaze, bool upsideDown, const ShadingRateMask& mask) const {
+            if (upsideDown) {
+                gaze.y = -gaze.y;
+            }
+
+            // The rings are stored as 1/(a^2), 1/(b^2).
+            float a = 0.f, b = 0.f;
+            for (size_t i = 0; i < std::size(m_Rings) - 2; i++) {
+                a = std::max(a, 1.f / std::sqrt(m_Rings[i].x));
+                b = std::max(b, 1.f / std::sqrt(m_Rings[i].y));
+            }
+
+            // NDC to tiles (y flip), with one tile of margin.
+            const auto width = (int32_t)mask.widthInTiles;
+            const auto height = (int32_t)mask.heightInTiles;
+            const auto left = std::clamp((int32_t)std::floor((gaze.x - a + 1.f) * 0.5f * width) - 1, 0, width);
+            const auto right = std::clamp((int32_t)std::ceil((gaze.x + a + 1.f) * 0.5f * width) + 1, 0, width);
+            const auto top = std::clamp((int32_t)std::floor((1.f - gaze.y - b) * 0.5f * height) - 1, 0, height);
+            const auto bottom = std::clamp((int32_t)std::ceil((1.f - gaze.y + b) * 0.5f * height) + 1, 0, height);
 
-            TraceLoggingWriteStop(local, "VariableRateShading_UpdateMask");
+            return {{left, top}, {right - left, bottom - top}};
+        }
+
+        static XrRect2Di unionRegion(const XrRect2Di& a, const XrRect2Di& b) {
+            if (a.extent.width <= 0 || a.extent.height <= 0) {
+                return b;
+            }
+            if (b.extent.width <= 0 || b.extent.height <= 0) {
+                return a;
+            }
+
+            const auto left = std::min(a.offset.x, b.offset.x);
+            const auto top = std::min(a.offset.y, b.offset.y);
+            const auto right = std::max(a.offset.x + a.extent.width, b.offset.x + b.extent.width);
+            const auto bottom = std::max(a.offset.y + a.extent.height, b.offset.y + b.extent.height);
+
+            return {{left, top}, {right - left, bottom - top}};
         }
 
         ShadingConstants makeShadingConstants(size_t eye, uint32_t texW, uint32_t texH, bool upsideDown = false) {
-            ShadingConstants constants;
+            ShadingConstants constants{};
             if (!upsideDown) {
                 constants.GazeXY = m_gazeLocation[eye];
             } else {
@@ -952,6 +1527,45 @@ namespace {
             return m_shadingRates[SHADING_RATE_CULL];
         }
 
+        // Same as settingsRateToShadingRate(), but for config::VariableShadingRateVal (the horizontal and vertical
+        // rates are not distinguished).
+        static VariableShadingRateVal settingsRateToRateVal(size_t settingsRate, int rateBias = 0) {
+            const auto maxRate = (size_t)to_integral(VariableShadingRateVal::R_4x4);
+            if (settingsRate <= maxRate) {
+                return (VariableShadingRateVal)std::min(settingsRate + abs(rateBias), maxRate);
+            }
+            return VariableShadingRateVal::R_Cull;
+        }
+
+        // Evaluate the ring patterns of both views on the tiles of the actual render resolution, the same way as the
+        // VRS shader does.
+        void updateTileCoverage() {
+            const auto texW = xr::math::DivideRoundingUp(m_actualRenderWidth, m_tileSize);
+            const auto texH = xr::math::DivideRoundingUp((uint32_t)(m_actualRenderWidth / m_renderRatio), m_tileSize);
+
+            std::array<uint32_t, to_integral(VariableShadingRateVal::MaxValue)> counts{};
+            for (size_t eye = 0; eye < ViewCount; eye++) {
+                for (uint32_t y = 0; y < texH; y++) {
+                    const float dy = 1.f - 2.f * (y + 0.5f) / texH - m_gazeLocation[eye].y;
+                    for (uint32_t x = 0; x < texW; x++) {
+                        const float dx = 2.f * (x + 0.5f) / texW - 1.f - m_gazeLocation[eye].x;
+
+                        // The last ring covers the entire view.
+                        size_t ring = 0;
+                        while (ring < 2 && dx * dx * m_Rings[ring].x + dy * dy * m_Rings[ring].y > 1.f) {
+                            ring++;
+                        }
+                        counts[to_integral(m_RateVals[eye][ring])]++;
+                    }
+                }
+            }
+
+            const float total = (float)std::max(ViewCount * texW * texH, 1u);
+            for (size_t i = 0; i < counts.size(); i++) {
+                m_tileCoverage[i] = counts[i] / total;
+            }
+        }
+
         void resetShadingRates(Api api) {
             if (api == Api::D3D11) {
                 // Implementation uses a constant table with a varying shading rate texture
@@ -1004,9 +1618,13 @@ namespace {
             }
         }
 
-        bool isVariableRateShadingCandidate(const XrSwapchainCreateInfo& info, bool& isDoubleWide) {
+        bool isVariableRateShadingCandidate(const XrSwapchainCreateInfo& info,
+                                            bool& isDoubleWide,
+                                            std::atomic<uint32_t>*& renderScaleCounter,
+                                            VariableRateShaderRejection& rejection) {
             TraceLoggingWrite(g_traceProvider,
                               "IsVariableRateShadingCandidate",
+                              TraceLoggingKeyword(TLK_VRS),
                               TLArg(info.width, "Width"),
                               TLArg(info.height, "Height"),
                               TLArg(info.arraySize, "ArraySize"),
@@ -1024,16 +1642,17 @@ namespace {
 
                 std::unique_lock lock(m_renderScalesLock);
 
+                // The counters are never destroyed, so they can be incremented without the lock.
                 auto it = m_renderScales.find(width);
                 if (it == m_renderScales.end()) {
-                    m_renderScales.insert_or_assign(width, 1u);
-                } else {
-                    it->second++;
+                    it = m_renderScales.insert_or_assign(width, std::make_unique<std::atomic<uint32_t>>(0u)).first;
                 }
+                renderScaleCounter = it->second.get();
             };
 
             if (!isDoubleWide) {
                 if (std::abs(aspectRatio - m_renderRatio) > 0.01f) {
+                    rejection = VariableRateShaderRejection::AspectRatio;
                     return false;
                 }
 
@@ -1041,10 +1660,12 @@ namespace {
 
                 // Check for proportionality with the size of our render target.
                 if (info.width < (m_actualRenderWidth * m_filterScale)) {
+                    rejection = VariableRateShaderRejection::Size;
                     return false;
                 }
 
                 if (info.arraySize > 2) {
+                    rejection = VariableRateShaderRejection::ArraySize;
                     return false;
                 }
             } else {
@@ -1052,6 +1673,7 @@ namespace {
 
                 // Check for proportionality with the size of our render target.
                 if (info.width / 2 < (m_actualRenderWidth * m_filterScale)) {
+                    rejection = VariableRateShaderRejection::Size;
                     return false;
                 }
             }
@@ -1071,10 +1693,11 @@ namespace {
         const float m_renderRatio;
 
         XrSession m_session{XR_NULL_HANDLE};
+        XrSpace m_viewSpace{XR_NULL_HANDLE};
         bool m_usingEyeTracking{false};
         bool m_needMirroredPattern{false};
 
-        std::map<uint32_t, uint32_t> m_renderScales;
+        std::map<uint32_t, std::unique_ptr<std::atomic<uint32_t>>> m_renderScales;
         uint32_t m_actualRenderWidth;
         std::mutex m_renderScalesLock;
         float m_filterScale{0.51f};
@@ -1093,19 +1716,50 @@ namespace {
         uint64_t m_currentGen{0};
 
         VariableShadingRateType m_mode{VariableShadingRateType::None};
+        int m_dynamicRateBias{0};
 
         // ShadingConstants
         XrVector2f m_gazeOffset[ViewCount + 1];
         XrVector2f m_gazeLocation[ViewCount + 1];
         XrVector2f m_Rings[4];
+        XrVector2f m_innerRing{};
+        float m_innerRingExpansion{1.f};
         uint8_t m_Rates[ViewCount + 1][4];
+        VariableShadingRateVal m_RateVals[ViewCount + 1][3];
 
         // ShadingRates to Graphics API specific rates LUT.
         uint8_t m_shadingRates[SHADING_RATE_COUNT];
 
-        std::shared_ptr<IComputeShader> m_csShading;
-        std::vector<ShadingRateMask> m_shadingRateMask;
+        std::shared_ptr<ITunedComputeShader> m_csShading;
+
+        bool m_isContentAdaptive{false};
+        uint32_t m_framesSinceContentHints{0};
+        std::shared_ptr<IComputeShader> m_csContentHints;
+        std::shared_ptr<ITexture> m_contentHints[ViewCount];
+        std::shared_ptr<IShaderBuffer> m_cbContentHints[ViewCount];
+        std::array<bool, ViewCount> m_contentHintsValid{};
+
+        bool m_isDepthAdaptive{false};
+        uint32_t m_framesSinceDepthHints{0};
+        std::shared_ptr<IComputeShader> m_csDepthHints;
+        std::shared_ptr<ITexture> m_depthTiles[ViewCount];
+        std::shared_ptr<IShaderBuffer> m_cbDepthHints[ViewCount];
+        std::array<bool, ViewCount> m_depthHintsValid{};
+        std::vector<std::shared_ptr<ShadingRateMask>> m_shadingRateMask;
         std::mutex m_shadingRateMaskLock;
+        std::atomic<uint64_t> m_renderTargetDecisionEpoch{++g_renderTargetDecisionEpoch};
+
+        // Statistics, reset at the beginning of each frame.
+        std::atomic<uint32_t> m_numCandidateBinds{0};
+        std::atomic<uint32_t> m_numRejectedBinds[to_integral(VariableRateShaderRejection::MaxValue)]{};
+        std::atomic<uint32_t> m_numMaskHits{0};
+        std::atomic<uint32_t> m_numMaskMisses{0};
+        uint32_t m_numMaskEvictions{0};
+        std::array<float, to_integral(VariableShadingRateVal::MaxValue)> m_tileCoverage{};
+        bool m_isTileCoverageDirty{false};
+
+        // Whether to evict the unused masks on the next update.
+        std::atomic<bool> m_isTrimRequested{false};
 
         bool m_isHAMEnabled{false};
         bool m_isHAMReady{false};
@@ -1129,10 +1783,6 @@ namespace {
                 // Make sure to unload NvAPI on destruction
                 deferredUnloadNvAPI.needUnload = true;
             }
-            std::vector<std::array<ComPtr<ID3D11NvShadingRateResourceView>, ViewCount + 1>> views;
-            std::vector<ComPtr<ID3D11NvShadingRateResourceView>> viewsDoubleWide;
-            std::vector<ComPtr<ID3D11NvShadingRateResourceView>> viewsTextureArray;
-
         } m_NvShadingRateResources;
 
         // We use a constant table and a varying shading rate texture filled with a compute shader.
@@ -1169,6 +1819,12 @@ namespace toolkit::graphics {
             uint32_t tileRateMax = 0;
 
             if (auto device11 = graphicsDevice->getAs<D3D11>()) {
+                // There is no vendor-neutral VRS with DX11, and the only extension we support is NVAPI.
+                if (graphicsDevice->GetGpuArchitecture() != GpuArchitecture::NVidia) {
+                    Log("VRS (DX11) is only supported on NVidia adapters, use DX12 (Tier2) instead\n");
+                    throw FeatureNotSupported();
+                }
+
                 auto status = NvAPI_Initialize();
                 if (status != NVAPI_OK) {
                     NvAPI_ShortString errorMessage;
@@ -0,0 +1,758 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "layer.h"
+#include "log.h"
+#include "overhead.h"
+
+// A standalone benchmark of the image processors and of the VRS mask generation, running on a headless device outside
+// of any OpenXR session. The GPU time of each pass is measured over many iterations with the same timers as the
+// developer overlay.
+
+namespace toolkit::log {
+    extern std::ofstream logStream;
+} // namespace toolkit::log
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::config;
+    using namespace toolkit::graphics;
+    using namespace toolkit::log;
+
+    // The subset of the DDS headers needed for reading uncompressed images (see ScreenGrab12.cpp).
+#pragma pack(push, 1)
+    constexpr uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+    constexpr uint32_t DDS_FOURCC = 0x00000004;
+    constexpr uint32_t DDS_RGB = 0x00000040;
+
+    struct DDS_PIXELFORMAT {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t RGBBitCount;
+        uint32_t RBitMask;
+        uint32_t GBitMask;
+        uint32_t BBitMask;
+        uint32_t ABitMask;
+    };
+
+    struct DDS_HEADER {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DDS_PIXELFORMAT ddspf;
+        uint32_t caps;
+        uint32_t caps2;
+        uint32_t caps3;
+        uint32_t caps4;
+        uint32_t reserved2;
+    };
+
+    struct DDS_HEADER_DXT10 {
+        DXGI_FORMAT dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t reserved;
+    };
+#pragma pack(pop)
+
+    const std::vector<std::string> AllPasses = {"nis", "fsr", "cas", "temporal", "postprocess", "vrs"};
+
+    struct BenchmarkOptions {
+        Api api{Api::D3D11};
+        uint32_t adapterIndex{0};
+        uint32_t displayWidth{2064};
+        uint32_t displayHeight{2208};
+        int scaling{130};
+        uint32_t iterations{500};
+        uint32_t warmupIterations{50};
+        std::filesystem::path inputFile;
+        std::filesystem::path jsonFile;
+        std::vector<std::string> passes{AllPasses};
+    };
+
+    struct PassResult {
+        std::string name;
+        XrExtent2Di inputSize;
+        XrExtent2Di outputSize;
+        std::vector<uint64_t> samplesUs;
+        std::string skipReason;
+    };
+
+    // The content to process, either loaded from a DDS file (such as a screenshot taken with the toolkit) or generated.
+    struct InputImage {
+        uint32_t width{0};
+        uint32_t height{0};
+        std::vector<uint32_t> pixels; // R8G8B8A8
+    };
+
+    void PrintUsage() {
+        std::cout << "Usage: benchmark [options]\n"
+                     "  --api d3d11|d3d12      Graphics API (default d3d11)\n"
+                     "  --adapter N            Index of the DXGI adapter (default 0)\n"
+                     "  --resolution WxH       Output (display) resolution of a view (default 2064x2208)\n"
+                     "  --scaling N            Upscaling factor in percent (default 130)\n"
+                     "  --input FILE.dds       Uncompressed 32bpp DDS image to use as the input of the upscalers\n"
+                     "  --iterations N         Number of measured iterations per pass (default 500)\n"
+                     "  --warmup N             Number of iterations before measuring (default 50)\n"
+                     "  --passes a,b,...       Passes to run among nis,fsr,cas,temporal,postprocess,vrs (default all)\n"
+                     "  --json FILE            Also write the results to a JSON file\n"
+                     "\n"
+                     "Usage: benchmark overhead [options]\n"
+                     "  Measure the CPU overhead of the layer against a mock runtime (see overhead --help)\n";
+    }
+
+    BenchmarkOptions ParseOptions(int argc, char** argv) {
+        BenchmarkOptions options;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                PrintUsage();
+                exit(0);
+            }
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for option " + arg);
+            }
+            const std::string value = argv[++i];
+
+            if (arg == "--api") {
+                if (value == "d3d11") {
+                    options.api = Api::D3D11;
+                } else if (value == "d3d12") {
+                    options.api = Api::D3D12;
+                } else {
+                    throw std::runtime_error("Unknown graphics API " + value);
+                }
+            } else if (arg == "--adapter") {
+                options.adapterIndex = std::stoul(value);
+            } else if (arg == "--resolution") {
+                if (sscanf_s(value.c_str(), "%ux%u", &options.displayWidth, &options.displayHeight) != 2) {
+                    throw std::runtime_error("Invalid resolution " + value);
+                }
+            } else if (arg == "--scaling") {
+                options.scaling = std::stoi(value);
+            } else if (arg == "--input") {
+                options.inputFile = value;
+            } else if (arg == "--iterations") {
+                options.iterations = std::max(1ul, std::stoul(value));
+            } else if (arg == "--warmup") {
+                options.warmupIterations = std::stoul(value);
+            } else if (arg == "--passes") {
+                options.passes.clear();
+                std::stringstream list(value);
+                std::string pass;
+                while (std::getline(list, pass, ',')) {
+                    if (std::find(AllPasses.cbegin(), AllPasses.cend(), pass) == AllPasses.cend()) {
+                        throw std::runtime_error("Unknown pass " + pass);
+                    }
+                    options.passes.push_back(pass);
+                }
+            } else if (arg == "--json") {
+                options.jsonFile = value;
+            } else {
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+        return options;
+    }
+
+    // Only the uncompressed 32bpp formats are supported, which is what the screenshots are saved with.
+    InputImage LoadDDS(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        uint32_t magic = 0;
+        DDS_HEADER header{};
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || magic != DDS_MAGIC || header.size != sizeof(DDS_HEADER)) {
+            throw std::runtime_error("Not a DDS file: " + path.string());
+        }
+
+        bool isBGRA = false;
+        if ((header.ddspf.flags & DDS_FOURCC) && header.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0')) {
+            DDS_HEADER_DXT10 header10{};
+            file.read(reinterpret_cast<char*>(&header10), sizeof(header10));
+            switch (header10.dxgiFormat) {
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+                break;
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+                isBGRA = true;
+                break;
+            default:
+                throw std::runtime_error(fmt::format("Unsupported DDS format {}", (int)header10.dxgiFormat));
+            }
+        } else if ((header.ddspf.flags & DDS_RGB) && header.ddspf.RGBBitCount == 32) {
+            isBGRA = header.ddspf.RBitMask == 0x00ff0000;
+        } else {
+            throw std::runtime_error("Unsupported DDS format (expected uncompressed 32bpp)");
+        }
+
+        InputImage image{header.width, header.height};
+        image.pixels.resize((size_t)image.width * image.height);
+        file.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size() * sizeof(uint32_t));
+        if (!file) {
+            throw std::runtime_error("Truncated DDS file: " + path.string());
+        }
+
+        if (isBGRA) {
+            for (auto& pixel : image.pixels) {
+                pixel = (pixel & 0xff00ff00) | ((pixel & 0xff) << 16) | ((pixel >> 16) & 0xff);
+            }
+        }
+        return image;
+    }
+
+    // Edges at all orientations and smooth gradients, to exercise the edge-adaptive paths of the upscalers.
+    InputImage GenerateImage(uint32_t width, uint32_t height) {
+        InputImage image{width, height};
+        image.pixels.resize((size_t)width * height);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                const float u = (float)x / width;
+                const float v = (float)y / height;
+                const float dx = u - 0.5f;
+                const float dy = v - 0.5f;
+                const bool checker = ((x / 32) + (y / 32)) % 2;
+                const bool ring = (int)(std::sqrt(dx * dx + dy * dy) * 96.f) % 2;
+                const uint8_t r = (uint8_t)(u * 255.f);
+                const uint8_t g = (uint8_t)(checker ? 200 : 40);
+                const uint8_t b = (uint8_t)(ring ? v * 255.f : 255.f - v * 255.f);
+                image.pixels[(size_t)y * width + x] = r | (g << 8) | (b << 16) | 0xff000000;
+            }
+        }
+        return image;
+    }
+
+    // The defaults of the settings read by the benchmarked passes are shared with the layer. The values can be
+    // overridden in the registry, under the key of the benchmark application.
+    void SetOptionsDefaults(IConfigManager& configManager) {
+        SetProcessingDefaults(configManager);
+
+        // The post-processing is benchmarked with its full shader, rather than as a pass-through.
+        configManager.setEnumDefault(SettingPostProcess, PostProcessType::On);
+        configManager.setEnumDefault(SettingVRS, VariableShadingRateType::Preset);
+        configManager.setDefault(SettingVRSScaleFilter, 80);
+        configManager.setDefault(SettingEyeTrackingEnabled, 0);
+
+        // The samples must all be timed with the same thread group size, and the tuning would store its winner as the
+        // one for the user's applications.
+        configManager.setDefault(SettingShaderTuning, 0);
+        if (configManager.getValue(SettingShaderTuning)) {
+            Log("Ignoring the shader tuning setting\n");
+            configManager.setValue(SettingShaderTuning, 0, true);
+        }
+    }
+
+    // The VRS only calls into OpenXR for the hidden area mesh, which is not used without a session.
+    class NullOpenXrApi : public OpenXrApi {};
+
+    // The context passed to the VRS for binding the shading rate masks, standing in for the application's context.
+    class BenchmarkContext : public IContext {
+      public:
+        BenchmarkContext(std::shared_ptr<IDevice> device, void* context) : m_device(device), m_context(context) {
+        }
+
+        Api getApi() const override {
+            return m_device->getApi();
+        }
+
+        std::shared_ptr<IDevice> getDevice() const override {
+            return m_device;
+        }
+
+        void* getNativePtr() const override {
+            return m_context;
+        }
+
+      private:
+        const std::shared_ptr<IDevice> m_device;
+        void* const m_context;
+    };
+
+    class Benchmark {
+      public:
+        Benchmark(const BenchmarkOptions& options) : m_options(options) {
+            m_configManager = CreateConfigManager(LayerPrettyName + "-Benchmark");
+            SetOptionsDefaults(*m_configManager);
+
+            ComPtr<IDXGIFactory1> dxgiFactory;
+            CHECK_HRCMD(CreateDXGIFactory1(IID_PPV_ARGS(set(dxgiFactory))));
+            ComPtr<IDXGIAdapter1> adapter;
+            if (dxgiFactory->EnumAdapters1(options.adapterIndex, set(adapter)) == DXGI_ERROR_NOT_FOUND) {
+                throw std::runtime_error(fmt::format("No adapter at index {}", options.adapterIndex));
+            }
+
+            if (options.api == Api::D3D11) {
+                ComPtr<ID3D11Device> device;
+                const D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
+                CHECK_HRCMD(D3D11CreateDevice(get(adapter),
+                                              D3D_DRIVER_TYPE_UNKNOWN,
+                                              nullptr,
+                                              D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+                                              &featureLevel,
+                                              1,
+                                              D3D11_SDK_VERSION,
+                                              set(device),
+                                              nullptr,
+                                              set(m_context11)));
+                m_device = WrapD3D11Device(get(device), m_configManager);
+            } else {
+                ComPtr<ID3D12Device> device;
+                CHECK_HRCMD(D3D12CreateDevice(get(adapter), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(set(device))));
+                D3D12_COMMAND_QUEUE_DESC queueDesc{};
+                queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+                CHECK_HRCMD(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(set(m_queue))));
+                m_device = WrapD3D12Device(get(device), get(m_queue), m_configManager);
+
+                CHECK_HRCMD(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                           IID_PPV_ARGS(set(m_commandAllocator))));
+                CHECK_HRCMD(device->CreateCommandList(0,
+                                                      D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                      get(m_commandAllocator),
+                                                      nullptr,
+                                                      IID_PPV_ARGS(set(m_commandList))));
+            }
+
+            // The timers are reused across the passes, since the device can only create a limited number of them.
+            for (auto& timer : m_timers) {
+                timer = m_device->createTimer();
+            }
+
+            InputImage image;
+            if (options.inputFile.empty()) {
+                m_displayWidth = options.displayWidth;
+                m_displayHeight = options.displayHeight;
+                image = GenerateImage(utilities::GetScaledInputSize(m_displayWidth, options.scaling, 2),
+                                      utilities::GetScaledInputSize(m_displayHeight, options.scaling, 2));
+            } else {
+                image = LoadDDS(options.inputFile);
+
+                // The output resolution follows the resolution of the loaded image.
+                const auto [horizontalScaleFactor, verticalScaleFactor] = GetScalingFactors(options.scaling, -100);
+                m_displayWidth = roundUp((uint32_t)std::ceil(image.width * horizontalScaleFactor), 2);
+                m_displayHeight = roundUp((uint32_t)std::ceil(image.height * verticalScaleFactor), 2);
+            }
+            createTextures(image);
+        }
+
+        ~Benchmark() {
+            m_device->flushContext(true);
+            m_device->shutdown();
+        }
+
+        std::vector<PassResult> run() {
+            std::vector<PassResult> results;
+            for (const auto& pass : m_options.passes) {
+                std::cout << "Running " << pass << "..." << std::endl;
+                if (pass == "vrs") {
+                    results.push_back(runVariableRateShader());
+                } else if (pass == "postprocess") {
+                    results.push_back(runImageProcessor(
+                        pass, CreateImageProcessor(m_configManager, m_device, "Benchmark"), m_outputCopy));
+                } else {
+                    results.push_back(runImageProcessor(pass, createUpscaler(pass), m_input));
+                }
+            }
+            return results;
+        }
+
+        const std::string& getDeviceName() const {
+            return m_device->getDeviceName();
+        }
+
+      private:
+        void createTextures(const InputImage& image) {
+            XrSwapchainCreateInfo info{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+            info.arraySize = 1;
+            info.mipCount = 1;
+            info.faceCount = 1;
+            info.sampleCount = 1;
+            info.format = m_device->getTextureFormat(TextureFormat::R8G8B8A8_UNORM);
+
+            // Repack the rows to the pitch required by the device.
+            const uint32_t rowPitch = alignTo(image.width * 4, m_device->getTextureAlignmentConstraint());
+            std::vector<uint8_t> data((size_t)rowPitch * image.height);
+            for (uint32_t y = 0; y < image.height; y++) {
+                memcpy(data.data() + (size_t)y * rowPitch, &image.pixels[(size_t)y * image.width], image.width * 4);
+            }
+
+            info.width = image.width;
+            info.height = image.height;
+            info.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+            m_input = m_device->createTexture(
+                info, "Benchmark Input TEX2D", 0, rowPitch, (uint32_t)data.size(), data.data());
+
+            // The render target for the VRS, at the application resolution.
+            m_renderTarget = m_device->createTexture(info, "Benchmark Render Target TEX2D");
+
+            info.width = m_displayWidth;
+            info.height = m_displayHeight;
+            info.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT |
+                              XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT;
+            m_output = m_device->createTexture(info, "Benchmark Output TEX2D");
+
+            // The input of the post-processing is an upscaled image.
+            m_outputCopy = m_device->createTexture(info, "Benchmark Upscaled TEX2D");
+        }
+
+        std::shared_ptr<IImageProcessor> createUpscaler(const std::string& pass) {
+            if (pass == "nis") {
+                return CreateNISUpscaler(m_configManager, m_device, m_options.scaling, -100);
+            } else if (pass == "fsr") {
+                return CreateFSRUpscaler(m_configManager, m_device, m_options.scaling, -100);
+            } else if (pass == "cas") {
+                return CreateCASUpscaler(m_configManager, m_device, m_options.scaling, -100);
+            } else if (pass == "temporal") {
+                return CreateTemporalUpscaler(m_configManager, m_device, m_options.scaling, -100);
+            }
+            throw std::runtime_error("Unknown pass " + pass);
+        }
+
+        PassResult runImageProcessor(const std::string& name,
+                                     std::shared_ptr<IImageProcessor> processor,
+                                     std::shared_ptr<ITexture> input) {
+            PassResult result{name, getExtent(input), getExtent(m_output)};
+            if (!processor) {
+                result.skipReason = "not supported";
+                return result;
+            }
+
+            // The intermediate textures and constant buffers are owned by the caller, as with the swapchains.
+            std::vector<std::shared_ptr<ITexture>> textures;
+            std::vector<std::shared_ptr<IShaderBuffer>> buffers;
+            std::array<uint8_t, 1024> blob{};
+
+            for (uint32_t i = 0; i < m_options.warmupIterations + m_options.iterations; i++) {
+                processor->update();
+
+                m_device->saveContext();
+                startTimer();
+                processor->process(input, m_output, textures, buffers, blob, utilities::Eye::Left);
+                stopTimer(i >= m_options.warmupIterations ? &result : nullptr);
+                m_device->restoreContext();
+
+                endIteration();
+            }
+            drainTimers();
+
+            // Keep a copy of the upscaled image as the input of the post-processing.
+            m_output->copyTo(m_outputCopy);
+            m_device->flushContext(true);
+
+            return result;
+        }
+
+        PassResult runVariableRateShader() {
+            PassResult result{"vrs", getExtent(m_renderTarget), getExtent(m_renderTarget)};
+
+            NullOpenXrApi openXR;
+            const auto& info = m_renderTarget->getInfo();
+            auto variableRateShader = CreateVariableRateShader(openXR,
+                                                               m_configManager,
+                                                               m_device,
+                                                               nullptr,
+                                                               info.width,
+                                                               info.height,
+                                                               m_displayWidth,
+                                                               m_displayHeight,
+                                                               false /* hasVisibilityMask */,
+                                                               false /* needMirroredPattern */);
+            if (!variableRateShader) {
+                result.skipReason = "not supported";
+                return result;
+            }
+
+            const auto context = std::make_shared<BenchmarkContext>(
+                m_device,
+                m_device->getApi() == Api::D3D11 ? (void*)get(m_context11) : (void*)get(m_commandList));
+
+            for (uint32_t i = 0; i < m_options.warmupIterations + m_options.iterations; i++) {
+                // Alternate the rates, in order to force a full redraw of the masks at the next frame.
+                variableRateShader->setDynamicRateBias(i % 2);
+                variableRateShader->update();
+
+                // The masks are redrawn with the work of the previous frame, like in the layer.
+                variableRateShader->beginFrame(0);
+                m_device->saveContext();
+                startTimer();
+                variableRateShader->recordMasks(false);
+                stopTimer(i >= m_options.warmupIterations ? &result : nullptr);
+                m_device->restoreContext();
+
+                // Binding the render target keeps the mask alive (and requests its creation on the first frame).
+                variableRateShader->onSetRenderTarget(context, m_renderTarget, utilities::Eye::Left);
+                variableRateShader->onUnsetRenderTarget(context);
+                variableRateShader->endFrame();
+
+                if (m_commandList) {
+                    // The command list is never executed, it only receives the binding of the masks.
+                    CHECK_HRCMD(m_commandList->Close());
+                    CHECK_HRCMD(m_commandAllocator->Reset());
+                    CHECK_HRCMD(m_commandList->Reset(get(m_commandAllocator), nullptr));
+                }
+
+                endIteration();
+            }
+            drainTimers();
+
+            return result;
+        }
+
+        void startTimer() {
+            // Wait for a timer to become available.
+            while (m_numPendingTimers == m_timers.size()) {
+                m_device->flushContext(true, true);
+                pollTimers();
+            }
+            m_timers[(m_pendingTimersHead + m_numPendingTimers) % m_timers.size()]->start();
+        }
+
+        void stopTimer(PassResult* result) {
+            const size_t index = (m_pendingTimersHead + m_numPendingTimers) % m_timers.size();
+            m_timers[index]->stop();
+            m_pendingResults[index] = result;
+            m_numPendingTimers++;
+        }
+
+        void endIteration() {
+            m_device->flushContext(false, true);
+            pollTimers();
+        }
+
+        // The timers complete in order, so stop at the first one that is not ready.
+        void pollTimers() {
+            m_device->resolveQueries();
+            while (m_numPendingTimers && m_timers[m_pendingTimersHead]->isReady()) {
+                if (auto result = m_pendingResults[m_pendingTimersHead]) {
+                    result->samplesUs.push_back(m_timers[m_pendingTimersHead]->query());
+                }
+                m_pendingTimersHead = (m_pendingTimersHead + 1) % m_timers.size();
+                m_numPendingTimers--;
+            }
+        }
+
+        void drainTimers() {
+            for (int attempt = 0; m_numPendingTimers && attempt < 100; attempt++) {
+                m_device->flushContext(true, true);
+                pollTimers();
+            }
+            if (m_numPendingTimers) {
+                Log("%u timers did not complete\n", (uint32_t)m_numPendingTimers);
+                m_pendingTimersHead = (m_pendingTimersHead + m_numPendingTimers) % m_timers.size();
+                m_numPendingTimers = 0;
+            }
+        }
+
+        static XrExtent2Di getExtent(const std::shared_ptr<ITexture>& texture) {
+            return {(int32_t)texture->getInfo().width, (int32_t)texture->getInfo().height};
+        }
+
+        const BenchmarkOptions m_options;
+        std::shared_ptr<IConfigManager> m_configManager;
+        std::shared_ptr<IDevice> m_device;
+        uint32_t m_displayWidth;
+        uint32_t m_displayHeight;
+
+        ComPtr<ID3D11DeviceContext> m_context11;
+        ComPtr<ID3D12CommandQueue> m_queue;
+        ComPtr<ID3D12CommandAllocator> m_commandAllocator;
+        ComPtr<ID3D12GraphicsCommandList> m_commandList;
+
+        std::shared_ptr<ITexture> m_input;
+        std::shared_ptr<ITexture> m_output;
+        std::shared_ptr<ITexture> m_outputCopy;
+        std::shared_ptr<ITexture> m_renderTarget;
+
+        std::array<std::shared_ptr<IGpuTimer>, 8> m_timers;
+        std::array<PassResult*, 8> m_pendingResults{};
+        size_t m_pendingTimersHead{0};
+        size_t m_numPendingTimers{0};
+    };
+
+    struct Statistics {
+        uint64_t minUs;
+        uint64_t medianUs;
+        uint64_t p99Us;
+        double meanUs;
+    };
+
+    Statistics GetStatistics(std::vector<uint64_t> samplesUs) {
+        std::sort(samplesUs.begin(), samplesUs.end());
+        const size_t p99Index = (size_t)std::ceil(samplesUs.size() * 0.99) - 1;
+        return {samplesUs.front(),
+                samplesUs[samplesUs.size() / 2],
+                samplesUs[std::min(p99Index, samplesUs.size() - 1)],
+                std::accumulate(samplesUs.cbegin(), samplesUs.cend(), 0.0) / samplesUs.size()};
+    }
+
+    void PrintResults(const std::string& deviceName,
+                      const BenchmarkOptions& options,
+                      const std::vector<PassResult>& results) {
+        std::cout << fmt::format("\n{} ({})\n", deviceName, options.api == Api::D3D11 ? "D3D11" : "D3D12");
+        std::cout << fmt::format("{:<12} {:>11} {:>11} {:>9} {:>9} {:>9} {:>9}\n",
+                                 "Pass",
+                                 "Input",
+                                 "Output",
+                                 "Min",
+                                 "Median",
+                                 "P99",
+                                 "Mean");
+        for (const auto& result : results) {
+            const auto input = fmt::format("{}x{}", result.inputSize.width, result.inputSize.height);
+            const auto output = fmt::format("{}x{}", result.outputSize.width, result.outputSize.height);
+            if (result.samplesUs.empty()) {
+                std::cout << fmt::format("{:<12} {:>11} {:>11} ({})\n",
+                                         result.name,
+                                         input,
+                                         output,
+                                         !result.skipReason.empty() ? result.skipReason : "no measurement");
+                continue;
+            }
+
+            const auto stats = GetStatistics(result.samplesUs);
+            std::cout << fmt::format("{:<12} {:>11} {:>11} {:>7}us {:>7}us {:>7}us {:>7.1f}us\n",
+                                     result.name,
+                                     input,
+                                     output,
+                                     stats.minUs,
+                                     stats.medianUs,
+                                     stats.p99Us,
+                                     stats.meanUs);
+        }
+    }
+
+    void WriteJson(const std::filesystem::path& path,
+                   const std::string& deviceName,
+                   const BenchmarkOptions& options,
+                   const std::vector<PassResult>& results) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        // The device name is the only free-form string.
+        std::string escapedDeviceName;
+        for (const char c : deviceName) {
+            if (c == '"' || c == '\\') {
+                escapedDeviceName += '\\';
+            }
+            escapedDeviceName += c;
+        }
+
+        file << "{\n";
+        file << fmt::format("  \"version\": \"{}\",\n", VersionString);
+        file << fmt::format("  \"device\": \"{}\",\n", escapedDeviceName);
+        file << fmt::format("  \"api\": \"{}\",\n", options.api == Api::D3D11 ? "d3d11" : "d3d12");
+        file << fmt::format("  \"scaling\": {},\n", options.scaling);
+        file << fmt::format("  \"iterations\": {},\n", options.iterations);
+        file << "  \"passes\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& result = results[i];
+            file << (i ? ",\n" : "\n");
+            file << fmt::format("    {{\"name\": \"{}\", \"input\": [{}, {}], \"output\": [{}, {}]",
+                                result.name,
+                                result.inputSize.width,
+                                result.inputSize.height,
+                                result.outputSize.width,
+                                result.outputSize.height);
+            if (!result.samplesUs.empty()) {
+                const auto stats = GetStatistics(result.samplesUs);
+                file << fmt::format(", \"min_us\": {}, \"median_us\": {}, \"p99_us\": {}, \"mean_us\": {:.1f}",
+                                    stats.minUs,
+                                    stats.medianUs,
+                                    stats.p99Us,
+                                    stats.meanUs);
+            } else {
+                file << fmt::format(", \"skipped\": \"{}\"",
+                                    !result.skipReason.empty() ? result.skipReason : "no measurement");
+            }
+            file << "}";
+        }
+        file << "\n  ]\n}\n";
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // The layer normally does this when loaded (see DllMain() and xrNegotiateLoaderApiLayerInterface()).
+    TraceLoggingRegister(g_traceProvider);
+
+    char path[_MAX_PATH];
+    GetModuleFileNameA(nullptr, path, sizeof(path));
+    toolkit::dllHome = std::filesystem::path(path).parent_path();
+    toolkit::localAppData = std::filesystem::path(getenv("LOCALAPPDATA")) / toolkit::LayerPrettyName;
+    CreateDirectoryA(toolkit::localAppData.string().c_str(), nullptr);
+    CreateDirectoryA((toolkit::localAppData / "logs").string().c_str(), nullptr);
+    CreateDirectoryA((toolkit::localAppData / "cache").string().c_str(), nullptr);
+    toolkit::log::logStream.open((toolkit::localAppData / "logs" / "benchmark.log").string(), std::ios_base::ate);
+
+    if (argc > 1 && std::string(argv[1]) == "overhead") {
+        const int exitCode = toolkit::benchmark::RunOverheadBenchmark(argc - 1, argv + 1);
+        toolkit::log::FlushLog();
+        TraceLoggingUnregister(g_traceProvider);
+        return exitCode;
+    }
+
+    int exitCode = 0;
+    try {
+        const auto options = ParseOptions(argc, argv);
+
+        std::vector<PassResult> results;
+        std::string deviceName;
+        {
+            Benchmark benchmark(options);
+            deviceName = benchmark.getDeviceName();
+            results = benchmark.run();
+        }
+
+        PrintResults(deviceName, options, results);
+        if (!options.jsonFile.empty()) {
+            WriteJson(options.jsonFile, deviceName, options, results);
+        }
+    } catch (std::exception& exc) {
+        std::cerr << "Error: " << exc.what() << std::endl;
+        PrintUsage();
+        exitCode = 1;
+    }
+
+    toolkit::log::FlushLog();
+    TraceLoggingUnregister(g_traceProvider);
+
+    return exitCode;
+}
@@ -0,0 +1,833 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "log.h"
+#include "mockruntime.h"
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::benchmark;
+    using namespace toolkit::log;
+
+    const std::vector<DXGI_FORMAT> SupportedFormats = {DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+                                                       DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,
+                                                       DXGI_FORMAT_R8G8B8A8_UNORM,
+                                                       DXGI_FORMAT_B8G8R8A8_UNORM,
+                                                       DXGI_FORMAT_R16G16B16A16_FLOAT,
+                                                       DXGI_FORMAT_R10G10B10A2_UNORM,
+                                                       DXGI_FORMAT_D32_FLOAT,
+                                                       DXGI_FORMAT_D24_UNORM_S8_UINT,
+                                                       DXGI_FORMAT_D16_UNORM};
+
+    // Like the actual runtimes, the swapchain images are typeless so the application can pick the views it needs.
+    DXGI_FORMAT GetTypelessFormat(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+            return DXGI_FORMAT_R8G8B8A8_TYPELESS;
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+            return DXGI_FORMAT_B8G8R8A8_TYPELESS;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            return DXGI_FORMAT_R16G16B16A16_TYPELESS;
+        case DXGI_FORMAT_R10G10B10A2_UNORM:
+            return DXGI_FORMAT_R10G10B10A2_TYPELESS;
+        case DXGI_FORMAT_D32_FLOAT:
+            return DXGI_FORMAT_R32_TYPELESS;
+        case DXGI_FORMAT_D24_UNORM_S8_UINT:
+            return DXGI_FORMAT_R24G8_TYPELESS;
+        case DXGI_FORMAT_D16_UNORM:
+            return DXGI_FORMAT_R16_TYPELESS;
+        default:
+            return format;
+        }
+    }
+
+    struct Swapchain {
+        std::vector<ComPtr<ID3D11Texture2D>> images;
+        uint32_t nextImage{0};
+    };
+
+    struct Space {
+        bool isViewSpace{false};
+    };
+
+    class MockRuntime {
+      public:
+        void setOptions(const MockRuntimeOptions& options) {
+            m_options = options;
+        }
+
+        XrResult getInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+            const auto it = m_functions.find(name);
+            if (it == m_functions.cend() || (!m_options.supportsHandTracking && isHandTrackingFunction(name))) {
+                *function = nullptr;
+                return XR_ERROR_FUNCTION_UNSUPPORTED;
+            }
+            *function = it->second;
+            return XR_SUCCESS;
+        }
+
+        XrResult createInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instance) {
+            if (createInfo->type != XR_TYPE_INSTANCE_CREATE_INFO) {
+                return XR_ERROR_VALIDATION_FAILURE;
+            }
+
+            // The layer creates a dummy instance before the real one.
+            *instance = (XrInstance)++m_lastHandle;
+            m_numInstances++;
+            return XR_SUCCESS;
+        }
+
+        XrResult destroyInstance(XrInstance instance) {
+            if (m_numInstances && --m_numInstances == 0) {
+                m_swapchains.clear();
+                m_spaces.clear();
+                m_device = nullptr;
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult enumerateInstanceExtensionProperties(const char* layerName,
+                                                      uint32_t propertyCapacityInput,
+                                                      uint32_t* propertyCountOutput,
+                                                      XrExtensionProperties* properties) {
+            std::vector<const char*> extensions = {XR_KHR_D3D11_ENABLE_EXTENSION_NAME,
+                                                   XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME};
+            if (m_options.supportsHandTracking) {
+                extensions.push_back(XR_EXT_HAND_TRACKING_EXTENSION_NAME);
+            }
+
+            *propertyCountOutput = (uint32_t)extensions.size();
+            if (propertyCapacityInput) {
+                if (propertyCapacityInput < extensions.size()) {
+                    return XR_ERROR_SIZE_INSUFFICIENT;
+                }
+                for (uint32_t i = 0; i < extensions.size(); i++) {
+                    strcpy_s(properties[i].extensionName, extensions[i]);
+                    properties[i].extensionVersion = 1;
+                }
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult getInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties) {
+            strcpy_s(instanceProperties->runtimeName, "OpenXR-Toolkit Mock Runtime");
+            instanceProperties->runtimeVersion = XR_MAKE_VERSION(1, 0, 0);
+            return XR_SUCCESS;
+        }
+
+        XrResult getSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId) {
+            if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) {
+                return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+            }
+            *systemId = (XrSystemId)1;
+            return XR_SUCCESS;
+        }
+
+        XrResult getSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties) {
+            properties->systemId = systemId;
+            properties->vendorId = 0;
+            strcpy_s(properties->systemName, "Mock HMD");
+            properties->graphicsProperties.maxSwapchainImageWidth = 8192;
+            properties->graphicsProperties.maxSwapchainImageHeight = 8192;
+            properties->graphicsProperties.maxLayerCount = XR_MIN_COMPOSITION_LAYERS_SUPPORTED;
+            properties->trackingProperties.orientationTracking = XR_TRUE;
+            properties->trackingProperties.positionTracking = XR_TRUE;
+
+            auto entry = reinterpret_cast<XrBaseOutStructure*>(properties->next);
+            while (entry) {
+                if (entry->type == XR_TYPE_SYSTEM_HAND_TRACKING_PROPERTIES_EXT) {
+                    reinterpret_cast<XrSystemHandTrackingPropertiesEXT*>(entry)->supportsHandTracking =
+                        m_options.supportsHandTracking;
+                }
+                entry = entry->next;
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult enumerateViewConfigurationViews(XrInstance instance,
+                                                 XrSystemId systemId,
+                                                 XrViewConfigurationType viewConfigurationType,
+                                                 uint32_t viewCapacityInput,
+                                                 uint32_t* viewCountOutput,
+                                                 XrViewConfigurationView* views) {
+            if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+                return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+            }
+
+            *viewCountOutput = 2;
+            if (viewCapacityInput) {
+                if (viewCapacityInput < 2) {
+                    return XR_ERROR_SIZE_INSUFFICIENT;
+                }
+                for (uint32_t i = 0; i < 2; i++) {
+                    views[i].recommendedImageRectWidth = m_options.displayWidth;
+                    views[i].recommendedImageRectHeight = m_options.displayHeight;
+                    views[i].maxImageRectWidth = 8192;
+                    views[i].maxImageRectHeight = 8192;
+                    views[i].recommendedSwapchainSampleCount = 1;
+                    views[i].maxSwapchainSampleCount = 1;
+                }
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult enumerateSwapchainFormats(XrSession session,
+                                           uint32_t formatCapacityInput,
+                                           uint32_t* formatCountOutput,
+                                           int64_t* formats) {
+            *formatCountOutput = (uint32_t)SupportedFormats.size();
+            if (formatCapacityInput) {
+                if (formatCapacityInput < SupportedFormats.size()) {
+                    return XR_ERROR_SIZE_INSUFFICIENT;
+                }
+                for (uint32_t i = 0; i < SupportedFormats.size(); i++) {
+                    formats[i] = (int64_t)SupportedFormats[i];
+                }
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult getD3D11GraphicsRequirementsKHR(XrInstance instance,
+                                                 XrSystemId systemId,
+                                                 XrGraphicsRequirementsD3D11KHR* graphicsRequirements) {
+            graphicsRequirements->adapterLuid = {};
+            graphicsRequirements->minFeatureLevel = D3D_FEATURE_LEVEL_11_0;
+            return XR_SUCCESS;
+        }
+
+        XrResult createSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
+            auto entry = reinterpret_cast<const XrBaseInStructure*>(createInfo->next);
+            while (entry) {
+                if (entry->type == XR_TYPE_GRAPHICS_BINDING_D3D11_KHR) {
+                    m_device = reinterpret_cast<const XrGraphicsBindingD3D11KHR*>(entry)->device;
+                    break;
+                }
+                entry = entry->next;
+            }
+            if (!m_device) {
+                return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+            }
+
+            *session = (XrSession)++m_lastHandle;
+            return XR_SUCCESS;
+        }
+
+        XrResult destroySession(XrSession session) {
+            m_swapchains.clear();
+            m_device = nullptr;
+            return XR_SUCCESS;
+        }
+
+        XrResult createSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain) {
+            D3D11_TEXTURE2D_DESC desc{};
+            desc.Width = createInfo->width;
+            desc.Height = createInfo->height;
+            desc.MipLevels = createInfo->mipCount;
+            desc.ArraySize = createInfo->arraySize;
+            desc.Format = GetTypelessFormat((DXGI_FORMAT)createInfo->format);
+            desc.SampleDesc.Count = createInfo->sampleCount;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT) {
+                desc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+            }
+            if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+                desc.BindFlags |= D3D11_BIND_DEPTH_STENCIL;
+            }
+            if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_SAMPLED_BIT) {
+                desc.BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+            }
+            if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) {
+                desc.BindFlags |= D3D11_BIND_UNORDERED_ACCESS;
+            }
+
+            Swapchain entry;
+            for (uint32_t i = 0; i < 3; i++) {
+                ComPtr<ID3D11Texture2D> texture;
+                CHECK_HRCMD(m_device->CreateTexture2D(&desc, nullptr, set(texture)));
+                entry.images.push_back(texture);
+            }
+
+            *swapchain = (XrSwapchain)++m_lastHandle;
+            m_swapchains.insert_or_assign(*swapchain, std::move(entry));
+            return XR_SUCCESS;
+        }
+
+        XrResult destroySwapchain(XrSwapchain swapchain) {
+            return m_swapchains.erase(swapchain) ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+        }
+
+        XrResult enumerateSwapchainImages(XrSwapchain swapchain,
+                                          uint32_t imageCapacityInput,
+                                          uint32_t* imageCountOutput,
+                                          XrSwapchainImageBaseHeader* images) {
+            const auto it = m_swapchains.find(swapchain);
+            if (it == m_swapchains.end()) {
+                return XR_ERROR_HANDLE_INVALID;
+            }
+
+            *imageCountOutput = (uint32_t)it->second.images.size();
+            if (imageCapacityInput) {
+                if (imageCapacityInput < it->second.images.size()) {
+                    return XR_ERROR_SIZE_INSUFFICIENT;
+                }
+                auto d3dImages = reinterpret_cast<XrSwapchainImageD3D11KHR*>(images);
+                for (uint32_t i = 0; i < it->second.images.size(); i++) {
+                    d3dImages[i].texture = get(it->second.images[i]);
+                }
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult acquireSwapchainImage(XrSwapchain swapchain,
+                                       const XrSwapchainImageAcquireInfo* acquireInfo,
+                                       uint32_t* index) {
+            const auto it = m_swapchains.find(swapchain);
+            if (it == m_swapchains.end()) {
+                return XR_ERROR_HANDLE_INVALID;
+            }
+
+            *index = it->second.nextImage;
+            it->second.nextImage = (it->second.nextImage + 1) % it->second.images.size();
+            return XR_SUCCESS;
+        }
+
+        XrResult createReferenceSpace(XrSession session,
+                                      const XrReferenceSpaceCreateInfo* createInfo,
+                                      XrSpace* space) {
+            *space = (XrSpace)++m_lastHandle;
+            m_spaces.insert_or_assign(*space, Space{createInfo->referenceSpaceType == XR_REFERENCE_SPACE_TYPE_VIEW});
+            return XR_SUCCESS;
+        }
+
+        XrResult createActionSpace(XrSession session, const XrActionSpaceCreateInfo* createInfo, XrSpace* space) {
+            *space = (XrSpace)++m_lastHandle;
+            m_spaces.insert_or_assign(*space, Space{});
+            return XR_SUCCESS;
+        }
+
+        XrResult destroySpace(XrSpace space) {
+            m_spaces.erase(space);
+            return XR_SUCCESS;
+        }
+
+        XrResult locateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location) {
+            location->locationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+                                      XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT |
+                                      XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+            location->pose = xr::math::Pose::Identity();
+            return XR_SUCCESS;
+        }
+
+        XrResult locateViews(XrSession session,
+                             const XrViewLocateInfo* viewLocateInfo,
+                             XrViewState* viewState,
+                             uint32_t viewCapacityInput,
+                             uint32_t* viewCountOutput,
+                             XrView* views) {
+            *viewCountOutput = 2;
+            viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT |
+                                        XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+            if (viewCapacityInput) {
+                if (viewCapacityInput < 2) {
+                    return XR_ERROR_SIZE_INSUFFICIENT;
+                }
+                for (uint32_t i = 0; i < 2; i++) {
+                    views[i].pose = xr::math::Pose::Translation({i ? 0.032f : -0.032f, 0, 0});
+                    views[i].fov = {i ? -0.87f : -0.96f, i ? 0.96f : 0.87f, 0.92f, -0.98f};
+                }
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult stringToPath(XrInstance instance, const char* pathString, XrPath* path) {
+            const auto it = m_pathIds.find(pathString);
+            if (it != m_pathIds.cend()) {
+                *path = it->second;
+                return XR_SUCCESS;
+            }
+
+            m_paths.push_back(pathString);
+            *path = (XrPath)m_paths.size();
+            m_pathIds.insert_or_assign(pathString, *path);
+            return XR_SUCCESS;
+        }
+
+        XrResult pathToString(XrInstance instance,
+                              XrPath path,
+                              uint32_t bufferCapacityInput,
+                              uint32_t* bufferCountOutput,
+                              char* buffer) {
+            if (path == XR_NULL_PATH || path > m_paths.size()) {
+                return XR_ERROR_PATH_INVALID;
+            }
+
+            const auto& str = m_paths[(size_t)path - 1];
+            *bufferCountOutput = (uint32_t)str.size() + 1;
+            if (bufferCapacityInput) {
+                if (bufferCapacityInput < *bufferCountOutput) {
+                    return XR_ERROR_SIZE_INSUFFICIENT;
+                }
+                memcpy(buffer, str.c_str(), *bufferCountOutput);
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult createHandle(uint64_t* handle) {
+            *handle = ++m_lastHandle;
+            return XR_SUCCESS;
+        }
+
+        XrResult getCurrentInteractionProfile(XrSession session,
+                                              XrPath topLevelUserPath,
+                                              XrInteractionProfileState* interactionProfile) {
+            interactionProfile->interactionProfile = XR_NULL_PATH;
+            return XR_SUCCESS;
+        }
+
+        XrResult waitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState) {
+            // The frames are never throttled.
+            frameState->predictedDisplayPeriod = 11'111'111;
+            frameState->predictedDisplayTime = getTimeNow() + frameState->predictedDisplayPeriod;
+            frameState->shouldRender = XR_TRUE;
+            return XR_SUCCESS;
+        }
+
+        XrResult locateHandJointsEXT(XrHandTrackerEXT handTracker,
+                                     const XrHandJointsLocateInfoEXT* locateInfo,
+                                     XrHandJointLocationsEXT* locations) {
+            locations->isActive = XR_TRUE;
+            for (uint32_t i = 0; i < locations->jointCount; i++) {
+                locations->jointLocations[i].locationFlags =
+                    XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+                    XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+                locations->jointLocations[i].pose = xr::math::Pose::Translation({0, -0.3f, -0.3f - i * 0.01f});
+                locations->jointLocations[i].radius = 0.01f;
+            }
+            return XR_SUCCESS;
+        }
+
+        XrResult convertWin32PerformanceCounterToTimeKHR(XrInstance instance,
+                                                         const LARGE_INTEGER* performanceCounter,
+                                                         XrTime* time) {
+            *time = (XrTime)(performanceCounter->QuadPart * 1'000'000'000.0 / m_qpcFrequency.QuadPart);
+            return XR_SUCCESS;
+        }
+
+        XrResult convertTimeToWin32PerformanceCounterKHR(XrInstance instance,
+                                                         XrTime time,
+                                                         LARGE_INTEGER* performanceCounter) {
+            performanceCounter->QuadPart = (LONGLONG)(time * m_qpcFrequency.QuadPart / 1'000'000'000.0);
+            return XR_SUCCESS;
+        }
+
+        void registerFunction(const char* name, PFN_xrVoidFunction function) {
+            m_functions.insert_or_assign(name, function);
+        }
+
+      private:
+        static bool isHandTrackingFunction(const std::string& name) {
+            return name == "xrCreateHandTrackerEXT" || name == "xrDestroyHandTrackerEXT" ||
+                   name == "xrLocateHandJointsEXT";
+        }
+
+        XrTime getTimeNow() {
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            XrTime time;
+            convertWin32PerformanceCounterToTimeKHR(XR_NULL_HANDLE, &now, &time);
+            return time;
+        }
+
+        MockRuntimeOptions m_options;
+        std::unordered_map<std::string, PFN_xrVoidFunction> m_functions;
+        uint64_t m_lastHandle{0};
+        uint32_t m_numInstances{0};
+        LARGE_INTEGER m_qpcFrequency{[] {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            return frequency;
+        }()};
+
+        ComPtr<ID3D11Device> m_device;
+        std::unordered_map<XrSwapchain, Swapchain> m_swapchains;
+        std::unordered_map<XrSpace, Space> m_spaces;
+        std::vector<std::string> m_paths;
+        std::unordered_map<std::string, XrPath> m_pathIds;
+    };
+
+    MockRuntime g_runtime;
+
+    // The entry points handed out to the layer, forwarding to the runtime object. The functions that only need to
+    // succeed share the same implementation.
+
+    template <typename... Args>
+    XrResult XRAPI_CALL mockSucceed(Args...) {
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL mockPollEvent(XrInstance instance, XrEventDataBuffer* eventData) {
+        return XR_EVENT_UNAVAILABLE;
+    }
+
+    XrResult XRAPI_CALL mockGetActionStateBoolean(XrSession session,
+                                                   const XrActionStateGetInfo* getInfo,
+                                                   XrActionStateBoolean* state) {
+        state->isActive = XR_TRUE;
+        state->currentState = XR_FALSE;
+        state->changedSinceLastSync = XR_FALSE;
+        state->lastChangeTime = 0;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL mockGetActionStateFloat(XrSession session,
+                                                 const XrActionStateGetInfo* getInfo,
+                                                 XrActionStateFloat* state) {
+        state->isActive = XR_TRUE;
+        state->currentState = 0.f;
+        state->changedSinceLastSync = XR_FALSE;
+        state->lastChangeTime = 0;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL mockGetActionStateVector2f(XrSession session,
+                                                    const XrActionStateGetInfo* getInfo,
+                                                    XrActionStateVector2f* state) {
+        state->isActive = XR_TRUE;
+        state->currentState = {0.f, 0.f};
+        state->changedSinceLastSync = XR_FALSE;
+        state->lastChangeTime = 0;
+        return XR_SUCCESS;
+    }
+
+    XrResult XRAPI_CALL mockGetActionStatePose(XrSession session,
+                                                const XrActionStateGetInfo* getInfo,
+                                                XrActionStatePose* state) {
+        state->isActive = XR_TRUE;
+        return XR_SUCCESS;
+    }
+
+    void RegisterFunctions() {
+        const auto registerFunction = [](const char* name, auto function) {
+            g_runtime.registerFunction(name, reinterpret_cast<PFN_xrVoidFunction>(function));
+        };
+
+        registerFunction("xrGetInstanceProcAddr", &MockGetInstanceProcAddr);
+        registerFunction("xrDestroyInstance",
+                         static_cast<PFN_xrDestroyInstance>([](XrInstance instance) -> XrResult {
+                             return g_runtime.destroyInstance(instance);
+                         }));
+        registerFunction("xrEnumerateInstanceExtensionProperties",
+                         static_cast<PFN_xrEnumerateInstanceExtensionProperties>(
+                             [](const char* layerName, uint32_t capacity, uint32_t* count, XrExtensionProperties* p)
+                                 -> XrResult {
+                                 return g_runtime.enumerateInstanceExtensionProperties(layerName, capacity, count, p);
+                             }));
+        registerFunction("xrEnumerateApiLayerProperties",
+                         static_cast<PFN_xrEnumerateApiLayerProperties>(
+                             [](uint32_t capacity, uint32_t* count, XrApiLayerProperties* properties) -> XrResult {
+                                 *count = 0;
+                                 return XR_SUCCESS;
+                             }));
+        registerFunction("xrGetInstanceProperties",
+                         static_cast<PFN_xrGetInstanceProperties>(
+                             [](XrInstance instance, XrInstanceProperties* properties) -> XrResult {
+                                 return g_runtime.getInstanceProperties(instance, properties);
+                             }));
+        registerFunction("xrPollEvent", static_cast<PFN_xrPollEvent>(&mockPollEvent));
+        registerFunction("xrResultToString",
+                         static_cast<PFN_xrResultToString>(
+                             [](XrInstance instance, XrResult value, char buffer[]) -> XrResult {
+                                 sprintf_s(buffer, XR_MAX_RESULT_STRING_SIZE, "XrResult(%d)", value);
+                                 return XR_SUCCESS;
+                             }));
+        registerFunction("xrStructureTypeToString",
+                         static_cast<PFN_xrStructureTypeToString>(
+                             [](XrInstance instance, XrStructureType value, char buffer[]) -> XrResult {
+                                 sprintf_s(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "XrStructureType(%d)", value);
+                                 return XR_SUCCESS;
+                             }));
+        registerFunction("xrGetSystem",
+                         static_cast<PFN_xrGetSystem>(
+                             [](XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId) -> XrResult {
+                                 return g_runtime.getSystem(instance, getInfo, systemId);
+                             }));
+        registerFunction("xrGetSystemProperties",
+                         static_cast<PFN_xrGetSystemProperties>(
+                             [](XrInstance instance, XrSystemId systemId, XrSystemProperties* properties) -> XrResult {
+                                 return g_runtime.getSystemProperties(instance, systemId, properties);
+                             }));
+        registerFunction("xrEnumerateEnvironmentBlendModes",
+                         static_cast<PFN_xrEnumerateEnvironmentBlendModes>(
+                             [](XrInstance instance,
+                                XrSystemId systemId,
+                                XrViewConfigurationType viewConfigurationType,
+                                uint32_t capacity,
+                                uint32_t* count,
+                                XrEnvironmentBlendMode* modes) -> XrResult {
+                                 *count = 1;
+                                 if (capacity) {
+                                     modes[0] = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+                                 }
+                                 return XR_SUCCESS;
+                             }));
+        registerFunction("xrEnumerateViewConfigurations",
+                         static_cast<PFN_xrEnumerateViewConfigurations>(
+                             [](XrInstance instance,
+                                XrSystemId systemId,
+                                uint32_t capacity,
+                                uint32_t* count,
+                                XrViewConfigurationType* types) -> XrResult {
+                                 *count = 1;
+                                 if (capacity) {
+                                     types[0] = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+                                 }
+                                 return XR_SUCCESS;
+                             }));
+        registerFunction("xrEnumerateViewConfigurationViews",
+                         static_cast<PFN_xrEnumerateViewConfigurationViews>(
+                             [](XrInstance instance,
+                                XrSystemId systemId,
+                                XrViewConfigurationType viewConfigurationType,
+                                uint32_t capacity,
+                                uint32_t* count,
+                                XrViewConfigurationView* views) -> XrResult {
+                                 return g_runtime.enumerateViewConfigurationViews(
+                                     instance, systemId, viewConfigurationType, capacity, count, views);
+                             }));
+        registerFunction("xrGetD3D11GraphicsRequirementsKHR",
+                         static_cast<PFN_xrGetD3D11GraphicsRequirementsKHR>(
+                             [](XrInstance instance, XrSystemId systemId, XrGraphicsRequirementsD3D11KHR* requirements)
+                                 -> XrResult {
+                                 return g_runtime.getD3D11GraphicsRequirementsKHR(instance, systemId, requirements);
+                             }));
+        registerFunction("xrConvertWin32PerformanceCounterToTimeKHR",
+                         static_cast<PFN_xrConvertWin32PerformanceCounterToTimeKHR>(
+                             [](XrInstance instance, const LARGE_INTEGER* performanceCounter, XrTime* time)
+                                 -> XrResult {
+                                 return g_runtime.convertWin32PerformanceCounterToTimeKHR(
+                                     instance, performanceCounter, time);
+                             }));
+        registerFunction("xrConvertTimeToWin32PerformanceCounterKHR",
+                         static_cast<PFN_xrConvertTimeToWin32PerformanceCounterKHR>(
+                             [](XrInstance instance, XrTime time, LARGE_INTEGER* performanceCounter) -> XrResult {
+                                 return g_runtime.convertTimeToWin32PerformanceCounterKHR(
+                                     instance, time, performanceCounter);
+                             }));
+
+        // Session and frame loop.
+        registerFunction("xrCreateSession",
+                         static_cast<PFN_xrCreateSession>(
+                             [](XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session)
+                                 -> XrResult { return g_runtime.createSession(instance, createInfo, session); }));
+        registerFunction("xrDestroySession",
+                         static_cast<PFN_xrDestroySession>(
+                             [](XrSession session) -> XrResult { return g_runtime.destroySession(session); }));
+        registerFunction("xrBeginSession",
+                         static_cast<PFN_xrBeginSession>(&mockSucceed<XrSession, const XrSessionBeginInfo*>));
+        registerFunction("xrEndSession", static_cast<PFN_xrEndSession>(&mockSucceed<XrSession>));
+        registerFunction("xrRequestExitSession", static_cast<PFN_xrRequestExitSession>(&mockSucceed<XrSession>));
+        registerFunction(
+            "xrWaitFrame",
+            static_cast<PFN_xrWaitFrame>(
+                [](XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState) -> XrResult {
+                    return g_runtime.waitFrame(session, frameWaitInfo, frameState);
+                }));
+        registerFunction("xrBeginFrame",
+                         static_cast<PFN_xrBeginFrame>(&mockSucceed<XrSession, const XrFrameBeginInfo*>));
+        registerFunction("xrEndFrame", static_cast<PFN_xrEndFrame>(&mockSucceed<XrSession, const XrFrameEndInfo*>));
+        registerFunction("xrLocateViews",
+                         static_cast<PFN_xrLocateViews>([](XrSession session,
+                                                           const XrViewLocateInfo* viewLocateInfo,
+                                                           XrViewState* viewState,
+                                                           uint32_t capacity,
+                                                           uint32_t* count,
+                                                           XrView* views) -> XrResult {
+                             return g_runtime.locateViews(session, viewLocateInfo, viewState, capacity, count, views);
+                         }));
+
+        // Swapchains.
+        registerFunction(
+            "xrEnumerateSwapchainFormats",
+            static_cast<PFN_xrEnumerateSwapchainFormats>(
+                [](XrSession session, uint32_t capacity, uint32_t* count, int64_t* formats) -> XrResult {
+                    return g_runtime.enumerateSwapchainFormats(session, capacity, count, formats);
+                }));
+        registerFunction(
+            "xrCreateSwapchain",
+            static_cast<PFN_xrCreateSwapchain>(
+                [](XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain) -> XrResult {
+                    return g_runtime.createSwapchain(session, createInfo, swapchain);
+                }));
+        registerFunction("xrDestroySwapchain",
+                         static_cast<PFN_xrDestroySwapchain>(
+                             [](XrSwapchain swapchain) -> XrResult { return g_runtime.destroySwapchain(swapchain); }));
+        registerFunction(
+            "xrEnumerateSwapchainImages",
+            static_cast<PFN_xrEnumerateSwapchainImages>(
+                [](XrSwapchain swapchain, uint32_t capacity, uint32_t* count, XrSwapchainImageBaseHeader* images)
+                    -> XrResult { return g_runtime.enumerateSwapchainImages(swapchain, capacity, count, images); }));
+        registerFunction(
+            "xrAcquireSwapchainImage",
+            static_cast<PFN_xrAcquireSwapchainImage>(
+                [](XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index)
+                    -> XrResult { return g_runtime.acquireSwapchainImage(swapchain, acquireInfo, index); }));
+        registerFunction(
+            "xrWaitSwapchainImage",
+            static_cast<PFN_xrWaitSwapchainImage>(&mockSucceed<XrSwapchain, const XrSwapchainImageWaitInfo*>));
+        registerFunction(
+            "xrReleaseSwapchainImage",
+            static_cast<PFN_xrReleaseSwapchainImage>(&mockSucceed<XrSwapchain, const XrSwapchainImageReleaseInfo*>));
+
+        // Spaces.
+        registerFunction("xrEnumerateReferenceSpaces",
+                         static_cast<PFN_xrEnumerateReferenceSpaces>(
+                             [](XrSession session, uint32_t capacity, uint32_t* count, XrReferenceSpaceType* spaces)
+                                 -> XrResult {
+                                 const XrReferenceSpaceType types[] = {XR_REFERENCE_SPACE_TYPE_VIEW,
+                                                                       XR_REFERENCE_SPACE_TYPE_LOCAL,
+                                                                       XR_REFERENCE_SPACE_TYPE_STAGE};
+                                 *count = (uint32_t)std::size(types);
+                                 if (capacity) {
+                                     std::copy_n(types, std::min(capacity, *count), spaces);
+                                 }
+                                 return XR_SUCCESS;
+                             }));
+        registerFunction(
+            "xrCreateReferenceSpace",
+            static_cast<PFN_xrCreateReferenceSpace>(
+                [](XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space) -> XrResult {
+                    return g_runtime.createReferenceSpace(session, createInfo, space);
+                }));
+        registerFunction(
+            "xrCreateActionSpace",
+            static_cast<PFN_xrCreateActionSpace>(
+                [](XrSession session, const XrActionSpaceCreateInfo* createInfo, XrSpace* space) -> XrResult {
+                    return g_runtime.createActionSpace(session, createInfo, space);
+                }));
+        registerFunction("xrDestroySpace",
+                         static_cast<PFN_xrDestroySpace>(
+                             [](XrSpace space) -> XrResult { return g_runtime.destroySpace(space); }));
+        registerFunction(
+            "xrLocateSpace",
+            static_cast<PFN_xrLocateSpace>(
+                [](XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location) -> XrResult {
+                    return g_runtime.locateSpace(space, baseSpace, time, location);
+                }));
+
+        // Paths and actions.
+        registerFunction("xrStringToPath",
+                         static_cast<PFN_xrStringToPath>(
+                             [](XrInstance instance, const char* pathString, XrPath* path) -> XrResult {
+                                 return g_runtime.stringToPath(instance, pathString, path);
+                             }));
+        registerFunction(
+            "xrPathToString",
+            static_cast<PFN_xrPathToString>(
+                [](XrInstance instance, XrPath path, uint32_t capacity, uint32_t* count, char* buffer) -> XrResult {
+                    return g_runtime.pathToString(instance, path, capacity, count, buffer);
+                }));
+        registerFunction("xrCreateActionSet",
+                         static_cast<PFN_xrCreateActionSet>(
+                             [](XrInstance instance, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSet)
+                                 -> XrResult {
+                                 return g_runtime.createHandle(reinterpret_cast<uint64_t*>(actionSet));
+                             }));
+        registerFunction("xrDestroyActionSet", static_cast<PFN_xrDestroyActionSet>(&mockSucceed<XrActionSet>));
+        registerFunction(
+            "xrCreateAction",
+            static_cast<PFN_xrCreateAction>(
+                [](XrActionSet actionSet, const XrActionCreateInfo* createInfo, XrAction* action) -> XrResult {
+                    return g_runtime.createHandle(reinterpret_cast<uint64_t*>(action));
+                }));
+        registerFunction("xrDestroyAction", static_cast<PFN_xrDestroyAction>(&mockSucceed<XrAction>));
+        registerFunction("xrSuggestInteractionProfileBindings",
+                         static_cast<PFN_xrSuggestInteractionProfileBindings>(
+                             &mockSucceed<XrInstance, const XrInteractionProfileSuggestedBinding*>));
+        registerFunction(
+            "xrAttachSessionActionSets",
+            static_cast<PFN_xrAttachSessionActionSets>(&mockSucceed<XrSession, const XrSessionActionSetsAttachInfo*>));
+        registerFunction("xrGetCurrentInteractionProfile",
+                         static_cast<PFN_xrGetCurrentInteractionProfile>(
+                             [](XrSession session, XrPath topLevelUserPath, XrInteractionProfileState* state)
+                                 -> XrResult {
+                                 return g_runtime.getCurrentInteractionProfile(session, topLevelUserPath, state);
+                             }));
+        registerFunction("xrSyncActions",
+                         static_cast<PFN_xrSyncActions>(&mockSucceed<XrSession, const XrActionsSyncInfo*>));
+        registerFunction("xrGetActionStateBoolean",
+                         static_cast<PFN_xrGetActionStateBoolean>(&mockGetActionStateBoolean));
+        registerFunction("xrGetActionStateFloat", static_cast<PFN_xrGetActionStateFloat>(&mockGetActionStateFloat));
+        registerFunction("xrGetActionStateVector2f",
+                         static_cast<PFN_xrGetActionStateVector2f>(&mockGetActionStateVector2f));
+        registerFunction("xrGetActionStatePose", static_cast<PFN_xrGetActionStatePose>(&mockGetActionStatePose));
+        registerFunction("xrApplyHapticFeedback",
+                         static_cast<PFN_xrApplyHapticFeedback>(
+                             &mockSucceed<XrSession, const XrHapticActionInfo*, const XrHapticBaseHeader*>));
+        registerFunction("xrStopHapticFeedback",
+                         static_cast<PFN_xrStopHapticFeedback>(&mockSucceed<XrSession, const XrHapticActionInfo*>));
+
+        // Hand tracking.
+        registerFunction("xrCreateHandTrackerEXT",
+                         static_cast<PFN_xrCreateHandTrackerEXT>([](XrSession session,
+                                                                    const XrHandTrackerCreateInfoEXT* createInfo,
+                                                                    XrHandTrackerEXT* handTracker) -> XrResult {
+                             return g_runtime.createHandle(reinterpret_cast<uint64_t*>(handTracker));
+                         }));
+        registerFunction("xrDestroyHandTrackerEXT",
+                         static_cast<PFN_xrDestroyHandTrackerEXT>(&mockSucceed<XrHandTrackerEXT>));
+        registerFunction("xrLocateHandJointsEXT",
+                         static_cast<PFN_xrLocateHandJointsEXT>([](XrHandTrackerEXT handTracker,
+                                                                   const XrHandJointsLocateInfoEXT* locateInfo,
+                                                                   XrHandJointLocationsEXT* locations) -> XrResult {
+                             return g_runtime.locateHandJointsEXT(handTracker, locateInfo, locations);
+                         }));
+    }
+
+} // namespace
+
+namespace toolkit::benchmark {
+
+    void SetMockRuntimeOptions(const MockRuntimeOptions& options) {
+        g_runtime.setOptions(options);
+    }
+
+    XrResult XRAPI_CALL MockGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+        static std::once_flag registered;
+        std::call_once(registered, RegisterFunctions);
+
+        return g_runtime.getInstanceProcAddr(instance, name, function);
+    }
+
+    XrResult XRAPI_CALL MockCreateApiLayerInstance(const XrInstanceCreateInfo* createInfo,
+                                                   const XrApiLayerCreateInfo* apiLayerInfo,
+                                                   XrInstance* instance) {
+        // This is the end of the chain, there is no other layer to call.
+        return g_runtime.createInstance(createInfo, instance);
+    }
+
+} // namespace toolkit::benchmark
@@ -0,0 +1,43 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+namespace toolkit::benchmark {
+
+    struct MockRuntimeOptions {
+        uint32_t displayWidth{2064};
+        uint32_t displayHeight{2208};
+        bool supportsHandTracking{false};
+    };
+
+    // A minimal OpenXR runtime living in the process, to be placed at the end of an API layer chain. It implements
+    // just enough of the D3D11 path for the layer to run its frame loop, and does no work of its own. Only one instance
+    // may exist at a time.
+    void SetMockRuntimeOptions(const MockRuntimeOptions& options);
+    XrResult XRAPI_CALL MockGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
+    XrResult XRAPI_CALL MockCreateApiLayerInstance(const XrInstanceCreateInfo* createInfo,
+                                                   const XrApiLayerCreateInfo* apiLayerInfo,
+                                                   XrInstance* instance);
+
+} // namespace toolkit::benchmark
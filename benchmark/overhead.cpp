@@ -0,0 +1,809 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "factories.h"
+#include "interfaces.h"
+#include "layer.h"
+#include "log.h"
+#include "mockruntime.h"
+#include "overhead.h"
+
+// The layer's entry point for the loader (see framework/entry.cpp).
+extern "C" XrResult XRAPI_CALL xrNegotiateLoaderApiLayerInterface(const XrNegotiateLoaderInfo* const loaderInfo,
+                                                                  const char* const apiLayerName,
+                                                                  XrNegotiateApiLayerRequest* const apiLayerRequest);
+
+// A benchmark of the CPU overhead of the layer. The layer is loaded in-process on top of a mock runtime that does no
+// work, and a scripted application frame loop is timed call by call. The calls that are too fast for the resolution of
+// the clock are timed in batches, and reported as the average per call of each batch.
+
+namespace {
+
+    using namespace toolkit;
+    using namespace toolkit::benchmark;
+    using namespace toolkit::config;
+    using namespace toolkit::log;
+
+    const std::string AppName = LayerPrettyName + "-Overhead";
+
+    constexpr uint32_t NumActionStateCalls = 50;
+    constexpr uint32_t NumLocateSpaceCalls = 20;
+    constexpr uint32_t NumRenderTargetBinds = 8;
+    constexpr uint32_t MaxProjectionLayers = 4;
+
+    // The layer's features to measure, enabled through the registry like the menu would.
+    struct Combination {
+        std::string name;
+        bool useLayer;
+        bool supportsHandTracking;
+        std::vector<std::pair<Setting, int>> settings;
+    };
+
+    const std::vector<Combination> AllCombinations = {
+        {"runtime", false, false, {}},
+        {"layer", true, false, {}},
+        {"locate_cache", true, false, {{SettingLocateSpaceCache, 1}}},
+        {"hand_tracking", true, true, {{SettingHandTrackingEnabled, (int)HandTrackingEnabled::Both}}},
+        {"upscaling", true, false, {{SettingScalingType, (int)ScalingType::FSR}, {SettingScaling, 130}}},
+        {"vrs", true, false, {{SettingVRS, (int)VariableShadingRateType::Preset}}},
+        {"all",
+         true,
+         true,
+         {{SettingLocateSpaceCache, 1},
+          {SettingHandTrackingEnabled, (int)HandTrackingEnabled::Both},
+          {SettingScalingType, (int)ScalingType::FSR},
+          {SettingScaling, 130},
+          {SettingVRS, (int)VariableShadingRateType::Preset}}},
+    };
+
+    struct OverheadOptions {
+        D3D_DRIVER_TYPE driverType{D3D_DRIVER_TYPE_NULL};
+        uint32_t frames{1000};
+        uint32_t warmupFrames{100};
+        std::vector<uint32_t> layerCounts{1, 2, 4};
+        std::vector<Combination> combinations{AllCombinations};
+        std::filesystem::path jsonFile;
+    };
+
+    struct CallResult {
+        std::string name;
+        uint32_t callsPerFrame;
+        std::vector<uint64_t> samplesNs;
+    };
+
+    struct RunResult {
+        std::string combination;
+        uint32_t projectionLayers;
+        std::vector<CallResult> calls;
+    };
+
+    void PrintUsage() {
+        std::cout << "Usage: benchmark overhead [options]\n"
+                     "  --driver null|warp|hardware  D3D11 driver for the application (default null)\n"
+                     "  --frames N                   Number of measured frames per run (default 1000)\n"
+                     "  --warmup N                   Number of frames before measuring (default 100)\n"
+                     "  --layers a,b,...             Numbers of projection layers (1 to 4) to submit (default 1,2,4)\n"
+                     "  --combinations a,b,...       Features to measure among runtime,layer,locate_cache,\n"
+                     "                               hand_tracking,upscaling,vrs,all (default all of them)\n"
+                     "  --json FILE                  Also write the results to a JSON file\n";
+    }
+
+    std::vector<std::string> SplitList(const std::string& list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            items.push_back(item);
+        }
+        return items;
+    }
+
+    OverheadOptions ParseOptions(int argc, char** argv) {
+        OverheadOptions options;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                PrintUsage();
+                exit(0);
+            }
+            if (i + 1 >= argc) {
+                throw std::runtime_error("Missing value for option " + arg);
+            }
+            const std::string value = argv[++i];
+
+            if (arg == "--driver") {
+                if (value == "null") {
+                    options.driverType = D3D_DRIVER_TYPE_NULL;
+                } else if (value == "warp") {
+                    options.driverType = D3D_DRIVER_TYPE_WARP;
+                } else if (value == "hardware") {
+                    options.driverType = D3D_DRIVER_TYPE_HARDWARE;
+                } else {
+                    throw std::runtime_error("Unknown driver " + value);
+                }
+            } else if (arg == "--frames") {
+                options.frames = std::max(1ul, std::stoul(value));
+            } else if (arg == "--warmup") {
+                options.warmupFrames = std::stoul(value);
+            } else if (arg == "--layers") {
+                options.layerCounts.clear();
+                for (const auto& item : SplitList(value)) {
+                    const uint32_t count = std::stoul(item);
+                    if (count < 1 || count > MaxProjectionLayers) {
+                        throw std::runtime_error("Invalid number of projection layers " + item);
+                    }
+                    options.layerCounts.push_back(count);
+                }
+            } else if (arg == "--combinations") {
+                options.combinations.clear();
+                for (const auto& item : SplitList(value)) {
+                    const auto it =
+                        std::find_if(AllCombinations.cbegin(), AllCombinations.cend(), [&](const Combination& entry) {
+                            return entry.name == item;
+                        });
+                    if (it == AllCombinations.cend()) {
+                        throw std::runtime_error("Unknown combination " + item);
+                    }
+                    options.combinations.push_back(*it);
+                }
+            } else if (arg == "--json") {
+                options.jsonFile = value;
+            } else {
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+        return options;
+    }
+
+    // The entry points used by the application, resolved either through the layer or directly from the runtime.
+    struct Dispatch {
+        PFN_xrGetInstanceProcAddr xrGetInstanceProcAddr;
+        PFN_xrDestroyInstance xrDestroyInstance;
+        PFN_xrGetSystem xrGetSystem;
+        PFN_xrEnumerateViewConfigurationViews xrEnumerateViewConfigurationViews;
+        PFN_xrCreateSession xrCreateSession;
+        PFN_xrBeginSession xrBeginSession;
+        PFN_xrEndSession xrEndSession;
+        PFN_xrDestroySession xrDestroySession;
+        PFN_xrEnumerateSwapchainFormats xrEnumerateSwapchainFormats;
+        PFN_xrCreateSwapchain xrCreateSwapchain;
+        PFN_xrDestroySwapchain xrDestroySwapchain;
+        PFN_xrEnumerateSwapchainImages xrEnumerateSwapchainImages;
+        PFN_xrAcquireSwapchainImage xrAcquireSwapchainImage;
+        PFN_xrWaitSwapchainImage xrWaitSwapchainImage;
+        PFN_xrReleaseSwapchainImage xrReleaseSwapchainImage;
+        PFN_xrCreateReferenceSpace xrCreateReferenceSpace;
+        PFN_xrCreateActionSpace xrCreateActionSpace;
+        PFN_xrDestroySpace xrDestroySpace;
+        PFN_xrLocateSpace xrLocateSpace;
+        PFN_xrLocateViews xrLocateViews;
+        PFN_xrStringToPath xrStringToPath;
+        PFN_xrCreateActionSet xrCreateActionSet;
+        PFN_xrDestroyActionSet xrDestroyActionSet;
+        PFN_xrCreateAction xrCreateAction;
+        PFN_xrSuggestInteractionProfileBindings xrSuggestInteractionProfileBindings;
+        PFN_xrAttachSessionActionSets xrAttachSessionActionSets;
+        PFN_xrSyncActions xrSyncActions;
+        PFN_xrGetActionStateBoolean xrGetActionStateBoolean;
+        PFN_xrGetActionStateFloat xrGetActionStateFloat;
+        PFN_xrPollEvent xrPollEvent;
+        PFN_xrWaitFrame xrWaitFrame;
+        PFN_xrBeginFrame xrBeginFrame;
+        PFN_xrEndFrame xrEndFrame;
+    };
+
+    struct ProjectionLayerSwapchain {
+        XrSwapchain swapchain{XR_NULL_HANDLE};
+        std::vector<ComPtr<ID3D11RenderTargetView>> renderTargetViews;
+    };
+
+    class OverheadBenchmark {
+      public:
+        OverheadBenchmark(const OverheadOptions& options, const Combination& combination, uint32_t projectionLayers)
+            : m_options(options), m_combination(combination), m_projectionLayers(projectionLayers) {
+            m_result.combination = combination.name;
+            m_result.projectionLayers = projectionLayers;
+        }
+
+        RunResult run() {
+            applySettings();
+            createDevice();
+            createInstance();
+            createSession();
+
+            for (uint32_t i = 0; i < m_options.warmupFrames + m_options.frames; i++) {
+                runFrame(i >= m_options.warmupFrames);
+            }
+
+            destroySession();
+            CHECK_XRCMD(m_xr.xrDestroyInstance(m_instance));
+            m_instance = XR_NULL_HANDLE;
+
+            utilities::RegDeleteKey(HKEY_CURRENT_USER, xr::utf8_to_wide(RegPrefix + "\\" + AppName));
+
+            return m_result;
+        }
+
+      private:
+        void applySettings() {
+            const auto baseKey = xr::utf8_to_wide(RegPrefix + "\\" + AppName);
+            utilities::RegDeleteKey(HKEY_CURRENT_USER, baseKey);
+            for (const auto& [setting, value] : m_combination.settings) {
+                utilities::RegSetDword(HKEY_CURRENT_USER, baseKey, xr::utf8_to_wide(setting.name), value);
+            }
+
+            MockRuntimeOptions runtimeOptions;
+            runtimeOptions.supportsHandTracking = m_combination.supportsHandTracking;
+            SetMockRuntimeOptions(runtimeOptions);
+        }
+
+        void createDevice() {
+            const D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
+            CHECK_HRCMD(D3D11CreateDevice(nullptr,
+                                          m_options.driverType,
+                                          nullptr,
+                                          D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+                                          &featureLevel,
+                                          1,
+                                          D3D11_SDK_VERSION,
+                                          set(m_device),
+                                          nullptr,
+                                          set(m_context)));
+        }
+
+        void createInstance() {
+            XrInstanceCreateInfo createInfo{XR_TYPE_INSTANCE_CREATE_INFO};
+            strcpy_s(createInfo.applicationInfo.applicationName, AppName.c_str());
+            strcpy_s(createInfo.applicationInfo.engineName, "Benchmark");
+            createInfo.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+            const char* extensions[] = {XR_KHR_D3D11_ENABLE_EXTENSION_NAME};
+            createInfo.enabledExtensionCount = (uint32_t)std::size(extensions);
+            createInfo.enabledExtensionNames = extensions;
+
+            if (m_combination.useLayer) {
+                // Do what the loader does: negotiate with the layer, then create the instance through the chain.
+                XrNegotiateLoaderInfo loaderInfo{};
+                loaderInfo.structType = XR_LOADER_INTERFACE_STRUCT_LOADER_INFO;
+                loaderInfo.structVersion = XR_LOADER_INFO_STRUCT_VERSION;
+                loaderInfo.structSize = sizeof(XrNegotiateLoaderInfo);
+                loaderInfo.minInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+                loaderInfo.maxInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+                loaderInfo.minApiVersion = XR_MAKE_VERSION(1, 0, 0);
+                loaderInfo.maxApiVersion = XR_CURRENT_API_VERSION;
+
+                XrNegotiateApiLayerRequest layerRequest{};
+                layerRequest.structType = XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST;
+                layerRequest.structVersion = XR_API_LAYER_INFO_STRUCT_VERSION;
+                layerRequest.structSize = sizeof(XrNegotiateApiLayerRequest);
+                CHECK_XRCMD(xrNegotiateLoaderApiLayerInterface(&loaderInfo, LayerName.c_str(), &layerRequest));
+
+                XrApiLayerNextInfo nextInfo{};
+                nextInfo.structType = XR_LOADER_INTERFACE_STRUCT_API_LAYER_NEXT_INFO;
+                nextInfo.structVersion = XR_API_LAYER_NEXT_INFO_STRUCT_VERSION;
+                nextInfo.structSize = sizeof(XrApiLayerNextInfo);
+                strcpy_s(nextInfo.layerName, LayerName.c_str());
+                nextInfo.nextGetInstanceProcAddr = MockGetInstanceProcAddr;
+                nextInfo.nextCreateApiLayerInstance = MockCreateApiLayerInstance;
+
+                XrApiLayerCreateInfo apiLayerInfo{};
+                apiLayerInfo.structType = XR_LOADER_INTERFACE_STRUCT_API_LAYER_CREATE_INFO;
+                apiLayerInfo.structVersion = XR_API_LAYER_CREATE_INFO_STRUCT_VERSION;
+                apiLayerInfo.structSize = sizeof(XrApiLayerCreateInfo);
+                apiLayerInfo.nextInfo = &nextInfo;
+                CHECK_XRCMD(layerRequest.createApiLayerInstance(&createInfo, &apiLayerInfo, &m_instance));
+
+                m_xr.xrGetInstanceProcAddr = layerRequest.getInstanceProcAddr;
+            } else {
+                CHECK_XRCMD(MockCreateApiLayerInstance(&createInfo, nullptr, &m_instance));
+
+                m_xr.xrGetInstanceProcAddr = MockGetInstanceProcAddr;
+            }
+
+#define RESOLVE(name)                                                                                                  \
+    CHECK_XRCMD(m_xr.xrGetInstanceProcAddr(m_instance, #name, reinterpret_cast<PFN_xrVoidFunction*>(&m_xr.name)))
+
+            RESOLVE(xrDestroyInstance);
+            RESOLVE(xrGetSystem);
+            RESOLVE(xrEnumerateViewConfigurationViews);
+            RESOLVE(xrCreateSession);
+            RESOLVE(xrBeginSession);
+            RESOLVE(xrEndSession);
+            RESOLVE(xrDestroySession);
+            RESOLVE(xrEnumerateSwapchainFormats);
+            RESOLVE(xrCreateSwapchain);
+            RESOLVE(xrDestroySwapchain);
+            RESOLVE(xrEnumerateSwapchainImages);
+            RESOLVE(xrAcquireSwapchainImage);
+            RESOLVE(xrWaitSwapchainImage);
+            RESOLVE(xrReleaseSwapchainImage);
+            RESOLVE(xrCreateReferenceSpace);
+            RESOLVE(xrCreateActionSpace);
+            RESOLVE(xrDestroySpace);
+            RESOLVE(xrLocateSpace);
+            RESOLVE(xrLocateViews);
+            RESOLVE(xrStringToPath);
+            RESOLVE(xrCreateActionSet);
+            RESOLVE(xrDestroyActionSet);
+            RESOLVE(xrCreateAction);
+            RESOLVE(xrSuggestInteractionProfileBindings);
+            RESOLVE(xrAttachSessionActionSets);
+            RESOLVE(xrSyncActions);
+            RESOLVE(xrGetActionStateBoolean);
+            RESOLVE(xrGetActionStateFloat);
+            RESOLVE(xrPollEvent);
+            RESOLVE(xrWaitFrame);
+            RESOLVE(xrBeginFrame);
+            RESOLVE(xrEndFrame);
+
+#undef RESOLVE
+        }
+
+        XrPath getPath(const char* path) {
+            XrPath xrPath;
+            CHECK_XRCMD(m_xr.xrStringToPath(m_instance, path, &xrPath));
+            return xrPath;
+        }
+
+        // The actions of a typical application, bound to a motion controller that the hand tracker can emulate.
+        void createActions() {
+            XrActionSetCreateInfo actionSetCreateInfo{XR_TYPE_ACTION_SET_CREATE_INFO};
+            strcpy_s(actionSetCreateInfo.actionSetName, "benchmark");
+            strcpy_s(actionSetCreateInfo.localizedActionSetName, "Benchmark");
+            CHECK_XRCMD(m_xr.xrCreateActionSet(m_instance, &actionSetCreateInfo, &m_actionSet));
+
+            const XrPath subactionPaths[] = {getPath("/user/hand/left"), getPath("/user/hand/right")};
+            std::vector<XrActionSuggestedBinding> bindings;
+            const auto createAction = [&](const char* name, XrActionType type, std::vector<const char*> paths) {
+                XrActionCreateInfo actionCreateInfo{XR_TYPE_ACTION_CREATE_INFO};
+                strcpy_s(actionCreateInfo.actionName, name);
+                strcpy_s(actionCreateInfo.localizedActionName, name);
+                actionCreateInfo.actionType = type;
+                actionCreateInfo.countSubactionPaths = (uint32_t)std::size(subactionPaths);
+                actionCreateInfo.subactionPaths = subactionPaths;
+                XrAction action;
+                CHECK_XRCMD(m_xr.xrCreateAction(m_actionSet, &actionCreateInfo, &action));
+                for (const auto path : paths) {
+                    bindings.push_back({action, getPath(path)});
+                }
+                return action;
+            };
+
+            m_floatActions.push_back(createAction("trigger",
+                                                  XR_ACTION_TYPE_FLOAT_INPUT,
+                                                  {"/user/hand/left/input/trigger/value",
+                                                   "/user/hand/right/input/trigger/value"}));
+            m_floatActions.push_back(createAction("squeeze",
+                                                  XR_ACTION_TYPE_FLOAT_INPUT,
+                                                  {"/user/hand/left/input/squeeze/value",
+                                                   "/user/hand/right/input/squeeze/value"}));
+            m_booleanActions.push_back(createAction("menu",
+                                                    XR_ACTION_TYPE_BOOLEAN_INPUT,
+                                                    {"/user/hand/left/input/menu/click",
+                                                     "/user/hand/right/input/menu/click"}));
+            m_booleanActions.push_back(createAction("primary",
+                                                    XR_ACTION_TYPE_BOOLEAN_INPUT,
+                                                    {"/user/hand/left/input/x/click",
+                                                     "/user/hand/right/input/a/click"}));
+            m_booleanActions.push_back(createAction("secondary",
+                                                    XR_ACTION_TYPE_BOOLEAN_INPUT,
+                                                    {"/user/hand/left/input/y/click",
+                                                     "/user/hand/right/input/b/click"}));
+            m_poseAction = createAction("grip",
+                                        XR_ACTION_TYPE_POSE_INPUT,
+                                        {"/user/hand/left/input/grip/pose", "/user/hand/right/input/grip/pose"});
+            for (const auto subactionPath : subactionPaths) {
+                m_subactionPaths.push_back(subactionPath);
+            }
+
+            XrInteractionProfileSuggestedBinding suggestedBindings{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
+            suggestedBindings.interactionProfile = getPath("/interaction_profiles/hp/mixed_reality_controller");
+            suggestedBindings.countSuggestedBindings = (uint32_t)bindings.size();
+            suggestedBindings.suggestedBindings = bindings.data();
+            CHECK_XRCMD(m_xr.xrSuggestInteractionProfileBindings(m_instance, &suggestedBindings));
+        }
+
+        void createSession() {
+            createActions();
+
+            XrSystemGetInfo systemInfo{XR_TYPE_SYSTEM_GET_INFO};
+            systemInfo.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+            CHECK_XRCMD(m_xr.xrGetSystem(m_instance, &systemInfo, &m_systemId));
+
+            XrViewConfigurationView views[2] = {{XR_TYPE_VIEW_CONFIGURATION_VIEW}, {XR_TYPE_VIEW_CONFIGURATION_VIEW}};
+            uint32_t viewCount;
+            CHECK_XRCMD(m_xr.xrEnumerateViewConfigurationViews(
+                m_instance, m_systemId, XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, 2, &viewCount, views));
+
+            XrGraphicsBindingD3D11KHR d3dBindings{XR_TYPE_GRAPHICS_BINDING_D3D11_KHR};
+            d3dBindings.device = get(m_device);
+            XrSessionCreateInfo sessionCreateInfo{XR_TYPE_SESSION_CREATE_INFO, &d3dBindings};
+            sessionCreateInfo.systemId = m_systemId;
+            CHECK_XRCMD(m_xr.xrCreateSession(m_instance, &sessionCreateInfo, &m_session));
+
+            XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
+            attachInfo.countActionSets = 1;
+            attachInfo.actionSets = &m_actionSet;
+            CHECK_XRCMD(m_xr.xrAttachSessionActionSets(m_session, &attachInfo));
+
+            XrReferenceSpaceCreateInfo referenceSpaceCreateInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+            referenceSpaceCreateInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+            referenceSpaceCreateInfo.poseInReferenceSpace = xr::math::Pose::Identity();
+            CHECK_XRCMD(m_xr.xrCreateReferenceSpace(m_session, &referenceSpaceCreateInfo, &m_localSpace));
+            for (const auto subactionPath : m_subactionPaths) {
+                XrActionSpaceCreateInfo actionSpaceCreateInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+                actionSpaceCreateInfo.action = m_poseAction;
+                actionSpaceCreateInfo.subactionPath = subactionPath;
+                actionSpaceCreateInfo.poseInActionSpace = xr::math::Pose::Identity();
+                XrSpace space;
+                CHECK_XRCMD(m_xr.xrCreateActionSpace(m_session, &actionSpaceCreateInfo, &space));
+                m_handSpaces.push_back(space);
+            }
+
+            // Use the same format as most engines.
+            uint32_t formatCount;
+            CHECK_XRCMD(m_xr.xrEnumerateSwapchainFormats(m_session, 0, &formatCount, nullptr));
+            std::vector<int64_t> formats(formatCount);
+            CHECK_XRCMD(m_xr.xrEnumerateSwapchainFormats(m_session, formatCount, &formatCount, formats.data()));
+            const auto preferredFormat =
+                std::find(formats.cbegin(), formats.cend(), (int64_t)DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
+            const int64_t format = preferredFormat != formats.cend() ? *preferredFormat : formats[0];
+
+            for (uint32_t layer = 0; layer < m_projectionLayers; layer++) {
+                for (uint32_t eye = 0; eye < 2; eye++) {
+                    XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+                    swapchainCreateInfo.usageFlags =
+                        XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+                    swapchainCreateInfo.format = format;
+                    swapchainCreateInfo.sampleCount = 1;
+                    swapchainCreateInfo.width = views[eye].recommendedImageRectWidth;
+                    swapchainCreateInfo.height = views[eye].recommendedImageRectHeight;
+                    swapchainCreateInfo.faceCount = 1;
+                    swapchainCreateInfo.arraySize = 1;
+                    swapchainCreateInfo.mipCount = 1;
+
+                    ProjectionLayerSwapchain swapchain;
+                    CHECK_XRCMD(m_xr.xrCreateSwapchain(m_session, &swapchainCreateInfo, &swapchain.swapchain));
+
+                    uint32_t imageCount;
+                    CHECK_XRCMD(m_xr.xrEnumerateSwapchainImages(swapchain.swapchain, 0, &imageCount, nullptr));
+                    std::vector<XrSwapchainImageD3D11KHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR});
+                    CHECK_XRCMD(m_xr.xrEnumerateSwapchainImages(
+                        swapchain.swapchain,
+                        imageCount,
+                        &imageCount,
+                        reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+                    for (const auto& image : images) {
+                        D3D11_RENDER_TARGET_VIEW_DESC rtvDesc{};
+                        rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+                        rtvDesc.Format = (DXGI_FORMAT)format;
+                        ComPtr<ID3D11RenderTargetView> rtv;
+                        CHECK_HRCMD(m_device->CreateRenderTargetView(image.texture, &rtvDesc, set(rtv)));
+                        swapchain.renderTargetViews.push_back(rtv);
+                    }
+
+                    m_swapchains[layer][eye] = std::move(swapchain);
+                    m_subImages[layer][eye] = {
+                        m_swapchains[layer][eye].swapchain,
+                        {{0, 0},
+                         {(int32_t)swapchainCreateInfo.width, (int32_t)swapchainCreateInfo.height}},
+                        0};
+                }
+            }
+
+            XrSessionBeginInfo beginInfo{XR_TYPE_SESSION_BEGIN_INFO};
+            beginInfo.primaryViewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+            CHECK_XRCMD(m_xr.xrBeginSession(m_session, &beginInfo));
+        }
+
+        void destroySession() {
+            CHECK_XRCMD(m_xr.xrEndSession(m_session));
+            for (uint32_t layer = 0; layer < m_projectionLayers; layer++) {
+                for (uint32_t eye = 0; eye < 2; eye++) {
+                    m_swapchains[layer][eye].renderTargetViews.clear();
+                    CHECK_XRCMD(m_xr.xrDestroySwapchain(m_swapchains[layer][eye].swapchain));
+                }
+            }
+            for (const auto space : m_handSpaces) {
+                CHECK_XRCMD(m_xr.xrDestroySpace(space));
+            }
+            m_handSpaces.clear();
+            CHECK_XRCMD(m_xr.xrDestroySpace(m_localSpace));
+            CHECK_XRCMD(m_xr.xrDestroySession(m_session));
+            CHECK_XRCMD(m_xr.xrDestroyActionSet(m_actionSet));
+            m_context->ClearState();
+            m_context->Flush();
+        }
+
+        void runFrame(bool record) {
+            XrFrameState frameState{XR_TYPE_FRAME_STATE};
+            measure(record, "xrWaitFrame", 1, [&] {
+                XrFrameWaitInfo waitInfo{XR_TYPE_FRAME_WAIT_INFO};
+                CHECK_XRCMD(m_xr.xrWaitFrame(m_session, &waitInfo, &frameState));
+            });
+            measure(record, "xrBeginFrame", 1, [&] {
+                XrFrameBeginInfo beginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+                CHECK_XRCMD(m_xr.xrBeginFrame(m_session, &beginInfo));
+            });
+            measure(record, "xrPollEvent", 1, [&] {
+                XrEventDataBuffer event{XR_TYPE_EVENT_DATA_BUFFER};
+                CHECK_XRCMD(m_xr.xrPollEvent(m_instance, &event));
+            });
+
+            measure(record, "xrSyncActions", 1, [&] {
+                XrActiveActionSet activeActionSet{m_actionSet, XR_NULL_PATH};
+                XrActionsSyncInfo syncInfo{XR_TYPE_ACTIONS_SYNC_INFO};
+                syncInfo.countActiveActionSets = 1;
+                syncInfo.activeActionSets = &activeActionSet;
+                CHECK_XRCMD(m_xr.xrSyncActions(m_session, &syncInfo));
+            });
+            measure(record, "xrGetActionStateBoolean", NumActionStateCalls / 2, [&] {
+                for (uint32_t i = 0; i < NumActionStateCalls / 2; i++) {
+                    XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+                    getInfo.action = m_booleanActions[i % m_booleanActions.size()];
+                    getInfo.subactionPath = m_subactionPaths[i % m_subactionPaths.size()];
+                    XrActionStateBoolean state{XR_TYPE_ACTION_STATE_BOOLEAN};
+                    CHECK_XRCMD(m_xr.xrGetActionStateBoolean(m_session, &getInfo, &state));
+                }
+            });
+            measure(record, "xrGetActionStateFloat", NumActionStateCalls / 2, [&] {
+                for (uint32_t i = 0; i < NumActionStateCalls / 2; i++) {
+                    XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+                    getInfo.action = m_floatActions[i % m_floatActions.size()];
+                    getInfo.subactionPath = m_subactionPaths[i % m_subactionPaths.size()];
+                    XrActionStateFloat state{XR_TYPE_ACTION_STATE_FLOAT};
+                    CHECK_XRCMD(m_xr.xrGetActionStateFloat(m_session, &getInfo, &state));
+                }
+            });
+            measure(record, "xrLocateSpace", NumLocateSpaceCalls, [&] {
+                for (uint32_t i = 0; i < NumLocateSpaceCalls; i++) {
+                    XrSpaceLocation location{XR_TYPE_SPACE_LOCATION};
+                    CHECK_XRCMD(m_xr.xrLocateSpace(m_handSpaces[i % m_handSpaces.size()],
+                                                   m_localSpace,
+                                                   frameState.predictedDisplayTime,
+                                                   &location));
+                }
+            });
+
+            XrView views[2] = {{XR_TYPE_VIEW}, {XR_TYPE_VIEW}};
+            measure(record, "xrLocateViews", 1, [&] {
+                XrViewLocateInfo locateInfo{XR_TYPE_VIEW_LOCATE_INFO};
+                locateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+                locateInfo.displayTime = frameState.predictedDisplayTime;
+                locateInfo.space = m_localSpace;
+                XrViewState viewState{XR_TYPE_VIEW_STATE};
+                uint32_t viewCount;
+                CHECK_XRCMD(m_xr.xrLocateViews(m_session, &locateInfo, &viewState, 2, &viewCount, views));
+            });
+
+            // Render the views, binding each render target a few times like a multi-pass engine would.
+            for (uint32_t layer = 0; layer < m_projectionLayers; layer++) {
+                for (uint32_t eye = 0; eye < 2; eye++) {
+                    auto& swapchain = m_swapchains[layer][eye];
+
+                    uint32_t index;
+                    measure(record, "xrAcquireSwapchainImage", 1, [&] {
+                        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+                        CHECK_XRCMD(m_xr.xrAcquireSwapchainImage(swapchain.swapchain, &acquireInfo, &index));
+                    });
+                    measure(record, "xrWaitSwapchainImage", 1, [&] {
+                        XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+                        waitInfo.timeout = XR_INFINITE_DURATION;
+                        CHECK_XRCMD(m_xr.xrWaitSwapchainImage(swapchain.swapchain, &waitInfo));
+                    });
+                    measure(record, "OMSetRenderTargets", NumRenderTargetBinds * 2, [&] {
+                        ID3D11RenderTargetView* rtv = get(swapchain.renderTargetViews[index]);
+                        for (uint32_t i = 0; i < NumRenderTargetBinds; i++) {
+                            m_context->OMSetRenderTargets(1, &rtv, nullptr);
+                            m_context->OMSetRenderTargets(0, nullptr, nullptr);
+                        }
+                    });
+                    measure(record, "xrReleaseSwapchainImage", 1, [&] {
+                        XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+                        CHECK_XRCMD(m_xr.xrReleaseSwapchainImage(swapchain.swapchain, &releaseInfo));
+                    });
+                }
+            }
+
+            XrCompositionLayerProjectionView projectionViews[MaxProjectionLayers][2];
+            XrCompositionLayerProjection projectionLayers[MaxProjectionLayers];
+            const XrCompositionLayerBaseHeader* layers[MaxProjectionLayers];
+            for (uint32_t layer = 0; layer < m_projectionLayers; layer++) {
+                for (uint32_t eye = 0; eye < 2; eye++) {
+                    projectionViews[layer][eye] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+                    projectionViews[layer][eye].pose = views[eye].pose;
+                    projectionViews[layer][eye].fov = views[eye].fov;
+                    projectionViews[layer][eye].subImage = m_subImages[layer][eye];
+                }
+                projectionLayers[layer] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION};
+                projectionLayers[layer].layerFlags = layer ? XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT : 0;
+                projectionLayers[layer].space = m_localSpace;
+                projectionLayers[layer].viewCount = 2;
+                projectionLayers[layer].views = projectionViews[layer];
+                layers[layer] = reinterpret_cast<const XrCompositionLayerBaseHeader*>(&projectionLayers[layer]);
+            }
+            measure(record, "xrEndFrame", 1, [&] {
+                XrFrameEndInfo endInfo{XR_TYPE_FRAME_END_INFO};
+                endInfo.displayTime = frameState.predictedDisplayTime;
+                endInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+                endInfo.layerCount = m_projectionLayers;
+                endInfo.layers = layers;
+                CHECK_XRCMD(m_xr.xrEndFrame(m_session, &endInfo));
+            });
+        }
+
+        template <typename Function>
+        void measure(bool record, const char* name, uint32_t callsInBatch, Function function) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const auto duration = std::chrono::steady_clock::now() - start;
+            if (!record) {
+                return;
+            }
+
+            auto it = std::find_if(m_result.calls.begin(), m_result.calls.end(), [&](const CallResult& call) {
+                return call.name == name;
+            });
+            if (it == m_result.calls.end()) {
+                m_result.calls.push_back({name, callsInBatch});
+                m_result.calls.back().samplesNs.reserve((size_t)m_options.frames * 2 * m_projectionLayers);
+                it = m_result.calls.end() - 1;
+            }
+            const auto durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            it->samplesNs.push_back(durationNs / callsInBatch);
+        }
+
+        const OverheadOptions& m_options;
+        const Combination& m_combination;
+        const uint32_t m_projectionLayers;
+        RunResult m_result;
+
+        ComPtr<ID3D11Device> m_device;
+        ComPtr<ID3D11DeviceContext> m_context;
+
+        Dispatch m_xr{};
+        XrInstance m_instance{XR_NULL_HANDLE};
+        XrSystemId m_systemId{XR_NULL_SYSTEM_ID};
+        XrSession m_session{XR_NULL_HANDLE};
+        XrSpace m_localSpace{XR_NULL_HANDLE};
+        std::vector<XrSpace> m_handSpaces;
+        XrActionSet m_actionSet{XR_NULL_HANDLE};
+        std::vector<XrAction> m_booleanActions;
+        std::vector<XrAction> m_floatActions;
+        XrAction m_poseAction{XR_NULL_HANDLE};
+        std::vector<XrPath> m_subactionPaths;
+        ProjectionLayerSwapchain m_swapchains[MaxProjectionLayers][2];
+        XrSwapchainSubImage m_subImages[MaxProjectionLayers][2]{};
+    };
+
+    struct Statistics {
+        uint64_t medianNs;
+        uint64_t p99Ns;
+        double meanNs;
+    };
+
+    Statistics GetStatistics(std::vector<uint64_t> samplesNs) {
+        std::sort(samplesNs.begin(), samplesNs.end());
+        const size_t p99Index = (size_t)std::ceil(samplesNs.size() * 0.99) - 1;
+        return {samplesNs[samplesNs.size() / 2],
+                samplesNs[std::min(p99Index, samplesNs.size() - 1)],
+                std::accumulate(samplesNs.cbegin(), samplesNs.cend(), 0.0) / samplesNs.size()};
+    }
+
+    // The number of calls per frame is derived from the samples, since some calls are made once per view.
+    uint32_t GetCallsPerFrame(const CallResult& call, uint32_t frames) {
+        return (uint32_t)(call.samplesNs.size() / frames) * call.callsPerFrame;
+    }
+
+    void PrintResults(const OverheadOptions& options, const std::vector<RunResult>& results) {
+        for (const auto& result : results) {
+            std::cout << fmt::format("\n{} ({} projection layer{})\n",
+                                     result.combination,
+                                     result.projectionLayers,
+                                     result.projectionLayers > 1 ? "s" : "");
+            std::cout << fmt::format(
+                "{:<26} {:>10} {:>10} {:>10} {:>10}\n", "Call", "Per frame", "Median", "P99", "Mean");
+
+            double totalNs = 0;
+            for (const auto& call : result.calls) {
+                const auto stats = GetStatistics(call.samplesNs);
+                const uint32_t callsPerFrame = GetCallsPerFrame(call, options.frames);
+                totalNs += stats.meanNs * callsPerFrame;
+                std::cout << fmt::format("{:<26} {:>10} {:>8}ns {:>8}ns {:>8.0f}ns\n",
+                                         call.name,
+                                         callsPerFrame,
+                                         stats.medianNs,
+                                         stats.p99Ns,
+                                         stats.meanNs);
+            }
+            std::cout << fmt::format("{:<26} {:>10} {:>32.1f}us\n", "Total", "", totalNs / 1000);
+        }
+    }
+
+    void WriteJson(const std::filesystem::path& path,
+                   const OverheadOptions& options,
+                   const std::vector<RunResult>& results) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+
+        file << "{\n";
+        file << fmt::format("  \"version\": \"{}\",\n", VersionString);
+        file << fmt::format("  \"frames\": {},\n", options.frames);
+        file << "  \"runs\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& result = results[i];
+            file << (i ? ",\n" : "\n");
+            file << fmt::format("    {{\"combination\": \"{}\", \"projection_layers\": {}, \"calls\": [",
+                                result.combination,
+                                result.projectionLayers);
+            for (size_t j = 0; j < result.calls.size(); j++) {
+                const auto& call = result.calls[j];
+                const auto stats = GetStatistics(call.samplesNs);
+                file << (j ? ",\n" : "\n");
+                file << fmt::format("      {{\"name\": \"{}\", \"per_frame\": {}, \"median_ns\": {}, \"p99_ns\": {}, "
+                                    "\"mean_ns\": {:.1f}}}",
+                                    call.name,
+                                    GetCallsPerFrame(call, options.frames),
+                                    stats.medianNs,
+                                    stats.p99Ns,
+                                    stats.meanNs);
+            }
+            file << "\n    ]}";
+        }
+        file << "\n  ]\n}\n";
+    }
+
+} // namespace
+
+namespace toolkit::benchmark {
+
+    int RunOverheadBenchmark(int argc, char** argv) {
+        try {
+            const auto options = ParseOptions(argc, argv);
+
+            std::vector<RunResult> results;
+            for (const auto& combination : options.combinations) {
+                for (const auto layerCount : options.layerCounts) {
+                    std::cout << "Running " << combination.name << " with " << layerCount << " layer(s)..."
+                              << std::endl;
+                    results.push_back(OverheadBenchmark(options, combination, layerCount).run());
+                }
+            }
+
+            PrintResults(options, results);
+            if (!options.jsonFile.empty()) {
+                WriteJson(options.jsonFile, options, results);
+            }
+        } catch (std::exception& exc) {
+            std::cerr << "Error: " << exc.what() << std::endl;
+            PrintUsage();
+            return 1;
+        }
+
+        return 0;
+    }
+
+} // namespace toolkit::benchmark